@@ -0,0 +1,25 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "HierarchyAnalysis.h"
+
+#include "DexUtil.h"
+#include "Timer.h"
+
+void HierarchyAnalysisPass::run_pass(DexStoresVector& stores,
+                                     ConfigFiles& /* conf */,
+                                     PassManager& /* mgr */) {
+  auto scope = build_class_scope(stores);
+  {
+    Timer t("Building class hierarchy");
+    m_class_hierarchy =
+        std::make_shared<const ClassHierarchy>(build_type_hierarchy(scope));
+  }
+  m_method_override_graph = method_override_graph::build_graph(scope);
+}
+
+static HierarchyAnalysisPass s_pass;
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <memory>
+
+#include "ClassHierarchy.h"
+#include "DexClass.h"
+#include "MethodOverrideGraph.h"
+#include "Pass.h"
+#include "PassManager.h"
+
+/**
+ * Builds the class hierarchy and the method override graph of the whole
+ * program once, so that the passes running after it can share them instead of
+ * each building their own.
+ *
+ * Like any analysis, the results are destroyed by the first pass that does not
+ * declare that it preserves them. Passes that leave classes and virtual
+ * methods alone should call `add_preserve_specific<HierarchyAnalysisPass>()`.
+ */
+class HierarchyAnalysisPass : public Pass {
+ public:
+  HierarchyAnalysisPass() : Pass("HierarchyAnalysisPass", Pass::ANALYSIS) {}
+
+  void run_pass(DexStoresVector&, ConfigFiles&, PassManager&) override;
+
+  std::shared_ptr<const ClassHierarchy> get_class_hierarchy() const {
+    return m_class_hierarchy;
+  }
+
+  std::shared_ptr<const method_override_graph::Graph>
+  get_method_override_graph() const {
+    return m_method_override_graph;
+  }
+
+  void destroy_analysis_result() override {
+    m_class_hierarchy = nullptr;
+    m_method_override_graph = nullptr;
+  }
+
+ private:
+  std::shared_ptr<const ClassHierarchy> m_class_hierarchy;
+  std::shared_ptr<const method_override_graph::Graph> m_method_override_graph;
+};
+
+namespace hierarchy_analysis {
+
+/**
+ * The preserved class hierarchy if HierarchyAnalysisPass ran and nothing has
+ * invalidated it since, or one freshly built for `scope` otherwise.
+ */
+inline std::shared_ptr<const ClassHierarchy> get_class_hierarchy(
+    const PassManager& mgr, const Scope& scope) {
+  auto* analysis = mgr.get_preserved_analysis<HierarchyAnalysisPass>();
+  if (analysis != nullptr && analysis->get_class_hierarchy() != nullptr) {
+    return analysis->get_class_hierarchy();
+  }
+  return std::make_shared<const ClassHierarchy>(build_type_hierarchy(scope));
+}
+
+/**
+ * The preserved method override graph if HierarchyAnalysisPass ran and nothing
+ * has invalidated it since, or null otherwise.
+ */
+inline std::shared_ptr<const method_override_graph::Graph>
+get_preserved_method_override_graph(const PassManager& mgr) {
+  auto* analysis = mgr.get_preserved_analysis<HierarchyAnalysisPass>();
+  return analysis != nullptr ? analysis->get_method_override_graph() : nullptr;
+}
+
+/**
+ * The preserved method override graph if there is one, or one freshly built
+ * for `scope` otherwise.
+ */
+inline std::shared_ptr<const method_override_graph::Graph>
+get_method_override_graph(const PassManager& mgr, const Scope& scope) {
+  auto graph = get_preserved_method_override_graph(mgr);
+  if (graph != nullptr) {
+    return graph;
+  }
+  return method_override_graph::build_graph(scope);
+}
+
+} // namespace hierarchy_analysis
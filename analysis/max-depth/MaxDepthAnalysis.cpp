@@ -165,8 +165,15 @@ class MaxDepthFunctionAnalyzer : public Base {
     if (!m_method) {
       return;
     }
-    this->get_summaries()->update(m_method,
-                                  [&](const DepthDomain&) { return m_domain; });
+    // Only report actual changes, so that the global fixpoint is reached as
+    // soon as the summaries are stable instead of after max_iteration rounds.
+    this->get_summaries()->maybe_update(m_method, [&](DepthDomain& old) {
+      if (old.equals(m_domain)) {
+        return false;
+      }
+      old = m_domain;
+      return true;
+    });
   }
 };
 
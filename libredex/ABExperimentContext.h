@@ -17,6 +17,11 @@ namespace ab_test {
  * RAII object that controls whether mutations happening to a CFG after the
  * experiment context has been created and before it has been flushed will
  * actually be visible (i.e. applied) or not, depending on its setup.
+ *
+ * The state of an experiment is fixed when its context is created, and passes
+ * consult use_control() before transforming anything, so that no snapshot of
+ * the original code needs to be kept around: registering a method is free, and
+ * an experiment costs no memory whatever the number of methods it covers.
  */
 class ABExperimentContext {
   friend RedexTest;
@@ -52,6 +52,17 @@ class AnalysisUsage {
     m_preserve_specific.emplace(get_analysis_id_by_pass<AnalysisPassType>());
   }
 
+  // Declares that this current pass looks up the type environments of most
+  // methods through type_inference::get_type_environments, so that they get
+  // computed for all methods in parallel before it runs.
+  void set_requires_type_environments(bool requires = true) {
+    m_requires_type_environments = requires;
+  }
+
+  bool requires_type_environments() const {
+    return m_requires_type_environments;
+  }
+
   // Returns a set of passes used by (thus should precede) this current pass.
   const std::unordered_set<AnalysisID>& get_required_passes() {
     return m_required_passes;
@@ -69,6 +80,7 @@ class AnalysisUsage {
 
  private:
   bool m_preserve_all = false;
+  bool m_requires_type_environments = false;
   std::unordered_set<AnalysisID> m_required_passes;
   std::unordered_set<AnalysisID> m_preserve_specific;
 };
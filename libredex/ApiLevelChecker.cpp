@@ -103,7 +103,7 @@ void LevelChecker::init_method(DexMethod* method) {
 
 DexClass* LevelChecker::get_outer_class(const DexClass* cls) {
   TraceContext context(cls->get_type());
-  const std::string& cls_name = cls->get_deobfuscated_name();
+  const auto cls_name = cls->get_deobfuscated_name_copy();
   auto cash_idx = cls_name.find_last_of('$');
   if (cash_idx == std::string::npos) {
     // this is not an inner class
@@ -139,12 +139,12 @@ constexpr const char* ANDROID_X_PREFIX = "Landroidx/";
 constexpr const char* ANDROID_SUPPORT_LIB_PREFIX = "Landroid/support/";
 
 bool is_android_sdk_type(const DexType* type) {
-  const std::string& name = type->str();
+  const auto name = type->str();
   return boost::starts_with(name, ANDROID_SDK_PREFIX);
 }
 
 bool is_support_lib_type(const DexType* type) {
-  const std::string& name = type->str();
+  const auto name = type->str();
   return boost::starts_with(name, ANDROID_X_PREFIX) ||
          boost::starts_with(name, ANDROID_SUPPORT_LIB_PREFIX);
 }
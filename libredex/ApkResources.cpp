@@ -869,9 +869,26 @@ void ResourcesArscFile::remap_ids(
     remapped.add(pair.second);
   }
 
+  // Each resource's values live in the configs of its own type chunk, so the
+  // chunks can be rewritten concurrently. Entries may be shared between
+  // resources of the same type, so a chunk is never split across tasks.
+  std::map<uint32_t, std::vector<uint32_t>> ids_by_type;
   for (const auto& pair : old_to_remapped_ids) {
-    res_table.remapReferenceValuesForResource(pair.first, old, remapped);
-  }
+    ids_by_type[pair.first & (PACKAGE_MASK_BIT | TYPE_MASK_BIT)].push_back(
+        pair.first);
+  }
+  std::vector<const std::vector<uint32_t>*> type_chunks;
+  type_chunks.reserve(ids_by_type.size());
+  for (const auto& pair : ids_by_type) {
+    type_chunks.push_back(&pair.second);
+  }
+  workqueue_run<const std::vector<uint32_t>*>(
+      [&](const std::vector<uint32_t>* ids) {
+        for (auto id : *ids) {
+          res_table.remapReferenceValuesForResource(id, old, remapped);
+        }
+      },
+      type_chunks);
 }
 
 std::unordered_set<uint32_t> ResourcesArscFile::get_types_by_name(
@@ -23,6 +23,7 @@
 #include <string>
 
 #include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
 
 #include "Debug.h"
 #include "DexUtil.h"
@@ -128,16 +129,16 @@ std::string get_string_attribute_value(const aapt::pb::XmlElement& element,
 void traverse_element_and_children(
     const aapt::pb::XmlElement& start,
     const std::function<bool(const aapt::pb::XmlElement&)>& callback) {
-  std::queue<aapt::pb::XmlElement> q;
-  q.push(start);
+  std::queue<const aapt::pb::XmlElement*> q;
+  q.push(&start);
   while (!q.empty()) {
-    const auto& front = q.front();
-    if (!callback(front)) {
+    const auto* front = q.front();
+    if (!callback(*front)) {
       return;
     }
-    for (const aapt::pb::XmlNode& pb_child : front.child()) {
+    for (const aapt::pb::XmlNode& pb_child : front->child()) {
       if (pb_child.node_case() == aapt::pb::XmlNode::NodeCase::kElement) {
-        q.push(pb_child.element());
+        q.push(&pb_child.element());
       }
     }
     q.pop();
@@ -432,16 +433,184 @@ const std::vector<std::string> CLASS_XML_ATTRIBUTES = {
     "targetClass",
 };
 
+// The parts of an aapt::pb::XmlElement that layout scanning looks at.
+struct ScannedAttribute {
+  std::string namespace_uri;
+  std::string name;
+  std::string value;
+  bool has_compiled_item{false};
+};
+
+struct ScannedElement {
+  std::string name;
+  std::vector<ScannedAttribute> attributes;
+};
+
+using google::protobuf::io::CodedInputStream;
+using google::protobuf::internal::WireFormatLite;
+
+// Calls fn(field_number, tag) for the fields of a message, up to the current
+// limit of the input. fn must consume the field, e.g. via SkipField.
+template <typename Fn>
+bool scan_fields(CodedInputStream& input, const Fn& fn) {
+  while (auto tag = input.ReadTag()) {
+    if (!fn(WireFormatLite::GetTagFieldNumber(tag), tag)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Like scan_fields, for a length-delimited message at the current position.
+template <typename Fn>
+bool scan_message(CodedInputStream& input, const Fn& fn) {
+  uint32_t length;
+  if (!input.ReadVarint32(&length)) {
+    return false;
+  }
+  auto limit = input.PushLimit(length);
+  bool ok = scan_fields(input, fn);
+  input.PopLimit(limit);
+  return ok;
+}
+
+bool is_length_delimited(uint32_t tag) {
+  return WireFormatLite::GetTagWireType(tag) ==
+         WireFormatLite::WIRETYPE_LENGTH_DELIMITED;
+}
+
+bool read_string(CodedInputStream& input, std::string* out) {
+  uint32_t length;
+  return input.ReadVarint32(&length) && input.ReadString(out, length);
+}
+
+/*
+ * Scans the wire format of an aapt::pb::XmlNode, without materializing any
+ * messages, and calls `fn` for each element once all of it has been read.
+ * Children are reported before their parents. Only the namespace declarations
+ * of the root element are recorded, in `ns_uri_to_prefix`; aapt2 writes
+ * fields in field number order, so they are known before any element is
+ * reported.
+ */
+class XmlNodeScanner {
+ public:
+  using ElementFn = std::function<void(const ScannedElement&)>;
+
+  XmlNodeScanner(CodedInputStream& input, const ElementFn& fn)
+      : m_input(input), m_fn(fn) {}
+
+  bool scan() {
+    return scan_fields(m_input, [&](uint32_t field, uint32_t tag) {
+      // XmlNode.element
+      if (field == 1 && is_length_delimited(tag)) {
+        return scan_element(/* is_root */ true);
+      }
+      return WireFormatLite::SkipField(&m_input, tag);
+    });
+  }
+
+  const std::unordered_map<std::string, std::string>& ns_uri_to_prefix()
+      const {
+    return m_ns_uri_to_prefix;
+  }
+
+ private:
+  bool scan_element(bool is_root) {
+    ScannedElement element;
+    bool ok = scan_message(m_input, [&](uint32_t field, uint32_t tag) {
+      if (!is_length_delimited(tag)) {
+        return WireFormatLite::SkipField(&m_input, tag);
+      }
+      switch (field) {
+      case 1: // XmlElement.namespace_declaration
+        return is_root ? scan_namespace()
+                       : WireFormatLite::SkipField(&m_input, tag);
+      case 3: // XmlElement.name
+        return read_string(m_input, &element.name);
+      case 4: // XmlElement.attribute
+        element.attributes.emplace_back();
+        return scan_attribute(&element.attributes.back());
+      case 5: // XmlElement.child
+        return scan_message(m_input, [&](uint32_t child_field,
+                                         uint32_t child_tag) {
+          // XmlNode.element
+          if (child_field == 1 && is_length_delimited(child_tag)) {
+            return scan_element(/* is_root */ false);
+          }
+          return WireFormatLite::SkipField(&m_input, child_tag);
+        });
+      default:
+        return WireFormatLite::SkipField(&m_input, tag);
+      }
+    });
+    if (ok) {
+      m_fn(element);
+    }
+    return ok;
+  }
+
+  bool scan_namespace() {
+    std::string prefix;
+    std::string uri;
+    bool ok = scan_message(m_input, [&](uint32_t field, uint32_t tag) {
+      if (field == 1 && is_length_delimited(tag)) {
+        return read_string(m_input, &prefix);
+      } else if (field == 2 && is_length_delimited(tag)) {
+        return read_string(m_input, &uri);
+      }
+      return WireFormatLite::SkipField(&m_input, tag);
+    });
+    if (ok && !uri.empty() && !prefix.empty()) {
+      m_ns_uri_to_prefix.emplace(uri, prefix);
+    }
+    return ok;
+  }
+
+  bool scan_attribute(ScannedAttribute* attr) {
+    return scan_message(m_input, [&](uint32_t field, uint32_t tag) {
+      if (is_length_delimited(tag)) {
+        switch (field) {
+        case 1:
+          return read_string(m_input, &attr->namespace_uri);
+        case 2:
+          return read_string(m_input, &attr->name);
+        case 3:
+          return read_string(m_input, &attr->value);
+        case 6:
+          attr->has_compiled_item = true;
+          break;
+        default:
+          break;
+        }
+      }
+      return WireFormatLite::SkipField(&m_input, tag);
+    });
+  }
+
+  CodedInputStream& m_input;
+  ElementFn m_fn;
+  std::unordered_map<std::string, std::string> m_ns_uri_to_prefix;
+};
+
 void collect_layout_classes_and_attributes_for_element(
-    const aapt::pb::XmlElement& element,
+    const ScannedElement& element,
     const std::unordered_map<std::string, std::string>& ns_uri_to_prefix,
     const std::unordered_set<std::string>& attributes_to_read,
     std::unordered_set<std::string>* out_classes,
     std::unordered_multimap<std::string, std::string>* out_attributes) {
-  const auto& element_name = element.name();
+  const auto& element_name = element.name;
   if (NON_CLASS_ELEMENTS.count(element_name) > 0) {
     for (const auto& attr : CLASS_XML_ATTRIBUTES) {
-      auto classname = get_string_attribute_value(element, attr);
+      auto it = std::find_if(
+          element.attributes.begin(), element.attributes.end(),
+          [&](const ScannedAttribute& a) { return a.name == attr; });
+      if (it == element.attributes.end()) {
+        continue;
+      }
+      always_assert_log(!it->has_compiled_item,
+                        "Attribute %s expected to be a string!",
+                        attr.c_str());
+      const auto& classname = it->value;
       if (!classname.empty() && classname.find('.') != std::string::npos) {
         auto internal = java_names::external_to_internal(classname);
         TRACE(RES, 9,
@@ -461,20 +630,18 @@ void collect_layout_classes_and_attributes_for_element(
   }
 
   if (!attributes_to_read.empty()) {
-    for (const aapt::pb::XmlAttribute& pb_attr : element.attribute()) {
-      const auto& attr_name = pb_attr.name();
-      const auto& uri = pb_attr.namespace_uri();
-      std::string fully_qualified =
-          ns_uri_to_prefix.count(uri) == 0
-              ? attr_name
-              : (ns_uri_to_prefix.at(uri) + ":" + attr_name);
+    for (const auto& attr : element.attributes) {
+      const auto& uri = attr.namespace_uri;
+      auto prefix_it = ns_uri_to_prefix.find(uri);
+      std::string fully_qualified = prefix_it == ns_uri_to_prefix.end()
+                                        ? attr.name
+                                        : (prefix_it->second + ":" + attr.name);
       if (attributes_to_read.count(fully_qualified) > 0) {
-        always_assert_log(!pb_attr.has_compiled_item(),
+        always_assert_log(!attr.has_compiled_item,
                           "Only supporting string values for attributes. "
                           "Given attribute: %s",
                           fully_qualified.c_str());
-        auto value = pb_attr.value();
-        out_attributes->emplace(fully_qualified, value);
+        out_attributes->emplace(fully_qualified, attr.value);
       }
     }
   }
@@ -656,26 +823,16 @@ void BundleResources::collect_layout_classes_and_attributes_for_file(
   read_protobuf_file_contents(
       file_path,
       [&](google::protobuf::io::CodedInputStream& input, size_t size) {
-        aapt::pb::XmlNode pb_node;
-        bool read_finish = pb_node.ParseFromCodedStream(&input);
+        // Layouts are only read here, so scan them without building the
+        // message tree.
+        XmlNodeScanner scanner(input, [&](const ScannedElement& element) {
+          collect_layout_classes_and_attributes_for_element(
+              element, scanner.ns_uri_to_prefix(), attributes_to_read,
+              out_classes, out_attributes);
+        });
+        bool read_finish = scanner.scan();
         always_assert_log(read_finish, "BundleResoource failed to read %s",
                           file_path.c_str());
-        if (pb_node.has_element()) {
-          const auto& root = pb_node.element();
-          std::unordered_map<std::string, std::string> ns_uri_to_prefix;
-          for (const auto& ns_decl : root.namespace_declaration()) {
-            if (!ns_decl.uri().empty() && !ns_decl.prefix().empty()) {
-              ns_uri_to_prefix.emplace(ns_decl.uri(), ns_decl.prefix());
-            }
-          }
-          traverse_element_and_children(
-              root, [&](const aapt::pb::XmlElement& element) {
-                collect_layout_classes_and_attributes_for_element(
-                    element, ns_uri_to_prefix, attributes_to_read, out_classes,
-                    out_attributes);
-                return true;
-              });
-        }
       });
 }
 
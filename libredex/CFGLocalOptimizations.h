@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <functional>
+#include <json/json.h>
+#include <map>
+#include <string>
+#include <unordered_map>
+
+#include "Debug.h"
+
+class DexMethod;
+
+namespace cfg {
+class ControlFlowGraph;
+} // namespace cfg
+
+/*
+ * Method-local transformations that only need the editable CFG of a method
+ * can register themselves as stages here. CFGLocalOptimizationsPass then runs
+ * a configured list of stages back to back on each method, building and
+ * linearizing its CFG only once, instead of each transformation running as a
+ * pass of its own.
+ */
+namespace cfg_local_opts {
+
+// Metric name to value, summed over all methods.
+struct Metrics {
+  std::unordered_map<std::string, size_t> values;
+
+  Metrics& operator+=(const Metrics& that) {
+    for (const auto& p : that.values) {
+      values[p.first] += p.second;
+    }
+    return *this;
+  }
+};
+
+// Transforms the editable CFG of the given method, and adds to `metrics`.
+// Called concurrently for different methods.
+using MethodTransform = std::function<void(
+    DexMethod*, cfg::ControlFlowGraph&, Metrics& /* metrics */)>;
+
+struct Stage {
+  // Creates the transform for the options given to the stage in the
+  // configuration of CFGLocalOptimizationsPass.
+  std::function<MethodTransform(const Json::Value& /* options */)>
+      make_transform;
+  // Whether the transform looks up type environments of most methods, see
+  // AnalysisUsage::set_requires_type_environments.
+  bool requires_type_environments{false};
+  // Whether the transform only depends on the code, signature and access
+  // flags of the method, and on the options, so that CFGLocalOptimizationsPass
+  // may replay its results from a cache of earlier builds.
+  bool cacheable{false};
+};
+
+inline std::map<std::string, Stage>& stages() {
+  static std::map<std::string, Stage> stages;
+  return stages;
+}
+
+inline const Stage* get_stage(const std::string& name) {
+  auto it = stages().find(name);
+  return it == stages().end() ? nullptr : &it->second;
+}
+
+// Registers a stage under the given name, typically that of the pass that
+// runs the same transformation on its own. Meant for static initializers.
+struct StageRegistration {
+  StageRegistration(const std::string& name, Stage stage) {
+    bool inserted = stages().emplace(name, std::move(stage)).second;
+    always_assert_log(inserted, "Duplicate CFG-local stage %s", name.c_str());
+  }
+};
+
+} // namespace cfg_local_opts
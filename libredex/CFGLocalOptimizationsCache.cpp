@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "CFGLocalOptimizationsCache.h"
+
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include "Debug.h"
+#include "Sha1.h"
+#include "Trace.h"
+
+namespace {
+
+// Identifies the file format. Bump the version whenever the format or the
+// meaning of the stored values changes.
+constexpr char MAGIC[] = "RDXCLO01";
+constexpr size_t MAGIC_SIZE = sizeof(MAGIC) - 1;
+constexpr size_t KEY_SIZE = 20;
+
+// Entries are laid out as the key, followed by the size of the value as a
+// little-endian 32-bit integer, followed by the value.
+constexpr size_t ENTRY_HEADER_SIZE = KEY_SIZE + 4;
+
+uint32_t read_u32(const char* p) {
+  const auto* u = reinterpret_cast<const unsigned char*>(p);
+  return uint32_t(u[0]) | (uint32_t(u[1]) << 8) | (uint32_t(u[2]) << 16) |
+         (uint32_t(u[3]) << 24);
+}
+
+void write_u32(std::ostream& out, uint32_t value) {
+  char bytes[4];
+  for (size_t i = 0; i < 4; i++) {
+    bytes[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+  }
+  out.write(bytes, 4);
+}
+
+} // namespace
+
+namespace cfg_local_opts {
+
+Cache::Key Cache::make_key(const std::vector<std::string>& parts) {
+  Sha1Context context;
+  sha1_init(&context);
+  for (const auto& part : parts) {
+    unsigned char size[8];
+    uint64_t n = part.size();
+    for (size_t i = 0; i < 8; i++) {
+      size[i] = static_cast<unsigned char>((n >> (8 * i)) & 0xff);
+    }
+    sha1_update(&context, size, sizeof(size));
+    sha1_update(&context,
+                reinterpret_cast<const unsigned char*>(part.data()),
+                part.size());
+  }
+  unsigned char digest[KEY_SIZE];
+  sha1_final(digest, &context);
+  return Key(reinterpret_cast<const char*>(digest), KEY_SIZE);
+}
+
+Cache::Cache(std::string path) : m_path(std::move(path)) {
+  boost::system::error_code ec;
+  auto file_size = boost::filesystem::file_size(m_path, ec);
+  if (ec || file_size < MAGIC_SIZE) {
+    TRACE(CFG, 1, "[cfg-local-opts] No cache at %s", m_path.c_str());
+    return;
+  }
+  try {
+    m_mapped = std::make_unique<RedexMappedFile>(
+        RedexMappedFile::open(m_path, /* read_only */ true));
+  } catch (const std::exception& e) {
+    TRACE(CFG, 1, "[cfg-local-opts] Could not map %s: %s", m_path.c_str(),
+          e.what());
+    return;
+  }
+  const char* data = m_mapped->const_data();
+  size_t size = m_mapped->size();
+  if (size < MAGIC_SIZE || memcmp(data, MAGIC, MAGIC_SIZE) != 0) {
+    TRACE(CFG, 1, "[cfg-local-opts] Ignoring cache %s of another version",
+          m_path.c_str());
+    return;
+  }
+  size_t offset = MAGIC_SIZE;
+  while (offset < size) {
+    if (size - offset < ENTRY_HEADER_SIZE) {
+      break;
+    }
+    size_t value_size = read_u32(data + offset + KEY_SIZE);
+    size_t value_offset = offset + ENTRY_HEADER_SIZE;
+    if (size - value_offset < value_size) {
+      break;
+    }
+    m_loaded.emplace(Key(data + offset, KEY_SIZE),
+                     std::make_pair(value_offset, value_size));
+    offset = value_offset + value_size;
+  }
+  if (offset != size) {
+    TRACE(CFG, 1, "[cfg-local-opts] Ignoring truncated cache %s",
+          m_path.c_str());
+    m_loaded.clear();
+  }
+}
+
+boost::optional<std::string> Cache::get(const Key& key) {
+  auto it = m_loaded.find(key);
+  if (it != m_loaded.end()) {
+    m_used.insert(key);
+    return std::string(m_mapped->const_data() + it->second.first,
+                       it->second.second);
+  }
+  // Not in the file, but maybe inserted by an earlier lookup of the same
+  // content in this build.
+  auto value = m_inserted.get(key, std::string());
+  if (!value.empty()) {
+    return value;
+  }
+  return boost::none;
+}
+
+void Cache::put(const Key& key, std::string value) {
+  always_assert(key.size() == KEY_SIZE);
+  // Empty values denote misses in get().
+  always_assert(!value.empty());
+  if (m_loaded.count(key)) {
+    m_used.insert(key);
+    return;
+  }
+  m_inserted.emplace(key, std::move(value));
+}
+
+void Cache::save() {
+  // Sort the entries by key, so that the same entries give the same file.
+  std::vector<std::pair<Key, std::pair<const char*, size_t>>> entries;
+  entries.reserve(m_used.size() + m_inserted.size());
+  for (const auto& key : m_used) {
+    const auto& loc = m_loaded.at(key);
+    entries.emplace_back(
+        key, std::make_pair(m_mapped->const_data() + loc.first, loc.second));
+  }
+  for (const auto& p : m_inserted) {
+    entries.emplace_back(p.first,
+                         std::make_pair(p.second.data(), p.second.size()));
+  }
+  std::sort(entries.begin(), entries.end(),
+            [](const auto& a, const auto& b) { return a.first < b.first; });
+
+  // Write to a temporary file first, so that a build that is interrupted
+  // leaves the previous cache intact.
+  auto tmp_path = m_path + ".tmp";
+  {
+    std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      TRACE(CFG, 1, "[cfg-local-opts] Could not write %s", tmp_path.c_str());
+      return;
+    }
+    out.write(MAGIC, MAGIC_SIZE);
+    for (const auto& entry : entries) {
+      always_assert(entry.second.second <= UINT32_MAX);
+      out.write(entry.first.data(), KEY_SIZE);
+      write_u32(out, static_cast<uint32_t>(entry.second.second));
+      out.write(entry.second.first, entry.second.second);
+    }
+  }
+  // The values of used entries point into the mapping, so only unmap once
+  // they are written.
+  m_mapped.reset();
+  m_loaded.clear();
+  if (std::rename(tmp_path.c_str(), m_path.c_str()) != 0) {
+    TRACE(CFG, 1, "[cfg-local-opts] Could not replace %s", m_path.c_str());
+    return;
+  }
+  TRACE(CFG, 1, "[cfg-local-opts] Saved %zu entries to %s", entries.size(),
+        m_path.c_str());
+}
+
+} // namespace cfg_local_opts
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ConcurrentContainers.h"
+#include "RedexMappedFile.h"
+
+namespace cfg_local_opts {
+
+/*
+ * A content-addressed store that persists the results of CFG-local stages
+ * across builds, see CFGLocalOptimizationsPass.
+ *
+ * Keys are SHA-1 digests of everything a result depends on, and values are
+ * opaque strings. The store lives in a single file. The file stays
+ * memory-mapped while the store is in use, and values are only copied out on
+ * lookup. save() only keeps the entries that were looked up or inserted, so
+ * entries of methods that changed or went away don't pile up.
+ *
+ * get() and put() are safe to call concurrently.
+ */
+class Cache final {
+ public:
+  using Key = std::string;
+
+  // The SHA-1 digest of the given parts. Parts are length-prefixed, so that
+  // moving characters from one part to the next changes the key.
+  static Key make_key(const std::vector<std::string>& parts);
+
+  // Loads the file at `path`, if it exists. A file that is truncated or was
+  // written by another version is treated as empty.
+  explicit Cache(std::string path);
+
+  Cache(const Cache&) = delete;
+  Cache& operator=(const Cache&) = delete;
+
+  boost::optional<std::string> get(const Key& key);
+
+  void put(const Key& key, std::string value);
+
+  // Writes the used entries back to the file. The store must not be used
+  // afterwards.
+  void save();
+
+  // The number of entries loaded from the file.
+  size_t loaded_size() const { return m_loaded.size(); }
+
+ private:
+  std::string m_path;
+  std::unique_ptr<RedexMappedFile> m_mapped;
+  // Offset and size in m_mapped of the values loaded from the file. Not
+  // modified after loading.
+  std::unordered_map<Key, std::pair<size_t, size_t>> m_loaded;
+  ConcurrentSet<Key> m_used;
+  ConcurrentMap<Key, std::string> m_inserted;
+};
+
+} // namespace cfg_local_opts
@@ -14,6 +14,7 @@
 #include "Show.h"
 #include "Trace.h"
 #include "Walkers.h"
+#include "WorkQueue.h"
 
 namespace mog = method_override_graph;
 
@@ -192,19 +193,14 @@ CompleteCallGraphStrategy::CompleteCallGraphStrategy(
     const mog::Graph& method_override_graph, const Scope& scope)
     : MultipleCalleeBaseStrategy(method_override_graph, scope) {}
 
-DexMethod* resolve_interface_virtual_callee(const IRInstruction* insn,
-                                            const DexMethod* caller,
-                                            MethodRefCache& ref_cache,
-                                            bool use_cache) {
+DexMethod* resolve_interface_virtual_callee(
+    const IRInstruction* insn,
+    const DexMethod* caller,
+    ConcurrentMethodRefCache& ref_cache) {
   DexMethod* callee = nullptr;
   if (opcode_to_search(insn) == MethodSearch::Virtual) {
-    callee = use_cache ? resolve_method(insn->get_method(),
-                                        MethodSearch::InterfaceVirtual,
-                                        ref_cache,
-                                        caller)
-                       : resolve_method(insn->get_method(),
-                                        MethodSearch::InterfaceVirtual,
-                                        caller);
+    callee = resolve_method(insn->get_method(), MethodSearch::InterfaceVirtual,
+                            ref_cache, caller);
     if (callee == nullptr) {
       auto insn_method_cls = type_class(insn->get_method()->get_class());
       if (insn_method_cls != nullptr && !insn_method_cls->is_external()) {
@@ -228,8 +224,8 @@ CallSites CompleteCallGraphStrategy::get_callsites(
     if (opcode::is_an_invoke(insn->opcode())) {
       auto callee = this->resolve_callee(method, insn);
       if (callee == nullptr) {
-        callee = resolve_interface_virtual_callee(insn, method, m_resolved_refs,
-                                                  /* use_cache */ true);
+        callee =
+            resolve_interface_virtual_callee(insn, method, m_resolved_refs);
         if (callee == nullptr) {
           continue;
         }
@@ -313,11 +309,11 @@ MultipleCalleeStrategy::MultipleCalleeStrategy(
     for (auto& mie : InstructionIterable(code)) {
       auto insn = mie.insn;
       if (opcode::is_an_invoke(insn->opcode())) {
-        auto callee =
-            resolve_method(insn->get_method(), opcode_to_search(insn), method);
+        auto callee = resolve_method(insn->get_method(), opcode_to_search(insn),
+                                     m_resolved_refs, method);
         if (callee == nullptr) {
-          callee = resolve_interface_virtual_callee(
-              insn, method, m_resolved_refs, /* use_cache */ false);
+          callee =
+              resolve_interface_virtual_callee(insn, method, m_resolved_refs);
           if (callee == nullptr) {
             continue;
           }
@@ -358,8 +354,8 @@ CallSites MultipleCalleeStrategy::get_callsites(const DexMethod* method) const {
     if (opcode::is_an_invoke(insn->opcode())) {
       auto callee = this->resolve_callee(method, insn);
       if (callee == nullptr) {
-        callee = resolve_interface_virtual_callee(insn, method, m_resolved_refs,
-                                                  /* use_cache */ true);
+        callee =
+            resolve_interface_virtual_callee(insn, method, m_resolved_refs);
         if (callee == nullptr) {
           continue;
         }
@@ -423,8 +419,35 @@ Graph::Graph(const BuildStrategy& strat)
     make_node(root)->m_predecessors.emplace_back(edge);
   }
 
-  // Obtain the callsites of each method recursively, building the graph in the
-  // process.
+  // Obtain the callsites of all methods reachable from the roots in parallel,
+  // as that is where most of the time goes.
+  ConcurrentMap<const DexMethod*, CallSites> all_callsites;
+  {
+    ConcurrentSet<const DexMethod*> reached;
+    std::vector<const DexMethod*> unique_roots;
+    for (const DexMethod* root : roots) {
+      if (reached.insert(root)) {
+        unique_roots.push_back(root);
+      }
+    }
+    workqueue_run<const DexMethod*>(
+        [&](sparta::SpartaWorkerState<const DexMethod*>* worker_state,
+            const DexMethod* caller) {
+          auto callsites = strat.get_callsites(caller);
+          for (const auto& callsite : callsites) {
+            if (reached.insert(callsite.callee)) {
+              worker_state->push_task(callsite.callee);
+            }
+          }
+          all_callsites.emplace(caller, std::move(callsites));
+        },
+        unique_roots,
+        redex_parallel::default_num_threads(),
+        /*push_tasks_while_running=*/true);
+  }
+
+  // Then build the graph by visiting the methods recursively, so that nodes
+  // and edges are added in a deterministic order.
   MethodSet visited;
   auto visit = [&](const auto* caller) {
     auto visit_impl = [&](const auto* caller, auto& visit_fn) {
@@ -432,12 +455,13 @@ Graph::Graph(const BuildStrategy& strat)
         return;
       }
       visited.emplace(caller);
-      auto callsites = strat.get_callsites(caller);
+      const auto& callsites = all_callsites.at_unsafe(caller);
+      auto caller_node = make_node(caller);
       if (callsites.empty()) {
-        this->add_edge(make_node(caller), m_exit, IRList::iterator());
+        this->add_edge(caller_node, m_exit, IRList::iterator());
       }
       for (const auto& callsite : callsites) {
-        this->add_edge(make_node(caller), make_node(callsite.callee),
+        this->add_edge(caller_node, make_node(callsite.callee),
                        callsite.invoke);
         m_insn_to_callee[callsite.invoke->insn].emplace(callsite.callee);
         visit_fn(callsite.callee, visit_fn);
@@ -70,6 +70,9 @@ struct RootAndDynamic {
  * recursively until the graph is fully mapped out. One can think of the
  * BuildStrategy as implicitly encoding the graph structure, with the Graph
  * constructor reifying it.
+ *
+ * get_callsites() is called concurrently for different methods, and so must be
+ * thread-safe.
  */
 class BuildStrategy {
  public:
@@ -192,7 +195,9 @@ class SingleCalleeStrategy : public BuildStrategy {
 
   const Scope& m_scope;
   std::unordered_set<DexMethod*> m_non_virtual;
-  mutable MethodRefCache m_resolved_refs;
+  // Thread-safe, so that it can be shared by the parallel walks done while
+  // setting up strategies and the sequential graph construction.
+  mutable ConcurrentMethodRefCache m_resolved_refs;
 };
 
 class MultipleCalleeBaseStrategy : public SingleCalleeStrategy {
@@ -14,7 +14,7 @@
 namespace klass {
 
 Serdes get_serdes(const DexClass* cls) {
-  std::string name = cls->get_name()->str();
+  std::string name = cls->get_name()->str_copy();
   name.pop_back();
   std::string flatbuf_name = name;
   std::replace(flatbuf_name.begin(), flatbuf_name.end(), '$', '_');
@@ -52,7 +52,7 @@ DexMethod* get_or_create_clinit(DexClass* cls) {
       DexMethod::make_method(cls->get_type(), clinit_name, clinit_proto)
           ->make_concrete(ACC_PUBLIC | ACC_STATIC | ACC_CONSTRUCTOR, false);
 
-  std::string cls_deobfuscated_name = cls->get_deobfuscated_name();
+  auto cls_deobfuscated_name = cls->get_deobfuscated_name();
   clinit->set_deobfuscated_name(show_deobfuscated(clinit));
 
   auto ir_code = std::make_unique<IRCode>(clinit, 1);
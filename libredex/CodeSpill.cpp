@@ -0,0 +1,433 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "CodeSpill.h"
+
+#include <boost/filesystem.hpp>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include "Debug.h"
+#include "DexPosition.h"
+#include "IRCode.h"
+#include "IRInstruction.h"
+#include "Show.h"
+#include "Trace.h"
+#include "Walkers.h"
+#include "WorkQueue.h"
+
+namespace {
+
+constexpr uint32_t kNoIndex = std::numeric_limits<uint32_t>::max();
+
+enum ParentKind : uint8_t {
+  kNoParent = 0,
+  // The parent is a position of the same method, given by its entry index.
+  kParentIndex = 1,
+  // The parent lives elsewhere and is kept as is.
+  kParentPointer = 2,
+};
+
+class Writer {
+ public:
+  template <typename T>
+  void put(T value) {
+    static_assert(std::is_trivially_copyable<T>::value, "raw bytes only");
+    size_t at = m_buf.size();
+    m_buf.resize(at + sizeof(T));
+    std::memcpy(m_buf.data() + at, &value, sizeof(T));
+  }
+
+  void put_ptr(const void* ptr) { put(reinterpret_cast<uintptr_t>(ptr)); }
+
+  const std::vector<char>& buffer() const { return m_buf; }
+
+ private:
+  std::vector<char> m_buf;
+};
+
+class Reader {
+ public:
+  Reader(const char* data, size_t size) : m_ptr(data), m_end(data + size) {}
+
+  template <typename T>
+  T get() {
+    always_assert(m_ptr + sizeof(T) <= m_end);
+    T value;
+    std::memcpy(&value, m_ptr, sizeof(T));
+    m_ptr += sizeof(T);
+    return value;
+  }
+
+  template <typename T>
+  T* get_ptr() {
+    return reinterpret_cast<T*>(get<uintptr_t>());
+  }
+
+  bool at_end() const { return m_ptr == m_end; }
+
+ private:
+  const char* m_ptr;
+  const char* m_end;
+};
+
+bool is_spillable(const IRCode& code) {
+  for (const auto& mie : code) {
+    if (mie.type == MFLOW_DEBUG || mie.type == MFLOW_DEX_OPCODE) {
+      return false;
+    }
+  }
+  return true;
+}
+
+uint64_t get_payload(const IRInstruction* insn) {
+  if (insn->has_literal()) {
+    return static_cast<uint64_t>(insn->get_literal());
+  } else if (insn->has_string()) {
+    return reinterpret_cast<uintptr_t>(insn->get_string());
+  } else if (insn->has_type()) {
+    return reinterpret_cast<uintptr_t>(insn->get_type());
+  } else if (insn->has_field()) {
+    return reinterpret_cast<uintptr_t>(insn->get_field());
+  } else if (insn->has_method()) {
+    return reinterpret_cast<uintptr_t>(insn->get_method());
+  } else if (insn->has_data()) {
+    return reinterpret_cast<uintptr_t>(insn->get_data());
+  } else if (insn->has_callsite()) {
+    return reinterpret_cast<uintptr_t>(insn->get_callsite());
+  } else if (insn->has_methodhandle()) {
+    return reinterpret_cast<uintptr_t>(insn->get_methodhandle());
+  }
+  return 0;
+}
+
+void set_payload(IRInstruction* insn, uint64_t payload) {
+  if (insn->has_literal()) {
+    insn->set_literal(static_cast<int64_t>(payload));
+  } else if (insn->has_string()) {
+    insn->set_string(reinterpret_cast<DexString*>(payload));
+  } else if (insn->has_type()) {
+    insn->set_type(reinterpret_cast<DexType*>(payload));
+  } else if (insn->has_field()) {
+    insn->set_field(reinterpret_cast<DexFieldRef*>(payload));
+  } else if (insn->has_method()) {
+    insn->set_method(reinterpret_cast<DexMethodRef*>(payload));
+  } else if (insn->has_data()) {
+    insn->set_data(reinterpret_cast<DexOpcodeData*>(payload));
+  } else if (insn->has_callsite()) {
+    insn->set_callsite(reinterpret_cast<DexCallSite*>(payload));
+  } else if (insn->has_methodhandle()) {
+    insn->set_methodhandle(reinterpret_cast<DexMethodHandle*>(payload));
+  }
+}
+
+/*
+ * Layout: the number of entries, the type of each entry, then the contents
+ * of each entry in order. References between entries are entry indices.
+ */
+void serialize(const IRCode& code, Writer* out) {
+  std::unordered_map<const MethodItemEntry*, uint32_t> indices;
+  for (const auto& mie : code) {
+    indices.emplace(&mie, indices.size());
+  }
+  auto index_of = [&indices](const MethodItemEntry* mie) {
+    return mie == nullptr ? kNoIndex : indices.at(mie);
+  };
+  std::unordered_map<const DexPosition*, uint32_t> position_indices;
+  for (const auto& mie : code) {
+    if (mie.type == MFLOW_POSITION) {
+      position_indices.emplace(mie.pos.get(), indices.at(&mie));
+    }
+  }
+
+  out->put<uint32_t>(indices.size());
+  for (const auto& mie : code) {
+    out->put<uint8_t>(mie.type);
+  }
+  for (const auto& mie : code) {
+    switch (mie.type) {
+    case MFLOW_TRY:
+      out->put<uint8_t>(mie.tentry->type);
+      out->put<uint32_t>(index_of(mie.tentry->catch_start));
+      break;
+    case MFLOW_CATCH:
+      out->put_ptr(mie.centry->catch_type);
+      out->put<uint32_t>(index_of(mie.centry->next));
+      break;
+    case MFLOW_TARGET:
+      out->put<uint8_t>(mie.target->type);
+      out->put<int32_t>(mie.target->case_key);
+      out->put<uint32_t>(index_of(mie.target->src));
+      break;
+    case MFLOW_OPCODE: {
+      const auto* insn = mie.insn;
+      out->put<uint16_t>(insn->opcode());
+      if (insn->has_dest()) {
+        out->put<reg_t>(insn->dest());
+      }
+      out->put<uint16_t>(insn->srcs_size());
+      for (auto reg : insn->srcs()) {
+        out->put<reg_t>(reg);
+      }
+      out->put<uint64_t>(get_payload(insn));
+      break;
+    }
+    case MFLOW_POSITION: {
+      const auto* pos = mie.pos.get();
+      out->put_ptr(pos->method);
+      out->put_ptr(pos->file);
+      out->put<uint32_t>(pos->line);
+      if (pos->parent == nullptr) {
+        out->put<uint8_t>(kNoParent);
+      } else if (position_indices.count(pos->parent)) {
+        out->put<uint8_t>(kParentIndex);
+        out->put<uint32_t>(position_indices.at(pos->parent));
+      } else {
+        out->put<uint8_t>(kParentPointer);
+        out->put_ptr(pos->parent);
+      }
+      break;
+    }
+    case MFLOW_SOURCE_BLOCK: {
+      uint32_t chain_length = 0;
+      for (auto* sb = mie.src_block.get(); sb != nullptr; sb = sb->next.get()) {
+        ++chain_length;
+      }
+      out->put<uint32_t>(chain_length);
+      for (auto* sb = mie.src_block.get(); sb != nullptr; sb = sb->next.get()) {
+        out->put_ptr(sb->src);
+        out->put<uint32_t>(sb->id);
+        out->put<uint32_t>(sb->vals.size());
+        for (const auto& val : sb->vals) {
+          auto none = std::numeric_limits<float>::quiet_NaN();
+          out->put<float>(val ? val->val : none);
+          out->put<float>(val ? val->appear100 : none);
+        }
+      }
+      break;
+    }
+    case MFLOW_FALLTHROUGH:
+      break;
+    case MFLOW_DEBUG:
+    case MFLOW_DEX_OPCODE:
+      not_reached();
+    }
+  }
+}
+
+void deserialize(Reader* in, IRCode* code) {
+  auto size = in->get<uint32_t>();
+  std::vector<MethodItemEntry*> entries(size);
+  for (auto& mie : entries) {
+    mie = new MethodItemEntry();
+    mie->type = static_cast<MethodItemType>(in->get<uint8_t>());
+  }
+  auto entry_at = [&entries](uint32_t index) {
+    return index == kNoIndex ? nullptr : entries.at(index);
+  };
+
+  std::vector<std::pair<DexPosition*, uint32_t>> parent_fixups;
+  for (auto* mie : entries) {
+    switch (mie->type) {
+    case MFLOW_TRY: {
+      auto type = static_cast<TryEntryType>(in->get<uint8_t>());
+      mie->tentry = new TryEntry(type, entry_at(in->get<uint32_t>()));
+      break;
+    }
+    case MFLOW_CATCH:
+      mie->centry = new CatchEntry(in->get_ptr<DexType>());
+      mie->centry->next = entry_at(in->get<uint32_t>());
+      break;
+    case MFLOW_TARGET:
+      mie->target = new BranchTarget();
+      mie->target->type = static_cast<BranchTargetType>(in->get<uint8_t>());
+      mie->target->case_key = in->get<int32_t>();
+      mie->target->src = entry_at(in->get<uint32_t>());
+      break;
+    case MFLOW_OPCODE: {
+      auto op = static_cast<IROpcode>(in->get<uint16_t>());
+      auto* insn = new IRInstruction(op);
+      if (insn->has_dest()) {
+        insn->set_dest(in->get<reg_t>());
+      }
+      auto srcs_size = in->get<uint16_t>();
+      insn->set_srcs_size(srcs_size);
+      for (src_index_t i = 0; i < srcs_size; ++i) {
+        insn->set_src(i, in->get<reg_t>());
+      }
+      set_payload(insn, in->get<uint64_t>());
+      mie->insn = insn;
+      break;
+    }
+    case MFLOW_POSITION: {
+      auto* method = in->get_ptr<DexString>();
+      auto* file = in->get_ptr<DexString>();
+      auto line = in->get<uint32_t>();
+      auto pos = std::make_unique<DexPosition>(method, file, line);
+      switch (in->get<uint8_t>()) {
+      case kNoParent:
+        break;
+      case kParentIndex:
+        parent_fixups.emplace_back(pos.get(), in->get<uint32_t>());
+        break;
+      case kParentPointer:
+        pos->parent = in->get_ptr<DexPosition>();
+        break;
+      default:
+        not_reached();
+      }
+      new (&mie->pos) std::unique_ptr<DexPosition>(std::move(pos));
+      break;
+    }
+    case MFLOW_SOURCE_BLOCK: {
+      new (&mie->src_block) std::unique_ptr<SourceBlock>();
+      auto* tail = &mie->src_block;
+      for (auto n = in->get<uint32_t>(); n != 0; --n) {
+        auto* src = in->get_ptr<DexMethodRef>();
+        auto id = in->get<uint32_t>();
+        auto num_vals = in->get<uint32_t>();
+        std::vector<SourceBlock::Val> vals;
+        vals.reserve(num_vals);
+        for (uint32_t i = 0; i < num_vals; ++i) {
+          auto val = in->get<float>();
+          auto appear100 = in->get<float>();
+          vals.emplace_back(val, appear100);
+        }
+        *tail = std::make_unique<SourceBlock>(src, id, vals);
+        tail = &(*tail)->next;
+      }
+      break;
+    }
+    case MFLOW_FALLTHROUGH:
+      break;
+    case MFLOW_DEBUG:
+    case MFLOW_DEX_OPCODE:
+      not_reached();
+    }
+  }
+  always_assert(in->at_end());
+
+  for (const auto& fixup : parent_fixups) {
+    fixup.first->parent = entries.at(fixup.second)->pos.get();
+  }
+  for (auto* mie : entries) {
+    code->push_back(*mie);
+  }
+}
+
+void clear(IRCode* code) {
+  for (auto it = code->begin(); it != code->end();) {
+    if (it->type == MFLOW_OPCODE) {
+      delete it->insn;
+    }
+    it = code->erase_and_dispose(it);
+  }
+}
+
+} // namespace
+
+namespace code_spill {
+
+CodeSpill* CodeSpill::s_active = nullptr;
+
+CodeSpill::CodeSpill(std::string path)
+    : m_path(std::move(path)),
+      m_out(m_path, std::ios::binary | std::ios::trunc) {
+  always_assert_log(m_out, "Could not open code spill file %s",
+                    m_path.c_str());
+  always_assert(s_active == nullptr);
+  s_active = this;
+}
+
+CodeSpill::~CodeSpill() {
+  restore_all();
+  s_active = nullptr;
+  m_mapped.reset();
+  m_out.close();
+  boost::system::error_code ec;
+  boost::filesystem::remove(m_path, ec);
+}
+
+size_t CodeSpill::spill(const Scope& scope) {
+  std::atomic<size_t> spilled{0};
+  walk::parallel::methods(scope, [&](DexMethod* method) {
+    if (method->is_code_spilled()) {
+      return;
+    }
+    auto* code = method->m_code.get();
+    if (code == nullptr || code->cfg_built() || !is_spillable(*code)) {
+      return;
+    }
+    Writer writer;
+    serialize(*code, &writer);
+    const auto& buf = writer.buffer();
+    Record record{0, buf.size()};
+    {
+      std::lock_guard<std::mutex> lock(m_write_lock);
+      record.offset = m_file_size;
+      m_out.write(buf.data(), buf.size());
+      m_file_size += buf.size();
+    }
+    m_records.insert_or_assign(std::make_pair(method, record));
+    clear(code);
+    method->m_code_spilled.store(true, std::memory_order_release);
+    spilled.fetch_add(1, std::memory_order_relaxed);
+  });
+
+  // Restored methods are written again when they are spilled the next time,
+  // so the file only grows. The old mapping may be too short for the records
+  // just written.
+  m_out.flush();
+  always_assert_log(m_out, "Could not write code spill file %s",
+                    m_path.c_str());
+  m_mapped.reset();
+  if (m_file_size != 0) {
+    m_mapped = std::make_unique<RedexMappedFile>(
+        RedexMappedFile::open(m_path, /* read_only */ true));
+  }
+  TRACE(PM, 2, "Spilled code of %zu methods, %zu bytes in %s", spilled.load(),
+        m_file_size, m_path.c_str());
+  return spilled.load();
+}
+
+void CodeSpill::restore_all() {
+  std::vector<const DexMethod*> methods;
+  methods.reserve(m_records.size());
+  for (const auto& pair : m_records) {
+    methods.push_back(pair.first);
+  }
+  workqueue_run<const DexMethod*>(
+      [&](const DexMethod* method) { restore_impl(method); }, methods);
+}
+
+void CodeSpill::restore(const DexMethod* method) {
+  always_assert_log(s_active != nullptr, "%s is spilled without a CodeSpill",
+                    SHOW(method));
+  s_active->restore_impl(method);
+}
+
+void CodeSpill::restore_impl(const DexMethod* method) {
+  if (!method->is_code_spilled()) {
+    return;
+  }
+  auto& lock =
+      m_restore_locks[std::hash<const DexMethod*>()(method) %
+                      m_restore_locks.size()];
+  std::lock_guard<std::mutex> guard(lock);
+  if (!method->is_code_spilled()) {
+    return;
+  }
+  auto record = m_records.at(method);
+  Reader reader(m_mapped->const_data() + record.offset, record.size);
+  deserialize(&reader, method->m_code.get());
+  m_records.erase(method);
+  method->m_code_spilled.store(false, std::memory_order_release);
+}
+
+} // namespace code_spill
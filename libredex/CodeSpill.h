@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <array>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "ConcurrentContainers.h"
+#include "DexClass.h"
+#include "RedexMappedFile.h"
+
+namespace code_spill {
+
+/*
+ * Moves the instructions of methods out of memory into a spill file between
+ * passes, so that code which the next pass never looks at does not count
+ * towards the peak memory of the whole pipeline.
+ *
+ * Only the IRList of a method is spilled; the IRCode itself stays attached to
+ * the method, so that checks for the presence of code don't need the file. The
+ * first DexMethod::get_code() of a spilled method reads its entries back from
+ * the mapped file. The entries are restored as new objects, so nothing may
+ * hold on to instructions or entries of a method across a spill.
+ *
+ * Entries refer to other Dex members by pointer, so the file is only
+ * meaningful to the process that wrote it. Methods with a CFG or with local
+ * variable debug info are left in memory.
+ */
+class CodeSpill {
+ public:
+  explicit CodeSpill(std::string path);
+  ~CodeSpill();
+
+  CodeSpill(const CodeSpill&) = delete;
+  CodeSpill& operator=(const CodeSpill&) = delete;
+
+  /*
+   * Spills the code of all methods in the scope which are not spilled yet.
+   * Returns the number of methods spilled.
+   */
+  size_t spill(const Scope& scope);
+
+  /*
+   * Brings the code of all spilled methods back into memory. Also done when
+   * the CodeSpill is destroyed.
+   */
+  void restore_all();
+
+  /*
+   * Brings the code of the given method back into memory, if it is spilled.
+   * Thread-safe.
+   */
+  static void restore(const DexMethod* method);
+
+ private:
+  struct Record {
+    size_t offset;
+    size_t size;
+  };
+
+  void restore_impl(const DexMethod* method);
+
+  std::string m_path;
+  std::mutex m_write_lock;
+  std::ofstream m_out;
+  size_t m_file_size{0};
+  std::unique_ptr<RedexMappedFile> m_mapped;
+  ConcurrentMap<const DexMethod*, Record> m_records;
+  std::array<std::mutex, 64> m_restore_locks;
+
+  static CodeSpill* s_active;
+};
+
+} // namespace code_spill
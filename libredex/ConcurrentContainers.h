@@ -7,12 +7,16 @@
 
 #pragma once
 
+#include <atomic>
 #include <functional>
 #include <initializer_list>
 #include <iterator>
+#include <memory>
+#include <stdexcept>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include <boost/thread.hpp>
 
@@ -527,6 +531,514 @@ class InsertOnlyConcurrentSet final
   size_t erase(const Key& key) = delete;
 };
 
+/*
+ * A concurrent map for read-mostly workloads, such as caches and interning
+ * tables, with the same interface as `ConcurrentMap`.
+ *
+ * Lookups (`get`, `count`, `at`) are lock-free: each slot is an open-addressing
+ * table of atomic pointers to immutable entries. Writers still serialize on a
+ * per-slot lock; they never modify a published entry or table in place, but
+ * publish a new one and retire the old one. Retired entries and tables are
+ * only reclaimed at quiescent points, namely `clear()` and destruction, so
+ * concurrent readers never observe freed memory. Consequently, maps that see
+ * many overwrites or erasures of the same keys accumulate garbage; use a
+ * `ConcurrentMap` for those.
+ *
+ * The same access modes as for `ConcurrentContainer` apply to iteration,
+ * `find()` and the `_unsafe` accessors.
+ */
+template <typename Key,
+          typename Value,
+          typename Hash = std::hash<Key>,
+          typename Equal = std::equal_to<Key>,
+          size_t n_slots = 31>
+class ReadMostlyConcurrentMap final {
+ public:
+  static_assert(n_slots > 0, "The concurrent container has no slots");
+
+  using value_type = std::pair<const Key, Value>;
+
+ private:
+  using Entry = value_type;
+
+  struct Table {
+    explicit Table(size_t capacity)
+        : capacity(capacity),
+          buckets(std::make_unique<std::atomic<Entry*>[]>(capacity)) {
+      for (size_t i = 0; i < capacity; ++i) {
+        buckets[i].store(nullptr, std::memory_order_relaxed);
+      }
+    }
+    // Always a power of two.
+    size_t capacity;
+    std::unique_ptr<std::atomic<Entry*>[]> buckets;
+  };
+
+  struct Slot {
+    std::atomic<Table*> table{nullptr};
+    // Number of live entries, and of buckets that are live or erased.
+    size_t size{0};
+    size_t used{0};
+    // Live entries are owned by the current table; everything else awaits
+    // reclamation.
+    std::vector<std::unique_ptr<Table>> tables;
+    std::vector<std::unique_ptr<Entry>> retired_entries;
+  };
+
+  // Marks an erased bucket. Lookups continue probing past it.
+  static Entry* tombstone() { return reinterpret_cast<Entry*>(uintptr_t(1)); }
+
+  static bool is_live(const Entry* e) {
+    return e != nullptr && e != tombstone();
+  }
+
+  static constexpr size_t kMinCapacity = 8;
+
+ public:
+  template <typename SlotPtr, typename Reference>
+  class Iterator final {
+   public:
+    using difference_type = std::ptrdiff_t;
+    using value_type = ReadMostlyConcurrentMap::value_type;
+    using pointer = std::remove_reference_t<Reference>*;
+    using reference = Reference;
+    using iterator_category = std::forward_iterator_tag;
+
+    explicit Iterator(SlotPtr slots) : m_slots(slots), m_slot(n_slots) {}
+
+    Iterator(SlotPtr slots, size_t slot, size_t bucket)
+        : m_slots(slots), m_slot(slot), m_bucket(bucket) {
+      skip_empty_buckets();
+    }
+
+    Iterator& operator++() {
+      always_assert(m_slot < n_slots);
+      ++m_bucket;
+      skip_empty_buckets();
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator retval = *this;
+      ++(*this);
+      return retval;
+    }
+
+    bool operator==(const Iterator& other) const {
+      return m_slots == other.m_slots && m_slot == other.m_slot &&
+             (m_slot == n_slots || m_bucket == other.m_bucket);
+    }
+
+    bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+    reference operator*() const { return *entry(); }
+
+    pointer operator->() const { return entry(); }
+
+   private:
+    Entry* entry() const {
+      always_assert(m_slot < n_slots);
+      auto* table = m_slots[m_slot].table.load(std::memory_order_relaxed);
+      return table->buckets[m_bucket].load(std::memory_order_relaxed);
+    }
+
+    void skip_empty_buckets() {
+      for (; m_slot < n_slots; ++m_slot, m_bucket = 0) {
+        auto* table = m_slots[m_slot].table.load(std::memory_order_relaxed);
+        if (table == nullptr) {
+          continue;
+        }
+        for (; m_bucket < table->capacity; ++m_bucket) {
+          if (is_live(
+                  table->buckets[m_bucket].load(std::memory_order_relaxed))) {
+            return;
+          }
+        }
+      }
+    }
+
+    SlotPtr m_slots;
+    size_t m_slot;
+    size_t m_bucket{0};
+  };
+
+  using iterator = Iterator<Slot*, value_type&>;
+  using const_iterator = Iterator<const Slot*, const value_type&>;
+
+  ReadMostlyConcurrentMap() = default;
+
+  ReadMostlyConcurrentMap(const ReadMostlyConcurrentMap& other) {
+    for (const auto& entry : other) {
+      insert(entry);
+    }
+  }
+
+  ReadMostlyConcurrentMap(ReadMostlyConcurrentMap&& other) noexcept {
+    for (size_t i = 0; i < n_slots; ++i) {
+      auto& from = other.m_slots[i];
+      auto& to = m_slots[i];
+      to.table.store(from.table.exchange(nullptr));
+      to.size = std::exchange(from.size, 0);
+      to.used = std::exchange(from.used, 0);
+      to.tables = std::move(from.tables);
+      to.retired_entries = std::move(from.retired_entries);
+      from.tables.clear();
+      from.retired_entries.clear();
+    }
+  }
+
+  template <typename InputIt>
+  ReadMostlyConcurrentMap(InputIt first, InputIt last) {
+    insert(first, last);
+  }
+
+  ~ReadMostlyConcurrentMap() { clear(); }
+
+  ReadMostlyConcurrentMap& operator=(const ReadMostlyConcurrentMap&) = delete;
+  ReadMostlyConcurrentMap& operator=(ReadMostlyConcurrentMap&&) = delete;
+
+  iterator begin() { return iterator(m_slots, 0, 0); }
+
+  iterator end() { return iterator(m_slots); }
+
+  const_iterator begin() const { return const_iterator(m_slots, 0, 0); }
+
+  const_iterator end() const { return const_iterator(m_slots); }
+
+  const_iterator cbegin() const { return begin(); }
+
+  const_iterator cend() const { return end(); }
+
+  iterator find(const Key& key) {
+    size_t hash = Hash()(key);
+    size_t slot = hash % n_slots;
+    size_t bucket;
+    if (lookup(m_slots[slot], key, hash, &bucket) == nullptr) {
+      return end();
+    }
+    return iterator(m_slots, slot, bucket);
+  }
+
+  const_iterator find(const Key& key) const {
+    size_t hash = Hash()(key);
+    size_t slot = hash % n_slots;
+    size_t bucket;
+    if (lookup(m_slots[slot], key, hash, &bucket) == nullptr) {
+      return end();
+    }
+    return const_iterator(m_slots, slot, bucket);
+  }
+
+  size_t size() const {
+    size_t s = 0;
+    for (size_t slot = 0; slot < n_slots; ++slot) {
+      s += m_slots[slot].size;
+    }
+    return s;
+  }
+
+  bool empty() const { return size() == 0; }
+
+  void reserve(size_t capacity) {
+    size_t slot_capacity = capacity / n_slots;
+    if (slot_capacity > 0) {
+      for (size_t i = 0; i < n_slots; ++i) {
+        boost::lock_guard<boost::mutex> lock(m_locks[i]);
+        auto* table = m_slots[i].table.load(std::memory_order_relaxed);
+        if (table == nullptr || table->capacity < 2 * slot_capacity) {
+          rehash(m_slots[i], 2 * slot_capacity);
+        }
+      }
+    }
+  }
+
+  /*
+   * This frees all entries, including retired ones, and is therefore not
+   * thread-safe.
+   */
+  void clear() {
+    for (size_t slot = 0; slot < n_slots; ++slot) {
+      auto& s = m_slots[slot];
+      auto* table = s.table.exchange(nullptr);
+      if (table != nullptr) {
+        for (size_t i = 0; i < table->capacity; ++i) {
+          auto* entry = table->buckets[i].load(std::memory_order_relaxed);
+          if (is_live(entry)) {
+            delete entry;
+          }
+        }
+      }
+      s.size = 0;
+      s.used = 0;
+      s.tables.clear();
+      s.retired_entries.clear();
+    }
+  }
+
+  /*
+   * This operation is always thread-safe and lock-free.
+   */
+  size_t count(const Key& key) const {
+    size_t hash = Hash()(key);
+    return lookup(m_slots[hash % n_slots], key, hash) != nullptr ? 1 : 0;
+  }
+
+  size_t count_unsafe(const Key& key) const { return count(key); }
+
+  /*
+   * This operation is always thread-safe and lock-free. Like
+   * `ConcurrentMap::at`, it throws `std::out_of_range` if the key is absent.
+   */
+  Value at(const Key& key) const { return at_unsafe(key); }
+
+  const Value& at_unsafe(const Key& key) const {
+    size_t hash = Hash()(key);
+    auto* entry = lookup(m_slots[hash % n_slots], key, hash);
+    if (entry == nullptr) {
+      throw std::out_of_range("ReadMostlyConcurrentMap::at");
+    }
+    return entry->second;
+  }
+
+  Value& at_unsafe(const Key& key) {
+    return const_cast<Value&>(
+        static_cast<const ReadMostlyConcurrentMap*>(this)->at_unsafe(key));
+  }
+
+  /*
+   * This operation is always thread-safe and lock-free.
+   */
+  Value get(const Key& key, Value default_value) const {
+    size_t hash = Hash()(key);
+    auto* entry = lookup(m_slots[hash % n_slots], key, hash);
+    if (entry == nullptr) {
+      return default_value;
+    }
+    return entry->second;
+  }
+
+  /*
+   * The Boolean return value denotes whether the insertion took place.
+   * This operation is always thread-safe.
+   */
+  bool insert(const std::pair<Key, Value>& entry) {
+    return emplace(entry.first, entry.second);
+  }
+
+  /*
+   * This operation is always thread-safe.
+   */
+  void insert(std::initializer_list<std::pair<Key, Value>> l) {
+    for (const auto& entry : l) {
+      insert(entry);
+    }
+  }
+
+  /*
+   * This operation is always thread-safe.
+   */
+  template <typename InputIt>
+  void insert(InputIt first, InputIt last) {
+    for (; first != last; ++first) {
+      insert(*first);
+    }
+  }
+
+  /*
+   * This operation is always thread-safe.
+   */
+  void insert_or_assign(const std::pair<Key, Value>& entry) {
+    size_t hash = Hash()(entry.first);
+    size_t slot = hash % n_slots;
+    boost::lock_guard<boost::mutex> lock(m_locks[slot]);
+    publish(m_slots[slot], hash, std::make_unique<Entry>(entry), true);
+  }
+
+  /*
+   * This operation is always thread-safe.
+   */
+  template <typename... Args>
+  bool emplace(Args&&... args) {
+    auto entry = std::make_unique<Entry>(std::forward<Args>(args)...);
+    size_t hash = Hash()(entry->first);
+    size_t slot = hash % n_slots;
+    boost::lock_guard<boost::mutex> lock(m_locks[slot]);
+    return publish(m_slots[slot], hash, std::move(entry), false);
+  }
+
+  /*
+   * This operation is always thread-safe.
+   */
+  size_t erase(const Key& key) {
+    size_t hash = Hash()(key);
+    size_t slot = hash % n_slots;
+    boost::lock_guard<boost::mutex> lock(m_locks[slot]);
+    auto& s = m_slots[slot];
+    size_t bucket;
+    auto* entry = lookup(s, key, hash, &bucket);
+    if (entry == nullptr) {
+      return 0;
+    }
+    auto* table = s.table.load(std::memory_order_relaxed);
+    table->buckets[bucket].store(tombstone(), std::memory_order_release);
+    s.retired_entries.emplace_back(entry);
+    --s.size;
+    return 1;
+  }
+
+  /*
+   * This operation atomically modifies an entry in the map. If the entry
+   * doesn't exist, it is created. The third argument of the updater function is
+   * a Boolean flag denoting whether the entry exists or not.
+   *
+   * The updater operates on a copy of the value, which then replaces the
+   * published entry.
+   */
+  template <
+      typename UpdateFn = const std::function<void(const Key&, Value&, bool)>&>
+  void update(const Key& key, UpdateFn updater) {
+    size_t hash = Hash()(key);
+    size_t slot = hash % n_slots;
+    boost::lock_guard<boost::mutex> lock(m_locks[slot]);
+    auto& s = m_slots[slot];
+    auto* existing = lookup(s, key, hash);
+    auto entry = existing != nullptr ? std::make_unique<Entry>(*existing)
+                                     : std::make_unique<Entry>(key, Value());
+    updater(entry->first, entry->second, existing != nullptr);
+    publish(s, hash, std::move(entry), true);
+  }
+
+  template <
+      typename UpdateFn = const std::function<void(const Key&, Value&, bool)>&>
+  void update_unsafe(const Key& key, UpdateFn updater) {
+    size_t hash = Hash()(key);
+    auto& s = m_slots[hash % n_slots];
+    auto* existing = lookup(s, key, hash);
+    if (existing != nullptr) {
+      updater(existing->first, existing->second, true);
+      return;
+    }
+    auto entry = std::make_unique<Entry>(key, Value());
+    updater(entry->first, entry->second, false);
+    publish(s, hash, std::move(entry), false);
+  }
+
+  /*
+   * WARNING: Only use with unsafe functions, or risk deadlock or undefined
+   * behavior!
+   */
+  boost::mutex& get_lock(const Key& key) const {
+    return m_locks[Hash()(key) % n_slots];
+  }
+
+ private:
+  // Spread the hash over the bucket bits; std::hash of pointers and integers
+  // is the identity.
+  static size_t home_bucket(size_t hash, size_t capacity) {
+    uint64_t h = hash / n_slots;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return (size_t)h & (capacity - 1);
+  }
+
+  static Entry* lookup(const Slot& s,
+                       const Key& key,
+                       size_t hash,
+                       size_t* bucket_out = nullptr) {
+    auto* table = s.table.load(std::memory_order_acquire);
+    if (table == nullptr) {
+      return nullptr;
+    }
+    size_t mask = table->capacity - 1;
+    size_t bucket = home_bucket(hash, table->capacity);
+    for (size_t i = 0; i < table->capacity; ++i, bucket = (bucket + 1) & mask) {
+      auto* entry = table->buckets[bucket].load(std::memory_order_acquire);
+      if (entry == nullptr) {
+        return nullptr;
+      }
+      if (entry != tombstone() && Equal()(entry->first, key)) {
+        if (bucket_out != nullptr) {
+          *bucket_out = bucket;
+        }
+        return entry;
+      }
+    }
+    return nullptr;
+  }
+
+  // Must be called with the slot lock held. Returns whether the entry's key
+  // was absent. An existing entry is only replaced if `overwrite` is set.
+  bool publish(Slot& s,
+               size_t hash,
+               std::unique_ptr<Entry> entry,
+               bool overwrite) {
+    size_t bucket;
+    auto* existing = lookup(s, entry->first, hash, &bucket);
+    if (existing != nullptr) {
+      if (overwrite) {
+        auto* table = s.table.load(std::memory_order_relaxed);
+        table->buckets[bucket].store(entry.release(),
+                                     std::memory_order_release);
+        s.retired_entries.emplace_back(existing);
+      }
+      return false;
+    }
+    auto* table = s.table.load(std::memory_order_relaxed);
+    // Keep the load factor, including tombstones, at most one half so that
+    // probe sequences stay short.
+    if (table == nullptr || 2 * (s.used + 1) > table->capacity) {
+      rehash(s, 4 * (s.size + 1));
+      table = s.table.load(std::memory_order_relaxed);
+    }
+    size_t mask = table->capacity - 1;
+    bucket = home_bucket(hash, table->capacity);
+    while (true) {
+      auto* current = table->buckets[bucket].load(std::memory_order_relaxed);
+      if (!is_live(current)) {
+        if (current == nullptr) {
+          ++s.used;
+        }
+        break;
+      }
+      bucket = (bucket + 1) & mask;
+    }
+    table->buckets[bucket].store(entry.release(), std::memory_order_release);
+    ++s.size;
+    return true;
+  }
+
+  // Must be called with the slot lock held. Publishes a fresh table holding
+  // the live entries, dropping all tombstones.
+  void rehash(Slot& s, size_t min_capacity) {
+    size_t capacity = kMinCapacity;
+    while (capacity < min_capacity) {
+      capacity *= 2;
+    }
+    auto new_table = std::make_unique<Table>(capacity);
+    size_t mask = capacity - 1;
+    auto* old_table = s.table.load(std::memory_order_relaxed);
+    for (size_t i = 0; old_table != nullptr && i < old_table->capacity; ++i) {
+      auto* entry = old_table->buckets[i].load(std::memory_order_relaxed);
+      if (!is_live(entry)) {
+        continue;
+      }
+      size_t bucket = home_bucket(Hash()(entry->first), capacity);
+      while (new_table->buckets[bucket].load(std::memory_order_relaxed) !=
+             nullptr) {
+        bucket = (bucket + 1) & mask;
+      }
+      new_table->buckets[bucket].store(entry, std::memory_order_relaxed);
+    }
+    s.used = s.size;
+    s.table.store(new_table.get(), std::memory_order_release);
+    s.tables.push_back(std::move(new_table));
+  }
+
+  mutable boost::mutex m_locks[n_slots];
+  Slot m_slots[n_slots];
+};
+
 namespace cc_impl {
 
 template <typename Container, size_t n_slots>
@@ -17,6 +17,8 @@
 #include "Debug.h"
 #include "DexClass.h"
 #include "FrameworkApi.h"
+#include "IPConstantPropagationSummaryCache.h"
+#include "InlinedCostCache.h"
 #include "InlinerConfig.h"
 #include "MethodProfiles.h"
 #include "ProguardMap.h"
@@ -233,6 +235,7 @@ void ConfigFiles::load_inliner_config(inliner::InlinerConfig* inliner_config) {
   jw.get("run_reg_alloc", false, shrinker_config.run_reg_alloc);
   jw.get("run_fast_reg_alloc", false, shrinker_config.run_fast_reg_alloc);
   jw.get("run_dedup_blocks", false, shrinker_config.run_dedup_blocks);
+  jw.get("shrinker_max_rounds", (size_t)1, shrinker_config.max_rounds);
   jw.get("debug", false, inliner_config->debug);
   jw.get("blocklist", {}, inliner_config->m_blocklist);
   jw.get("caller_blocklist", {}, inliner_config->m_caller_blocklist);
@@ -273,6 +276,22 @@ const inliner::InlinerConfig& ConfigFiles::get_inliner_config() {
   return *m_inliner_config;
 }
 
+inliner::InlinedCostCache& ConfigFiles::get_inlined_cost_cache() {
+  if (m_inlined_cost_cache == nullptr) {
+    m_inlined_cost_cache = std::make_unique<inliner::InlinedCostCache>();
+  }
+  return *m_inlined_cost_cache;
+}
+
+constant_propagation::interprocedural::SummaryCache&
+ConfigFiles::get_ip_constant_propagation_summary_cache() {
+  if (m_ip_constant_propagation_summary_cache == nullptr) {
+    m_ip_constant_propagation_summary_cache =
+        std::make_unique<constant_propagation::interprocedural::SummaryCache>();
+  }
+  return *m_ip_constant_propagation_summary_cache;
+}
+
 void ConfigFiles::parse_global_config() {
   m_global_config.parse_config(m_json);
 }
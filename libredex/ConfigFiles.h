@@ -29,8 +29,15 @@ namespace api {
 class AndroidSDK;
 } // namespace api
 
+namespace constant_propagation {
+namespace interprocedural {
+class SummaryCache;
+} // namespace interprocedural
+} // namespace constant_propagation
+
 namespace inliner {
 struct InlinerConfig;
+class InlinedCostCache;
 } // namespace inliner
 
 namespace method_profiles {
@@ -129,6 +136,18 @@ struct ConfigFiles {
    */
   const inliner::InlinerConfig& get_inliner_config();
 
+  /**
+   * Inlined costs of callees, shared by all inlining passes of this run.
+   */
+  inliner::InlinedCostCache& get_inlined_cost_cache();
+
+  /**
+   * Method summaries of the interprocedural constant propagation, shared by
+   * all of its runs.
+   */
+  constant_propagation::interprocedural::SummaryCache&
+  get_ip_constant_propagation_summary_cache();
+
   boost::optional<std::string> get_android_sdk_api_file(int32_t api_level) {
     std::string api_file;
     std::string key = "android_sdk_api_" + std::to_string(api_level) + "_file";
@@ -184,6 +203,9 @@ struct ConfigFiles {
   std::unordered_set<DexString*> m_finalish_field_names;
   // Global inliner config.
   std::unique_ptr<inliner::InlinerConfig> m_inliner_config;
+  std::unique_ptr<inliner::InlinedCostCache> m_inlined_cost_cache;
+  std::unique_ptr<constant_propagation::interprocedural::SummaryCache>
+      m_ip_constant_propagation_summary_cache;
   // min_sdk AndroidAPI
   int32_t m_min_sdk_api_level = 0;
   std::unique_ptr<api::AndroidSDK> m_android_min_sdk_api;
@@ -17,8 +17,10 @@
 #include "DexInstruction.h"
 #include "DexPosition.h"
 #include "DexUtil.h"
+#include "Dominators.h"
 #include "GraphUtil.h"
 #include "IRList.h"
+#include "MonotonicFixpointIterator.h"
 #include "Show.h"
 #include "Trace.h"
 #include "Transform.h"
@@ -114,8 +116,8 @@ void remove_duplicate_positions(IRList* ir) {
 bool catch_entries_equivalent_to_throw_edges(
     cfg::ControlFlowGraph* cfg,
     MethodItemEntry* first_mie,
-    std::vector<cfg::Edge*>::iterator it,
-    std::vector<cfg::Edge*>::iterator end,
+    cfg::EdgeList::iterator it,
+    cfg::EdgeList::iterator end,
     const std::unordered_map<MethodItemEntry*, cfg::Block*>&
         catch_to_containing_block) {
   for (auto mie = first_mie; mie != nullptr; mie = mie->centry->next) {
@@ -451,8 +453,8 @@ bool Block::cannot_throw() const {
   return true;
 }
 
-std::vector<Edge*> Block::get_outgoing_throws_in_order() const {
-  std::vector<Edge*> result =
+EdgeList Block::get_outgoing_throws_in_order() const {
+  EdgeList result =
       m_parent->get_succ_edges_of_type(this, EDGE_THROW);
   std::sort(result.begin(), result.end(), [](const Edge* e1, const Edge* e2) {
     return e1->throw_info()->index < e2->throw_info()->index;
@@ -943,6 +945,7 @@ std::pair<uint32_t, bool> ControlFlowGraph::remove_unreachable_blocks() {
       b->free();
       delete b;
       it = m_blocks.erase(it);
+      invalidate_cached_orderings();
     } else {
       ++it;
     }
@@ -1047,6 +1050,7 @@ void ControlFlowGraph::remove_empty_blocks() {
 
       if (b == entry_block()) {
         m_entry_block = succ;
+        invalidate_cached_orderings();
       }
 
       // Move positions if succ doesn't have any
@@ -1094,6 +1098,7 @@ void ControlFlowGraph::remove_empty_blocks() {
     b->free();
     delete b;
     it = m_blocks.erase(it);
+    invalidate_cached_orderings();
   }
   fix_dangling_parents(std::move(dangling));
 }
@@ -1870,8 +1875,7 @@ MethodItemEntry* ControlFlowGraph::create_catch(
     std::unordered_map<MethodItemEntry*, Block*>* catch_to_containing_block) {
   always_assert(m_editable);
 
-  using EdgeVector = std::vector<Edge*>;
-  EdgeVector throws = get_succ_edges_of_type(block, EDGE_THROW);
+  EdgeList throws = get_succ_edges_of_type(block, EDGE_THROW);
   if (throws.empty()) {
     // No need to create a catch if there are no throws
     return nullptr;
@@ -1889,7 +1893,7 @@ MethodItemEntry* ControlFlowGraph::create_catch(
   // We stop early if we find find an equivalent linked list of catch entries
   return self_recursive_fn(
       [this, &throws_end, catch_to_containing_block](
-          auto self, const EdgeVector::iterator& it) -> MethodItemEntry* {
+          auto self, const EdgeList::iterator& it) -> MethodItemEntry* {
         if (it == throws_end) {
           return nullptr;
         }
@@ -1969,12 +1973,82 @@ std::vector<Block*> ControlFlowGraph::blocks_reverse_post_deprecated() const {
   return postorder;
 }
 
+struct ControlFlowGraph::CachedOrderings {
+  std::shared_ptr<const std::vector<Block*>> reverse_postorder;
+  std::shared_ptr<const sparta::WeakPartialOrdering<Block*>> forward_wpo;
+  std::shared_ptr<const sparta::WeakPartialOrdering<Block*>> backward_wpo;
+  std::shared_ptr<const dominators::SimpleFastDominators<GraphInterface>>
+      dominator_tree;
+};
+
+ControlFlowGraph::CachedOrderings& ControlFlowGraph::cached_orderings() const {
+  if (!m_cached_orderings) {
+    m_cached_orderings = std::make_unique<CachedOrderings>();
+  }
+  return *m_cached_orderings;
+}
+
+void ControlFlowGraph::invalidate_cached_orderings() {
+  m_cached_orderings.reset();
+}
+
+std::shared_ptr<const std::vector<Block*>> ControlFlowGraph::reverse_postorder()
+    const {
+  std::lock_guard<std::mutex> lock(m_cached_orderings_lock);
+  auto& cache = cached_orderings();
+  if (!cache.reverse_postorder) {
+    auto order = graph::postorder_sort<GraphInterface>(*this);
+    std::reverse(order.begin(), order.end());
+    cache.reverse_postorder =
+        std::make_shared<const std::vector<Block*>>(std::move(order));
+  }
+  return cache.reverse_postorder;
+}
+
+std::shared_ptr<const sparta::WeakPartialOrdering<Block*>>
+ControlFlowGraph::forward_wpo() const {
+  std::lock_guard<std::mutex> lock(m_cached_orderings_lock);
+  auto& cache = cached_orderings();
+  if (!cache.forward_wpo) {
+    cache.forward_wpo =
+        sparta::make_weak_partial_ordering<GraphInterface>(*this);
+  }
+  return cache.forward_wpo;
+}
+
+std::shared_ptr<const sparta::WeakPartialOrdering<Block*>>
+ControlFlowGraph::backward_wpo() const {
+  always_assert_log(m_exit_block != nullptr,
+                    "Call calculate_exit_block() first");
+  std::lock_guard<std::mutex> lock(m_cached_orderings_lock);
+  auto& cache = cached_orderings();
+  if (!cache.backward_wpo) {
+    cache.backward_wpo = sparta::make_weak_partial_ordering<
+        sparta::BackwardsFixpointIterationAdaptor<GraphInterface>>(*this);
+  }
+  return cache.backward_wpo;
+}
+
+std::shared_ptr<const dominators::SimpleFastDominators<GraphInterface>>
+ControlFlowGraph::dominator_tree() const {
+  std::lock_guard<std::mutex> lock(m_cached_orderings_lock);
+  auto& cache = cached_orderings();
+  if (!cache.dominator_tree) {
+    cache.dominator_tree = std::make_shared<
+        const dominators::SimpleFastDominators<GraphInterface>>(*this);
+  }
+  return cache.dominator_tree;
+}
+
+ControlFlowGraph::ControlFlowGraph() = default;
+
 ControlFlowGraph::~ControlFlowGraph() { free_all_blocks_and_edges(); }
 
 Block* ControlFlowGraph::create_block() {
   size_t id = next_block_id();
   Block* b = new Block(this, id);
   m_blocks.emplace(id, b);
+  invalidate_cached_orderings();
   return b;
 }
 
@@ -2115,6 +2189,7 @@ void ControlFlowGraph::calculate_exit_block() {
       add_edge(b, m_exit_block, EDGE_GHOST);
     }
   }
+  invalidate_cached_orderings();
 }
 
 // public API edge removal functions
@@ -2173,6 +2248,7 @@ void ControlFlowGraph::clear() {
   m_exit_block = nullptr;
 
   m_editable = true;
+  invalidate_cached_orderings();
 }
 
 // After `edges` have been removed from the graph,
@@ -2219,14 +2295,14 @@ Edge* ControlFlowGraph::get_succ_edge_of_type(const Block* block,
                           [type](const Edge* e) { return e->type() == type; });
 }
 
-std::vector<Edge*> ControlFlowGraph::get_pred_edges_of_type(
-    const Block* block, EdgeType type) const {
+EdgeList ControlFlowGraph::get_pred_edges_of_type(const Block* block,
+                                                 EdgeType type) const {
   return get_pred_edges_if(block,
                            [type](const Edge* e) { return e->type() == type; });
 }
 
-std::vector<Edge*> ControlFlowGraph::get_succ_edges_of_type(
-    const Block* block, EdgeType type) const {
+EdgeList ControlFlowGraph::get_succ_edges_of_type(const Block* block,
+                                                 EdgeType type) const {
   return get_succ_edges_if(block,
                            [type](const Edge* e) { return e->type() == type; });
 }
@@ -2299,6 +2375,7 @@ void ControlFlowGraph::merge_blocks(Block* pred, Block* succ) {
   delete_succ_edges(succ);
   m_blocks.erase(succ->id());
   delete succ;
+  invalidate_cached_orderings();
 }
 
 void ControlFlowGraph::set_edge_target(Edge* edge, Block* new_target) {
@@ -2327,6 +2404,7 @@ void ControlFlowGraph::move_edge(Edge* edge,
 
   edge->src()->m_succs.push_back(edge);
   edge->target()->m_preds.push_back(edge);
+  invalidate_cached_orderings();
 }
 
 bool ControlFlowGraph::blocks_are_in_same_try(const Block* b1,
@@ -2614,6 +2692,7 @@ uint32_t ControlFlowGraph::remove_blocks(const std::vector<Block*>& blocks) {
                       "Block %zu wasn't in CFG. Attempted double delete?", id);
     block->m_entries.clear_and_dispose();
     delete block;
+    invalidate_cached_orderings();
   }
 
   fix_dangling_parents(std::move(dangling));
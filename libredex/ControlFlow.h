@@ -7,9 +7,15 @@
 
 #pragma once
 
+#include <boost/container/small_vector.hpp>
 #include <boost/dynamic_bitset.hpp>
 #include <boost/optional/optional.hpp>
 #include <boost/range/sub_range.hpp>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <type_traits>
 #include <unordered_set>
 #include <utility>
@@ -17,6 +23,7 @@
 
 #include "DexPosition.h"
 #include "IRCode.h"
+#include "WeakPartialOrdering.h"
 #include "WeakTopologicalOrdering.h"
 
 /**
@@ -67,6 +74,11 @@ struct BlockAccessor;
 } // namespace impl
 } // namespace source_blocks
 
+namespace dominators {
+template <class GraphInterface>
+class SimpleFastDominators;
+} // namespace dominators
+
 namespace cfg {
 
 enum EdgeType : uint8_t {
@@ -85,6 +97,7 @@ enum EdgeType : uint8_t {
 class Block;
 class ControlFlowGraph;
 class CFGInliner;
+class GraphInterface;
 
 namespace details {
 
@@ -220,8 +233,164 @@ class Edge final {
 
 std::ostream& operator<<(std::ostream& os, const Edge& e);
 
+// The result of edge queries. Most blocks have few edges, so the edges usually
+// fit in place and queries don't allocate.
+using EdgeList = boost::container::small_vector<Edge*, 4>;
+
 using BlockId = size_t;
 
+/*
+ * The blocks of a CFG, ordered by id. Block ids are handed out densely (see
+ * ControlFlowGraph::next_block_id), so blocks are kept in a vector indexed by
+ * id, with holes for removed blocks. Compared to a std::map, lookups are O(1),
+ * iteration walks contiguous memory and there is no per-block node to
+ * allocate and free.
+ *
+ * The interface mirrors the subset of std::map used by ControlFlowGraph.
+ * Unlike vector iterators, iterators stay valid when blocks are added, as they
+ * only hold an index; end() is a dedicated sentinel.
+ */
+class BlockMap {
+ public:
+  using value_type = std::pair<const BlockId, Block*>;
+
+  class const_iterator {
+   public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = BlockMap::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type*;
+    using reference = const value_type&;
+
+    const_iterator() = default;
+
+    reference operator*() const { return m_map->m_entries[m_idx]; }
+    pointer operator->() const { return &m_map->m_entries[m_idx]; }
+
+    const_iterator& operator++() {
+      m_idx = m_map->next_index(m_idx + 1);
+      return *this;
+    }
+    const_iterator operator++(int) {
+      auto result = *this;
+      ++(*this);
+      return result;
+    }
+    const_iterator& operator--() {
+      size_t idx = m_idx == END ? m_map->m_entries.size() : m_idx;
+      do {
+        --idx;
+      } while (m_map->m_entries[idx].second == nullptr);
+      m_idx = idx;
+      return *this;
+    }
+    const_iterator operator--(int) {
+      auto result = *this;
+      --(*this);
+      return result;
+    }
+
+    bool operator==(const const_iterator& other) const {
+      return m_idx == other.m_idx;
+    }
+    bool operator!=(const const_iterator& other) const {
+      return m_idx != other.m_idx;
+    }
+
+   private:
+    friend class BlockMap;
+    const_iterator(const BlockMap* map, size_t idx) : m_map(map), m_idx(idx) {}
+
+    const BlockMap* m_map{nullptr};
+    size_t m_idx{END};
+  };
+  using iterator = const_iterator;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+  using reverse_iterator = const_reverse_iterator;
+
+  const_iterator begin() const { return const_iterator(this, next_index(0)); }
+  const_iterator end() const { return const_iterator(this, END); }
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator(end());
+  }
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator(begin());
+  }
+
+  size_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+
+  // One past the largest id in use.
+  BlockId id_bound() const { return m_entries.size(); }
+
+  size_t count(BlockId id) const {
+    return id < m_entries.size() && m_entries[id].second != nullptr;
+  }
+
+  const_iterator find(BlockId id) const {
+    return count(id) ? const_iterator(this, id) : end();
+  }
+
+  Block* at(BlockId id) const {
+    if (!count(id)) {
+      throw std::out_of_range("BlockMap::at");
+    }
+    return m_entries[id].second;
+  }
+
+  std::pair<const_iterator, bool> emplace(BlockId id, Block* block) {
+    while (m_entries.size() <= id) {
+      m_entries.emplace_back(m_entries.size(), nullptr);
+    }
+    auto& entry = m_entries[id];
+    if (entry.second != nullptr) {
+      return {const_iterator(this, id), false};
+    }
+    entry.second = block;
+    ++m_size;
+    return {const_iterator(this, id), true};
+  }
+
+  const_iterator erase(const_iterator it) {
+    auto next = std::next(it);
+    erase(it->first);
+    return next;
+  }
+
+  size_t erase(BlockId id) {
+    if (!count(id)) {
+      return 0;
+    }
+    m_entries[id].second = nullptr;
+    --m_size;
+    // Keep id_bound() tight, so that ids freed at the end are reused.
+    while (!m_entries.empty() && m_entries.back().second == nullptr) {
+      m_entries.pop_back();
+    }
+    return 1;
+  }
+
+  void clear() {
+    m_entries.clear();
+    m_size = 0;
+  }
+
+  void reserve(size_t n) { m_entries.reserve(n); }
+
+ private:
+  static constexpr size_t END = std::numeric_limits<size_t>::max();
+
+  size_t next_index(size_t idx) const {
+    while (idx < m_entries.size() && m_entries[idx].second == nullptr) {
+      ++idx;
+    }
+    return idx < m_entries.size() ? idx : END;
+  }
+
+  std::vector<value_type> m_entries;
+  size_t m_size{0};
+};
+
 template <bool is_const>
 class InstructionIteratorImpl;
 using InstructionIterator = InstructionIteratorImpl</* is_const */ false>;
@@ -342,7 +511,7 @@ class Block final {
   bool cannot_throw() const;
 
   // TODO?: Should we just always store the throws in index order?
-  std::vector<Edge*> get_outgoing_throws_in_order() const;
+  EdgeList get_outgoing_throws_in_order() const;
 
   // Remove the first target in this block that corresponds to `branch`.
   // Returns a not-none CaseKey for multi targets, boost::none otherwise.
@@ -438,7 +607,7 @@ class ControlFlowGraph {
  public:
   static bool DEBUG;
 
-  ControlFlowGraph() = default;
+  ControlFlowGraph();
   ControlFlowGraph(const ControlFlowGraph&) = delete;
 
   /*
@@ -477,6 +646,25 @@ class ControlFlowGraph {
   // blocks in the sorted output.
   std::vector<Block*> blocks_reverse_post_deprecated() const;
 
+  // Orderings of the blocks which analyses need again and again. Each is
+  // computed on first use and cached until the next change to the blocks or
+  // edges of this CFG. A returned ordering stays valid when the cache is
+  // dropped, but doesn't reflect the changes that dropped it.
+
+  // The reachable blocks in reverse post order, like graph::postorder_sort.
+  std::shared_ptr<const std::vector<Block*>> reverse_postorder() const;
+
+  // What a MonotonicFixpointIterator over GraphInterface follows. Fixpoint
+  // iterators pick these up on their own.
+  std::shared_ptr<const sparta::WeakPartialOrdering<Block*>> forward_wpo()
+      const;
+  // Same, for backwards analyses. Requires the exit block.
+  std::shared_ptr<const sparta::WeakPartialOrdering<Block*>> backward_wpo()
+      const;
+
+  std::shared_ptr<const dominators::SimpleFastDominators<GraphInterface>>
+  dominator_tree() const;
+
   Block* create_block();
 
   // Create a new block (with a unique ID) that has a copy of the code inside
@@ -486,8 +674,14 @@ class ControlFlowGraph {
 
   Block* entry_block() const { return m_entry_block; }
   Block* exit_block() const { return m_exit_block; }
-  void set_entry_block(Block* b) { m_entry_block = b; }
-  void set_exit_block(Block* b) { m_exit_block = b; }
+  void set_entry_block(Block* b) {
+    m_entry_block = b;
+    invalidate_cached_orderings();
+  }
+  void set_exit_block(Block* b) {
+    m_exit_block = b;
+    invalidate_cached_orderings();
+  }
 
   /*
    * If there is a single method exit point, this returns a vector holding the
@@ -521,6 +715,7 @@ class ControlFlowGraph {
     m_edges.insert(e);
     e->src()->m_succs.emplace_back(e);
     e->target()->m_preds.emplace_back(e);
+    invalidate_cached_orderings();
   }
 
   // copies all edges from one block to another
@@ -567,10 +762,10 @@ class ControlFlowGraph {
 
   // return all edges for which predicate returns true
   template <typename EdgePredicate>
-  std::vector<Edge*> get_pred_edges_if(const Block* block,
-                                       EdgePredicate predicate) const {
+  EdgeList get_pred_edges_if(const Block* block,
+                             EdgePredicate predicate) const {
     const auto& preds = block->preds();
-    std::vector<Edge*> result;
+    EdgeList result;
     for (Edge* e : preds) {
       if (predicate(e)) {
         result.push_back(e);
@@ -580,10 +775,10 @@ class ControlFlowGraph {
   }
 
   template <typename EdgePredicate>
-  std::vector<Edge*> get_succ_edges_if(const Block* block,
-                                       EdgePredicate predicate) const {
+  EdgeList get_succ_edges_if(const Block* block,
+                             EdgePredicate predicate) const {
     const auto& succs = block->succs();
-    std::vector<Edge*> result;
+    EdgeList result;
     for (Edge* e : succs) {
       if (predicate(e)) {
         result.push_back(e);
@@ -598,10 +793,8 @@ class ControlFlowGraph {
   Edge* get_succ_edge_of_type(const Block* block, EdgeType type) const;
 
   // return all edges of the given type
-  std::vector<Edge*> get_pred_edges_of_type(const Block* block,
-                                            EdgeType type) const;
-  std::vector<Edge*> get_succ_edges_of_type(const Block* block,
-                                            EdgeType type) const;
+  EdgeList get_pred_edges_of_type(const Block* block, EdgeType type) const;
+  EdgeList get_succ_edges_of_type(const Block* block, EdgeType type) const;
 
   // delete_..._edge:
   //   * These functions remove edges from the graph and free the memory
@@ -889,7 +1082,7 @@ class ControlFlowGraph {
       std::unordered_map<MethodItemEntry*, std::vector<Block*>>;
   using TryEnds = std::vector<std::pair<TryEntry*, Block*>>;
   using TryCatches = std::unordered_map<CatchEntry*, Block*>;
-  using Blocks = std::map<BlockId, Block*>;
+  using Blocks = BlockMap;
   friend class InstructionIteratorImpl<false>;
   friend class InstructionIteratorImpl<true>;
   friend class CFGInliner;
@@ -1021,6 +1214,7 @@ class ControlFlowGraph {
                                        }),
                         reverse_edges.end());
 
+    invalidate_cached_orderings();
     if (cleanup) {
       cleanup_deleted_edges(to_remove);
     }
@@ -1057,6 +1251,7 @@ class ControlFlowGraph {
           forward_edges.end());
     }
 
+    invalidate_cached_orderings();
     if (cleanup) {
       cleanup_deleted_edges(to_remove);
     }
@@ -1093,6 +1288,7 @@ class ControlFlowGraph {
           reverse_edges.end());
     }
 
+    invalidate_cached_orderings();
     if (cleanup) {
       cleanup_deleted_edges(to_remove);
     }
@@ -1128,6 +1324,13 @@ class ControlFlowGraph {
 
   std::vector<Block*> blocks_post_helper(bool reverse) const;
 
+  // Drops the cached orderings. Called by everything that changes the blocks
+  // or edges.
+  void invalidate_cached_orderings();
+
+  struct CachedOrderings;
+  CachedOrderings& cached_orderings() const;
+
   // The memory of all blocks and edges in this graph are owned here
   Blocks m_blocks;
   EdgeSet m_edges;
@@ -1137,6 +1340,9 @@ class ControlFlowGraph {
   Block* m_exit_block{nullptr};
   reg_t m_registers_size{0};
   bool m_editable{true};
+
+  mutable std::mutex m_cached_orderings_lock;
+  mutable std::unique_ptr<CachedOrderings> m_cached_orderings;
 };
 
 // A static-method-only API for use with the monotonic fixpoint iterator.
@@ -1152,14 +1358,24 @@ class GraphInterface {
   static NodeId exit(const Graph& graph) {
     return const_cast<NodeId>(graph.exit_block());
   }
-  static std::vector<EdgeId> predecessors(const Graph&, const NodeId& b) {
+  static const std::vector<EdgeId>& predecessors(const Graph&,
+                                                 const NodeId& b) {
     return b->preds();
   }
-  static std::vector<EdgeId> successors(const Graph&, const NodeId& b) {
+  static const std::vector<EdgeId>& successors(const Graph&,
+                                               const NodeId& b) {
     return b->succs();
   }
   static NodeId source(const Graph&, const EdgeId& e) { return e->src(); }
   static NodeId target(const Graph&, const EdgeId& e) { return e->target(); }
+  static std::shared_ptr<const sparta::WeakPartialOrdering<NodeId>> cached_wpo(
+      const Graph& graph) {
+    return graph.forward_wpo();
+  }
+  static std::shared_ptr<const sparta::WeakPartialOrdering<NodeId>>
+  cached_backward_wpo(const Graph& graph) {
+    return graph.backward_wpo();
+  }
 };
 
 template <bool is_const>
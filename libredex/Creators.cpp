@@ -18,14 +18,14 @@ namespace {
 
 // TODO: make naming of methods smart
 DexString* get_name(DexMethod* meth) {
-  std::string name = "__st__" + meth->get_name()->str();
+  std::string name = "__st__" + meth->get_name()->str_copy();
   return DexString::make_string(name);
 }
 
 DexProto* make_static_sig(DexMethod* meth) {
   auto proto = meth->get_proto();
   auto rtype = proto->get_rtype();
-  std::deque<DexType*> arg_list;
+  DexTypeList::ContainerType arg_list;
   arg_list.push_back(meth->get_class());
   auto args = proto->get_args()->get_type_list();
   arg_list.insert(arg_list.end(), args.begin(), args.end());
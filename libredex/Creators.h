@@ -511,7 +511,7 @@ struct ClassCreator {
     m_cls->m_anno = nullptr;
     m_cls->m_external = false;
     m_cls->m_perf_sensitive = false;
-    m_cls->set_deobfuscated_name(type->get_name()->c_str());
+    m_cls->set_deobfuscated_name(type->get_name());
   }
 
   /**
@@ -543,7 +543,7 @@ struct ClassCreator {
    * Set the external bit for the DexClass.
    */
   void set_external() {
-    m_cls->m_deobfuscated_name = show_cls(m_cls);
+    m_cls->m_deobfuscated_name = DexString::make_string(show_cls(m_cls));
     m_cls->m_external = true;
   }
 
@@ -589,5 +589,5 @@ struct ClassCreator {
   static std::string show_type(const DexType* type);
 
   DexClass* m_cls;
-  std::deque<DexType*> m_interfaces;
+  DexTypeList::ContainerType m_interfaces;
 };
@@ -10,6 +10,7 @@
 #include <boost/functional/hash.hpp>
 #include <deque>
 #include <map>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -468,7 +469,7 @@ class DexAnnotationSet : public Gatherable {
   void add_annotation(DexAnnotation* anno) { m_annotations.emplace_back(anno); }
   void vencode(DexOutputIdx* dodx,
                std::vector<uint32_t>& asetout,
-               std::map<DexAnnotation*, uint32_t>& annoout);
+               std::unordered_map<DexAnnotation*, uint32_t>& annoout);
   void gather_annotations(std::vector<DexAnnotation*>& alist);
 };
 
@@ -538,8 +539,8 @@ class DexAnnotationDirectory {
   void gather_xrefs(std::vector<ParamAnnotations*>& xrefs);
   void vencode(DexOutputIdx* dodx,
                std::vector<uint32_t>& annodirout,
-               std::map<ParamAnnotations*, uint32_t>& xrefmap,
-               std::map<DexAnnotationSet*, uint32_t>& asetmap);
+               std::unordered_map<ParamAnnotations*, uint32_t>& xrefmap,
+               std::unordered_map<DexAnnotationSet*, uint32_t>& asetmap);
 
   friend std::string show(const DexAnnotationDirectory*);
 };
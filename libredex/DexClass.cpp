@@ -7,6 +7,7 @@
 
 #include "DexClass.h"
 
+#include "CodeSpill.h"
 #include "Debug.h"
 #include "DexAccess.h"
 #include "DexDebugInstruction.h"
@@ -25,8 +26,10 @@
 #include "Util.h"
 #include "Walkers.h"
 #include "Warning.h"
+#include "WorkQueue.h"
 
 #include <algorithm>
+#include <array>
 #include <boost/functional/hash.hpp>
 #include <boost/optional.hpp>
 #include <memory>
@@ -113,9 +116,9 @@ std::string get_simple_deobf_name(const T* ref) {
   auto dot_pos = full_name.find('.');
   auto colon_pos = full_name.find(':');
   if (dot_pos == std::string::npos || colon_pos == std::string::npos) {
-    return full_name;
+    return std::string(full_name);
   }
-  return full_name.substr(dot_pos + 1, colon_pos - dot_pos - 1);
+  return std::string(full_name.substr(dot_pos + 1, colon_pos - dot_pos - 1));
 }
 } // namespace
 
@@ -123,7 +126,7 @@ uint32_t DexString::length() const {
   if (is_simple()) {
     return size();
   }
-  return length_of_utf8_string(c_str());
+  return length_of_utf8_string(c_str(), size());
 }
 
 int32_t DexString::java_hashcode() const {
@@ -445,12 +448,72 @@ void DexDebugItem::gather_strings(std::vector<DexString*>& lstring) const {
   }
 }
 
+namespace {
+// Compact instructions are decoded on first access, which may happen on
+// several threads at once.
+std::array<std::mutex, 64> s_decode_locks;
+
+std::mutex& decode_lock(const DexCode* code) {
+  return s_decode_locks[std::hash<const DexCode*>()(code) %
+                        s_decode_locks.size()];
+}
+} // namespace
+
+void DexCode::decode_compact_insns() const {
+  std::lock_guard<std::mutex> guard(decode_lock(this));
+  if (!m_is_compact.load(std::memory_order_relaxed)) {
+    return;
+  }
+  auto insns = std::make_unique<std::vector<DexInstruction*>>();
+  insns->reserve(m_compact_insns->num_insns);
+  void* const* refs = m_compact_insns->refs.data();
+  const uint16_t* cdata = m_compact_insns->units.data();
+  const uint16_t* end = cdata + m_compact_insns->units.size();
+  while (cdata < end) {
+    insns->push_back(DexInstruction::make_instruction(&refs, &cdata));
+  }
+  m_insns = std::move(insns);
+  m_compact_insns.reset();
+  m_is_compact.store(false, std::memory_order_release);
+}
+
+template <typename Fn>
+void DexCode::for_each_instruction(const Fn& fn) const {
+  if (m_is_compact.load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> guard(decode_lock(this));
+    if (m_is_compact.load(std::memory_order_relaxed)) {
+      void* const* refs = m_compact_insns->refs.data();
+      const uint16_t* cdata = m_compact_insns->units.data();
+      const uint16_t* end = cdata + m_compact_insns->units.size();
+      while (cdata < end) {
+        std::unique_ptr<DexInstruction> insn(
+            DexInstruction::make_instruction(&refs, &cdata));
+        fn(insn.get());
+      }
+      return;
+    }
+  }
+  for (const auto* insn : *m_insns) {
+    fn(insn);
+  }
+}
+
+uint32_t DexCode::num_instructions() const {
+  if (m_is_compact.load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> guard(decode_lock(this));
+    if (m_is_compact.load(std::memory_order_relaxed)) {
+      return m_compact_insns->num_insns;
+    }
+  }
+  return m_insns->size();
+}
+
 DexCode::DexCode(const DexCode& that)
     : m_registers_size(that.m_registers_size),
       m_ins_size(that.m_ins_size),
       m_outs_size(that.m_outs_size),
       m_insns(std::make_unique<std::vector<DexInstruction*>>()) {
-  for (auto& insn : *that.m_insns) {
+  for (auto& insn : that.get_instructions()) {
     m_insns->emplace_back(insn->clone());
   }
   for (auto& try_ : that.m_tries) {
@@ -461,6 +524,47 @@ DexCode::DexCode(const DexCode& that)
   }
 }
 
+void DexCode::gather_strings(std::vector<DexString*>& lstring) const {
+  for_each_instruction(
+      [&](const DexInstruction* insn) { insn->gather_strings(lstring); });
+  if (m_dbg) m_dbg->gather_strings(lstring);
+}
+
+void DexCode::gather_types(std::vector<DexType*>& ltype) const {
+  for_each_instruction(
+      [&](const DexInstruction* insn) { insn->gather_types(ltype); });
+  for (auto& try_ : m_tries) {
+    for (auto& catch_ : try_->m_catches) {
+      if (catch_.first != nullptr) {
+        ltype.push_back(catch_.first);
+      }
+    }
+  }
+  if (m_dbg) m_dbg->gather_types(ltype);
+}
+
+void DexCode::gather_fields(std::vector<DexFieldRef*>& lfield) const {
+  for_each_instruction(
+      [&](const DexInstruction* insn) { insn->gather_fields(lfield); });
+}
+
+void DexCode::gather_methods(std::vector<DexMethodRef*>& lmethod) const {
+  for_each_instruction(
+      [&](const DexInstruction* insn) { insn->gather_methods(lmethod); });
+}
+
+void DexCode::gather_callsites(std::vector<DexCallSite*>& lcallsite) const {
+  for_each_instruction(
+      [&](const DexInstruction* insn) { insn->gather_callsites(lcallsite); });
+}
+
+void DexCode::gather_methodhandles(
+    std::vector<DexMethodHandle*>& lmethodhandle) const {
+  for_each_instruction([&](const DexInstruction* insn) {
+    insn->gather_methodhandles(lmethodhandle);
+  });
+}
+
 DexCode::~DexCode() {
   if (m_insns) {
     for (auto const& op : *m_insns) {
@@ -469,25 +573,46 @@ DexCode::~DexCode() {
   }
 }
 
-std::unique_ptr<DexCode> DexCode::get_dex_code(DexIdx* idx, uint32_t offset) {
+std::unique_ptr<DexCode> DexCode::get_dex_code(DexIdx* idx,
+                                               uint32_t offset,
+                                               bool compact) {
   if (offset == 0) return std::unique_ptr<DexCode>();
   const dex_code_item* code = (const dex_code_item*)idx->get_uint_data(offset);
   std::unique_ptr<DexCode> dc(new DexCode());
   dc->m_registers_size = code->registers_size;
   dc->m_ins_size = code->ins_size;
   dc->m_outs_size = code->outs_size;
-  dc->m_insns.reset(new std::vector<DexInstruction*>());
   const uint16_t* cdata = (const uint16_t*)(code + 1);
   uint32_t tries = code->tries_size;
+  if (compact) {
+    dc->m_insns.reset();
+    dc->m_compact_insns = std::make_unique<CompactInsns>();
+    dc->m_is_compact.store(true, std::memory_order_relaxed);
+  }
   if (code->insns_size) {
-    // On average there seem to be about two code units per instruction
-    dc->m_insns->reserve(code->insns_size / 2);
     const uint16_t* end = cdata + code->insns_size;
-    while (cdata < end) {
-      DexInstruction* dop = DexInstruction::make_instruction(idx, &cdata);
-      always_assert_log(dop != nullptr,
-                        "Failed to parse method at offset 0x%08x", offset);
-      dc->m_insns->push_back(dop);
+    if (compact) {
+      // Decode the instructions once to resolve their references, and only
+      // keep the code units and the references.
+      auto* compact_insns = dc->m_compact_insns.get();
+      compact_insns->units.assign(cdata, end);
+      while (cdata < end) {
+        std::unique_ptr<DexInstruction> dop(DexInstruction::make_instruction(
+            idx, &cdata, &compact_insns->refs));
+        always_assert_log(dop != nullptr,
+                          "Failed to parse method at offset 0x%08x", offset);
+        compact_insns->num_insns++;
+      }
+      compact_insns->refs.shrink_to_fit();
+    } else {
+      // On average there seem to be about two code units per instruction
+      dc->m_insns->reserve(code->insns_size / 2);
+      while (cdata < end) {
+        DexInstruction* dop = DexInstruction::make_instruction(idx, &cdata);
+        always_assert_log(dop != nullptr,
+                          "Failed to parse method at offset 0x%08x", offset);
+        dc->m_insns->push_back(dop);
+      }
     }
     /*
      * Padding, see dex-spec.
@@ -603,22 +728,79 @@ DexMethod::~DexMethod() = default;
 
 std::string DexMethod::get_fully_deobfuscated_name() const {
   if (get_deobfuscated_name() == show(this)) {
-    return get_deobfuscated_name();
+    return get_deobfuscated_name_copy();
   }
   return build_fully_deobfuscated_name(this);
 }
 
 void DexMethod::set_code(std::unique_ptr<IRCode> code) {
+  restore_code();
   m_code = std::move(code);
 }
 
+void DexMethod::restore_spilled_code() const {
+  code_spill::CodeSpill::restore(this);
+}
+
 void DexMethod::balloon() {
   redex_assert(m_code == nullptr);
+  redex_assert(!is_balloon_pending());
   m_code = std::make_unique<IRCode>(this);
   m_dex_code.reset();
 }
 
+void DexMethod::balloon_lazily() {
+  redex_assert(m_code == nullptr);
+  redex_assert(m_dex_code != nullptr);
+  m_balloon_pending.store(true, std::memory_order_release);
+}
+
+namespace {
+// Methods are ballooned lazily on their first get_code(), which may happen on
+// several threads at once.
+std::array<std::mutex, 64> s_balloon_locks;
+
+std::mutex& balloon_lock(const DexMethod* method) {
+  return s_balloon_locks[std::hash<const DexMethod*>()(method) %
+                         s_balloon_locks.size()];
+}
+
+// Runs `fn` on the DexCode of a method which is still to be ballooned, and
+// returns whether it did. A concurrent get_code() cannot free the DexCode
+// while `fn` looks at it.
+template <typename Fn>
+bool with_pending_dex_code(const DexMethod* method, const Fn& fn) {
+  if (!method->is_balloon_pending()) {
+    return false;
+  }
+  std::lock_guard<std::mutex> guard(balloon_lock(method));
+  if (!method->is_balloon_pending()) {
+    return false;
+  }
+  fn(*method->get_dex_code());
+  return true;
+}
+} // namespace
+
+void DexMethod::balloon_pending_code() const {
+  std::lock_guard<std::mutex> guard(balloon_lock(this));
+  if (!is_balloon_pending()) {
+    return;
+  }
+  auto* self = const_cast<DexMethod*>(this);
+  self->m_code = std::make_unique<IRCode>(self);
+  self->m_dex_code.reset();
+  m_balloon_pending.store(false, std::memory_order_release);
+}
+
 void DexMethod::sync() {
+  if (is_balloon_pending()) {
+    // Nothing asked for the IR since loading, so the loaded DexCode is still
+    // what the IR would sync to. Emit it as is.
+    m_balloon_pending.store(false, std::memory_order_release);
+    return;
+  }
+  restore_code();
   redex_assert(m_dex_code == nullptr);
   m_dex_code = m_code->sync(this);
   m_code.reset();
@@ -672,7 +854,7 @@ DexMethodRef* DexMethod::get_method(
     const dex_member_refs::MethodDescriptorTokens& mdt) {
   auto cls = DexType::get_type(mdt.cls.c_str());
   auto name = DexString::get_string(mdt.name);
-  std::deque<DexType*> args;
+  DexTypeList::ContainerType args;
   for (auto& arg_str : mdt.args) {
     args.push_back(DexType::get_type(arg_str.c_str()));
   }
@@ -693,7 +875,7 @@ DexMethodRef* DexMethod::make_method(const std::string& full_descriptor) {
   auto mdt = dex_member_refs::parse_method(full_descriptor);
   auto cls = DexType::make_type(mdt.cls.c_str());
   auto name = DexString::make_string(mdt.name);
-  std::deque<DexType*> args;
+  DexTypeList::ContainerType args;
   for (auto& arg_str : mdt.args) {
     args.push_back(DexType::make_type(arg_str.c_str()));
   }
@@ -707,7 +889,7 @@ DexMethodRef* DexMethod::make_method(
     const std::string& name,
     std::initializer_list<std::string> arg_types,
     const std::string& return_type) {
-  std::deque<DexType*> dex_types;
+  DexTypeList::ContainerType dex_types;
   for (const std::string& type_str : arg_types) {
     dex_types.push_back(DexType::make_type(type_str.c_str()));
   }
@@ -718,31 +900,28 @@ DexMethodRef* DexMethod::make_method(
                            DexTypeList::make_type_list(std::move(dex_types))));
 }
 
-void DexClass::set_deobfuscated_name(const std::string& name) {
+void DexClass::set_deobfuscated_name(const DexString* name) {
   // If the class has an old deobfuscated_name which is not equal to
   // `show(self)`, erase the name mapping from the global type map.
-  if (!m_deobfuscated_name.empty()) {
-    auto old_name = DexString::make_string(m_deobfuscated_name);
-    if (old_name != m_self->get_name()) {
-      g_redex->remove_type_name(old_name);
-    }
+  if (m_deobfuscated_name != nullptr &&
+      m_deobfuscated_name != m_self->get_name()) {
+    g_redex->remove_type_name(m_deobfuscated_name);
   }
   m_deobfuscated_name = name;
-  auto new_name = DexString::make_string(m_deobfuscated_name);
-  if (new_name == m_self->get_name()) {
+  if (name == m_self->get_name()) {
     return;
   }
-  auto existing_type = g_redex->get_type(new_name);
+  auto existing_type = g_redex->get_type(name);
   if (existing_type != nullptr) {
     fprintf(stderr,
             "Unable to alias type '%s' to deobfuscated name '%s' because type "
             "'%s' already exists.\n",
             m_self->c_str(),
-            new_name->c_str(),
+            name->c_str(),
             existing_type->c_str());
     return;
   }
-  g_redex->alias_type_name(m_self, new_name);
+  g_redex->alias_type_name(m_self, name);
 }
 
 void DexClass::remove_method(const DexMethod* m) {
@@ -801,6 +980,7 @@ DexMethod* DexMethodRef::make_concrete(DexAccessFlags access, bool is_virtual) {
 void DexMethod::make_non_concrete() {
   m_access = static_cast<DexAccessFlags>(0);
   m_concrete = false;
+  restore_code();
   m_code.reset();
   m_virtual = false;
   m_param_anno.clear();
@@ -853,7 +1033,8 @@ void DexClass::load_class_data_item(DexIdx* idx,
     uint32_t code_off = read_uleb128(&encd);
     // Find method in method index, returns same pointer for same method.
     DexMethod* dm = static_cast<DexMethod*>(idx->get_methodidx(ndex));
-    std::unique_ptr<DexCode> dc = DexCode::get_dex_code(idx, code_off);
+    std::unique_ptr<DexCode> dc = DexCode::get_dex_code(
+        idx, code_off, /* compact */ RedexContext::lazy_balloon());
     if (dc && dc->get_debug_item()) {
       dc->get_debug_item()->bind_positions(dm, m_source_file);
     }
@@ -882,7 +1063,10 @@ void DexClass::load_class_data_item(DexIdx* idx,
   }
 }
 
-std::unique_ptr<IRCode> DexMethod::release_code() { return std::move(m_code); }
+std::unique_ptr<IRCode> DexMethod::release_code() {
+  restore_code();
+  return std::move(m_code);
+}
 
 std::vector<DexMethod*> DexClass::get_all_methods() const {
   std::vector<DexMethod*> all_methods(m_vmethods.begin(), m_vmethods.end());
@@ -1510,7 +1694,12 @@ template <typename C>
 void DexMethod::gather_types(C& ltype) const {
   gather_types_shallow(ltype); // Handle DexMethodRef parts.
   std::vector<DexType*> type_vec; // Simplify refactor.
-  if (m_code) m_code->gather_types(type_vec);
+  if (!with_pending_dex_code(this, [&](const DexCode& dc) {
+        dc.gather_types(type_vec);
+      }) &&
+      get_code()) {
+    m_code->gather_types(type_vec);
+  }
   if (m_anno) m_anno->gather_types(type_vec);
   auto param_anno = get_param_anno();
   if (param_anno) {
@@ -1526,11 +1715,14 @@ INSTANTIATE(DexMethod::gather_types, DexType*)
 template <typename C>
 void DexMethod::gather_callsites(C& lcallsite) const {
   // We handle m_spec.cls and proto in the first-layer gather.
-  if (m_code) {
-    std::vector<DexCallSite*> callsite_vec; // Simplify refactor.
+  std::vector<DexCallSite*> callsite_vec; // Simplify refactor.
+  if (!with_pending_dex_code(this, [&](const DexCode& dc) {
+        dc.gather_callsites(callsite_vec);
+      }) &&
+      get_code()) {
     m_code->gather_callsites(callsite_vec);
-    c_append_all(lcallsite, callsite_vec.begin(), callsite_vec.end());
   }
+  c_append_all(lcallsite, callsite_vec.begin(), callsite_vec.end());
 }
 INSTANTIATE(DexMethod::gather_callsites, DexCallSite*)
 
@@ -1538,7 +1730,12 @@ template <typename C>
 void DexMethod::gather_methodhandles(C& lmethodhandle) const {
   // We handle m_spec.cls and proto in the first-layer gather.
   std::vector<DexMethodHandle*> mhandles_vec; // Simplify refactor.
-  if (m_code) m_code->gather_methodhandles(mhandles_vec);
+  if (!with_pending_dex_code(this, [&](const DexCode& dc) {
+        dc.gather_methodhandles(mhandles_vec);
+      }) &&
+      get_code()) {
+    m_code->gather_methodhandles(mhandles_vec);
+  }
   c_append_all(lmethodhandle, mhandles_vec.begin(), mhandles_vec.end());
 }
 INSTANTIATE(DexMethod::gather_methodhandles, DexMethodHandle*)
@@ -1546,7 +1743,12 @@ template <typename C>
 void DexMethod::gather_strings(C& lstring, bool exclude_loads) const {
   // We handle m_name and proto in the first-layer gather.
   std::vector<DexString*> strings_vec; // Simplify refactor.
-  if (m_code && !exclude_loads) m_code->gather_strings(strings_vec);
+  if (!exclude_loads && !with_pending_dex_code(this, [&](const DexCode& dc) {
+        dc.gather_strings(strings_vec);
+      }) &&
+      get_code()) {
+    m_code->gather_strings(strings_vec);
+  }
   if (m_anno) m_anno->gather_strings(strings_vec);
   auto param_anno = get_param_anno();
   if (param_anno) {
@@ -1561,7 +1763,12 @@ INSTANTIATE2(DexMethod::gather_strings, DexString*, bool)
 template <typename C>
 void DexMethod::gather_fields(C& lfield) const {
   std::vector<DexFieldRef*> fields_vec; // Simplify refactor.
-  if (m_code) m_code->gather_fields(fields_vec);
+  if (!with_pending_dex_code(this, [&](const DexCode& dc) {
+        dc.gather_fields(fields_vec);
+      }) &&
+      get_code()) {
+    m_code->gather_fields(fields_vec);
+  }
   if (m_anno) m_anno->gather_fields(fields_vec);
   auto param_anno = get_param_anno();
   if (param_anno) {
@@ -1576,11 +1783,14 @@ INSTANTIATE(DexMethod::gather_fields, DexFieldRef*)
 
 template <typename C>
 void DexMethod::gather_methods(C& lmethod) const {
-  if (m_code) {
-    std::vector<DexMethodRef*> method_vec; // Simplify refactor.
+  std::vector<DexMethodRef*> method_vec; // Simplify refactor.
+  if (!with_pending_dex_code(this, [&](const DexCode& dc) {
+        dc.gather_methods(method_vec);
+      }) &&
+      get_code()) {
     m_code->gather_methods(method_vec);
-    c_append_all(lmethod, method_vec.begin(), method_vec.end());
   }
+  c_append_all(lmethod, method_vec.begin(), method_vec.end());
   gather_methods_from_annos(lmethod);
 }
 INSTANTIATE(DexMethod::gather_methods, DexMethodRef*)
@@ -1632,11 +1842,11 @@ INSTANTIATE(DexMethodRef::gather_strings_shallow, DexString*)
 
 uint32_t DexCode::size() const {
   uint32_t size = 0;
-  for (auto const& opc : get_instructions()) {
+  for_each_instruction([&size](const DexInstruction* opc) {
     if (!dex_opcode::is_fopcode(opc->opcode())) {
       size += opc->size();
     }
-  }
+  });
   return size;
 }
 
@@ -1647,7 +1857,7 @@ DexProto* DexType::get_non_overlapping_proto(DexString* method_name,
   if (!methodref_in_context) {
     return orig_proto;
   }
-  std::deque<DexType*> new_arg_list;
+  DexTypeList::ContainerType new_arg_list;
   const auto& type_list = orig_proto->get_args()->get_type_list();
   auto rtype = orig_proto->get_rtype();
   for (auto t : type_list) {
@@ -1655,12 +1865,13 @@ DexProto* DexType::get_non_overlapping_proto(DexString* method_name,
   }
   new_arg_list.push_back(type::_int());
   DexTypeList* new_args =
-      DexTypeList::make_type_list(std::deque<DexType*>{new_arg_list});
+      DexTypeList::make_type_list(DexTypeList::ContainerType{new_arg_list});
   DexProto* new_proto = DexProto::make_proto(rtype, new_args);
   methodref_in_context = DexMethod::get_method(this, method_name, new_proto);
   while (methodref_in_context) {
     new_arg_list.push_back(type::_int());
-    new_args = DexTypeList::make_type_list(std::deque<DexType*>{new_arg_list});
+    new_args =
+        DexTypeList::make_type_list(DexTypeList::ContainerType{new_arg_list});
     new_proto = DexProto::make_proto(rtype, new_args);
     methodref_in_context = DexMethod::get_method(this, method_name, new_proto);
   }
@@ -1681,6 +1892,30 @@ void DexMethod::add_load_params(size_t num_add_loads) {
   }
 }
 
+namespace {
+
+// Number of classes gathered by each parallel task.
+constexpr size_t kGatherChunkSize = 64;
+
+// References gathered from a chunk of classes, with duplicates. Appending to
+// vectors is much cheaper than hashing every reference into a set, and a
+// single sort_unique at the end deduplicates them all at once.
+struct GatheredRefs {
+  std::vector<DexString*> strings;
+  std::vector<DexType*> types;
+  std::vector<DexFieldRef*> fields;
+  std::vector<DexMethodRef*> methods;
+  std::vector<DexCallSite*> callsites;
+  std::vector<DexMethodHandle*> methodhandles;
+};
+
+template <typename T>
+void append_all(std::vector<T>& to, const std::vector<T>& from) {
+  to.insert(to.end(), from.begin(), from.end());
+}
+
+} // namespace
+
 void gather_components(std::vector<DexString*>& lstring,
                        std::vector<DexType*>& ltype,
                        std::vector<DexFieldRef*>& lfield,
@@ -1689,57 +1924,60 @@ void gather_components(std::vector<DexString*>& lstring,
                        std::vector<DexMethodHandle*>& lmethodhandle,
                        const DexClasses& classes,
                        bool exclude_loads) {
-  // Gather references reachable from each class.
-  std::unordered_set<DexString*> strings;
-  std::unordered_set<DexType*> types;
-  std::unordered_set<DexFieldRef*> fields;
-  std::unordered_set<DexMethodRef*> methods;
-  std::unordered_set<DexCallSite*> callsites;
-  std::unordered_set<DexMethodHandle*> methodhandles;
-  // Inside a lambda to ensure only visibility of the sets.
-  [&classes, &exclude_loads, &strings, &types, &fields, &methods, &callsites,
-   &methodhandles]() {
-    for (auto const& cls : classes) {
-      cls->gather_strings(strings, exclude_loads);
-      cls->gather_types(types);
-      cls->gather_fields(fields);
-      cls->gather_methods(methods);
-      cls->gather_callsites(callsites);
-      cls->gather_methodhandles(methodhandles);
-    }
-
-    // Gather types and strings needed for field and method refs.
-    for (auto meth : methods) {
-      meth->gather_types_shallow(types);
-      meth->gather_strings_shallow(strings);
-    }
-
-    for (auto field : fields) {
-      field->gather_types_shallow(types);
-      field->gather_strings_shallow(strings);
-    }
-
-    // Gather strings needed for each type.
-    for (auto type : types) {
-      if (type) strings.insert(type->get_name());
-    }
-  }();
-
-  lstring.insert(lstring.end(), strings.begin(), strings.end());
-  ltype.insert(ltype.end(), types.begin(), types.end());
-  lfield.insert(lfield.end(), fields.begin(), fields.end());
-  lmethod.insert(lmethod.end(), methods.begin(), methods.end());
-  lcallsite.insert(lcallsite.end(), callsites.begin(), callsites.end());
-  lmethodhandle.insert(lmethodhandle.end(), methodhandles.begin(),
-                       methodhandles.end());
-
-  // This retains pre-set computation behavior.
-  sort_unique(lstring);
-  sort_unique(ltype);
+  // Gather references reachable from each class, in parallel chunks of
+  // classes.
+  std::vector<size_t> chunks;
+  for (size_t begin = 0; begin < classes.size(); begin += kGatherChunkSize) {
+    chunks.push_back(begin);
+  }
+  std::vector<GatheredRefs> gathered(chunks.size());
+  workqueue_run<size_t>(
+      [&](size_t begin) {
+        auto& refs = gathered[begin / kGatherChunkSize];
+        auto end = std::min(classes.size(), begin + kGatherChunkSize);
+        for (size_t i = begin; i < end; ++i) {
+          auto const& cls = classes[i];
+          cls->gather_strings(refs.strings, exclude_loads);
+          cls->gather_types(refs.types);
+          cls->gather_fields(refs.fields);
+          cls->gather_methods(refs.methods);
+          cls->gather_callsites(refs.callsites);
+          cls->gather_methodhandles(refs.methodhandles);
+        }
+      },
+      chunks);
+
+  for (const auto& refs : gathered) {
+    append_all(lstring, refs.strings);
+    append_all(ltype, refs.types);
+    append_all(lfield, refs.fields);
+    append_all(lmethod, refs.methods);
+    append_all(lcallsite, refs.callsites);
+    append_all(lmethodhandle, refs.methodhandles);
+  }
+  gathered.clear();
   sort_unique(lfield);
   sort_unique(lmethod);
   sort_unique(lcallsite);
   sort_unique(lmethodhandle);
+
+  // Gather types and strings needed for field and method refs.
+  for (auto meth : lmethod) {
+    meth->gather_types_shallow(ltype);
+    meth->gather_strings_shallow(lstring);
+  }
+
+  for (auto field : lfield) {
+    field->gather_types_shallow(ltype);
+    field->gather_strings_shallow(lstring);
+  }
+  sort_unique(ltype);
+
+  // Gather strings needed for each type.
+  for (auto type : ltype) {
+    if (type) lstring.push_back(type->get_name());
+  }
+  sort_unique(lstring);
 }
 
 std::string DexField::self_show() const { return show(this); }
@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <cstdlib>
 #include <cstring>
 #include <functional>
@@ -14,6 +16,7 @@
 #include <limits>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <utility>
 
 #include "DexAccess.h"
@@ -63,6 +66,10 @@ class DexString;
 class DexType;
 class PositionMapper;
 
+namespace code_spill {
+class CodeSpill;
+} // namespace code_spill
+
 using Scope = std::vector<DexClass*>;
 
 #if defined(__SSE4_2__) && defined(__linux__) && defined(__STRCMP_LESS__)
@@ -72,15 +79,23 @@ extern "C" bool strcmp_less(const char* str1, const char* str2);
 class DexString {
   friend struct RedexContext;
 
-  std::string m_storage;
+  // A DexString is only ever placement-constructed by the RedexContext into
+  // its string arena, immediately followed by the NUL-terminated string data.
+  uint32_t m_storage_size;
   uint32_t m_utfsize;
+  // Rank of this string in the DexSpec string order, as assigned by the last
+  // RedexContext::assign_string_ordinals(). Zero if not assigned.
+  uint32_t m_ordinal{0};
 
   // See UNIQUENESS above for the rationale for the private constructor pattern.
-  DexString(std::string nstr, uint32_t utfsize)
-      : m_storage(std::move(nstr)), m_utfsize(utfsize) {}
+  DexString(uint32_t storage_size, uint32_t utfsize)
+      : m_storage_size(storage_size), m_utfsize(utfsize) {}
+
+  DexString(const DexString&) = delete;
+  DexString& operator=(const DexString&) = delete;
 
  public:
-  uint32_t size() const { return static_cast<uint32_t>(m_storage.size()); }
+  uint32_t size() const { return m_storage_size; }
 
   // UTF-aware length
   uint32_t length() const;
@@ -103,6 +118,10 @@ class DexString {
     return make_string(nstr.c_str());
   }
 
+  static DexString* make_string(std::string_view nstr) {
+    return make_string(std::string(nstr));
+  }
+
   // Return an existing DexString or nullptr if one does not exist.
   static DexString* get_string(const char* nstr, uint32_t utfsize) {
     return g_redex->get_string(nstr, utfsize);
@@ -116,11 +135,18 @@ class DexString {
     return get_string(str.c_str(), (uint32_t)strlen(str.c_str()));
   }
 
+  static DexString* get_string(std::string_view str) {
+    return get_string(std::string(str));
+  }
+
  public:
   bool is_simple() const { return size() == m_utfsize; }
 
-  const char* c_str() const { return m_storage.c_str(); }
-  const std::string& str() const { return m_storage; }
+  uint32_t ordinal() const { return m_ordinal; }
+
+  const char* c_str() const { return reinterpret_cast<const char*>(this + 1); }
+  std::string_view str() const { return std::string_view(c_str(), size()); }
+  std::string str_copy() const { return std::string(c_str(), size()); }
 
   uint32_t get_entry_size() const {
     uint32_t len = uleb128_encoding_size(m_utfsize);
@@ -135,13 +161,11 @@ class DexString {
   }
 };
 
-/* Non-optimizing DexSpec compliant ordering */
-inline bool compare_dexstrings(const DexString* a, const DexString* b) {
-  if (a == nullptr) {
-    return b != nullptr;
-  } else if (b == nullptr) {
-    return false;
-  }
+/*
+ * DexSpec compliant ordering of the string contents, decoding MUTF-8 where
+ * needed. Both strings must be non-null.
+ */
+inline bool compare_dexstring_contents(const DexString* a, const DexString* b) {
   if (a->is_simple() && b->is_simple())
 #if defined(__SSE4_2__) && defined(__linux__) && defined(__STRCMP_LESS__)
     return strcmp_less(a->c_str(), b->c_str());
@@ -164,6 +188,18 @@ inline bool compare_dexstrings(const DexString* a, const DexString* b) {
   if (strlen(sb) == 0) {
     return false;
   }
+  /*
+   * The common prefix decodes identically in both strings, so skip it and
+   * only decode from the start of the first code point that differs.
+   */
+  size_t common = std::mismatch(sa, sa + std::min(a->size(), b->size()), sb)
+                      .first -
+                  sa;
+  while (common > 0 && (sa[common] & 0xc0) == 0x80) {
+    --common;
+  }
+  sa += common;
+  sb += common;
   while (1) {
     uint32_t cpa = mutf8_next_code_point(sa);
     uint32_t cpb = mutf8_next_code_point(sb);
@@ -176,6 +212,23 @@ inline bool compare_dexstrings(const DexString* a, const DexString* b) {
   }
 }
 
+/*
+ * Non-optimizing DexSpec compliant ordering. Strings that have an ordinal are
+ * compared by it, which agrees with comparing their contents, so strings with
+ * and without ordinals can be mixed freely.
+ */
+inline bool compare_dexstrings(const DexString* a, const DexString* b) {
+  if (a == nullptr) {
+    return b != nullptr;
+  } else if (b == nullptr) {
+    return false;
+  }
+  if (a->ordinal() != 0 && b->ordinal() != 0) {
+    return a->ordinal() < b->ordinal();
+  }
+  return compare_dexstring_contents(a, b);
+}
+
 struct dexstrings_comparator {
   bool operator()(const DexString* a, const DexString* b) const {
     return compare_dexstrings(a, b);
@@ -230,6 +283,10 @@ class DexType {
     return get_type(DexString::get_string(str));
   }
 
+  static DexType* get_type(std::string_view str) {
+    return get_type(DexString::get_string(str));
+  }
+
   static DexType* get_type(const char* type_string, int utfsize) {
     return get_type(DexString::get_string(type_string, utfsize));
   }
@@ -239,7 +296,8 @@ class DexType {
 
   DexString* get_name() const { return m_name; }
   const char* c_str() const { return get_name()->c_str(); }
-  const std::string& str() const { return get_name()->str(); }
+  std::string_view str() const { return get_name()->str(); }
+  std::string str_copy() const { return get_name()->str_copy(); }
   DexProto* get_non_overlapping_proto(DexString*, DexProto*);
 };
 
@@ -298,7 +356,8 @@ class DexFieldRef {
   DexType* get_class() const { return m_spec.cls; }
   DexString* get_name() const { return m_spec.name; }
   const char* c_str() const { return get_name()->c_str(); }
-  const std::string& str() const { return get_name()->str(); }
+  std::string_view str() const { return get_name()->str(); }
+  std::string str_copy() const { return get_name()->str_copy(); }
   DexType* get_type() const { return m_spec.type; }
 
   template <typename C>
@@ -324,7 +383,8 @@ class DexField : public DexFieldRef {
   DexAccessFlags m_access;
   DexAnnotationSet* m_anno;
   DexEncodedValue* m_value; /* Static Only */
-  std::string m_deobfuscated_name;
+  // Interned, so that members sharing a name share its storage.
+  const DexString* m_deobfuscated_name{nullptr};
 
   // See UNIQUENESS above for the rationale for the private constructor pattern.
   DexField(DexType* container, DexString* name, DexType* type)
@@ -372,7 +432,7 @@ class DexField : public DexFieldRef {
                                     DexType* type) {
     auto ret = name;
     for (uint32_t i = 0; get_field(container, ret, type); i++) {
-      ret = DexString::make_string(name->str() + "r$" + std::to_string(i));
+      ret = DexString::make_string(name->str_copy() + "r$" + std::to_string(i));
     }
     return ret;
   }
@@ -394,18 +454,33 @@ class DexField : public DexFieldRef {
   void set_external() {
     always_assert_log(!m_concrete, "Unexpected concrete field %s\n",
                       self_show().c_str());
-    m_deobfuscated_name = self_show();
+    m_deobfuscated_name = DexString::make_string(self_show());
     m_external = true;
   }
 
-  void set_deobfuscated_name(const std::string& name) {
+  void set_deobfuscated_name(const DexString* name) {
     m_deobfuscated_name = name;
   }
 
-  const std::string& get_deobfuscated_name() const {
+  void set_deobfuscated_name(std::string_view name) {
+    m_deobfuscated_name = DexString::make_string(name);
+  }
+
+  // Null if no deobfuscated name was ever set, e.g. for Redex-created members.
+  const DexString* get_deobfuscated_name_or_null() const {
     return m_deobfuscated_name;
   }
 
+  // Empty if no deobfuscated name was ever set.
+  std::string_view get_deobfuscated_name() const {
+    return m_deobfuscated_name == nullptr ? std::string_view()
+                                          : m_deobfuscated_name->str();
+  }
+
+  std::string get_deobfuscated_name_copy() const {
+    return std::string(get_deobfuscated_name());
+  }
+
   // Return just the name of the field.
   std::string get_simple_deobfuscated_name() const;
 
@@ -472,29 +547,36 @@ struct dexfields_comparator {
 class DexTypeList {
   friend struct RedexContext;
 
-  std::deque<DexType*> m_list;
+ public:
+  // Contiguous and exactly sized, as most lists hold only a few types.
+  using ContainerType = std::vector<DexType*>;
+
+ private:
+  ContainerType m_list;
 
   // See UNIQUENESS above for the rationale for the private constructor pattern.
-  explicit DexTypeList(std::deque<DexType*>&& p) { m_list = std::move(p); }
+  explicit DexTypeList(ContainerType&& p) : m_list(std::move(p)) {
+    m_list.shrink_to_fit();
+  }
 
  public:
-  std::deque<DexType*>::iterator begin() { return m_list.begin(); }
-  std::deque<DexType*>::iterator end() { return m_list.end(); }
+  ContainerType::iterator begin() { return m_list.begin(); }
+  ContainerType::iterator end() { return m_list.end(); }
   // DexTypeList retrieval/creation
 
   // If the DexTypeList exists, return it, otherwise create it and return it.
   // See also get_type_list()
-  static DexTypeList* make_type_list(std::deque<DexType*>&& p) {
+  static DexTypeList* make_type_list(ContainerType&& p) {
     return g_redex->make_type_list(std::move(p));
   }
 
   // Return an existing DexTypeList or nullptr if one does not exist.
-  static DexTypeList* get_type_list(std::deque<DexType*>&& p) {
+  static DexTypeList* get_type_list(ContainerType&& p) {
     return g_redex->get_type_list(std::move(p));
   }
 
  public:
-  const std::deque<DexType*>& get_type_list() const { return m_list; }
+  const ContainerType& get_type_list() const { return m_list; }
 
   size_t size() const { return get_type_list().size(); }
 
@@ -703,15 +785,51 @@ class IRCode;
 class DexCode {
   friend class DexMethod;
 
+  // The code units of instructions which were not decoded yet, along with
+  // their references in instruction order, see
+  // DexInstruction::make_instruction. This takes much less memory than
+  // heap-allocated instructions, for code that may never be looked at.
+  struct CompactInsns {
+    std::vector<uint16_t> units;
+    std::vector<void*> refs;
+    uint32_t num_insns{0};
+  };
+
   uint16_t m_registers_size;
   uint16_t m_ins_size;
   uint16_t m_outs_size;
-  std::unique_ptr<std::vector<DexInstruction*>> m_insns;
+  // Exactly one of m_insns and m_compact_insns is set. Compact instructions
+  // are decoded on first access to the instructions, which may happen on
+  // several threads at once, hence mutable.
+  mutable std::unique_ptr<std::vector<DexInstruction*>> m_insns;
+  mutable std::unique_ptr<CompactInsns> m_compact_insns;
+  mutable std::atomic<bool> m_is_compact{false};
   std::vector<std::unique_ptr<DexTryItem>> m_tries;
   std::unique_ptr<DexDebugItem> m_dbg;
 
+  void decode() const {
+    if (m_is_compact.load(std::memory_order_acquire)) {
+      decode_compact_insns();
+    }
+  }
+  void decode_compact_insns() const;
+  void drop_compact_insns() {
+    m_compact_insns.reset();
+    m_is_compact.store(false, std::memory_order_release);
+  }
+  // Calls fn on each instruction, without keeping decoded instructions of
+  // compact code around.
+  template <typename Fn>
+  void for_each_instruction(const Fn& fn) const;
+
  public:
-  static std::unique_ptr<DexCode> get_dex_code(DexIdx* idx, uint32_t offset);
+  /*
+   * With `compact`, the instructions are kept as code units until first
+   * accessed, e.g. for methods which are ballooned lazily.
+   */
+  static std::unique_ptr<DexCode> get_dex_code(DexIdx* idx,
+                                               uint32_t offset,
+                                               bool compact = false);
 
   // TODO: make it private and find a better way to allow code creation
   DexCode()
@@ -735,23 +853,30 @@ class DexCode {
     return std::move(m_dbg);
   }
   std::unique_ptr<std::vector<DexInstruction*>> release_instructions() {
+    decode();
     return std::move(m_insns);
   }
   std::vector<DexInstruction*>& reset_instructions() {
+    drop_compact_insns();
     m_insns.reset(new std::vector<DexInstruction*>());
     return *m_insns;
   }
   std::vector<DexInstruction*>& get_instructions() {
+    decode();
     redex_assert(m_insns);
     return *m_insns;
   }
   const std::vector<DexInstruction*>& get_instructions() const {
+    decode();
     redex_assert(m_insns);
     return *m_insns;
   }
   void set_instructions(std::vector<DexInstruction*>* insns) {
+    drop_compact_insns();
     m_insns.reset(insns);
   }
+  // Same as get_instructions().size(), without decoding compact code.
+  uint32_t num_instructions() const;
   std::vector<std::unique_ptr<DexTryItem>>& get_tries() { return m_tries; }
   const std::vector<std::unique_ptr<DexTryItem>>& get_tries() const {
     return m_tries;
@@ -777,6 +902,16 @@ class DexCode {
    */
   uint32_t size() const;
 
+  /*
+   * Same as the IRCode gather methods, for code which was never ballooned.
+   */
+  void gather_strings(std::vector<DexString*>& lstring) const;
+  void gather_types(std::vector<DexType*>& ltype) const;
+  void gather_fields(std::vector<DexFieldRef*>& lfield) const;
+  void gather_methods(std::vector<DexMethodRef*>& lmethod) const;
+  void gather_callsites(std::vector<DexCallSite*>& lcallsite) const;
+  void gather_methodhandles(std::vector<DexMethodHandle*>& lmethodhandle) const;
+
   friend std::string show(const DexCode*);
 };
 
@@ -822,7 +957,8 @@ class DexMethodRef {
   DexType* get_class() const { return m_spec.cls; }
   DexString* get_name() const { return m_spec.name; }
   const char* c_str() const { return get_name()->c_str(); }
-  const std::string& str() const { return get_name()->str(); }
+  std::string_view str() const { return get_name()->str(); }
+  std::string str_copy() const { return get_name()->str_copy(); }
   DexProto* get_proto() const { return m_spec.proto; }
 
   template <typename C>
@@ -852,18 +988,25 @@ class DexMethodRef {
 class DexMethod : public DexMethodRef {
   friend struct RedexContext;
   friend class DexMethodRef;
+  friend class code_spill::CodeSpill;
 
   /* Concrete method members */
 
   // Place these first to avoid/fill padding from DexMethodRef.
   bool m_virtual{false};
+  // Set while the entries of m_code live in a spill file, see CodeSpill.h.
+  mutable std::atomic<bool> m_code_spilled{false};
+  // Set while m_code is yet to be ballooned from m_dex_code, see
+  // balloon_lazily().
+  mutable std::atomic<bool> m_balloon_pending{false};
   DexAccessFlags m_access;
 
   DexAnnotationSet* m_anno;
   std::unique_ptr<DexCode> m_dex_code;
   std::unique_ptr<IRCode> m_code;
   ParamAnnotations m_param_anno;
-  std::string m_deobfuscated_name;
+  // Interned, so that members sharing a name share its storage.
+  const DexString* m_deobfuscated_name{nullptr};
 
   // See UNIQUENESS above for the rationale for the private constructor pattern.
   DexMethod(DexType* type, DexString* name, DexProto* proto);
@@ -876,6 +1019,17 @@ class DexMethod : public DexMethodRef {
 
   std::string self_show() const; // To avoid "Show.h" in the header.
 
+  void restore_code() const {
+    if (is_code_spilled()) {
+      restore_spilled_code();
+    }
+    if (is_balloon_pending()) {
+      balloon_pending_code();
+    }
+  }
+  void restore_spilled_code() const; // To avoid "CodeSpill.h" in the header.
+  void balloon_pending_code() const;
+
  public:
   // Tracks whether this method can be deleted or renamed
   ReferencedState rstate;
@@ -916,7 +1070,7 @@ class DexMethod : public DexMethodRef {
     DexType* cls = DexType::make_type(cls_name);
     DexString* name = DexString::make_string(meth_name);
     DexType* rtype = DexType::make_type(rtype_str);
-    std::deque<DexType*> args;
+    DexTypeList::ContainerType args;
     for (auto const arg_str : arg_strs) {
       DexType* arg = DexType::make_type(arg_str);
       args.push_back(arg);
@@ -967,7 +1121,7 @@ class DexMethod : public DexMethodRef {
                                     DexProto* proto) {
     auto ret = name;
     for (uint32_t i = 0; get_method(type, ret, proto); i++) {
-      ret = DexString::make_string(name->str() + "r$" + std::to_string(i));
+      ret = DexString::make_string(name->str_copy() + "r$" + std::to_string(i));
     }
     return ret;
   }
@@ -977,9 +1131,21 @@ class DexMethod : public DexMethodRef {
   DexAnnotationSet* get_anno_set() { return m_anno; }
   const DexCode* get_dex_code() const { return m_dex_code.get(); }
   DexCode* get_dex_code() { return m_dex_code.get(); }
-  IRCode* get_code() { return m_code.get(); }
-  const IRCode* get_code() const { return m_code.get(); }
+  IRCode* get_code() {
+    restore_code();
+    return m_code.get();
+  }
+  const IRCode* get_code() const {
+    restore_code();
+    return m_code.get();
+  }
   std::unique_ptr<IRCode> release_code();
+  bool is_code_spilled() const {
+    return m_code_spilled.load(std::memory_order_acquire);
+  }
+  bool is_balloon_pending() const {
+    return m_balloon_pending.load(std::memory_order_acquire);
+  }
   bool is_virtual() const { return m_virtual; }
   DexAccessFlags get_access() const {
     always_assert(is_def());
@@ -994,14 +1160,29 @@ class DexMethod : public DexMethodRef {
     return &m_param_anno;
   }
 
-  void set_deobfuscated_name(const std::string& name) {
+  void set_deobfuscated_name(const DexString* name) {
     m_deobfuscated_name = name;
   }
 
-  const std::string& get_deobfuscated_name() const {
+  void set_deobfuscated_name(std::string_view name) {
+    m_deobfuscated_name = DexString::make_string(name);
+  }
+
+  // Null if no deobfuscated name was ever set, e.g. for Redex-created members.
+  const DexString* get_deobfuscated_name_or_null() const {
     return m_deobfuscated_name;
   }
 
+  // Empty if no deobfuscated name was ever set.
+  std::string_view get_deobfuscated_name() const {
+    return m_deobfuscated_name == nullptr ? std::string_view()
+                                          : m_deobfuscated_name->str();
+  }
+
+  std::string get_deobfuscated_name_copy() const {
+    return std::string(get_deobfuscated_name());
+  }
+
   // Return just the name of the method.
   std::string get_simple_deobfuscated_name() const;
 
@@ -1024,7 +1205,7 @@ class DexMethod : public DexMethodRef {
   void set_external() {
     always_assert_log(!m_concrete, "Unexpected concrete method %s\n",
                       self_show().c_str());
-    m_deobfuscated_name = self_show();
+    m_deobfuscated_name = DexString::make_string(self_show());
     m_external = true;
   }
   void set_dex_code(std::unique_ptr<DexCode> code) {
@@ -1109,6 +1290,9 @@ class DexMethod : public DexMethodRef {
    * have to call sync().
    */
   void balloon();
+  // Like balloon(), but deferred until the IRCode is first asked for.
+  // Methods which are never looked at before output never pay for it.
+  void balloon_lazily();
   void sync();
 
   // This method frees the given `DexMethod` - different from `erase_method`,
@@ -1129,7 +1313,8 @@ class DexClass {
   DexTypeList* m_interfaces;
   DexString* m_source_file;
   DexAnnotationSet* m_anno;
-  std::string m_deobfuscated_name;
+  // Interned; equal to the name of m_self unless renamed or obfuscated.
+  const DexString* m_deobfuscated_name{nullptr};
   const std::string m_location; // TODO: string interning
   std::vector<DexField*> m_sfields;
   std::vector<DexField*> m_ifields;
@@ -1234,7 +1419,8 @@ class DexClass {
   DexType* get_type() const { return m_self; }
   DexString* get_name() const { return m_self->get_name(); }
   const char* c_str() const { return get_name()->c_str(); }
-  const std::string& str() const { return get_name()->str(); }
+  std::string_view str() const { return get_name()->str(); }
+  std::string str_copy() const { return get_name()->str_copy(); }
   DexTypeList* get_interfaces() const { return m_interfaces; }
   DexString* get_source_file() const { return m_source_file; }
   bool has_class_data() const;
@@ -1250,12 +1436,27 @@ class DexClass {
    * This also adds `name` as an alias for this DexType in the g_redex global
    * type map.
    */
-  void set_deobfuscated_name(const std::string& name);
+  void set_deobfuscated_name(const DexString* name);
+
+  void set_deobfuscated_name(std::string_view name) {
+    set_deobfuscated_name(DexString::make_string(name));
+  }
 
-  const std::string& get_deobfuscated_name() const {
+  // Null if no deobfuscated name was ever set.
+  const DexString* get_deobfuscated_name_or_null() const {
     return m_deobfuscated_name;
   }
 
+  // Empty if no deobfuscated name was ever set.
+  std::string_view get_deobfuscated_name() const {
+    return m_deobfuscated_name == nullptr ? std::string_view()
+                                          : m_deobfuscated_name->str();
+  }
+
+  std::string get_deobfuscated_name_copy() const {
+    return std::string(get_deobfuscated_name());
+  }
+
   // Returns the location of this class - can be dex/jar file.
   const std::string& get_location() const { return m_location; }
 
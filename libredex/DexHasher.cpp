@@ -7,6 +7,7 @@
 
 #include "DexHasher.h"
 
+#include <boost/functional/hash.hpp>
 #include <cinttypes>
 
 #include "DexAccess.h"
@@ -29,6 +30,171 @@ std::string hash_to_string(size_t hash) {
   return result.str();
 }
 
+namespace {
+
+void combine_type(size_t& seed, const DexType* type) {
+  boost::hash_combine(seed, type);
+  if (type != nullptr) {
+    boost::hash_combine(seed, type->get_name());
+  }
+}
+
+void combine_proto(size_t& seed, const DexProto* proto) {
+  boost::hash_combine(seed, proto);
+  combine_type(seed, proto->get_rtype());
+  for (const auto* arg : proto->get_args()->get_type_list()) {
+    combine_type(seed, arg);
+  }
+}
+
+void combine_method(size_t& seed, const DexMethodRef* method) {
+  boost::hash_combine(seed, method);
+  if (method == nullptr) {
+    return;
+  }
+  combine_type(seed, method->get_class());
+  boost::hash_combine(seed, method->get_name());
+  combine_proto(seed, method->get_proto());
+  boost::hash_combine(seed, method->is_concrete());
+  boost::hash_combine(seed, method->is_external());
+}
+
+void combine_field(size_t& seed, const DexFieldRef* field) {
+  boost::hash_combine(seed, field);
+  combine_type(seed, field->get_class());
+  boost::hash_combine(seed, field->get_name());
+  combine_type(seed, field->get_type());
+  boost::hash_combine(seed, field->is_concrete());
+  boost::hash_combine(seed, field->is_external());
+}
+
+} // namespace
+
+size_t code_fingerprint(const DexMethod* method) {
+  size_t seed = 0;
+  combine_type(seed, method->get_class());
+  combine_proto(seed, method->get_proto());
+  boost::hash_combine(seed, method->get_access());
+  auto* code = method->get_code();
+  if (code == nullptr) {
+    return seed | 1;
+  }
+  boost::hash_combine(seed, code->get_registers_size());
+
+  // Branches, try/catch markers and positions refer to other entries; hash
+  // those by index, like DexClassHasher::hash(const IRCode*) does.
+  std::unordered_map<const void*, uint32_t> ids;
+  auto get_id = [&ids](const void* p) {
+    return ids.emplace(p, (uint32_t)ids.size()).first->second;
+  };
+  for (const MethodItemEntry& mie : *code) {
+    boost::hash_combine(seed, (uint8_t)mie.type);
+    switch (mie.type) {
+    case MFLOW_OPCODE: {
+      auto* insn = mie.insn;
+      boost::hash_combine(seed, (uint16_t)insn->opcode());
+      for (auto src : insn->srcs()) {
+        boost::hash_combine(seed, src);
+      }
+      if (insn->has_dest()) {
+        boost::hash_combine(seed, insn->dest());
+      }
+      if (insn->has_literal()) {
+        boost::hash_combine(seed, insn->get_literal());
+      } else if (insn->has_string()) {
+        boost::hash_combine(seed, insn->get_string());
+      } else if (insn->has_type()) {
+        combine_type(seed, insn->get_type());
+      } else if (insn->has_field()) {
+        combine_field(seed, insn->get_field());
+      } else if (insn->has_method()) {
+        combine_method(seed, insn->get_method());
+      } else if (insn->has_callsite()) {
+        boost::hash_combine(seed, insn->get_callsite());
+      } else if (insn->has_methodhandle()) {
+        boost::hash_combine(seed, insn->get_methodhandle());
+      } else if (insn->has_data()) {
+        auto* data = insn->get_data();
+        boost::hash_range(seed, data->data(),
+                          data->data() + data->data_size());
+      }
+      break;
+    }
+    case MFLOW_TRY:
+      boost::hash_combine(seed, (uint8_t)mie.tentry->type);
+      boost::hash_combine(seed, get_id(mie.tentry->catch_start));
+      break;
+    case MFLOW_CATCH:
+      combine_type(seed, mie.centry->catch_type);
+      boost::hash_combine(seed, get_id(mie.centry->next));
+      break;
+    case MFLOW_TARGET:
+      boost::hash_combine(seed, (uint8_t)mie.target->type);
+      boost::hash_combine(seed, get_id(mie.target->src));
+      if (mie.target->type == BRANCH_MULTI) {
+        boost::hash_combine(seed, mie.target->case_key);
+      }
+      break;
+    case MFLOW_DEBUG:
+      boost::hash_combine(seed, mie.dbgop->opcode());
+      boost::hash_combine(seed, mie.dbgop->uvalue());
+      break;
+    case MFLOW_POSITION:
+      boost::hash_combine(seed, mie.pos->method);
+      boost::hash_combine(seed, mie.pos->file);
+      boost::hash_combine(seed, mie.pos->line);
+      if (mie.pos->parent) {
+        boost::hash_combine(seed, get_id(mie.pos->parent));
+      }
+      break;
+    case MFLOW_SOURCE_BLOCK:
+      for (auto* sb = mie.src_block.get(); sb != nullptr; sb = sb->next.get()) {
+        combine_method(seed, sb->src);
+        boost::hash_combine(seed, sb->id);
+      }
+      break;
+    default:
+      break;
+    }
+  }
+  uint32_t mie_index = 0;
+  for (const MethodItemEntry& mie : *code) {
+    auto it = ids.find(&mie);
+    if (it != ids.end()) {
+      boost::hash_combine(seed, it->second);
+      boost::hash_combine(seed, mie_index);
+    }
+    if (mie.type == MFLOW_POSITION) {
+      auto it2 = ids.find(mie.pos.get());
+      if (it2 != ids.end()) {
+        boost::hash_combine(seed, it2->second);
+        boost::hash_combine(seed, mie_index);
+      }
+    }
+    mie_index++;
+  }
+  return seed | 1;
+}
+
+DexHash MethodHashCache::get(const DexMethod* method) {
+  auto fingerprint = code_fingerprint(method);
+  auto entry = m_entries.get(method, Entry());
+  if (entry.fingerprint == fingerprint) {
+    m_hits++;
+    return entry.hash;
+  }
+  m_misses++;
+  entry.fingerprint = fingerprint;
+  entry.hash = DexClassHasher::hash_code(method->get_code());
+  m_entries.insert_or_assign(std::make_pair(method, entry));
+  return entry.hash;
+}
+
+bool MethodHashCache::has_changed(const DexMethod* method) const {
+  return m_entries.get(method, Entry()).fingerprint !=
+         code_fingerprint(method);
+}
+
 DexHash DexScopeHasher::run() {
   std::unordered_map<DexClass*, size_t> class_indices;
   walk::classes(m_scope, [&](DexClass* cls) {
@@ -39,7 +205,7 @@ DexHash DexScopeHasher::run() {
   std::vector<size_t> class_code_hashes(class_indices.size());
   std::vector<size_t> class_signature_hashes(class_indices.size());
   walk::parallel::classes(m_scope, [&](DexClass* cls) {
-    DexClassHasher class_hasher(cls);
+    DexClassHasher class_hasher(cls, m_cache);
     DexHash class_hash = class_hasher.run();
     auto index = class_indices.at(cls);
     class_positions_hashes.at(index) = class_hash.positions_hash;
@@ -59,7 +225,11 @@ void DexClassHasher::hash(const std::string& str) {
   boost::hash_combine(m_hash, str);
 }
 
-void DexClassHasher::hash(const DexString* s) { hash(s->str()); }
+void DexClassHasher::hash(const DexString* s) {
+  TRACE(HASHER, 4, "[hasher] %s", s->c_str());
+  // Hashes the same as the equivalent std::string.
+  boost::hash_combine(m_hash, s->str());
+}
 
 void DexClassHasher::hash(bool value) {
   TRACE(HASHER, 4, "[hasher] %u", value);
@@ -259,9 +429,23 @@ void DexClassHasher::hash(const DexMethod* m) {
   hash(static_cast<const DexMethodRef*>(m));
   hash(m->get_anno_set());
   hash(m->get_access());
-  hash(m->get_deobfuscated_name());
+  hash(m->get_deobfuscated_name_copy());
   hash(m->get_param_anno());
-  hash(m->get_code());
+  auto* code = m->get_code();
+  if (code != nullptr) {
+    auto code_hash =
+        m_cache != nullptr ? m_cache->get(m) : hash_code(code);
+    boost::hash_combine(m_positions_hash, code_hash.positions_hash);
+    boost::hash_combine(m_registers_hash, code_hash.registers_hash);
+    boost::hash_combine(m_code_hash, code_hash.code_hash);
+  }
+}
+
+DexHash DexClassHasher::hash_code(const IRCode* code) {
+  DexClassHasher hasher(nullptr);
+  hasher.hash(code);
+  return DexHash{hasher.m_positions_hash, hasher.m_registers_hash,
+                 hasher.m_code_hash, 0};
 }
 
 void DexClassHasher::hash(const DexFieldRef* f) {
@@ -357,7 +541,7 @@ void DexClassHasher::hash(const DexField* f) {
   hash(f->get_anno_set());
   hash(f->get_static_value());
   hash(f->get_access());
-  hash(f->get_deobfuscated_name());
+  hash(f->get_deobfuscated_name_copy());
 }
 
 DexHash DexClassHasher::run() {
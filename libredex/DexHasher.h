@@ -15,11 +15,13 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <ostream>
 #include <string>
 
+#include "ConcurrentContainers.h"
 #include "Debug.h"
 #include "DexClass.h"
 #include "IRInstruction.h"
@@ -36,20 +38,73 @@ struct DexHash {
   size_t signature_hash;
 };
 
+/*
+ * A cheap fingerprint of a method's class, proto, access flags and
+ * everything in its code that the DexClassHasher looks at. Strings, types and
+ * members are hashed by identity, which is stable within a run, together with
+ * the identity of their names, so renamings are noticed too. Zero is reserved
+ * for "not fingerprinted".
+ */
+size_t code_fingerprint(const DexMethod* method);
+
+/*
+ * Remembers the code hashes of methods, and recomputes them only for methods
+ * whose code_fingerprint changed since they were last hashed. This can be kept
+ * across passes, and also serves as change detection for anything that wants
+ * to only revisit the methods that changed.
+ */
+class MethodHashCache final {
+ public:
+  /*
+   * The positions, registers and code hashes of the code of `method`; the
+   * signature hash is left zero. Safe to call concurrently.
+   */
+  DexHash get(const DexMethod* method);
+
+  /*
+   * Whether `method` is new or changed since it was last hashed by get().
+   */
+  bool has_changed(const DexMethod* method) const;
+
+  void clear() { m_entries.clear(); }
+
+  size_t hits() const { return m_hits.load(); }
+  size_t misses() const { return m_misses.load(); }
+
+ private:
+  struct Entry {
+    size_t fingerprint{0};
+    DexHash hash{0, 0, 0, 0};
+  };
+  ConcurrentMap<const DexMethod*, Entry> m_entries;
+  std::atomic<size_t> m_hits{0};
+  std::atomic<size_t> m_misses{0};
+};
+
 class DexScopeHasher final {
  public:
-  explicit DexScopeHasher(const Scope& scope) : m_scope(scope) {}
+  explicit DexScopeHasher(const Scope& scope,
+                          MethodHashCache* cache = nullptr)
+      : m_scope(scope), m_cache(cache) {}
   DexHash run();
 
  private:
   const Scope& m_scope;
+  MethodHashCache* m_cache;
 };
 
 class DexClassHasher final {
  public:
-  explicit DexClassHasher(DexClass* cls) : m_cls(cls) {}
+  explicit DexClassHasher(DexClass* cls, MethodHashCache* cache = nullptr)
+      : m_cls(cls), m_cache(cache) {}
   DexHash run();
 
+  /*
+   * The positions, registers and code hashes of `code` on its own, which
+   * DexClassHasher::run() combines for all methods of a class.
+   */
+  static DexHash hash_code(const IRCode* code);
+
  private:
   void hash(const std::string& str);
   void hash(int value);
@@ -97,6 +152,7 @@ class DexClassHasher final {
     }
   }
   DexClass* m_cls;
+  MethodHashCache* m_cache;
   size_t m_hash{0};
   size_t m_code_hash{0};
   size_t m_registers_hash{0};
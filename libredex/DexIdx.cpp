@@ -7,11 +7,15 @@
 
 #include "DexIdx.h"
 
+#include <algorithm>
 #include <sstream>
+#include <utility>
+#include <vector>
 
 #include "DexCallSite.h"
 #include "DexClass.h"
 #include "DexMethodHandle.h"
+#include "WorkQueue.h"
 
 #define INIT_DMAP_ID(TYPE, CACHETYPE)                                  \
   always_assert_log(dh->TYPE##_ids_off < dh->file_size,                \
@@ -66,6 +70,53 @@ DexIdx::~DexIdx() {
   }
 }
 
+namespace {
+
+constexpr uint32_t kPreloadChunkSize = 1024;
+
+template <typename Fn>
+void for_each_chunk_in_parallel(uint32_t size, const Fn& fn) {
+  std::vector<uint32_t> chunks;
+  for (uint32_t begin = 0; begin < size; begin += kPreloadChunkSize) {
+    chunks.push_back(begin);
+  }
+  workqueue_run<uint32_t>(
+      [&](uint32_t begin) {
+        fn(begin, std::min(size, begin + kPreloadChunkSize));
+      },
+      chunks);
+}
+
+} // namespace
+
+void DexIdx::preload_strings_types_and_protos() {
+  // Each table only refers to the ones before it, so after each pass the
+  // caches it fills are complete and only read by the next one.
+  for_each_chunk_in_parallel(
+      m_string_ids_size, [this](uint32_t begin, uint32_t end) {
+        std::vector<std::pair<const char*, uint32_t>> strs;
+        strs.reserve(end - begin);
+        for (uint32_t i = begin; i < end; i++) {
+          strs.push_back(get_stringidx_data(i));
+        }
+        auto dexstrings = g_redex->make_strings(strs);
+        std::copy(dexstrings.begin(), dexstrings.end(),
+                  m_string_cache + begin);
+      });
+  for_each_chunk_in_parallel(
+      m_type_ids_size, [this](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; i++) {
+          m_type_cache[i] = get_typeidx_fromdex(i);
+        }
+      });
+  for_each_chunk_in_parallel(
+      m_proto_ids_size, [this](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; i++) {
+          m_proto_cache[i] = get_protoidx_fromdex(i);
+        }
+      });
+}
+
 DexCallSite* DexIdx::get_callsiteidx_fromdex(uint32_t csidx) {
   redex_assert(csidx < m_callsite_ids_size);
   // callsites are indirected through the callsite_id table, because
@@ -119,7 +170,8 @@ DexMethodHandle* DexIdx::get_methodhandleidx_fromdex(uint32_t mhidx) {
   }
 }
 
-DexString* DexIdx::get_stringidx_fromdex(uint32_t stridx) {
+std::pair<const char*, uint32_t> DexIdx::get_stringidx_data(
+    uint32_t stridx) {
   redex_assert(stridx < m_string_ids_size);
   uint32_t stroff = m_string_ids[stridx].offset;
   always_assert_log(stroff < ((dex_header*)m_dexbase)->file_size,
@@ -127,7 +179,12 @@ DexString* DexIdx::get_stringidx_fromdex(uint32_t stridx) {
   const uint8_t* dstr = m_dexbase + stroff;
   /* Strip off uleb128 size encoding */
   int utfsize = read_uleb128(&dstr);
-  return DexString::make_string((const char*)dstr, utfsize);
+  return std::make_pair((const char*)dstr, (uint32_t)utfsize);
+}
+
+DexString* DexIdx::get_stringidx_fromdex(uint32_t stridx) {
+  auto data = get_stringidx_data(stridx);
+  return DexString::make_string(data.first, data.second);
 }
 
 DexType* DexIdx::get_typeidx_fromdex(uint32_t typeidx) {
@@ -168,7 +225,7 @@ DexTypeList* DexIdx::get_type_list(uint32_t offset) {
   const uint32_t* tlp = get_uint_data(offset);
   uint32_t size = *tlp++;
   const uint16_t* typep = (const uint16_t*)tlp;
-  std::deque<DexType*> tlist;
+  DexTypeList::ContainerType tlist;
   for (uint32_t i = 0; i < size; i++) {
     tlist.push_back(get_typeidx(typep[i]));
   }
@@ -9,6 +9,7 @@
 
 #include <assert.h>
 #include <string>
+#include <utility>
 
 #include "Debug.h"
 #include "DexDefs.h"
@@ -52,6 +53,7 @@ class DexIdx {
   DexMethodHandle** m_methodhandle_cache = nullptr;
 
   DexType* get_typeidx_fromdex(uint32_t typeidx);
+  std::pair<const char*, uint32_t> get_stringidx_data(uint32_t stridx);
   DexString* get_stringidx_fromdex(uint32_t stridx);
   DexFieldRef* get_fieldidx_fromdex(uint32_t fidx);
   DexMethodRef* get_methodidx_fromdex(uint32_t midx);
@@ -63,6 +65,15 @@ class DexIdx {
   explicit DexIdx(const dex_header* dh);
   ~DexIdx();
 
+  /*
+   * Eagerly intern every string, type and proto of the dex, in parallel, and
+   * fill the corresponding caches. Loading classes touches nearly all of them
+   * anyway; doing it in bulk up front spreads the interning across all shards
+   * of the context's maps at once instead of having class loaders contend on
+   * the same hot entries, and leaves these caches read-only afterwards.
+   */
+  void preload_strings_types_and_protos();
+
   DexString* get_stringidx(uint32_t stridx) {
     if (m_string_cache[stridx] == nullptr) {
       m_string_cache[stridx] = get_stringidx_fromdex(stridx);
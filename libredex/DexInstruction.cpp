@@ -768,8 +768,74 @@ void DexInstruction::encode(DexOutputIdx* /* unused */,
 
 uint16_t DexInstruction::size() const { return m_count + 1; }
 
-DexInstruction* DexInstruction::make_instruction(DexIdx* idx,
-                                                 const uint16_t** insns_ptr) {
+namespace {
+
+// Resolves the references of instructions through the DexIdx of their dex,
+// optionally recording them.
+class IdxRefResolver {
+ public:
+  IdxRefResolver(DexIdx* idx, std::vector<void*>* refs)
+      : m_idx(idx), m_refs(refs) {}
+
+  DexString* get_stringidx(uint32_t i) {
+    return record(m_idx->get_stringidx(i));
+  }
+  DexType* get_typeidx(uint32_t i) { return record(m_idx->get_typeidx(i)); }
+  DexFieldRef* get_fieldidx(uint32_t i) {
+    return record(m_idx->get_fieldidx(i));
+  }
+  DexMethodRef* get_methodidx(uint32_t i) {
+    return record(m_idx->get_methodidx(i));
+  }
+  DexMethodHandle* get_methodhandleidx(uint32_t i) {
+    return record(m_idx->get_methodhandleidx(i));
+  }
+  DexCallSite* get_callsiteidx(uint32_t i) {
+    return record(m_idx->get_callsiteidx(i));
+  }
+
+ private:
+  template <typename T>
+  T* record(T* ref) {
+    if (m_refs != nullptr) {
+      m_refs->push_back(ref);
+    }
+    return ref;
+  }
+
+  DexIdx* m_idx;
+  std::vector<void*>* m_refs;
+};
+
+// Returns references recorded by an IdxRefResolver, in order. The indices in
+// the code units are ignored.
+class RecordedRefResolver {
+ public:
+  explicit RecordedRefResolver(void* const** refs_ptr) : m_refs(*refs_ptr) {}
+
+  DexString* get_stringidx(uint32_t) { return next<DexString>(); }
+  DexType* get_typeidx(uint32_t) { return next<DexType>(); }
+  DexFieldRef* get_fieldidx(uint32_t) { return next<DexFieldRef>(); }
+  DexMethodRef* get_methodidx(uint32_t) { return next<DexMethodRef>(); }
+  DexMethodHandle* get_methodhandleidx(uint32_t) {
+    return next<DexMethodHandle>();
+  }
+  DexCallSite* get_callsiteidx(uint32_t) { return next<DexCallSite>(); }
+
+ private:
+  template <typename T>
+  T* next() {
+    return static_cast<T*>(*m_refs++);
+  }
+
+  void* const*& m_refs;
+};
+
+} // namespace
+
+template <typename RefResolver>
+DexInstruction* DexInstruction::decode(RefResolver& resolver,
+                                       const uint16_t** insns_ptr) {
   auto& insns = *insns_ptr;
   auto fopcode = static_cast<DexOpcode>(*insns++);
   DexOpcode opcode = static_cast<DexOpcode>(fopcode & 0xff);
@@ -1007,7 +1073,7 @@ DexInstruction* DexInstruction::make_instruction(DexIdx* idx,
   case DOPCODE_SPUT_CHAR:
   case DOPCODE_SPUT_SHORT: {
     uint16_t fidx = *insns++;
-    DexFieldRef* field = idx->get_fieldidx(fidx);
+    DexFieldRef* field = resolver.get_fieldidx(fidx);
     return new DexOpcodeField(fopcode, field);
   }
   /* MethodRef: */
@@ -1023,7 +1089,7 @@ DexInstruction* DexInstruction::make_instruction(DexIdx* idx,
   case DOPCODE_INVOKE_INTERFACE_RANGE: {
     uint16_t midx = *insns++;
     uint16_t arg = *insns++;
-    DexMethodRef* meth = idx->get_methodidx(midx);
+    DexMethodRef* meth = resolver.get_methodidx(midx);
     return new DexOpcodeMethod(fopcode, meth, arg);
   }
   /* MethodHandle: */
@@ -1031,7 +1097,7 @@ DexInstruction* DexInstruction::make_instruction(DexIdx* idx,
   case DOPCODE_INVOKE_POLYMORPHIC_RANGE: {
     uint16_t csidx = *insns++;
     uint16_t arg = *insns++;
-    DexMethodHandle* methodhandle = idx->get_methodhandleidx(csidx);
+    DexMethodHandle* methodhandle = resolver.get_methodhandleidx(csidx);
     return new DexOpcodeMethodHandle(fopcode, methodhandle, arg);
   }
   /* CallSite: */
@@ -1039,19 +1105,19 @@ DexInstruction* DexInstruction::make_instruction(DexIdx* idx,
   case DOPCODE_INVOKE_CUSTOM_RANGE: {
     uint16_t csidx = *insns++;
     uint16_t arg = *insns++;
-    DexCallSite* callsite = idx->get_callsiteidx(csidx);
+    DexCallSite* callsite = resolver.get_callsiteidx(csidx);
     return new DexOpcodeCallSite(fopcode, callsite, arg);
   }
   /* StringRef: */
   case DOPCODE_CONST_STRING: {
     uint16_t sidx = *insns++;
-    DexString* str = idx->get_stringidx(sidx);
+    DexString* str = resolver.get_stringidx(sidx);
     return new DexOpcodeString(fopcode, str);
   }
   case DOPCODE_CONST_STRING_JUMBO: {
     uint32_t sidx = *insns++;
     sidx |= (*insns++) << 16;
-    DexString* str = idx->get_stringidx(sidx);
+    DexString* str = resolver.get_stringidx(sidx);
     return new DexOpcodeString(fopcode, str);
   }
   case DOPCODE_CONST_CLASS:
@@ -1060,14 +1126,14 @@ DexInstruction* DexInstruction::make_instruction(DexIdx* idx,
   case DOPCODE_NEW_INSTANCE:
   case DOPCODE_NEW_ARRAY: {
     uint16_t tidx = *insns++;
-    DexType* type = idx->get_typeidx(tidx);
+    DexType* type = resolver.get_typeidx(tidx);
     return new DexOpcodeType(fopcode, type);
   }
   case DOPCODE_FILLED_NEW_ARRAY:
   case DOPCODE_FILLED_NEW_ARRAY_RANGE: {
     uint16_t tidx = *insns++;
     uint16_t arg = *insns++;
-    DexType* type = idx->get_typeidx(tidx);
+    DexType* type = resolver.get_typeidx(tidx);
     return new DexOpcodeType(fopcode, type, arg);
   }
   default:
@@ -1076,6 +1142,25 @@ DexInstruction* DexInstruction::make_instruction(DexIdx* idx,
   }
 }
 
+DexInstruction* DexInstruction::make_instruction(DexIdx* idx,
+                                                 const uint16_t** insns_ptr) {
+  IdxRefResolver resolver(idx, nullptr);
+  return decode(resolver, insns_ptr);
+}
+
+DexInstruction* DexInstruction::make_instruction(DexIdx* idx,
+                                                 const uint16_t** insns_ptr,
+                                                 std::vector<void*>* refs) {
+  IdxRefResolver resolver(idx, refs);
+  return decode(resolver, insns_ptr);
+}
+
+DexInstruction* DexInstruction::make_instruction(void* const** refs_ptr,
+                                                 const uint16_t** insns_ptr) {
+  RecordedRefResolver resolver(refs_ptr);
+  return decode(resolver, insns_ptr);
+}
+
 DexInstruction* DexInstruction::make_instruction(DexOpcode op) {
   switch (op) {
   /* Field ref: */
@@ -11,6 +11,7 @@
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "Debug.h"
 #include "DexDefs.h"
@@ -81,9 +82,29 @@ class DexInstruction : public Gatherable {
 
   void encode_opcode(uint16_t*& insns) const { *insns++ = m_opcode; }
 
+ private:
+  template <typename RefResolver>
+  static DexInstruction* decode(RefResolver& resolver,
+                                const uint16_t** insns_ptr);
+
  public:
   static DexInstruction* make_instruction(DexIdx* idx,
                                           const uint16_t** insns_ptr);
+  /*
+   * Same as above, also appending the references of the instruction, if any,
+   * to `refs`. Together with the code units, they are enough to decode the
+   * instruction again without the DexIdx, with the overload below.
+   */
+  static DexInstruction* make_instruction(DexIdx* idx,
+                                          const uint16_t** insns_ptr,
+                                          std::vector<void*>* refs);
+  /*
+   * Decodes an instruction whose references were recorded by the above.
+   * `*refs_ptr` points to the references of this and the following
+   * instructions, and is advanced past those of this instruction.
+   */
+  static DexInstruction* make_instruction(void* const** refs_ptr,
+                                          const uint16_t** insns_ptr);
   /* Creates the right subclass of DexInstruction for the given opcode */
   static DexInstruction* make_instruction(DexOpcode);
   virtual void encode(DexOutputIdx* dodx, uint16_t*& insns) const;
@@ -18,6 +18,7 @@
 
 #include <exception>
 #include <stdexcept>
+#include <unordered_set>
 #include <vector>
 
 DexLoader::DexLoader(const char* location)
@@ -135,13 +136,13 @@ void DexLoader::gather_input_stats(dex_stats_t* stats, const dex_header* dh) {
     for (auto* meth : clz->get_vmethods()) {
       DexCode* code = meth->get_dex_code();
       if (code) {
-        stats->num_instructions += code->get_instructions().size();
+        stats->num_instructions += code->num_instructions();
       }
     }
     for (auto* meth : clz->get_dmethods()) {
       DexCode* code = meth->get_dex_code();
       if (code) {
-        stats->num_instructions += code->get_instructions().size();
+        stats->num_instructions += code->num_instructions();
       }
     }
   }
@@ -444,6 +445,10 @@ void DexLoader::gather_input_stats(dex_stats_t* stats, const dex_header* dh) {
   }
 }
 
+DexType* DexLoader::get_class_def_type(int num) {
+  return m_idx->get_typeidx(m_class_defs[num].typeidx);
+}
+
 void DexLoader::load_dex_class(int num) {
   const dex_class_def* cdef = m_class_defs + num;
   DexClass* dc = DexClass::create(m_idx.get(), cdef, m_dex_location);
@@ -463,67 +468,102 @@ const dex_header* DexLoader::get_dex_header(const char* location) {
   return reinterpret_cast<const dex_header*>(m_file->const_data());
 }
 
+const dex_header* DexLoader::get_validated_dex_header(
+    const char* location, int support_dex_version) {
+  const dex_header* dh = get_dex_header(location);
+  validate_dex_header(dh, m_file->size(), support_dex_version);
+  return dh;
+}
+
 DexClasses DexLoader::load_dex(const char* location,
                                dex_stats_t* stats,
                                int support_dex_version) {
-  const dex_header* dh = get_dex_header(location);
-  validate_dex_header(dh, m_file->size(), support_dex_version);
-  return load_dex(dh, stats);
+  return load_dex(get_validated_dex_header(location, support_dex_version),
+                  stats);
 }
 
-DexClasses DexLoader::load_dex(const dex_header* dh, dex_stats_t* stats) {
-  if (dh->class_defs_size == 0) {
-    return DexClasses(0);
+namespace {
+
+// Runs `fn` on all items in parallel. Exceptions thrown by `fn` are collected,
+// and rethrown together once all items are done.
+template <typename Item, typename Fn>
+void run_collecting_exceptions(const std::vector<Item>& items, const Fn& fn) {
+  auto num_threads = redex_parallel::default_num_threads();
+  std::vector<std::vector<std::exception_ptr>> exceptions_vec(num_threads);
+  workqueue_run<Item>(
+      [&exceptions_vec, &fn](sparta::SpartaWorkerState<Item>* state,
+                             Item item) {
+        try {
+          fn(item);
+        } catch (const std::exception& exc) {
+          TRACE(MAIN, 1, "Worker throw the exception:%s", exc.what());
+          exceptions_vec[state->worker_id()].emplace_back(
+              std::current_exception());
+        }
+      },
+      items,
+      num_threads);
+
+  std::vector<std::exception_ptr> all_exceptions;
+  for (auto& exceptions : exceptions_vec) {
+    all_exceptions.insert(all_exceptions.end(), exceptions.begin(),
+                          exceptions.end());
   }
+  if (!all_exceptions.empty()) {
+    // At least one of the workers raised an exception
+    aggregate_exception ae(all_exceptions);
+    throw ae;
+  }
+}
+
+} // namespace
+
+void DexLoader::prepare_dex(const dex_header* dh, DexClasses* classes) {
   m_idx = std::make_unique<DexIdx>(dh);
+  m_idx->preload_strings_types_and_protos();
   auto off = (uint64_t)dh->class_defs_off;
   m_class_defs =
       reinterpret_cast<const dex_class_def*>((const uint8_t*)dh + off);
-  DexClasses classes(dh->class_defs_size);
-  m_classes = &classes;
-
-  {
-    auto num_threads = redex_parallel::default_num_threads();
-    std::vector<std::vector<std::exception_ptr>> exceptions_vec(num_threads);
-    std::vector<size_t> indices(dh->class_defs_size);
-    std::iota(indices.begin(), indices.end(), 0);
-    workqueue_run<size_t>(
-        [&exceptions_vec, this](sparta::SpartaWorkerState<size_t>* state,
-                                size_t num) {
-          try {
-            load_dex_class(num);
-          } catch (const std::exception& exc) {
-            TRACE(MAIN, 1, "Worker throw the exception:%s", exc.what());
-            exceptions_vec[state->worker_id()].emplace_back(
-                std::current_exception());
-          }
-        },
-        indices,
-        num_threads);
-
-    std::vector<std::exception_ptr> all_exceptions;
-    for (auto& exceptions : exceptions_vec) {
-      all_exceptions.insert(all_exceptions.end(), exceptions.begin(),
-                            exceptions.end());
-    }
-    if (!all_exceptions.empty()) {
-      // At least one of the workers raised an exception
-      aggregate_exception ae(all_exceptions);
-      throw ae;
-    }
-  }
+  classes->resize(dh->class_defs_size);
+  m_classes = classes;
+}
 
+void DexLoader::finish_dex(const dex_header* dh,
+                           dex_stats_t* stats,
+                           DexClasses* classes) {
   gather_input_stats(stats, dh);
 
   // Remove nulls from the classes list. They may have been introduced by benign
   // duplicate classes.
-  classes.erase(std::remove(classes.begin(), classes.end(), nullptr),
-                classes.end());
+  classes->erase(std::remove(classes->begin(), classes->end(), nullptr),
+                 classes->end());
+}
 
+DexClasses DexLoader::load_dex(const dex_header* dh, dex_stats_t* stats) {
+  if (dh->class_defs_size == 0) {
+    return DexClasses(0);
+  }
+  DexClasses classes;
+  prepare_dex(dh, &classes);
+
+  std::vector<size_t> indices(dh->class_defs_size);
+  std::iota(indices.begin(), indices.end(), 0);
+  run_collecting_exceptions(indices,
+                            [this](size_t num) { load_dex_class(num); });
+
+  finish_dex(dh, stats, &classes);
   return classes;
 }
 
 static void balloon_all(const Scope& scope) {
+  if (RedexContext::lazy_balloon()) {
+    walk::methods(scope, [](DexMethod* m) {
+      if (m->get_dex_code()) {
+        m->balloon_lazily();
+      }
+    });
+    return;
+  }
   walk::parallel::methods(scope, [&](DexMethod* m) {
     if (m->get_dex_code()) {
       m->balloon();
@@ -562,6 +602,68 @@ DexClasses load_classes_from_dex(const dex_header* dh,
   return classes;
 }
 
+DexClassesVector load_classes_from_dexes(
+    const std::vector<std::string>& locations,
+    std::vector<dex_stats_t>* stats,
+    bool balloon,
+    int support_dex_version) {
+  std::vector<std::unique_ptr<DexLoader>> loaders;
+  std::vector<const dex_header*> headers;
+  DexClassesVector dexen(locations.size());
+  // Class defs as (dex, class def) pairs. Those of types defined by an
+  // earlier class def are loaded once all others are, and in order, so that
+  // which definition wins and which duplicates are reported does not depend
+  // on the scheduling of the work queue.
+  std::vector<std::pair<size_t, size_t>> class_defs;
+  std::vector<std::pair<size_t, size_t>> duplicate_class_defs;
+  std::unordered_set<DexType*> types;
+  for (size_t i = 0; i < locations.size(); ++i) {
+    const char* location = locations[i].c_str();
+    TRACE(MAIN, 1, "Loading classes from dex from %s", location);
+    loaders.push_back(std::make_unique<DexLoader>(location));
+    auto& dl = *loaders.back();
+    const dex_header* dh =
+        dl.get_validated_dex_header(location, support_dex_version);
+    headers.push_back(dh);
+    if (dh->class_defs_size == 0) {
+      continue;
+    }
+    dl.prepare_dex(dh, &dexen[i]);
+    for (size_t num = 0; num < dh->class_defs_size; ++num) {
+      if (types.insert(dl.get_class_def_type(num)).second) {
+        class_defs.emplace_back(i, num);
+      } else {
+        duplicate_class_defs.emplace_back(i, num);
+      }
+    }
+  }
+
+  run_collecting_exceptions(class_defs,
+                            [&loaders](std::pair<size_t, size_t> p) {
+                              loaders[p.first]->load_dex_class(p.second);
+                            });
+  for (const auto& p : duplicate_class_defs) {
+    loaders[p.first]->load_dex_class(p.second);
+  }
+
+  if (stats) {
+    stats->resize(locations.size());
+  }
+  Scope scope;
+  for (size_t i = 0; i < locations.size(); ++i) {
+    if (headers[i]->class_defs_size == 0) {
+      continue;
+    }
+    loaders[i]->finish_dex(headers[i], stats ? &stats->at(i) : nullptr,
+                           &dexen[i]);
+    scope.insert(scope.end(), dexen[i].begin(), dexen[i].end());
+  }
+  if (balloon) {
+    balloon_all(scope);
+  }
+  return dexen;
+}
+
 std::string load_dex_magic_from_dex(const char* location) {
   DexLoader dl(location);
   auto dh = dl.get_dex_header(location);
@@ -26,11 +26,22 @@ class DexLoader {
   explicit DexLoader(const char* location);
 
   const dex_header* get_dex_header(const char* location);
+  const dex_header* get_validated_dex_header(const char* location,
+                                             int support_dex_version);
   DexClasses load_dex(const char* location,
                       dex_stats_t* stats,
                       int support_dex_version);
   DexClasses load_dex(const dex_header* dh, dex_stats_t* stats);
+  // The steps of load_dex, for loading the class defs of several dexes
+  // through one work queue. prepare_dex sizes `classes` to hold one class per
+  // class def, which load_dex_class then fills in, and finish_dex removes the
+  // class defs that did not produce a class.
+  void prepare_dex(const dex_header* dh, DexClasses* classes);
+  DexType* get_class_def_type(int num);
   void load_dex_class(int num);
+  void finish_dex(const dex_header* dh,
+                  dex_stats_t* stats,
+                  DexClasses* classes);
   void gather_input_stats(dex_stats_t* stats, const dex_header* dh);
   DexIdx* get_idx() { return m_idx.get(); }
 };
@@ -45,6 +56,18 @@ DexClasses load_classes_from_dex(const char* location,
 DexClasses load_classes_from_dex(const dex_header* dh,
                                  const char* location,
                                  bool balloon = true);
+/*
+ * Loads the classes of several dexes at once, with a single work queue over
+ * the class defs of all of them, and returns the classes of each dex. The
+ * result is the same as loading the dexes one after the other: a class that
+ * is defined more than once is taken from its first definition, in the order
+ * of `locations`. If not null, `stats` receives the stats of each dex.
+ */
+DexClassesVector load_classes_from_dexes(
+    const std::vector<std::string>& locations,
+    std::vector<dex_stats_t>* stats,
+    bool balloon = true,
+    int support_dex_version = 35);
 std::string load_dex_magic_from_dex(const char* location);
 void balloon_for_test(const Scope& scope);
 
@@ -12,28 +12,52 @@
 
 namespace dex_opcode {
 
-// clang-format off
-OpcodeFormat format(DexOpcode opcode) {
-  switch (opcode) {
-#define OP(op, code, fmt, ...) \
-  case code:                   \
-    return FMT_##fmt;
-    DOPS
+namespace {
+
+// Marks the opcode bytes that have no format in the tables below.
+constexpr uint8_t kUnknownFormat = 0xff;
+constexpr uint8_t kQuickFormat = 0xfe;
+
+struct FormatTable {
+  uint8_t formats[256];
+};
+
+// format() is looked up by most accessors of DexInstruction, so it is a
+// single load from a table built at compile time rather than a switch.
+constexpr FormatTable make_format_table() {
+  FormatTable table{};
+  for (auto& fmt : table.formats) {
+    fmt = kUnknownFormat;
+  }
+#define OP(op, code, fmt, ...) table.formats[code] = FMT_##fmt;
+  DOPS
 #undef OP
-  case FOPCODE_PACKED_SWITCH : return FMT_fopcode;
-  case FOPCODE_SPARSE_SWITCH:
-    return FMT_fopcode;
-  case FOPCODE_FILLED_ARRAY:
+#define OP(op, code, fmt, ...) table.formats[code] = kQuickFormat;
+  QDOPS
+#undef OP
+  return table;
+}
+
+constexpr FormatTable kFormatTable = make_format_table();
+
+} // namespace
+
+OpcodeFormat format(DexOpcode opcode) {
+  if (opcode > 0xff) {
+    always_assert_log(opcode == FOPCODE_PACKED_SWITCH ||
+                          opcode == FOPCODE_SPARSE_SWITCH ||
+                          opcode == FOPCODE_FILLED_ARRAY,
+                      "Unexpected opcode 0x%x", opcode);
     return FMT_fopcode;
-#define OP(op, code, fmt, ...) \
-  case code:                   \
+  }
+  auto fmt = kFormatTable.formats[opcode];
+  if (fmt == kQuickFormat) {
     not_reached_log("Unexpected quick opcode 0x%x", opcode);
-    QDOPS
-#undef OP
+  } else if (fmt == kUnknownFormat) {
+    not_reached_log("Unexpected opcode 0x%x", opcode);
   }
-  not_reached_log("Unexpected opcode 0x%x", opcode);
+  return static_cast<OpcodeFormat>(fmt);
 }
-// clang-format on
 
 bool dest_is_src(DexOpcode op) { return format(op) == FMT_f12x_2; }
 
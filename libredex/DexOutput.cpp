@@ -10,6 +10,7 @@
 #include <algorithm>
 #include <assert.h>
 #include <boost/filesystem.hpp>
+#include <boost/functional/hash.hpp>
 #include <exception>
 #include <fcntl.h>
 #include <fstream>
@@ -19,6 +20,7 @@
 #include <memory>
 #include <stdlib.h>
 #include <sys/stat.h>
+#include <unordered_map>
 #include <unordered_set>
 
 #ifdef _MSC_VER
@@ -34,6 +36,7 @@
 #define O_WRONLY _O_WRONLY
 #endif
 
+#include "Adler32.h"
 #include "Debug.h"
 #include "DexCallSite.h"
 #include "DexClass.h"
@@ -44,6 +47,7 @@
 #include "DexUtil.h"
 #include "IODIMetadata.h"
 #include "IRCode.h"
+#include "InstructionLowering.h"
 #include "Macros.h"
 #include "MethodProfiles.h"
 #include "MethodSimilarityOrderer.h"
@@ -56,11 +60,6 @@
 #include "Walkers.h"
 #include "WorkQueue.h"
 
-/*
- * For adler32...
- */
-#include <zlib.h>
-
 template <class T, class U>
 class CustomSort {
  private:
@@ -462,16 +461,25 @@ DexOutput::DexOutput(
                          ? get_dex_output_size(config_files) * 2
                          : get_dex_output_size(config_files)) +
                     k_output_red_zone),
-      m_output(std::make_unique<uint8_t[]>(m_output_size)),
+      m_output(nullptr),
       m_offset(0),
       m_iodi_metadata(iodi_metadata),
       m_config_files(config_files),
       m_min_sdk(min_sdk) {
-  // Ensure a clean slate.
-  memset(m_output.get(), 0, m_output_size);
+  // Both kinds of storage start out zeroed. A freshly created file is sparse,
+  // so only the pages the dex actually uses take up memory, and the kernel
+  // can write them back while the rest of the dex is being generated.
+  if (path != nullptr && *path != '\0') {
+    m_output_file = std::make_unique<RedexMappedFile>(
+        RedexMappedFile::create(path, m_output_size));
+    m_output = reinterpret_cast<uint8_t*>(m_output_file->data());
+  } else {
+    m_output_buffer = std::make_unique<uint8_t[]>(m_output_size);
+    m_output = m_output_buffer.get();
+  }
 
   m_gtypes = new GatheredTypes(classes);
-  dodx = m_gtypes->get_dodx(m_output.get());
+  dodx = m_gtypes->get_dodx(m_output);
 
   always_assert_log(
       dodx->method_to_idx().size() <= kMaxMethodRefs,
@@ -610,9 +618,9 @@ void DexOutput::insert_map_item(uint16_t maptype,
 void DexOutput::emit_locator(Locator locator) {
   char buf[Locator::encoded_max];
   size_t locator_length = locator.encode(buf);
-  write_uleb128(m_output.get() + m_offset, (uint32_t)locator_length);
+  write_uleb128(m_output + m_offset, (uint32_t)locator_length);
   inc_offset(uleb128_encoding_size((uint32_t)locator_length));
-  memcpy(m_output.get() + m_offset, buf, locator_length + 1);
+  memcpy(m_output + m_offset, buf, locator_length + 1);
   inc_offset(locator_length + 1);
 }
 
@@ -682,7 +690,7 @@ void DexOutput::generate_string_data(SortMode mode) {
     string_order = m_gtypes->get_dexstring_emitlist();
   }
   dex_string_id* stringids =
-      (dex_string_id*)(m_output.get() + hdr.string_ids_off);
+      (dex_string_id*)(m_output + hdr.string_ids_off);
 
   std::unordered_set<DexString*> type_names = m_gtypes->index_type_names();
   unsigned locator_size = 0;
@@ -726,7 +734,7 @@ void DexOutput::generate_string_data(SortMode mode) {
     // Emit the string itself
     TRACE(CUSTOMSORT, 3, "str emit %s", SHOW(str));
     stringids[idx].offset = m_offset;
-    str->encode(m_output.get() + m_offset);
+    str->encode(m_output + m_offset);
     inc_offset(str->get_entry_size());
     m_stats.num_strings++;
   }
@@ -811,7 +819,7 @@ void DexOutput::generate_type_data() {
       get_max_type_refs(m_min_sdk),
       dodx->type_to_idx().size() - get_max_type_refs(m_min_sdk));
 
-  dex_type_id* typeids = (dex_type_id*)(m_output.get() + hdr.type_ids_off);
+  dex_type_id* typeids = (dex_type_id*)(m_output + hdr.type_ids_off);
   for (auto& p : dodx->type_to_idx()) {
     auto t = p.first;
     auto idx = p.second;
@@ -832,7 +840,7 @@ void DexOutput::generate_typelist_data() {
     ++num_tls;
     align_output();
     m_tl_emit_offsets[tl] = m_offset;
-    int size = tl->encode(dodx, (uint32_t*)(m_output.get() + m_offset));
+    int size = tl->encode(dodx, (uint32_t*)(m_output + m_offset));
     inc_offset(size);
     m_stats.num_type_lists++;
   }
@@ -842,7 +850,7 @@ void DexOutput::generate_typelist_data() {
 }
 
 void DexOutput::generate_proto_data() {
-  auto protoids = (dex_proto_id*)(m_output.get() + hdr.proto_ids_off);
+  auto protoids = (dex_proto_id*)(m_output + hdr.proto_ids_off);
   for (auto& it : dodx->proto_to_idx()) {
     auto proto = it.first;
     auto idx = it.second;
@@ -854,7 +862,7 @@ void DexOutput::generate_proto_data() {
 }
 
 void DexOutput::generate_field_data() {
-  auto fieldids = (dex_field_id*)(m_output.get() + hdr.field_ids_off);
+  auto fieldids = (dex_field_id*)(m_output + hdr.field_ids_off);
   for (auto& it : dodx->field_to_idx()) {
     auto field = it.first;
     auto idx = it.second;
@@ -866,7 +874,7 @@ void DexOutput::generate_field_data() {
 }
 
 void DexOutput::generate_method_data() {
-  auto methodids = (dex_method_id*)(m_output.get() + hdr.method_ids_off);
+  auto methodids = (dex_method_id*)(m_output + hdr.method_ids_off);
   for (auto& it : dodx->method_to_idx()) {
     auto method = it.first;
     auto idx = it.second;
@@ -878,7 +886,7 @@ void DexOutput::generate_method_data() {
 }
 
 void DexOutput::generate_class_data() {
-  dex_class_def* cdefs = (dex_class_def*)(m_output.get() + hdr.class_defs_off);
+  dex_class_def* cdefs = (dex_class_def*)(m_output + hdr.class_defs_off);
   for (uint32_t i = 0; i < hdr.class_defs_size; i++) {
     m_stats.num_classes++;
     DexClass* clz = m_classes->at(i);
@@ -913,16 +921,16 @@ void DexOutput::generate_class_data_items() {
   dexcode_to_offset dco;
   uint32_t cdi_start = m_offset;
   for (auto& it : m_code_item_emits) {
-    uint32_t offset = (uint32_t)(((uint8_t*)it.code_item) - m_output.get());
+    uint32_t offset = (uint32_t)(((uint8_t*)it.code_item) - m_output);
     dco[it.code] = offset;
   }
-  dex_class_def* cdefs = (dex_class_def*)(m_output.get() + hdr.class_defs_off);
+  dex_class_def* cdefs = (dex_class_def*)(m_output + hdr.class_defs_off);
   uint32_t count = 0;
   for (uint32_t i = 0; i < hdr.class_defs_size; i++) {
     DexClass* clz = m_classes->at(i);
     if (!clz->has_class_data()) continue;
     /* No alignment constraints for this data */
-    int size = clz->encode(dodx, dco, m_output.get() + m_offset);
+    int size = clz->encode(dodx, dco, m_output + m_offset);
     cdefs[i].class_data_offset = m_offset;
     inc_offset(size);
     count += 1;
@@ -932,7 +940,11 @@ void DexOutput::generate_class_data_items() {
 
 static void sync_all(const Scope& scope) {
   constexpr bool serial = false; // for debugging
-  auto fn = [&](DexMethod* m, IRCode&) {
+  auto fn = [&](DexMethod* m) {
+    // Code which was never ballooned is synced without asking for the IR.
+    if (!m->is_balloon_pending() && m->get_code() == nullptr) {
+      return;
+    }
     if (serial) {
       TRACE(MTRANS, 2, "Syncing %s", SHOW(m));
     }
@@ -940,9 +952,9 @@ static void sync_all(const Scope& scope) {
   };
 
   if (serial) {
-    walk::code(scope, fn);
+    walk::methods(scope, fn);
   } else {
-    walk::parallel::code(scope, fn);
+    walk::parallel::methods(scope, fn);
   }
 }
 
@@ -1003,13 +1015,13 @@ void DexOutput::generate_code_items(const std::vector<SortMode>& mode) {
         "Undefined method in generate_code_items()\n\t prototype: %s\n",
         SHOW(meth));
     align_output();
-    int size = code->encode(dodx, (uint32_t*)(m_output.get() + m_offset));
+    int size = code->encode(dodx, (uint32_t*)(m_output + m_offset));
     check_method_instruction_size_limit(m_config_files, size, SHOW(meth));
     m_method_bytecode_offsets.emplace_back(meth->get_name()->c_str(), m_offset);
     m_code_item_emits.emplace_back(meth, code,
-                                   (dex_code_item*)(m_output.get() + m_offset));
+                                   (dex_code_item*)(m_output + m_offset));
     auto insns_size =
-        ((const dex_code_item*)(m_output.get() + m_offset))->insns_size;
+        ((const dex_code_item*)(m_output + m_offset))->insns_size;
     inc_offset(size);
     m_stats.num_instructions += code->get_instructions().size();
     m_stats.instruction_bytes += insns_size * 2;
@@ -1024,7 +1036,7 @@ void DexOutput::generate_callsite_data() {
       hdr.class_defs_off + hdr.class_defs_size * sizeof(dex_class_def);
 
   auto callsites = m_gtypes->get_dexcallsite_emitlist();
-  dex_callsite_id* dexcallsites = (dex_callsite_id*)(m_output.get() + offset);
+  dex_callsite_id* dexcallsites = (dex_callsite_id*)(m_output + offset);
   for (uint32_t i = 0; i < callsites.size(); i++) {
     m_stats.num_callsites++;
     DexCallSite* callsite = callsites.at(i);
@@ -1038,7 +1050,7 @@ void DexOutput::generate_methodhandle_data() {
                     hdr.class_defs_size * sizeof(dex_class_def) +
                     total_callsite_size;
   dex_methodhandle_id* dexmethodhandles =
-      (dex_methodhandle_id*)(m_output.get() + offset);
+      (dex_methodhandle_id*)(m_output + offset);
   for (auto it : dodx->methodhandle_to_idx()) {
     m_stats.num_methodhandles++;
     DexMethodHandle* methodhandle = it.first;
@@ -1091,7 +1103,7 @@ void DexOutput::generate_static_values() {
     if (enc_arrays.count(*deva)) {
       m_static_values[clz] = enc_arrays.at(*deva);
     } else {
-      uint8_t* output = m_output.get() + m_offset;
+      uint8_t* output = m_output + m_offset;
       uint8_t* outputsv = output;
       /* No alignment requirements */
       deva->encode(dodx, output);
@@ -1110,7 +1122,7 @@ void DexOutput::generate_static_values() {
       if (enc_arrays.count(eva)) {
         offset = m_call_site_items[callsite] = enc_arrays.at(eva);
       } else {
-        uint8_t* output = m_output.get() + m_offset;
+        uint8_t* output = m_output + m_offset;
         uint8_t* outputsv = output;
         eva.encode(dodx, output);
         enc_arrays.emplace(std::move(eva), m_offset);
@@ -1131,26 +1143,46 @@ static bool annotation_cmp(const DexAnnotationDirectory* a,
   return (a->viz_score() < b->viz_score());
 }
 
+namespace {
+
+// Annotations, annotation sets, set ref lists and directories are deduplicated
+// by their encoding. Hashing the encoded words is much cheaper than ordering
+// them.
+struct EncodingHash {
+  template <typename T>
+  size_t operator()(const std::vector<T>& encoding) const {
+    return boost::hash_range(encoding.begin(), encoding.end());
+  }
+};
+
+template <typename T>
+using EncodingOffsets =
+    std::unordered_map<std::vector<T>, uint32_t, EncodingHash>;
+
+} // namespace
+
 void DexOutput::unique_annotations(annomap_t& annomap,
                                    std::vector<DexAnnotation*>& annolist) {
   int annocnt = 0;
   uint32_t mentry_offset = m_offset;
-  std::map<std::vector<uint8_t>, uint32_t> annotation_byte_offsets;
+  EncodingOffsets<uint8_t> annotation_byte_offsets;
+  annotation_byte_offsets.reserve(annolist.size());
   for (auto anno : annolist) {
     if (annomap.count(anno)) continue;
     std::vector<uint8_t> annotation_bytes;
     anno->vencode(dodx, annotation_bytes);
-    if (annotation_byte_offsets.count(annotation_bytes)) {
-      annomap[anno] = annotation_byte_offsets[annotation_bytes];
+    auto it = annotation_byte_offsets.find(annotation_bytes);
+    if (it != annotation_byte_offsets.end()) {
+      annomap[anno] = it->second;
       continue;
     }
     /* Insert new annotation in tracking structs */
-    annotation_byte_offsets[annotation_bytes] = m_offset;
     annomap[anno] = m_offset;
     /* Not a dupe, encode... */
-    uint8_t* annoout = (uint8_t*)(m_output.get() + m_offset);
+    uint8_t* annoout = (uint8_t*)(m_output + m_offset);
     memcpy(annoout, &annotation_bytes[0], annotation_bytes.size());
     inc_offset(annotation_bytes.size());
+    annotation_byte_offsets.emplace(std::move(annotation_bytes), annomap[anno]);
     annocnt++;
   }
   if (annocnt) {
@@ -1165,23 +1197,25 @@ void DexOutput::unique_asets(annomap_t& annomap,
                              std::vector<DexAnnotationSet*>& asetlist) {
   int asetcnt = 0;
   uint32_t mentry_offset = align(m_offset);
-  std::map<std::vector<uint32_t>, uint32_t> aset_offsets;
+  EncodingOffsets<uint32_t> aset_offsets;
+  aset_offsets.reserve(asetlist.size());
   for (auto aset : asetlist) {
     if (asetmap.count(aset)) continue;
     std::vector<uint32_t> aset_bytes;
     aset->vencode(dodx, aset_bytes, annomap);
-    if (aset_offsets.count(aset_bytes)) {
-      asetmap[aset] = aset_offsets[aset_bytes];
+    auto it = aset_offsets.find(aset_bytes);
+    if (it != aset_offsets.end()) {
+      asetmap[aset] = it->second;
       continue;
     }
     /* Insert new aset in tracking structs */
     align_output();
-    aset_offsets[aset_bytes] = m_offset;
     asetmap[aset] = m_offset;
     /* Not a dupe, encode... */
-    uint8_t* asetout = (uint8_t*)(m_output.get() + m_offset);
+    uint8_t* asetout = (uint8_t*)(m_output + m_offset);
     memcpy(asetout, &aset_bytes[0], aset_bytes.size() * sizeof(uint32_t));
     inc_offset(aset_bytes.size() * sizeof(uint32_t));
+    aset_offsets.emplace(std::move(aset_bytes), asetmap[aset]);
     asetcnt++;
   }
   if (asetcnt) {
@@ -1195,7 +1229,8 @@ void DexOutput::unique_xrefs(asetmap_t& asetmap,
                              std::vector<ParamAnnotations*>& xreflist) {
   int xrefcnt = 0;
   uint32_t mentry_offset = align(m_offset);
-  std::map<std::vector<uint32_t>, uint32_t> xref_offsets;
+  EncodingOffsets<uint32_t> xref_offsets;
+  xref_offsets.reserve(xreflist.size());
   for (auto xref : xreflist) {
     if (xrefmap.count(xref)) continue;
     std::vector<uint32_t> xref_bytes;
@@ -1206,18 +1241,19 @@ void DexOutput::unique_xrefs(asetmap_t& asetmap,
                         das, SHOW(das));
       xref_bytes.push_back(asetmap[das]);
     }
-    if (xref_offsets.count(xref_bytes)) {
-      xrefmap[xref] = xref_offsets[xref_bytes];
+    auto it = xref_offsets.find(xref_bytes);
+    if (it != xref_offsets.end()) {
+      xrefmap[xref] = it->second;
       continue;
     }
     /* Insert new xref in tracking structs */
     align_output();
-    xref_offsets[xref_bytes] = m_offset;
     xrefmap[xref] = m_offset;
     /* Not a dupe, encode... */
-    uint8_t* xrefout = (uint8_t*)(m_output.get() + m_offset);
+    uint8_t* xrefout = (uint8_t*)(m_output + m_offset);
     memcpy(xrefout, &xref_bytes[0], xref_bytes.size() * sizeof(uint32_t));
     inc_offset(xref_bytes.size() * sizeof(uint32_t));
+    xref_offsets.emplace(std::move(xref_bytes), xrefmap[xref]);
     xrefcnt++;
   }
   if (xrefcnt) {
@@ -1232,23 +1268,25 @@ void DexOutput::unique_adirs(asetmap_t& asetmap,
                              std::vector<DexAnnotationDirectory*>& adirlist) {
   int adircnt = 0;
   uint32_t mentry_offset = align(m_offset);
-  std::map<std::vector<uint32_t>, uint32_t> adir_offsets;
+  EncodingOffsets<uint32_t> adir_offsets;
+  adir_offsets.reserve(adirlist.size());
   for (auto adir : adirlist) {
     if (adirmap.count(adir)) continue;
     std::vector<uint32_t> adir_bytes;
     adir->vencode(dodx, adir_bytes, xrefmap, asetmap);
-    if (adir_offsets.count(adir_bytes)) {
-      adirmap[adir] = adir_offsets[adir_bytes];
+    auto it = adir_offsets.find(adir_bytes);
+    if (it != adir_offsets.end()) {
+      adirmap[adir] = it->second;
       continue;
     }
     /* Insert new adir in tracking structs */
     align_output();
-    adir_offsets[adir_bytes] = m_offset;
     adirmap[adir] = m_offset;
     /* Not a dupe, encode... */
-    uint8_t* adirout = (uint8_t*)(m_output.get() + m_offset);
+    uint8_t* adirout = (uint8_t*)(m_output + m_offset);
     memcpy(adirout, &adir_bytes[0], adir_bytes.size() * sizeof(uint32_t));
     inc_offset(adir_bytes.size() * sizeof(uint32_t));
+    adir_offsets.emplace(std::move(adir_bytes), adirmap[adir]);
     adircnt++;
   }
   if (adircnt) {
@@ -1270,7 +1308,7 @@ void DexOutput::generate_annotations() {
   int xrefsize = 0;
   int annodirsize = 0;
   int xrefcnt = 0;
-  std::map<DexAnnotationDirectory*, int> ad_to_classnum;
+  std::unordered_map<DexAnnotationDirectory*, int> ad_to_classnum;
   annomap_t annomap;
   asetmap_t asetmap;
   xrefmap_t xrefmap;
@@ -1303,7 +1341,7 @@ void DexOutput::generate_annotations() {
   for (auto ad : lad) {
     int class_num = ad_to_classnum[ad];
     dex_class_def* cdefs =
-        (dex_class_def*)(m_output.get() + hdr.class_defs_off);
+        (dex_class_def*)(m_output + hdr.class_defs_off);
     cdefs[class_num].annotations_off = adirmap[ad];
     delete ad;
   }
@@ -2249,7 +2287,7 @@ void DexOutput::generate_debug_items() {
         m_code_item_emits,
         *m_iodi_metadata,
         m_debug_info_kind == DebugInfoKind::InstructionOffsetsLayered,
-        m_output.get(),
+        m_output,
         m_offset,
         &dbgcount,
         m_code_debug_lines));
@@ -2267,7 +2305,7 @@ void DexOutput::generate_debug_items() {
       dbgcount++;
       size_t num_params = it.method->get_proto()->get_args()->size();
       inc_offset(emit_debug_info(dodx, emit_positions, dbg, dc, dci,
-                                 m_pos_mapper, m_output.get(), m_offset,
+                                 m_pos_mapper, m_output, m_offset,
                                  num_params, m_code_debug_lines));
     }
   }
@@ -2281,7 +2319,7 @@ void DexOutput::generate_debug_items() {
 
 void DexOutput::generate_map() {
   align_output();
-  uint32_t* mapout = (uint32_t*)(m_output.get() + m_offset);
+  uint32_t* mapout = (uint32_t*)(m_output + m_offset);
   hdr.map_off = m_offset;
   insert_map_item(TYPE_MAP_LIST, 1, m_offset,
                   sizeof(uint32_t) + m_map_items.size() * sizeof(dex_map_item));
@@ -2299,7 +2337,34 @@ void DexOutput::generate_map() {
  * or vice versea. This fixup ensures that all const string opcodes agree
  * with the jumbo-ness of their stridx.
  */
+static bool is_jumbo_string(const DexInstruction* insn,
+                            const DexOutputIdx* dodx) {
+  auto str = static_cast<const DexOpcodeString*>(insn)->get_string();
+  return (dodx->stringidx(str) >> 16) != 0;
+}
+
 static void fix_method_jumbos(DexMethod* method, const DexOutputIdx* dodx) {
+  if (method->is_balloon_pending()) {
+    // Code which was never ballooned is emitted as loaded, unless a string
+    // index crossed the jumbo boundary. That changes the instruction size, so
+    // branches need to be laid out again from IR.
+    bool needs_fixing = false;
+    for (auto* insn : method->get_dex_code()->get_instructions()) {
+      auto op = insn->opcode();
+      if (op != DOPCODE_CONST_STRING && op != DOPCODE_CONST_STRING_JUMBO) {
+        continue;
+      }
+      if (is_jumbo_string(insn, dodx) != (op == DOPCODE_CONST_STRING_JUMBO)) {
+        needs_fixing = true;
+        break;
+      }
+    }
+    if (!needs_fixing) {
+      return;
+    }
+    instruction_lowering::lower(method);
+  }
+
   auto code = method->get_code();
   if (!code) return; // nothing to do for native methods
 
@@ -2313,9 +2378,7 @@ static void fix_method_jumbos(DexMethod* method, const DexOutputIdx* dodx) {
       continue;
     }
 
-    auto str = static_cast<DexOpcodeString*>(insn)->get_string();
-    uint32_t stridx = dodx->stringidx(str);
-    bool jumbo = ((stridx >> 16) != 0);
+    bool jumbo = is_jumbo_string(insn, dodx);
 
     if (jumbo) {
       insn->set_opcode(DOPCODE_CONST_STRING_JUMBO);
@@ -2326,7 +2389,9 @@ static void fix_method_jumbos(DexMethod* method, const DexOutputIdx* dodx) {
 }
 
 static void fix_jumbos(DexClasses* classes, DexOutputIdx* dodx) {
-  walk::methods(*classes, [&](DexMethod* m) { fix_method_jumbos(m, dodx); });
+  // Methods are fixed independently, and the output index is only read.
+  walk::parallel::methods(*classes,
+                          [&](DexMethod* m) { fix_method_jumbos(m, dodx); });
 }
 
 void DexOutput::init_header_offsets(const std::string& dex_magic) {
@@ -2406,18 +2471,16 @@ void DexOutput::finalize_header() {
   hdr.file_size = m_offset;
   int skip;
   skip = sizeof(hdr.magic) + sizeof(hdr.checksum) + sizeof(hdr.signature);
-  memcpy(m_output.get(), &hdr, sizeof(hdr));
+  memcpy(m_output, &hdr, sizeof(hdr));
   Sha1Context context;
   sha1_init(&context);
-  sha1_update(&context, m_output.get() + skip, hdr.file_size - skip);
+  sha1_update(&context, m_output + skip, hdr.file_size - skip);
   sha1_final(hdr.signature, &context);
-  memcpy(m_output.get(), &hdr, sizeof(hdr));
-  uint32_t adler = (uint32_t)adler32(0L, Z_NULL, 0);
+  memcpy(m_output, &hdr, sizeof(hdr));
   skip = sizeof(hdr.magic) + sizeof(hdr.checksum);
-  adler = (uint32_t)adler32(adler, (const Bytef*)(m_output.get() + skip),
-                            hdr.file_size - skip);
-  hdr.checksum = adler;
-  memcpy(m_output.get(), &hdr, sizeof(hdr));
+  hdr.checksum =
+      adler32_update(kAdler32Init, m_output + skip, hdr.file_size - skip);
+  memcpy(m_output, &hdr, sizeof(hdr));
 }
 
 namespace {
@@ -2493,7 +2556,7 @@ void write_method_mapping(const std::string& filename,
     auto deobf_class = [&] {
       if (cls) {
         auto deobname = cls->get_deobfuscated_name();
-        if (!deobname.empty()) return deobname;
+        if (!deobname.empty()) return std::string(deobname);
       }
       return show(typecls);
     }();
@@ -2516,7 +2579,7 @@ void write_method_mapping(const std::string& filename,
       if (resolved_method->is_def()) {
         auto deobfname =
             static_cast<DexMethod*>(resolved_method)->get_deobfuscated_name();
-        if (!deobfname.empty()) return deobfname;
+        if (!deobfname.empty()) return std::string(deobfname);
       }
       return show(resolved_method);
     }();
@@ -2551,7 +2614,7 @@ void write_class_mapping(const std::string& filename,
     auto deobf_class = [&] {
       if (cls) {
         auto deobname = cls->get_deobfuscated_name();
-        if (!deobname.empty()) return deobname;
+        if (!deobname.empty()) return std::string(deobname);
       }
       return show(cls);
     }();
@@ -2601,7 +2664,7 @@ void write_pg_mapping(
   auto deobf_class = [&](DexClass* cls) {
     if (cls) {
       auto deobname = cls->get_deobfuscated_name();
-      if (!deobname.empty()) return deobname;
+      if (!deobname.empty()) return std::string(deobname);
     }
     return show(cls);
   };
@@ -2811,6 +2874,99 @@ void GatheredTypes::set_legacy_order(bool legacy_order) {
   m_legacy_order = legacy_order;
 }
 
+namespace {
+
+constexpr uint32_t kPageSize = 4096;
+
+// The distinct pages of a dex touched by a number of byte ranges.
+class PageSet {
+ public:
+  void touch(uint32_t offset, uint32_t size) {
+    uint32_t last = (offset + std::max<uint32_t>(size, 1) - 1) / kPageSize;
+    for (uint32_t page = offset / kPageSize; page <= last; ++page) {
+      m_pages.insert(page);
+    }
+  }
+
+  void add(const PageSet& other) {
+    m_pages.insert(other.m_pages.begin(), other.m_pages.end());
+  }
+
+  size_t size() const { return m_pages.size(); }
+
+ private:
+  std::unordered_set<uint32_t> m_pages;
+};
+
+} // namespace
+
+/*
+ * Estimates what the layout of this dex does to cold start page faults, so that
+ * orderings can be tuned offline against the resulting stats. The methods in
+ * the cold start method profile touch the pages holding their code items, the
+ * start of their debug info, the class defs of their classes, and the string
+ * data of the names of these classes and of the strings the methods load.
+ */
+void DexOutput::simulate_startup_pages(ConfigFiles& conf) {
+  const auto& cold_start =
+      conf.get_method_profiles().method_stats(method_profiles::COLD_START);
+  if (cold_start.empty()) {
+    return;
+  }
+
+  std::unordered_map<const DexType*, uint32_t> class_def_indices;
+  for (uint32_t i = 0; i < hdr.class_defs_size; i++) {
+    class_def_indices.emplace(m_classes->at(i)->get_type(), i);
+  }
+  auto* string_ids = (const dex_string_id*)(m_output + hdr.string_ids_off);
+  PageSet code, strings, class_defs, debug_info;
+  auto touch_string = [&](DexString* str) {
+    strings.touch(string_ids[dodx->stringidx(str)].offset,
+                  str->get_entry_size());
+  };
+  std::unordered_set<const DexType*> startup_classes;
+  for (const auto& emit : m_code_item_emits) {
+    if (!cold_start.count(emit.method)) {
+      continue;
+    }
+    m_stats.num_startup_methods++;
+    auto* code_item = emit.code_item;
+    code.touch((uint8_t*)code_item - m_output,
+               sizeof(dex_code_item) + code_item->insns_size * 2);
+    if (code_item->debug_info_off != 0) {
+      debug_info.touch(code_item->debug_info_off, 1);
+    }
+    for (auto* insn : emit.code->get_instructions()) {
+      if (insn->has_string()) {
+        touch_string(static_cast<DexOpcodeString*>(insn)->get_string());
+      }
+    }
+    auto* type = emit.method->get_class();
+    if (startup_classes.insert(type).second) {
+      class_defs.touch(hdr.class_defs_off + class_def_indices.at(type) *
+                                                sizeof(dex_class_def),
+                       sizeof(dex_class_def));
+      touch_string(type->get_name());
+    }
+  }
+
+  m_stats.startup_code_pages = code.size();
+  m_stats.startup_string_data_pages = strings.size();
+  m_stats.startup_class_def_pages = class_defs.size();
+  m_stats.startup_debug_info_pages = debug_info.size();
+  PageSet all;
+  for (const auto* pages : {&code, &strings, &class_defs, &debug_info}) {
+    all.add(*pages);
+  }
+  m_stats.startup_pages = all.size();
+  TRACE(OPUT, 2,
+        "[startup pages] %d methods touch %d pages: %d code, %d string data, "
+        "%d class defs, %d debug info",
+        m_stats.num_startup_methods, m_stats.startup_pages,
+        m_stats.startup_code_pages, m_stats.startup_string_data_pages,
+        m_stats.startup_class_def_pages, m_stats.startup_debug_info_pages);
+}
+
 void DexOutput::prepare(SortMode string_mode,
                         const std::vector<SortMode>& code_mode,
                         ConfigFiles& conf,
@@ -2843,17 +2999,34 @@ void DexOutput::prepare(SortMode string_mode,
   generate_debug_items();
   generate_map();
   finalize_header();
+  simulate_startup_pages(conf);
   compute_method_to_id_map(dodx, m_classes, hdr.signature, m_method_to_id);
 }
 
 void DexOutput::write() {
+  if (m_output_file) {
+    // Unmap the file before cutting it down to the size of the dex.
+    m_output_file.reset();
+    m_output = nullptr;
+    boost::system::error_code ec;
+    boost::filesystem::resize_file(m_filename, m_offset, ec);
+    if (ec) {
+      fprintf(stderr, "Error writing dex %s: %s\n", m_filename,
+              ec.message().c_str());
+      return;
+    }
+    m_stats.num_bytes = m_offset;
+    write_symbol_files();
+    return;
+  }
+
   struct stat st;
   int fd = open(m_filename, O_CREAT | O_TRUNC | O_WRONLY | O_BINARY, 0660);
   if (fd == -1) {
     perror("Error writing dex");
     return;
   }
-  ::write(fd, m_output.get(), m_offset);
+  ::write(fd, m_output, m_offset);
   if (0 == fstat(fd, &st)) {
     m_stats.num_bytes = st.st_size;
   }
@@ -2944,7 +3117,7 @@ static SortMode make_sort_bytecode(const std::string& sort_bytecode) {
   }
 }
 
-dex_stats_t write_classes_to_dex(
+std::unique_ptr<DexOutput> prepare_classes_for_dex(
     const RedexOptions& redex_options,
     const std::string& filename,
     DexClasses* classes,
@@ -3000,17 +3173,45 @@ dex_stats_t write_classes_to_dex(
 
   TRACE(OPUT, 2, "[write_classes_to_dex][filename] %s", filename.c_str());
 
-  DexOutput dout(filename.c_str(), classes, locator_index, normal_primary_dex,
-                 store_number, dex_number, redex_options.debug_info_kind,
-                 iodi_metadata, conf, pos_mapper, method_to_id,
-                 code_debug_lines, post_lowering, min_sdk);
+  auto dout = std::make_unique<DexOutput>(
+      filename.c_str(), classes, locator_index, normal_primary_dex,
+      store_number, dex_number, redex_options.debug_info_kind, iodi_metadata,
+      conf, pos_mapper, method_to_id, code_debug_lines, post_lowering, min_sdk);
 
-  dout.prepare(string_sort_mode, code_sort_mode, conf, dex_magic);
+  dout->prepare(string_sort_mode, code_sort_mode, conf, dex_magic);
+  return dout;
+}
+
+dex_stats_t finish_classes_for_dex(DexOutput& dout) {
   dout.write();
   dout.metrics();
   return dout.m_stats;
 }
 
+dex_stats_t write_classes_to_dex(
+    const RedexOptions& redex_options,
+    const std::string& filename,
+    DexClasses* classes,
+    LocatorIndex* locator_index,
+    size_t store_number,
+    size_t dex_number,
+    ConfigFiles& conf,
+    PositionMapper* pos_mapper,
+    std::unordered_map<DexMethod*, uint64_t>* method_to_id,
+    std::unordered_map<DexCode*, std::vector<DebugLineItem>>* code_debug_lines,
+    IODIMetadata* iodi_metadata,
+    const std::string& dex_magic,
+    PostLowering* post_lowering,
+    int min_sdk,
+    bool disable_method_similarity_order) {
+  auto dout = prepare_classes_for_dex(
+      redex_options, filename, classes, locator_index, store_number,
+      dex_number, conf, pos_mapper, method_to_id, code_debug_lines,
+      iodi_metadata, dex_magic, post_lowering, min_sdk,
+      disable_method_similarity_order);
+  return finish_classes_for_dex(*dout);
+}
+
 LocatorIndex make_locator_index(DexStoresVector& stores) {
   LocatorIndex index;
 
@@ -3040,7 +3241,7 @@ LocatorIndex make_locator_index(DexStoresVector& stores) {
                             .second;
         // We shouldn't see the same class defined in two dexen
         always_assert_log(inserted, "This was already inserted %s\n",
-                          (*clsit)->get_deobfuscated_name().c_str());
+                          (*clsit)->get_deobfuscated_name_copy().c_str());
         (void)inserted; // Shut up compiler when defined(NDEBUG)
       }
     }
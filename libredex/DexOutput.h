@@ -20,6 +20,7 @@
 #include "Pass.h"
 #include "PostLowering.h"
 #include "ProguardMap.h"
+#include "RedexMappedFile.h"
 #include "RedexOptions.h"
 #include "Trace.h"
 
@@ -280,10 +281,10 @@ std::vector<DexString*> GatheredTypes::get_dexstring_emitlist(T cmp) {
   return strlist;
 }
 
-using annomap_t = std::map<DexAnnotation*, uint32_t>;
-using asetmap_t = std::map<DexAnnotationSet*, uint32_t>;
-using xrefmap_t = std::map<ParamAnnotations*, uint32_t>;
-using adirmap_t = std::map<DexAnnotationDirectory*, uint32_t>;
+using annomap_t = std::unordered_map<DexAnnotation*, uint32_t>;
+using asetmap_t = std::unordered_map<DexAnnotationSet*, uint32_t>;
+using xrefmap_t = std::unordered_map<ParamAnnotations*, uint32_t>;
+using adirmap_t = std::unordered_map<DexAnnotationDirectory*, uint32_t>;
 
 struct CodeItemEmit {
   DexMethod* method;
@@ -314,7 +315,11 @@ class DexOutput {
   DexOutputIdx* dodx;
   GatheredTypes* m_gtypes;
   const size_t m_output_size;
-  std::unique_ptr<uint8_t[]> m_output;
+  // The dex is laid out in place in the mapped output file, or in a heap
+  // buffer when there is no output file.
+  std::unique_ptr<RedexMappedFile> m_output_file;
+  std::unique_ptr<uint8_t[]> m_output_buffer;
+  uint8_t* m_output;
   uint32_t m_offset;
   const char* m_filename;
   size_t m_store_number;
@@ -381,6 +386,7 @@ class DexOutput {
   void finalize_header();
   void init_header_offsets(const std::string& dex_magic);
   void write_symbol_files();
+  void simulate_startup_pages(ConfigFiles& conf);
   uint32_t align(uint32_t offset) { return (offset + 3) & ~3; }
   void align_output() { m_offset = align(m_offset); }
   void emit_locator(Locator locator);
@@ -419,3 +425,31 @@ class DexOutput {
                                                   int size,
                                                   const char* method_name);
 };
+
+/*
+ * The two halves of write_classes_to_dex. prepare_classes_for_dex lays out a
+ * complete dex in memory; it only touches the given method_to_id and
+ * code_debug_lines maps, so different dexes may be prepared concurrently as
+ * long as the PositionMapper does not hand out lines (NoopPositionMapper) and
+ * no IODI metadata or PostLowering is involved. finish_classes_for_dex writes
+ * the dex and its symbol files and gathers the stats; it must be called in
+ * dex order to keep the output deterministic.
+ */
+std::unique_ptr<DexOutput> prepare_classes_for_dex(
+    const RedexOptions&,
+    const std::string& filename,
+    DexClasses* classes,
+    LocatorIndex* locator_index /* nullable */,
+    size_t store_number,
+    size_t dex_number,
+    ConfigFiles& conf,
+    PositionMapper* pos_mapper,
+    std::unordered_map<DexMethod*, uint64_t>* method_to_id,
+    std::unordered_map<DexCode*, std::vector<DebugLineItem>>* code_debug_lines,
+    IODIMetadata* iodi_metadata,
+    const std::string& dex_magic,
+    PostLowering* post_lowering = nullptr,
+    int min_sdk = 0,
+    bool disable_method_similarity_order = false);
+
+dex_stats_t finish_classes_for_dex(DexOutput& dout);
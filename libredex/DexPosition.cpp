@@ -108,20 +108,51 @@ std::unique_ptr<DexPosition> PositionPatternSwitchManager::make_switch_position(
                                        switch_id);
 }
 
+DexPosition* RealPositionMapper::canonicalize(DexPosition* pos) {
+  auto it = m_canonical_positions.find(pos);
+  if (it != m_canonical_positions.end()) {
+    return it->second;
+  }
+  auto parent = pos->parent == nullptr ? nullptr : canonicalize(pos->parent);
+  CanonicalKey key{pos->method, pos->file, pos->line, parent};
+  auto canonical_pos = m_positions_by_key.emplace(key, pos).first->second;
+  m_canonical_positions.emplace(pos, canonical_pos);
+  if (canonical_pos == pos && pos->parent != parent) {
+    // The first position of its kind, but not with a canonical parent. We
+    // don't rewrite positions we don't own, so make an equal one.
+    canonical_pos = new DexPosition(*pos);
+    canonical_pos->parent = parent;
+    m_owned_auxiliary_positions.emplace_back(canonical_pos);
+    m_positions_by_key[key] = canonical_pos;
+    m_canonical_positions[pos] = canonical_pos;
+    m_canonical_positions.emplace(canonical_pos, canonical_pos);
+  }
+  return canonical_pos;
+}
+
+uint32_t RealPositionMapper::add_line(DexPosition* canonical_pos) {
+  auto idx = m_positions.size();
+  m_positions.emplace_back(canonical_pos);
+  m_pos_line_map[canonical_pos] = idx;
+  return idx + 1;
+}
+
 void RealPositionMapper::register_position(DexPosition* pos) {
   always_assert(pos->file);
-  m_pos_line_map[pos] = -1;
+  m_pos_line_map.emplace(canonicalize(pos), -1);
 }
 
 uint32_t RealPositionMapper::get_line(DexPosition* pos) {
-  return m_pos_line_map.at(pos) + 1;
+  return m_pos_line_map.at(canonicalize(pos)) + 1;
 }
 
 uint32_t RealPositionMapper::position_to_line(DexPosition* pos) {
-  auto idx = m_positions.size();
-  m_positions.emplace_back(pos);
-  m_pos_line_map[pos] = idx;
-  return get_line(pos);
+  auto canonical_pos = canonicalize(pos);
+  auto it = m_pos_line_map.find(canonical_pos);
+  if (it != m_pos_line_map.end() && it->second != -1) {
+    return it->second + 1;
+  }
+  return add_line(canonical_pos);
 }
 
 void RealPositionMapper::write_map() {
@@ -202,15 +233,14 @@ void RealPositionMapper::process_pattern_switch_positions() {
       if (!reachable_patterns.count(c.pattern_id)) {
         continue;
       }
-      for (auto pos = c.position; pos && pos->file; pos = pos->parent) {
+      for (auto pos = canonicalize(c.position); pos && pos->file;
+           pos = pos->parent) {
         auto it = m_pos_line_map.find(pos);
         if (it != m_pos_line_map.end()) {
           always_assert(it->second != -1);
           break;
         }
-        auto idx = m_positions.size();
-        m_positions.emplace_back(pos);
-        m_pos_line_map.emplace(pos, idx);
+        add_line(pos);
       }
       reachable_cases.push_back(c);
     }
@@ -226,9 +256,7 @@ void RealPositionMapper::process_pattern_switch_positions() {
       auto count_pos = new DexPosition(count_string, unknown_source_string,
                                        reachable_cases.size());
       m_owned_auxiliary_positions.emplace_back(count_pos);
-      auto idx = m_positions.size();
-      m_positions.emplace_back(count_pos);
-      m_pos_line_map[count_pos] = idx;
+      add_line(count_pos);
     }
     // Then we emit consecutive list of cases
     for (auto& c : reachable_cases) {
@@ -237,10 +265,8 @@ void RealPositionMapper::process_pattern_switch_positions() {
       m_owned_auxiliary_positions.emplace_back(case_pos);
       always_assert(c.position);
       always_assert(c.position->file);
-      case_pos->parent = c.position;
-      auto idx = m_positions.size();
-      m_positions.emplace_back(case_pos);
-      m_pos_line_map[case_pos] = idx;
+      case_pos->parent = canonicalize(c.position);
+      add_line(case_pos);
     }
   }
 
@@ -293,7 +319,8 @@ void RealPositionMapper::write_map_v2() {
    * string_length (4 bytes)
    * char[string_length]
    */
-  std::ostringstream pos_out;
+  std::vector<uint32_t> pos_out;
+  pos_out.reserve(m_positions.size() * 5);
   std::unordered_map<std::string, uint32_t> string_ids;
   std::vector<std::string> string_pool;
 
@@ -306,6 +333,39 @@ void RealPositionMapper::write_map_v2() {
     return it->second;
   };
 
+  // Positions vastly outnumber the methods and files they refer to, so only
+  // split up and intern the strings of each method and file once. DexStrings
+  // are unique, so they can serve as keys.
+  std::unordered_map<const DexString*, std::pair<uint32_t, uint32_t>>
+      method_ids;
+  auto ids_of_method = [&](const DexString* method) {
+    auto it = method_ids.find(method);
+    if (it != method_ids.end()) {
+      return it->second;
+    }
+    // of the form "class_name.method_name:(arg_types)return_type"
+    const auto& full_method_name = method->str();
+    // strip out the args and return type
+    auto qualified_method_name =
+        full_method_name.substr(0, full_method_name.find(':'));
+    auto class_name = java_names::internal_to_external(std::string(
+        qualified_method_name.substr(0, qualified_method_name.rfind('.'))));
+    auto method_name = std::string(
+        qualified_method_name.substr(qualified_method_name.rfind('.') + 1));
+    auto class_id = id_of_string(class_name);
+    auto method_id = id_of_string(method_name);
+    return method_ids.emplace(method, std::make_pair(class_id, method_id))
+        .first->second;
+  };
+  std::unordered_map<const DexString*, uint32_t> file_ids;
+  auto id_of_file = [&](const DexString* file) {
+    auto it = file_ids.find(file);
+    if (it == file_ids.end()) {
+      it = file_ids.emplace(file, id_of_string(file->str_copy())).first;
+    }
+    return it->second;
+  };
+
   for (auto pos : m_positions) {
     uint32_t parent_line = 0;
     try {
@@ -314,23 +374,12 @@ void RealPositionMapper::write_map_v2() {
       std::cerr << "Parent position " << show(pos->parent) << " of "
                 << show(pos) << " was not registered" << std::endl;
     }
-    // of the form "class_name.method_name:(arg_types)return_type"
-    const auto& full_method_name = pos->method->str();
-    // strip out the args and return type
-    auto qualified_method_name =
-        full_method_name.substr(0, full_method_name.find(':'));
-    auto class_name = java_names::internal_to_external(
-        qualified_method_name.substr(0, qualified_method_name.rfind('.')));
-    auto method_name =
-        qualified_method_name.substr(qualified_method_name.rfind('.') + 1);
-    auto class_id = id_of_string(class_name);
-    auto method_id = id_of_string(method_name);
-    auto file_id = id_of_string(pos->file->str());
-    pos_out.write((const char*)&class_id, sizeof(class_id));
-    pos_out.write((const char*)&method_id, sizeof(method_id));
-    pos_out.write((const char*)&file_id, sizeof(file_id));
-    pos_out.write((const char*)&pos->line, sizeof(pos->line));
-    pos_out.write((const char*)&parent_line, sizeof(parent_line));
+    auto method_ids_of_pos = ids_of_method(pos->method);
+    pos_out.push_back(method_ids_of_pos.first);
+    pos_out.push_back(method_ids_of_pos.second);
+    pos_out.push_back(id_of_file(pos->file));
+    pos_out.push_back(pos->line);
+    pos_out.push_back(parent_line);
   }
 
   std::ofstream ofs(m_filename_v2.c_str(),
@@ -348,7 +397,7 @@ void RealPositionMapper::write_map_v2() {
   }
   uint32_t pos_count = m_positions.size();
   ofs.write((const char*)&pos_count, sizeof(pos_count));
-  ofs << pos_out.str();
+  ofs.write((const char*)pos_out.data(), pos_out.size() * sizeof(uint32_t));
 }
 
 PositionMapper* PositionMapper::make(const std::string& map_filename_v2) {
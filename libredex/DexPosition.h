@@ -17,6 +17,8 @@
 #include <utility>
 #include <vector>
 
+#include "SlabAllocator.h"
+
 class DexClass;
 class DexMethod;
 class DexString;
@@ -32,6 +34,14 @@ struct DexPosition final {
   explicit DexPosition(uint32_t line);
   DexPosition(DexString* method, DexString* file, uint32_t line);
 
+  // Allocated from slabs, see SlabAllocator.h.
+  static void* operator new(size_t size) {
+    return slab_allocator::allocate(size);
+  }
+  static void operator delete(void* ptr, size_t size) {
+    slab_allocator::deallocate(ptr, size);
+  }
+
   void bind(DexString* method_, DexString* file_);
   bool operator==(const DexPosition&) const;
 
@@ -153,11 +163,43 @@ class PositionMapper {
  * position can be found.
  */
 class RealPositionMapper : public PositionMapper {
+  // Inlining clones the positions of a callee, with new parents, into each of
+  // its callers, so many registered positions are equal by value. They are
+  // all mapped to a single canonical position, and thus a single line of the
+  // map. Canonical positions have canonical parents, so that they can be
+  // keyed without walking the whole parent chain.
+  struct CanonicalKey {
+    DexString* method;
+    DexString* file;
+    uint32_t line;
+    DexPosition* parent;
+    bool operator==(const CanonicalKey& that) const {
+      return method == that.method && file == that.file &&
+             line == that.line && parent == that.parent;
+    }
+  };
+  struct CanonicalKeyHasher {
+    size_t operator()(const CanonicalKey& key) const {
+      size_t seed = 0;
+      boost::hash_combine(seed, key.method);
+      boost::hash_combine(seed, key.file);
+      boost::hash_combine(seed, key.line);
+      boost::hash_combine(seed, key.parent);
+      return seed;
+    }
+  };
+
   std::string m_filename_v2;
   std::vector<DexPosition*> m_positions;
+  // Keyed by canonical positions only.
   std::unordered_map<DexPosition*, int64_t> m_pos_line_map;
+  std::unordered_map<DexPosition*, DexPosition*> m_canonical_positions;
+  std::unordered_map<CanonicalKey, DexPosition*, CanonicalKeyHasher>
+      m_positions_by_key;
   std::vector<std::unique_ptr<DexPosition>> m_owned_auxiliary_positions;
 
+  DexPosition* canonicalize(DexPosition*);
+  uint32_t add_line(DexPosition* canonical_pos);
   void process_pattern_switch_positions();
 
  protected:
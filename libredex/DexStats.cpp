@@ -76,5 +76,12 @@ dex_stats_t& operator+=(dex_stats_t& lhs, const dex_stats_t& rhs) {
   lhs.annotations_directory_count += rhs.annotations_directory_count;
   lhs.annotations_directory_bytes += rhs.annotations_directory_bytes;
 
+  lhs.num_startup_methods += rhs.num_startup_methods;
+  lhs.startup_code_pages += rhs.startup_code_pages;
+  lhs.startup_string_data_pages += rhs.startup_string_data_pages;
+  lhs.startup_class_def_pages += rhs.startup_class_def_pages;
+  lhs.startup_debug_info_pages += rhs.startup_debug_info_pages;
+  lhs.startup_pages += rhs.startup_pages;
+
   return lhs;
 }
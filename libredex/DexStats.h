@@ -105,6 +105,15 @@ struct dex_stats_t {
 
   int annotations_directory_count = 0;
   int annotations_directory_bytes = 0;
+
+  /* Distinct pages touched during cold start, as simulated from the method
+   * profiles. See DexOutput::simulate_startup_pages. */
+  int num_startup_methods = 0;
+  int startup_code_pages = 0;
+  int startup_string_data_pages = 0;
+  int startup_class_def_pages = 0;
+  int startup_debug_info_pages = 0;
+  int startup_pages = 0;
 };
 
 dex_stats_t& operator+=(dex_stats_t& lhs, const dex_stats_t& rhs);
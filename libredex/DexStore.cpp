@@ -76,29 +76,34 @@ std::unordered_set<const DexType*> get_root_store_types(
 }
 
 XStoreRefs::XStoreRefs(const DexStoresVector& stores) {
-  m_xstores.push_back(std::unordered_set<const DexType*>());
-  m_stores.push_back(&stores[0]);
-  for (const auto& cls : stores[0].get_dexen()[0]) {
-    m_xstores.back().insert(cls->get_type());
+  auto add_classes = [this](const DexClasses& classes) {
+    size_t store_idx = m_stores.size() - 1;
+    for (const auto& cls : classes) {
+      m_xstores.emplace(cls->get_type(), store_idx);
+    }
+  };
+  size_t num_classes = 0;
+  for (const auto& store : stores) {
+    for (const auto& classes : store.get_dexen()) {
+      num_classes += classes.size();
+    }
   }
+  m_xstores.reserve(num_classes);
+
+  m_stores.push_back(&stores[0]);
+  add_classes(stores[0].get_dexen()[0]);
   m_root_stores = 1;
   if (stores[0].get_dexen().size() > 1) {
     m_root_stores++;
-    m_xstores.push_back(std::unordered_set<const DexType*>());
     m_stores.push_back(&stores[0]);
     for (size_t i = 1; i < stores[0].get_dexen().size(); i++) {
-      for (const auto& cls : stores[0].get_dexen()[i]) {
-        m_xstores.back().insert(cls->get_type());
-      }
+      add_classes(stores[0].get_dexen()[i]);
     }
   }
   for (size_t i = 1; i < stores.size(); i++) {
-    m_xstores.push_back(std::unordered_set<const DexType*>());
     m_stores.push_back(&stores[i]);
     for (const auto& classes : stores[i].get_dexen()) {
-      for (const auto& cls : classes) {
-        m_xstores.back().insert(cls->get_type());
-      }
+      add_classes(classes);
     }
   }
 }
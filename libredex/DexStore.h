@@ -9,6 +9,7 @@
 
 #include <cstdlib>
 #include <cstring>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -147,10 +148,10 @@ std::unordered_set<const DexType*> get_root_store_types(
 class XStoreRefs {
  private:
   /**
-   * Set of classes in each logical store. A primary DEX goes in its own
-   * bucket (first element in the array).
+   * The logical store of each class. A primary DEX goes in its own store
+   * (index 0). A class defined in several stores maps to the first one.
    */
-  std::vector<std::unordered_set<const DexType*>> m_xstores;
+  std::unordered_map<const DexType*, size_t> m_xstores;
 
   /**
    * Pointers to original stores in the same order as used to populate
@@ -180,9 +181,8 @@ class XStoreRefs {
    * api.
    */
   size_t get_store_idx(const DexType* type) const {
-    for (size_t store_idx = 0; store_idx < m_xstores.size(); store_idx++) {
-      if (m_xstores[store_idx].count(type) > 0) return store_idx;
-    }
+    auto it = m_xstores.find(type);
+    if (it != m_xstores.end()) return it->second;
     not_reached_log("type %s not in the current APK", show_type(type).c_str());
   }
 
@@ -193,17 +193,13 @@ class XStoreRefs {
    * the current scope.
    */
   bool is_in_root_store(const DexType* type) const {
-    for (size_t store_idx = 0; store_idx < m_root_stores; store_idx++) {
-      if (m_xstores[store_idx].count(type) > 0) {
-        return true;
-      }
-    }
-
-    return false;
+    auto it = m_xstores.find(type);
+    return it != m_xstores.end() && it->second < m_root_stores;
   }
 
   bool is_in_primary_dex(const DexType* type) const {
-    return !m_xstores.empty() && m_xstores[0].count(type);
+    auto it = m_xstores.find(type);
+    return it != m_xstores.end() && it->second == 0;
   }
 
   const DexStore* get_store(size_t idx) const { return m_stores[idx]; }
@@ -239,12 +235,10 @@ class XStoreRefs {
     if (type_class_internal(type) == nullptr) return false;
     // Temporary HACK: optimizations may leave references to dead classes and
     // if we just call get_store_idx() - as we should - the assert will fire...
-    size_t type_store_idx = 0;
-    for (; type_store_idx < m_xstores.size(); type_store_idx++) {
-      if (m_xstores[type_store_idx].count(type) > 0) break;
-    }
-    if ((store_idx >= m_xstores.size()) ||
-        (type_store_idx >= m_xstores.size())) {
+    auto it = m_xstores.find(type);
+    size_t num_stores = m_stores.size();
+    size_t type_store_idx = it == m_xstores.end() ? num_stores : it->second;
+    if ((store_idx >= num_stores) || (type_store_idx >= num_stores)) {
       return type_store_idx > store_idx;
     }
     return illegal_ref_between_stores(store_idx, type_store_idx);
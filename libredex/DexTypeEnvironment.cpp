@@ -7,6 +7,8 @@
 
 #include "DexTypeEnvironment.h"
 
+#include <algorithm>
+#include <boost/container/small_vector.hpp>
 #include <boost/optional/optional_io.hpp>
 #include <ostream>
 
@@ -48,15 +50,29 @@ bool are_interfaces_mergeable_to(const DexClass* left, const DexClass* right) {
 
 /*
  * Try to find type on `l`'s parent chain that is also a parent of `r`.
+ *
+ * This is on the hot path of every join. Instead of checking each parent of
+ * `l` with `type::is_subclass`, which walks `r`'s chain again each time, we
+ * collect `r`'s chain once, so that the number of class lookups is linear in
+ * the depth of the hierarchy.
  */
 const DexType* find_common_super_class(const DexType* l, const DexType* r) {
   always_assert(l && r);
   if (l == r) {
     return l;
   }
+  boost::container::small_vector<const DexType*, 16> r_chain;
+  for (auto super = r; super != nullptr;) {
+    r_chain.push_back(super);
+    auto super_cls = type_class(super);
+    if (!super_cls) {
+      break;
+    }
+    super = super_cls->get_super_class();
+  }
   auto parent = l;
   while (parent) {
-    if (type::is_subclass(parent, r)) {
+    if (std::find(r_chain.begin(), r_chain.end(), parent) != r_chain.end()) {
       return parent;
     }
     auto parent_cls = type_class(parent);
@@ -176,7 +192,8 @@ bool SmallSetDexTypeDomain::leq(const SmallSetDexTypeDomain& other) const {
   if (is_top()) {
     return false;
   }
-  return m_types.is_subset_of(other.m_types);
+  return std::includes(other.begin(), other.end(), begin(), end(),
+                       std::less<const DexType*>());
 }
 
 bool SmallSetDexTypeDomain::equals(const SmallSetDexTypeDomain& other) const {
@@ -186,7 +203,7 @@ bool SmallSetDexTypeDomain::equals(const SmallSetDexTypeDomain& other) const {
   if (is_top()) {
     return other.is_top();
   }
-  return m_types.equals(other.m_types);
+  return std::equal(begin(), end(), other.begin(), other.end());
 }
 
 void SmallSetDexTypeDomain::join_with(const SmallSetDexTypeDomain& other) {
@@ -198,14 +215,19 @@ void SmallSetDexTypeDomain::join_with(const SmallSetDexTypeDomain& other) {
     return;
   }
   if (is_bottom()) {
-    m_kind = other.m_kind;
-    m_types = other.m_types;
+    *this = other;
     return;
   }
-  m_types.union_with(other.m_types);
-  if (m_types.size() > MAX_SET_SIZE) {
+  std::array<const DexType*, 2 * MAX_SET_SIZE> types;
+  auto types_end = std::set_union(begin(), end(), other.begin(), other.end(),
+                                  types.begin(), std::less<const DexType*>());
+  size_t size = types_end - types.begin();
+  if (size > MAX_SET_SIZE) {
     set_to_top();
+    return;
   }
+  std::copy(types.begin(), types_end, m_types.begin());
+  m_size = size;
 }
 
 void SmallSetDexTypeDomain::widen_with(const SmallSetDexTypeDomain& other) {
@@ -217,11 +239,10 @@ void SmallSetDexTypeDomain::widen_with(const SmallSetDexTypeDomain& other) {
     return;
   }
   if (is_bottom()) {
-    m_kind = other.m_kind;
-    m_types = other.m_types;
+    *this = other;
     return;
   }
-  if (m_types.size() + other.m_types.size() > MAX_SET_SIZE) {
+  if (m_size + other.m_size > MAX_SET_SIZE) {
     set_to_top();
     return;
   }
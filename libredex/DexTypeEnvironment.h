@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <array>
 #include <ostream>
 
 #include <boost/optional.hpp>
@@ -182,9 +183,9 @@ class SmallSetDexTypeDomain final
  public:
   SmallSetDexTypeDomain() : m_kind(sparta::AbstractValueKind::Value) {}
 
-  explicit SmallSetDexTypeDomain(const DexType* type) {
-    m_types.insert(type);
-    m_kind = sparta::AbstractValueKind::Value;
+  explicit SmallSetDexTypeDomain(const DexType* type)
+      : m_size(1), m_kind(sparta::AbstractValueKind::Value) {
+    m_types[0] = type;
   }
 
   bool is_bottom() const override {
@@ -197,19 +198,19 @@ class SmallSetDexTypeDomain final
 
   void set_to_bottom() override {
     m_kind = sparta::AbstractValueKind::Bottom;
-    m_types.clear();
+    m_size = 0;
   }
 
   void set_to_top() override {
     m_kind = sparta::AbstractValueKind::Top;
-    m_types.clear();
+    m_size = 0;
   }
 
   sparta::AbstractValueKind kind() const { return m_kind; }
 
   sparta::PatriciaTreeSet<const DexType*> get_types() const {
     always_assert(!is_top());
-    return m_types;
+    return sparta::PatriciaTreeSet<const DexType*>(begin(), end());
   }
 
   bool leq(const SmallSetDexTypeDomain& other) const override;
@@ -232,7 +233,13 @@ class SmallSetDexTypeDomain final
                                   const SmallSetDexTypeDomain& x);
 
  private:
-  sparta::PatriciaTreeSet<const DexType*> m_types;
+  const DexType* const* begin() const { return m_types.data(); }
+  const DexType* const* end() const { return m_types.data() + m_size; }
+
+  // Sets larger than MAX_SET_SIZE are top, so the types are stored inline,
+  // sorted by address, and joins don't allocate.
+  std::array<const DexType*, MAX_SET_SIZE> m_types;
+  size_t m_size{0};
   sparta::AbstractValueKind m_kind;
 };
 
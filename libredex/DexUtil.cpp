@@ -88,7 +88,7 @@ Scope build_class_scope(const DexStoresVector& stores) {
 }
 
 template <typename PrefixIt>
-bool starts_with_any_prefix(const std::string& str,
+bool starts_with_any_prefix(std::string_view str,
                             const PrefixIt& begin,
                             const PrefixIt& end) {
   auto it = begin;
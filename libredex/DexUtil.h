@@ -10,6 +10,7 @@
 #include <algorithm>
 #include <boost/algorithm/string/predicate.hpp>
 #include <functional>
+#include <string_view>
 #include <unordered_set>
 #include <vector>
 
@@ -108,11 +109,15 @@ void create_runtime_exception_block(DexString* except_str,
  */
 template <class T>
 Scope build_class_scope(const T& dexen) {
+  // This is called a lot, so size the scope up front instead of growing it.
+  size_t size = 0;
+  for (auto const& classes : dexen) {
+    size += classes.size();
+  }
   Scope v;
+  v.reserve(size);
   for (auto const& classes : dexen) {
-    for (auto clazz : classes) {
-      v.push_back(clazz);
-    }
+    v.insert(v.end(), classes.begin(), classes.end());
   }
   return v;
 };
@@ -237,10 +242,10 @@ inline boost::optional<char> primitive_name_to_desc(const std::string& name) {
 // Example: "[Ljava/lang/String;" --> "[Ljava.lang.String;"
 // Example: "I" --> "int"
 // Example: "[I" --> "[I"
-inline std::string internal_to_external(const std::string& internal_name) {
+inline std::string internal_to_external(std::string_view internal_name) {
   int array_level = std::count(internal_name.begin(), internal_name.end(), '[');
 
-  std::string component_name = internal_name.substr(array_level);
+  std::string component_name(internal_name.substr(array_level));
 
   char type = component_name.at(0);
   if (type == 'L') {
@@ -260,7 +265,7 @@ inline std::string internal_to_external(const std::string& internal_name) {
   } else if (array_level) {
     // If the type is an array of primitives, the external format is the same
     // as internal.
-    return internal_name;
+    return std::string(internal_name);
   } else {
     auto maybe_external_name = primitive_desc_to_name(type);
     always_assert_log(
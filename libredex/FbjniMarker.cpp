@@ -120,7 +120,7 @@ std::string FbjniMarker::to_internal_type(const std::string& str) {
     // try to match simple name (more common)
     for (auto dtype : types) {
       if (type::get_simple_name(dtype) == type_str) {
-        return array_prefix + dtype->str();
+        return array_prefix + dtype->str_copy();
       }
     }
 
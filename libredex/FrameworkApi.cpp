@@ -9,6 +9,11 @@
 
 #include <boost/algorithm/string.hpp>
 #include <fstream>
+#include <iterator>
+#include <numeric>
+#include <string_view>
+
+#include "WorkQueue.h"
 
 namespace api {
 
@@ -87,54 +92,125 @@ bool FrameworkAPI::has_field(const std::string& simple_deobfuscated_name,
  *      ...
  */
 
-void AndroidSDK::load_framework_classes() {
+namespace {
 
-  std::ifstream infile(m_sdk_api_file.c_str());
-  assert_log(infile, "Failed to open framework api file: %s\n",
-             m_sdk_api_file.c_str());
+std::vector<std::string_view> split_tokens(std::string_view line) {
+  std::vector<std::string_view> tokens;
+  size_t pos = 0;
+  while (true) {
+    pos = line.find_first_not_of(" \t\r", pos);
+    if (pos == std::string_view::npos) {
+      break;
+    }
+    size_t end = line.find_first_of(" \t\r", pos);
+    if (end == std::string_view::npos) {
+      end = line.size();
+    }
+    tokens.push_back(line.substr(pos, end - pos));
+    pos = end;
+  }
+  return tokens;
+}
 
-  std::string framework_cls_str;
-  std::string super_cls_str;
-  std::string class_name;
-  uint32_t num_methods;
-  uint32_t num_fields;
-  uint32_t access_flags;
-
-  while (infile >> framework_cls_str >> access_flags >> super_cls_str >>
-         num_methods >> num_fields) {
-    FrameworkAPI framework_api;
-    framework_api.cls = DexType::make_type(framework_cls_str.c_str());
-    always_assert_log(m_framework_classes.count(framework_api.cls) == 0,
-                      "Duplicated class name!");
-    framework_api.super_cls = DexType::make_type(super_cls_str.c_str());
-    framework_api.access_flags = DexAccessFlags(access_flags);
+uint32_t parse_uint(std::string_view token) {
+  uint32_t value = 0;
+  always_assert_log(!token.empty(), "Expected a number");
+  for (char c : token) {
+    always_assert_log(c >= '0' && c <= '9', "Expected a number, got %s",
+                      std::string(token).c_str());
+    value = value * 10 + (c - '0');
+  }
+  return value;
+}
 
-    while (num_methods-- > 0) {
-      std::string method_str;
-      std::string tag;
-      uint32_t m_access_flags;
+FrameworkAPI parse_framework_class(
+    const std::vector<std::vector<std::string_view>>& lines,
+    size_t header,
+    uint32_t num_methods,
+    uint32_t num_fields) {
+  const auto& tokens = lines[header];
+  FrameworkAPI framework_api;
+  framework_api.cls = DexType::make_type(std::string(tokens[0]).c_str());
+  framework_api.access_flags = DexAccessFlags(parse_uint(tokens[1]));
+  framework_api.super_cls = DexType::make_type(std::string(tokens[2]).c_str());
+
+  size_t line = header + 1;
+  framework_api.mrefs_info.reserve(num_methods);
+  for (uint32_t i = 0; i < num_methods; i++, line++) {
+    const auto& member = lines[line];
+    always_assert(member.size() == 3 && member[0] == "M");
+    DexMethodRef* mref = DexMethod::make_method(std::string(member[1]));
+    framework_api.mrefs_info.emplace_back(
+        mref, DexAccessFlags(parse_uint(member[2])));
+  }
+  framework_api.frefs_info.reserve(num_fields);
+  for (uint32_t i = 0; i < num_fields; i++, line++) {
+    const auto& member = lines[line];
+    always_assert(member.size() == 3 && member[0] == "F");
+    DexFieldRef* fref = DexField::make_field(std::string(member[1]));
+    framework_api.frefs_info.emplace_back(
+        fref, DexAccessFlags(parse_uint(member[2])));
+  }
+  return framework_api;
+}
 
-      infile >> tag >> method_str >> m_access_flags;
+} // namespace
 
-      always_assert(tag == "M");
-      DexMethodRef* mref = DexMethod::make_method(method_str);
-      framework_api.mrefs_info.emplace_back(mref,
-                                            DexAccessFlags(m_access_flags));
+void AndroidSDK::load_framework_classes() {
+  // The API files hold tens of thousands of classes. Read each file in one go,
+  // split it into per-class records, and intern the records in parallel.
+  std::ifstream infile(m_sdk_api_file.c_str(), std::ios::binary);
+  assert_log(infile, "Failed to open framework api file: %s\n",
+             m_sdk_api_file.c_str());
+  std::string contents((std::istreambuf_iterator<char>(infile)),
+                       std::istreambuf_iterator<char>());
+
+  std::vector<std::vector<std::string_view>> lines;
+  std::string_view data(contents);
+  for (size_t pos = 0; pos < data.size();) {
+    size_t end = data.find('\n', pos);
+    if (end == std::string_view::npos) {
+      end = data.size();
     }
-
-    while (num_fields-- > 0) {
-      std::string field_str;
-      std::string tag;
-      uint32_t f_access_flags;
-
-      infile >> tag >> field_str >> f_access_flags;
-
-      always_assert(tag == "F");
-      DexFieldRef* fref = DexField::make_field(field_str);
-      framework_api.frefs_info.emplace_back(fref,
-                                            DexAccessFlags(f_access_flags));
+    auto tokens = split_tokens(data.substr(pos, end - pos));
+    if (!tokens.empty()) {
+      lines.push_back(std::move(tokens));
     }
+    pos = end + 1;
+  }
+
+  struct Record {
+    size_t header;
+    uint32_t num_methods;
+    uint32_t num_fields;
+  };
+  std::vector<Record> records;
+  for (size_t line = 0; line < lines.size();) {
+    const auto& tokens = lines[line];
+    always_assert_log(tokens.size() == 5, "Malformed framework class: %s",
+                      std::string(tokens[0]).c_str());
+    Record record{line, parse_uint(tokens[3]), parse_uint(tokens[4])};
+    line += 1 + record.num_methods + record.num_fields;
+    always_assert_log(line <= lines.size(), "Truncated framework api file: %s",
+                      m_sdk_api_file.c_str());
+    records.push_back(record);
+  }
 
+  std::vector<FrameworkAPI> apis(records.size());
+  std::vector<size_t> indices(records.size());
+  std::iota(indices.begin(), indices.end(), 0);
+  workqueue_run<size_t>(
+      [&](size_t i) {
+        const auto& record = records[i];
+        apis[i] = parse_framework_class(lines, record.header,
+                                        record.num_methods, record.num_fields);
+      },
+      indices);
+
+  m_framework_classes.reserve(apis.size());
+  for (auto& framework_api : apis) {
+    always_assert_log(m_framework_classes.count(framework_api.cls) == 0,
+                      "Duplicated class name!");
     auto& map_entry = m_framework_classes[framework_api.cls];
     map_entry = std::move(framework_api);
   }
@@ -26,6 +26,7 @@ void InlinerConfig::bind_config() {
   bind("run_fast_reg_alloc", shrinker.run_fast_reg_alloc,
        shrinker.run_fast_reg_alloc);
   bind("run_local_dce", shrinker.run_local_dce, shrinker.run_local_dce);
+  bind("shrinker_max_rounds", shrinker.max_rounds, shrinker.max_rounds);
   bind("no_inline_annos", {}, m_no_inline_annos);
   bind("force_inline_annos", {}, m_force_inline_annos);
   bind("blocklist", {}, m_blocklist);
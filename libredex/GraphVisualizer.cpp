@@ -399,8 +399,8 @@ class CFGVisualizer : public CodeVisualizer<CFGVisualizer> {
   static bool is_not_throw_edge(const Edge* e) { return !is_throw_edge(e); }
 
   template <typename T>
-  std::vector<Edge*> get_succ_edges(Block* block, T& fn) {
-    return m_cfg ? m_cfg->get_succ_edges_if(block, fn) : std::vector<Edge*>{};
+  EdgeList get_succ_edges(Block* block, T& fn) {
+    return m_cfg ? m_cfg->get_succ_edges_if(block, fn) : EdgeList{};
   }
 
   void successors(Block* block) {
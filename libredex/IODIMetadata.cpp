@@ -19,7 +19,7 @@ namespace {
 // Returns com.foo.Bar. for the DexClass Lcom/foo/Bar;. Note the trailing
 // '.'.
 std::string pretty_prefix_for_cls(const DexClass* cls) {
-  std::string pretty_name = java_names::internal_to_external(cls->str());
+  std::string pretty_name = java_names::internal_to_external(cls->str_copy());
   // Include the . separator
   pretty_name.push_back('.');
   return pretty_name;
@@ -109,10 +109,10 @@ void IODIMetadata::mark_methods(DexStoresVector& scope) {
         auto pretty_prefix = pretty_prefix_for_cls(cls);
         // First we need to mark all entries...
         for (DexMethod* m : cls->get_dmethods()) {
-          emplace_entry(pretty_prefix + m->str(), m);
+          emplace_entry(pretty_prefix + m->str_copy(), m);
         }
         for (DexMethod* m : cls->get_vmethods()) {
-          emplace_entry(pretty_prefix + m->str(), m);
+          emplace_entry(pretty_prefix + m->str_copy(), m);
         }
       }
     }
@@ -81,13 +81,13 @@ s_expr to_s_expr(const IRInstruction* insn, const LabelRefs& label_refs) {
     s_exprs.emplace_back(show(insn->get_method()));
     break;
   case opcode::Ref::String:
-    s_exprs.emplace_back(insn->get_string()->str());
+    s_exprs.emplace_back(insn->get_string()->str_copy());
     break;
   case opcode::Ref::Literal:
     s_exprs.emplace_back(std::to_string(insn->get_literal()));
     break;
   case opcode::Ref::Type:
-    s_exprs.emplace_back(insn->get_type()->get_name()->str());
+    s_exprs.emplace_back(insn->get_type()->get_name()->str_copy());
     break;
   case opcode::Ref::CallSite:
     s_exprs.emplace_back(show(insn->get_callsite()));
@@ -559,7 +559,7 @@ s_expr create_catch_expr(const MethodItemEntry* mie,
   result.emplace_back(".catch");
   result.emplace_back(catch_name_exprs);
   if (mie->centry->catch_type != nullptr) {
-    result.emplace_back(mie->centry->catch_type->get_name()->str());
+    result.emplace_back(mie->centry->catch_type->get_name()->str_copy());
   }
   return s_expr(result);
 }
@@ -586,8 +586,8 @@ s_expr create_dbg_expr(const MethodItemEntry* mie) {
     auto start_local = dynamic_cast<const DexDebugOpcodeStartLocal*>(dbg);
     always_assert(start_local != nullptr);
     result.emplace_back(std::to_string(start_local->uvalue()));
-    result.emplace_back(start_local->name()->str());
-    result.emplace_back(start_local->type()->str());
+    result.emplace_back(start_local->name()->str_copy());
+    result.emplace_back(start_local->type()->str_copy());
     break;
   }
   case DBG_START_LOCAL_EXTENDED: {
@@ -595,9 +595,9 @@ s_expr create_dbg_expr(const MethodItemEntry* mie) {
     auto start_local = dynamic_cast<const DexDebugOpcodeStartLocal*>(dbg);
     always_assert(start_local != nullptr);
     result.emplace_back(std::to_string(start_local->uvalue()));
-    result.emplace_back(start_local->name()->str());
-    result.emplace_back(start_local->type()->str());
-    result.emplace_back(start_local->sig()->str());
+    result.emplace_back(start_local->name()->str_copy());
+    result.emplace_back(start_local->type()->str_copy());
+    result.emplace_back(start_local->sig()->str_copy());
     break;
   }
   case DBG_END_LOCAL:
@@ -618,7 +618,7 @@ s_expr create_dbg_expr(const MethodItemEntry* mie) {
     result.emplace_back("DBG_SET_FILE");
     auto set_file = dynamic_cast<const DexDebugOpcodeSetFile*>(dbg);
     always_assert(set_file != nullptr);
-    result.emplace_back(set_file->file()->str());
+    result.emplace_back(set_file->file()->str_copy());
     break;
   }
   default:
@@ -264,7 +264,9 @@ static void associate_debug_entries(IRList* ir,
     }
     ir->insert_before(ir->iterator_to(*insert_point_it->second), *mentry);
   }
-  dbg.get_entries().clear();
+  // The debug item stays attached to the code for the rest of the run; don't
+  // let it hold on to the storage of the moved-out entries.
+  dbg.set_entries({});
 }
 
 // Insert MFLOW_TRYs and MFLOW_CATCHes
@@ -766,6 +768,8 @@ void gather_debug_entries(
       entries->emplace_back(entry_to_addr.at(&mie), std::move(mie.pos));
     }
   }
+  // The entries are kept until the dex and its mapping files are written.
+  entries->shrink_to_fit();
 }
 
 } // namespace
@@ -1139,6 +1143,13 @@ size_t IRCode::count_opcodes() const {
   return m_ir_list->count_opcodes();
 }
 
+size_t IRCode::estimate_size() const {
+  if (editable_cfg_built()) {
+    return m_cfg->num_opcodes();
+  }
+  return m_ir_list->size();
+}
+
 bool IRCode::has_try_blocks() const {
   if (editable_cfg_built()) {
     auto b = this->cfg().blocks();
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <atomic>
+#include <memory>
 #include <mutex>
 #include <set>
 #include <unordered_map>
@@ -23,6 +24,10 @@ class ControlFlowGraph;
 struct LinearizationStrategy;
 } // namespace cfg
 
+namespace type_inference {
+struct CachedTypeEnvironments;
+} // namespace type_inference
+
 // TODO(jezng): IRCode currently contains too many methods that shouldn't
 // belong there... I'm going to move them out soon
 class IRCode {
@@ -50,6 +55,11 @@ class IRCode {
   // exposing the param names should be enough
   std::unique_ptr<DexDebugItem> m_dbg;
 
+  // A cache rather than part of the code, hence mutable. Not copied along
+  // with the code, as it refers to its instructions.
+  mutable std::shared_ptr<const type_inference::CachedTypeEnvironments>
+      m_cached_type_environments;
+
   IRList::iterator make_if_block(const IRList::iterator& cur,
                                  IRInstruction* insn,
                                  IRList::iterator* if_block) {
@@ -165,6 +175,22 @@ class IRCode {
   bool cfg_built() const;
   bool editable_cfg_built() const;
 
+  // The type environments last computed for this code, which may be stale.
+  // Use type_inference::get_type_environments, which checks that they still
+  // match the CFG, instead of accessing them directly.
+  const std::shared_ptr<const type_inference::CachedTypeEnvironments>&
+  get_cached_type_environments() const {
+    return m_cached_type_environments;
+  }
+  void set_cached_type_environments(
+      std::shared_ptr<const type_inference::CachedTypeEnvironments> envs)
+      const {
+    m_cached_type_environments = std::move(envs);
+  }
+  void clear_cached_type_environments() const {
+    m_cached_type_environments.reset();
+  }
+
   /* Generate DexCode from IRCode */
   std::unique_ptr<DexCode> sync(const DexMethod*);
 
@@ -265,6 +291,13 @@ class IRCode {
    */
   size_t count_opcodes() const;
 
+  /*
+   * A cheap estimate of the size of the code, e.g. for load balancing: the
+   * number of entries of the IR list, including positions and debug info, in
+   * constant time. With an editable CFG, this is the number of instructions.
+   */
+  size_t estimate_size() const;
+
   void sanity_check() const { m_ir_list->sanity_check(); }
 
   bool has_try_blocks() const;
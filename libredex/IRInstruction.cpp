@@ -216,7 +216,7 @@ bool IRInstruction::invoke_src_is_wide(src_index_t i) const {
     --i;
   }
 
-  const std::deque<DexType*>& args =
+  const DexTypeList::ContainerType& args =
       m_method->get_proto()->get_args()->get_type_list();
   return type::is_wide_type(args[i]);
 }
@@ -14,6 +14,7 @@
 
 #include "Debug.h"
 #include "IROpcode.h"
+#include "SlabAllocator.h"
 
 class DexCallSite;
 class DexFieldRef;
@@ -139,6 +140,14 @@ class IRInstruction final {
   IRInstruction(const IRInstruction&);
   ~IRInstruction();
 
+  // Allocated from slabs, see SlabAllocator.h.
+  static void* operator new(size_t size) {
+    return slab_allocator::allocate(size);
+  }
+  static void operator delete(void* ptr, size_t size) {
+    slab_allocator::deallocate(ptr, size);
+  }
+
   /*
    * Ensures that wide registers only have their first register referenced
    * in the srcs list. This only affects invoke-* instructions.
@@ -10,6 +10,8 @@
 #include <boost/intrusive/list.hpp>
 #include <boost/optional.hpp>
 #include <boost/range/sub_range.hpp>
+#include <algorithm>
+#include <atomic>
 #include <functional>
 #include <iosfwd>
 #include <limits>
@@ -23,6 +25,7 @@
 #include <vector>
 
 #include "Debug.h"
+#include "SlabAllocator.h"
 
 class DexCallSite;
 class DexDebugInstruction;
@@ -166,11 +169,99 @@ struct SourceBlock {
    private:
     ValPair m_val;
   };
-  std::vector<Val> vals;
+
+  /*
+   * The values of all interactions. There are source blocks on every block
+   * of every method, each with a value per interaction, so they are kept in a
+   * single slab allocation behind a pointer, with a reference count and the
+   * size in front of them. Copies (e.g., of inlined blocks) share the values
+   * until one of them is written through the non-const accessor.
+   */
+  class Vals {
+   public:
+    Vals() = default;
+    // NOLINTNEXTLINE
+    /* implicit */ Vals(const std::vector<Val>& v) {
+      if (!v.empty()) {
+        m_rep = Rep::make(v.size());
+        std::uninitialized_copy(v.begin(), v.end(), m_rep->data());
+      }
+    }
+    Vals(const Vals& other) : m_rep(other.m_rep) {
+      if (m_rep != nullptr) {
+        m_rep->refs.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    Vals(Vals&& other) noexcept : m_rep(other.m_rep) { other.m_rep = nullptr; }
+    Vals& operator=(Vals other) noexcept {
+      std::swap(m_rep, other.m_rep);
+      return *this;
+    }
+    ~Vals() { Rep::release(m_rep); }
+
+    size_t size() const { return m_rep == nullptr ? 0 : m_rep->size; }
+    bool empty() const { return size() == 0; }
+
+    const Val* begin() const {
+      return m_rep == nullptr ? nullptr : m_rep->data();
+    }
+    const Val* end() const { return begin() + size(); }
+
+    const Val& operator[](size_t i) const { return begin()[i]; }
+    Val& operator[](size_t i) {
+      unshare();
+      return m_rep->data()[i];
+    }
+
+    bool operator==(const Vals& other) const {
+      return m_rep == other.m_rep ||
+             std::equal(begin(), end(), other.begin(), other.end());
+    }
+
+   private:
+    struct Rep {
+      std::atomic<uint32_t> refs{1};
+      uint32_t size{0};
+
+      Val* data() { return reinterpret_cast<Val*>(this + 1); }
+
+      static size_t bytes(size_t size) {
+        return sizeof(Rep) + size * sizeof(Val);
+      }
+
+      static Rep* make(size_t size) {
+        auto* rep = new (slab_allocator::allocate(bytes(size))) Rep();
+        rep->size = size;
+        return rep;
+      }
+
+      static void release(Rep* rep) {
+        if (rep != nullptr &&
+            rep->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+          size_t size = rep->size;
+          rep->~Rep();
+          slab_allocator::deallocate(rep, bytes(size));
+        }
+      }
+    };
+    static_assert(alignof(Val) <= alignof(Rep), "Vals must follow Rep");
+
+    void unshare() {
+      if (m_rep->refs.load(std::memory_order_acquire) != 1) {
+        auto* rep = Rep::make(m_rep->size);
+        std::uninitialized_copy(begin(), end(), rep->data());
+        Rep::release(m_rep);
+        m_rep = rep;
+      }
+    }
+
+    Rep* m_rep{nullptr};
+  };
+  Vals vals;
 
   SourceBlock() = default;
   SourceBlock(DexMethodRef* src, size_t id) : src(src), id(id) {}
-  SourceBlock(DexMethodRef* src, size_t id, std::vector<Val> v)
+  SourceBlock(DexMethodRef* src, size_t id, Vals v)
       : src(src), id(id), vals(std::move(v)) {}
   SourceBlock(const SourceBlock& other)
       : src(other.src),
@@ -178,6 +269,14 @@ struct SourceBlock {
         id(other.id),
         vals(other.vals) {}
 
+  // Allocated from slabs, see SlabAllocator.h.
+  static void* operator new(size_t size) {
+    return slab_allocator::allocate(size);
+  }
+  static void operator delete(void* ptr, size_t size) {
+    slab_allocator::deallocate(ptr, size);
+  }
+
   boost::optional<float> get_val(size_t i) const {
     return vals[i] ? boost::optional<float>(vals[i]->val) : boost::none;
   }
@@ -299,6 +398,14 @@ struct MethodItemEntry {
   MethodItemEntry() : type(MFLOW_FALLTHROUGH) {}
   ~MethodItemEntry();
 
+  // Allocated from slabs, see SlabAllocator.h.
+  static void* operator new(size_t size) {
+    return slab_allocator::allocate(size);
+  }
+  static void operator delete(void* ptr, size_t size) {
+    slab_allocator::deallocate(ptr, size);
+  }
+
   /*
    * This should only ever be used by the instruction lowering step. Do NOT use
    * it in passes!
@@ -547,6 +654,14 @@ std::string show(const IRList*);
 
 namespace ir_list {
 
+/*
+ * Walks the MFLOW_OPCODE entries of an IRList, skipping all others.
+ *
+ * There is deliberately no cached array of the instructions: entries are
+ * mutated in place through IRList iterators all over the codebase, so nothing
+ * could tell when such a cache goes stale. A scan that needs the instructions
+ * several times should copy them into a vector itself.
+ */
 template <bool is_const>
 class InstructionIteratorImpl {
   using Iterator = typename std::
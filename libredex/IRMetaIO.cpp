@@ -80,7 +80,7 @@ DexMethod* find_method(const DexClass* cls, const std::string& name_and_proto) {
 template <typename T>
 void serialize_name_and_rstate(const T* obj, std::ofstream& ostrm) {
   if (show(obj) != obj->get_deobfuscated_name()) {
-    serialize_str(obj->get_deobfuscated_name(), ostrm);
+    serialize_str(obj->get_deobfuscated_name_copy(), ostrm);
   } else {
     serialize_str("", ostrm);
   }
@@ -1453,5 +1453,5 @@ std::ostream& operator<<(std::ostream& output, const IRTypeChecker& checker) {
 void IRTypeChecker::check_completion() const {
   always_assert_log(m_complete,
                     "The type checker did not run on method %s.\n",
-                    m_dex_method->get_deobfuscated_name().c_str());
+                    m_dex_method->get_deobfuscated_name_copy().c_str());
 }
@@ -7,6 +7,9 @@
 
 #include "InstructionLowering.h"
 
+#include <algorithm>
+#include <numeric>
+
 #include "Debug.h"
 #include "DexInstruction.h"
 #include "DexOpcodeDefs.h"
@@ -14,6 +17,7 @@
 #include "IRInstruction.h"
 #include "Show.h"
 #include "Walkers.h"
+#include "WorkQueue.h"
 
 namespace instruction_lowering {
 
@@ -463,11 +467,18 @@ Stats lower(DexMethod* method, bool lower_with_cfg) {
     code_begin = code->begin();
   }
 
+  // Whether the profiles say that the current block was executed.
+  bool in_hot_block = false;
   for (auto it = code_begin; it != code->end(); ++it) {
     if (it->type != MFLOW_OPCODE) {
+      if (it->type == MFLOW_TARGET) {
+        in_hot_block = false;
+      }
       // Remove any source blocks. They are no longer necessary and slow down
       // iteration.
       if (it->type == MFLOW_SOURCE_BLOCK) {
+        in_hot_block = it->src_block->foreach_val_early(
+            [](const auto& val) { return val && val->val > 0; });
         redex_assert(it != code->begin());
         auto prev = std::prev(it);
         code->erase_and_dispose(it);
@@ -496,8 +507,12 @@ Stats lower(DexMethod* method, bool lower_with_cfg) {
     // its cases are laid out.
     if (op == OPCODE_SWITCH) {
       const auto& keys = case_keys.at(&*it);
-      DexOpcode dop = sufficiently_sparse(keys) ? DOPCODE_SPARSE_SWITCH
-                                                : DOPCODE_PACKED_SWITCH;
+      DexOpcode dop = sufficiently_sparse(keys, in_hot_block)
+                          ? DOPCODE_SPARSE_SWITCH
+                          : DOPCODE_PACKED_SWITCH;
+      if (dop == DOPCODE_PACKED_SWITCH && sufficiently_sparse(keys)) {
+        stats.hot_packed_switches++;
+      }
       it->dex_insn->set_opcode(dop);
     }
   }
@@ -513,13 +528,47 @@ Stats lower(DexMethod* method, bool lower_with_cfg) {
 
 Stats run(DexStoresVector& stores, bool lower_with_cfg) {
   auto scope = build_class_scope(stores);
-  return walk::parallel::methods<Stats>(scope, [lower_with_cfg](DexMethod* m) {
-    Stats stats;
-    if (m->get_code() == nullptr) {
-      return stats;
+  std::vector<DexMethod*> methods;
+  walk::methods(scope, [&methods](DexMethod* m) {
+    // Code which was never ballooned is still in dex form.
+    if (!m->is_balloon_pending()) {
+      methods.push_back(m);
     }
-    return lower(m, lower_with_cfg);
   });
+  // Getting the code may restore it from a spill, so sizes are computed in
+  // parallel too.
+  std::vector<size_t> sizes(methods.size());
+  std::vector<size_t> indices(methods.size());
+  std::iota(indices.begin(), indices.end(), 0);
+  workqueue_run<size_t>(
+      [&](size_t i) {
+        auto* code = methods[i]->get_code();
+        sizes[i] = code == nullptr ? 0 : code->sum_opcode_sizes();
+      },
+      indices);
+  // Lowering time grows with the size of a method. Scheduling the largest
+  // methods first keeps a few big ones from being picked up last and
+  // running alone at the end.
+  std::stable_sort(
+      indices.begin(), indices.end(),
+      [&sizes](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+
+  size_t num_threads = redex_parallel::default_num_threads();
+  std::vector<Stats> stats_per_worker(num_threads);
+  workqueue_run<size_t>(
+      [&](sparta::SpartaWorkerState<size_t>* state, size_t i) {
+        if (methods[i]->get_code() != nullptr) {
+          stats_per_worker[state->worker_id()] +=
+              lower(methods[i], lower_with_cfg);
+        }
+      },
+      indices, num_threads);
+
+  Stats stats;
+  for (const auto& worker_stats : stats_per_worker) {
+    stats += worker_stats;
+  }
+  return stats;
 }
 
 // Computes number of entries needed for a packed switch, accounting for any
@@ -532,12 +581,14 @@ uint64_t get_packed_switch_size(const std::vector<int32_t>& case_keys) {
 }
 
 // Whether a sparse switch statement will be more compact than a packed switch
-bool sufficiently_sparse(const std::vector<int32_t>& case_keys) {
+bool sufficiently_sparse(const std::vector<int32_t>& case_keys, bool is_hot) {
   uint64_t size = get_packed_switch_size(case_keys);
   // packed switches must have less than 2^16 entries, and
-  // sparse switches pay off once there are more holes than entries
+  // sparse switches pay off once there are more holes than entries. For hot
+  // switches, we accept packed payloads of up to about twice the size of the
+  // sparse one, i.e. three holes per entry.
   return size > std::numeric_limits<uint16_t>::max() ||
-         size / 2 > case_keys.size();
+         size / (is_hot ? 4 : 2) > case_keys.size();
 }
 
 } // namespace instruction_lowering
@@ -25,10 +25,12 @@ namespace instruction_lowering {
 struct Stats {
   size_t to_2addr{0};
   size_t move_for_check_cast{0};
+  size_t hot_packed_switches{0};
 
   Stats& operator+=(const Stats& that) {
     to_2addr += that.to_2addr;
     move_for_check_cast += that.move_for_check_cast;
+    hot_packed_switches += that.hot_packed_switches;
     return *this;
   }
 };
@@ -40,6 +42,8 @@ struct Stats {
  *   - Pick the smallest opcode that can address its operands.
  *   - Insert move instructions as necessary for check-cast instructions that
  *     have different src and dest registers.
+ *   - Pick packed or sparse switches, favoring packed switches in blocks that
+ *     the source-block profiles show to be executed.
  *   - Record the number of instructions converted to /2addr form, and the
  *     number of move instructions inserted because of check-casts.
  */
@@ -63,7 +67,10 @@ bool try_2addr_conversion(MethodItemEntry*);
 // holes that might exist
 uint64_t get_packed_switch_size(const std::vector<int32_t>& case_keys);
 
-// Whether a sparse switch statement will be more compact than a packed switch
-bool sufficiently_sparse(const std::vector<int32_t>& case_keys);
+// Whether a sparse switch statement will be more compact than a packed switch.
+// Hot switches trade some code size for the constant-time dispatch of a packed
+// switch, instead of the binary search of a sparse switch.
+bool sufficiently_sparse(const std::vector<int32_t>& case_keys,
+                         bool is_hot = false);
 
 } // namespace instruction_lowering
@@ -5,9 +5,14 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <boost/filesystem.hpp>
 #include <boost/iostreams/device/mapped_file.hpp>
 
 #include <cstdint>
+#include <fstream>
+#include <numeric>
+#include <string_view>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 #include <zlib.h>
@@ -25,9 +30,11 @@
 #include "DexClass.h"
 #include "DuplicateClasses.h"
 #include "JarLoader.h"
+#include "Sha1.h"
 #include "Show.h"
 #include "Trace.h"
 #include "Util.h"
+#include "WorkQueue.h"
 
 /******************
  * Begin Class Loading code.
@@ -83,6 +90,31 @@ struct cp_method_info {
   uint16_t nameNdx;
   uint16_t descNdx;
 };
+
+/*
+ * The parts of a class file that we turn into an external DexClass. The
+ * strings point into the class file or into a jar cache mapping.
+ */
+struct MemberRecord {
+  uint16_t aflags{0};
+  std::string_view name;
+  std::string_view desc;
+  // The member's attribute table in the class file, if any.
+  uint8_t* attributes{nullptr};
+};
+
+struct ClassRecord {
+  uint16_t aflags{0};
+  // Internal names, without the `L` and `;`. An empty super name means that
+  // there is no superclass.
+  std::string_view name;
+  std::string_view super_name;
+  std::vector<std::string_view> interfaces;
+  std::vector<MemberRecord> fields;
+  std::vector<MemberRecord> methods;
+};
+
+class JarCacheWriter;
 } // namespace
 
 /* clang-format off */
@@ -164,27 +196,16 @@ static void skip_attributes(uint8_t*& buffer) {
   }
 }
 #define MAX_CLASS_NAMELEN (8 * 1024)
-static DexType* make_dextype_from_cref(std::vector<cp_entry>& cpool,
-                                       uint16_t cref) {
+static DexType* make_dextype_from_name(std::string_view name) {
   char nbuffer[MAX_CLASS_NAMELEN];
-  if (cpool[cref].tag != CP_CONST_CLASS) {
-    fprintf(stderr, "Non-class ref in get_class_name, Bailing\n");
-    return nullptr;
-  }
-  uint16_t utf8ref = cpool[cref].s0;
-  const cp_entry& utf8cpe = cpool[utf8ref];
-  if (utf8cpe.tag != CP_CONST_UTF8) {
-    fprintf(stderr, "Non-utf8 ref in get_utf8, Bailing\n");
-    return nullptr;
-  }
-  if (utf8cpe.len > (MAX_CLASS_NAMELEN + 3)) {
+  if (name.size() + 3 > MAX_CLASS_NAMELEN) {
     fprintf(stderr, "classname is greater than max, bailing");
     return nullptr;
   }
   nbuffer[0] = 'L';
-  memcpy(nbuffer + 1, utf8cpe.data, utf8cpe.len);
-  nbuffer[1 + utf8cpe.len] = ';';
-  nbuffer[2 + utf8cpe.len] = '\0';
+  memcpy(nbuffer + 1, name.data(), name.size());
+  nbuffer[1 + name.size()] = ';';
+  nbuffer[2 + name.size()] = '\0';
   return DexType::make_type(nbuffer);
 }
 
@@ -207,13 +228,45 @@ static bool extract_utf8(std::vector<cp_entry>& cpool,
   return true;
 }
 
-static DexField* make_dexfield(std::vector<cp_entry>& cpool,
-                               DexType* self,
-                               cp_field_info& finfo) {
+static bool get_utf8(std::vector<cp_entry>& cpool,
+                     uint16_t utf8ref,
+                     std::string_view* out) {
+  const cp_entry& utf8cpe = cpool[utf8ref];
+  if (utf8cpe.tag != CP_CONST_UTF8) {
+    fprintf(stderr, "Non-utf8 ref in get_utf8, bailing\n");
+    return false;
+  }
+  *out = std::string_view(reinterpret_cast<const char*>(utf8cpe.data),
+                          utf8cpe.len);
+  return true;
+}
+
+static bool get_class_name(std::vector<cp_entry>& cpool,
+                           uint16_t cref,
+                           std::string_view* out) {
+  if (cpool[cref].tag != CP_CONST_CLASS) {
+    fprintf(stderr, "Non-class ref in get_class_name, Bailing\n");
+    return false;
+  }
+  return get_utf8(cpool, cpool[cref].s0, out);
+}
+
+static bool copy_utf8(std::string_view str, char* out, uint32_t size) {
+  if (str.size() > (size - 1)) {
+    fprintf(stderr, "Name is greater (%zu) than max (%u), bailing\n",
+            str.size(), size);
+    return false;
+  }
+  memcpy(out, str.data(), str.size());
+  out[str.size()] = '\0';
+  return true;
+}
+
+static DexField* make_dexfield(DexType* self, const MemberRecord& finfo) {
   char dbuffer[MAX_CLASS_NAMELEN];
   char nbuffer[MAX_CLASS_NAMELEN];
-  if (!extract_utf8(cpool, finfo.nameNdx, nbuffer, MAX_CLASS_NAMELEN) ||
-      !extract_utf8(cpool, finfo.descNdx, dbuffer, MAX_CLASS_NAMELEN)) {
+  if (!copy_utf8(finfo.name, nbuffer, MAX_CLASS_NAMELEN) ||
+      !copy_utf8(finfo.desc, dbuffer, MAX_CLASS_NAMELEN)) {
     return nullptr;
   }
   DexString* name = DexString::make_string(nbuffer);
@@ -308,7 +361,7 @@ static DexTypeList* extract_arguments(const char*& buf) {
     buf++;
     return DexTypeList::make_type_list({});
   }
-  std::deque<DexType*> args;
+  DexTypeList::ContainerType args;
   while (*buf != ')') {
     DexType* dtype = parse_type(buf);
     if (dtype == nullptr) return nullptr;
@@ -322,13 +375,11 @@ static DexTypeList* extract_arguments(const char*& buf) {
   return DexTypeList::make_type_list(std::move(args));
 }
 
-static DexMethod* make_dexmethod(std::vector<cp_entry>& cpool,
-                                 DexType* self,
-                                 cp_method_info& finfo) {
+static DexMethod* make_dexmethod(DexType* self, const MemberRecord& finfo) {
   char dbuffer[MAX_CLASS_NAMELEN];
   char nbuffer[MAX_CLASS_NAMELEN];
-  if (!extract_utf8(cpool, finfo.nameNdx, nbuffer, MAX_CLASS_NAMELEN) ||
-      !extract_utf8(cpool, finfo.descNdx, dbuffer, MAX_CLASS_NAMELEN)) {
+  if (!copy_utf8(finfo.name, nbuffer, MAX_CLASS_NAMELEN) ||
+      !copy_utf8(finfo.desc, dbuffer, MAX_CLASS_NAMELEN)) {
     return nullptr;
   }
   DexString* name = DexString::make_string(nbuffer);
@@ -360,10 +411,115 @@ static DexMethod* make_dexmethod(std::vector<cp_entry>& cpool,
   return method;
 }
 
-bool parse_class(uint8_t* buffer,
-                 Scope* classes,
-                 attribute_hook_t attr_hook,
-                 const std::string& jar_location) {
+namespace {
+
+/*
+ * A jar cache holds the ClassRecords of all classes in a jar, so that loading
+ * the same jar again needs neither decompression nor class file parsing. The
+ * layout, in host byte order, is
+ *
+ *   JarCacheHeader
+ *   num_strings x { u32 length, bytes }
+ *   num_classes x { u16 aflags, u32 name, u32 super_name,
+ *                   u16 count, count x u32 interface,
+ *                   u16 count, count x { u16 aflags, u32 name, u32 desc },
+ *                   u16 count, count x { u16 aflags, u32 name, u32 desc } }
+ *
+ * where strings are referenced by their index in the string table.
+ */
+struct JarCacheHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t num_strings;
+  uint32_t num_classes;
+};
+
+constexpr uint32_t kJarCacheMagic = 0x4a584452; // "RDXJ"
+constexpr uint32_t kJarCacheVersion = 1;
+constexpr uint32_t kNoString = 0xffffffff;
+
+class JarCacheWriter {
+ public:
+  void add(const ClassRecord& record) {
+    ++m_num_classes;
+    write16(record.aflags);
+    write32(intern(record.name));
+    write32(record.super_name.empty() ? kNoString
+                                      : intern(record.super_name));
+    write16(record.interfaces.size());
+    for (auto iface_name : record.interfaces) {
+      write32(intern(iface_name));
+    }
+    for (const auto* members : {&record.fields, &record.methods}) {
+      write16(members->size());
+      for (const auto& member : *members) {
+        write16(member.aflags);
+        write32(intern(member.name));
+        write32(intern(member.desc));
+      }
+    }
+  }
+
+  /*
+   * Writes to a temporary file first, so that concurrent builds sharing the
+   * cache never see a partial file.
+   */
+  bool write(const std::string& path) const {
+    boost::system::error_code ec;
+    auto target = boost::filesystem::path(path);
+    boost::filesystem::create_directories(target.parent_path(), ec);
+    auto tmp = target;
+    tmp += boost::filesystem::unique_path(".%%%%-%%%%-%%%%.tmp");
+    {
+      std::ofstream out(tmp.string(), std::ofstream::binary);
+      JarCacheHeader header{kJarCacheMagic, kJarCacheVersion,
+                            (uint32_t)m_string_ids.size(), m_num_classes};
+      out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      out.write(m_strings.data(), m_strings.size());
+      out.write(m_classes.data(), m_classes.size());
+      if (!out) {
+        boost::filesystem::remove(tmp, ec);
+        return false;
+      }
+    }
+    boost::filesystem::rename(tmp, target, ec);
+    if (ec) {
+      boost::filesystem::remove(tmp, ec);
+      return false;
+    }
+    return true;
+  }
+
+ private:
+  template <typename T>
+  static void append(std::string* out, T value) {
+    out->append(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+
+  void write16(uint16_t value) { append(&m_classes, value); }
+
+  void write32(uint32_t value) { append(&m_classes, value); }
+
+  uint32_t intern(std::string_view str) {
+    auto p = m_string_ids.emplace(std::string(str), m_string_ids.size());
+    if (p.second) {
+      append(&m_strings, (uint32_t)str.size());
+      m_strings.append(str.data(), str.size());
+    }
+    return p.first->second;
+  }
+
+  std::unordered_map<std::string, uint32_t> m_string_ids;
+  std::string m_strings;
+  std::string m_classes;
+  uint32_t m_num_classes{0};
+};
+
+} // namespace
+
+static bool decode_class(uint8_t* buffer,
+                         std::vector<cp_entry>& cpool,
+                         ClassRecord* record) {
   uint32_t magic = read32(buffer);
   uint16_t vminor DEBUG_ONLY = read16(buffer);
   uint16_t vmajor DEBUG_ONLY = read16(buffer);
@@ -372,7 +528,6 @@ bool parse_class(uint8_t* buffer,
     fprintf(stderr, "Bad class magic %08x, Bailing\n", magic);
     return false;
   }
-  std::vector<cp_entry> cpool;
   cpool.resize(cp_count);
   /* The zero'th entry is always empty.  Java is annoying. */
   for (int i = 1; i < cp_count; i++) {
@@ -382,12 +537,57 @@ bool parse_class(uint8_t* buffer,
       i++;
     }
   }
-  uint16_t aflags = read16(buffer);
+  record->aflags = read16(buffer);
   uint16_t clazz = read16(buffer);
   uint16_t super = read16(buffer);
   uint16_t ifcount = read16(buffer);
 
-  if (is_module((DexAccessFlags)aflags)) {
+  if (is_module((DexAccessFlags)record->aflags)) {
+    // Module classes have no further content that we care about.
+    return true;
+  }
+
+  if (!get_class_name(cpool, clazz, &record->name)) return false;
+  if (super != 0 && !get_class_name(cpool, super, &record->super_name)) {
+    return false;
+  }
+  for (int i = 0; i < ifcount; i++) {
+    uint16_t iface = read16(buffer);
+    std::string_view iface_name;
+    if (!get_class_name(cpool, iface, &iface_name)) return false;
+    record->interfaces.push_back(iface_name);
+  }
+
+  auto decode_members = [&](std::vector<MemberRecord>* members) {
+    uint16_t count = read16(buffer);
+    members->reserve(count);
+    for (int i = 0; i < count; i++) {
+      MemberRecord member;
+      member.aflags = read16(buffer);
+      uint16_t name_idx = read16(buffer);
+      uint16_t desc_idx = read16(buffer);
+      member.attributes = buffer;
+      skip_attributes(buffer);
+      if (!get_utf8(cpool, name_idx, &member.name) ||
+          !get_utf8(cpool, desc_idx, &member.desc)) {
+        return false;
+      }
+      members->push_back(member);
+    }
+    return true;
+  };
+  return decode_members(&record->fields) && decode_members(&record->methods);
+}
+
+using member_hook_t =
+    std::function<void(const boost::variant<DexField*, DexMethod*>&,
+                       const MemberRecord&)>;
+
+static bool create_class(const ClassRecord& record,
+                         Scope* classes,
+                         const member_hook_t& member_hook,
+                         const std::string& jar_location) {
+  if (is_module((DexAccessFlags)record.aflags)) {
     // Classes with the ACC_MODULE access flag are special.  They contain
     // metadata for the module/package system and don't have a superclass.
     // Ignore them for now.
@@ -396,7 +596,8 @@ bool parse_class(uint8_t* buffer,
     return true;
   }
 
-  DexType* self = make_dextype_from_cref(cpool, clazz);
+  DexType* self = make_dextype_from_name(record.name);
+  if (self == nullptr) return false;
   DexClass* cls = type_class(self);
   if (cls) {
     // We are seeing duplicate classes when parsing jar file
@@ -432,69 +633,31 @@ bool parse_class(uint8_t* buffer,
 
   ClassCreator cc(self, jar_location);
   cc.set_external();
-  if (super != 0) {
-    DexType* sclazz = make_dextype_from_cref(cpool, super);
+  if (!record.super_name.empty()) {
+    DexType* sclazz = make_dextype_from_name(record.super_name);
     cc.set_super(sclazz);
   }
-  cc.set_access((DexAccessFlags)aflags);
-  if (ifcount) {
-    for (int i = 0; i < ifcount; i++) {
-      uint16_t iface = read16(buffer);
-      DexType* iftype = make_dextype_from_cref(cpool, iface);
-      cc.add_interface(iftype);
-    }
+  cc.set_access((DexAccessFlags)record.aflags);
+  for (auto iface_name : record.interfaces) {
+    DexType* iftype = make_dextype_from_name(iface_name);
+    cc.add_interface(iftype);
   }
-  uint16_t fcount = read16(buffer);
 
-  auto invoke_attr_hook =
-      [&](const boost::variant<DexField*, DexMethod*>& field_or_method,
-          uint8_t* attrPtr) {
-        if (attr_hook == nullptr) {
-          return;
-        }
-        uint16_t attributes_count = read16(attrPtr);
-        for (uint16_t j = 0; j < attributes_count; j++) {
-          uint16_t attribute_name_index = read16(attrPtr);
-          uint32_t attribute_length = read32(attrPtr);
-          char attribute_name[MAX_CLASS_NAMELEN];
-          auto extract_res = extract_utf8(cpool, attribute_name_index,
-                                          attribute_name, MAX_CLASS_NAMELEN);
-          always_assert_log(
-              extract_res,
-              "attribute hook was specified, but failed to load the attribute "
-              "name due to insufficient name buffer");
-          attr_hook(field_or_method, attribute_name, attrPtr);
-          attrPtr += attribute_length;
-        }
-      };
-
-  for (int i = 0; i < fcount; i++) {
-    cp_field_info cpfield;
-    cpfield.aflags = read16(buffer);
-    cpfield.nameNdx = read16(buffer);
-    cpfield.descNdx = read16(buffer);
-    uint8_t* attrPtr = buffer;
-    skip_attributes(buffer);
-    DexField* field = make_dexfield(cpool, self, cpfield);
+  for (const auto& member : record.fields) {
+    DexField* field = make_dexfield(self, member);
     if (field == nullptr) return false;
     cc.add_field(field);
-    invoke_attr_hook({field}, attrPtr);
+    if (member_hook) {
+      member_hook({field}, member);
+    }
   }
 
-  uint16_t mcount = read16(buffer);
-  if (mcount) {
-    for (int i = 0; i < mcount; i++) {
-      cp_method_info cpmethod;
-      cpmethod.aflags = read16(buffer);
-      cpmethod.nameNdx = read16(buffer);
-      cpmethod.descNdx = read16(buffer);
-
-      uint8_t* attrPtr = buffer;
-      skip_attributes(buffer);
-      DexMethod* method = make_dexmethod(cpool, self, cpmethod);
-      if (method == nullptr) return false;
-      cc.add_method(method);
-      invoke_attr_hook({method}, attrPtr);
+  for (const auto& member : record.methods) {
+    DexMethod* method = make_dexmethod(self, member);
+    if (method == nullptr) return false;
+    cc.add_method(method);
+    if (member_hook) {
+      member_hook({method}, member);
     }
   }
   DexClass* dc = cc.create();
@@ -533,6 +696,53 @@ bool parse_class(uint8_t* buffer,
   return true;
 }
 
+static bool parse_class_impl(uint8_t* buffer,
+                             Scope* classes,
+                             const attribute_hook_t& attr_hook,
+                             const std::string& jar_location,
+                             JarCacheWriter* cache_writer) {
+  std::vector<cp_entry> cpool;
+  ClassRecord record;
+  if (!decode_class(buffer, cpool, &record)) {
+    return false;
+  }
+  if (cache_writer != nullptr && !is_module((DexAccessFlags)record.aflags)) {
+    cache_writer->add(record);
+  }
+
+  member_hook_t member_hook;
+  if (attr_hook != nullptr) {
+    member_hook = [&](const boost::variant<DexField*, DexMethod*>&
+                          field_or_method,
+                      const MemberRecord& member) {
+      uint8_t* attrPtr = member.attributes;
+      uint16_t attributes_count = read16(attrPtr);
+      for (uint16_t j = 0; j < attributes_count; j++) {
+        uint16_t attribute_name_index = read16(attrPtr);
+        uint32_t attribute_length = read32(attrPtr);
+        char attribute_name[MAX_CLASS_NAMELEN];
+        auto extract_res = extract_utf8(cpool, attribute_name_index,
+                                        attribute_name, MAX_CLASS_NAMELEN);
+        always_assert_log(
+            extract_res,
+            "attribute hook was specified, but failed to load the attribute "
+            "name due to insufficient name buffer");
+        attr_hook(field_or_method, attribute_name, attrPtr);
+        attrPtr += attribute_length;
+      }
+    };
+  }
+  return create_class(record, classes, member_hook, jar_location);
+}
+
+bool parse_class(uint8_t* buffer,
+                 Scope* classes,
+                 attribute_hook_t attr_hook,
+                 const std::string& jar_location) {
+  return parse_class_impl(buffer, classes, attr_hook, jar_location,
+                          /* cache_writer */ nullptr);
+}
+
 bool load_class_file(const std::string& filename, Scope* classes) {
   // It's not exactly efficient to call init_basic_types repeatedly for each
   // class file that we load, but load_class_file should typically only be used
@@ -694,32 +904,68 @@ static bool get_jar_entries(const uint8_t* mapping,
   return true;
 }
 
-static int jar_uncompress(Bytef* dest,
-                          uLongf* destLen,
-                          const Bytef* source,
-                          uLong sourceLen) {
-  z_stream stream;
-  int err;
+namespace {
 
-  stream.next_in = (Bytef*)source;
-  stream.avail_in = (uInt)sourceLen;
-  stream.next_out = dest;
-  stream.avail_out = (uInt)*destLen;
-  stream.zalloc = (alloc_func)0;
-  stream.zfree = (free_func)0;
+/*
+ * A raw inflate stream that is set up once and reset between entries. Setting
+ * up a z_stream allocates the ~40KB inflate state and window, which dominates
+ * the cost of inflating the many small entries of a typical jar.
+ */
+class Inflater {
+ public:
+  Inflater() {
+    m_stream.zalloc = (alloc_func)0;
+    m_stream.zfree = (free_func)0;
+    m_stream.opaque = (voidpf)0;
+    m_stream.next_in = Z_NULL;
+    m_stream.avail_in = 0;
+    m_init = inflateInit2(&m_stream, -MAX_WBITS);
+  }
 
-  err = inflateInit2(&stream, -MAX_WBITS);
-  if (err != Z_OK) return err;
+  ~Inflater() {
+    if (m_init == Z_OK) {
+      inflateEnd(&m_stream);
+    }
+  }
 
-  err = inflate(&stream, Z_FINISH);
-  if (err != Z_STREAM_END) {
-    inflateEnd(&stream);
-    return err;
+  Inflater(const Inflater&) = delete;
+  Inflater& operator=(const Inflater&) = delete;
+
+  int uncompress(Bytef* dest,
+                 uLongf* destLen,
+                 const Bytef* source,
+                 uLong sourceLen) {
+    if (m_init != Z_OK) return m_init;
+    int err = inflateReset(&m_stream);
+    if (err != Z_OK) return err;
+
+    m_stream.next_in = (Bytef*)source;
+    m_stream.avail_in = (uInt)sourceLen;
+    m_stream.next_out = dest;
+    m_stream.avail_out = (uInt)*destLen;
+
+    err = inflate(&m_stream, Z_FINISH);
+    if (err != Z_STREAM_END) {
+      return err == Z_OK ? Z_BUF_ERROR : err;
+    }
+    *destLen = m_stream.total_out;
+    return Z_OK;
   }
-  *destLen = stream.total_out;
 
-  err = inflateEnd(&stream);
-  return err;
+ private:
+  z_stream m_stream;
+  int m_init;
+};
+
+} // namespace
+
+static int jar_uncompress(Bytef* dest,
+                          uLongf* destLen,
+                          const Bytef* source,
+                          uLong sourceLen) {
+  // Jars are inflated from worker threads, so each thread keeps its own stream.
+  thread_local Inflater inflater;
+  return inflater.uncompress(dest, destLen, source, sourceLen);
 }
 
 static bool decompress_class(jar_entry& file,
@@ -775,24 +1021,29 @@ static bool decompress_class(jar_entry& file,
 
 static const int kStartBufferSize = 128 * 1024;
 
+static bool is_class_entry(const jar_entry& file) {
+  static char classEndString[] = ".class";
+  static size_t classEndStringLen = strlen(classEndString);
+  if (file.cd_entry.ucomp_size == 0) return false;
+  if (file.cd_entry.fname_len < (classEndStringLen + 1)) return false;
+
+  // Skip non-class files
+  uint8_t* endcomp =
+      file.filename + (file.cd_entry.fname_len - classEndStringLen);
+  return memcmp(endcomp, classEndString, classEndStringLen) == 0;
+}
+
 static bool process_jar_entries(const char* location,
                                 std::vector<jar_entry>& files,
                                 const uint8_t* mapping,
                                 Scope* classes,
-                                const attribute_hook_t& attr_hook) {
+                                const attribute_hook_t& attr_hook,
+                                JarCacheWriter* cache_writer) {
   ssize_t bufsize = kStartBufferSize;
   uint8_t* outbuffer = (uint8_t*)malloc(bufsize);
-  static char classEndString[] = ".class";
-  static size_t classEndStringLen = strlen(classEndString);
   init_basic_types();
   for (auto& file : files) {
-    if (file.cd_entry.ucomp_size == 0) continue;
-    if (file.cd_entry.fname_len < (classEndStringLen + 1)) continue;
-
-    // Skip non-class files
-    uint8_t* endcomp =
-        file.filename + (file.cd_entry.fname_len - classEndStringLen);
-    if (memcmp(endcomp, classEndString, classEndStringLen) != 0) continue;
+    if (!is_class_entry(file)) continue;
 
     // Resize output if necessary.
     if (bufsize < file.cd_entry.ucomp_size) {
@@ -807,7 +1058,8 @@ static bool process_jar_entries(const char* location,
       return false;
     }
 
-    if (!parse_class(outbuffer, classes, attr_hook, location)) {
+    if (!parse_class_impl(outbuffer, classes, attr_hook, location,
+                          cache_writer)) {
       free(outbuffer);
       return false;
     }
@@ -816,22 +1068,33 @@ static bool process_jar_entries(const char* location,
   return true;
 }
 
-bool process_jar(const char* location,
-                 const uint8_t* mapping,
-                 ssize_t size,
-                 Scope* classes,
-                 const attribute_hook_t& attr_hook) {
+static bool process_jar_impl(const char* location,
+                             const uint8_t* mapping,
+                             ssize_t size,
+                             Scope* classes,
+                             const attribute_hook_t& attr_hook,
+                             JarCacheWriter* cache_writer) {
   pk_cdir_end pce;
   std::vector<jar_entry> files;
   if (!find_central_directory(mapping, size, pce)) return false;
   if (!validate_pce(pce, size)) return false;
   if (!get_jar_entries(mapping, pce, files)) return false;
-  if (!process_jar_entries(location, files, mapping, classes, attr_hook)) {
+  if (!process_jar_entries(location, files, mapping, classes, attr_hook,
+                           cache_writer)) {
     return false;
   }
   return true;
 }
 
+bool process_jar(const char* location,
+                 const uint8_t* mapping,
+                 ssize_t size,
+                 Scope* classes,
+                 const attribute_hook_t& attr_hook) {
+  return process_jar_impl(location, mapping, size, classes, attr_hook,
+                          /* cache_writer */ nullptr);
+}
+
 bool load_jar_file(const char* location,
                    Scope* classes,
                    const attribute_hook_t& attr_hook) {
@@ -851,6 +1114,310 @@ bool load_jar_file(const char* location,
   return true;
 }
 
+static std::string sha1_hex(const uint8_t* data, size_t size) {
+  Sha1Context context;
+  sha1_init(&context);
+  constexpr size_t kChunkSize = 1 << 30;
+  for (size_t offset = 0; offset < size; offset += kChunkSize) {
+    sha1_update(&context, data + offset,
+                (unsigned int)std::min(kChunkSize, size - offset));
+  }
+  unsigned char digest[20];
+  sha1_final(digest, &context);
+  std::string hex;
+  hex.reserve(2 * sizeof(digest));
+  for (auto byte : digest) {
+    static const char kHexDigits[] = "0123456789abcdef";
+    hex.push_back(kHexDigits[byte >> 4]);
+    hex.push_back(kHexDigits[byte & 0xf]);
+  }
+  return hex;
+}
+
+/*
+ * Returns false if the cache doesn't exist or is invalid. On success, the
+ * records point into `file`.
+ */
+static bool read_jar_cache(const std::string& cache_path,
+                           boost::iostreams::mapped_file_source* file,
+                           std::vector<ClassRecord>* out) {
+  boost::system::error_code ec;
+  if (!boost::filesystem::exists(cache_path, ec)) {
+    return false;
+  }
+  try {
+    file->open(cache_path);
+  } catch (const std::exception& e) {
+    return false;
+  }
+
+  auto ptr = reinterpret_cast<const uint8_t*>(file->data());
+  auto end = ptr + file->size();
+  bool ok = true;
+  auto read = [&](auto* value) {
+    if (end - ptr < (ssize_t)sizeof(*value)) {
+      ok = false;
+      return;
+    }
+    memcpy(value, ptr, sizeof(*value));
+    ptr += sizeof(*value);
+  };
+
+  JarCacheHeader header;
+  read(&header);
+  if (!ok || header.magic != kJarCacheMagic ||
+      header.version != kJarCacheVersion) {
+    return false;
+  }
+
+  std::vector<std::string_view> strings;
+  strings.reserve(header.num_strings);
+  for (uint32_t i = 0; i < header.num_strings; i++) {
+    uint32_t length;
+    read(&length);
+    if (!ok || end - ptr < (ssize_t)length) {
+      return false;
+    }
+    strings.emplace_back(reinterpret_cast<const char*>(ptr), length);
+    ptr += length;
+  }
+  auto read_string = [&](std::string_view* out) {
+    uint32_t idx;
+    read(&idx);
+    if (!ok || idx == kNoString) {
+      return;
+    }
+    if (idx >= strings.size()) {
+      ok = false;
+      return;
+    }
+    *out = strings[idx];
+  };
+
+  std::vector<ClassRecord> records(header.num_classes);
+  for (auto& record : records) {
+    uint16_t count;
+    read(&record.aflags);
+    read_string(&record.name);
+    read_string(&record.super_name);
+    read(&count);
+    record.interfaces.resize(ok ? count : 0);
+    for (auto& iface_name : record.interfaces) {
+      read_string(&iface_name);
+    }
+    for (auto* members : {&record.fields, &record.methods}) {
+      read(&count);
+      members->resize(ok ? count : 0);
+      for (auto& member : *members) {
+        read(&member.aflags);
+        read_string(&member.name);
+        read_string(&member.desc);
+      }
+    }
+    if (!ok) {
+      return false;
+    }
+  }
+  if (ptr != end) {
+    return false;
+  }
+  *out = std::move(records);
+  return true;
+}
+
+static bool create_classes(const std::vector<ClassRecord>& records,
+                           const char* location,
+                           Scope* classes) {
+  init_basic_types();
+  for (const auto& record : records) {
+    if (!create_class(record, classes, /* member_hook */ nullptr, location)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+ * Everything is validated before any class gets created.
+ */
+static bool load_jar_cache(const std::string& cache_path,
+                           const char* location,
+                           Scope* classes) {
+  boost::iostreams::mapped_file_source file;
+  std::vector<ClassRecord> records;
+  return read_jar_cache(cache_path, &file, &records) &&
+         create_classes(records, location, classes);
+}
+
+bool load_jar_file_cached(const char* location,
+                          const std::string& cache_dir,
+                          Scope* classes) {
+  boost::iostreams::mapped_file file;
+  try {
+    file.open(location, boost::iostreams::mapped_file::readonly);
+  } catch (const std::exception& e) {
+    fprintf(stderr, "error: cannot open jar file: %s\n", location);
+    return false;
+  }
+
+  auto mapping = reinterpret_cast<const uint8_t*>(file.const_data());
+  auto cache_path = (boost::filesystem::path(cache_dir) /
+                     (sha1_hex(mapping, file.size()) + ".jarcache"))
+                        .string();
+  if (load_jar_cache(cache_path, location, classes)) {
+    TRACE(MAIN, 2, "Loaded jar %s from cache %s", location,
+          cache_path.c_str());
+    return true;
+  }
+
+  JarCacheWriter cache_writer;
+  if (!process_jar_impl(location, mapping, file.size(), classes,
+                        /* attr_hook */ nullptr, &cache_writer)) {
+    fprintf(stderr, "error: cannot process jar: %s\n", location);
+    return false;
+  }
+  if (!cache_writer.write(cache_path)) {
+    fprintf(stderr, "warning: cannot write jar cache: %s\n",
+            cache_path.c_str());
+  }
+  return true;
+}
+
+namespace {
+
+// Bounds the decompressed class files held in memory at once.
+constexpr size_t kMaxParallelJarBytes = 512 * 1024 * 1024;
+
+struct PreparedJar {
+  boost::iostreams::mapped_file file;
+  std::vector<jar_entry> entries;
+  // Indices of the class file entries, and their decoded contents.
+  std::vector<size_t> class_entries;
+  std::vector<std::unique_ptr<uint8_t[]>> buffers;
+  std::vector<ClassRecord> records;
+  std::string cache_path;
+  boost::iostreams::mapped_file_source cache_file;
+  bool from_cache{false};
+  std::atomic<bool> failed{false};
+};
+
+} // namespace
+
+std::vector<bool> load_jar_files(const std::vector<std::string>& locations,
+                                 std::vector<Scope>* classes,
+                                 const std::string& cache_dir) {
+  size_t num_jars = locations.size();
+  std::vector<bool> loaded(num_jars, false);
+  classes->resize(num_jars);
+  std::vector<std::unique_ptr<PreparedJar>> jars(num_jars);
+  std::vector<size_t> indices(num_jars);
+  std::iota(indices.begin(), indices.end(), 0);
+
+  // Map the jars, consult the cache and read the central directories.
+  workqueue_run<size_t>(
+      [&](size_t i) {
+        auto jar = std::make_unique<PreparedJar>();
+        const char* location = locations[i].c_str();
+        try {
+          jar->file.open(location, boost::iostreams::mapped_file::readonly);
+        } catch (const std::exception& e) {
+          fprintf(stderr, "error: cannot open jar file: %s\n", location);
+          jar->failed = true;
+          jars[i] = std::move(jar);
+          return;
+        }
+        auto mapping = reinterpret_cast<const uint8_t*>(jar->file.const_data());
+        ssize_t size = jar->file.size();
+        if (!cache_dir.empty()) {
+          jar->cache_path = (boost::filesystem::path(cache_dir) /
+                             (sha1_hex(mapping, size) + ".jarcache"))
+                                .string();
+          jar->from_cache = read_jar_cache(jar->cache_path, &jar->cache_file,
+                                           &jar->records);
+        }
+        pk_cdir_end pce;
+        if (!jar->from_cache &&
+            (!find_central_directory(mapping, size, pce) ||
+             !validate_pce(pce, size) ||
+             !get_jar_entries(mapping, pce, jar->entries))) {
+          jar->failed = true;
+        }
+        for (size_t e = 0; e < jar->entries.size(); e++) {
+          if (is_class_entry(jar->entries[e])) {
+            jar->class_entries.push_back(e);
+          }
+        }
+        jar->buffers.resize(jar->class_entries.size());
+        jar->records.resize(std::max(jar->records.size(),
+                                     jar->class_entries.size()));
+        jars[i] = std::move(jar);
+      },
+      indices);
+
+  size_t batch_begin = 0;
+  while (batch_begin < num_jars) {
+    // Decompress and decode the class files of a batch of jars in parallel.
+    size_t batch_end = batch_begin;
+    size_t batch_bytes = 0;
+    std::vector<std::pair<size_t, size_t>> tasks;
+    do {
+      auto& jar = *jars[batch_end];
+      for (size_t c = 0; !jar.failed && c < jar.class_entries.size(); c++) {
+        tasks.emplace_back(batch_end, c);
+        batch_bytes += jar.entries[jar.class_entries[c]].cd_entry.ucomp_size;
+      }
+      batch_end++;
+    } while (batch_end < num_jars && batch_bytes < kMaxParallelJarBytes);
+
+    workqueue_run<std::pair<size_t, size_t>>(
+        [&](const std::pair<size_t, size_t>& task) {
+          auto& jar = *jars[task.first];
+          auto& file = jar.entries[jar.class_entries[task.second]];
+          auto mapping =
+              reinterpret_cast<const uint8_t*>(jar.file.const_data());
+          size_t bufsize = file.cd_entry.ucomp_size;
+          auto& buffer = jar.buffers[task.second];
+          buffer = std::make_unique<uint8_t[]>(bufsize);
+          std::vector<cp_entry> cpool;
+          if (!decompress_class(file, mapping, buffer.get(), bufsize) ||
+              !decode_class(buffer.get(), cpool, &jar.records[task.second])) {
+            jar.failed = true;
+          }
+        },
+        tasks);
+
+    // Create the classes in order, so that duplicates resolve exactly as if
+    // the jars had been loaded one after another.
+    init_basic_types();
+    for (size_t i = batch_begin; i < batch_end; i++) {
+      auto& jar = *jars[i];
+      const char* location = locations[i].c_str();
+      if (jar.failed ||
+          !create_classes(jar.records, location, &(*classes)[i])) {
+        fprintf(stderr, "error: cannot process jar: %s\n", location);
+        jars[i].reset();
+        continue;
+      }
+      loaded[i] = true;
+      if (!jar.cache_path.empty() && !jar.from_cache) {
+        JarCacheWriter cache_writer;
+        for (const auto& record : jar.records) {
+          if (!is_module((DexAccessFlags)record.aflags)) {
+            cache_writer.add(record);
+          }
+        }
+        if (!cache_writer.write(jar.cache_path)) {
+          fprintf(stderr, "warning: cannot write jar cache: %s\n",
+                  jar.cache_path.c_str());
+        }
+      }
+      jars[i].reset();
+    }
+    batch_begin = batch_end;
+  }
+  return loaded;
+}
+
 //#define LOCAL_MAIN
 #ifdef LOCAL_MAIN
 int main(int argc, char* argv[]) {
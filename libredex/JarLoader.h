@@ -15,6 +15,8 @@ class DexMethod;
 #include "ConfigFiles.h"
 
 #include <functional>
+#include <string>
+#include <vector>
 
 namespace JarLoaderUtil {
 uint32_t read32(uint8_t*& buffer);
@@ -30,6 +32,31 @@ bool load_jar_file(const char* location,
                    Scope* classes = nullptr,
                    const attribute_hook_t& = nullptr);
 
+/*
+ * Like load_jar_file, but looks the jar's classes up in `cache_dir` first,
+ * keyed on the SHA1 of the jar's contents. On a miss, the jar is parsed and
+ * the cache gets populated. Loading from the cache yields the same classes as
+ * parsing the jar, without decompressing and decoding any class files.
+ */
+bool load_jar_file_cached(const char* location,
+                          const std::string& cache_dir,
+                          Scope* classes = nullptr);
+
+/*
+ * Loads the given jars, and optionally caches them like
+ * load_jar_file_cached. Class files are decompressed and decoded in parallel,
+ * across jars as well as within each jar. Classes are then created in the
+ * order of `locations` and of the entries in each jar, so the result,
+ * including which of several duplicate classes wins, is the same as loading
+ * the jars one after another.
+ *
+ * The classes of `locations[i]` are stored in `(*classes)[i]`. Returns
+ * whether each jar could be loaded.
+ */
+std::vector<bool> load_jar_files(const std::vector<std::string>& locations,
+                                 std::vector<Scope>* classes,
+                                 const std::string& cache_dir = "");
+
 bool load_class_file(const std::string& filename, Scope* classes = nullptr);
 
 void init_basic_types();
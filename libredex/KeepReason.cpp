@@ -7,6 +7,9 @@
 
 #include "KeepReason.h"
 
+#include <algorithm>
+#include <thread>
+
 #include "ProguardPrintConfiguration.h"
 #include "RedexContext.h"
 #include "Show.h"
@@ -47,4 +50,52 @@ size_t hash_value(const Reason& reason) {
   return seed;
 }
 
+void Recorder::record(const void* owner, const Reason& reason) {
+  auto& log = m_logs[std::hash<std::thread::id>()(std::this_thread::get_id()) %
+                     m_logs.size()];
+  {
+    std::lock_guard<std::mutex> lock(log.mutex);
+    log.entries.emplace_back(owner, reason);
+  }
+  if (!m_has_pending.load(std::memory_order_relaxed)) {
+    m_has_pending.store(true, std::memory_order_release);
+  }
+}
+
+void Recorder::consolidate() {
+  if (!m_has_pending.load(std::memory_order_acquire)) {
+    return;
+  }
+  std::lock_guard<std::mutex> consolidation_lock(m_consolidation_mutex);
+  if (!m_has_pending.load(std::memory_order_relaxed)) {
+    return;
+  }
+  for (auto& log : m_logs) {
+    std::lock_guard<std::mutex> lock(log.mutex);
+    for (const auto& entry : log.entries) {
+      const Reason* reason = &*m_interned.insert(entry.second).first;
+      auto& reasons = m_reasons[entry.first];
+      if (std::find(reasons.begin(), reasons.end(), reason) == reasons.end()) {
+        reasons.push_back(reason);
+      }
+    }
+    log.entries.clear();
+    log.entries.shrink_to_fit();
+  }
+  m_has_pending.store(false, std::memory_order_release);
+}
+
+const std::vector<const Reason*>& Recorder::reasons_of(const void* owner) {
+  static const std::vector<const Reason*> no_reasons;
+  consolidate();
+  auto it = m_reasons.find(owner);
+  return it == m_reasons.end() ? no_reasons : it->second;
+}
+
+void Recorder::forget(const void* owner) {
+  consolidate();
+  std::lock_guard<std::mutex> consolidation_lock(m_consolidation_mutex);
+  m_reasons.erase(owner);
+}
+
 } // namespace keep_reason
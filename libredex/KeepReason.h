@@ -7,11 +7,18 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <boost/functional/hash.hpp>
+#include <mutex>
 #include <ostream>
+#include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "Debug.h"
+#include "Thread.h"
 
 class DexMethod;
 
@@ -81,4 +88,40 @@ struct ReasonPtrEqual {
 using ReasonPtrSet =
     std::unordered_set<const Reason*, ReasonPtrHash, ReasonPtrEqual>;
 
+/*
+ * The keep reasons of all classes and members, see
+ * RedexContext::record_keep_reasons().
+ *
+ * Recording only appends the owner and the reason, by value, to one of a few
+ * logs picked by thread, so it neither allocates per owner nor interns
+ * anything. The logs are grouped by owner, and the reasons interned, on the
+ * first lookup after recording. Lookups may run concurrently with each other,
+ * but not with recording.
+ */
+class Recorder {
+ public:
+  void record(const void* owner, const Reason& reason);
+
+  // The distinct reasons recorded for `owner`.
+  const std::vector<const Reason*>& reasons_of(const void* owner);
+
+  // Drops the reasons of an owner which is being destroyed.
+  void forget(const void* owner);
+
+ private:
+  void consolidate();
+
+  struct alignas(CACHE_LINE_SIZE) Log {
+    std::mutex mutex;
+    std::vector<std::pair<const void*, Reason>> entries;
+  };
+  std::array<Log, 64> m_logs;
+  std::atomic<bool> m_has_pending{false};
+
+  std::mutex m_consolidation_mutex;
+  // Node-based, so that the interned reasons never move.
+  std::unordered_set<Reason, boost::hash<Reason>> m_interned;
+  std::unordered_map<const void*, std::vector<const Reason*>> m_reasons;
+};
+
 } // namespace keep_reason
@@ -7,8 +7,11 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 
 template <typename T>
@@ -71,3 +74,91 @@ class LazyUnorderedMap {
   std::function<T(const Key& key)> m_creator;
   std::unordered_map<Key, T, Hash, KeyEqual, Allocator> m_map;
 };
+
+template <typename T>
+// A thread-safe variant of Lazy. The value is created exactly once, by the
+// first thread that needs it; other threads needing it in the meantime wait
+// until it is created.
+class ConcurrentLazy {
+ public:
+  ConcurrentLazy() = delete;
+  ConcurrentLazy(const ConcurrentLazy&) = delete;
+  ConcurrentLazy& operator=(const ConcurrentLazy&) = delete;
+  explicit ConcurrentLazy(const std::function<T()>& creator)
+      : m_creator([creator] { return std::make_unique<T>(creator()); }) {}
+  explicit ConcurrentLazy(const std::function<std::unique_ptr<T>()>& creator)
+      : m_creator(creator) {}
+  // NOLINTNEXTLINE(google-explicit-constructor,hicpp-explicit-conversions)
+  operator bool() const { return m_initialized.load(); }
+  T& operator*() {
+    init();
+    return *m_value;
+  }
+  T* operator->() {
+    init();
+    return m_value.get();
+  }
+
+ private:
+  std::function<std::unique_ptr<T>()> m_creator;
+  std::unique_ptr<T> m_value;
+  std::once_flag m_once;
+  std::atomic<bool> m_initialized{false};
+  void init() {
+    std::call_once(m_once, [this] {
+      m_value = m_creator();
+      // Release whatever memory is associated with creator
+      m_creator = std::function<std::unique_ptr<T>()>();
+      m_initialized.store(true);
+    });
+  }
+};
+
+template <class Key,
+          class T,
+          class Hash = std::hash<Key>,
+          class KeyEqual = std::equal_to<Key>,
+          size_t n_slots = 31>
+// A thread-safe variant of LazyUnorderedMap, e.g. for per-method summaries
+// that are only computed for the methods queried from a parallel walk. The
+// creator runs at most once per key (unless it throws), concurrently for
+// different keys; threads querying a key that is being created wait for it.
+// References to values stay valid for the lifetime of the map.
+class ConcurrentLazyUnorderedMap {
+ public:
+  ConcurrentLazyUnorderedMap() = delete;
+  ConcurrentLazyUnorderedMap(const ConcurrentLazyUnorderedMap&) = delete;
+  ConcurrentLazyUnorderedMap& operator=(const ConcurrentLazyUnorderedMap&) =
+      delete;
+  explicit ConcurrentLazyUnorderedMap(std::function<T(const Key& key)> creator)
+      : m_creator(std::move(creator)) {}
+  T& operator[](const Key& key) {
+    Entry* entry;
+    {
+      // The lock is only held to find the entry, not to create its value.
+      size_t slot = Hash()(key) % n_slots;
+      std::lock_guard<std::mutex> lock(m_locks[slot]);
+      auto& ptr = m_maps[slot][key];
+      if (!ptr) {
+        ptr = std::make_unique<Entry>();
+      }
+      entry = ptr.get();
+    }
+    std::call_once(entry->once, [&] {
+      entry->value = std::make_unique<T>(m_creator(key));
+    });
+    return *entry->value;
+  }
+
+ private:
+  struct Entry {
+    std::once_flag once;
+    std::unique_ptr<T> value;
+  };
+
+  std::function<T(const Key& key)> m_creator;
+  std::array<std::mutex, n_slots> m_locks;
+  std::array<std::unordered_map<Key, std::unique_ptr<Entry>, Hash, KeyEqual>,
+             n_slots>
+      m_maps;
+};
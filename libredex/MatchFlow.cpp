@@ -26,6 +26,11 @@ result_t flow_t::find(cfg::ControlFlowGraph& cfg,
     lixs.insert(l.m_ix);
   }
 
+  if (!detail::may_match(cfg, m_constraints, lixs)) {
+    TRACE(MFLOW, 6, "find: No instruction can match a root, skipping.");
+    return result_t{detail::Locations{}};
+  }
+
   TRACE(MFLOW, 6, "find: Building Instruction Graph");
   auto dfg = detail::instruction_graph(cfg, m_constraints, lixs);
 
@@ -8,6 +8,7 @@
 #include "MatchFlowDetail.h"
 
 #include <algorithm>
+#include <functional>
 #include <queue>
 
 #include <boost/optional/optional.hpp>
@@ -550,5 +551,56 @@ DataFlowGraph instruction_graph(cfg::ControlFlowGraph& cfg,
   return graph;
 }
 
+bool may_match(cfg::ControlFlowGraph& cfg,
+               const std::vector<Constraint>& constraints,
+               const std::unordered_set<LocationIx>& roots) {
+  std::vector<IRInstruction*> insns;
+  for (auto& mie : cfg::InstructionIterable(cfg)) {
+    insns.push_back(mie.insn);
+  }
+
+  enum class State : uint8_t { unknown, visiting, yes, no };
+  std::vector<State> states(constraints.size(), State::unknown);
+
+  std::function<bool(LocationIx)> satisfiable = [&](LocationIx loc) {
+    switch (states[loc]) {
+    case State::yes:
+      return true;
+    case State::no:
+      return false;
+    case State::visiting:
+      // Be optimistic about cycles: Assuming they can be satisfied errs on the
+      // side of running the full analysis.
+      return true;
+    case State::unknown:
+      break;
+    }
+
+    states[loc] = State::visiting;
+    const auto& constraint = constraints.at(loc);
+    const auto operands_satisfiable = [&](const IRInstruction* insn) {
+      for (src_index_t ix = 0; ix < insn->srcs_size(); ++ix) {
+        const auto& src = constraint.src(ix);
+        if (src.loc != NO_LOC && src.quant != QuantFlag::forall &&
+            !satisfiable(src.loc)) {
+          return false;
+        }
+      }
+      return true;
+    };
+
+    bool result = std::any_of(insns.begin(), insns.end(), [&](auto* insn) {
+      return constraint.insn_matcher->matches(insn) &&
+             operands_satisfiable(insn);
+    });
+
+    TRACE(MFLOW, 6, "may_match: L%zu %s", loc, result ? "yes" : "no");
+    states[loc] = result ? State::yes : State::no;
+    return result;
+  };
+
+  return std::any_of(roots.begin(), roots.end(), satisfiable);
+}
+
 } // namespace detail
 } // namespace mf
@@ -351,6 +351,20 @@ DataFlowGraph instruction_graph(cfg::ControlFlowGraph& cfg,
                                 const std::vector<Constraint>& constraints,
                                 const std::unordered_set<LocationIx>& roots);
 
+/**
+ * A necessary condition for any instruction in `cfg` to match a constraint in
+ * `roots`: Some instruction matches the root's predicate, and, for each of its
+ * operands under an exists or unique constraint, some instruction in `cfg`
+ * (recursively) satisfies the same condition for that operand's location.
+ *
+ * This evaluates each predicate at most once per instruction, so it is much
+ * cheaper than `instruction_graph`, and can be used to skip it when there
+ * cannot be any results.
+ */
+bool may_match(cfg::ControlFlowGraph& cfg,
+               const std::vector<Constraint>& constraints,
+               const std::unordered_set<LocationIx>& roots);
+
 inline void Constraint::add_src(src_index_t ix,
                                 LocationIx loc,
                                 AliasFlag alias,
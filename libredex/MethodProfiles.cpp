@@ -8,12 +8,16 @@
 #include "MethodProfiles.h"
 
 #include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
 #include <fstream>
 #include <iostream>
+#include <numeric>
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "RedexMappedFile.h"
 #include "Show.h"
+#include "WorkQueue.h"
 
 using namespace method_profiles;
 
@@ -38,6 +42,53 @@ bool parse_cells(std::string& line, const Func& parse_cell) {
   return true;
 }
 
+// Like parse_cells, but without modifying or copying the line. Empty cells are
+// skipped, as they are by strtok_r.
+template <class Func>
+bool parse_cells(std::string_view line, const Func& parse_cell) {
+  uint32_t i = 0;
+  size_t pos = 0;
+  while (pos < line.size()) {
+    size_t end = line.find(',', pos);
+    if (end == std::string_view::npos) {
+      end = line.size();
+    }
+    if (end != pos) {
+      if (!parse_cell(line.substr(pos, end - pos), i)) {
+        return false;
+      }
+      ++i;
+    }
+    pos = end + 1;
+  }
+  return true;
+}
+
+// Returns the line starting at `*pos`, without its newline, and moves `*pos`
+// to the start of the next line.
+std::string_view next_line(std::string_view data, size_t* pos) {
+  size_t end = data.find('\n', *pos);
+  if (end == std::string_view::npos) {
+    end = data.size();
+  }
+  auto line = data.substr(*pos, end - *pos);
+  *pos = end + 1;
+  return line;
+}
+
+// Calls `fn` with a NUL-terminated copy of `tok`, which is kept on the stack
+// for the short cells that numbers come in.
+template <class Func>
+auto with_c_str(std::string_view tok, const Func& fn) {
+  char buf[64];
+  if (tok.size() < sizeof(buf)) {
+    memcpy(buf, tok.data(), tok.size());
+    buf[tok.size()] = '\0';
+    return fn(buf);
+  }
+  return fn(std::string(tok).c_str());
+}
+
 } // namespace
 
 const StatsMap& MethodProfiles::method_stats(
@@ -67,17 +118,33 @@ bool MethodProfiles::parse_stats_file(const std::string& csv_filename) {
     return false;
   }
 
-  // Using C-style file reading and parsing because it's faster than the
-  // iostreams equivalent and we expect to read very large csv files.
-  std::ifstream ifs(csv_filename);
-  if (!ifs.good()) {
+  // We expect to read very large csv files, so map them and parse the main
+  // section in parallel.
+  boost::system::error_code ec;
+  auto file_size = boost::filesystem::file_size(csv_filename, ec);
+  if (ec) {
     std::cerr << "FAILED to open " << csv_filename << std::endl;
     return false;
   }
+  std::unique_ptr<RedexMappedFile> mapped;
+  std::string_view data;
+  if (file_size > 0) {
+    try {
+      mapped = std::make_unique<RedexMappedFile>(
+          RedexMappedFile::open(csv_filename));
+    } catch (const std::exception& e) {
+      std::cerr << "FAILED to open " << csv_filename << ": " << e.what()
+                << std::endl;
+      return false;
+    }
+    data = std::string_view(mapped->const_data(), mapped->size());
+  }
 
-  // getline will allocate a buffer and put a pointer to it here
-  std::string line;
-  while (std::getline(ifs, line)) {
+  // The header and metadata lines are parsed serially. Everything after the
+  // main header is data.
+  size_t pos = 0;
+  while (pos < data.size() && m_mode != MAIN) {
+    std::string line(next_line(data, &pos));
     bool success = false;
     if (m_mode == NONE) {
       success = parse_header(line);
@@ -88,8 +155,7 @@ bool MethodProfiles::parse_stats_file(const std::string& csv_filename) {
       return false;
     }
   }
-  if (ifs.bad()) {
-    std::cerr << "FAILED to read a line!" << std::endl;
+  if (pos < data.size() && !parse_main_rows(data.substr(pos))) {
     return false;
   }
 
@@ -155,42 +221,42 @@ bool MethodProfiles::parse_metadata(std::string& line) {
   return true;
 }
 
-bool MethodProfiles::parse_main(std::string& line) {
+bool MethodProfiles::parse_main_row(std::string_view line,
+                                    ParsedRow* row) const {
   always_assert(m_mode == MAIN);
-  Stats stats;
-  std::string interaction_id;
-  DexMethodRef* ref = nullptr;
-  auto parse_cell = [&](char* tok, uint32_t col) -> bool {
+  auto& stats = row->stats;
+  auto parse_cell = [&](std::string_view tok, uint32_t col) -> bool {
     switch (col) {
     case INDEX:
       // Don't need this raw data. It's an arbitrary index (the line number in
       // the file)
       return true;
     case NAME:
-      ref = DexMethod::get_method</*kCheckFormat=*/true>(tok);
-      if (ref == nullptr) {
-        TRACE(METH_PROF, 6, "failed to resolve %s", tok);
+      row->ref = DexMethod::get_method</*kCheckFormat=*/true>(std::string(tok));
+      if (row->ref == nullptr) {
+        TRACE(METH_PROF, 6, "failed to resolve %.*s", (int)tok.size(),
+              tok.data());
       }
       return true;
     case APPEAR100:
-      stats.appear_percent = parse_double(tok);
+      stats.appear_percent = with_c_str(tok, parse_double);
       return true;
     case APPEAR_NUMBER:
       // Don't need this raw data. appear_percent is the same thing but
       // normalized
       return true;
     case AVG_CALL:
-      stats.call_count = parse_double(tok);
+      stats.call_count = with_c_str(tok, parse_double);
       return true;
     case AVG_ORDER:
       // Don't need this raw data. order_percent is the same thing but
       // normalized
       return true;
     case AVG_RANK100:
-      stats.order_percent = parse_double(tok);
+      stats.order_percent = with_c_str(tok, parse_double);
       return true;
     case MIN_API_LEVEL: {
-      int64_t level = parse_int(tok);
+      int64_t level = with_c_str(tok, parse_int);
       always_assert(level <= std::numeric_limits<int16_t>::max());
       always_assert(level >= std::numeric_limits<int16_t>::min());
       stats.min_api_level = static_cast<int16_t>(level);
@@ -200,10 +266,10 @@ bool MethodProfiles::parse_main(std::string& line) {
       const auto& search = m_optional_columns.find(col);
       if (search != m_optional_columns.end()) {
         if (search->second == "interaction") {
-          interaction_id = tok;
-          if (interaction_id.back() == '\n') {
-            interaction_id.resize(interaction_id.size() - 1);
+          if (tok.back() == '\n') {
+            tok.remove_suffix(1);
           }
+          row->interaction_id = tok;
           return true;
         }
       }
@@ -211,26 +277,107 @@ bool MethodProfiles::parse_main(std::string& line) {
       return false;
     }
   };
+  return parse_cells(line, parse_cell);
+}
 
-  std::string copy(line);
-  bool success = parse_cells(line, parse_cell);
-  if (!success) {
+bool MethodProfiles::parse_main(std::string& line) {
+  ParsedRow row;
+  if (!parse_main_row(line, &row)) {
     return false;
   }
-  if (interaction_id.empty()) {
-    // Interaction IDs from the current row have priority over the interaction
-    // id from the top of the file. This shouldn't happen in practice, but this
-    // is the conservative approach.
-    interaction_id = m_interaction_id;
-  }
-  if (ref != nullptr) {
-    TRACE(METH_PROF, 6, "(%s, %s) -> {%f, %f, %f, %d}", SHOW(ref),
-          interaction_id.c_str(), stats.appear_percent, stats.call_count,
-          stats.order_percent, stats.min_api_level);
-    m_method_stats[interaction_id].emplace(ref, stats);
+  // Interaction IDs from the current row have priority over the interaction
+  // id from the top of the file. This shouldn't happen in practice, but this
+  // is the conservative approach.
+  std::string interaction_id = row.interaction_id.empty()
+                                   ? m_interaction_id
+                                   : std::string(row.interaction_id);
+  if (row.ref != nullptr) {
+    TRACE(METH_PROF, 6, "(%s, %s) -> {%f, %f, %f, %d}", SHOW(row.ref),
+          interaction_id.c_str(), row.stats.appear_percent,
+          row.stats.call_count, row.stats.order_percent,
+          row.stats.min_api_level);
+    m_method_stats[interaction_id].emplace(row.ref, row.stats);
   } else {
-    m_unresolved_lines[interaction_id].push_back(copy);
-    TRACE(METH_PROF, 6, "unresolved: %s", copy.c_str());
+    m_unresolved_lines[interaction_id].push_back(line);
+    TRACE(METH_PROF, 6, "unresolved: %s", line.c_str());
+  }
+  return true;
+}
+
+bool MethodProfiles::parse_main_rows(std::string_view rows) {
+  // Split into line-aligned chunks, a few per thread so that they balance.
+  constexpr size_t MIN_CHUNK_SIZE = 64 * 1024;
+  size_t num_chunks =
+      std::min(redex_parallel::default_num_threads() * 4,
+               rows.size() / MIN_CHUNK_SIZE + 1);
+  std::vector<std::string_view> chunks;
+  size_t start = 0;
+  for (size_t i = 1; i <= num_chunks && start < rows.size(); ++i) {
+    size_t end = rows.size() * i / num_chunks;
+    if (end < start) {
+      end = start;
+    }
+    end = rows.find('\n', end);
+    end = end == std::string_view::npos ? rows.size() : end + 1;
+    chunks.push_back(rows.substr(start, end - start));
+    start = end;
+  }
+
+  using Line = std::pair<ParsedRow, std::string_view>;
+  std::vector<std::vector<Line>> parsed(chunks.size());
+  std::atomic<bool> failed{false};
+  std::vector<size_t> indices(chunks.size());
+  std::iota(indices.begin(), indices.end(), 0);
+  workqueue_run<size_t>(
+      [&](size_t i) {
+        auto chunk = chunks[i];
+        size_t pos = 0;
+        while (pos < chunk.size() && !failed) {
+          auto line = next_line(chunk, &pos);
+          ParsedRow row;
+          if (!parse_main_row(line, &row)) {
+            failed = true;
+            return;
+          }
+          parsed[i].emplace_back(row, line);
+        }
+      },
+      indices);
+  if (failed) {
+    return false;
+  }
+
+  // Record the rows in file order, so that the first row for a method wins.
+  // Consecutive rows almost always share their interaction.
+  std::string_view last_interaction_id;
+  const std::string* interaction_id = nullptr;
+  StatsMap* stats_map = nullptr;
+  for (const auto& lines : parsed) {
+    for (const auto& [row, line] : lines) {
+      if (row.ref == nullptr) {
+        std::string interaction_id = row.interaction_id.empty()
+                                         ? m_interaction_id
+                                         : std::string(row.interaction_id);
+        m_unresolved_lines[interaction_id].emplace_back(line);
+        TRACE(METH_PROF, 6, "unresolved: %.*s", (int)line.size(), line.data());
+        continue;
+      }
+      if (stats_map == nullptr || row.interaction_id != last_interaction_id) {
+        last_interaction_id = row.interaction_id;
+        auto it = m_method_stats
+                      .try_emplace(row.interaction_id.empty()
+                                       ? m_interaction_id
+                                       : std::string(row.interaction_id))
+                      .first;
+        interaction_id = &it->first;
+        stats_map = &it->second;
+      }
+      TRACE(METH_PROF, 6, "(%s, %s) -> {%f, %f, %f, %d}", SHOW(row.ref),
+            interaction_id->c_str(), row.stats.appear_percent,
+            row.stats.call_count, row.stats.order_percent,
+            row.stats.min_api_level);
+      stats_map->emplace(row.ref, row.stats);
+    }
   }
   return true;
 }
@@ -450,7 +597,7 @@ double dexmethods_profiled_comparator::get_method_sort_num(
 
 double dexmethods_profiled_comparator::get_method_sort_num_override(
     const DexMethod* method) {
-  const std::string& deobfname = method->get_deobfuscated_name();
+  auto deobfname = method->get_deobfuscated_name();
   for (const std::string& substr : *m_allowlisted_substrings) {
     if (deobfname.find(substr) != std::string::npos) {
       return COLD_START_RANGE_BEGIN + RANGE_SIZE / 2;
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <boost/optional.hpp>
+#include <string_view>
 
 #include "DexClass.h"
 #include "Timer.h"
@@ -149,11 +150,25 @@ class MethodProfiles {
   // m_method_stats
   bool parse_stats_file(const std::string& csv_filename);
 
+  // The contents of a line from the main section.
+  struct ParsedRow {
+    DexMethodRef* ref{nullptr};
+    Stats stats;
+    // Empty if the row doesn't have its own interaction column.
+    std::string_view interaction_id;
+  };
+
   // Read a line of data (not a header)
   bool parse_line(std::string& line);
   // Read a line from the main section of the aggregated stats file and put an
   // entry into m_method_stats
   bool parse_main(std::string& line);
+  // Parse a line from the main section without recording it. Safe to call
+  // concurrently.
+  bool parse_main_row(std::string_view line, ParsedRow* row) const;
+  // Parse all the lines of the main section, in parallel chunks, and record
+  // them in file order.
+  bool parse_main_rows(std::string_view rows);
   // Read a line of data from the metadata section (at the top of the file)
   bool parse_metadata(std::string& line);
 
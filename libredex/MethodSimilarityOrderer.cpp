@@ -7,12 +7,14 @@
 
 #include "MethodSimilarityOrderer.h"
 
+#include <algorithm>
+
 #include "DexInstruction.h"
 #include "Show.h"
 #include "Trace.h"
 
 void MethodSimilarityOrderer::gather_code_hash_ids(
-    const DexCode* code, std::unordered_set<CodeHashId>& code_hash_ids) {
+    const DexCode* code, std::vector<CodeHashId>& code_hash_ids) {
   auto& instructions = code->get_instructions();
 
   // First, we partition the instructions into chunks, where each chunk ends
@@ -58,8 +60,10 @@ void MethodSimilarityOrderer::gather_code_hash_ids(
     auto it = m_code_hash_ids.find(code_hash);
     if (it == m_code_hash_ids.end()) {
       it = m_code_hash_ids.emplace(code_hash, m_code_hash_ids.size()).first;
+      m_code_hash_id_methods.emplace_back();
+      m_live_method_counts.push_back(0);
     }
-    code_hash_ids.insert(it->second);
+    code_hash_ids.push_back(it->second);
   };
 
   // We'll further partition chunks into smaller pieces, and then hash those
@@ -74,15 +78,17 @@ void MethodSimilarityOrderer::gather_code_hash_ids(
       hash_sub_chunk({i, i + chunk_size});
     }
   }
+  std::sort(code_hash_ids.begin(), code_hash_ids.end());
+  code_hash_ids.erase(std::unique(code_hash_ids.begin(), code_hash_ids.end()),
+                      code_hash_ids.end());
 }
 
 void MethodSimilarityOrderer::insert(DexMethod* method) {
-  always_assert(m_method_indices.count(method) == 0);
-  size_t index = m_methods.size();
-  m_methods.emplace(index, method);
-  m_method_indices.emplace(method, index);
-
-  auto& code_hash_ids = m_method_code_hash_ids[method];
+  MethodIndex index = m_methods.size();
+  m_methods.push_back(method);
+  m_taken.push_back(false);
+  m_method_code_hash_ids.emplace_back();
+  auto& code_hash_ids = m_method_code_hash_ids.back();
 
   if (type_class(method->get_class())->is_perf_sensitive()) {
     return;
@@ -94,21 +100,25 @@ void MethodSimilarityOrderer::insert(DexMethod* method) {
   }
 
   for (auto code_hash_id : code_hash_ids) {
-    m_code_hash_id_methods[code_hash_id].insert(method);
+    m_code_hash_id_methods[code_hash_id].push_back(index);
+    m_live_method_counts[code_hash_id]++;
   }
 }
 
 DexMethod* MethodSimilarityOrderer::get_next() {
-  if (m_methods.empty()) {
+  while (m_first_remaining < m_methods.size() && m_taken[m_first_remaining]) {
+    m_first_remaining++;
+  }
+  if (m_first_remaining == m_methods.size()) {
     return nullptr;
   }
-  boost::optional<size_t> best_candidate_index;
+  boost::optional<MethodIndex> best_candidate_index;
 
   // If the next method is part of a perf sensitive class,
   // then do not look for a candidate, just preserve the
   // original order.
-  auto* next_method = m_methods.begin()->second;
-  bool is_next_perf_sensitive = m_method_code_hash_ids[next_method].empty();
+  bool is_next_perf_sensitive =
+      m_method_code_hash_ids[m_first_remaining].empty();
 
   if (!is_next_perf_sensitive && !m_last_code_hash_ids.empty()) {
     // Similarity score for each candidate method, based on the number of
@@ -120,71 +130,70 @@ DexMethod* MethodSimilarityOrderer::get_next() {
       size_t additional{0};
       int value() const { return 2 * shared - missing - 2 * additional; }
     };
-    std::unordered_map<DexMethod*, Score> candidate_scores;
     // To compute the score, we add up how many matching code-hash-ids we
     // have...
+    std::vector<MethodIndex> candidates;
     for (auto code_hash_id : m_last_code_hash_ids) {
-      for (auto method : m_code_hash_id_methods.at(code_hash_id)) {
-        candidate_scores[method].shared++;
+      for (auto index : m_code_hash_id_methods[code_hash_id]) {
+        if (!m_taken[index] && m_shared_counts[index]++ == 0) {
+          candidates.push_back(index);
+        }
       }
     }
-    // minus penalty points for every non-matching code-hash-id
-    for (auto& p : candidate_scores) {
-      auto& other_code_hash_ids = m_method_code_hash_ids.at(p.first);
-
-      size_t other_code_hash_ids_size = other_code_hash_ids.size();
-      size_t last_code_hash_ids_size = m_last_code_hash_ids.size();
-
-      p.second.additional = other_code_hash_ids_size - p.second.shared;
-      p.second.missing = last_code_hash_ids_size - p.second.shared;
-    }
+    // minus penalty points for every non-matching code-hash-id.
     // Then we'll find the best matching candidate with a non-negative score
     // that is not perf sensitive.
     boost::optional<Score> best_candidate_score;
-    for (auto& p : candidate_scores) {
-      auto& score = p.second;
-      if (score.value() < 0 || m_method_code_hash_ids[p.first].empty()) {
+    for (auto index : candidates) {
+      Score score;
+      score.shared = m_shared_counts[index];
+      m_shared_counts[index] = 0;
+      auto& other_code_hash_ids = m_method_code_hash_ids[index];
+      score.additional = other_code_hash_ids.size() - score.shared;
+      score.missing = m_last_code_hash_ids.size() - score.shared;
+      if (score.value() < 0 || other_code_hash_ids.empty()) {
         continue;
       }
       if (!best_candidate_score ||
           score.value() > best_candidate_score->value() ||
           (score.value() == best_candidate_score->value() &&
-           best_candidate_index &&
-           m_method_indices.at(p.first) < *best_candidate_index)) {
-        best_candidate_index = m_method_indices.at(p.first);
-        best_candidate_score = p.second;
+           index < *best_candidate_index)) {
+        best_candidate_index = index;
+        best_candidate_score = score;
       }
     }
     if (best_candidate_score) {
       TRACE(
           OPUT, 3,
           "[method-similarity-orderer]   selected %s with %d = %zu - %zu - %zu",
-          SHOW(m_methods.at(*best_candidate_index)),
+          SHOW(m_methods[*best_candidate_index]),
           best_candidate_score->value(), best_candidate_score->shared,
           best_candidate_score->missing, best_candidate_score->additional);
     }
   }
   if (!best_candidate_index) {
-    best_candidate_index = m_methods.begin()->first;
+    best_candidate_index = m_first_remaining;
     TRACE(OPUT, 3, "[method-similarity-orderer] reverted to %s",
-          SHOW(m_methods.at(*best_candidate_index)));
+          SHOW(m_methods[*best_candidate_index]));
   }
-  auto best_candidate_method = m_methods.at(*best_candidate_index);
-  m_last_code_hash_ids =
-      std::move(m_method_code_hash_ids.at(best_candidate_method));
-  m_methods.erase(*best_candidate_index);
-  m_method_code_hash_ids.erase(best_candidate_method);
-  for (auto it = m_last_code_hash_ids.begin();
-       it != m_last_code_hash_ids.end();) {
-    auto code_hash_id = *it;
-    auto& methods = m_code_hash_id_methods.at(code_hash_id);
-    methods.erase(best_candidate_method);
-    if (methods.empty()) {
-      m_code_hash_id_methods.erase(code_hash_id);
-      it = m_last_code_hash_ids.erase(it);
-    } else {
-      it++;
+  auto index = *best_candidate_index;
+  m_taken[index] = true;
+  auto code_hash_ids = std::move(m_method_code_hash_ids[index]);
+  m_method_code_hash_ids[index] = {};
+  m_last_code_hash_ids.clear();
+  auto is_taken = [this](MethodIndex i) { return m_taken[i]; };
+  for (auto code_hash_id : code_hash_ids) {
+    auto& live_count = m_live_method_counts[code_hash_id];
+    auto& methods = m_code_hash_id_methods[code_hash_id];
+    if (--live_count == 0) {
+      methods = {};
+      continue;
+    }
+    if (2 * live_count < methods.size()) {
+      methods.erase(std::remove_if(methods.begin(), methods.end(), is_taken),
+                    methods.end());
     }
+    m_last_code_hash_ids.push_back(code_hash_id);
   }
-  return best_candidate_method;
+  return m_methods[index];
 }
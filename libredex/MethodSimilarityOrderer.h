@@ -8,7 +8,7 @@
 #pragma once
 
 #include <unordered_map>
-#include <unordered_set>
+#include <vector>
 
 #include "DexClass.h"
 
@@ -27,41 +27,55 @@
  */
 class MethodSimilarityOrderer {
   // Hash id for a sequence (chunk) of instructions
-  using CodeHashId = size_t;
+  using CodeHashId = uint32_t;
 
-  // Set of hash ids belonging to the previously chosen method code
-  std::unordered_set<CodeHashId> m_last_code_hash_ids;
+  // Position of a method in the order in which methods have been added to the
+  // orderer
+  using MethodIndex = uint32_t;
+
+  // Hash ids belonging to the previously chosen method code, restricted to
+  // those that some remaining method shares
+  std::vector<CodeHashId> m_last_code_hash_ids;
 
   // Mirrors the order in each the methods have been added to the orderer
-  std::map<size_t, DexMethod*> m_methods;
+  std::vector<DexMethod*> m_methods;
+
+  // Whether a method has already been returned by get_next()
+  std::vector<bool> m_taken;
 
-  // The inverse of m_methods
-  std::unordered_map<DexMethod*, size_t> m_method_indices;
+  // All methods before this index have been taken
+  MethodIndex m_first_remaining{0};
 
-  // Mapping from each method to its set of hash ids
-  std::unordered_map<DexMethod*, std::unordered_set<CodeHashId>>
-      m_method_code_hash_ids;
+  // Sorted hash ids of each method; empty for perf sensitive methods
+  std::vector<std::vector<CodeHashId>> m_method_code_hash_ids;
 
-  // Mapping from hash ids to the sets of all methods containing a sequence
-  // of instructions with that hash id
-  std::unordered_map<CodeHashId, std::unordered_set<DexMethod*>>
-      m_code_hash_id_methods;
+  // Mapping from hash ids to all methods containing a sequence of
+  // instructions with that hash id. Taken methods are only removed once they
+  // make up half of an entry, so m_live_method_counts tracks how many methods
+  // of each entry remain.
+  std::vector<std::vector<MethodIndex>> m_code_hash_id_methods;
+  std::vector<uint32_t> m_live_method_counts;
 
   // Mapping from hashed code sequences to their respective hash ids
   std::unordered_map<uint64_t, CodeHashId> m_code_hash_ids;
 
+  // Scratch space for get_next(), indexed by method; all zeros in between
+  // calls
+  std::vector<uint32_t> m_shared_counts;
+
   void insert(DexMethod* method);
 
   // Gather the hash ids of all instruction sequences
   // (of a certain size) inside code
   void gather_code_hash_ids(const DexCode* code,
-                            std::unordered_set<CodeHashId>& code_hash_ids);
+                            std::vector<CodeHashId>& code_hash_ids);
 
  public:
   explicit MethodSimilarityOrderer(const std::vector<DexMethod*>& methods) {
     for (auto* method : methods) {
       insert(method);
     }
+    m_shared_counts.resize(m_methods.size());
   }
 
   DexMethod* get_next();
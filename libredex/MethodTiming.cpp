@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "MethodTiming.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "PassManager.h"
+#include "PassMetrics.h"
+#include "Show.h"
+
+namespace method_timing {
+
+namespace detail {
+std::atomic<bool> g_enabled{false};
+} // namespace detail
+
+namespace {
+
+using Entry = std::pair<uint64_t, const DexMethod*>;
+
+struct State {
+  std::string pass_name;
+  Config config;
+  pass_metrics::Histogram histogram;
+  std::mutex slowest_mutex;
+  // A min-heap of the slowest methods seen so far.
+  std::vector<Entry> slowest;
+  // Once the heap is full, the time a method must exceed to get in.
+  std::atomic<uint64_t> slowest_threshold{0};
+};
+
+std::unique_ptr<State> s_state;
+
+} // namespace
+
+void begin_pass(const std::string& pass_name, const Config& config) {
+  s_state = std::make_unique<State>();
+  s_state->pass_name = pass_name;
+  s_state->config = config;
+  detail::g_enabled.store(true);
+}
+
+void end_pass(PassManager& mgr) {
+  if (!enabled()) {
+    return;
+  }
+  detail::g_enabled.store(false);
+  const auto& histogram = s_state->histogram;
+  if (histogram.count() > 0) {
+    mgr.set_metric("method_time_us~count", histogram.count());
+    mgr.set_metric("method_time_us~sum", histogram.sum());
+    mgr.set_metric("method_time_us~max", histogram.max());
+    mgr.set_metric("method_time_us~p50", histogram.percentile(50));
+    mgr.set_metric("method_time_us~p90", histogram.percentile(90));
+    mgr.set_metric("method_time_us~p99", histogram.percentile(99));
+  }
+  auto& slowest = s_state->slowest;
+  std::sort(slowest.begin(), slowest.end(), std::greater<Entry>());
+  for (size_t i = 0; i < slowest.size(); ++i) {
+    mgr.set_metric("slowest_method_us_" + std::to_string(i) + ":" +
+                       show_deobfuscated(slowest[i].second),
+                   slowest[i].first);
+  }
+  s_state.reset();
+}
+
+void record(const DexMethod* method, uint64_t micros) {
+  if (!enabled()) {
+    return;
+  }
+  auto& state = *s_state;
+  state.histogram.record(micros);
+  auto budget_ms = state.config.budget_ms;
+  if (budget_ms != 0 && micros > budget_ms * 1000) {
+    fprintf(stderr,
+            "WARNING: %s spent %" PRIu64 " ms on %s, over the budget of "
+            "%" PRIu64 " ms\n",
+            state.pass_name.c_str(), micros / 1000, SHOW(method), budget_ms);
+  }
+  if (state.config.top_k == 0 ||
+      micros <= state.slowest_threshold.load(std::memory_order_relaxed)) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(state.slowest_mutex);
+  auto& slowest = state.slowest;
+  slowest.emplace_back(micros, method);
+  std::push_heap(slowest.begin(), slowest.end(), std::greater<Entry>());
+  if (slowest.size() > state.config.top_k) {
+    std::pop_heap(slowest.begin(), slowest.end(), std::greater<Entry>());
+    slowest.pop_back();
+  }
+  if (slowest.size() == state.config.top_k) {
+    state.slowest_threshold.store(slowest.front().first,
+                                  std::memory_order_relaxed);
+  }
+}
+
+} // namespace method_timing
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class DexMethod;
+class PassManager;
+
+/*
+ * Opt-in recording of the wall time spent on each method by the parallel
+ * walkers (walk::parallel::methods and walk::parallel::code), to find the
+ * methods which dominate the tail of a pass. PassManager brackets each pass
+ * with begin_pass() and end_pass() when enabled in the config.
+ */
+namespace method_timing {
+
+struct Config {
+  // Number of slowest methods reported per pass.
+  size_t top_k{10};
+  // Warn about any method taking longer than this. 0 means no budget.
+  uint64_t budget_ms{0};
+};
+
+namespace detail {
+extern std::atomic<bool> g_enabled;
+} // namespace detail
+
+inline bool enabled() {
+  return detail::g_enabled.load(std::memory_order_relaxed);
+}
+
+void begin_pass(const std::string& pass_name, const Config& config);
+
+// Adds the distribution of the method times, and the slowest methods, to the
+// metrics of the current pass, and stops recording.
+void end_pass(PassManager& mgr);
+
+void record(const DexMethod* method, uint64_t micros);
+
+class ScopedMethodTimer {
+ public:
+  explicit ScopedMethodTimer(const DexMethod* method)
+      : m_method(method), m_start(std::chrono::steady_clock::now()) {}
+
+  ScopedMethodTimer(const ScopedMethodTimer&) = delete;
+  ScopedMethodTimer& operator=(const ScopedMethodTimer&) = delete;
+
+  ~ScopedMethodTimer() {
+    auto end = std::chrono::steady_clock::now();
+    record(m_method,
+           std::chrono::duration_cast<std::chrono::microseconds>(end - m_start)
+               .count());
+  }
+
+ private:
+  const DexMethod* m_method;
+  std::chrono::steady_clock::time_point m_start;
+};
+
+} // namespace method_timing
@@ -62,7 +62,7 @@ void make_static(DexMethod* method, KeepThis keep /* = Yes */) {
   auto cls_type = method->get_class();
   if (keep == KeepThis::Yes) {
     // make `this` an explicit parameter
-    params.push_front(cls_type);
+    params.insert(params.begin(), cls_type);
     auto new_args = DexTypeList::make_type_list(std::move(params));
     auto new_proto = DexProto::make_proto(proto->get_rtype(), new_args);
     DexMethodSpec spec;
@@ -89,7 +89,7 @@ void make_non_static(DexMethod* method, bool make_virtual) {
   // Limitation: We can only deal with static methods that have a first
   // of the parameter class type.
   always_assert(cls_type == params.front());
-  params.pop_front();
+  params.erase(params.begin());
   auto new_args = DexTypeList::make_type_list(std::move(params));
   auto new_proto = DexProto::make_proto(proto->get_rtype(), new_args);
   DexMethodSpec spec;
@@ -82,9 +82,9 @@ void mangle_type_name_in_signature(std::ostringstream& out,
 void get_native_short_name_for_method_impl(std::ostringstream& out,
                                            DexMethodRef* method) {
   out << "Java_";
-  mangle_class_name(out, method->get_class()->str());
+  mangle_class_name(out, method->get_class()->str_copy());
   out << "_";
-  escape_single_identifier(out, method->get_name()->str());
+  escape_single_identifier(out, method->get_name()->str_copy());
 }
 
 void get_native_long_name_for_method_impl(std::ostringstream& out,
@@ -93,7 +93,7 @@ void get_native_long_name_for_method_impl(std::ostringstream& out,
   out << "__";
   DexTypeList* types = method->get_proto()->get_args();
   for (DexType* type : types->get_type_list()) {
-    mangle_type_name_in_signature(out, type->get_name()->str());
+    mangle_type_name_in_signature(out, type->get_name()->str_copy());
   }
 }
 
@@ -58,6 +58,15 @@ class Pass : public Configurable {
 
   virtual void set_analysis_usage(AnalysisUsage& analysis_usage) const;
 
+  /**
+   * Whether the pass accepts methods whose code is in editable CFG form, and
+   * leaves the code of each method in the form it found it in (typically by
+   * using ScopedCFG rather than build_cfg/clear_cfg). The PassManager may then
+   * keep editable CFGs between consecutive passes that all keep them, see
+   * "keep_cfg_between_passes".
+   */
+  virtual bool keeps_editable_cfg() const { return false; }
+
   Configurable::Reflection reflect() override;
 
  private:
@@ -27,10 +27,13 @@
 #include "AnalysisUsage.h"
 #include "ApiLevelChecker.h"
 #include "AssetManager.h"
+#include "CodeSpill.h"
 #include "CommandProfiling.h"
+#include "ConcurrentContainers.h"
 #include "ConfigFiles.h"
 #include "Debug.h"
 #include "DexClass.h"
+#include "DexInstruction.h"
 #include "DexLoader.h"
 #include "DexOutput.h"
 #include "DexUtil.h"
@@ -42,9 +45,11 @@
 #include "JemallocUtil.h"
 #include "Macros.h"
 #include "MethodProfiles.h"
+#include "MethodTiming.h"
 #include "Native.h"
 #include "OptData.h"
 #include "Pass.h"
+#include "PerfCounters.h"
 #include "PrintSeeds.h"
 #include "ProguardPrintConfiguration.h"
 #include "ProguardReporting.h"
@@ -53,7 +58,9 @@
 #include "ScopedCFG.h"
 #include "Show.h"
 #include "SourceBlocks.h"
+#include "ThreadPool.h"
 #include "Timer.h"
+#include "TypeInferenceCache.h"
 #include "Walkers.h"
 
 namespace {
@@ -93,6 +100,8 @@ struct CheckerConfig {
         type_checker_args.get("check_no_overwrite_this", false).asBool();
     check_num_of_refs =
         type_checker_args.get("check_num_of_refs", false).asBool();
+    incremental_after_each_pass =
+        type_checker_args.get("incremental_after_each_pass", true).asBool();
 
     for (auto& trigger_pass : type_checker_args["run_after_passes"]) {
       type_checker_trigger_passes.insert(trigger_pass.asString());
@@ -107,7 +116,7 @@ struct CheckerConfig {
     auto res = run_verifier(scope, verify_moves,
                             /* check_no_overwrite_this= */ false,
                             /* validate_access= */ true,
-                            /* exit_on_fail= */ false);
+                            /* exit_on_fail= */ false, checked_methods());
     if (!res) {
       return; // No issues.
     }
@@ -143,6 +152,23 @@ struct CheckerConfig {
            type_checker_trigger_passes.count(pass->name()) > 0;
   }
 
+  void after_pass(const Scope& scope) {
+    // It's OK to overwrite the `this` register if we are not yet at the
+    // output phase -- the register allocator can fix it up later.
+    run_verifier(scope, verify_moves,
+                 /* check_no_overwrite_this */ false,
+                 /* validate_access */ false,
+                 /* exit_on_fail */ true, checked_methods());
+  }
+
+  /**
+   * Methods that passed the checker, with the fingerprint of their code at
+   * the time. Null when every check should cover the whole scope.
+   */
+  ConcurrentMap<const DexMethod*, size_t>* checked_methods() {
+    return incremental_after_each_pass ? &m_checked_methods : nullptr;
+  }
+
   /**
    * Return activated_passes.size() if the checking is turned off.
    * Otherwize, return 0 or the index of the last InterDexPass.
@@ -200,13 +226,22 @@ struct CheckerConfig {
   }
 
   // TODO(fengliu): Kill the `validate_access` flag.
-  static boost::optional<std::string> run_verifier(const Scope& scope,
-                                                   bool verify_moves,
-                                                   bool check_no_overwrite_this,
-                                                   bool validate_access,
-                                                   bool exit_on_fail = true) {
+  //
+  // If `checked_methods` is given, methods whose fingerprint is unchanged
+  // since they last passed are skipped, and the methods that pass are
+  // recorded. This only notices changes to the method itself; changes
+  // elsewhere, such as to the class hierarchy, are caught by the full check
+  // before output.
+  static boost::optional<std::string> run_verifier(
+      const Scope& scope,
+      bool verify_moves,
+      bool check_no_overwrite_this,
+      bool validate_access,
+      bool exit_on_fail = true,
+      ConcurrentMap<const DexMethod*, size_t>* checked_methods = nullptr) {
     TRACE(PM, 1, "Running IRTypeChecker...");
     Timer t("IRTypeChecker");
+    std::atomic<size_t> skipped{0};
 
     struct Result {
       size_t errors{0};
@@ -243,12 +278,25 @@ struct CheckerConfig {
 
     auto res =
         walk::parallel::methods<Result>(scope, [&](DexMethod* dex_method) {
+          size_t fingerprint = 0;
+          if (checked_methods != nullptr) {
+            fingerprint = hashing::code_fingerprint(dex_method);
+            if (checked_methods->get(dex_method, 0) == fingerprint) {
+              skipped++;
+              return Result();
+            }
+          }
           auto checker = run_checker(dex_method);
           if (!checker.fail()) {
+            if (checked_methods != nullptr) {
+              checked_methods->insert_or_assign({dex_method, fingerprint});
+            }
             return Result();
           }
           return Result(dex_method);
         });
+    TRACE(PM, 2, "IRTypeChecker skipped %zu unchanged methods",
+          skipped.load());
 
     if (res.errors == 0) {
       return boost::none;
@@ -288,6 +336,9 @@ struct CheckerConfig {
   bool verify_moves;
   bool check_no_overwrite_this;
   bool check_num_of_refs;
+  bool incremental_after_each_pass;
+
+  ConcurrentMap<const DexMethod*, size_t> m_checked_methods;
 };
 
 class ScopedVmHWM {
@@ -319,6 +370,42 @@ class ScopedVmHWM {
   bool m_enabled;
 };
 
+class ScopedHeapStats {
+ public:
+  explicit ScopedHeapStats(bool enabled)
+      : m_enabled(enabled && jemalloc_util::get_heap_stats(&m_before)) {}
+
+  // Records the heap usage of the pass, and fails if its net heap growth is
+  // over `max_allocated_delta` (when positive).
+  void record(PassManager* mgr, const Pass* pass, int64_t max_allocated_delta) {
+    jemalloc_util::HeapStats after;
+    if (!m_enabled || !jemalloc_util::get_heap_stats(&after)) {
+      return;
+    }
+    int64_t allocated_delta = (int64_t)after.allocated - m_before.allocated;
+    mgr->set_metric("heap_allocated_after", after.allocated);
+    mgr->set_metric("heap_allocated_delta", allocated_delta);
+    mgr->set_metric("heap_num_allocations",
+                    after.num_allocations - m_before.num_allocations);
+    mgr->set_metric("heap_resident_after", after.resident);
+    mgr->set_metric("heap_retained_after", after.retained);
+    TRACE(STATS, 1, "Heap for %s: %s allocated (%s over start), %s resident.",
+          pass->name().c_str(), pretty_bytes(after.allocated).c_str(),
+          pretty_bytes(std::max<int64_t>(allocated_delta, 0)).c_str(),
+          pretty_bytes(after.resident).c_str());
+    always_assert_log(max_allocated_delta <= 0 ||
+                          allocated_delta <= max_allocated_delta,
+                      "%s grew the heap by %" PRId64
+                      " bytes, over the limit of %" PRId64 " bytes",
+                      pass->name().c_str(), allocated_delta,
+                      max_allocated_delta);
+  }
+
+ private:
+  jemalloc_util::HeapStats m_before;
+  bool m_enabled;
+};
+
 class CheckUniqueDeobfuscatedNames {
  public:
   bool m_after_each_pass{false};
@@ -356,7 +443,7 @@ class CheckUniqueDeobfuscatedNames {
     Timer t("check_unique_deobfuscated_names");
     std::unordered_map<std::string, DexMethod*> method_names;
     walk::methods(scope, [&method_names, pass_name](DexMethod* dex_method) {
-      auto it = method_names.find(dex_method->get_deobfuscated_name());
+      auto it = method_names.find(dex_method->get_deobfuscated_name_copy());
       if (it != method_names.end()) {
         fprintf(
             stderr,
@@ -365,11 +452,12 @@ class CheckUniqueDeobfuscatedNames {
             pass_name, it->first.c_str(), SHOW(dex_method), SHOW(it->second));
         exit(EXIT_FAILURE);
       }
-      method_names.emplace(dex_method->get_deobfuscated_name(), dex_method);
+      method_names.emplace(dex_method->get_deobfuscated_name_copy(),
+                           dex_method);
     });
     std::unordered_map<std::string, DexField*> field_names;
     walk::fields(scope, [&field_names, pass_name](DexField* dex_field) {
-      auto it = field_names.find(dex_field->get_deobfuscated_name());
+      auto it = field_names.find(dex_field->get_deobfuscated_name_copy());
       if (it != field_names.end()) {
         fprintf(stderr,
                 "ABORT! [%s] Duplicate deobfuscated field name: %s\nfor %s\n "
@@ -378,7 +466,7 @@ class CheckUniqueDeobfuscatedNames {
                 SHOW(it->second));
         exit(EXIT_FAILURE);
       }
-      field_names.emplace(dex_field->get_deobfuscated_name(), dex_field);
+      field_names.emplace(dex_field->get_deobfuscated_name_copy(), dex_field);
     });
   }
 
@@ -424,6 +512,10 @@ class AnalysisUsageHelper {
 
   void pre_pass(Pass* pass) { pass->set_analysis_usage(m_analysis_usage); }
 
+  bool requires_type_environments() const {
+    return m_analysis_usage.requires_type_environments();
+  }
+
   void post_pass(Pass* pass) {
     // Invalidate existing preserved analyses according to policy set by each
     // pass.
@@ -622,6 +714,8 @@ class AfterPassSizes {
     json.get("after_pass_size_queue", m_max_jobs, m_max_jobs);
   }
 
+  bool enabled() const { return m_enabled; }
+
   bool handle(PassManager::PassInfo* pass_info,
               DexStoresVector* stores,
               ConfigFiles* conf) {
@@ -1000,11 +1094,14 @@ PassManager::PassManager(
 PassManager::~PassManager() {}
 
 void PassManager::init(const Json::Value& config) {
+  std::vector<size_t> config_indices;
   if (config["redex"].isMember("passes")) {
     const auto& redex = config["redex"];
     auto passes_from_config = redex["passes"];
+    size_t config_index = 0;
     for (const auto& pass : passes_from_config) {
       std::string pass_name = pass.asString();
+      size_t index = config_index++;
 
       // Check whether it is explicitly disabled.
       auto is_disabled = [&config, &pass_name]() {
@@ -1022,6 +1119,7 @@ void PassManager::init(const Json::Value& config) {
       }
 
       activate_pass(pass_name, config);
+      config_indices.push_back(index);
     }
   } else {
     // If config isn't set up, run all registered passes.
@@ -1029,6 +1127,7 @@ void PassManager::init(const Json::Value& config) {
     // But do not forget to initialize them.
     for (auto* pass : m_activated_passes) {
       pass->parse_config(JsonWrapper(config[pass->name()]));
+      config_indices.push_back(config_indices.size());
     }
   }
 
@@ -1046,6 +1145,7 @@ void PassManager::init(const Json::Value& config) {
     const size_t count = pass_counters[pass]++;
     m_pass_info[i].pass = pass;
     m_pass_info[i].order = i;
+    m_pass_info[i].config_index = config_indices[i];
     m_pass_info[i].repeat = count;
     m_pass_info[i].total_repeat = pass_repeats.at(pass);
     m_pass_info[i].name = pass->name() + "#" + std::to_string(count + 1);
@@ -1059,8 +1159,10 @@ hashing::DexHash PassManager::run_hasher(const char* pass_name,
   TRACE(PM, 2, "Running hasher...");
   Timer t("Hasher");
   auto timer = m_hashers_timer.scope();
-  hashing::DexScopeHasher hasher(scope);
+  hashing::DexScopeHasher hasher(scope, &m_method_hash_cache);
   auto hash = hasher.run();
+  TRACE(PM, 2, "Hasher reused %zu and recomputed %zu method hashes",
+        m_method_hash_cache.hits(), m_method_hash_cache.misses());
   if (pass_name) {
     // log metric value in a way that fits into JSON number value
     set_metric("~result~code~hash~",
@@ -1163,6 +1265,33 @@ void PassManager::run_passes(DexStoresVector& stores, ConfigFiles& conf) {
       traceEnabled(STATS, 1) || conf.get_json_config().get("mem_stats", true);
   const bool hwm_per_pass =
       conf.get_json_config().get("mem_stats_per_pass", true);
+  const bool perf_counters_per_pass =
+      conf.get_json_config().get("perf_counters_per_pass", true);
+  const bool heap_stats_per_pass =
+      conf.get_json_config().get("heap_stats_per_pass", true);
+  // A positive value makes any pass whose net heap growth is larger fail.
+  // Opt-in per-method timing of the parallel walkers, e.g.
+  // "method_timing": {"enabled": true, "top_k": 10, "budget_ms": 1000}
+  const auto& method_timing_json = conf.get_json_config()["method_timing"];
+  const bool method_timing_per_pass =
+      method_timing_json.get("enabled", false).asBool();
+  method_timing::Config method_timing_config;
+  method_timing_config.top_k =
+      method_timing_json.get("top_k", Json::UInt64(10)).asUInt64();
+  method_timing_config.budget_ms =
+      method_timing_json.get("budget_ms", Json::UInt64(0)).asUInt64();
+  int64_t max_heap_growth_per_pass;
+  conf.get_json_config().get("max_heap_growth_per_pass", (int64_t)0,
+                             max_heap_growth_per_pass);
+  // Optional wall-clock budgets, see remaining_budget().
+  const auto& time_budget_json = conf.get_json_config()["time_budget"];
+  m_total_deadline = boost::none;
+  if (time_budget_json.isMember("total_s")) {
+    using namespace std::chrono;
+    duration<double> budget(time_budget_json["total_s"].asDouble());
+    m_total_deadline =
+        steady_clock::now() + duration_cast<steady_clock::duration>(budget);
+  }
 
   size_t min_pass_idx_for_dex_ref_check =
       checker_conf.min_pass_idx_for_dex_ref_check(m_activated_passes);
@@ -1180,14 +1309,24 @@ void PassManager::run_passes(DexStoresVector& stores, ConfigFiles& conf) {
     }
   };
 
+  // Whether methods are currently kept in editable CFG form, between passes
+  // that all keep editable CFGs.
+  bool cfgs_kept = false;
+
   auto post_pass_verifiers = [&](Pass* pass, size_t i, size_t size) {
-    walk::parallel::code(build_class_scope(stores), [](DexMethod* m,
-                                                       IRCode& code) {
-      // Ensure that pass authors deconstructed the editable CFG at the end of
-      // their pass. Currently, passes assume the incoming code will be in
-      // IRCode form
-      always_assert_log(!code.editable_cfg_built(), "%s has a cfg!", SHOW(m));
-    });
+    if (!cfgs_kept) {
+      walk::parallel::methods(build_class_scope(stores), [](DexMethod* m) {
+        // Spilled code never has a CFG, and checking would bring it back.
+        if (m->is_code_spilled() || m->get_code() == nullptr) {
+          return;
+        }
+        // Ensure that pass authors deconstructed the editable CFG at the end
+        // of their pass. Currently, passes assume the incoming code will be in
+        // IRCode form, unless they keep editable CFGs.
+        always_assert_log(!m->get_code()->editable_cfg_built(),
+                          "%s has a cfg!", SHOW(m));
+      });
+    }
 
     bool run_hasher = run_hasher_after_each_pass;
     bool run_assessor = assessor_config.run_after_each_pass ||
@@ -1206,11 +1345,7 @@ void PassManager::run_passes(DexStoresVector& stores, ConfigFiles& conf) {
         track_source_block_coverage(*this, stores);
       }
       if (run_type_checker) {
-        // It's OK to overwrite the `this` register if we are not yet at the
-        // output phase -- the register allocator can fix it up later.
-        CheckerConfig::run_verifier(scope, checker_conf.verify_moves,
-                                    /* check_no_overwrite_this */ false,
-                                    /* validate_access */ false);
+        checker_conf.after_pass(scope);
       }
       if (i >= min_pass_idx_for_dex_ref_check) {
         CheckerConfig::ref_validation(stores, pass->name());
@@ -1222,6 +1357,39 @@ void PassManager::run_passes(DexStoresVector& stores, ConfigFiles& conf) {
 
   JNINativeContextHelper jni_native_context_helper(scope);
 
+  // Optionally keep the code of methods in a file between passes, to be read
+  // back when a pass asks for it.
+  std::unique_ptr<code_spill::CodeSpill> code_spill;
+  if (conf.get_json_config().get("spill_code_between_passes", false)) {
+    code_spill = std::make_unique<code_spill::CodeSpill>(
+        conf.metafile("redex-code-spill.bin"));
+  }
+
+  // Optionally keep editable CFGs between consecutive passes that keep them,
+  // instead of having each of those passes build and linearize them again.
+  // Anything that looks at the code in between, or builds a CFG of its own,
+  // needs the IRCode form, and so ends the run.
+  bool keep_cfg_between_passes =
+      conf.get_json_config().get("keep_cfg_between_passes", false) &&
+      code_spill == nullptr && !run_hasher_after_each_pass &&
+      !assessor_config.run_after_each_pass &&
+      !check_unique_deobfuscated.m_after_each_pass &&
+      !after_pass_size.enabled() &&
+      conf.get_json_config()
+          .get("dump_cfg_classes", std::string(""))
+          .empty();
+  auto keep_cfgs_after = [&](size_t i) {
+    if (!keep_cfg_between_passes || i + 1 >= m_activated_passes.size()) {
+      return false;
+    }
+    Pass* pass = m_activated_passes[i];
+    return pass->keeps_editable_cfg() &&
+           m_activated_passes[i + 1]->keeps_editable_cfg() &&
+           !checker_conf.run_after_pass(pass) &&
+           !(m_snapshot_index &&
+             *m_snapshot_index == m_pass_info[i].config_index);
+  };
+
   std::unordered_map<const Pass*, size_t> runs;
 
   /////////////////////
@@ -1236,11 +1404,26 @@ void PassManager::run_passes(DexStoresVector& stores, ConfigFiles& conf) {
 
     TRACE(PM, 1, "Running %s...", pass->name().c_str());
     ScopedVmHWM vm_hwm{hwm_pass_stats, hwm_per_pass};
+    ScopedHeapStats heap_stats{heap_stats_per_pass};
     Timer t(pass->name() + " " + std::to_string(pass_run) + " (run)");
     m_current_pass_info = &m_pass_info[i];
 
     pre_pass_verifiers(pass, i);
 
+    if (!cfgs_kept && keep_cfgs_after(i)) {
+      Timer t_cfgs("Building editable CFGs");
+      walk::parallel::code(build_class_scope(stores),
+                           [](DexMethod*, IRCode& code) {
+                             code.build_cfg(/* editable */ true);
+                           });
+      cfgs_kept = true;
+    }
+
+    if (analysis_usage_helper.requires_type_environments()) {
+      Timer t_types("Populating type environments");
+      type_inference::populate_type_environments(build_class_scope(stores));
+    }
+
     {
       auto scoped_command_prof = profiler_info_pass == pass
                                      ? ScopedCommandProfiling::maybe_from_info(
@@ -1249,10 +1432,48 @@ void PassManager::run_passes(DexStoresVector& stores, ConfigFiles& conf) {
       auto scoped_command_all_prof = ScopedCommandProfiling::maybe_from_info(
           profiler_all_info, &pass->name());
       jemalloc_util::ScopedProfiling malloc_prof(m_malloc_profile_pass == pass);
+      if (perf_counters_per_pass) {
+        // Counters are only inherited by threads spawned after they are
+        // opened, so don't reuse worker threads of earlier passes.
+        sparta::ThreadPool::get().release_idle_threads();
+      }
+      perf_counters::ScopedCounters perf_counters(perf_counters_per_pass);
+      if (method_timing_per_pass) {
+        method_timing::begin_pass(pass->name(), method_timing_config);
+      }
+      begin_pass_budget(time_budget_json, pass);
       pass->run_pass(stores, conf, *this);
+      end_pass_budget();
+      method_timing::end_pass(*this);
+      if (perf_counters_per_pass) {
+        // The counts of inherited counters are only added up when the
+        // threads exit.
+        sparta::ThreadPool::get().release_idle_threads();
+      }
+      for (const auto& p : perf_counters.stop()) {
+        set_metric(p.first, p.second);
+      }
+    }
+    flush_registered_metrics();
+
+    // Type environments may have been attached by the pass, whether it asked
+    // for them up front or not. They are only checked against the code of
+    // each method, so they must not outlive the pass.
+    type_inference::clear_type_environments(build_class_scope(stores));
+
+    if (cfgs_kept && !keep_cfgs_after(i)) {
+      Timer t_cfgs("Linearizing editable CFGs");
+      walk::parallel::code(build_class_scope(stores),
+                           [](DexMethod*, IRCode& code) {
+                             if (code.editable_cfg_built()) {
+                               code.clear_cfg();
+                             }
+                           });
+      cfgs_kept = false;
     }
 
     vm_hwm.trace_log(this, pass);
+    heap_stats.record(this, pass, max_heap_growth_per_pass);
 
     sanitizers::lsan_do_recoverable_leak_check();
 
@@ -1269,9 +1490,24 @@ void PassManager::run_passes(DexStoresVector& stores, ConfigFiles& conf) {
       break;
     }
 
+    if (m_snapshot_index &&
+        *m_snapshot_index == m_current_pass_info->config_index) {
+      take_snapshot(stores, conf);
+    }
+
+    if (code_spill != nullptr && i + 1 < m_activated_passes.size()) {
+      Timer t_spill("Spilling code");
+      code_spill->spill(build_class_scope(stores));
+    }
+
     m_current_pass_info = nullptr;
   }
 
+  if (code_spill != nullptr) {
+    Timer t_restore("Restoring spilled code");
+    code_spill.reset();
+  }
+
   after_pass_size.wait();
 
   // Always run the type checker before generating the optimized dex code.
@@ -1295,6 +1531,54 @@ void PassManager::run_passes(DexStoresVector& stores, ConfigFiles& conf) {
                    m_check_unique_deobfuscateds_timer.get_seconds());
 }
 
+void PassManager::take_snapshot(DexStoresVector& stores, ConfigFiles& conf) {
+#ifdef __linux__
+  Timer t("Taking IR snapshot");
+  TRACE(PM, 1, "Taking IR snapshot after %s",
+        m_current_pass_info->name.c_str());
+  std::cout.flush();
+  std::cerr.flush();
+  pid_t p = fork();
+  always_assert_log(p >= 0, "Fork failed: %s", strerror(errno));
+
+  if (p == 0) {
+    // Child. Leave the parent's state alone, and never return into the pass
+    // loop.
+    auto maybe_run = [&](const char* pass_name) {
+      auto pass = find_pass(pass_name);
+      if (pass != nullptr) {
+        pass->run_pass(stores, conf, *this);
+      }
+    };
+    maybe_run("MakePublicPass");
+    if (!regalloc_has_run()) {
+      maybe_run("RegAllocPass");
+    }
+    m_snapshot_fn(*m_current_pass_info, stores, conf);
+    std::cout.flush();
+    std::cerr.flush();
+    _exit(EXIT_SUCCESS);
+  }
+
+  int stat = 0;
+  pid_t wait_res;
+  for (;;) {
+    wait_res = waitpid(p, &stat, 0);
+    if (wait_res != -1 || errno != EINTR) {
+      break;
+    }
+  }
+  always_assert_log(wait_res != -1 && WIFEXITED(stat) &&
+                        WEXITSTATUS(stat) == 0,
+                    "IR snapshot after %s failed: %x",
+                    m_current_pass_info->name.c_str(), stat);
+#else
+  (void)stores;
+  (void)conf;
+  not_reached_log("IR snapshots are only supported on Linux");
+#endif
+}
+
 void PassManager::activate_pass(const std::string& name,
                                 const Json::Value& conf) {
   // Names may or may not have a "#<id>" suffix to indicate their order in the
@@ -1335,6 +1619,78 @@ int64_t PassManager::get_metric(const std::string& key) {
   return (m_current_pass_info->metrics)[key];
 }
 
+pass_metrics::Counter& PassManager::register_counter(const std::string& key) {
+  always_assert_log(m_current_pass_info != nullptr, "No current pass!");
+  m_registered_counters.emplace_back(key,
+                                     std::make_unique<pass_metrics::Counter>());
+  return *m_registered_counters.back().second;
+}
+
+pass_metrics::Histogram& PassManager::register_histogram(
+    const std::string& key) {
+  always_assert_log(m_current_pass_info != nullptr, "No current pass!");
+  m_registered_histograms.emplace_back(
+      key, std::make_unique<pass_metrics::Histogram>());
+  return *m_registered_histograms.back().second;
+}
+
+boost::optional<double> PassManager::remaining_budget() const {
+  if (!m_pass_deadline) {
+    return boost::none;
+  }
+  std::chrono::duration<double> remaining =
+      *m_pass_deadline - std::chrono::steady_clock::now();
+  return std::max(0.0, remaining.count());
+}
+
+void PassManager::begin_pass_budget(const Json::Value& config,
+                                    const Pass* pass) {
+  using namespace std::chrono;
+  auto now = steady_clock::now();
+  m_pass_deadline = m_total_deadline;
+  const auto& pass_budgets = config["passes"];
+  if (pass_budgets.isMember(pass->name())) {
+    duration<double> budget(pass_budgets[pass->name()].asDouble());
+    auto deadline = now + duration_cast<steady_clock::duration>(budget);
+    if (!m_pass_deadline || deadline < *m_pass_deadline) {
+      m_pass_deadline = deadline;
+    }
+  }
+  if (m_pass_deadline) {
+    m_pass_start = now;
+    auto budget = duration_cast<milliseconds>(*m_pass_deadline - now);
+    set_metric("time_budget_ms", std::max<int64_t>(0, budget.count()));
+  }
+}
+
+void PassManager::end_pass_budget() {
+  using namespace std::chrono;
+  if (m_pass_deadline) {
+    auto used =
+        duration_cast<milliseconds>(steady_clock::now() - *m_pass_start);
+    set_metric("time_budget_used_ms", used.count());
+  }
+  m_pass_start = boost::none;
+  m_pass_deadline = boost::none;
+}
+
+void PassManager::flush_registered_metrics() {
+  auto& metrics = m_current_pass_info->metrics;
+  for (const auto& [key, counter] : m_registered_counters) {
+    metrics[key] += counter->get();
+  }
+  for (const auto& [key, histogram] : m_registered_histograms) {
+    metrics[key + "~count"] = histogram->count();
+    metrics[key + "~sum"] = histogram->sum();
+    metrics[key + "~max"] = histogram->max();
+    metrics[key + "~p50"] = histogram->percentile(50);
+    metrics[key + "~p90"] = histogram->percentile(90);
+    metrics[key + "~p99"] = histogram->percentile(99);
+  }
+  m_registered_counters.clear();
+  m_registered_histograms.clear();
+}
+
 const std::vector<PassManager::PassInfo>& PassManager::get_pass_info() const {
   return m_pass_info;
 }
@@ -8,6 +8,8 @@
 #pragma once
 
 #include <boost/optional.hpp>
+#include <chrono>
+#include <functional>
 #include <memory>
 #include <string>
 #include <typeinfo>
@@ -19,6 +21,7 @@
 #include "AssetManager.h"
 #include "DexHasher.h"
 #include "JsonWrapper.h"
+#include "PassMetrics.h"
 #include "ProguardConfiguration.h"
 #include "RedexOptions.h"
 #include "Timer.h"
@@ -53,6 +56,7 @@ class PassManager {
   struct PassInfo {
     const Pass* pass;
     size_t order; // zero-based
+    size_t config_index; // zero-based, in the configured pass list
     size_t repeat; // zero-based
     size_t total_repeat;
     std::string name;
@@ -65,6 +69,13 @@ class PassManager {
   void incr_metric(const std::string& key, int64_t value);
   void set_metric(const std::string& key, int64_t value);
   int64_t get_metric(const std::string& key);
+
+  // Metrics which the worker threads of the current pass can update without
+  // a lock. Register them before going parallel. They are added to the
+  // metrics of the pass when it ends; a histogram is reported as
+  // <key>~count, ~sum, ~max, ~p50, ~p90 and ~p99.
+  pass_metrics::Counter& register_counter(const std::string& key);
+  pass_metrics::Histogram& register_histogram(const std::string& key);
   const std::vector<PassManager::PassInfo>& get_pass_info() const;
   boost::optional<hashing::DexHash> get_initial_hash() const {
     return m_initial_hash;
@@ -88,6 +99,14 @@ class PassManager {
 
   const PassInfo* get_current_pass_info() const { return m_current_pass_info; }
 
+  // Seconds left of the time budget of the current pass, or none if it has
+  // no budget. A pass budget is the smaller of what is configured for the
+  // pass and what is left of the budget for all passes, e.g.
+  //   "time_budget": {"total_s": 1800, "passes": {"MethodInlinePass": 300}}
+  // Passes with knobs that trade time for quality may query this to scale
+  // their effort; nothing is ever interrupted.
+  boost::optional<double> remaining_budget() const;
+
   AssetManager& asset_manager() { return m_asset_mgr; }
 
   void record_running_regalloc() { m_regalloc_has_run = true; }
@@ -113,6 +132,19 @@ class PassManager {
 
   Pass* find_pass(const std::string& pass_name) const;
 
+  using SnapshotFn =
+      std::function<void(const PassInfo&, DexStoresVector&, ConfigFiles&)>;
+
+  // Hands a copy of the state after the pass at the given index of the
+  // configured pass list to `fn`, to write out an IR snapshot that later runs
+  // can resume from. The copy lives in a forked child, which first runs
+  // MakePublicPass and RegAllocPass (if configured) so that the IR can be
+  // written as dex. Only supported on Linux.
+  void set_snapshot_after_pass(size_t config_index, SnapshotFn fn) {
+    m_snapshot_index = config_index;
+    m_snapshot_fn = std::move(fn);
+  }
+
  private:
   void activate_pass(const std::string& name, const Json::Value& conf);
 
@@ -122,6 +154,14 @@ class PassManager {
 
   void eval_passes(DexStoresVector&, ConfigFiles&);
 
+  void take_snapshot(DexStoresVector&, ConfigFiles&);
+
+  void flush_registered_metrics();
+
+  // Sets up the deadline of the given pass from the "time_budget" config.
+  void begin_pass_budget(const Json::Value& config, const Pass* pass);
+  void end_pass_budget();
+
   AssetManager m_asset_mgr;
   std::vector<Pass*> m_registered_passes;
   std::vector<Pass*> m_activated_passes;
@@ -140,7 +180,23 @@ class PassManager {
 
   Pass* m_malloc_profile_pass{nullptr};
 
+  boost::optional<size_t> m_snapshot_index;
+  SnapshotFn m_snapshot_fn;
+
+  std::vector<std::pair<std::string, std::unique_ptr<pass_metrics::Counter>>>
+      m_registered_counters;
+  std::vector<
+      std::pair<std::string, std::unique_ptr<pass_metrics::Histogram>>>
+      m_registered_histograms;
+
+  boost::optional<std::chrono::steady_clock::time_point> m_total_deadline;
+  boost::optional<std::chrono::steady_clock::time_point> m_pass_start;
+  boost::optional<std::chrono::steady_clock::time_point> m_pass_deadline;
+
   boost::optional<hashing::DexHash> m_initial_hash;
+  // Code hashes of methods, kept across passes so that only changed methods
+  // are rehashed.
+  hashing::MethodHashCache m_method_hash_cache;
   AccumulatingTimer m_hashers_timer;
   AccumulatingTimer m_check_unique_deobfuscateds_timer;
 };
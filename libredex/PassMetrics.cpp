@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "PassMetrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "Debug.h"
+
+namespace pass_metrics {
+
+size_t thread_slot() {
+  static std::atomic<size_t> next_slot{0};
+  thread_local size_t slot =
+      next_slot.fetch_add(1, std::memory_order_relaxed) % NUM_SLOTS;
+  return slot;
+}
+
+int64_t Counter::get() const {
+  int64_t sum = 0;
+  for (const auto& slot : m_slots) {
+    sum += slot.value.load(std::memory_order_relaxed);
+  }
+  return sum;
+}
+
+namespace {
+
+size_t bucket_of(uint64_t value) {
+  return value == 0 ? 0 : 64 - __builtin_clzll(value);
+}
+
+uint64_t bucket_upper_bound(size_t bucket) {
+  if (bucket == 0) {
+    return 0;
+  }
+  if (bucket == 64) {
+    return std::numeric_limits<uint64_t>::max();
+  }
+  return (uint64_t(1) << bucket) - 1;
+}
+
+} // namespace
+
+void Histogram::record(uint64_t value) {
+  m_buckets[bucket_of(value)].fetch_add(1, std::memory_order_relaxed);
+  m_sum.fetch_add(value, std::memory_order_relaxed);
+  uint64_t max = m_max.load(std::memory_order_relaxed);
+  while (value > max &&
+         !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+  }
+}
+
+uint64_t Histogram::count() const {
+  uint64_t count = 0;
+  for (const auto& bucket : m_buckets) {
+    count += bucket.load(std::memory_order_relaxed);
+  }
+  return count;
+}
+
+uint64_t Histogram::percentile(double p) const {
+  always_assert(p >= 0 && p <= 100);
+  uint64_t total = count();
+  if (total == 0) {
+    return 0;
+  }
+  auto rank = std::max<uint64_t>(1, (uint64_t)std::ceil(p / 100 * total));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+    seen += m_buckets[i].load(std::memory_order_relaxed);
+    if (seen >= rank) {
+      return std::min(bucket_upper_bound(i), max());
+    }
+  }
+  return max();
+}
+
+} // namespace pass_metrics
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Metrics which worker threads of a pass can update without taking a lock.
+ * Obtain them from PassManager::register_counter() and register_histogram()
+ * before going parallel; PassManager adds them to the metrics of the pass
+ * when it ends.
+ */
+namespace pass_metrics {
+
+constexpr size_t NUM_SLOTS = 64;
+
+// A small number for the calling thread, to spread the updates of different
+// threads over different slots.
+size_t thread_slot();
+
+/*
+ * A sum. Each thread adds into one of a fixed number of cache-line sized
+ * slots, and reading adds up all slots.
+ */
+class Counter {
+ public:
+  void add(int64_t value) {
+    m_slots[thread_slot()].value.fetch_add(value, std::memory_order_relaxed);
+  }
+
+  int64_t get() const;
+
+ private:
+  struct alignas(64) Slot {
+    std::atomic<int64_t> value{0};
+  };
+  std::array<Slot, NUM_SLOTS> m_slots;
+};
+
+/*
+ * The distribution of non-negative values, e.g. the sizes of inlined callees,
+ * in power-of-two buckets. Percentiles are reported as the upper bound of the
+ * bucket they fall into, capped by the largest value recorded.
+ */
+class Histogram {
+ public:
+  void record(uint64_t value);
+
+  uint64_t count() const;
+  uint64_t sum() const { return m_sum.load(std::memory_order_relaxed); }
+  uint64_t max() const { return m_max.load(std::memory_order_relaxed); }
+
+  // `p` is in [0, 100].
+  uint64_t percentile(double p) const;
+
+ private:
+  // Bucket 0 holds zeros, bucket i > 0 holds values in [2^(i-1), 2^i).
+  static constexpr size_t NUM_BUCKETS = 65;
+  std::array<std::atomic<uint64_t>, NUM_BUCKETS> m_buckets{};
+  std::atomic<uint64_t> m_sum{0};
+  std::atomic<uint64_t> m_max{0};
+};
+
+} // namespace pass_metrics
@@ -159,11 +159,11 @@ s_expr dex_method_to_s_expr(DexMethodRef* dex_method) {
   DexProto* proto = dex_method->get_proto();
   std::vector<s_expr> signature;
   for (DexType* arg : proto->get_args()->get_type_list()) {
-    signature.push_back(s_expr(arg->get_name()->str()));
+    signature.push_back(s_expr(arg->get_name()->str_copy()));
   }
-  return s_expr({s_expr(dex_method->get_class()->get_name()->str()),
-                 s_expr(dex_method->get_name()->str()),
-                 s_expr(proto->get_rtype()->get_name()->str()),
+  return s_expr({s_expr(dex_method->get_class()->get_name()->str_copy()),
+                 s_expr(dex_method->get_name()->str_copy()),
+                 s_expr(proto->get_rtype()->get_name()->str_copy()),
                  s_expr(signature)});
 }
 
@@ -177,7 +177,7 @@ boost::optional<DexMethodRef*> s_expr_to_dex_method(const s_expr& e) {
            .match_with(e)) {
     return {};
   }
-  std::deque<DexType*> types;
+  DexTypeList::ContainerType types;
   for (size_t arg = 0; arg < signature.size(); ++arg) {
     if (!signature[arg].is_string()) {
       return {};
@@ -197,13 +197,13 @@ s_expr PointsToOperation::to_s_expr() const {
   using namespace pts_impl;
   switch (kind) {
   case PTS_CONST_STRING: {
-    return s_expr({op_kind_to_s_expr(kind), s_expr(dex_string->str())});
+    return s_expr({op_kind_to_s_expr(kind), s_expr(dex_string->str_copy())});
   }
   case PTS_CONST_CLASS:
   case PTS_NEW_OBJECT:
   case PTS_CHECK_CAST: {
     return s_expr(
-        {op_kind_to_s_expr(kind), s_expr(dex_type->get_name()->str())});
+        {op_kind_to_s_expr(kind), s_expr(dex_type->get_name()->str_copy())});
   }
   case PTS_GET_EXCEPTION:
   case PTS_GET_CLASS:
@@ -220,9 +220,9 @@ s_expr PointsToOperation::to_s_expr() const {
   case PTS_IPUT:
   case PTS_SPUT: {
     return s_expr({op_kind_to_s_expr(kind),
-                   s_expr(dex_field->get_class()->get_name()->str()),
-                   s_expr(dex_field->get_name()->str()),
-                   s_expr(dex_field->get_type()->get_name()->str())});
+                   s_expr(dex_field->get_class()->get_name()->str_copy()),
+                   s_expr(dex_field->get_name()->str_copy()),
+                   s_expr(dex_field->get_type()->get_name()->str_copy())});
   }
   case PTS_IGET_SPECIAL:
   case PTS_IPUT_SPECIAL: {
@@ -1307,8 +1307,26 @@ class Shrinker final {
   }
 
  private:
-  using VariableSet =
-      std::unordered_set<PointsToVariable, boost::hash<PointsToVariable>>;
+  // Variable identifiers are allocated densely per method, starting from the
+  // special variables (which have small negative identifiers). We therefore
+  // index the dependency graph and the set of variables to keep directly by
+  // identifier instead of hashing variables.
+  static size_t index(const PointsToVariable& v) {
+    return static_cast<size_t>(v.m_id - PointsToVariable::this_var_id());
+  }
+
+  void ensure_index(size_t i) {
+    if (i >= m_dependency_graph.size()) {
+      m_dependency_graph.resize(i + 1);
+      m_vars_to_keep.resize(i + 1, false);
+    }
+  }
+
+  void add_root_var(const PointsToVariable& v) {
+    size_t i = index(v);
+    ensure_index(i);
+    m_root_vars.push_back(i);
+  }
 
   // We keep all `put`, `invoke` and `return` operations, since they presumably
   // have an effect on the analysis.
@@ -1317,22 +1335,22 @@ class Shrinker final {
       const PointsToOperation& op = pt_action.operation();
       if (op.is_put()) {
         if (!op.is_sput()) {
-          m_root_vars.insert(pt_action.lhs());
+          add_root_var(pt_action.lhs());
         }
-        m_root_vars.insert(pt_action.rhs());
+        add_root_var(pt_action.rhs());
         continue;
       }
       if (op.is_invoke()) {
         if (op.is_virtual_call()) {
-          m_root_vars.insert(pt_action.instance());
+          add_root_var(pt_action.instance());
         }
         for (const auto& arg : pt_action.get_arguments()) {
-          m_root_vars.insert(arg.second);
+          add_root_var(arg.second);
         }
         continue;
       }
       if (op.is_return()) {
-        m_root_vars.insert(pt_action.src());
+        add_root_var(pt_action.src());
         continue;
       }
     }
@@ -1365,29 +1383,37 @@ class Shrinker final {
   }
 
   void add_dependency(const PointsToVariable& x, const PointsToVariable& y) {
-    m_dependency_graph[x].insert(y);
+    size_t i = index(x);
+    size_t j = index(y);
+    ensure_index(std::max(i, j));
+    m_dependency_graph[i].push_back(j);
   }
 
   // If there exists a path from any root variable to a variable v, this means
   // that the value of variable v is required for performing the points-to
   // analysis. All other variables can safely be discarded. We compute the set
-  // of reachable variables using a simple breadth-first traversal of the graph.
+  // of reachable variables using a simple depth-first traversal of the graph.
   void collect_reachable_vars() {
-    std::deque<PointsToVariable> queue(m_root_vars.begin(), m_root_vars.end());
-    while (!queue.empty()) {
-      PointsToVariable v = queue.back();
-      queue.pop_back();
+    std::vector<size_t> stack(std::move(m_root_vars));
+    while (!stack.empty()) {
+      size_t v = stack.back();
+      stack.pop_back();
       // Note that the variables already visited are exactly the variables that
       // we need to keep.
-      if (m_vars_to_keep.count(v) != 0) {
+      if (m_vars_to_keep[v]) {
         continue;
       }
-      m_vars_to_keep.insert(v);
+      m_vars_to_keep[v] = true;
       const auto& deps = m_dependency_graph[v];
-      queue.insert(queue.begin(), deps.begin(), deps.end());
+      stack.insert(stack.end(), deps.begin(), deps.end());
     }
   }
 
+  bool is_kept(const PointsToVariable& v) const {
+    size_t i = index(v);
+    return i < m_vars_to_keep.size() && m_vars_to_keep[i];
+  }
+
   void shrink_points_to_actions() {
     // Any `load`, `check_cast`, `get` or `disjunction` operation assigning a
     // value to a variable that hasn't been marked to keep can safely be
@@ -1399,7 +1425,7 @@ class Shrinker final {
                          const PointsToOperation& op = pt_action.operation();
                          return (op.is_load() || op.is_check_cast() ||
                                  op.is_get() || op.is_disjunction()) &&
-                                (m_vars_to_keep.count(pt_action.dest()) == 0);
+                                !is_kept(pt_action.dest());
                        }),
         m_pt_actions->end());
     m_pt_actions->shrink_to_fit();
@@ -1411,19 +1437,17 @@ class Shrinker final {
     // valuable optimization.
     for (PointsToAction& pt_action : *m_pt_actions) {
       if (pt_action.operation().is_invoke() && pt_action.has_dest() &&
-          (m_vars_to_keep.count(pt_action.dest()) == 0)) {
+          !is_kept(pt_action.dest())) {
         pt_action.remove_dest();
       }
     }
   }
 
   std::vector<PointsToAction>* m_pt_actions;
-  std::unordered_map<PointsToVariable,
-                     VariableSet,
-                     boost::hash<PointsToVariable>>
-      m_dependency_graph;
-  VariableSet m_root_vars;
-  VariableSet m_vars_to_keep;
+  // Adjacency lists of the dependency graph, indexed by variable.
+  std::vector<std::vector<size_t>> m_dependency_graph;
+  std::vector<size_t> m_root_vars;
+  std::vector<bool> m_vars_to_keep;
 };
 
 /* clang-format off */
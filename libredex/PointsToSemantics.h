@@ -92,9 +92,13 @@
  * code.
  */
 
-// Forward declaration.
+// Forward declarations.
 class PointsToSemantics;
 
+namespace pts_impl {
+class Shrinker;
+} // namespace pts_impl
+
 /*
  * A points-to variable denotes a set of abstract object instances. It is
  * uniquely identified by a positive number.
@@ -132,6 +136,7 @@ class PointsToVariable final {
   int32_t m_id;
 
   friend class PointsToMethodSemantics;
+  friend class pts_impl::Shrinker;
   friend size_t hash_value(const PointsToVariable&);
   friend bool operator==(const PointsToVariable&, const PointsToVariable&);
   friend bool operator<(const PointsToVariable&, const PointsToVariable&);
@@ -80,41 +80,42 @@ void keep_rules::print_seeds(std::ostream& output,
                              const Scope& classes,
                              const bool allowshrinking_filter,
                              const bool allowobfuscation_filter) {
-  for (const auto& cls : classes) {
-    auto deob = cls->get_deobfuscated_name();
-    if (deob.empty()) {
-      std::cerr << "WARNING: this class has no deobu name: "
-                << cls->get_name()->c_str() << std::endl;
-      deob = cls->get_name()->c_str();
-    }
-    std::string name = java_names::internal_to_external(deob);
-    if (impl::KeepState::has_keep(cls)) {
-      show_class(
-          output, cls, name, allowshrinking_filter, allowobfuscation_filter);
-    }
-    print_field_seeds(output,
-                      pg_map,
-                      name,
-                      cls->get_ifields(),
-                      allowshrinking_filter,
-                      allowobfuscation_filter);
-    print_field_seeds(output,
-                      pg_map,
-                      name,
-                      cls->get_sfields(),
-                      allowshrinking_filter,
-                      allowobfuscation_filter);
-    print_method_seeds(output,
-                       pg_map,
-                       name,
-                       cls->get_dmethods(),
-                       allowshrinking_filter,
-                       allowobfuscation_filter);
-    print_method_seeds(output,
-                       pg_map,
-                       name,
-                       cls->get_vmethods(),
-                       allowshrinking_filter,
-                       allowobfuscation_filter);
-  }
+  redex::print_partitioned(
+      output, classes, [&](std::ostream& out, const DexClass* cls) {
+        auto deob = cls->get_deobfuscated_name();
+        if (deob.empty()) {
+          std::cerr << "WARNING: this class has no deobu name: "
+                    << cls->get_name()->c_str() << std::endl;
+          deob = cls->get_name()->c_str();
+        }
+        std::string name = java_names::internal_to_external(deob);
+        if (impl::KeepState::has_keep(cls)) {
+          show_class(
+              out, cls, name, allowshrinking_filter, allowobfuscation_filter);
+        }
+        print_field_seeds(out,
+                          pg_map,
+                          name,
+                          cls->get_ifields(),
+                          allowshrinking_filter,
+                          allowobfuscation_filter);
+        print_field_seeds(out,
+                          pg_map,
+                          name,
+                          cls->get_sfields(),
+                          allowshrinking_filter,
+                          allowobfuscation_filter);
+        print_method_seeds(out,
+                           pg_map,
+                           name,
+                           cls->get_dmethods(),
+                           allowshrinking_filter,
+                           allowobfuscation_filter);
+        print_method_seeds(out,
+                           pg_map,
+                           name,
+                           cls->get_vmethods(),
+                           allowshrinking_filter,
+                           allowobfuscation_filter);
+      });
 }
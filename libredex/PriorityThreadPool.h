@@ -43,6 +43,13 @@ class PriorityThreadPool {
   size_t m_running_work_items{0};
   std::chrono::duration<double> m_waited_time{0};
   bool m_shutdown{false};
+  // Utilization accounting: the integral of the number of running work items
+  // over time, and the time during which all threads were running.
+  boost::optional<std::chrono::steady_clock::time_point> m_first_post_time;
+  std::chrono::steady_clock::time_point m_last_change_time;
+  std::chrono::duration<double> m_active_time{0};
+  std::chrono::duration<double> m_busy_time{0};
+  std::chrono::duration<double> m_saturated_time{0};
 
  public:
   // Creates an instance with a default number of threads
@@ -68,6 +75,23 @@ class PriorityThreadPool {
         .count();
   }
 
+  // Fraction of the available thread time that was spent running work items,
+  // between the first post and the end of the last wait.
+  double get_utilization() {
+    std::unique_lock<std::mutex> lock{m_mutex};
+    auto available = m_active_time.count() * m_pool.size();
+    return available > 0 ? m_busy_time.count() / available : 0;
+  }
+
+  // Fraction of the time between the first post and the end of the last wait
+  // during which all threads were running work items.
+  double get_saturation() {
+    std::unique_lock<std::mutex> lock{m_mutex};
+    return m_active_time.count() > 0
+               ? m_saturated_time.count() / m_active_time.count()
+               : 0;
+  }
+
   // The number of threads may be set at most once to a positive number
   void set_num_threads(int num_threads) {
     always_assert(m_pool.empty());
@@ -90,6 +114,10 @@ class PriorityThreadPool {
     always_assert(!m_pool.empty());
     std::unique_lock<std::mutex> lock{m_mutex};
     always_assert(!m_shutdown);
+    if (!m_first_post_time) {
+      m_first_post_time = std::chrono::steady_clock::now();
+      m_last_change_time = *m_first_post_time;
+    }
     m_pending_work_items[priority].push(f);
     m_work_condition.notify_one();
   }
@@ -104,6 +132,11 @@ class PriorityThreadPool {
       m_done_condition.wait(lock, [&]() {
         return m_running_work_items == 0 && m_pending_work_items.empty();
       });
+      if (m_first_post_time) {
+        m_active_time +=
+            std::chrono::steady_clock::now() - *m_first_post_time;
+        m_first_post_time = boost::none;
+      }
       if (init_shutdown) {
         m_shutdown = true;
         m_work_condition.notify_all();
@@ -128,6 +161,18 @@ class PriorityThreadPool {
   }
 
  private:
+  // Accounts for the time since the number of running work items last
+  // changed. The mutex must be held.
+  void account_running_work_items() {
+    auto now = std::chrono::steady_clock::now();
+    auto elapsed = now - m_last_change_time;
+    m_busy_time += elapsed * m_running_work_items;
+    if (m_running_work_items == m_pool.size()) {
+      m_saturated_time += elapsed;
+    }
+    m_last_change_time = now;
+  }
+
   void run() {
     for (;;) {
       auto highest_priority_f =
@@ -151,6 +196,7 @@ class PriorityThreadPool {
           auto highest_priority = p.first;
           m_pending_work_items.erase(highest_priority);
         }
+        account_running_work_items();
         m_running_work_items++;
         return f;
       }();
@@ -169,6 +215,7 @@ class PriorityThreadPool {
       // Notify when *all* work is done, i.e. nothing is running or pending.
       {
         std::unique_lock<std::mutex> lock{m_mutex};
+        account_running_work_items();
         if (--m_running_work_items == 0 && m_pending_work_items.empty()) {
           m_done_condition.notify_one();
         }
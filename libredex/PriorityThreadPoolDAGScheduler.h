@@ -21,8 +21,11 @@ class PriorityThreadPoolDAGScheduler {
   Executor m_executor;
   std::unordered_map<Task, std::unordered_set<Task>> m_waiting_for;
   std::unordered_map<Task, uint32_t> m_wait_counts;
+  std::unordered_map<Task, uint32_t> m_weights;
   std::unique_ptr<std::unordered_map<Task, int>> m_priorities;
+  std::unique_ptr<std::unordered_map<Task, uint64_t>> m_weighted_lengths;
   int m_max_priority{-1};
+  uint64_t m_max_weighted_length{0};
   struct ConcurrentState {
     uint32_t wait_count{0};
     std::vector<std::function<void()>> continuations{};
@@ -46,6 +49,27 @@ class PriorityThreadPoolDAGScheduler {
     return value;
   }
 
+  // The total weight of the heaviest chain of tasks starting with the given
+  // task and continuing through the tasks waiting for it.
+  uint64_t compute_weighted_length(Task task) {
+    auto it = m_weighted_lengths->find(task);
+    if (it != m_weighted_lengths->end()) {
+      return it->second;
+    }
+    uint64_t value = 0;
+    auto it2 = m_waiting_for.find(task);
+    if (it2 != m_waiting_for.end()) {
+      for (auto other_task : it2->second) {
+        value = std::max(value, compute_weighted_length(other_task));
+      }
+    }
+    auto it3 = m_weights.find(task);
+    value += it3 == m_weights.end() ? 1 : it3->second;
+    m_weighted_lengths->emplace(task, value);
+    m_max_weighted_length = std::max(m_max_weighted_length, value);
+    return value;
+  }
+
   uint32_t increment_wait_count(Task task, uint32_t count = 1) {
     uint32_t res = 0;
     m_concurrent_states->update(
@@ -137,6 +161,19 @@ class PriorityThreadPoolDAGScheduler {
     ++m_wait_counts[task];
   }
 
+  // Sets the estimated cost of a task. When any weights are given, tasks are
+  // prioritized by the total weight of their longest chain of waiting tasks,
+  // and then by how many tasks are waiting for them; unweighted tasks weigh
+  // 1. Otherwise, priorities are based on the number of tasks in that chain.
+  void set_weight(Task task, uint32_t weight) {
+    always_assert(!m_concurrent_states);
+    m_weights[task] = weight;
+  }
+
+  // The total weight of the heaviest chain of tasks of the last run, if any
+  // weights were set.
+  uint64_t get_max_weighted_length() const { return m_max_weighted_length; }
+
   // While the given task is running, register another function that needs to
   // run before the current task can be considered done. If "continuation" is
   // true, then the given function will only run after all other actions
@@ -163,10 +200,27 @@ class PriorityThreadPoolDAGScheduler {
     for (auto it = begin; it != end; it++) {
       compute_priority(*it);
     }
-    for (auto& p : *m_priorities) {
-      auto it = m_wait_counts.find(p.first);
-      p.second =
-          (p.second << 16) + (it == m_wait_counts.end() ? 0 : it->second);
+    if (m_weights.empty()) {
+      for (auto& p : *m_priorities) {
+        auto it = m_wait_counts.find(p.first);
+        p.second =
+            (p.second << 16) + (it == m_wait_counts.end() ? 0 : it->second);
+      }
+    } else {
+      // The weighted length goes into the upper 23 bits of the (positive)
+      // priority; the number of waiting tasks breaks ties.
+      m_weighted_lengths =
+          std::make_unique<std::unordered_map<Task, uint64_t>>();
+      m_max_weighted_length = 0;
+      for (auto& p : *m_priorities) {
+        auto length = std::min<uint64_t>(compute_weighted_length(p.first),
+                                         (1 << 23) - 1);
+        auto it = m_waiting_for.find(p.first);
+        auto waiting = std::min<size_t>(
+            it == m_waiting_for.end() ? 0 : it->second.size(), 255);
+        p.second = (int)((length << 8) + waiting);
+      }
+      m_weighted_lengths = nullptr;
     }
 
     m_concurrent_states =
@@ -193,6 +247,7 @@ class PriorityThreadPoolDAGScheduler {
     }
     m_concurrent_states = nullptr;
     m_waiting_for.clear();
+    m_weights.clear();
     m_priorities = nullptr;
     auto max_priority = m_max_priority;
     m_max_priority = 0;
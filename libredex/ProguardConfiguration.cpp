@@ -9,6 +9,7 @@
 
 #include <algorithm>
 #include <boost/functional/hash.hpp>
+#include <unordered_map>
 
 #include "StlUtil.h"
 
@@ -90,4 +91,19 @@ void KeepSpecSet::erase_if(const std::function<bool(const KeepSpec&)>& pred) {
       m_ordered.end());
 }
 
+void KeepSpecSet::append(KeepSpecSet&& other) {
+  std::unordered_map<const KeepSpec*, std::unique_ptr<KeepSpec>> owned;
+  owned.reserve(other.m_unordered_set.size());
+  for (auto it = other.m_unordered_set.begin();
+       it != other.m_unordered_set.end();) {
+    auto node = other.m_unordered_set.extract(it++);
+    auto* spec = node.value().get();
+    owned.emplace(spec, std::move(node.value()));
+  }
+  for (auto* spec : other.m_ordered) {
+    emplace(std::move(owned.at(spec)));
+  }
+  other.m_ordered.clear();
+}
+
 } // namespace keep_rules
@@ -123,6 +123,9 @@ class KeepSpecSet {
 
   void erase_if(const std::function<bool(const KeepSpec&)>&);
 
+  // Moves the specs of `other` over, as if they were emplaced in its order.
+  void append(KeepSpecSet&& other);
+
  private:
   std::vector<KeepSpec*> m_ordered;
   std::unordered_set<std::unique_ptr<KeepSpec>,
@@ -7,9 +7,14 @@
 
 #include "ProguardMap.h"
 
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
 #include "DexPosition.h"
 #include "DexUtil.h"
 #include "IRCode.h"
+#include "RedexMappedFile.h"
 #include "Show.h"
 #include "Timer.h"
 #include "Trace.h"
@@ -17,14 +22,35 @@
 
 namespace {
 
-std::string find_or_same(
-    const std::string& key,
-    const std::unordered_map<std::string, std::string>& map) {
+std::string_view find_or_same(
+    std::string_view key,
+    const std::unordered_map<std::string_view, std::string_view>& map) {
   auto it = map.find(key);
   if (it == map.end()) return key;
   return it->second;
 }
 
+constexpr size_t POOL_BLOCK_SIZE = 1 << 20;
+
+/*
+ * Calls fn on each line of the contents, without the line terminator. The
+ * parsers below rely on lines being followed by a terminator, so a last line
+ * without one is copied.
+ */
+template <typename F>
+void for_each_line(std::string_view contents, const F& fn) {
+  while (!contents.empty()) {
+    auto end = contents.find('\n');
+    if (end == std::string_view::npos) {
+      std::string last_line(contents);
+      fn(std::string_view(last_line));
+      return;
+    }
+    fn(contents.substr(0, end));
+    contents.remove_prefix(end + 1);
+  }
+}
+
 std::string convert_scalar_type(const std::string& type) {
   static const std::unordered_map<std::string, std::string> prim_map = {
       {"void", "V"},  {"boolean", "Z"}, {"byte", "B"},
@@ -39,7 +65,7 @@ std::string convert_scalar_type(const std::string& type) {
 
 std::string convert_field(const std::string& cls,
                           const std::string& type,
-                          const std::string& name) {
+                          std::string_view name) {
   std::ostringstream ss;
   ss << cls << "." << name;
   if (!type.empty()) {
@@ -50,7 +76,7 @@ std::string convert_field(const std::string& cls,
 
 std::string convert_method(const std::string& cls,
                            const std::string& rtype,
-                           const std::string& methodname,
+                           std::string_view methodname,
                            const std::string& args) {
   std::ostringstream ss;
   ss << cls << "." << methodname << ":(" << args << ")" << rtype;
@@ -84,7 +110,7 @@ bool isseparator(uint32_t cp) {
 }
 
 template <typename F>
-bool id(const char*& p, std::string& s, F isseparator) {
+bool id(const char*& p, std::string_view& s, F isseparator) {
   auto b = p;
   auto first = mutf8_next_code_point(p);
   if (isdigit(first)) return false;
@@ -93,13 +119,13 @@ bool id(const char*& p, std::string& s, F isseparator) {
     auto cp = mutf8_next_code_point(p);
     if (isseparator(cp)) {
       p = prev;
-      s = std::string(b, p - b);
+      s = std::string_view(b, p - b);
       return true;
     }
   }
 }
 
-bool id(const char*& p, std::string& s) { return id(p, s, isseparator); }
+bool id(const char*& p, std::string_view& s) { return id(p, s, isseparator); }
 
 bool literal(const char*& p, const char* s) {
   auto len = strlen(s);
@@ -116,10 +142,13 @@ bool literal(const char*& p, char s) {
   return false;
 }
 
-bool field_full_format(const char*& p, std::string& s) {
-  std::string class_name;
-  std::string field_name;
-  std::string type;
+// The full format spells out descriptors, so the parsed name is a substring
+// of the line.
+bool field_full_format(const char*& p, std::string_view& s) {
+  auto b = p;
+  std::string_view class_name;
+  std::string_view field_name;
+  std::string_view type;
 
   if (!id(p, class_name, [](uint32_t s) { return s == ';'; })) {
     return false;
@@ -139,15 +168,16 @@ bool field_full_format(const char*& p, std::string& s) {
     return false;
   }
 
-  s = class_name + ";." + field_name + ":" + type;
+  s = std::string_view(b, p - b);
   return true;
 }
 
-bool method_full_format(const char*& p, std::string& s) {
-  std::string class_name;
-  std::string method_name;
-  std::string args;
-  std::string rtype;
+bool method_full_format(const char*& p, std::string_view& s) {
+  auto b = p;
+  std::string_view class_name;
+  std::string_view method_name;
+  std::string_view args;
+  std::string_view rtype;
 
   if (!id(p, class_name, [](uint32_t s) { return s == ';'; })) {
     return false;
@@ -176,20 +206,20 @@ bool method_full_format(const char*& p, std::string& s) {
     return false;
   }
 
-  s = class_name + ";." + method_name + ":(" + args + ")" + rtype;
+  s = std::string_view(b, p - b);
   return true;
 }
 
-bool comment(const std::string& line) {
-  auto p = line.c_str();
+bool comment(std::string_view line) {
+  auto p = line.data();
   whitespace(p);
   return literal(p, '#');
 }
 
-void inlined_method(std::string& classname, std::string& methodname) {
+void inlined_method(std::string& classname, std::string_view& methodname) {
   std::size_t found = methodname.find_last_of('.');
-  if (found != std::string::npos) {
-    classname = convert_scalar_type(methodname.substr(0, found));
+  if (found != std::string_view::npos) {
+    classname = convert_scalar_type(std::string(methodname.substr(0, found)));
     methodname = methodname.substr(found + 1);
   }
 }
@@ -203,7 +233,7 @@ void inlined_method(std::string& classname, std::string& methodname) {
  * After:
  *   a_vcard.android.syncml.pim.VBuilder mExecutorSupplier$7ec36e13 -> b
  */
-bool is_maybe_proguard_generated_member(const std::string& s) {
+bool is_maybe_proguard_generated_member(std::string_view s) {
   unsigned int count = 0;
   for (auto it = s.rbegin(); it != s.rend(); ++it, ++count) {
     if (isxdigit(*it)) continue;
@@ -214,42 +244,121 @@ bool is_maybe_proguard_generated_member(const std::string& s) {
 }
 } // namespace
 
+ProguardMap::ProguardMap() = default;
+
 ProguardMap::ProguardMap(const std::string& filename, bool use_new_rename_map) {
   if (filename.empty()) {
     return;
   }
   Timer t("Parsing proguard map");
-  std::ifstream fp(filename);
-  always_assert_log(fp, "Can't open proguard map: %s\n", filename.c_str());
+  {
+    std::ifstream fp(filename);
+    always_assert_log(fp, "Can't open proguard map: %s\n", filename.c_str());
+    if (fp.peek() == std::ifstream::traits_type::eof()) {
+      // Empty files cannot be mapped.
+      return;
+    }
+  }
+  m_mapped_file =
+      std::make_unique<RedexMappedFile>(RedexMappedFile::open(filename));
+  m_mapped_contents =
+      std::string_view(m_mapped_file->const_data(), m_mapped_file->size());
 
   if (use_new_rename_map) {
-    parse_full_map(fp);
+    parse_full_map(m_mapped_contents);
   } else {
-    parse_proguard_map(fp);
+    parse_proguard_map(m_mapped_contents);
   }
 }
 
+ProguardMap::ProguardMap(std::istream& is) {
+  std::ostringstream contents;
+  contents << is.rdbuf();
+  parse_proguard_map(contents.str());
+}
+
+ProguardMap::~ProguardMap() = default;
+
+ProguardMap::ProguardMap(ProguardMap&&) = default;
+
+ProguardMap& ProguardMap::operator=(ProguardMap&&) = default;
+
+std::string_view ProguardMap::store(std::string_view name) {
+  if (name.data() >= m_mapped_contents.data() &&
+      name.data() + name.size() <=
+          m_mapped_contents.data() + m_mapped_contents.size()) {
+    return name;
+  }
+  auto it = m_pool.find(name);
+  if (it != m_pool.end()) {
+    return *it;
+  }
+  if (name.size() > m_pool_left) {
+    auto block_size = std::max(POOL_BLOCK_SIZE, name.size());
+    m_pool_blocks.emplace_back(new char[block_size]);
+    m_pool_next = m_pool_blocks.back().get();
+    m_pool_left = block_size;
+  }
+  if (!name.empty()) {
+    memcpy(m_pool_next, name.data(), name.size());
+  }
+  std::string_view stored(m_pool_next, name.size());
+  m_pool_next += name.size();
+  m_pool_left -= name.size();
+  m_pool.insert(stored);
+  return stored;
+}
+
 std::string ProguardMap::translate_class(const std::string& cls) const {
-  return find_or_same(cls, m_classMap);
+  return std::string(translate_class_view(cls));
 }
 
 std::string ProguardMap::translate_field(const std::string& field) const {
-  return find_or_same(field, m_fieldMap);
+  return std::string(translate_field_view(field));
 }
 
 std::string ProguardMap::translate_method(const std::string& method) const {
-  return find_or_same(method, m_methodMap);
+  return std::string(translate_method_view(method));
 }
 
 std::string ProguardMap::deobfuscate_class(const std::string& cls) const {
-  return find_or_same(cls, m_obfClassMap);
+  return std::string(deobfuscate_class_view(cls));
 }
 
 std::string ProguardMap::deobfuscate_field(const std::string& field) const {
-  return find_or_same(find_or_same(field, m_obfFieldMap), m_obfUntypedFieldMap);
+  return std::string(deobfuscate_field_view(field));
 }
 
 std::string ProguardMap::deobfuscate_method(const std::string& method) const {
+  return std::string(deobfuscate_method_view(method));
+}
+
+std::string_view ProguardMap::translate_class_view(std::string_view cls) const {
+  return find_or_same(cls, m_classMap);
+}
+
+std::string_view ProguardMap::translate_field_view(
+    std::string_view field) const {
+  return find_or_same(field, m_fieldMap);
+}
+
+std::string_view ProguardMap::translate_method_view(
+    std::string_view method) const {
+  return find_or_same(method, m_methodMap);
+}
+
+std::string_view ProguardMap::deobfuscate_class_view(
+    std::string_view cls) const {
+  return find_or_same(cls, m_obfClassMap);
+}
+
+std::string_view ProguardMap::deobfuscate_field_view(
+    std::string_view field) const {
+  return find_or_same(find_or_same(field, m_obfFieldMap), m_obfUntypedFieldMap);
+}
+
+std::string_view ProguardMap::deobfuscate_method_view(
+    std::string_view method) const {
   return find_or_same(find_or_same(method, m_obfMethodMap),
                       m_obfUntypedMethodMap);
 }
@@ -258,7 +367,7 @@ std::vector<ProguardMap::Frame> ProguardMap::deobfuscate_frame(
     DexString* method_name, uint32_t line) const {
   std::vector<Frame> frames;
   auto ranges_it =
-      m_obfMethodLinesMap.find(pg_impl::lines_key(method_name->str()));
+      m_obfMethodLinesMap.find(pg_impl::lines_key(method_name->str_copy()));
   if (ranges_it != m_obfMethodLinesMap.end()) {
     for (const auto& range : ranges_it->second) {
       if (!range->matches(line)) {
@@ -286,79 +395,73 @@ ProguardLineRangeVector& ProguardMap::method_lines(
   return m_obfMethodLinesMap.at(pg_impl::lines_key(obfuscated_method));
 }
 
-void ProguardMap::parse_proguard_map(std::istream& fp) {
-  std::string line;
-  while (std::getline(fp, line)) {
-    parse_class(line);
-  }
-  fp.clear();
-  fp.seekg(0);
-  assert_log(!fp.fail(), "Can't use ProguardMap with non-seekable stream");
-  while (std::getline(fp, line)) {
+void ProguardMap::parse_proguard_map(std::string_view contents) {
+  // Fields and methods refer to classes declared later in the file, so
+  // collect the classes first.
+  for_each_line(contents, [&](std::string_view line) { parse_class(line); });
+  for_each_line(contents, [&](std::string_view line) {
     if (parse_class(line)) {
-      continue;
+      return;
     }
     if (parse_field(line)) {
-      continue;
+      return;
     }
     if (parse_method(line)) {
-      continue;
+      return;
     }
     if (comment(line)) {
-      continue;
+      return;
     }
     not_reached_log("Bogus line encountered in proguard map: %s\n",
-                    line.c_str());
-  }
+                    std::string(line).c_str());
+  });
 }
 
-void ProguardMap::parse_full_map(std::istream& fp) {
-  std::string line;
-  fp.seekg(0);
-  assert_log(!fp.fail(),
-             "Can't use the full rename map with non-seekable stream");
-  while (std::getline(fp, line)) {
+void ProguardMap::parse_full_map(std::string_view contents) {
+  for_each_line(contents, [&](std::string_view line) {
     if (parse_class_full_format(line)) {
-      continue;
+      return;
     }
     if (parse_field_full_format(line)) {
-      continue;
+      return;
     }
     if (parse_method_full_format(line)) {
-      continue;
+      return;
     }
     if (comment(line)) {
-      continue;
+      return;
     }
     not_reached_log("Bogus line encountered in the full map: %s\n",
-                    line.c_str());
-  }
+                    std::string(line).c_str());
+  });
 }
 
-bool ProguardMap::parse_class_full_format(const std::string& line) {
-  std::string old_class_name;
-  std::string new_class_name;
-  auto p = line.c_str();
+bool ProguardMap::parse_class_full_format(std::string_view line) {
+  std::string_view old_class_name;
+  std::string_view new_class_name;
+  auto p = line.data();
   if (!literal(p, "type ")) return false;
   if (!id(p, old_class_name)) return false;
   if (!literal(p, " -> ")) return false;
   if (!id(p, new_class_name)) return false;
 
-  m_currClass = old_class_name;
-  m_currNewClass = new_class_name;
-  m_classMap[m_currClass] = m_currNewClass;
-  m_obfClassMap[m_currNewClass] = m_currClass;
+  m_currClass = std::string(old_class_name);
+  m_currNewClass = std::string(new_class_name);
+  auto pgold = store(old_class_name);
+  auto pgnew = store(new_class_name);
+  m_classMap[pgold] = pgnew;
+  m_obfClassMap[pgnew] = pgold;
   return true;
 }
 
-bool ProguardMap::parse_field_full_format(const std::string& line) {
-  std::string old_field_name;
-  std::string new_field_name;
+bool ProguardMap::parse_field_full_format(std::string_view line) {
+  std::string_view old_field_name;
+  std::string_view new_field_name;
 
-  auto p = line.c_str();
+  auto p = line.data();
   if (!literal(p, "ifield ")) {
     // Reset the field pointer.
-    p = line.c_str();
+    p = line.data();
     if (!literal(p, "sfield ")) {
       return false;
     }
@@ -374,21 +477,21 @@ bool ProguardMap::parse_field_full_format(const std::string& line) {
     return false;
   }
 
-  auto pgnew = new_field_name;
-  auto pgold = old_field_name;
+  auto pgnew = store(new_field_name);
+  auto pgold = store(old_field_name);
 
   m_fieldMap[pgold] = pgnew;
   m_obfFieldMap[pgnew] = pgold;
   return true;
 }
 
-bool ProguardMap::parse_method_full_format(const std::string& line) {
-  std::string old_method_name;
-  std::string new_method_name;
-  auto p = line.c_str();
+bool ProguardMap::parse_method_full_format(std::string_view line) {
+  std::string_view old_method_name;
+  std::string_view new_method_name;
+  auto p = line.data();
   if (!literal(p, "dmethod ")) {
     // Reset the method pointer.
-    p = line.c_str();
+    p = line.data();
     if (!literal(p, "vmethod ")) {
       return false;
     }
@@ -404,33 +507,35 @@ bool ProguardMap::parse_method_full_format(const std::string& line) {
     return false;
   }
 
-  auto pgold = old_method_name;
-  auto pgnew = new_method_name;
+  auto pgold = store(old_method_name);
+  auto pgnew = store(new_method_name);
   m_methodMap[pgold] = pgnew;
   m_obfMethodMap[pgnew] = pgold;
   return true;
 }
 
-bool ProguardMap::parse_class(const std::string& line) {
-  std::string classname;
-  std::string newname;
-  auto p = line.c_str();
+bool ProguardMap::parse_class(std::string_view line) {
+  std::string_view classname;
+  std::string_view newname;
+  auto p = line.data();
   if (!id(p, classname)) return false;
   if (!literal(p, " -> ")) return false;
   if (!id(p, newname)) return false;
-  m_currClass = convert_type(classname);
-  m_currNewClass = convert_type(newname);
-  m_classMap[m_currClass] = m_currNewClass;
-  m_obfClassMap[m_currNewClass] = m_currClass;
+  m_currClass = convert_type(std::string(classname));
+  m_currNewClass = convert_type(std::string(newname));
+  auto pgold = store(m_currClass);
+  auto pgnew = store(m_currNewClass);
+  m_classMap[pgold] = pgnew;
+  m_obfClassMap[pgnew] = pgold;
   return true;
 }
 
-bool ProguardMap::parse_field(const std::string& line) {
-  std::string type;
-  std::string fieldname;
-  std::string newname;
+bool ProguardMap::parse_field(std::string_view line) {
+  std::string_view type;
+  std::string_view fieldname;
+  std::string_view newname;
 
-  auto p = line.c_str();
+  auto p = line.data();
   whitespace(p);
   if (!id(p, type)) return false;
   whitespace(p);
@@ -438,17 +543,17 @@ bool ProguardMap::parse_field(const std::string& line) {
   if (!literal(p, " -> ")) return false;
   if (!id(p, newname)) return false;
 
-  auto ctype = convert_type(type);
+  auto ctype = convert_type(std::string(type));
   auto xtype = translate_type(ctype, *this);
-  auto pgnew = convert_field(m_currNewClass, xtype, newname);
-  auto pgnew_notype = convert_field(m_currNewClass, "", newname);
-  auto pgold = convert_field(m_currClass, ctype, fieldname);
+  auto pgnew = store(convert_field(m_currNewClass, xtype, newname));
+  auto pgnew_notype = store(convert_field(m_currNewClass, "", newname));
+  auto pgold = store(convert_field(m_currClass, ctype, fieldname));
   // Record interfaces that are coalesced by Proguard.
   if (ctype[0] == 'L' && is_maybe_proguard_generated_member(fieldname)) {
     fprintf(stderr,
             "Type '%s' is touched by Proguard in '%s'\n",
             ctype.c_str(),
-            pgold.c_str());
+            std::string(pgold).c_str());
     m_pg_coalesced_interfaces.insert(ctype);
   }
   m_fieldMap[pgold] = pgnew;
@@ -457,15 +562,15 @@ bool ProguardMap::parse_field(const std::string& line) {
   return true;
 }
 
-bool ProguardMap::parse_method(const std::string& line) {
-  std::string type;
-  std::string methodname;
+bool ProguardMap::parse_method(std::string_view line) {
+  std::string_view type;
+  std::string_view methodname;
   std::string classname = m_currClass;
   std::string old_args;
   std::string new_args;
-  std::string newname;
+  std::string_view newname;
   auto lines = std::make_unique<ProguardLineRange>();
-  auto p = line.c_str();
+  auto p = line.data();
   whitespace(p);
   lines->start = line_number(p);
   literal(p, ':');
@@ -480,10 +585,10 @@ bool ProguardMap::parse_method(const std::string& line) {
 
   if (!literal(p, '(')) return false;
   while (true) {
-    std::string arg;
+    std::string_view arg;
     if (literal(p, ')')) break;
     id(p, arg);
-    auto old_arg = convert_type(arg);
+    auto old_arg = convert_type(std::string(arg));
     auto new_arg = translate_type(old_arg, *this);
     old_args += old_arg;
     new_args += new_arg;
@@ -498,16 +603,20 @@ bool ProguardMap::parse_method(const std::string& line) {
 
   if (!id(p, newname)) return false;
 
-  auto old_rtype = convert_type(type);
+  auto old_rtype = convert_type(std::string(type));
   auto new_rtype = translate_type(old_rtype, *this);
-  auto pgold = convert_method(classname, old_rtype, methodname, old_args);
-  auto pgnew = convert_method(m_currNewClass, new_rtype, newname, new_args);
-  auto pgnew_no_rtype = convert_method(m_currNewClass, "", newname, new_args);
+  auto pgold =
+      store(convert_method(classname, old_rtype, methodname, old_args));
+  auto pgnew =
+      store(convert_method(m_currNewClass, new_rtype, newname, new_args));
+  auto pgnew_no_rtype =
+      store(convert_method(m_currNewClass, "", newname, new_args));
   m_methodMap[pgold] = pgnew;
   m_obfMethodMap[pgnew] = pgold;
   m_obfUntypedMethodMap[pgnew_no_rtype] = pgold;
-  lines->original_name = pgold;
-  m_obfMethodLinesMap[pg_impl::lines_key(pgnew)].push_back(std::move(lines));
+  lines->original_name = std::string(pgold);
+  m_obfMethodLinesMap[store(pg_impl::lines_key(std::string(pgnew)))]
+      .push_back(std::move(lines));
   return true;
 }
 
@@ -532,7 +641,8 @@ DexString* file_name_from_method_string(const DexString* method) {
   } else {
     start = 1; // Skip over the "L"
   }
-  return DexString::make_string(s.substr(start, end - start) + ".java");
+  return DexString::make_string(std::string(s.substr(start, end - start)) +
+                                ".java");
 }
 
 static void apply_deobfuscated_positions(DexMethod* method,
@@ -588,7 +698,7 @@ std::string lines_key(const std::string& method_name) {
 void apply_deobfuscated_names(const std::vector<DexClasses>& dexen,
                               const ProguardMap& pm) {
   std::function<void(DexClass*)> worker_empty_pg_map = [&](DexClass* cls) {
-    cls->set_deobfuscated_name(show(cls));
+    cls->set_deobfuscated_name(cls->get_name());
     for (const auto& m : cls->get_dmethods()) {
       m->set_deobfuscated_name(show(m));
     }
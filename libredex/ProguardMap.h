@@ -9,13 +9,18 @@
 
 #include <cstddef>
 #include <fstream>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "DexClass.h"
 #include "ProguardLineRange.h"
 
+struct RedexMappedFile;
+
 /**
  * ProguardMap parses ProGuard's mapping.txt file that maps de-obfuscated class
  * and member names to obfuscated names.  This facility is useful if you have
@@ -37,15 +42,20 @@
  * For classes, this is the full descriptor.
  * For methods, it's <class descriptor>.<name>(<args descs>)<return desc> .
  * For fields,  it's <class descriptor>.<name>:<type desc> .
+ *
+ * Names are kept as views: into the mapped file where a name appears in it
+ * verbatim (as in the full rename map), and otherwise into an interning pool
+ * owned by the map, so that every distinct name is only stored once.
  */
 struct ProguardMap {
   /**
    * Construct an empty ProGuard map.
    */
-  explicit ProguardMap() = default;
+  ProguardMap();
 
   /**
-   * Construct map from the given file.
+   * Construct map from the given file, which is mapped into memory for the
+   * lifetime of the map.
    */
   explicit ProguardMap(const std::string& filename,
                        bool use_new_rename_map = false);
@@ -53,7 +63,12 @@ struct ProguardMap {
   /**
    * Construct map from a given stream.
    */
-  explicit ProguardMap(std::istream& is) { parse_proguard_map(is); }
+  explicit ProguardMap(std::istream& is);
+
+  ~ProguardMap();
+
+  ProguardMap(ProguardMap&&);
+  ProguardMap& operator=(ProguardMap&&);
 
   /**
    * Translate un-obfuscated class name to obfuscated name.
@@ -85,6 +100,18 @@ struct ProguardMap {
    */
   std::string deobfuscate_method(const std::string& method) const;
 
+  /**
+   * Allocation-free variants of the functions above. They return a view of
+   * the translated name, which is valid for the lifetime of the map, or the
+   * given name itself if it is not mapped.
+   */
+  std::string_view translate_class_view(std::string_view cls) const;
+  std::string_view translate_field_view(std::string_view field) const;
+  std::string_view translate_method_view(std::string_view method) const;
+  std::string_view deobfuscate_class_view(std::string_view cls) const;
+  std::string_view deobfuscate_field_view(std::string_view field) const;
+  std::string_view deobfuscate_method_view(std::string_view method) const;
+
   struct Frame {
     DexString* method;
     uint32_t line;
@@ -112,43 +139,64 @@ struct ProguardMap {
   }
 
  private:
-  void parse_proguard_map(std::istream& fp);
-  void parse_full_map(std::istream& fp);
+  using NameMap = std::unordered_map<std::string_view, std::string_view>;
 
-  bool parse_class(const std::string& line);
-  bool parse_field(const std::string& line);
-  bool parse_method(const std::string& line);
+  void parse_proguard_map(std::string_view contents);
+  void parse_full_map(std::string_view contents);
 
-  bool parse_class_full_format(const std::string& line);
-  bool parse_field_full_format(const std::string& line);
-  bool parse_method_full_format(const std::string& line);
+  bool parse_class(std::string_view line);
+  bool parse_field(std::string_view line);
+  bool parse_method(std::string_view line);
+
+  bool parse_class_full_format(std::string_view line);
+  bool parse_field_full_format(std::string_view line);
+  bool parse_method_full_format(std::string_view line);
+
+  /**
+   * Returns a view of the given name that is valid for the lifetime of the
+   * map: the name itself if it points into the mapped file, and an interned
+   * copy otherwise.
+   */
+  std::string_view store(std::string_view name);
 
  private:
   // Unobfuscated to obfuscated maps
-  std::unordered_map<std::string, std::string> m_classMap;
-  std::unordered_map<std::string, std::string> m_fieldMap;
-  std::unordered_map<std::string, std::string> m_methodMap;
+  NameMap m_classMap;
+  NameMap m_fieldMap;
+  NameMap m_methodMap;
 
   // Obfuscated to unobfuscated maps from proguard
-  std::unordered_map<std::string, std::string> m_obfClassMap;
-  std::unordered_map<std::string, std::string> m_obfFieldMap;
-  std::unordered_map<std::string, std::string> m_obfMethodMap;
+  NameMap m_obfClassMap;
+  NameMap m_obfFieldMap;
+  NameMap m_obfMethodMap;
 
   // Field map for reflection analysis when type is unknown
   // Stores Lcom/facebook/Class;.field -> original name without class name
-  std::unordered_map<std::string, std::string> m_obfUntypedFieldMap;
+  NameMap m_obfUntypedFieldMap;
 
   // Method map for reflection analysis when return type is unknown
   // Stores Lcom/facebook/Class;.method(II) -> original name without class name
-  std::unordered_map<std::string, std::string> m_obfUntypedMethodMap;
+  NameMap m_obfUntypedMethodMap;
 
-  std::unordered_map<std::string, ProguardLineRangeVector> m_obfMethodLinesMap;
+  std::unordered_map<std::string_view, ProguardLineRangeVector>
+      m_obfMethodLinesMap;
 
   // Interfaces that are (most likely) coalesced by Proguard.
   std::unordered_set<std::string> m_pg_coalesced_interfaces;
 
   std::string m_currClass;
   std::string m_currNewClass;
+
+  // The file the map was parsed from, if any.
+  std::unique_ptr<RedexMappedFile> m_mapped_file;
+  std::string_view m_mapped_contents;
+
+  // Interned names that do not appear verbatim in the mapped file, stored
+  // back to back in large blocks.
+  std::unordered_set<std::string_view> m_pool;
+  std::vector<std::unique_ptr<char[]>> m_pool_blocks;
+  char* m_pool_next{nullptr};
+  size_t m_pool_left{0};
 };
 
 /**
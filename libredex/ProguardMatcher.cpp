@@ -42,19 +42,54 @@ std::unique_ptr<boost::regex> make_rx(const std::string& s,
   return std::make_unique<boost::regex>(rx);
 }
 
-std::string get_deobfuscated_name(const DexType* type) {
+/**
+ * Matches class names against a ProGuard type regex. Plain wildcard patterns,
+ * which are the vast majority for class names, are matched directly; anything
+ * else goes through boost::regex.
+ */
+class TypeNameMatcher {
+ public:
+  explicit TypeNameMatcher(const std::string& s) {
+    if (s.empty()) return;
+    auto wc = proguard_parser::convert_wildcard_type(s);
+    m_wildcard = proguard_parser::TypeWildcardMatcher::compile(wc);
+    if (!m_wildcard) {
+      m_rx = std::make_unique<boost::regex>(
+          proguard_parser::form_type_regex(wc));
+    }
+  }
+
+  bool empty() const { return !m_wildcard && !m_rx; }
+
+  bool match(std::string_view name) const {
+    if (m_wildcard) {
+      return m_wildcard->match(name);
+    }
+    return boost::regex_match(name.begin(), name.end(), *m_rx);
+  }
+
+ private:
+  boost::optional<proguard_parser::TypeWildcardMatcher> m_wildcard;
+  std::unique_ptr<boost::regex> m_rx;
+};
+
+std::string_view get_deobfuscated_name(const DexType* type) {
   auto cls = type_class(type);
   if (cls == nullptr) {
-    return type->c_str();
+    return type->get_name()->str();
   }
   return cls->get_deobfuscated_name();
 }
 
+bool regex_match(std::string_view s, const boost::regex& rx) {
+  return boost::regex_match(s.begin(), s.end(), rx);
+}
+
 bool match_annotation_rx(const DexClass* cls, const boost::regex& annorx) {
   const auto* annos = cls->get_anno_set();
   if (!annos) return false;
   for (const auto& anno : annos->get_annotations()) {
-    if (boost::regex_match(get_deobfuscated_name(anno->type()), annorx)) {
+    if (regex_match(get_deobfuscated_name(anno->type()), annorx)) {
       return true;
     }
   }
@@ -70,9 +105,9 @@ struct ClassMatcher {
       : setFlags_(ks.class_spec.setAccessFlags),
         unsetFlags_(ks.class_spec.unsetAccessFlags),
         m_class_name(ks.class_spec.className),
-        m_cls(make_rx(ks.class_spec.className)),
+        m_cls(ks.class_spec.className),
         m_anno(make_rx(ks.class_spec.annotationType, false)),
-        m_extends(make_rx(ks.class_spec.extendsClassName)),
+        m_extends(ks.class_spec.extendsClassName),
         m_extends_anno(make_rx(ks.class_spec.extendsAnnotationType, false)) {}
 
   bool match(const DexClass* cls) {
@@ -96,8 +131,7 @@ struct ClassMatcher {
 
  private:
   bool match_name(const DexClass* cls) const {
-    const auto& deob_name = cls->get_deobfuscated_name();
-    return boost::regex_match(deob_name, *m_cls);
+    return m_cls.match(cls->get_deobfuscated_name());
   }
 
   bool match_access(const DexClass* cls) const {
@@ -110,7 +144,7 @@ struct ClassMatcher {
   }
 
   bool match_extends(const DexClass* cls) {
-    if (!m_extends) return true;
+    if (m_extends.empty()) return true;
     return search_extends_and_interfaces(cls);
   }
 
@@ -123,8 +157,7 @@ struct ClassMatcher {
         return false;
       }
     }
-    const auto& deob_name = cls->get_deobfuscated_name();
-    return boost::regex_match(deob_name, *m_extends);
+    return m_extends.match(cls->get_deobfuscated_name());
   }
 
   bool search_interfaces(const DexClass* cls) {
@@ -172,9 +205,9 @@ struct ClassMatcher {
   DexAccessFlags setFlags_;
   DexAccessFlags unsetFlags_;
   std::string m_class_name;
-  std::unique_ptr<boost::regex> m_cls;
+  TypeNameMatcher m_cls;
   std::unique_ptr<boost::regex> m_anno;
-  std::unique_ptr<boost::regex> m_extends;
+  TypeNameMatcher m_extends;
   std::unique_ptr<boost::regex> m_extends_anno;
 
   std::unordered_map<const DexClass*, bool> m_extends_result_cache;
@@ -335,6 +368,8 @@ class ProguardMatcher {
     // may, for instance, forbid renaming of all classes that inherit from a
     // given external class.
     build_extends_or_implements_hierarchy(m_external_classes, &m_hierarchy);
+    build_name_index(m_classes, &m_class_index);
+    build_name_index(m_external_classes, &m_external_class_index);
   }
 
   void process_proguard_rules(const ProguardConfiguration& pg_config);
@@ -346,6 +381,10 @@ class ProguardMatcher {
 
   DexClass* find_single_class(const std::string& descriptor) const;
 
+  // Classes sorted by deobfuscated name, so that a rule only needs to look at
+  // the classes that start with the literal prefix of its class name.
+  using NameIndex = std::vector<std::pair<std::string_view, DexClass*>>;
+
   const ConcurrentSet<const KeepSpec*>& get_unused_rules() const {
     return m_unused_rules;
   }
@@ -355,7 +394,31 @@ class ProguardMatcher {
   const Scope& m_classes;
   const Scope& m_external_classes;
   ClassHierarchy m_hierarchy;
+  NameIndex m_class_index;
+  NameIndex m_external_class_index;
   ConcurrentSet<const KeepSpec*> m_unused_rules;
+
+  static void build_name_index(const Scope& classes, NameIndex* index) {
+    index->reserve(classes.size());
+    for (auto* cls : classes) {
+      index->emplace_back(cls->get_deobfuscated_name(), cls);
+    }
+    std::sort(index->begin(), index->end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+  }
+
+  template <typename Fn>
+  static void for_each_with_prefix(const NameIndex& index,
+                                   const std::string& prefix,
+                                   const Fn& fn) {
+    auto it = std::lower_bound(
+        index.begin(), index.end(), prefix,
+        [](const auto& entry, const std::string& p) { return entry.first < p; });
+    for (; it != index.end() && it->first.substr(0, prefix.size()) == prefix;
+         ++it) {
+      fn(it->second);
+    }
+  }
 };
 
 template <class DexMember>
@@ -441,8 +504,8 @@ bool KeepRuleMatcher::has_annotation(const DexMember* member,
     auto annotation_regex = proguard_parser::form_type_regex(annotation);
     const boost::regex& annotation_matcher = register_matcher(annotation_regex);
     for (const auto& anno : annos->get_annotations()) {
-      if (boost::regex_match(get_deobfuscated_name(anno->type()),
-                             annotation_matcher)) {
+      if (regex_match(get_deobfuscated_name(anno->type()),
+                      annotation_matcher)) {
         return true;
       }
     }
@@ -452,16 +515,16 @@ bool KeepRuleMatcher::has_annotation(const DexMember* member,
 
 // From a fully qualified descriptor for a field, exract just the
 // name of the field which occurs between the ;. and : characters.
-std::string extract_field_name(std::string qualified_fieldname) {
+std::string_view extract_field_name(std::string_view qualified_fieldname) {
   auto p = qualified_fieldname.find(";.");
-  if (p == std::string::npos) {
+  if (p == std::string_view::npos) {
     return qualified_fieldname;
   }
   return qualified_fieldname.substr(p + 2);
 }
 
-std::string extract_method_name_and_type(
-    const std::string& qualified_fieldname) {
+std::string_view extract_method_name_and_type(
+    std::string_view qualified_fieldname) {
   auto p = qualified_fieldname.find(";.");
   return qualified_fieldname.substr(p + 2);
 }
@@ -484,7 +547,7 @@ bool KeepRuleMatcher::field_level_match(
   }
   // Match field name against regex.
   auto dequalified_name = extract_field_name(field->get_deobfuscated_name());
-  return boost::regex_match(dequalified_name, fieldname_regex);
+  return regex_match(dequalified_name, fieldname_regex);
 }
 
 template <class Container>
@@ -539,7 +602,7 @@ bool KeepRuleMatcher::method_level_match(
   }
   auto dequalified_name =
       extract_method_name_and_type(method->get_deobfuscated_name());
-  return boost::regex_match(dequalified_name.c_str(), method_regex);
+  return regex_match(dequalified_name, method_regex);
 }
 
 template <class Container>
@@ -807,13 +870,17 @@ void ProguardMatcher::process_keep(const KeepSpecSet& keep_rules,
     ClassMatcher class_match(*keep_rule);
     KeepRuleMatcher rule_matcher(rule_type, *keep_rule, regex_map);
 
-    for (const auto& cls : m_classes) {
+    // Every matching class starts with the literal prefix of the rule's class
+    // name, so only the corresponding range of the name index is scanned.
+    const auto prefix = proguard_parser::literal_type_prefix(
+        proguard_parser::convert_wildcard_type(
+            keep_rule->class_spec.className));
+    auto process = [&](DexClass* cls) {
       process_single_keep(class_match, rule_matcher, cls);
-    }
+    };
+    for_each_with_prefix(m_class_index, prefix, process);
     if (process_external) {
-      for (const auto& cls : m_external_classes) {
-        process_single_keep(class_match, rule_matcher, cls);
-      }
+      for_each_with_prefix(m_external_class_index, prefix, process);
     }
 
     if (rule_matcher.is_unused()) {
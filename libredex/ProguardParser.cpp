@@ -7,6 +7,8 @@
 
 #include <fstream>
 #include <iostream>
+#include <iterator>
+#include <numeric>
 #include <vector>
 
 #include "Macros.h"
@@ -15,6 +17,7 @@
 #include "ProguardParser.h"
 #include "ProguardRegex.h"
 #include "ReadMaybeMapped.h"
+#include "WorkQueue.h"
 
 namespace keep_rules {
 namespace proguard_parser {
@@ -1038,6 +1041,64 @@ void parse(const boost::string_view& config,
   }
 }
 
+void append(std::vector<std::string>&& from, std::vector<std::string>* into) {
+  into->insert(into->end(),
+               std::make_move_iterator(from.begin()),
+               std::make_move_iterator(from.end()));
+}
+
+// Merges the configuration parsed from a file into the one parsed from the
+// files before it, with the same result as parsing into it directly.
+void append(ProguardConfiguration&& from, ProguardConfiguration* into) {
+  into->ok = from.ok;
+  append(std::move(from.includes), &into->includes);
+  if (!from.basedirectory.empty()) {
+    into->basedirectory = std::move(from.basedirectory);
+  }
+  append(std::move(from.injars), &into->injars);
+  append(std::move(from.outjars), &into->outjars);
+  append(std::move(from.libraryjars), &into->libraryjars);
+  append(std::move(from.printmapping), &into->printmapping);
+  append(std::move(from.printconfiguration), &into->printconfiguration);
+  append(std::move(from.printseeds), &into->printseeds);
+  append(std::move(from.printusage), &into->printusage);
+  append(std::move(from.keepdirectories), &into->keepdirectories);
+  // Options only ever flip these away from their defaults.
+  into->shrink = into->shrink && from.shrink;
+  into->optimize = into->optimize && from.optimize;
+  into->allowaccessmodification =
+      into->allowaccessmodification || from.allowaccessmodification;
+  into->dontobfuscate = into->dontobfuscate || from.dontobfuscate;
+  into->dontusemixedcaseclassnames =
+      into->dontusemixedcaseclassnames || from.dontusemixedcaseclassnames;
+  into->dontpreverify = into->dontpreverify || from.dontpreverify;
+  into->verbose = into->verbose || from.verbose;
+  if (!from.target_version.empty()) {
+    into->target_version = std::move(from.target_version);
+  }
+  into->keep_rules.append(std::move(from.keep_rules));
+  into->assumenosideeffects_rules.append(
+      std::move(from.assumenosideeffects_rules));
+  into->whyareyoukeeping_rules.append(std::move(from.whyareyoukeeping_rules));
+  append(std::move(from.optimization_filters), &into->optimization_filters);
+  append(std::move(from.keepattributes), &into->keepattributes);
+  append(std::move(from.dontwarn), &into->dontwarn);
+  append(std::move(from.keeppackagenames), &into->keeppackagenames);
+}
+
+void parse_includes(ProguardConfiguration* pg_config) {
+  // Included files may include more files, so don't hold on to iterators.
+  for (size_t i = 0; i < pg_config->includes.size(); ++i) {
+    auto included_filename = pg_config->includes[i];
+    if (pg_config->already_included.find(included_filename) !=
+        pg_config->already_included.end()) {
+      continue;
+    }
+    pg_config->already_included.emplace(included_filename);
+    parse_file(included_filename, pg_config);
+  }
+}
+
 } // namespace
 
 void parse(std::istream& config,
@@ -1052,18 +1113,29 @@ void parse_file(const std::string& filename, ProguardConfiguration* pg_config) {
   redex::read_file_with_contents(filename, [&](const char* data, size_t s) {
     boost::string_view view(data, s);
     parse(view, pg_config, filename);
-    // Parse the included files.
-    for (const auto& included_filename : pg_config->includes) {
-      if (pg_config->already_included.find(included_filename) !=
-          pg_config->already_included.end()) {
-        continue;
-      }
-      pg_config->already_included.emplace(included_filename);
-      parse_file(included_filename, pg_config);
-    }
+    parse_includes(pg_config);
   });
 }
 
+void parse_files(const std::vector<std::string>& filenames,
+                 ProguardConfiguration* pg_config) {
+  std::vector<ProguardConfiguration> parsed(filenames.size());
+  std::vector<size_t> indices(filenames.size());
+  std::iota(indices.begin(), indices.end(), 0);
+  workqueue_run<size_t>(
+      [&](size_t i) {
+        redex::read_file_with_contents(
+            filenames[i], [&](const char* data, size_t s) {
+              parse(boost::string_view(data, s), &parsed[i], filenames[i]);
+            });
+      },
+      indices);
+  for (auto& config : parsed) {
+    append(std::move(config), pg_config);
+    parse_includes(pg_config);
+  }
+}
+
 void remove_blocklisted_rules(ProguardConfiguration* pg_config) {
   // TODO: Make the set of excluded rules configurable.
   auto blocklisted_rules = R"(
@@ -9,6 +9,7 @@
 
 #include <iosfwd>
 #include <string>
+#include <vector>
 
 #include "ProguardConfiguration.h"
 
@@ -16,6 +17,15 @@ namespace keep_rules {
 namespace proguard_parser {
 
 void parse_file(const std::string& filename, ProguardConfiguration* pg_config);
+
+/*
+ * Same as calling parse_file on each of the files in order, but the files are
+ * lexed and parsed concurrently. Their included files are parsed afterwards,
+ * in order.
+ */
+void parse_files(const std::vector<std::string>& filenames,
+                 ProguardConfiguration* pg_config);
+
 void parse(std::istream& config,
            ProguardConfiguration* pg_config,
            const std::string& filename = "");
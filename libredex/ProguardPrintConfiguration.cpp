@@ -9,8 +9,11 @@
 #include "ProguardReporting.h"
 
 #include <iostream>
+#include <numeric>
 #include <sstream>
 
+#include "WorkQueue.h"
+
 std::string show_keep_style(const keep_rules::KeepSpec& keep_rule) {
   if (keep_rule.mark_classes && !keep_rule.mark_conditionally &&
       !keep_rule.allowshrinking) {
@@ -194,12 +197,14 @@ void keep_rules::show_configuration(
     std::ostream& output,
     const Scope& classes,
     const keep_rules::ProguardConfiguration& config) {
-  size_t total = classes.size();
-  for (const auto& cls : classes) {
-    total += cls->get_vmethods().size() + cls->get_dmethods().size() +
-             cls->get_ifields().size() + cls->get_sfields().size();
-  }
-  for (const auto& keep : config.keep_rules) {
-    output << keep_rules::show_keep(*keep) << std::endl;
+  const auto& keeps = config.keep_rules.elements();
+  std::vector<std::string> shown(keeps.size());
+  std::vector<size_t> indices(keeps.size());
+  std::iota(indices.begin(), indices.end(), 0);
+  workqueue_run<size_t>(
+      [&](size_t i) { shown[i] = keep_rules::show_keep(*keeps[i]); },
+      indices);
+  for (const auto& keep : shown) {
+    output << keep << '\n';
   }
 }
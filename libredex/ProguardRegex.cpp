@@ -132,6 +132,128 @@ std::string form_type_regex(const std::string& proguard_regex) {
   return r;
 }
 
+namespace {
+
+// Characters that form_type_regex doesn't turn into literals.
+bool is_type_regex_special(char ch) {
+  switch (ch) {
+  case '%':
+  case '?':
+  case '*':
+  case '.':
+  case '|':
+  case '+':
+  case '{':
+  case '}':
+  case '^':
+  case '\\':
+    return true;
+  default:
+    return false;
+  }
+}
+
+} // namespace
+
+std::string literal_type_prefix(const std::string& proguard_regex) {
+  const std::string& regex =
+      proguard_regex == "L*;" ? L_STAR_REGEX : proguard_regex;
+  size_t end = 0;
+  while (end < regex.size() && !is_type_regex_special(regex[end])) {
+    end++;
+  }
+  return regex.substr(0, end);
+}
+
+boost::optional<TypeWildcardMatcher> TypeWildcardMatcher::compile(
+    const std::string& proguard_regex) {
+  if (proguard_regex.empty()) {
+    return boost::none;
+  }
+  const std::string& regex =
+      proguard_regex == "L*;" ? L_STAR_REGEX : proguard_regex;
+  TypeWildcardMatcher matcher;
+  auto& tokens = matcher.m_tokens;
+  for (size_t i = 0; i < regex.size(); i++) {
+    const char ch = regex[i];
+    if (ch == '?') {
+      tokens.push_back({TokenKind::ONE, ""});
+      continue;
+    }
+    if (ch == '*') {
+      if (i + 1 < regex.size() && regex[i + 1] == '*') {
+        if (i + 2 < regex.size() && regex[i + 2] == '*') {
+          // ***: any type, including primitives and arrays.
+          return boost::none;
+        }
+        tokens.push_back({TokenKind::DOUBLE_STAR, ""});
+        i++;
+        continue;
+      }
+      tokens.push_back({TokenKind::STAR, ""});
+      continue;
+    }
+    if (is_type_regex_special(ch)) {
+      return boost::none;
+    }
+    if (tokens.empty() || tokens.back().kind != TokenKind::LITERAL) {
+      tokens.push_back({TokenKind::LITERAL, ""});
+    }
+    tokens.back().literal += ch;
+  }
+  return matcher;
+}
+
+bool TypeWildcardMatcher::match(std::string_view type) const {
+  // reachable[i] denotes whether the tokens so far can match type[0, i).
+  const size_t n = type.size();
+  std::vector<char> reachable(n + 1, false);
+  std::vector<char> next(n + 1);
+  reachable[0] = true;
+  for (const auto& token : m_tokens) {
+    std::fill(next.begin(), next.end(), false);
+    bool any = false;
+    switch (token.kind) {
+    case TokenKind::LITERAL: {
+      size_t len = token.literal.size();
+      for (size_t i = 0; i + len <= n; i++) {
+        if (reachable[i] && type.compare(i, len, token.literal) == 0) {
+          next[i + len] = any = true;
+        }
+      }
+      break;
+    }
+    case TokenKind::ONE:
+      for (size_t i = 0; i < n; i++) {
+        if (reachable[i] && type[i] != '/' && type[i] != '[') {
+          next[i + 1] = any = true;
+        }
+      }
+      break;
+    case TokenKind::STAR:
+    case TokenKind::DOUBLE_STAR: {
+      bool stop_at_slash = token.kind == TokenKind::STAR;
+      bool reach = false;
+      for (size_t i = 0; i <= n; i++) {
+        if (i > 0 && reach) {
+          char ch = type[i - 1];
+          reach = ch != '[' && !(stop_at_slash && ch == '/');
+        }
+        reach = reach || reachable[i];
+        next[i] = reach;
+        any = any || reach;
+      }
+      break;
+    }
+    }
+    if (!any) {
+      return false;
+    }
+    reachable.swap(next);
+  }
+  return reachable[n];
+}
+
 // Return true if `proguard_regex` has any characters in it that would require
 // the use of regex. Return false if simple string equality would work
 bool has_special_char(const std::string& proguard_regex) {
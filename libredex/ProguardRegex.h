@@ -7,7 +7,10 @@
 
 #pragma once
 
+#include <boost/optional.hpp>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace keep_rules {
 namespace proguard_parser {
@@ -17,5 +20,41 @@ std::string form_type_regex(const std::string& proguard_regex);
 bool has_special_char(const std::string& proguard_regex);
 std::string convert_wildcard_type(const std::string& typ);
 
+// The literal text that every type matching the ProGuard type regex (as
+// accepted by form_type_regex) starts with.
+std::string literal_type_prefix(const std::string& proguard_regex);
+
+/*
+ * Matches types against a ProGuard type regex without going through
+ * boost::regex, with the same semantics as form_type_regex. Only literals,
+ * `*`, `**` and `?` are supported, which covers class names in keep rules;
+ * compile() returns none for anything else.
+ */
+class TypeWildcardMatcher {
+ public:
+  static boost::optional<TypeWildcardMatcher> compile(
+      const std::string& proguard_regex);
+
+  bool match(std::string_view type) const;
+
+ private:
+  enum class TokenKind {
+    LITERAL,
+    // `?`: any character but a package separator or an array prefix.
+    ONE,
+    // `*`: any sequence without package separators or array prefixes.
+    STAR,
+    // `**`: any sequence without array prefixes.
+    DOUBLE_STAR,
+  };
+
+  struct Token {
+    TokenKind kind;
+    std::string literal;
+  };
+
+  std::vector<Token> m_tokens;
+};
+
 } // namespace proguard_parser
 } // namespace keep_rules
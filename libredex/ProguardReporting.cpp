@@ -6,8 +6,13 @@
  */
 
 #include "ProguardReporting.h"
+
+#include <numeric>
+#include <sstream>
+
 #include "DexClass.h"
 #include "ReachableClasses.h"
+#include "WorkQueue.h"
 
 std::string extract_suffix(std::string class_name) {
   auto i = class_name.find_last_of('.');
@@ -58,10 +63,10 @@ std::string type_descriptor_to_java(const std::string& descriptor) {
   exit(2);
 }
 
-std::string extract_member_name(const std::string& qualified) {
+std::string extract_member_name(std::string_view qualified) {
   auto dot = qualified.find('.');
   auto colon = qualified.find(':');
-  return qualified.substr(dot + 1, colon - dot - 1);
+  return std::string(qualified.substr(dot + 1, colon - dot - 1));
 }
 
 // Convert a type descriptor that may contain obfuscated class names
@@ -95,7 +100,7 @@ std::string deobfuscate_type_descriptor(const ProguardMap& pg_map,
 }
 
 std::string form_java_args(const ProguardMap& pg_map,
-                           const std::deque<DexType*>& args) {
+                           const DexTypeList::ContainerType& args) {
   std::string s;
   unsigned long i = 0;
   for (const auto& arg : args) {
@@ -111,7 +116,7 @@ std::string form_java_args(const ProguardMap& pg_map,
 }
 
 std::string java_args(const ProguardMap& pg_map,
-                      const std::deque<DexType*>& args) {
+                      const DexTypeList::ContainerType& args) {
   std::string str = "(";
   str += form_java_args(pg_map, args);
   str += ")";
@@ -130,7 +135,7 @@ void redex::print_method(std::ostream& output,
     method_name = extract_suffix(class_name);
     is_constructor = true;
   } else {
-    const auto& deob = method->get_deobfuscated_name();
+    auto deob = method->get_deobfuscated_name();
     if (deob.empty()) {
       std::cerr << "WARNING: method has no deobfu: " << method_name
                 << std::endl;
@@ -203,9 +208,35 @@ void redex::print_class(std::ostream& output,
 void redex::print_classes(std::ostream& output,
                           const ProguardMap& pg_map,
                           const Scope& classes) {
-  for (const auto& cls : classes) {
-    if (!cls->is_external()) {
-      redex::print_class(output, pg_map, cls);
-    }
+  print_partitioned(
+      output, classes, [&](std::ostream& out, const DexClass* cls) {
+        if (!cls->is_external()) {
+          redex::print_class(out, pg_map, cls);
+        }
+      });
+}
+
+void redex::print_partitioned(
+    std::ostream& output,
+    const Scope& classes,
+    const std::function<void(std::ostream&, const DexClass*)>& print_class) {
+  constexpr size_t kClassesPerPartition = 256;
+  size_t num_partitions =
+      (classes.size() + kClassesPerPartition - 1) / kClassesPerPartition;
+  std::vector<std::string> buffers(num_partitions);
+  std::vector<size_t> indices(num_partitions);
+  std::iota(indices.begin(), indices.end(), 0);
+  workqueue_run<size_t>(
+      [&](size_t i) {
+        std::ostringstream out;
+        auto end = std::min(classes.size(), (i + 1) * kClassesPerPartition);
+        for (size_t j = i * kClassesPerPartition; j < end; ++j) {
+          print_class(out, classes[j]);
+        }
+        buffers[i] = out.str();
+      },
+      indices);
+  for (const auto& buffer : buffers) {
+    output << buffer;
   }
 }
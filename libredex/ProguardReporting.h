@@ -10,6 +10,7 @@
 #include "DexClass.h"
 #include "DexUtil.h"
 #include "ProguardMap.h"
+#include <functional>
 #include <iostream>
 
 namespace redex {
@@ -43,4 +44,15 @@ void print_class(std::ostream& output,
 void print_classes(std::ostream& output,
                    const ProguardMap& pg_map,
                    const Scope& classes);
+
+/*
+ * Calls `print_class` on each class, concurrently for partitions of
+ * consecutive classes, each printing into a buffer of its own. The buffers are
+ * written to `output` in order, so the output is the same as when printing
+ * sequentially.
+ */
+void print_partitioned(
+    std::ostream& output,
+    const Scope& classes,
+    const std::function<void(std::ostream&, const DexClass*)>& print_class);
 } // namespace redex
@@ -8,13 +8,18 @@
 #pragma once
 
 #include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <functional>
+#include <limits>
 #include <memory>
 #include <sstream>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include <boost/container/small_vector.hpp>
+
 #include "Debug.h"
 #include "S_Expression.h"
 #include "Trace.h"
@@ -151,6 +156,9 @@ class Forest {
     std::transform(m_trees.begin(), m_trees.end(),
                    std::back_inserter(ret.m_trees),
                    [](const auto& tree) { return tree->clone(); });
+    ret.m_nodes = m_nodes;
+    ret.m_roots = m_roots;
+    ret.m_features = m_features;
     return ret;
   }
 
@@ -181,15 +189,28 @@ class Forest {
       TRACE(METH_PROF, 5, "Parsing tree %zu", i);
       ret.m_trees.emplace_back(deserialize_tree(trees_expr[i], feature_fns));
     }
+    ret.compile();
     return ret;
   }
 
   size_t size() const { return m_trees.size(); }
 
   bool accept(Args... args, size_t* c = nullptr) const {
+    // Trees tend to test the same features, so evaluate each one at most once.
+    // NaN marks features that haven't been evaluated yet.
+    boost::container::small_vector<float, 16> values(
+        m_features.size(), std::numeric_limits<float>::quiet_NaN());
     size_t acc_count{0};
-    for (const auto& dec_tree : m_trees) {
-      if (dec_tree->accept(args...)) {
+    for (uint32_t idx : m_roots) {
+      while (m_nodes[idx].feature != LEAF) {
+        const auto& node = m_nodes[idx];
+        float& value = values[node.feature];
+        if (std::isnan(value)) {
+          value = m_features[node.feature](args...);
+        }
+        idx = value <= node.threshold ? idx + 1 : node.false_branch;
+      }
+      if (m_nodes[idx].acc) {
         ++acc_count;
       }
     }
@@ -213,7 +234,55 @@ class Forest {
   }
 
  private:
+  // Flattens the trees into m_nodes, laid out in pre-order so that the true
+  // branch of a feature node immediately follows it, and gathers the distinct
+  // features into m_features.
+  void compile() {
+    std::unordered_map<std::string, uint32_t> feature_indices;
+    std::function<void(const DecisionTreeNode*)> flatten =
+        [&](const DecisionTreeNode* node) {
+          if (auto cat = dynamic_cast<const DecisionTreeCategory*>(node)) {
+            m_nodes.push_back(FlatNode{LEAF, 0, 0, cat->acc});
+            return;
+          }
+          auto feat = dynamic_cast<const DecisionTreeFeature*>(node);
+          always_assert(feat != nullptr);
+          auto it = feature_indices.find(feat->feature_name);
+          if (it == feature_indices.end()) {
+            it = feature_indices
+                     .emplace(feat->feature_name, m_features.size())
+                     .first;
+            m_features.push_back(feat->feature_fn);
+          }
+          size_t idx = m_nodes.size();
+          m_nodes.push_back(FlatNode{it->second, feat->threshold, 0, false});
+          flatten(feat->true_branch.get());
+          m_nodes[idx].false_branch = m_nodes.size();
+          flatten(feat->false_branch.get());
+        };
+    for (const auto& tree : m_trees) {
+      m_roots.push_back(m_nodes.size());
+      flatten(tree.get());
+    }
+  }
+
+  static constexpr uint32_t LEAF = std::numeric_limits<uint32_t>::max();
+
+  struct FlatNode {
+    // Index into m_features, or LEAF.
+    uint32_t feature;
+    float threshold;
+    uint32_t false_branch;
+    // Only meaningful for leaves.
+    bool acc;
+  };
+
+  // The trees as parsed, kept for dumping.
   std::vector<std::unique_ptr<DecisionTreeNode>> m_trees;
+  // The trees compiled for evaluation.
+  std::vector<FlatNode> m_nodes;
+  std::vector<uint32_t> m_roots;
+  std::vector<typename DecisionTreeFeature::FeatureFn> m_features;
 };
 
 } // namespace random_forest
@@ -46,7 +46,7 @@ std::unique_ptr<ReachableObjects> setup_seeds_and_compute_reachable_objects(
     bool remove_no_argument_constructors) {
   Timer t("Marking");
   auto scope = build_class_scope(stores);
-  auto reachable_objects = std::make_unique<ReachableObjects>();
+  auto reachable_objects = std::make_unique<ReachableObjects>(scope);
   ConditionallyMarked cond_marked;
   auto method_override_graph = mog::build_graph(scope);
 
@@ -289,10 +289,9 @@ void TransitiveClosureMarker::push(const Parent* parent, const DexClass* cls) {
     return;
   }
   record_reachability(parent, cls);
-  if (m_reachable_objects->marked(cls)) {
+  if (!m_reachable_objects->mark(cls)) {
     return;
   }
-  m_reachable_objects->mark(cls);
   m_worker_state->push_task(ReachableObject(cls));
 }
 
@@ -303,14 +302,13 @@ void TransitiveClosureMarker::push(const Parent* parent,
     return;
   }
   record_reachability(parent, field);
-  if (m_reachable_objects->marked(field)) {
+  if (!m_reachable_objects->mark(field)) {
     return;
   }
   auto f = field->as_def();
   if (f) {
     gather_and_push(f);
   }
-  m_reachable_objects->mark(field);
   m_worker_state->push_task(ReachableObject(field));
 }
 
@@ -326,10 +324,9 @@ void TransitiveClosureMarker::push(const Parent* parent,
   }
 
   record_reachability(parent, method);
-  if (m_reachable_objects->marked(method)) {
+  if (!m_reachable_objects->mark(method)) {
     return;
   }
-  m_reachable_objects->mark(method);
   m_worker_state->push_task(ReachableObject(method));
 }
 
@@ -627,6 +624,36 @@ std::unique_ptr<ReachableObjects> compute_reachable_objects(
       remove_no_argument_constructors);
 }
 
+ReachableObjects::ReachableObjects(const Scope& scope) {
+  size_t num_fields = 0;
+  size_t num_methods = 0;
+  for (const auto* cls : scope) {
+    num_fields += cls->get_ifields().size() + cls->get_sfields().size();
+    num_methods += cls->get_dmethods().size() + cls->get_vmethods().size();
+  }
+  m_marked_classes.reserve(scope.size());
+  m_marked_fields.reserve(num_fields);
+  m_marked_methods.reserve(num_methods);
+  for (const auto* cls : scope) {
+    m_marked_classes.assign_id(cls);
+    for (const auto* f : cls->get_ifields()) {
+      m_marked_fields.assign_id(f);
+    }
+    for (const auto* f : cls->get_sfields()) {
+      m_marked_fields.assign_id(f);
+    }
+    for (const auto* m : cls->get_dmethods()) {
+      m_marked_methods.assign_id(m);
+    }
+    for (const auto* m : cls->get_vmethods()) {
+      m_marked_methods.assign_id(m);
+    }
+  }
+  m_marked_classes.allocate_bits();
+  m_marked_fields.allocate_bits();
+  m_marked_methods.allocate_bits();
+}
+
 void ReachableObjects::record_reachability(const DexMethodRef* member,
                                            const DexClass* cls) {
   // Each class member trivially retains its containing class; let's filter out
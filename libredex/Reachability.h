@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -90,15 +92,92 @@ using ReachableObjectSet =
 using ReachableObjectGraph =
     ConcurrentMap<ReachableObject, ReachableObjectSet, ReachableObjectHash>;
 
+/*
+ * A set of marked objects. Objects that were given a dense id up front are
+ * marked in an atomic bitset; all others, e.g. references to external members,
+ * go to a ConcurrentSet. Ids must all be assigned before anything is marked.
+ */
+template <class T>
+class MarkedSet {
+ public:
+  void reserve(size_t size) { m_ids.reserve(size); }
+
+  void assign_id(const T* obj) {
+    m_ids.emplace(obj, static_cast<uint32_t>(m_ids.size()));
+  }
+
+  void allocate_bits() {
+    m_num_words = (m_ids.size() + 63) / 64;
+    m_bits = std::make_unique<std::atomic<uint64_t>[]>(m_num_words);
+    for (size_t i = 0; i < m_num_words; ++i) {
+      m_bits[i].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  // Returns whether `obj` wasn't marked before.
+  bool insert(const T* obj) {
+    auto it = m_ids.find(obj);
+    if (it == m_ids.end()) {
+      return m_others.insert(obj);
+    }
+    auto bit = uint64_t(1) << (it->second % 64);
+    auto old = m_bits[it->second / 64].fetch_or(bit, std::memory_order_relaxed);
+    return !(old & bit);
+  }
+
+  bool count(const T* obj) const {
+    auto it = m_ids.find(obj);
+    if (it == m_ids.end()) {
+      return m_others.count(obj);
+    }
+    return m_bits[it->second / 64].load(std::memory_order_relaxed) &
+           (uint64_t(1) << (it->second % 64));
+  }
+
+  bool count_unsafe(const T* obj) const {
+    auto it = m_ids.find(obj);
+    if (it == m_ids.end()) {
+      return m_others.count_unsafe(obj);
+    }
+    return m_bits[it->second / 64].load(std::memory_order_relaxed) &
+           (uint64_t(1) << (it->second % 64));
+  }
+
+  size_t size() const {
+    size_t size = m_others.size();
+    for (size_t i = 0; i < m_num_words; ++i) {
+      size += __builtin_popcountll(m_bits[i].load(std::memory_order_relaxed));
+    }
+    return size;
+  }
+
+ private:
+  std::unordered_map<const T*, uint32_t> m_ids;
+  std::unique_ptr<std::atomic<uint64_t>[]> m_bits;
+  size_t m_num_words{0};
+  ConcurrentSet<const T*> m_others;
+};
+
 class ReachableObjects {
  public:
+  ReachableObjects() = default;
+
+  /*
+   * Assigns dense ids to the classes of `scope` and their members, so that
+   * marking them doesn't need to take locks or allocate.
+   */
+  explicit ReachableObjects(const Scope& scope);
+
   const ReachableObjectGraph& retainers_of() const { return m_retainers_of; }
 
-  void mark(const DexClass* cls) { m_marked_classes.insert(cls); }
+  // The mark() functions return whether the object wasn't marked before.
+  bool mark(const DexClass* cls) { return m_marked_classes.insert(cls); }
 
-  void mark(const DexMethodRef* method) { m_marked_methods.insert(method); }
+  bool mark(const DexMethodRef* method) {
+    return m_marked_methods.insert(method);
+  }
 
-  void mark(const DexFieldRef* field) { m_marked_fields.insert(field); }
+  bool mark(const DexFieldRef* field) { return m_marked_fields.insert(field); }
 
   bool marked(const DexClass* cls) const { return m_marked_classes.count(cls); }
 
@@ -142,9 +221,9 @@ class ReachableObjects {
 
   void record_reachability(const DexMethodRef* member, const DexClass* cls);
 
-  ConcurrentSet<const DexClass*> m_marked_classes;
-  ConcurrentSet<const DexFieldRef*> m_marked_fields;
-  ConcurrentSet<const DexMethodRef*> m_marked_methods;
+  MarkedSet<DexClass> m_marked_classes;
+  MarkedSet<DexFieldRef> m_marked_fields;
+  MarkedSet<DexMethodRef> m_marked_methods;
   ReachableObjectGraph m_retainers_of;
 
   friend class RootSetMarker;
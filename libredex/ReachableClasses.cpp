@@ -10,7 +10,9 @@
 #include <boost/filesystem.hpp>
 #include <chrono>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <numeric>
 #include <sstream>
 #include <string>
 #include <unordered_set>
@@ -26,6 +28,7 @@
 #include "Trace.h"
 #include "TypeSystem.h"
 #include "Walkers.h"
+#include "WorkQueue.h"
 
 namespace {
 
@@ -143,8 +146,8 @@ void analyze_reflection(const Scope& scope) {
   const auto ATOMIC_REF_FIELD_UPDATER =
       "Ljava/util/concurrent/atomic/AtomicReferenceFieldUpdater;";
 
-  const std::unordered_map<std::string,
-                           std::unordered_map<std::string, ReflectionType>>
+  const std::unordered_map<std::string_view,
+                           std::unordered_map<std::string_view, ReflectionType>>
       refls = {
           {JAVA_LANG_CLASS,
            {
@@ -198,8 +201,8 @@ void analyze_reflection(const Scope& scope) {
       }
 
       // See if it matches something in refls
-      auto& method_name = insn->get_method()->get_name()->str();
-      auto& method_class_name =
+      auto method_name = insn->get_method()->get_name()->str();
+      auto method_class_name =
           insn->get_method()->get_class()->get_name()->str();
       auto method_map = refls.find(method_class_name);
       if (method_map == refls.end()) {
@@ -245,8 +248,8 @@ void analyze_reflection(const Scope& scope) {
       std::lock_guard<std::mutex> l(mutation_mutex);
 
       TRACE(PGR, 4, "SRA ANALYZE: %s: type:%d %s.%s cls: %d %s %s str: %s",
-            insn->get_method()->get_name()->str().c_str(), refl_type,
-            method_class_name.c_str(), method_name.c_str(), arg_cls->obj_kind,
+            insn->get_method()->get_name()->c_str(), refl_type,
+            method_class_name.data(), method_name.data(), arg_cls->obj_kind,
             SHOW(arg_cls->dex_type), SHOW(arg_cls->dex_string),
             SHOW(arg_str_value));
 
@@ -447,8 +450,18 @@ void mark_manifest_root(const std::string& classname) {
  * are sufficient to statically determine their reachability, so I am taking the
  * conservative approach. This may be worth revisiting.
  */
+ManifestClassInfo read_manifest_class_info(const std::string& apk_dir) {
+  try {
+    auto resources = create_resource_reader(apk_dir);
+    return resources->get_manifest_class_info();
+  } catch (const std::exception& e) {
+    std::cerr << "Error reading manifest: " << e.what() << std::endl;
+    return ManifestClassInfo{};
+  }
+}
+
 void analyze_reachable_from_manifest(
-    const std::string& apk_dir,
+    const ManifestClassInfo& manifest_class_info,
     const std::unordered_set<std::string>& prune_unexported_components_str) {
   std::unordered_map<std::string, ComponentTag> string_to_tag{
       {"activity", ComponentTag::Activity},
@@ -458,16 +471,6 @@ void analyze_reachable_from_manifest(
     prune_unexported_components.emplace(string_to_tag.at(s));
   }
 
-  auto manifest_class_info = [&apk_dir]() {
-    try {
-      auto resources = create_resource_reader(apk_dir);
-      return resources->get_manifest_class_info();
-    } catch (const std::exception& e) {
-      std::cerr << "Error reading manifest: " << e.what() << std::endl;
-      return ManifestClassInfo{};
-    }
-  }();
-
   for (const auto& classname : manifest_class_info.application_classes) {
     mark_manifest_root(classname);
   }
@@ -524,26 +527,34 @@ void mark_reachable_by_xml(const std::string& classname) {
   }
 }
 
-// 1) Marks classes (Fragments, Views) found in XML layouts as reachable along
-// with their constructors.
-// 2) Marks candidate methods that could be called via android:onClick
-// attributes.
-void analyze_reachable_from_xml_layouts(const Scope& scope,
-                                        const std::string& apk_dir) {
+struct XmlLayoutInfo {
   std::unordered_set<std::string> layout_classes;
+  std::unordered_multimap<std::string, std::string> attribute_values;
+};
+
+XmlLayoutInfo read_xml_layout_info(const std::string& apk_dir) {
+  XmlLayoutInfo info;
   std::unordered_set<std::string> attrs_to_read;
   // Method names used by reflection
   attrs_to_read.emplace(ONCLICK_ATTRIBUTE);
-  std::unordered_multimap<std::string, std::string> attribute_values;
   auto resources = create_resource_reader(apk_dir);
   resources->collect_layout_classes_and_attributes(
-      attrs_to_read, &layout_classes, &attribute_values);
-  for (const std::string& classname : layout_classes) {
+      attrs_to_read, &info.layout_classes, &info.attribute_values);
+  return info;
+}
+
+// 1) Marks classes (Fragments, Views) found in XML layouts as reachable along
+// with their constructors.
+// 2) Marks candidate methods that could be called via android:onClick
+// attributes.
+void analyze_reachable_from_xml_layouts(const Scope& scope,
+                                        const XmlLayoutInfo& info) {
+  for (const std::string& classname : info.layout_classes) {
     TRACE(PGR, 3, "xml_layout: %s", classname.c_str());
     mark_reachable_by_xml(classname);
   }
   auto attr_values =
-      multimap_values_to_set(attribute_values, ONCLICK_ATTRIBUTE);
+      multimap_values_to_set(info.attribute_values, ONCLICK_ATTRIBUTE);
   mark_onclick_attributes_reachable(scope, attr_values);
 }
 
@@ -635,6 +646,27 @@ void analyze_serializable(const Scope& scope) {
   }
 }
 
+// The native methods of `scope`, in scope order.
+std::vector<DexMethod*> get_native_methods(const Scope& scope) {
+  std::vector<std::vector<DexMethod*>> native_methods(scope.size());
+  std::vector<size_t> indices(scope.size());
+  std::iota(indices.begin(), indices.end(), 0);
+  workqueue_run<size_t>(
+      [&](size_t i) {
+        for (auto* meth : scope[i]->get_all_methods()) {
+          if (is_native(meth)) {
+            native_methods[i].push_back(meth);
+          }
+        }
+      },
+      indices);
+  std::vector<DexMethod*> res;
+  for (auto& methods : native_methods) {
+    res.insert(res.end(), methods.begin(), methods.end());
+  }
+  return res;
+}
+
 } // namespace
 
 /*
@@ -657,20 +689,46 @@ void init_reachable_classes(const Scope& scope,
   }
 
   if (!config.apk_dir.empty()) {
+    // The manifest, the XML layouts, the native libraries and the code are
+    // looked at concurrently. Marking happens afterwards, in a fixed order.
+    ManifestClassInfo manifest_class_info;
+    XmlLayoutInfo xml_layout_info;
+    std::unordered_set<std::string> native_classes;
+    std::vector<DexMethod*> native_methods;
+    {
+      Timer t{"Reading resources and native libraries"};
+      std::vector<std::function<void()>> fns;
+      if (config.compute_xml_reachability) {
+        fns.emplace_back([&] {
+          manifest_class_info = read_manifest_class_info(config.apk_dir);
+        });
+        fns.emplace_back(
+            [&] { xml_layout_info = read_xml_layout_info(config.apk_dir); });
+      }
+      if (config.analyze_native_lib_reachability) {
+        fns.emplace_back([&] {
+          // Classnames present in native libraries (lib/*/*.so)
+          native_classes =
+              create_resource_reader(config.apk_dir)->get_native_classes();
+        });
+      }
+      fns.emplace_back([&] { native_methods = get_native_methods(scope); });
+      workqueue_run<std::function<void()>>(
+          [](std::function<void()>& fn) { fn(); }, fns);
+    }
+
     if (config.compute_xml_reachability) {
       Timer t{"Computing XML reachability"};
       // Classes present in manifest
-      analyze_reachable_from_manifest(config.apk_dir,
+      analyze_reachable_from_manifest(manifest_class_info,
                                       config.prune_unexported_components);
       // Classes present in XML layouts
-      analyze_reachable_from_xml_layouts(scope, config.apk_dir);
+      analyze_reachable_from_xml_layouts(scope, xml_layout_info);
     }
 
     if (config.analyze_native_lib_reachability) {
       Timer t{"Computing native reachability"};
-      // Classnames present in native libraries (lib/*/*.so)
-      auto resources = create_resource_reader(config.apk_dir);
-      for (const std::string& classname : resources->get_native_classes()) {
+      for (const std::string& classname : native_classes) {
         auto type = DexType::get_type(classname.c_str());
         if (type == nullptr) continue;
         TRACE(PGR, 3, "native_lib: %s", classname.c_str());
@@ -682,15 +740,13 @@ void init_reachable_classes(const Scope& scope,
         mark_native_classes_from_fbjni_configs(config.fbjni_json_files);
       }
     }
-    walk::methods(scope, [&](DexMethod* meth) {
+    for (auto* meth : native_methods) {
       // These were probably already marked by the native lib reachability
       // analysis above, but just to be doubly sure...
-      if (is_native(meth)) {
-        TRACE(PGR, 3, "native_method: %s", SHOW(meth->get_class()));
-        mark_reachable_by_string(meth);
-        meth->rstate.set_keepnames(keep_reason::NATIVE);
-      }
-    });
+      TRACE(PGR, 3, "native_method: %s", SHOW(meth->get_class()));
+      mark_reachable_by_string(meth);
+      meth->rstate.set_keepnames(keep_reason::NATIVE);
+    }
   }
 
   {
@@ -750,7 +806,7 @@ void recompute_reachable_from_xml_layouts(const Scope& scope,
       field->rstate.unset_referenced_by_resource_xml();
     }
   });
-  analyze_reachable_from_xml_layouts(scope, apk_dir);
+  analyze_reachable_from_xml_layouts(scope, read_xml_layout_info(apk_dir));
 }
 
 std::string ReferencedState::str() const {
@@ -7,10 +7,14 @@
 
 #include "RedexContext.h"
 
+#include <algorithm>
 #include <exception>
 #include <iostream>
+#include <limits>
 #include <mutex>
+#include <new>
 #include <regex>
+#include <tuple>
 #include <unordered_set>
 
 #include "Debug.h"
@@ -28,12 +32,9 @@ RedexContext::RedexContext(bool allow_class_duplicates)
     : m_allow_class_duplicates(allow_class_duplicates) {}
 
 RedexContext::~RedexContext() {
-  // Delete DexStrings.
-  for (auto& segment : s_string_map) {
-    for (auto const& p : segment) {
-      delete p.second;
-    }
-  }
+  // DexStrings live in m_string_arena_chunks and need no destruction.
+  static_assert(std::is_trivially_destructible<DexString>::value);
+
   // Delete DexTypes.  NB: This table intentionally contains aliases (multiple
   // DexStrings map to the same DexType), so we have to dedup the set of types
   // before deleting to avoid double-frees.
@@ -65,10 +66,6 @@ RedexContext::~RedexContext() {
     delete it.second;
   }
 
-  for (const auto& p : s_keep_reasons) {
-    delete p.second;
-  }
-
   for (const Task& t : m_destruction_tasks) {
     t();
   }
@@ -100,6 +97,36 @@ static StoredValue* try_insert(Key key,
   return container->at(key);
 }
 
+DexString* RedexContext::allocate_string(const char* nstr, uint32_t utfsize) {
+  size_t len = strlen(nstr);
+  always_assert(len <= std::numeric_limits<uint32_t>::max());
+  // Header, data and NUL terminator, padded so the next header is aligned.
+  size_t alloc_size = sizeof(DexString) + len + 1;
+  constexpr size_t align = alignof(DexString);
+  alloc_size = (alloc_size + align - 1) & ~(align - 1);
+
+  char* mem;
+  {
+    std::lock_guard<std::mutex> lock(m_string_arena_lock);
+    if (alloc_size > kStringArenaChunkSize / 4) {
+      // Give huge strings their own chunk, so as not to waste the rest of
+      // the current one.
+      m_string_arena_chunks.emplace_back(new char[alloc_size]);
+      mem = m_string_arena_chunks.back().get();
+    } else {
+      if ((size_t)(m_string_arena_end - m_string_arena_cur) < alloc_size) {
+        m_string_arena_chunks.emplace_back(new char[kStringArenaChunkSize]);
+        m_string_arena_cur = m_string_arena_chunks.back().get();
+        m_string_arena_end = m_string_arena_cur + kStringArenaChunkSize;
+      }
+      mem = m_string_arena_cur;
+      m_string_arena_cur += alloc_size;
+    }
+  }
+  memcpy(mem + sizeof(DexString), nstr, len + 1);
+  return new (mem) DexString((uint32_t)len, utfsize);
+}
+
 DexString* RedexContext::make_string(const char* nstr, uint32_t utfsize) {
   always_assert(nstr != nullptr);
   auto p = std::make_pair(nstr, utfsize);
@@ -109,13 +136,68 @@ DexString* RedexContext::make_string(const char* nstr, uint32_t utfsize) {
   if (rv != nullptr) {
     return rv;
   }
-  // Note that DexStrings are keyed by the c_str() of the underlying
-  // std::string. The c_str is valid until a the string is destroyed, or until a
-  // non-const function is called on the string (but note the std::string itself
-  // is const)
-  auto dexstring = new DexString(nstr, utfsize);
+  // DexStrings are keyed by their c_str(), which points into the arena and
+  // is stable for the lifetime of the context. If another thread wins the
+  // race to insert the same string, our copy stays unused in the arena.
+  auto dexstring = allocate_string(nstr, utfsize);
   auto p2 = std::make_pair(dexstring->c_str(), utfsize);
-  return try_insert(p2, dexstring, &segment);
+  if (segment.emplace(p2, dexstring)) {
+    return dexstring;
+  }
+  return segment.at(p2);
+}
+
+std::vector<DexString*> RedexContext::make_strings(
+    const std::vector<StringMapKey>& strs) {
+  using Segment = ConcurrentProjectedStringMap<>;
+  std::vector<DexString*> result(strs.size(), nullptr);
+  std::vector<std::tuple<boost::mutex*, Segment*, size_t>> order;
+  order.reserve(strs.size());
+  for (size_t i = 0; i < strs.size(); i++) {
+    always_assert(strs[i].first != nullptr);
+    auto& segment = s_string_map.at(strs[i]);
+    order.emplace_back(&segment.get_lock(strs[i]), &segment, i);
+  }
+  std::sort(order.begin(), order.end());
+
+  for (size_t begin = 0, end; begin < order.size(); begin = end) {
+    auto* mutex = std::get<0>(order[begin]);
+    boost::lock_guard<boost::mutex> lock(*mutex);
+    for (end = begin; end < order.size() && std::get<0>(order[end]) == mutex;
+         end++) {
+      auto* segment = std::get<1>(order[end]);
+      size_t i = std::get<2>(order[end]);
+      const auto& p = strs[i];
+      auto it = segment->find(p);
+      if (it != segment->end()) {
+        result[i] = it->second;
+        continue;
+      }
+      // Holding the shard lock, nobody can race us to insert this string, so
+      // unlike make_string we never copy a string into the arena in vain.
+      auto dexstring = allocate_string(p.first, p.second);
+      segment->update_unsafe(
+          std::make_pair(dexstring->c_str(), p.second),
+          [&](const char*, DexString*& value, bool) { value = dexstring; });
+      result[i] = dexstring;
+    }
+  }
+  return result;
+}
+
+void RedexContext::assign_string_ordinals() {
+  std::vector<DexString*> strings;
+  for (auto& segment : s_string_map) {
+    for (auto& p : segment) {
+      strings.push_back(p.second);
+    }
+  }
+  always_assert(strings.size() < std::numeric_limits<uint32_t>::max());
+  std::sort(strings.begin(), strings.end(), compare_dexstring_contents);
+  uint32_t ordinal = 0;
+  for (auto* s : strings) {
+    s->m_ordinal = ++ordinal;
+  }
 }
 
 DexString* RedexContext::get_string(const char* nstr, uint32_t utfsize) {
@@ -149,7 +231,8 @@ void RedexContext::set_type_name(DexType* type, DexString* new_name) {
   type->m_name = new_name;
 }
 
-void RedexContext::alias_type_name(DexType* type, DexString* new_name) {
+void RedexContext::alias_type_name(DexType* type,
+                                   const DexString* new_name) {
   always_assert_log(
       !s_type_map.count(new_name),
       "Bailing, attempting to alias a symbol that already exists! '%s'\n",
@@ -157,7 +240,9 @@ void RedexContext::alias_type_name(DexType* type, DexString* new_name) {
   s_type_map.emplace(new_name, type);
 }
 
-void RedexContext::remove_type_name(DexString* name) { s_type_map.erase(name); }
+void RedexContext::remove_type_name(const DexString* name) {
+  s_type_map.erase(name);
+}
 
 DexFieldRef* RedexContext::make_field(const DexType* container,
                                       const DexString* name,
@@ -218,17 +303,17 @@ void RedexContext::mutate_field(DexFieldRef* field,
   s_field_map.emplace(r, field);
 }
 
-DexTypeList* RedexContext::make_type_list(std::deque<DexType*>&& p) {
-  auto rv = s_typelist_map.get(p, nullptr);
+DexTypeList* RedexContext::make_type_list(DexTypeList::ContainerType&& p) {
+  auto rv = s_typelist_map.get(&p, nullptr);
   if (rv != nullptr) {
     return rv;
   }
   auto typelist = new DexTypeList(std::move(p));
-  return try_insert(typelist->m_list, typelist, &s_typelist_map);
+  return try_insert(&typelist->m_list, typelist, &s_typelist_map);
 }
 
-DexTypeList* RedexContext::get_type_list(std::deque<DexType*>&& p) {
-  return s_typelist_map.get(p, nullptr);
+DexTypeList* RedexContext::get_type_list(DexTypeList::ContainerType&& p) {
+  return s_typelist_map.get(&p, nullptr);
 }
 
 DexProto* RedexContext::make_proto(const DexType* rtype,
@@ -285,6 +370,39 @@ DexMethodRef* RedexContext::get_method(const DexType* type,
   return s_method_map.get(r, nullptr);
 }
 
+std::vector<DexMethodRef*> RedexContext::make_methods(
+    const std::vector<DexMethodSpec>& specs) {
+  std::vector<DexMethodRef*> result(specs.size(), nullptr);
+  std::vector<std::pair<boost::mutex*, size_t>> missing;
+  for (size_t i = 0; i < specs.size(); i++) {
+    const auto& r = specs[i];
+    always_assert(r.cls != nullptr && r.name != nullptr && r.proto != nullptr);
+    result[i] = s_method_map.get(r, nullptr);
+    if (result[i] == nullptr) {
+      missing.emplace_back(&s_method_map.get_lock(r), i);
+    }
+  }
+  std::sort(missing.begin(), missing.end());
+
+  for (size_t begin = 0, end; begin < missing.size(); begin = end) {
+    auto* mutex = missing[begin].first;
+    boost::lock_guard<boost::mutex> lock(*mutex);
+    for (end = begin; end < missing.size() && missing[end].first == mutex;
+         end++) {
+      size_t i = missing[end].second;
+      const auto& r = specs[i];
+      s_method_map.update_unsafe(
+          r, [&](const DexMethodSpec&, DexMethodRef*& value, bool exists) {
+            if (!exists) {
+              value = new DexMethod(r.cls, r.name, r.proto);
+            }
+            result[i] = value;
+          });
+    }
+  }
+  return result;
+}
+
 void RedexContext::erase_method(DexMethodRef* method) {
   s_method_map.erase(method->m_spec);
 }
@@ -323,9 +441,11 @@ void RedexContext::mutate_method(DexMethodRef* method,
       if (r.name->str().front() == '<') {
         redex_assert(r.name->str().back() == '>');
         prefix =
-            "$" + r.name->str().substr(1, r.name->str().length() - 2) + "$$";
+            "$" +
+            std::string(r.name->str().substr(1, r.name->str().length() - 2)) +
+            "$$";
       } else {
-        prefix = r.name->str() + "$";
+        prefix = r.name->str_copy() + "$";
       }
       do {
         r.name = DexString::make_string((prefix + std::to_string(i++)).c_str());
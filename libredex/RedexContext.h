@@ -15,6 +15,7 @@
 #include <limits>
 #include <list>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <sstream>
 #include <unordered_map>
@@ -59,6 +60,22 @@ struct RedexContext {
   DexString* make_string(const char* nstr, uint32_t utfsize);
   DexString* get_string(const char* nstr, uint32_t utfsize);
 
+  /**
+   * Batch variant of make_string, taking (nstr, utfsize) pairs. The strings
+   * are grouped by shard, so that each shard lock is taken once per batch
+   * rather than once per string. Results are in input order.
+   */
+  std::vector<DexString*> make_strings(
+      const std::vector<std::pair<const char*, uint32_t>>& strs);
+
+  /**
+   * Sort all existing DexStrings once and record their rank on them, so that
+   * compare_dexstrings becomes an integer comparison for them. Strings created
+   * afterwards are still compared by contents. Must not run concurrently with
+   * string comparisons.
+   */
+  void assign_string_ordinals();
+
   DexType* make_type(const DexString* dstring);
   DexType* get_type(const DexString* dstring);
 
@@ -69,11 +86,11 @@ struct RedexContext {
   /**
    * Add an additional name to refer to a type (a deobfuscated name for example)
    */
-  void alias_type_name(DexType* type, DexString* new_name);
+  void alias_type_name(DexType* type, const DexString* new_name);
   /**
    * Remove a name -> type entry from the map
    */
-  void remove_type_name(DexString* name);
+  void remove_type_name(const DexString* name);
 
   DexFieldRef* make_field(const DexType* container,
                           const DexString* name,
@@ -87,8 +104,8 @@ struct RedexContext {
                     const DexFieldSpec& ref,
                     bool rename_on_collision);
 
-  DexTypeList* make_type_list(std::deque<DexType*>&& p);
-  DexTypeList* get_type_list(std::deque<DexType*>&& p);
+  DexTypeList* make_type_list(std::vector<DexType*>&& p);
+  DexTypeList* get_type_list(std::vector<DexType*>&& p);
 
   DexProto* make_proto(const DexType* rtype,
                        const DexTypeList* args,
@@ -102,6 +119,14 @@ struct RedexContext {
                            const DexString* name,
                            const DexProto* proto);
 
+  /**
+   * Batch variant of make_method. Existing methods are looked up without
+   * locking; the missing ones are grouped by shard and created with one lock
+   * acquisition per shard. Results are in input order.
+   */
+  std::vector<DexMethodRef*> make_methods(
+      const std::vector<DexMethodSpec>& specs);
+
   DexMethodHandle* make_methodhandle();
   DexMethodHandle* get_methodhandle();
 
@@ -140,14 +165,15 @@ struct RedexContext {
     g_redex->m_record_keep_reasons = v;
   }
 
-  template <class... Args>
-  static keep_reason::Reason* make_keep_reason(Args&&... args) {
-    auto to_insert =
-        std::make_unique<keep_reason::Reason>(std::forward<Args>(args)...);
-    if (g_redex->s_keep_reasons.emplace(to_insert.get(), to_insert.get())) {
-      return to_insert.release();
-    }
-    return g_redex->s_keep_reasons.at(to_insert.get());
+  /*
+   * When set, loading dex files with ballooning only marks the code of methods
+   * to be ballooned on first access, see DexMethod::balloon_lazily().
+   */
+  static bool lazy_balloon() { return g_redex->m_lazy_balloon; }
+  static void set_lazy_balloon(bool v) { g_redex->m_lazy_balloon = v; }
+
+  static keep_reason::Recorder& keep_reasons() {
+    return g_redex->m_keep_reasons;
   }
 
   // Add a lambda to be called when RedexContext is destructed. This is
@@ -287,17 +313,42 @@ struct RedexContext {
   // DexString
   LargeStringMap<31, 127> s_string_map;
 
-  // DexType
-  ConcurrentMap<const DexString*, DexType*> s_type_map;
+  // DexStrings are placement-constructed, followed by their data, into large
+  // bump-allocated chunks that live as long as the context. This avoids a
+  // separate heap allocation (and std::string overhead) per string, and makes
+  // teardown a matter of freeing a few chunks.
+  static constexpr size_t kStringArenaChunkSize = 1024 * 1024;
+  DexString* allocate_string(const char* nstr, uint32_t utfsize);
+  std::mutex m_string_arena_lock;
+  std::vector<std::unique_ptr<char[]>> m_string_arena_chunks;
+  char* m_string_arena_cur{nullptr};
+  char* m_string_arena_end{nullptr};
+
+  // DexType. Type and method lookups vastly outnumber insertions, so these
+  // maps use lock-free reads.
+  ReadMostlyConcurrentMap<const DexString*, DexType*> s_type_map;
 
   // DexFieldRef
   ConcurrentMap<DexFieldSpec, DexFieldRef*> s_field_map;
   std::mutex s_field_lock;
 
-  // DexTypeList
-  ConcurrentMap<std::deque<DexType*>,
+  // DexTypeList. Keyed by the list held by the DexTypeList itself, so that
+  // the types are not stored a second time; lookups pass the list to find.
+  struct TypeListHash {
+    size_t operator()(const std::vector<DexType*>* list) const {
+      return boost::hash_range(list->begin(), list->end());
+    }
+  };
+  struct TypeListEqual {
+    bool operator()(const std::vector<DexType*>* a,
+                    const std::vector<DexType*>* b) const {
+      return *a == *b;
+    }
+  };
+  ConcurrentMap<const std::vector<DexType*>*,
                 DexTypeList*,
-                boost::hash<std::deque<DexType*>>>
+                TypeListHash,
+                TypeListEqual>
       s_typelist_map;
 
   // DexProto
@@ -305,7 +356,7 @@ struct RedexContext {
   ConcurrentMap<ProtoKey, DexProto*, boost::hash<ProtoKey>> s_proto_map;
 
   // DexMethod
-  ConcurrentMap<DexMethodSpec, DexMethodRef*> s_method_map;
+  ReadMostlyConcurrentMap<DexMethodSpec, DexMethodRef*> s_method_map;
   std::mutex s_method_lock;
 
   // DexPositionSwitch and DexPositionPattern
@@ -318,11 +369,7 @@ struct RedexContext {
 
   const std::vector<const DexType*> m_empty_types;
 
-  ConcurrentMap<keep_reason::Reason*,
-                keep_reason::Reason*,
-                keep_reason::ReasonPtrHash,
-                keep_reason::ReasonPtrEqual>
-      s_keep_reasons;
+  keep_reason::Recorder m_keep_reasons;
 
   // These functions will be called when ~RedexContext() is called
   std::mutex m_destruction_tasks_lock;
@@ -331,6 +378,7 @@ struct RedexContext {
   std::unordered_map<std::string, size_t> m_sb_interaction_indices;
 
   bool m_record_keep_reasons{false};
+  bool m_lazy_balloon{false};
   bool m_allow_class_duplicates;
 
   bool m_pointers_cache_loaded{false};
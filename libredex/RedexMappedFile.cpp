@@ -48,6 +48,19 @@ RedexMappedFile RedexMappedFile::open(std::string path, bool read_only) {
   return RedexMappedFile(std::move(map), std::move(path), read_only);
 }
 
+RedexMappedFile RedexMappedFile::create(std::string path, size_t size) {
+  boost::iostreams::mapped_file_params params(path);
+  params.flags = boost::iostreams::mapped_file::readwrite;
+  params.new_file_size = size;
+  auto map = std::make_unique<boost::iostreams::mapped_file>();
+  map->open(params);
+  if (!map->is_open()) {
+    throw std::runtime_error(std::string("Could not create ") + path);
+  }
+
+  return RedexMappedFile(std::move(map), std::move(path), false);
+}
+
 const char* RedexMappedFile::const_data() const { return file->const_data(); }
 char* RedexMappedFile::data() const {
   redex_assert(!read_only);
@@ -34,6 +34,10 @@ struct RedexMappedFile {
 
   static RedexMappedFile open(std::string path, bool read_only = true);
 
+  // Creates (or truncates) the file at `path` with `size` zero bytes and maps
+  // it writable. The file is sparse until written to.
+  static RedexMappedFile create(std::string path, size_t size);
+
   const char* const_data() const;
   char* data() const;
   size_t size() const;
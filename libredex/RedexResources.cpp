@@ -7,17 +7,21 @@
 
 #include "RedexResources.h"
 
+#include <algorithm>
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/operations.hpp>
+#include <cstring>
 #include <map>
 #include <mutex>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
 #include "ApkResources.h"
 #include "BundleResources.h"
+#include "ConcurrentContainers.h"
 #include "Debug.h"
 #include "DetectBundle.h"
 #include "DexUtil.h"
@@ -28,6 +32,10 @@
 #include "Trace.h"
 #include "WorkQueue.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 // Workaround for inclusion order, when compiling on Windows (#defines NO_ERROR
 // as 0).
 #ifdef NO_ERROR
@@ -40,8 +48,6 @@ constexpr size_t MIN_CLASSNAME_LENGTH = 10;
 constexpr size_t MAX_CLASSNAME_LENGTH = 500;
 
 constexpr decltype(redex_parallel::default_num_threads()) kReadXMLThreads = 4u;
-constexpr decltype(redex_parallel::default_num_threads()) kReadNativeThreads =
-    2u;
 
 using path_t = boost::filesystem::path;
 using dir_iterator = boost::filesystem::directory_iterator;
@@ -64,6 +70,150 @@ std::unique_ptr<AndroidResources> create_resource_reader(
 }
 
 namespace {
+
+bool is_identifier_char(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '/' || c == '_' || c == '$';
+}
+
+/*
+ * Returns a mask with bit i set iff p[i] is in [a-zA-Z0-9/_$], for the 64
+ * bytes at p.
+ */
+uint64_t identifier_mask64(const char* p) {
+#if defined(__SSE2__)
+  uint64_t mask = 0;
+  for (size_t i = 0; i < 64; i += 16) {
+    __m128i bytes = _mm_loadu_si128((const __m128i*)(p + i));
+    // Bytes >= 0x80 are negative, so they fail all range checks.
+    __m128i folded = _mm_or_si128(bytes, _mm_set1_epi8(0x20));
+    __m128i letter =
+        _mm_and_si128(_mm_cmpgt_epi8(folded, _mm_set1_epi8('a' - 1)),
+                      _mm_cmplt_epi8(folded, _mm_set1_epi8('z' + 1)));
+    // '/' immediately precedes '0'.
+    __m128i digit_or_slash =
+        _mm_and_si128(_mm_cmpgt_epi8(bytes, _mm_set1_epi8('/' - 1)),
+                      _mm_cmplt_epi8(bytes, _mm_set1_epi8('9' + 1)));
+    __m128i other = _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('_')),
+                                 _mm_cmpeq_epi8(bytes, _mm_set1_epi8('$')));
+    __m128i ident = _mm_or_si128(_mm_or_si128(letter, digit_or_slash), other);
+    mask |= (uint64_t)(uint16_t)_mm_movemask_epi8(ident) << i;
+  }
+  return mask;
+#else
+  uint64_t mask = 0;
+  for (size_t i = 0; i < 64; ++i) {
+    mask |= (uint64_t)is_identifier_char(p[i]) << i;
+  }
+  return mask;
+#endif
+}
+
+/*
+ * Calls fn(begin, end) for every maximal run of identifier characters in the
+ * data, classifying 64 bytes at a time. Runs shorter than min_length (at most
+ * 64) may be skipped.
+ */
+template <typename Fn>
+void for_each_identifier_run(const char* data,
+                             size_t size,
+                             size_t min_length,
+                             Fn&& fn) {
+  bool in_run = false;
+  size_t run_start = 0;
+  char tail[64];
+  for (size_t base = 0; base < size; base += 64) {
+    uint64_t mask;
+    if (size - base >= 64) {
+      mask = identifier_mask64(data + base);
+    } else {
+      // NUL is not an identifier char, so padding does not extend runs.
+      memset(tail, 0, sizeof(tail));
+      memcpy(tail, data + base, size - base);
+      mask = identifier_mask64(tail);
+    }
+    // Positions that start at least min_length identifier chars, assuming
+    // that the next block continues any run at the end of this one. Only
+    // those are considered as run starts, which skips most short runs
+    // without looking at them.
+    uint64_t starts = mask;
+    for (size_t k = 1; k < min_length; ++k) {
+      starts &= (mask >> k) | ~(~uint64_t(0) >> k);
+    }
+    while (true) {
+      if (in_run) {
+        if (~mask == 0) {
+          break;
+        }
+        size_t end = __builtin_ctzll(~mask);
+        fn(data + run_start, data + base + end);
+        in_run = false;
+        // Only look at what comes after the run.
+        mask &= ~uint64_t(0) << end;
+        starts &= ~uint64_t(0) << end;
+      } else {
+        if (starts == 0) {
+          break;
+        }
+        size_t begin = __builtin_ctzll(starts);
+        run_start = base + begin;
+        in_run = true;
+        // Pretend everything before the run is in it, to find its end.
+        mask |= (uint64_t(1) << begin) - 1;
+      }
+    }
+  }
+  if (in_run) {
+    fn(data + run_start, data + size);
+  }
+}
+
+/*
+ * Calls fn(name, has_prefix) for every string that looks like a java class
+ * name in a native library. All classnames start with a package, which starts
+ * with a lowercase letter. Some of them are preceded by an 'L' (has_prefix)
+ * and followed by a ';' in native libraries while others are not. Names are
+ * cut off at MAX_CLASSNAME_LENGTH, including the 'L', after which scanning
+ * resumes past the following character.
+ */
+template <typename Fn>
+void for_each_class_in_native_lib(const char* data, size_t size, Fn&& fn) {
+  // A name needs at least MIN_CLASSNAME_LENGTH - 1 chars besides a 'L' that
+  // may be added.
+  size_t min_length = MIN_CLASSNAME_LENGTH - 1;
+  for_each_identifier_run(data, size, min_length, [&](const char* begin,
+                                                      const char* end) {
+    if ((size_t)(end - begin) < min_length) {
+      return;
+    }
+    const char* p = begin;
+    while (p < end) {
+      if (!((*p >= 'a' && *p <= 'z') || *p == 'L')) {
+        ++p;
+        continue;
+      }
+      bool has_prefix = *p == 'L';
+      size_t max_chars = MAX_CLASSNAME_LENGTH - (has_prefix ? 0 : 1);
+      size_t num_chars = std::min<size_t>(end - p, max_chars);
+      if (num_chars + (has_prefix ? 0 : 1) >= MIN_CLASSNAME_LENGTH) {
+        fn(std::string_view(p, num_chars), has_prefix);
+      }
+      p += num_chars + 1;
+    }
+  });
+}
+
+std::string to_class_name(std::string_view name, bool has_prefix) {
+  std::string class_name;
+  class_name.reserve(name.size() + 2);
+  if (!has_prefix) {
+    class_name += 'L';
+  }
+  class_name += name;
+  class_name += ';';
+  return class_name;
+}
+
 /*
  * Returns all strings that look like java class names from a native library.
  *
@@ -76,40 +226,10 @@ namespace {
 std::unordered_set<std::string> extract_classes_from_native_lib(
     const char* data, size_t size) {
   std::unordered_set<std::string> classes;
-  char buffer[MAX_CLASSNAME_LENGTH + 2]; // +2 for the trailing ";\0"
-  const char* inptr = data;
-  const char* end = inptr + size;
-
-  while (inptr < end) {
-    char* outptr = buffer;
-    size_t length = 0;
-    // All classnames start with a package, which starts with a lowercase
-    // letter. Some of them are preceded by an 'L' and followed by a ';' in
-    // native libraries while others are not.
-    if ((*inptr >= 'a' && *inptr <= 'z') || *inptr == 'L') {
-
-      if (*inptr != 'L') {
-        *outptr++ = 'L';
-        length++;
-      }
-
-      while (inptr < end &&
-             ((*inptr >= 'a' && *inptr <= 'z') ||
-              (*inptr >= 'A' && *inptr <= 'Z') ||
-              (*inptr >= '0' && *inptr <= '9') || *inptr == '/' ||
-              *inptr == '_' || *inptr == '$') &&
-             length < MAX_CLASSNAME_LENGTH) {
-        *outptr++ = *inptr++;
-        length++;
-      }
-      if (length >= MIN_CLASSNAME_LENGTH) {
-        *outptr++ = ';';
-        *outptr = '\0';
-        classes.insert(std::string(buffer));
-      }
-    }
-    inptr++;
-  }
+  for_each_class_in_native_lib(
+      data, size, [&](std::string_view name, bool has_prefix) {
+        classes.insert(to_class_name(name, has_prefix));
+      });
   return classes;
 }
 } // namespace
@@ -286,31 +406,25 @@ void AndroidResources::collect_layout_classes_and_attributes(
 
 void AndroidResources::rename_classes_in_layouts(
     const std::map<std::string, std::string>& rename_map) {
+  // Collect all layouts up front so that the rewriting is spread over the
+  // whole worker pool instead of trickling in from a single dispatcher.
+  std::vector<std::string> layouts;
+  for (const auto& dir : find_res_directories()) {
+    for (const auto& path : get_xml_files(dir)) {
+      if (!is_raw_resource(path)) {
+        layouts.push_back(path);
+      }
+    }
+  }
   workqueue_run<std::string>(
-      [&](sparta::SpartaWorkerState<std::string>* worker_state,
-          const std::string& input) {
-        if (input.empty()) {
-          // Dispatcher, find files and create tasks.
-          auto directories = find_res_directories();
-          for (const auto& dir : directories) {
-            auto xml_files = get_xml_files(dir);
-            for (const auto& path : xml_files) {
-              if (!is_raw_resource(path)) {
-                worker_state->push_task(path);
-              }
-            }
-          }
-          return;
-        }
+      [&](const std::string& input) {
         size_t num_renamed = 0;
         TRACE(RES, 3, "Begin rename Views in layout %s", input.c_str());
         bool result = rename_classes_in_layout(input, rename_map, &num_renamed);
         TRACE(RES, 3, "%sRenamed %zu class names in file %s",
               (result ? "" : "FAILED: "), num_renamed, input.c_str());
       },
-      std::vector<std::string>{""},
-      std::min(redex_parallel::default_num_threads(), kReadXMLThreads),
-      /*push_tasks_while_running=*/true);
+      layouts);
 }
 
 std::set<std::string> multimap_values_to_set(
@@ -355,8 +469,10 @@ void find_native_library_files(const std::string& lib_root, Fn handler) {
  * Return all potential java class names located in native libraries.
  */
 std::unordered_set<std::string> AndroidResources::get_native_classes() {
-  std::mutex out_mutex;
-  std::unordered_set<std::string> all_classes;
+  // All files feed into one pool. Within a file, names are first deduplicated
+  // as views into the file, so that every distinct name is materialized once
+  // per file at most.
+  ConcurrentSet<std::string> all_classes;
   workqueue_run<std::string>(
       [&](sparta::SpartaWorkerState<std::string>* worker_state,
           const std::string& input) {
@@ -376,19 +492,19 @@ std::unordered_set<std::string> AndroidResources::get_native_classes() {
         redex::read_file_with_contents(
             input,
             [&](const char* data, size_t size) {
-              std::unordered_set<std::string> classes_from_native =
-                  extract_classes_from_native_lib(data, size);
-              if (!classes_from_native.empty()) {
-                std::unique_lock<std::mutex> lock(out_mutex);
-                // C++17: use merge to avoid copies.
-                all_classes.insert(classes_from_native.begin(),
-                                   classes_from_native.end());
-              }
+              std::unordered_set<std::string_view> seen;
+              for_each_class_in_native_lib(
+                  data, size, [&](std::string_view name, bool has_prefix) {
+                    if (seen.insert(name).second) {
+                      all_classes.insert(to_class_name(name, has_prefix));
+                    }
+                  });
             },
             64 * 1024);
       },
       std::vector<std::string>{""},
-      std::min(redex_parallel::default_num_threads(), kReadNativeThreads),
+      redex_parallel::default_num_threads(),
       /*push_tasks_while_running=*/true);
-  return all_classes;
+  return std::unordered_set<std::string>(all_classes.begin(),
+                                         all_classes.end());
 }
@@ -9,8 +9,13 @@
 #include "EditableCfgAdapter.h"
 #include "Resolver.h"
 #include "TypeUtil.h"
+#include "Walkers.h"
 
 bool RefChecker::check_type(const DexType* type) const {
+  auto it = m_precomputed_types.find(type);
+  if (it != m_precomputed_types.end()) {
+    return it->second;
+  }
   auto res = m_type_cache.get(type, boost::none);
   if (res == boost::none) {
     res = check_type_internal(type);
@@ -24,6 +29,10 @@ bool RefChecker::check_type(const DexType* type) const {
 }
 
 bool RefChecker::check_method(const DexMethod* method) const {
+  auto it = m_precomputed_methods.find(method);
+  if (it != m_precomputed_methods.end()) {
+    return it->second;
+  }
   auto res = m_method_cache.get(method, boost::none);
   if (res == boost::none) {
     res = check_method_internal(method);
@@ -38,6 +47,10 @@ bool RefChecker::check_method(const DexMethod* method) const {
 }
 
 bool RefChecker::check_field(const DexField* field) const {
+  auto it = m_precomputed_fields.find(field);
+  if (it != m_precomputed_fields.end()) {
+    return it->second;
+  }
   auto res = m_field_cache.get(field, boost::none);
   if (res == boost::none) {
     res = check_field_internal(field);
@@ -79,25 +92,9 @@ bool RefChecker::check_method_and_code(const DexMethod* method) const {
     editable_cfg_adapter::iterate(
         method->get_code(),
         [this, method, &all_refs_valid](const MethodItemEntry& mie) {
-          auto insn = mie.insn;
-          if (insn->has_type()) {
-            if (!check_type(insn->get_type())) {
-              all_refs_valid = false;
-              return editable_cfg_adapter::LOOP_BREAK;
-            }
-          } else if (insn->has_field()) {
-            auto field = resolve_field(insn->get_field());
-            if (!field || !check_field(field)) {
-              all_refs_valid = false;
-              return editable_cfg_adapter::LOOP_BREAK;
-            }
-          } else if (insn->has_method()) {
-            auto callee = resolve_method(
-                insn->get_method(), opcode_to_search(insn), method);
-            if (!callee || !check_method(callee)) {
-              all_refs_valid = false;
-              return editable_cfg_adapter::LOOP_BREAK;
-            }
+          if (!check_insn(mie.insn, method)) {
+            all_refs_valid = false;
+            return editable_cfg_adapter::LOOP_BREAK;
           }
           return editable_cfg_adapter::LOOP_CONTINUE;
         });
@@ -106,6 +103,54 @@ bool RefChecker::check_method_and_code(const DexMethod* method) const {
   return true;
 }
 
+bool RefChecker::check_insn(const IRInstruction* insn,
+                            const DexMethod* method) const {
+  if (insn->has_type()) {
+    return check_type(insn->get_type());
+  } else if (insn->has_field()) {
+    auto field = resolve_field(insn->get_field());
+    return field && check_field(field);
+  } else if (insn->has_method()) {
+    auto callee =
+        resolve_method(insn->get_method(), opcode_to_search(insn), method);
+    return callee && check_method(callee);
+  }
+  return true;
+}
+
+void RefChecker::precompute(const Scope& scope) {
+  walk::parallel::classes(scope, [this](DexClass* cls) {
+    check_type(cls->get_type());
+    for (auto* field : cls->get_all_fields()) {
+      check_field(field);
+    }
+  });
+  walk::parallel::methods(scope, [this](DexMethod* method) {
+    check_method(method);
+    if (method->get_code()) {
+      editable_cfg_adapter::iterate(
+          method->get_code(), [this, method](const MethodItemEntry& mie) {
+            check_insn(mie.insn, method);
+            return editable_cfg_adapter::LOOP_CONTINUE;
+          });
+    }
+  });
+
+  // Move all verdicts out of the caches.
+  for (auto& p : m_type_cache) {
+    m_precomputed_types.emplace(p.first, *p.second);
+  }
+  for (auto& p : m_method_cache) {
+    m_precomputed_methods.emplace(p.first, *p.second);
+  }
+  for (auto& p : m_field_cache) {
+    m_precomputed_fields.emplace(p.first, *p.second);
+  }
+  m_type_cache.clear();
+  m_method_cache.clear();
+  m_field_cache.clear();
+}
+
 bool RefChecker::check_type_internal(const DexType* type) const {
   type = type::get_element_type_if_array(type);
   if (type::is_primitive(type)) {
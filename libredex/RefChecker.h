@@ -8,6 +8,7 @@
 #pragma once
 
 #include <boost/optional.hpp>
+#include <unordered_map>
 
 #include "ConcurrentContainers.h"
 #include "DexClass.h"
@@ -15,6 +16,8 @@
 #include "FrameworkApi.h"
 #include "TypeUtil.h"
 
+class IRInstruction;
+
 // Helper class that checks if it's safe to use a type/method/field in
 // - the context of a particular store, and
 // - any context where we can only assume a particular min-sdk.
@@ -58,6 +61,15 @@ class RefChecker {
 
   bool is_in_primary_dex(const DexType* type) const;
 
+  /**
+   * Computes in parallel the verdicts for the classes of :scope, their fields
+   * and methods, and everything referenced by their code. Afterwards, these
+   * verdicts, along with all others computed so far, are looked up without
+   * taking any lock. This is the one function that is not thread-safe; it
+   * may be called again, e.g. for more scopes of the same store.
+   */
+  void precompute(const Scope& scope);
+
  private:
   XStoreRefs* m_xstores;
   size_t m_store_idx;
@@ -67,6 +79,13 @@ class RefChecker {
   mutable ConcurrentMap<const DexMethod*, boost::optional<bool>> m_method_cache;
   mutable ConcurrentMap<const DexField*, boost::optional<bool>> m_field_cache;
 
+  // Read-only in between calls to precompute().
+  std::unordered_map<const DexType*, bool> m_precomputed_types;
+  std::unordered_map<const DexMethod*, bool> m_precomputed_methods;
+  std::unordered_map<const DexField*, bool> m_precomputed_fields;
+
+  bool check_insn(const IRInstruction* insn, const DexMethod* method) const;
+
   bool check_type_internal(const DexType* type) const;
 
   bool check_method_internal(const DexMethod* method) const;
@@ -12,6 +12,7 @@
 #include <limits>
 #include <mutex>
 #include <string>
+#include <vector>
 
 #include "Debug.h"
 #include "KeepReason.h"
@@ -128,18 +129,17 @@ class ReferencedState {
       std::numeric_limits<InterdexSubgroupIdx>::max();
   InterdexSubgroupIdx m_interdex_subgroup{kNoSubgroup};
 
-  // Going through hoops here to reduce the size of ReferencedState while
-  // keeping memory requirements still small in non-default case.
-  struct KeepReasons {
-    std::mutex m_keep_reasons_mtx;
-    keep_reason::ReasonPtrSet m_keep_reasons;
-  };
-  mutable std::atomic<KeepReasons*> m_keep_reasons{nullptr};
+  // Keep reasons are not stored here but in RedexContext::keep_reasons(),
+  // keyed by the address of the ReferencedState.
 
  public:
   ReferencedState() = default;
   ReferencedState(const ReferencedState&) = delete;
-  ~ReferencedState() { delete m_keep_reasons.load(); }
+  ~ReferencedState() {
+    if (g_redex != nullptr && RedexContext::record_keep_reasons()) {
+      RedexContext::keep_reasons().forget(this);
+    }
+  }
 
   ReferencedState& operator=(const ReferencedState& other) {
     if (this != &other) {
@@ -249,7 +249,7 @@ class ReferencedState {
   void set_referenced_by_resource_xml() {
     inner_struct.m_by_resources = true;
     if (RedexContext::record_keep_reasons()) {
-      add_keep_reason(RedexContext::make_keep_reason(keep_reason::XML));
+      add_keep_reason(keep_reason::Reason(keep_reason::XML));
     }
   }
 
@@ -284,8 +284,7 @@ class ReferencedState {
     unset_allowshrinking();
     unset_allowobfuscation();
     if (RedexContext::record_keep_reasons()) {
-      add_keep_reason(
-          RedexContext::make_keep_reason(std::forward<Args>(args)...));
+      add_keep_reason(keep_reason::Reason(std::forward<Args>(args)...));
     }
   }
 
@@ -295,14 +294,13 @@ class ReferencedState {
     inner_struct.m_unset_allowobfuscation = false;
   }
 
-  const keep_reason::ReasonPtrSet& keep_reasons() const {
+  const std::vector<const keep_reason::Reason*>& keep_reasons() const {
     if (!RedexContext::record_keep_reasons()) {
       // We really should not allow this.
-      static keep_reason::ReasonPtrSet SINGLETON;
+      static std::vector<const keep_reason::Reason*> SINGLETON;
       return SINGLETON;
     }
-    auto& keep_reasons = ensure_keep_reasons();
-    return keep_reasons.m_keep_reasons;
+    return RedexContext::keep_reasons().reasons_of(this);
   }
 
   template <class... Args>
@@ -385,8 +383,7 @@ class ReferencedState {
   void set_has_keep(Args&&... args) {
     inner_struct.m_keep = true;
     if (RedexContext::record_keep_reasons()) {
-      add_keep_reason(
-          RedexContext::make_keep_reason(std::forward<Args>(args)...));
+      add_keep_reason(keep_reason::Reason(std::forward<Args>(args)...));
     }
   }
 
@@ -412,27 +409,9 @@ class ReferencedState {
     inner_struct.m_unset_allowobfuscation = true;
   }
 
-  KeepReasons& ensure_keep_reasons() const {
-    always_assert(RedexContext::record_keep_reasons());
-    // First see whether it's already done to avoid allocating.
-    auto attempt = m_keep_reasons.load();
-    if (attempt != nullptr) {
-      return *attempt;
-    }
-    // OK, allocate and CAS.
-    auto keep_reasons = std::make_unique<KeepReasons>();
-    KeepReasons* expected = nullptr;
-    if (m_keep_reasons.compare_exchange_strong(expected, keep_reasons.get())) {
-      return *keep_reasons.release();
-    }
-    return *expected;
-  }
-
-  void add_keep_reason(const keep_reason::Reason* reason) {
+  void add_keep_reason(const keep_reason::Reason& reason) {
     always_assert(RedexContext::record_keep_reasons());
-    auto& keep_reasons = ensure_keep_reasons();
-    std::lock_guard<std::mutex> lock(keep_reasons.m_keep_reasons_mtx);
-    keep_reasons.m_keep_reasons.emplace(reason);
+    RedexContext::keep_reasons().record(this, reason);
   }
 
   friend class keep_rules::impl::KeepState;
@@ -56,7 +56,7 @@ std::ostream& operator<<(std::ostream& out,
   }
   case reflection::STRING: {
     if (x.dex_string != nullptr) {
-      const std::string& str = x.dex_string->str();
+      const std::string str = x.dex_string->str_copy();
       if (str.empty()) {
         out << "\"\"";
       } else {
@@ -352,6 +352,10 @@ class AbstractObjectEnvironment final
     return get<0>().get(reg);
   }
 
+  const BasicAbstractObjectEnvironment& get_abstract_objs() const {
+    return get<0>();
+  }
+
   void set_abstract_obj(reg_t reg, const AbstractObjectDomain aobj) {
     apply<0>([=](auto env) { env->set(reg, aobj); }, true);
   }
@@ -744,7 +748,7 @@ class Analyzer final : public BaseIRAnalyzer<AbstractObjectEnvironment> {
           if (class_name->dex_string != nullptr) {
             auto internal_name =
                 DexString::make_string(java_names::external_to_internal(
-                    class_name->dex_string->str()));
+                    class_name->dex_string->str_copy()));
             current_state->set_abstract_obj(
                 RESULT_REGISTER,
                 AbstractObjectDomain(
@@ -785,6 +789,11 @@ class Analyzer final : public BaseIRAnalyzer<AbstractObjectEnvironment> {
     }
   }
 
+  const AbstractObjectEnvironment* get_environment(IRInstruction* insn) const {
+    auto it = m_environments.find(insn);
+    return it == m_environments.end() ? nullptr : &it->second;
+  }
+
   boost::optional<AbstractObject> get_abstract_object(
       size_t reg, IRInstruction* insn) const {
     auto it = m_environments.find(insn);
@@ -1100,11 +1109,17 @@ ReflectionAnalysis::ReflectionAnalysis(DexMethod* dex_method,
   m_analyzer->run(context);
 }
 
-void ReflectionAnalysis::get_reflection_site(
+namespace {
+
+/*
+ * Record the abstract object held by `reg` in `env` if it is the output of a
+ * reflective operation.
+ */
+void get_reflection_site(
     const reg_t reg,
-    IRInstruction* insn,
-    std::map<reg_t, ReflectionAbstractObject>* abstract_objects) const {
-  auto aobj = m_analyzer->get_abstract_object(reg, insn);
+    const impl::AbstractObjectEnvironment& env,
+    std::map<reg_t, ReflectionAbstractObject>* abstract_objects) {
+  auto aobj = env.get_abstract_obj(reg).get_object();
   if (!aobj) {
     return;
   }
@@ -1113,7 +1128,7 @@ void ReflectionAnalysis::get_reflection_site(
   }
   boost::optional<ClassObjectSource> cls_src =
       aobj->obj_kind == AbstractObjectKind::CLASS
-          ? m_analyzer->get_class_source(reg, insn)
+          ? env.get_class_source(reg).get_constant()
           : boost::none;
   if (aobj->obj_kind == AbstractObjectKind::CLASS &&
       cls_src == ClassObjectSource::NON_REFLECTION) {
@@ -1131,20 +1146,34 @@ void ReflectionAnalysis::get_reflection_site(
   (*abstract_objects)[reg] = ReflectionAbstractObject(*aobj, cls_src);
 }
 
+} // namespace
+
 ReflectionSites ReflectionAnalysis::get_reflection_sites() const {
   ReflectionSites reflection_sites;
   auto code = m_dex_method->get_code();
-  if (code == nullptr) {
+  if (code == nullptr || m_analyzer == nullptr) {
     return reflection_sites;
   }
   auto reg_size = code->get_registers_size();
   for (auto& mie : InstructionIterable(code)) {
     IRInstruction* insn = mie.insn;
+    const auto* env = m_analyzer->get_environment(insn);
+    if (env == nullptr) {
+      continue;
+    }
+    // Only the registers bound in the environment can hold an abstract
+    // object, so there is no need to probe every register of the method.
+    const auto& objects = env->get_abstract_objs();
+    if (!objects.is_value()) {
+      continue;
+    }
     std::map<reg_t, ReflectionAbstractObject> abstract_objects;
-    for (size_t i = 0; i < reg_size; i++) {
-      get_reflection_site(i, insn, &abstract_objects);
+    for (const auto& binding : objects.bindings()) {
+      reg_t reg = binding.first;
+      if (reg < reg_size || reg == RESULT_REGISTER) {
+        get_reflection_site(reg, *env, &abstract_objects);
+      }
     }
-    get_reflection_site(RESULT_REGISTER, insn, &abstract_objects);
 
     if (!abstract_objects.empty()) {
       reflection_sites.push_back(std::make_pair(insn, abstract_objects));
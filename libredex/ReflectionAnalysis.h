@@ -349,11 +349,6 @@ class ReflectionAnalysis final {
   const DexMethod* m_dex_method;
   std::unique_ptr<impl::Analyzer> m_analyzer;
   MetadataCache* m_fallback_cache = nullptr;
-
-  void get_reflection_site(
-      const reg_t reg,
-      IRInstruction* insn,
-      std::map<reg_t, ReflectionAbstractObject>* abstract_objects) const;
 };
 
 } // namespace reflection
@@ -328,3 +328,47 @@ inline DexField* resolve_field(const DexFieldRef* field,
   return resolve_field(field->get_class(), field->get_name(), field->get_type(),
                        search);
 }
+
+struct FieldRefCacheKey {
+  const DexFieldRef* field;
+  FieldSearch search;
+
+  bool operator==(const FieldRefCacheKey& other) const {
+    return field == other.field && search == other.search;
+  }
+};
+
+struct FieldRefCacheKeyHash {
+  std::size_t operator()(const FieldRefCacheKey& key) const {
+    std::size_t seed = 0;
+    boost::hash_combine(seed, key.field);
+    boost::hash_combine(
+        seed, static_cast<std::underlying_type_t<FieldSearch>>(key.search));
+    return seed;
+  }
+};
+
+using ConcurrentFieldRefCache =
+    ConcurrentMap<FieldRefCacheKey, DexField*, FieldRefCacheKeyHash>;
+
+/**
+ * Resolve a field and cache the mapping. Same behavior as the resolve_field
+ * above, but lookups of the same ref from different threads are resolved once.
+ */
+inline DexField* resolve_field(const DexFieldRef* field,
+                               FieldSearch search,
+                               ConcurrentFieldRefCache& concurrent_ref_cache) {
+  if (field->is_def()) {
+    return const_cast<DexField*>(static_cast<const DexField*>(field));
+  }
+  auto def =
+      concurrent_ref_cache.get(FieldRefCacheKey{field, search}, nullptr);
+  if (def != nullptr) {
+    return def;
+  }
+  auto fdef = resolve_field(field, search);
+  if (fdef != nullptr) {
+    concurrent_ref_cache.emplace(FieldRefCacheKey{field, search}, fdef);
+  }
+  return fdef;
+}
@@ -133,21 +133,20 @@ std::string show_type(const DexType* t, bool deobfuscated) {
         }
         auto name = t->get_name()->str();
         if (!deobfuscated) {
-          return name;
+          return std::string(name);
         }
         if (name[0] == 'L') {
-          auto deobf_name = name;
           auto cls = type_class(t);
           if (cls != nullptr && !cls->get_deobfuscated_name().empty()) {
-            deobf_name = cls->get_deobfuscated_name();
+            return cls->get_deobfuscated_name_copy();
           }
-          return deobf_name;
+          return std::string(name);
         } else if (name[0] == '[') {
           std::ostringstream ss;
           ss << '[' << self(self, DexType::get_type(name.substr(1)));
           return ss.str();
         }
-        return name;
+        return std::string(name);
       },
       t);
 }
@@ -160,7 +159,7 @@ std::string show_field(const DexFieldRef* ref, bool deobfuscated) {
   if (deobfuscated && ref->is_def()) {
     auto name = ref->as_def()->get_deobfuscated_name();
     if (!name.empty()) {
-      return name;
+      return std::string(name);
     }
   }
   string_builders::StaticStringBuilder<5> b;
@@ -200,7 +199,7 @@ std::string show_method(const DexMethodRef* ref, bool deobfuscated) {
   if (deobfuscated && ref->is_def()) {
     auto name = ref->as_def()->get_deobfuscated_name();
     if (!name.empty()) {
-      return name;
+      return std::string(name);
     }
   }
 
@@ -992,7 +991,7 @@ std::ostream& operator<<(std::ostream& o, const DexType& type) {
 
 inline std::string show(DexString* p) {
   if (!p) return "";
-  return p->str();
+  return p->str_copy();
 }
 
 inline std::string show(const DexType* t) { return show_type(t, false); }
@@ -1620,9 +1619,9 @@ std::string show_deobfuscated(const DexClass* cls) {
     return "";
   }
   if (cls->get_deobfuscated_name().empty()) {
-    return cls->get_name() ? cls->get_name()->str() : show(cls);
+    return cls->get_name() ? cls->get_name()->str_copy() : show(cls);
   }
-  return cls->get_deobfuscated_name();
+  return cls->get_deobfuscated_name_copy();
 }
 
 std::string show_deobfuscated(const DexFieldRef* ref) {
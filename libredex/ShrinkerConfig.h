@@ -23,6 +23,11 @@ struct ShrinkerConfig {
   bool run_fast_reg_alloc{false};
   bool run_dedup_blocks{false};
 
+  // Repeat all stages on a method until its code stops changing, but at most
+  // this many times. Methods that the profiles say are cold only get a single
+  // round.
+  size_t max_rounds{1};
+
   // Internally used option that decides whether to compute pure methods with a
   // relatively expensive analysis over the scope
   bool compute_pure_methods{true};
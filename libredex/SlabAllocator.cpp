@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "SlabAllocator.h"
+
+#include <array>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "Sanitizers.h"
+
+namespace slab_allocator {
+
+namespace {
+
+// Sizes are rounded up to a multiple of the granularity, which also keeps all
+// objects suitably aligned.
+constexpr size_t kGranularity = alignof(std::max_align_t);
+constexpr size_t kMaxSize = 256;
+constexpr size_t kNumClasses = kMaxSize / kGranularity;
+constexpr size_t kSlabSize = 64 * 1024;
+// Number of objects moved between a thread and the global free list at once.
+constexpr size_t kBatchSize = 256;
+
+struct FreeNode {
+  FreeNode* next;
+};
+
+struct FreeList {
+  FreeNode* head{nullptr};
+  size_t count{0};
+
+  void push(void* ptr) {
+    auto* node = static_cast<FreeNode*>(ptr);
+    node->next = head;
+    head = node;
+    ++count;
+  }
+
+  void* pop() {
+    auto* node = head;
+    head = node->next;
+    --count;
+    return node;
+  }
+
+  // Move up to `n` objects to `other`.
+  void move_to(FreeList* other, size_t n) {
+    while (head != nullptr && n-- > 0) {
+      other->push(pop());
+    }
+  }
+};
+
+struct SizeClass {
+  std::mutex lock;
+  FreeList free_list;
+  std::vector<std::unique_ptr<char[]>> slabs;
+};
+
+std::array<SizeClass, kNumClasses>& size_classes() {
+  // Intentionally never destroyed, as threads may hand back their free lists
+  // during static destruction.
+  static auto* classes = new std::array<SizeClass, kNumClasses>();
+  return *classes;
+}
+
+size_t class_index(size_t size) { return (size - 1) / kGranularity; }
+
+// Trivially destructible, so that it stays usable during thread teardown.
+thread_local std::array<FreeList, kNumClasses> t_free_lists;
+thread_local bool t_flushed = false;
+
+void flush_thread_free_lists() {
+  auto& classes = size_classes();
+  for (size_t i = 0; i < kNumClasses; ++i) {
+    auto& local = t_free_lists[i];
+    if (local.count == 0) {
+      continue;
+    }
+    std::lock_guard<std::mutex> guard(classes[i].lock);
+    local.move_to(&classes[i].free_list, local.count);
+  }
+}
+
+struct ThreadFlusher {
+  ~ThreadFlusher() {
+    flush_thread_free_lists();
+    t_flushed = true;
+  }
+};
+
+FreeList& thread_free_list(size_t idx) {
+  // Registers the flush on thread exit the first time a thread gets here.
+  thread_local ThreadFlusher flusher;
+  (void)flusher;
+  return t_free_lists[idx];
+}
+
+void refill(size_t idx, FreeList* local) {
+  auto& size_class = size_classes()[idx];
+  std::lock_guard<std::mutex> guard(size_class.lock);
+  if (size_class.free_list.count > 0) {
+    size_class.free_list.move_to(local, kBatchSize);
+    return;
+  }
+  const size_t object_size = (idx + 1) * kGranularity;
+  const size_t num_objects = kSlabSize / object_size;
+  size_class.slabs.emplace_back(new char[num_objects * object_size]);
+  char* slab = size_class.slabs.back().get();
+  // Push in reverse, so that objects are handed out in address order.
+  for (size_t i = num_objects; i > 0; --i) {
+    local->push(slab + (i - 1) * object_size);
+  }
+}
+
+} // namespace
+
+bool is_enabled() {
+  static const bool enabled =
+      !sanitizers::kIsAsan && getenv("REDEX_DISABLE_SLAB_ALLOCATOR") == nullptr;
+  return enabled;
+}
+
+void* allocate(size_t size) {
+  if (size == 0 || size > kMaxSize || !is_enabled()) {
+    return ::operator new(size);
+  }
+  const size_t idx = class_index(size);
+  if (t_flushed) {
+    // Objects of a full size class may join the free lists like any other.
+    return ::operator new((idx + 1) * kGranularity);
+  }
+  auto& local = thread_free_list(idx);
+  if (local.count == 0) {
+    refill(idx, &local);
+  }
+  return local.pop();
+}
+
+void deallocate(void* ptr, size_t size) {
+  if (ptr == nullptr) {
+    return;
+  }
+  if (size == 0 || size > kMaxSize || !is_enabled()) {
+    ::operator delete(ptr);
+    return;
+  }
+  const size_t idx = class_index(size);
+  if (t_flushed) {
+    auto& size_class = size_classes()[idx];
+    std::lock_guard<std::mutex> guard(size_class.lock);
+    size_class.free_list.push(ptr);
+    return;
+  }
+  auto& local = thread_free_list(idx);
+  local.push(ptr);
+  if (local.count > 2 * kBatchSize) {
+    auto& size_class = size_classes()[idx];
+    std::lock_guard<std::mutex> guard(size_class.lock);
+    local.move_to(&size_class.free_list, kBatchSize);
+  }
+}
+
+} // namespace slab_allocator
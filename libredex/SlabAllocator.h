@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+/*
+ * A size-class allocator for the small objects that make up method bodies
+ * (IRInstruction, MethodItemEntry, DexPosition, SourceBlock). Redex creates
+ * and destroys millions of these while ballooning code and building and
+ * linearizing CFGs, and they tend to be accessed together.
+ *
+ * Objects are carved out of large slabs, so that objects allocated in
+ * sequence sit next to each other in memory. Freed objects go to a free list
+ * of the freeing thread, which is handed back in batches to a global free
+ * list when it grows too large or the thread exits. Slabs are never returned
+ * to the system.
+ *
+ * Classes opt in by defining their class-specific operator new and delete in
+ * terms of allocate() and deallocate(). The allocator is disabled, and simply
+ * forwards to the global operators, under AddressSanitizer (which would no
+ * longer see use-after-free errors) or when the REDEX_DISABLE_SLAB_ALLOCATOR
+ * environment variable is set.
+ */
+namespace slab_allocator {
+
+void* allocate(size_t size);
+
+void deallocate(void* ptr, size_t size);
+
+bool is_enabled();
+
+} // namespace slab_allocator
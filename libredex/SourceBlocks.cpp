@@ -7,6 +7,7 @@
 
 #include "SourceBlocks.h"
 
+#include <algorithm>
 #include <limits>
 #include <optional>
 #include <sstream>
@@ -397,4 +398,34 @@ InsertResult insert_source_blocks(DexMethod* method,
   return {helper.id, helper.oss.str(), !had_failures};
 }
 
+bool is_cold(const cfg::Block* b) { return is_cold(get_first_source_block(b)); }
+
+bool is_cold(const SourceBlock* sb) {
+  if (sb == nullptr || sb->vals.empty()) {
+    return false;
+  }
+  return !sb->foreach_val_early(
+      [](const auto& val) { return !val || val->val > 0; });
+}
+
+std::vector<Block*> ColdLastLinearizationStrategy::order(
+    ControlFlowGraph& cfg, WeakTopologicalOrdering<BlockChain*> wto) {
+  std::vector<Block*> hot;
+  std::vector<Block*> cold;
+  hot.reserve(cfg.num_blocks());
+  // The WTO starts with the chain of the entry block, which must stay first.
+  bool is_entry_chain = true;
+  wto.visit_depth_first([&](BlockChain* chain) {
+    bool cold_chain =
+        !is_entry_chain &&
+        std::all_of(chain->begin(), chain->end(),
+                    [](const Block* b) { return is_cold(b); });
+    is_entry_chain = false;
+    auto& out = cold_chain ? cold : hot;
+    out.insert(out.end(), chain->begin(), chain->end());
+  });
+  hot.insert(hot.end(), cold.begin(), cold.end());
+  return hot;
+}
+
 } // namespace source_blocks
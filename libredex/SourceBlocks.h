@@ -235,4 +235,24 @@ inline const SourceBlock* get_first_source_block(const cfg::Block* b) {
   return nullptr;
 }
 
+// A block is cold if its profile values say it was never executed in any
+// interaction. Blocks without (complete) profile values are not cold.
+bool is_cold(const cfg::Block* b);
+bool is_cold(const SourceBlock* sb);
+
+/*
+ * A linearization strategy that moves the chains of cold blocks to the end of
+ * the method. The other chains keep the weak topological order of the default
+ * linearization, which already lays out loop bodies contiguously, so that the
+ * hot paths through a method end up next to each other.
+ *
+ * Pass an instance to `IRCode::clear_cfg` to use it.
+ */
+class ColdLastLinearizationStrategy final : public cfg::LinearizationStrategy {
+ public:
+  std::vector<cfg::Block*> order(
+      cfg::ControlFlowGraph& cfg,
+      sparta::WeakTopologicalOrdering<cfg::BlockChain*> wto) override;
+};
+
 } // namespace source_blocks
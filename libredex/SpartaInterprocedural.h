@@ -63,7 +63,9 @@ class MethodSummaryRegistry : public sparta::AbstractRegistry {
     return m_map.get(method, default_value);
   }
 
-  // returns true if the entry exists.
+  // returns true if the entry exists. This always counts as an update, so the
+  // global fixpoint keeps iterating; prefer `maybe_update` when the summary
+  // may be unchanged.
   bool update(const DexMethod* method,
               std::function<Summary(const Summary&)> updater) {
     bool entry_exists;
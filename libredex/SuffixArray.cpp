@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "SuffixArray.h"
+
+#include <algorithm>
+
+#include "Debug.h"
+
+namespace suffix_array {
+
+namespace {
+
+// Stable counting sort of `in` by `keys[in[i]]` into `out`.
+void counting_sort(const std::vector<uint32_t>& in,
+                   const std::vector<uint32_t>& keys,
+                   uint32_t num_keys,
+                   std::vector<uint32_t>* counts,
+                   std::vector<uint32_t>* out) {
+  counts->assign(num_keys + 1, 0);
+  for (auto i : in) {
+    (*counts)[keys[i] + 1]++;
+  }
+  for (uint32_t k = 1; k <= num_keys; ++k) {
+    (*counts)[k] += (*counts)[k - 1];
+  }
+  for (auto i : in) {
+    (*out)[(*counts)[keys[i]]++] = i;
+  }
+}
+
+} // namespace
+
+std::vector<uint32_t> build(const std::vector<uint32_t>& str,
+                            uint32_t alphabet_size) {
+  const uint32_t n = str.size();
+  std::vector<uint32_t> sa(n);
+  if (n == 0) {
+    return sa;
+  }
+  std::vector<uint32_t> rank(str);
+  std::vector<uint32_t> tmp(n);
+  std::vector<uint32_t> counts;
+  for (uint32_t i = 0; i < n; ++i) {
+    always_assert(str[i] < alphabet_size);
+    tmp[i] = i;
+  }
+  counting_sort(tmp, rank, alphabet_size, &counts, &sa);
+
+  // Compact the initial ranks so that they are dense.
+  uint32_t num_ranks = 1;
+  tmp[sa[0]] = 0;
+  for (uint32_t i = 1; i < n; ++i) {
+    if (str[sa[i]] != str[sa[i - 1]]) {
+      num_ranks++;
+    }
+    tmp[sa[i]] = num_ranks - 1;
+  }
+  rank.swap(tmp);
+
+  std::vector<uint32_t> by_second(n);
+  for (uint32_t k = 1; num_ranks < n; k *= 2) {
+    // Order by the rank of the second half: suffixes without a second half
+    // come first, then the others in the order of their second half.
+    uint32_t j = 0;
+    for (uint32_t i = n - k; i < n; ++i) {
+      by_second[j++] = i;
+    }
+    for (auto i : sa) {
+      if (i >= k) {
+        by_second[j++] = i - k;
+      }
+    }
+    counting_sort(by_second, rank, num_ranks, &counts, &sa);
+
+    auto second_rank = [&](uint32_t i) -> int64_t {
+      return i + k < n ? rank[i + k] : -1;
+    };
+    num_ranks = 1;
+    tmp[sa[0]] = 0;
+    for (uint32_t i = 1; i < n; ++i) {
+      if (rank[sa[i]] != rank[sa[i - 1]] ||
+          second_rank(sa[i]) != second_rank(sa[i - 1])) {
+        num_ranks++;
+      }
+      tmp[sa[i]] = num_ranks - 1;
+    }
+    rank.swap(tmp);
+    if (k >= n) {
+      break;
+    }
+  }
+  return sa;
+}
+
+std::vector<uint32_t> lcp(const std::vector<uint32_t>& str,
+                          const std::vector<uint32_t>& sa) {
+  // Kasai et al.
+  const uint32_t n = str.size();
+  always_assert(sa.size() == n);
+  std::vector<uint32_t> rank(n);
+  for (uint32_t i = 0; i < n; ++i) {
+    rank[sa[i]] = i;
+  }
+  std::vector<uint32_t> res(n, 0);
+  uint32_t h = 0;
+  for (uint32_t i = 0; i < n; ++i) {
+    if (rank[i] == 0) {
+      h = 0;
+      continue;
+    }
+    uint32_t j = sa[rank[i] - 1];
+    while (i + h < n && j + h < n && str[i + h] == str[j + h]) {
+      h++;
+    }
+    res[rank[i]] = h;
+    if (h > 0) {
+      h--;
+    }
+  }
+  return res;
+}
+
+} // namespace suffix_array
@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace suffix_array {
+
+/*
+ * Returns the suffix array of `str`, i.e. the start positions of all suffixes
+ * in lexicographic order. All symbols must be less than `alphabet_size`.
+ *
+ * This uses prefix doubling with radix sorting, which takes O(n log n) time
+ * and a few words of memory per symbol.
+ */
+std::vector<uint32_t> build(const std::vector<uint32_t>& str,
+                            uint32_t alphabet_size);
+
+/*
+ * Returns the longest common prefix array of `str` for its suffix array `sa`:
+ * element i is the length of the longest common prefix of the suffixes at
+ * sa[i - 1] and sa[i], and element 0 is zero.
+ */
+std::vector<uint32_t> lcp(const std::vector<uint32_t>& str,
+                          const std::vector<uint32_t>& sa);
+
+} // namespace suffix_array
@@ -7,15 +7,38 @@
 
 #include "Timer.h"
 
+#include "Debug.h"
+#include "JemallocUtil.h"
 #include "Trace.h"
 
 unsigned Timer::s_indent = 0;
 std::mutex Timer::s_lock;
 Timer::times_t Timer::s_times;
+std::atomic<bool> Timer::s_trace_enabled{false};
+Timer::TraceEvents Timer::s_trace_events;
+
+namespace {
+
+const auto s_process_start = std::chrono::high_resolution_clock::now();
+
+uint32_t current_thread_id() {
+  // Small sequential ids read better in trace viewers than native ones.
+  static std::atomic<uint32_t> s_next_id{0};
+  thread_local uint32_t id = s_next_id++;
+  return id;
+}
+
+} // namespace
 
 Timer::Timer(const std::string& msg)
     : m_msg(msg), m_start(std::chrono::high_resolution_clock::now()) {
   ++s_indent;
+  if (s_trace_enabled) {
+    m_trace = true;
+    m_cpu_start = std::clock();
+    m_vm_hwm_start = get_mem_stats().vm_hwm;
+    m_allocated_start = jemalloc_util::get_allocated_bytes();
+  }
 }
 
 Timer::~Timer() {
@@ -25,6 +48,30 @@ Timer::~Timer() {
   TRACE(TIME, 1, "%*s%s completed in %.1lf seconds", 4 * s_indent, "",
         m_msg.c_str(), duration_s);
 
+  if (m_trace) {
+    auto to_us = [](auto duration) {
+      return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+                 duration)
+          .count();
+    };
+    auto cpu_us = (uint64_t)((double)(std::clock() - m_cpu_start) * 1000000 /
+                             CLOCKS_PER_SEC);
+    auto vm_hwm_delta = (int64_t)(get_mem_stats().vm_hwm - m_vm_hwm_start);
+    auto allocated_delta =
+        (int64_t)(jemalloc_util::get_allocated_bytes() - m_allocated_start);
+
+    std::lock_guard<std::mutex> guard(s_lock);
+    auto& events = s_trace_events;
+    events.names.push_back(m_msg);
+    events.start_us.push_back(to_us(m_start - s_process_start));
+    events.wall_us.push_back(to_us(end - m_start));
+    events.cpu_us.push_back(cpu_us);
+    events.vm_hwm_delta.push_back(vm_hwm_delta);
+    events.allocated_delta.push_back(allocated_delta);
+    events.thread_ids.push_back(current_thread_id());
+    events.depths.push_back(s_indent);
+  }
+
   Timer::add_timer(std::move(m_msg), duration_s);
 }
 
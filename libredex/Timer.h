@@ -9,6 +9,8 @@
 
 #include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <ctime>
 #include <mutex>
 #include <string>
 #include <utility>
@@ -24,12 +26,41 @@ struct Timer {
 
   static void add_timer(std::string&& msg, double dur_s);
 
+  // Detailed telemetry of every Timer scope, stored column-wise. Only
+  // collected after enable_trace_events(true), as sampling memory stats is
+  // not free.
+  struct TraceEvents {
+    std::vector<std::string> names;
+    // Microseconds since the start of the process.
+    std::vector<uint64_t> start_us;
+    std::vector<uint64_t> wall_us;
+    // Process CPU time spent during the scope, summed over all threads.
+    std::vector<uint64_t> cpu_us;
+    std::vector<int64_t> vm_hwm_delta;
+    // Change in bytes allocated through jemalloc, if it is present.
+    std::vector<int64_t> allocated_delta;
+    std::vector<uint32_t> thread_ids;
+    std::vector<uint32_t> depths;
+
+    size_t size() const { return names.size(); }
+  };
+
+  static void enable_trace_events(bool enable) { s_trace_enabled = enable; }
+  // there should be no currently running Timers when this function is called
+  static const TraceEvents& get_trace_events() { return s_trace_events; }
+
  private:
   static std::mutex s_lock;
   static times_t s_times;
   static unsigned s_indent;
+  static std::atomic<bool> s_trace_enabled;
+  static TraceEvents s_trace_events;
   std::string m_msg;
   std::chrono::high_resolution_clock::time_point m_start;
+  bool m_trace{false};
+  std::clock_t m_cpu_start{0};
+  uint64_t m_vm_hwm_start{0};
+  uint64_t m_allocated_start{0};
 };
 
 // An accumulating thread-safe timer with a scope-based approach.
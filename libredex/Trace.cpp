@@ -35,6 +35,7 @@ struct Tracer {
 
   bool m_show_timestamps{false};
   bool m_show_tracemodule{false};
+  bool m_buffered{false};
   const char* m_method_filter;
   std::unordered_map<int /*TraceModule*/, std::string> m_module_id_name_map;
 
@@ -43,6 +44,7 @@ struct Tracer {
     const char* envfile = getenv("TRACEFILE");
     const char* show_timestamps = getenv("SHOW_TIMESTAMPS");
     const char* show_tracemodule = getenv("SHOW_TRACEMODULE");
+    const char* buffered = getenv("TRACE_BUFFERED");
     m_method_filter = getenv("TRACE_METHOD_FILTER");
     if (!traceenv) {
       init_trace_file(nullptr);
@@ -61,6 +63,8 @@ struct Tracer {
     std::cerr << "TRACE_METHOD_FILTER="
               << (m_method_filter == nullptr ? "" : m_method_filter)
               << std::endl;
+    std::cerr << "TRACE_BUFFERED=" << (buffered == nullptr ? "" : buffered)
+              << std::endl;
 
     init_trace_modules(traceenv);
     init_trace_file(envfile);
@@ -71,6 +75,9 @@ struct Tracer {
     if (show_tracemodule) {
       m_show_tracemodule = true;
     }
+    if (buffered) {
+      m_buffered = true;
+    }
 
 #define TM(x) m_module_id_name_map[static_cast<int>(x)] = #x;
     TMS
@@ -114,18 +121,13 @@ struct Tracer {
              va_list ap) {
     // Assume that `trace` is never called without `traceEnabled`, so we
     // do not need to check anything (including context) here.
+    if (m_buffered) {
+      trace_buffered(module, level, suppress_newline, fmt, ap);
+      return;
+    }
     std::lock_guard<std::mutex> guard(m_trace_mutex);
     if (m_show_timestamps) {
-      auto t = std::time(nullptr);
-      struct tm local_tm;
-#if IS_WINDOWS
-      localtime_s(&local_tm, &t);
-#else
-      localtime_r(&t, &local_tm);
-#endif
-      std::array<char, 40> buf;
-      std::strftime(buf.data(), sizeof(buf), "%c", &local_tm);
-      fprintf(m_file, "[%s]", buf.data());
+      fprintf(m_file, "[%s]", timestamp().data());
       if (!m_show_tracemodule) {
         fprintf(m_file, " ");
       }
@@ -140,7 +142,81 @@ struct Tracer {
     fflush(m_file);
   }
 
+  // Writes out and clears the trace lines a thread has buffered.
+  void flush(std::string* buffer) {
+    if (buffer->empty()) {
+      return;
+    }
+    std::lock_guard<std::mutex> guard(m_trace_mutex);
+    fwrite(buffer->data(), 1, buffer->size(), m_file);
+    fflush(m_file);
+    buffer->clear();
+  }
+
  private:
+  // With TRACE_BUFFERED set, each thread formats its trace lines into its own
+  // buffer, without taking any lock, and only writes them out in large chunks
+  // -- when the buffer fills up, and when the thread exits. Lines of different
+  // threads get grouped by thread, and lines that are still buffered when the
+  // process crashes are lost.
+  static constexpr size_t FLUSH_THRESHOLD = 64 * 1024;
+
+  struct ThreadBuffer {
+    std::string data;
+    ~ThreadBuffer();
+  };
+
+  void trace_buffered(TraceModule module,
+                      int level,
+                      bool suppress_newline,
+                      const char* fmt,
+                      va_list ap) {
+    thread_local ThreadBuffer thread_buffer;
+    auto& buffer = thread_buffer.data;
+    if (m_show_timestamps) {
+      buffer += '[';
+      buffer += timestamp().data();
+      buffer += m_show_tracemodule ? "]" : "] ";
+    }
+    if (m_show_tracemodule) {
+      buffer += '[';
+      buffer += m_module_id_name_map.at(module);
+      buffer += ':';
+      buffer += std::to_string(level);
+      buffer += "] ";
+    }
+    va_list ap_copy;
+    va_copy(ap_copy, ap);
+    int size = vsnprintf(nullptr, 0, fmt, ap_copy);
+    va_end(ap_copy);
+    if (size > 0) {
+      auto offset = buffer.size();
+      // vsnprintf needs room for its terminating null character.
+      buffer.resize(offset + size + 1);
+      vsnprintf(&buffer[offset], size + 1, fmt, ap);
+      buffer.resize(offset + size);
+    }
+    if (!suppress_newline) {
+      buffer += '\n';
+    }
+    if (buffer.size() >= FLUSH_THRESHOLD) {
+      flush(&buffer);
+    }
+  }
+
+  static std::array<char, 40> timestamp() {
+    auto t = std::time(nullptr);
+    struct tm local_tm;
+#if IS_WINDOWS
+    localtime_s(&local_tm, &t);
+#else
+    localtime_r(&t, &local_tm);
+#endif
+    std::array<char, 40> buf;
+    std::strftime(buf.data(), sizeof(buf), "%c", &local_tm);
+    return buf;
+  }
+
   void init_trace_modules(const char* traceenv) {
     std::unordered_map<std::string, int> module_id_map{{
 #define TM(x) {std::string(#x), x},
@@ -205,6 +281,9 @@ struct Tracer {
 };
 
 static Tracer tracer;
+
+Tracer::ThreadBuffer::~ThreadBuffer() { tracer.flush(&data); }
+
 } // namespace
 
 #ifndef NDEBUG
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "TypeInferenceCache.h"
+
+#include <boost/functional/hash.hpp>
+
+#include "ControlFlow.h"
+#include "IRCode.h"
+#include "IRInstruction.h"
+#include "Walkers.h"
+
+namespace {
+
+void combine_insn(size_t& seed, const IRInstruction* insn) {
+  // The environments are keyed by instruction, so identity matters too.
+  boost::hash_combine(seed, insn);
+  boost::hash_combine(seed, (uint16_t)insn->opcode());
+  for (auto src : insn->srcs()) {
+    boost::hash_combine(seed, src);
+  }
+  if (insn->has_dest()) {
+    boost::hash_combine(seed, insn->dest());
+  }
+  if (insn->has_literal()) {
+    boost::hash_combine(seed, insn->get_literal());
+  } else if (insn->has_type()) {
+    boost::hash_combine(seed, insn->get_type());
+  } else if (insn->has_field()) {
+    auto* field = insn->get_field();
+    boost::hash_combine(seed, field);
+    boost::hash_combine(seed, field->get_type());
+  } else if (insn->has_method()) {
+    auto* method = insn->get_method();
+    boost::hash_combine(seed, method);
+    boost::hash_combine(seed, method->get_proto());
+  }
+}
+
+// Blocks are identified by their first instruction, rather than by their id
+// or position, so that the fingerprint survives linearizing and rebuilding the
+// CFG. Empty blocks are identified by their successors.
+const IRInstruction* first_insn(cfg::Block* block) {
+  for (auto& mie : InstructionIterable(block)) {
+    return mie.insn;
+  }
+  return nullptr;
+}
+
+size_t block_key(cfg::Block* block) {
+  if (auto* insn = first_insn(block)) {
+    return boost::hash_value(insn);
+  }
+  size_t seed = 1;
+  for (auto* edge : block->succs()) {
+    boost::hash_combine(seed, first_insn(edge->target()));
+  }
+  return seed;
+}
+
+size_t fingerprint(const DexMethod* method, const cfg::ControlFlowGraph& cfg) {
+  size_t seed = 0;
+  boost::hash_combine(seed, method->get_class());
+  boost::hash_combine(seed, method->get_proto());
+  boost::hash_combine(seed, is_static(method));
+  boost::hash_combine(seed, cfg.editable());
+  boost::hash_combine(seed, cfg.get_registers_size());
+  boost::hash_combine(seed, block_key(cfg.entry_block()));
+
+  // Blocks are combined independently of their order.
+  size_t blocks_hash = 0;
+  for (auto* block : cfg.blocks()) {
+    size_t block_seed = block_key(block);
+    for (auto& mie : InstructionIterable(block)) {
+      combine_insn(block_seed, mie.insn);
+    }
+    for (auto* edge : block->succs()) {
+      boost::hash_combine(block_seed, (uint8_t)edge->type());
+      boost::hash_combine(block_seed, block_key(edge->target()));
+      if (edge->type() == cfg::EDGE_THROW) {
+        boost::hash_combine(block_seed, edge->throw_info()->catch_type);
+        boost::hash_combine(block_seed, edge->throw_info()->index);
+      } else if (edge->case_key()) {
+        boost::hash_combine(block_seed, *edge->case_key());
+      }
+    }
+    blocks_hash += block_seed;
+  }
+  boost::hash_combine(seed, blocks_hash);
+  return seed;
+}
+
+} // namespace
+
+namespace type_inference {
+
+std::shared_ptr<const CachedTypeEnvironments> get_type_environments(
+    const cfg::ControlFlowGraph& cfg,
+    const DexMethod* method,
+    bool skip_check_cast_to_intf) {
+  const auto* code = method->get_code();
+  bool cacheable =
+      code != nullptr && code->cfg_built() && &code->cfg() == &cfg;
+  auto fp = fingerprint(method, cfg);
+  if (cacheable) {
+    const auto& cached = code->get_cached_type_environments();
+    if (cached != nullptr && cached->fingerprint == fp &&
+        cached->skip_check_cast_to_intf == skip_check_cast_to_intf) {
+      return cached;
+    }
+  }
+
+  TypeInference inference(cfg, skip_check_cast_to_intf);
+  inference.run(method);
+  auto envs = std::make_shared<CachedTypeEnvironments>();
+  envs->fingerprint = fp;
+  envs->skip_check_cast_to_intf = skip_check_cast_to_intf;
+  envs->type_envs = std::move(inference.get_type_environments());
+  if (cacheable) {
+    code->set_cached_type_environments(envs);
+  }
+  return envs;
+}
+
+std::shared_ptr<const CachedTypeEnvironments> get_type_environments(
+    const DexMethod* method, bool skip_check_cast_to_intf) {
+  const auto* code = method->get_code();
+  always_assert(code->cfg_built());
+  return get_type_environments(code->cfg(), method, skip_check_cast_to_intf);
+}
+
+void populate_type_environments(const Scope& scope) {
+  walk::parallel::code(scope, [](DexMethod* method, IRCode& code) {
+    if (code.cfg_built()) {
+      get_type_environments(method);
+      return;
+    }
+    code.build_cfg(/* editable */ true);
+    get_type_environments(method);
+    code.clear_cfg();
+  });
+}
+
+void clear_type_environments(const Scope& scope) {
+  walk::parallel::methods(scope, [](DexMethod* method) {
+    // Spilled code has no environments attached; don't bring it back.
+    if (method->is_code_spilled()) {
+      return;
+    }
+    if (auto* code = method->get_code()) {
+      code->clear_cached_type_environments();
+    }
+  });
+}
+
+} // namespace type_inference
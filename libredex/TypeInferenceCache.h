@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+
+#include "DexClass.h"
+#include "TypeInference.h"
+
+namespace type_inference {
+
+using TypeEnvironments =
+    std::unordered_map<const IRInstruction*, TypeEnvironment>;
+
+/*
+ * The result of running TypeInference on a method, kept with the method's
+ * IRCode so that the analyses and transformations of a pass that all need the
+ * types of the same method don't each rerun the inference.
+ *
+ * The environments are tagged with a fingerprint of the CFG they were computed
+ * on, covering the identity and contents of all instructions, the edges, and
+ * the method signature. There are no mutation hooks in the CFG or in
+ * IRInstruction to drop the environments eagerly, so they are checked against
+ * the current CFG on every lookup instead, and recomputed when anything
+ * changed. Types of referenced members and the class hierarchy are not part of
+ * the fingerprint; the PassManager drops all cached environments after each
+ * pass.
+ */
+struct CachedTypeEnvironments {
+  size_t fingerprint;
+  bool skip_check_cast_to_intf;
+  TypeEnvironments type_envs;
+};
+
+/*
+ * Returns the type environments of the given CFG of the method. If it is the
+ * CFG of the method's code, the ones attached to its IRCode are reused if they
+ * are still current, or are replaced otherwise. Not thread-safe for the same
+ * method.
+ */
+std::shared_ptr<const CachedTypeEnvironments> get_type_environments(
+    const cfg::ControlFlowGraph& cfg,
+    const DexMethod* method,
+    bool skip_check_cast_to_intf = false);
+
+/*
+ * Same as above, for the CFG of the method's code, which must be built.
+ */
+std::shared_ptr<const CachedTypeEnvironments> get_type_environments(
+    const DexMethod* method, bool skip_check_cast_to_intf = false);
+
+/*
+ * Computes the type environments of all methods in the scope in parallel and
+ * attaches them to their IRCode. Methods without a CFG get an editable one
+ * built for the duration of the inference.
+ */
+void populate_type_environments(const Scope& scope);
+
+/*
+ * Drops the type environments attached to all methods in the scope.
+ */
+void clear_type_environments(const Scope& scope);
+
+} // namespace type_inference
@@ -186,6 +186,23 @@ void TypeSystem::make_instanceof_interfaces_table() {
   for (const auto& root : no_parents) {
     make_interfaces_table(root);
   }
+  for (const auto& root : no_parents) {
+    make_preorder_intervals(root);
+  }
+}
+
+void TypeSystem::make_preorder_intervals(const DexType* type) {
+  uint32_t begin = m_preorder.size();
+  m_preorder.push_back(type);
+  const auto& hierarchy = m_class_scopes.get_class_hierarchy();
+  const auto& children = hierarchy.find(type);
+  if (children != hierarchy.end()) {
+    for (const auto& child : children->second) {
+      make_preorder_intervals(child);
+    }
+  }
+  uint32_t end = m_preorder.size();
+  m_preorder_intervals.emplace(type, PreorderInterval{begin, end});
 }
 
 void TypeSystem::make_interfaces_table(const DexType* type) {
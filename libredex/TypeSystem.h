@@ -39,6 +39,16 @@ class TypeSystem {
   InstanceOfTable m_instanceof_table;
   TypeToTypeSet m_interfaces;
 
+  // The class hierarchy numbered in pre-order: the subtree rooted at a type
+  // occupies the interval [begin, end) of m_preorder, with the type itself at
+  // begin.
+  struct PreorderInterval {
+    uint32_t begin;
+    uint32_t end;
+  };
+  std::vector<const DexType*> m_preorder;
+  std::unordered_map<const DexType*, PreorderInterval> m_preorder_intervals;
+
  public:
   explicit TypeSystem(const Scope& scope);
 
@@ -58,8 +68,13 @@ class TypeSystem {
    * The type must be a class (not an interface).
    */
   void get_all_children(const DexType* type, TypeSet& children) const {
-    return ::get_all_children(
-        m_class_scopes.get_class_hierarchy(), type, children);
+    const auto& it = m_preorder_intervals.find(type);
+    if (it == m_preorder_intervals.end()) {
+      return ::get_all_children(
+          m_class_scopes.get_class_hierarchy(), type, children);
+    }
+    children.insert(m_preorder.begin() + it->second.begin + 1,
+                    m_preorder.begin() + it->second.end);
   }
 
   /**
@@ -106,16 +121,14 @@ class TypeSystem {
    * The type must be a class (not an interface).
    */
   bool is_subtype(const DexType* parent, const DexType* child) const {
-    const auto& parent_it = m_instanceof_table.find(parent);
-    const auto& child_it = m_instanceof_table.find(child);
-    if (parent_it == m_instanceof_table.end() ||
-        child_it == m_instanceof_table.end()) {
+    const auto& parent_it = m_preorder_intervals.find(parent);
+    const auto& child_it = m_preorder_intervals.find(child);
+    if (parent_it == m_preorder_intervals.end() ||
+        child_it == m_preorder_intervals.end()) {
       return false;
     }
-    const auto& p_chain = parent_it->second;
-    const auto& c_chain = child_it->second;
-    if (p_chain.size() > c_chain.size()) return false;
-    return c_chain.at(p_chain.size() - 1) == parent;
+    return parent_it->second.begin <= child_it->second.begin &&
+           child_it->second.begin < parent_it->second.end;
   }
 
   /**
@@ -223,4 +236,5 @@ class TypeSystem {
  private:
   void make_instanceof_interfaces_table();
   void make_interfaces_table(const DexType* type);
+  void make_preorder_intervals(const DexType* type);
 };
@@ -242,7 +242,7 @@ std::string get_package_name(const DexType* type) {
   if (pos == std::string::npos) {
     return "";
   }
-  return name.substr(0, pos + 1);
+  return std::string(name.substr(0, pos + 1));
 }
 
 bool same_package(const DexType* type1, const DexType* type2) {
@@ -253,7 +253,7 @@ bool same_package(const DexType* type1, const DexType* type2) {
 }
 
 std::string get_simple_name(const DexType* type) {
-  return java_names::internal_to_simple(type->str());
+  return java_names::internal_to_simple(type->str_copy());
 }
 
 uint32_t get_array_level(const DexType* type) {
@@ -292,7 +292,7 @@ const DexType* get_element_type_if_array(const DexType* type) {
 DexType* make_array_type(const DexType* type) {
   always_assert(type != nullptr);
   return DexType::make_type(
-      DexString::make_string("[" + type->get_name()->str()));
+      DexString::make_string("[" + type->get_name()->str_copy()));
 }
 
 DexType* make_array_type(const DexType* type, uint32_t level) {
@@ -13,9 +13,10 @@
 #include "Show.h"
 #include "Timer.h"
 #include "Trace.h"
+#include "WorkQueue.h"
 
-#include <map>
-#include <set>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace {
 
@@ -170,17 +171,20 @@ void create_object_class() {
   }
 }
 
+// The maps below are only used for lookups and for per-signature updates
+// whose order doesn't matter, so they are keyed by the interned
+// DexString/DexProto pointers instead of comparing string contents.
+
 // map from a proto to the set of interface implementing that sig
-using IntfProtoMap = std::map<const DexProto*, TypeSet, dexprotos_comparator>;
+using IntfProtoMap = std::unordered_map<const DexProto*, TypeSet>;
 
 // a map from name to signatures for a set of interfaces
-using BaseIntfSigs =
-    std::map<const DexString*, IntfProtoMap, dexstrings_comparator>;
+using BaseIntfSigs = std::unordered_map<const DexString*, IntfProtoMap>;
 
 // map to track signatures as (name, sig)
-using BaseSigs = std::map<const DexString*,
-                          std::set<const DexProto*, dexprotos_comparator>,
-                          dexstrings_comparator>;
+using BaseSigs =
+    std::unordered_map<const DexString*,
+                       std::unordered_set<const DexProto*>>;
 
 /**
  * Create a BaseSig which is the set of method definitions in a type.
@@ -478,7 +482,7 @@ DexMethod* make_miranda(const DexType* type,
   return static_cast<DexMethod*>(miranda);
 }
 
-bool load_interfaces_methods(const std::deque<DexType*>&, BaseIntfSigs&);
+bool load_interfaces_methods(const DexTypeList::ContainerType&, BaseIntfSigs&);
 
 /**
  * Load methods for a given interface and its super interfaces.
@@ -504,7 +508,7 @@ bool load_interface_methods(const DexClass* intf_cls,
  * Load methods for a list of interfaces.
  * If any interface escapes (no DexClass*) return true.
  */
-bool load_interfaces_methods(const std::deque<DexType*>& interfaces,
+bool load_interfaces_methods(const DexTypeList::ContainerType& interfaces,
                              BaseIntfSigs& intf_methods) {
   bool escaped = false;
   for (const auto& intf : interfaces) {
@@ -664,12 +668,37 @@ bool build_signature_map(const ClassHierarchy& hierarchy,
   TRACE(VIRT, 3, "* Sig map computed for %s", SHOW(type));
 
   // recurse through every child to collect all methods
-  // and interface methods under type
+  // and interface methods under type.
+  // The subtrees under Object are disjoint, so they are built in parallel
+  // and then merged in the original order.
+  std::vector<SignatureMap> child_sig_maps;
+  std::vector<char> child_escapes;
+  if (type == type::java_lang_Object() && children.size() > 1) {
+    child_sig_maps.resize(children.size());
+    child_escapes.resize(children.size());
+    std::vector<std::pair<size_t, const DexType*>> work;
+    for (const auto& child : children) {
+      work.emplace_back(work.size(), child);
+    }
+    workqueue_run<std::pair<size_t, const DexType*>>(
+        [&](const std::pair<size_t, const DexType*>& item) {
+          child_escapes[item.first] = build_signature_map(
+              hierarchy, item.second, child_sig_maps[item.first]);
+        },
+        work);
+  }
   bool escape_up = false;
+  size_t i = 0;
   for (const auto& child : children) {
     SignatureMap child_sig_map;
-    escape_up =
-        build_signature_map(hierarchy, child, child_sig_map) || escape_up;
+    if (child_sig_maps.empty()) {
+      escape_up =
+          build_signature_map(hierarchy, child, child_sig_map) || escape_up;
+    } else {
+      child_sig_map = std::move(child_sig_maps[i]);
+      escape_up = child_escapes[i] || escape_up;
+    }
+    i++;
     TRACE(VIRT,
           3,
           "* Merging sig map of %s with child %s",
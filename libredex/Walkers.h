@@ -18,6 +18,7 @@
 #include "EditableCfgAdapter.h"
 #include "IRCode.h"
 #include "Match.h"
+#include "MethodTiming.h"
 #include "Thread.h"
 #include "Trace.h"
 #include "VirtualScope.h"
@@ -415,6 +416,35 @@ class walk {
     parallel() = delete;
     ~parallel() = delete;
 
+    // An estimate of the cost of walking a class, dominated by the size of
+    // its code. Cheap enough to compute serially before every walk.
+    static uint64_t class_cost(const DexClass* cls) {
+      uint64_t cost = 1;
+      auto add_methods = [&cost](const std::vector<DexMethod*>& methods) {
+        for (auto* m : methods) {
+          auto* code = m->get_code();
+          cost += 1 + (code == nullptr ? 0 : code->estimate_size());
+        }
+      };
+      add_methods(cls->get_dmethods());
+      add_methods(cls->get_vmethods());
+      return cost;
+    }
+
+    // Run `fn` on all classes in parallel, handing out the classes with the
+    // most code first, so that a class with a huge method doesn't end up
+    // trailing at the end of some worker's queue.
+    template <class Classes, typename Fn>
+    static void classes_by_cost(const Classes& classes,
+                                const Fn& fn,
+                                size_t num_threads) {
+      auto wq = workqueue_foreach<DexClass*>(fn, num_threads);
+      for (auto* cls : classes) {
+        wq.add_weighted_item(cls, class_cost(cls));
+      }
+      wq.run_all();
+    }
+
     /**
      * Call walker on all classes in `classes` in parallel.
      */
@@ -436,9 +466,18 @@ class walk {
         const Classes& classes,
         const WalkerFn& walker,
         size_t num_threads = redex_parallel::default_num_threads()) {
-      workqueue_run<DexClass*>(
-          [&walker](DexClass* cls) { walk::iterate_methods(cls, walker); },
+      classes_by_cost(
           classes,
+          [&walker](DexClass* cls) {
+            if (method_timing::enabled()) {
+              walk::iterate_methods(cls, [&walker](DexMethod* method) {
+                method_timing::ScopedMethodTimer timer(method);
+                walker(method);
+              });
+            } else {
+              walk::iterate_methods(cls, walker);
+            }
+          },
           num_threads);
     }
 
@@ -536,11 +575,19 @@ class walk {
         const FilterFn& filter,
         const WalkerFn& walker,
         size_t num_threads = redex_parallel::default_num_threads()) {
-      workqueue_run<DexClass*>(
+      classes_by_cost(
+          classes,
           [&filter, &walker](DexClass* cls) {
-            walk::iterate_code(cls, filter, walker);
+            if (method_timing::enabled()) {
+              walk::iterate_code(
+                  cls, filter, [&walker](DexMethod* method, IRCode& code) {
+                    method_timing::ScopedMethodTimer timer(method);
+                    walker(method, code);
+                  });
+            } else {
+              walk::iterate_code(cls, filter, walker);
+            }
           },
-          classes,
           num_threads);
     }
 
@@ -563,11 +610,11 @@ class walk {
         const FilterFn& filter,
         const WalkerFn& walker,
         size_t num_threads = redex_parallel::default_num_threads()) {
-      workqueue_run<DexClass*>(
+      classes_by_cost(
+          classes,
           [&filter, &walker](DexClass* cls) {
             walk::iterate_opcodes(cls, filter, walker);
           },
-          classes,
           num_threads);
     }
 
@@ -24,8 +24,12 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
+#include <atomic>
 #include <limits>
+#include <thread>
 #include <type_traits>
+#include <vector>
 
 #if defined(_MSC_VER) || defined(__MINGW64__) || defined(__MINGW32__)
 #include "CompatWindows.h"
@@ -3349,14 +3353,38 @@ struct ResTable::PackageGroup
             pkg->serialize(cVec);
         }
 
+        // Type chunks are self-contained, so serialize them concurrently into
+        // their own buffers and stitch them together in order.
+        std::vector<Type*> allTypes;
         const size_t numTypes = types.size();
         for (size_t i = 0; i < numTypes; i++) {
             const TypeList& typeList = types[i];
             const size_t numInnerTypes = typeList.size();
             for (size_t j = 0; j < numInnerTypes; j++) {
-                typeList[j]->serialize(cVec);
+                allTypes.push_back(typeList[j]);
             }
         }
+        std::vector<Vector<char>> chunks(allTypes.size());
+        std::atomic<size_t> nextType{0};
+        auto serializeTypes = [&]() {
+            size_t k;
+            while ((k = nextType.fetch_add(1)) < allTypes.size()) {
+                allTypes[k]->serialize(chunks[k]);
+            }
+        };
+        size_t numThreads = std::min<size_t>(
+            std::thread::hardware_concurrency(), allTypes.size());
+        std::vector<std::thread> threads;
+        for (size_t t = 1; t < numThreads; t++) {
+            threads.emplace_back(serializeTypes);
+        }
+        serializeTypes();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        for (const auto& chunk : chunks) {
+            cVec.appendVector(chunk);
+        }
 
         // Rewrite size of 'root' package
         rewriteSize(cVec, initSize);
@@ -7,6 +7,7 @@
 
 #include "AccessMarking.h"
 
+#include <atomic>
 #include <unordered_map>
 
 #include "ClassHierarchy.h"
@@ -27,12 +28,15 @@ namespace mog = method_override_graph;
 
 namespace {
 
+// The decision for a class or method only depends on the type hierarchy or
+// the override graph, which finalizing doesn't change, so all members can be
+// processed in parallel; each worker only touches the flags of its own class.
 size_t mark_classes_final(const Scope& scope) {
   ClassHierarchy ch = build_type_hierarchy(scope);
-  size_t n_classes_finalized = 0;
-  for (auto const& cls : scope) {
+  std::atomic<size_t> n_classes_finalized{0};
+  walk::parallel::classes(scope, [&](DexClass* cls) {
     if (!can_rename(cls) || is_abstract(cls) || is_final(cls)) {
-      continue;
+      return;
     }
     auto const& children = get_children(ch, cls->get_type());
     if (children.empty()) {
@@ -40,14 +44,14 @@ size_t mark_classes_final(const Scope& scope) {
       set_final(cls);
       ++n_classes_finalized;
     }
-  }
+  });
   return n_classes_finalized;
 }
 
 size_t mark_methods_final(const Scope& scope,
                           const mog::Graph& override_graph) {
-  size_t n_methods_finalized = 0;
-  for (auto const& cls : scope) {
+  std::atomic<size_t> n_methods_finalized{0};
+  walk::parallel::classes(scope, [&](DexClass* cls) {
     for (auto const& method : cls->get_vmethods()) {
       if (!can_rename(method) || is_abstract(method) || is_final(method)) {
         continue;
@@ -58,7 +62,7 @@ size_t mark_methods_final(const Scope& scope,
         ++n_methods_finalized;
       }
     }
-  }
+  });
   return n_methods_finalized;
 }
 
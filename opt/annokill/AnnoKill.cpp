@@ -456,8 +456,8 @@ bool AnnoKill::should_kill_bad_signature(DexAnnotation* da) {
     auto const& evs = arrayev->evalues();
     for (auto strev : *evs) {
       if (strev->evtype() != DEVT_STRING) continue;
-      const auto& sigstr =
-          static_cast<DexEncodedValueString*>(strev)->string()->str();
+      const auto sigstr =
+          static_cast<DexEncodedValueString*>(strev)->string()->str_copy();
       always_assert(sigstr.length() > 0);
       const auto* sigcstr = sigstr.c_str();
       // @Signature grammar is non-trivial[1], nevermind the fact that
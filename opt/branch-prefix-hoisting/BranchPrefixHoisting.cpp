@@ -11,6 +11,7 @@
 #include <boost/optional/optional.hpp>
 #include <iterator>
 
+#include "CFGLocalOptimizations.h"
 #include "ControlFlow.h"
 #include "DexClass.h"
 #include "DexUtil.h"
@@ -20,6 +21,7 @@
 #include "IRList.h"
 #include "IROpcode.h"
 #include "PassManager.h"
+#include "ScopedCFG.h"
 #include "Show.h"
 #include "Trace.h"
 #include "Util.h"
@@ -295,11 +297,10 @@ bool create_move_and_fix_clobbered(
     cfg::Block* block,
     cfg::ControlFlowGraph& cfg,
     const std::unordered_map<reg_t, bool>& crit_regs,
-    type_inference::TypeInference& type_inference) {
+    const type_inference::TypeEnvironments& type_envs) {
   std::unordered_map<reg_t, reg_t> reg_map;
   auto it = block->to_cfg_instruction_iterator(pos);
   auto cond_insn = it->insn;
-  auto& type_envs = type_inference.get_type_environments();
   auto& env = type_envs.at(cond_insn);
 
   // Go over the critical regs and make a copy before hoisted insns.
@@ -352,19 +353,20 @@ bool create_move_and_fix_clobbered(
 }
 
 // This function is where the pass mutates the IR
-size_t hoist_insns_for_block(cfg::Block* block,
-                             const IRList::iterator& pos,
-                             const std::vector<cfg::Block*>& succ_blocks,
-                             cfg::ControlFlowGraph& cfg,
-                             const std::vector<IRInstruction>& insns_to_hoist,
-                             const std::unordered_map<reg_t, bool>& crit_regs,
-                             type_inference::TypeInference& type_inference) {
+size_t hoist_insns_for_block(
+    cfg::Block* block,
+    const IRList::iterator& pos,
+    const std::vector<cfg::Block*>& succ_blocks,
+    cfg::ControlFlowGraph& cfg,
+    const std::vector<IRInstruction>& insns_to_hoist,
+    const std::unordered_map<reg_t, bool>& crit_regs,
+    const type_inference::TypeEnvironments& type_envs) {
   auto insert_it = block->to_cfg_instruction_iterator(pos);
 
   {
     std::vector<IRInstruction*> heap_insn_objs;
     if (!create_move_and_fix_clobbered(pos, heap_insn_objs, block, cfg,
-                                       crit_regs, type_inference)) {
+                                       crit_regs, type_envs)) {
       return 0;
     }
 
@@ -505,10 +507,11 @@ size_t hoist_insns_for_block(cfg::Block* block,
 }
 
 // returns number of hoisted instructions
-size_t process_hoisting_for_block(cfg::Block* block,
-                                  cfg::ControlFlowGraph& cfg,
-                                  type_inference::TypeInference& type_inference,
-                                  constant_uses::ConstantUses& constant_uses) {
+size_t process_hoisting_for_block(
+    cfg::Block* block,
+    cfg::ControlFlowGraph& cfg,
+    const type_inference::TypeEnvironments& type_envs,
+    constant_uses::ConstantUses& constant_uses) {
 
   auto all_preds_are_same = [](const std::vector<cfg::Edge*>& edges) {
     std::unordered_set<cfg::Block*> count;
@@ -563,7 +566,7 @@ size_t process_hoisting_for_block(cfg::Block* block,
                                          cfg,
                                          insns_to_hoist,
                                          crit_regs,
-                                         type_inference);
+                                         type_envs);
     TRACE(
         BPH, 5, "Hoisted %zu/%zu instruction from %s into B%zu", hoisted,
         insns_to_hoist.size(),
@@ -584,21 +587,19 @@ size_t process_hoisting_for_block(cfg::Block* block,
 } // namespace
 
 size_t BranchPrefixHoistingPass::process_code(IRCode* code, DexMethod* method) {
-  code->build_cfg(true);
-  auto& cfg = code->cfg();
+  cfg::ScopedCFG scoped_cfg(code);
+  auto& cfg = *scoped_cfg;
   TRACE(BPH, 5, "%s", SHOW(cfg));
-  type_inference::TypeInference type_inference(cfg);
-  type_inference.run(method);
+  // Shared with the constant-uses analysis, which may need types too.
+  auto type_envs = type_inference::get_type_environments(method);
   constant_uses::ConstantUses constant_uses(cfg, method);
 
-  size_t ret = process_cfg(cfg, type_inference, constant_uses);
-  code->clear_cfg();
-  return ret;
+  return process_cfg(cfg, type_envs->type_envs, constant_uses);
 }
 
 size_t BranchPrefixHoistingPass::process_cfg(
     cfg::ControlFlowGraph& cfg,
-    type_inference::TypeInference& type_inference,
+    const type_inference::TypeEnvironments& type_envs,
     constant_uses::ConstantUses& constant_uses) {
   size_t ret_insns_hoisted = 0;
   bool performed_transformation = false;
@@ -610,7 +611,7 @@ size_t BranchPrefixHoistingPass::process_cfg(
     for (auto block : blocks) {
       // when we are processing hoist for one block, other blocks may be changed
       size_t n_insn_hoisted =
-          process_hoisting_for_block(block, cfg, type_inference, constant_uses);
+          process_hoisting_for_block(block, cfg, type_envs, constant_uses);
       if (n_insn_hoisted) {
         performed_transformation = true;
         ret_insns_hoisted += n_insn_hoisted;
@@ -648,3 +649,17 @@ void BranchPrefixHoistingPass::run_pass(DexStoresVector& stores,
 }
 
 static BranchPrefixHoistingPass s_pass;
+
+static cfg_local_opts::StageRegistration s_stage(
+    "BranchPrefixHoistingPass",
+    {[](const Json::Value&) -> cfg_local_opts::MethodTransform {
+       return [](DexMethod* method, cfg::ControlFlowGraph& cfg,
+                 cfg_local_opts::Metrics& metrics) {
+         auto type_envs = type_inference::get_type_environments(cfg, method);
+         constant_uses::ConstantUses constant_uses(cfg, method);
+         metrics.values[METRIC_INSTRUCTIONS_HOISTED] +=
+             BranchPrefixHoistingPass::process_cfg(cfg, type_envs->type_envs,
+                                                   constant_uses);
+       };
+     },
+     /* requires_type_environments */ true});
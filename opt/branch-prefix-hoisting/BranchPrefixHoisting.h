@@ -10,10 +10,11 @@
 #include <unordered_set>
 #include <vector>
 
+#include "AnalysisUsage.h"
 #include "ConstantUses.h"
 #include "IRList.h"
 #include "Pass.h"
-#include "TypeInference.h"
+#include "TypeInferenceCache.h"
 
 class IRCode;
 
@@ -26,10 +27,18 @@ class BranchPrefixHoistingPass : public Pass {
  public:
   BranchPrefixHoistingPass() : Pass("BranchPrefixHoistingPass") {}
 
+  // Types are needed for every method, by both the pass and its constant-uses
+  // analysis.
+  void set_analysis_usage(AnalysisUsage& au) const override {
+    au.set_requires_type_environments();
+  }
+
   void run_pass(DexStoresVector&, ConfigFiles&, PassManager&) override;
 
+  bool keeps_editable_cfg() const override { return true; }
+
   static size_t process_code(IRCode*, DexMethod*);
   static size_t process_cfg(cfg::ControlFlowGraph&,
-                            type_inference::TypeInference&,
+                            const type_inference::TypeEnvironments&,
                             constant_uses::ConstantUses&);
 };
@@ -0,0 +1,265 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "CFGLocalOptimizationsPass.h"
+
+#include <atomic>
+#include <memory>
+#include <sstream>
+
+#include "AnalysisUsage.h"
+#include "CFGLocalOptimizations.h"
+#include "CFGLocalOptimizationsCache.h"
+#include "ControlFlow.h"
+#include "DexClass.h"
+#include "DexHasher.h"
+#include "IRAssembler.h"
+#include "IRCode.h"
+#include "PassManager.h"
+#include "S_Expression.h"
+#include "ScopedCFG.h"
+#include "Show.h"
+#include "Walkers.h"
+
+namespace {
+
+struct PerStageMetrics {
+  std::vector<cfg_local_opts::Metrics> stages;
+
+  PerStageMetrics& operator+=(const PerStageMetrics& that) {
+    if (stages.size() < that.stages.size()) {
+      stages.resize(that.stages.size());
+    }
+    for (size_t i = 0; i < that.stages.size(); i++) {
+      stages[i] += that.stages[i];
+    }
+    return *this;
+  }
+};
+
+// Whether the code can be written as an s-expression and read back, see
+// IRAssembler.h.
+bool is_serializable(const IRCode* code) {
+  for (const auto& mie : InstructionIterable(code)) {
+    switch (opcode::ref(mie.insn->opcode())) {
+    case opcode::Ref::Data:
+    case opcode::Ref::CallSite:
+    case opcode::Ref::MethodHandle:
+      return false;
+    default:
+      break;
+    }
+  }
+  return true;
+}
+
+std::string hash_to_key_part(const hashing::DexHash& hash) {
+  return hashing::hash_to_string(hash.positions_hash) +
+         hashing::hash_to_string(hash.registers_hash) +
+         hashing::hash_to_string(hash.code_hash);
+}
+
+bool same_code_hashes(const hashing::DexHash& a, const hashing::DexHash& b) {
+  return a.positions_hash == b.positions_hash &&
+         a.registers_hash == b.registers_hash && a.code_hash == b.code_hash;
+}
+
+/*
+ * Cached results are s-expressions of the form
+ *
+ *   (registers_size ((stage_index metric value) ...) code)
+ *
+ * where the code is in the syntax of the IRAssembler. Only code that reads
+ * back with the same DexHasher hashes is cached, so that replaying a result
+ * gives the very same code.
+ */
+boost::optional<std::string> serialize(const IRCode* code,
+                                       const PerStageMetrics& metrics) {
+  if (!is_serializable(code)) {
+    return boost::none;
+  }
+  auto code_expr = assembler::to_s_expr(code);
+  auto read_back = assembler::ircode_from_s_expr(code_expr);
+  read_back->set_registers_size(code->get_registers_size());
+  if (!same_code_hashes(hashing::DexClassHasher::hash_code(code),
+                        hashing::DexClassHasher::hash_code(read_back.get()))) {
+    return boost::none;
+  }
+  std::vector<sparta::s_expr> metric_exprs;
+  for (size_t i = 0; i < metrics.stages.size(); i++) {
+    for (const auto& p : metrics.stages[i].values) {
+      metric_exprs.emplace_back(
+          sparta::s_expr({sparta::s_expr(std::to_string(i)),
+                          sparta::s_expr(p.first),
+                          sparta::s_expr(std::to_string(p.second))}));
+    }
+  }
+  return sparta::s_expr(
+             {sparta::s_expr(std::to_string(code->get_registers_size())),
+              sparta::s_expr(metric_exprs), code_expr})
+      .str();
+}
+
+// Replaces the code of the method by the cached one, and adds the cached
+// metrics. Returns false, without changing anything, for malformed values.
+bool replay(DexMethod* method,
+            const std::string& value,
+            PerStageMetrics& metrics) try {
+  std::istringstream input(value);
+  sparta::s_expr_istream expr_input(input);
+  sparta::s_expr expr;
+  expr_input >> expr;
+  if (expr_input.fail() || !expr.is_list() || expr.size() != 3 ||
+      !expr[0].is_string() || !expr[1].is_list() || !expr[2].is_list()) {
+    return false;
+  }
+  PerStageMetrics cached_metrics;
+  cached_metrics.stages.resize(metrics.stages.size());
+  for (size_t i = 0; i < expr[1].size(); i++) {
+    auto metric = expr[1][i];
+    if (!metric.is_list() || metric.size() != 3 || !metric[0].is_string() ||
+        !metric[1].is_string() || !metric[2].is_string()) {
+      return false;
+    }
+    auto stage = std::stoul(metric[0].get_string());
+    if (stage >= cached_metrics.stages.size()) {
+      return false;
+    }
+    cached_metrics.stages[stage].values[metric[1].get_string()] +=
+        std::stoull(metric[2].get_string());
+  }
+
+  auto code = assembler::ircode_from_s_expr(expr[2]);
+  code->set_registers_size(std::stoul(expr[0].get_string()));
+  // The debug item only holds parameter names, which the stages don't touch.
+  auto old_code = method->get_code();
+  if (old_code->get_debug_item() != nullptr) {
+    code->set_debug_item(old_code->release_debug_item());
+  }
+  method->set_code(std::move(code));
+  metrics += cached_metrics;
+  return true;
+} catch (const std::exception&) {
+  return false;
+}
+
+} // namespace
+
+void CFGLocalOptimizationsPass::set_analysis_usage(AnalysisUsage& au) const {
+  for (const auto& name : m_stages) {
+    auto* stage = cfg_local_opts::get_stage(name);
+    if (stage != nullptr && stage->requires_type_environments) {
+      au.set_requires_type_environments();
+    }
+  }
+}
+
+void CFGLocalOptimizationsPass::run_pass(DexStoresVector& stores,
+                                         ConfigFiles& /* unused */,
+                                         PassManager& mgr) {
+  std::vector<cfg_local_opts::MethodTransform> transforms;
+  for (const auto& name : m_stages) {
+    auto* stage = cfg_local_opts::get_stage(name);
+    always_assert_log(stage != nullptr, "Unknown CFG-local stage %s",
+                      name.c_str());
+    transforms.push_back(stage->make_transform(
+        m_stage_options.get(name, Json::Value(Json::objectValue))));
+  }
+  if (transforms.empty()) {
+    return;
+  }
+
+  std::unique_ptr<cfg_local_opts::Cache> cache;
+  // Everything besides the method that the results depend on.
+  std::string config_key;
+  if (!m_cache_file.empty()) {
+    bool cacheable = true;
+    for (const auto& name : m_stages) {
+      cacheable &= cfg_local_opts::get_stage(name)->cacheable;
+    }
+    if (cacheable) {
+      cache = std::make_unique<cfg_local_opts::Cache>(m_cache_file);
+      for (const auto& name : m_stages) {
+        config_key += name + ";";
+      }
+      config_key += m_stage_options.toStyledString();
+    } else {
+      TRACE(CFG, 1,
+            "[cfg-local-opts] Not caching, as some stages are not cacheable");
+    }
+  }
+
+  auto run_stages = [&](DexMethod* method, IRCode* code,
+                        PerStageMetrics& res) {
+    cfg::ScopedCFG cfg(code);
+    for (size_t i = 0; i < transforms.size(); i++) {
+      transforms[i](method, *cfg, res.stages[i]);
+    }
+  };
+
+  std::atomic<size_t> cache_hits{0};
+  std::atomic<size_t> cache_misses{0};
+  auto scope = build_class_scope(stores);
+  auto metrics = walk::parallel::methods<PerStageMetrics>(
+      scope, [&](DexMethod* method) {
+        PerStageMetrics res;
+        auto code = method->get_code();
+        if (!code) {
+          return res;
+        }
+        res.stages.resize(transforms.size());
+        if (!cache) {
+          run_stages(method, code, res);
+          return res;
+        }
+
+        // Keys and cached results are computed on the linear code.
+        bool had_cfg = code->editable_cfg_built();
+        if (had_cfg) {
+          code->clear_cfg();
+        }
+        if (!is_serializable(code)) {
+          run_stages(method, code, res);
+        } else {
+          auto key = cfg_local_opts::Cache::make_key(
+              {config_key, show(method), std::to_string(method->get_access()),
+               hash_to_key_part(hashing::DexClassHasher::hash_code(code)),
+               assembler::to_string(code)});
+          auto value = cache->get(key);
+          if (value && replay(method, *value, res)) {
+            cache_hits++;
+            code = method->get_code();
+          } else {
+            cache_misses++;
+            run_stages(method, code, res);
+            auto result = serialize(code, res);
+            if (result) {
+              cache->put(key, std::move(*result));
+            }
+          }
+        }
+        if (had_cfg) {
+          code->build_cfg(/* editable */ true);
+        }
+        return res;
+      });
+
+  if (cache) {
+    mgr.incr_metric("cache_loaded", cache->loaded_size());
+    mgr.incr_metric("cache_hits", cache_hits.load());
+    mgr.incr_metric("cache_misses", cache_misses.load());
+    cache->save();
+  }
+
+  for (size_t i = 0; i < metrics.stages.size(); i++) {
+    for (const auto& p : metrics.stages[i].values) {
+      mgr.incr_metric(m_stages[i] + "." + p.first, p.second);
+    }
+  }
+}
+
+static CFGLocalOptimizationsPass s_pass;
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <json/json.h>
+#include <string>
+#include <vector>
+
+#include "Pass.h"
+
+/*
+ * Runs a list of CFG-local stages (see CFGLocalOptimizations.h) on every
+ * method, building and linearizing each method's editable CFG only once for
+ * all of them. For example,
+ *
+ *   "CFGLocalOptimizationsPass": {
+ *     "stages": ["UpCodeMotionPass", "BranchPrefixHoistingPass"],
+ *     "stage_options": {
+ *       "UpCodeMotionPass": {"check_branch_hotness": true}
+ *     }
+ *   }
+ *
+ * does the work of the two passes in a single walk over the scope. Metrics are
+ * reported per stage, prefixed by the stage name.
+ *
+ * With a "cache_file", the results of each method are kept across builds,
+ * keyed by its code, signature and access flags, and by the configuration of
+ * the pass. Methods that did not change since an earlier build then get their
+ * optimized code from the cache instead of going through the stages again.
+ * This only applies when all the stages are cacheable, see
+ * cfg_local_opts::Stage. The cache does not know about changes to Redex
+ * itself, so it must be deleted when updating Redex.
+ */
+class CFGLocalOptimizationsPass : public Pass {
+ public:
+  CFGLocalOptimizationsPass() : Pass("CFGLocalOptimizationsPass") {}
+
+  void bind_config() override {
+    bind("stages", {}, m_stages,
+         "The stages to run on each method, in order. Stages are named after "
+         "the passes that run the same transformation on their own.");
+    bind("stage_options", Json::Value(Json::objectValue), m_stage_options,
+         "Options of each stage, by stage name.");
+    bind("cache_file", "", m_cache_file,
+         "If set, the file in which to cache results across builds.");
+  }
+
+  void set_analysis_usage(AnalysisUsage& au) const override;
+
+  void run_pass(DexStoresVector&, ConfigFiles&, PassManager&) override;
+
+  bool keeps_editable_cfg() const override { return true; }
+
+ private:
+  std::vector<std::string> m_stages;
+  Json::Value m_stage_options;
+  std::string m_cache_file;
+};
@@ -10,6 +10,7 @@
 #include <algorithm>
 #include <fstream>
 #include <iosfwd>
+#include <numeric>
 #include <sstream>
 #include <unordered_set>
 
@@ -27,6 +28,7 @@
 #include "Show.h"
 #include "Trace.h"
 #include "Walkers.h"
+#include "WorkQueue.h"
 
 /**
  * Performs 2 kind of verifications:
@@ -146,7 +148,7 @@ void build_allowed_violations(const Scope& scope,
     }
   }
   for (const auto& cls : scope) {
-    auto& dname = cls->get_deobfuscated_name();
+    auto dname = cls->get_deobfuscated_name_copy();
     if (allowed_class_names.count(dname) != 0) {
       types->emplace(cls->get_type());
       allowed_class_names[dname] = true;
@@ -298,6 +300,7 @@ Breadcrumbs::Breadcrumbs(const Scope& scope,
 }
 
 void Breadcrumbs::check_breadcrumbs() {
+  build_load_types();
   check_fields();
   check_methods();
   check_opcodes();
@@ -613,6 +616,31 @@ bool Breadcrumbs::has_illegal_access(const DexMethod* input_method) {
   return result;
 }
 
+// Gathering the load types of a class walks its whole hierarchy, and the same
+// classes are checked over and over, once per referencing instruction. So do
+// it once per class, up front and in parallel.
+void Breadcrumbs::build_load_types() {
+  if (!m_verify_type_hierarchies) {
+    return;
+  }
+  std::vector<Types> load_types(m_scope.size());
+  std::vector<size_t> indices(m_scope.size());
+  std::iota(indices.begin(), indices.end(), 0);
+  workqueue_run<size_t>(
+      [&](size_t i) {
+        std::unordered_set<DexType*> types;
+        m_scope[i]->gather_load_types(types);
+        auto& sorted = load_types[i];
+        sorted.assign(types.begin(), types.end());
+        std::sort(sorted.begin(), sorted.end(), dextypes_comparator());
+      },
+      indices);
+  m_load_types.reserve(m_scope.size());
+  for (size_t i = 0; i < m_scope.size(); ++i) {
+    m_load_types.emplace(m_scope[i]->get_type(), std::move(load_types[i]));
+  }
+}
+
 bool Breadcrumbs::is_illegal_cross_store(const DexType* caller,
                                          const DexType* callee) {
   // Skip deleted types, as we don't know the store for those.
@@ -621,18 +649,16 @@ bool Breadcrumbs::is_illegal_cross_store(const DexType* caller,
     return false;
   }
 
-  std::set<const DexType*, dextypes_comparator> load_types;
+  Types callee_only;
+  const Types* load_types = &callee_only;
   if (m_verify_type_hierarchies) {
-    auto callee_cls = type_class(callee);
-    std::unordered_set<DexType*> types;
-    callee_cls->gather_load_types(types);
-    load_types.insert(types.begin(), types.end());
+    load_types = &m_load_types.at(callee);
   } else {
-    load_types.emplace(callee);
+    callee_only.push_back(callee);
   }
 
   size_t caller_store_idx = m_xstores.get_store_idx(caller);
-  for (const auto& callee_to_check : load_types) {
+  for (const auto& callee_to_check : *load_types) {
     size_t callee_store_idx = m_xstores.get_store_idx(callee_to_check);
     if (m_multiple_root_store_dexes && caller_store_idx == 0 &&
         callee_store_idx == 1 && !m_reject_illegal_refs_root_store) {
@@ -703,6 +729,7 @@ const DexType* Breadcrumbs::check_anno(const DexAnnotationSet* anno) {
 void Breadcrumbs::bad_type(const DexType* type,
                            const DexMethod* method,
                            const IRInstruction* insn) {
+  std::lock_guard<std::mutex> lock(m_reports_mutex);
   m_bad_type_insns[type][method].emplace_back(insn);
 }
 
@@ -810,6 +837,7 @@ void Breadcrumbs::check_type_opcode(const DexMethod* method,
   } else {
     const auto cls = method->get_class();
     if (is_illegal_cross_store(cls, insn->get_type())) {
+      std::lock_guard<std::mutex> lock(m_reports_mutex);
       m_illegal_type[method].emplace_back(insn);
     }
   }
@@ -833,10 +861,12 @@ void Breadcrumbs::check_field_opcode(const DexMethod* method,
   if (check_cross_store_ref) {
     auto cls = method->get_class();
     if (is_illegal_cross_store(cls, field->get_type())) {
+      std::lock_guard<std::mutex> lock(m_reports_mutex);
       m_illegal_field_type[method].emplace_back(insn);
     }
 
     if (is_illegal_cross_store(cls, field->get_class())) {
+      std::lock_guard<std::mutex> lock(m_reports_mutex);
       m_illegal_field_cls[method].emplace_back(insn);
     }
   }
@@ -855,6 +885,7 @@ void Breadcrumbs::check_field_opcode(const DexMethod* method,
     // the class of the field is around but the field may have
     // been deleted so let's verify the field exists on the class
     if (referenced_field_is_deleted(field)) {
+      std::lock_guard<std::mutex> lock(m_reports_mutex);
       m_bad_field_insns[static_cast<DexField*>(field)][method].emplace_back(
           insn);
       return;
@@ -871,6 +902,7 @@ void Breadcrumbs::check_method_opcode(const DexMethod* method,
     return;
   }
   if (is_illegal_cross_store(method->get_class(), meth->get_class())) {
+    std::lock_guard<std::mutex> lock(m_reports_mutex);
     m_illegal_method_call[method].emplace_back(insn);
   }
 
@@ -888,6 +920,7 @@ void Breadcrumbs::check_method_opcode(const DexMethod* method,
     // the class of the method is around but the method may have
     // been deleted so let's verify the method exists on the class
     if (referenced_method_is_deleted(meth)) {
+      std::lock_guard<std::mutex> lock(m_reports_mutex);
       m_bad_meth_insns[static_cast<DexMethod*>(meth)][method].emplace_back(
           insn);
       return;
@@ -895,8 +928,12 @@ void Breadcrumbs::check_method_opcode(const DexMethod* method,
   }
 }
 
+// Instructions are checked in parallel. Violations are rare, so the reports
+// are simply guarded by a mutex. All of them are keyed by the referencing
+// method, whose instructions are all visited by one thread in order, so the
+// reports come out the same as with a sequential walk.
 void Breadcrumbs::check_opcodes() {
-  walk::opcodes(
+  walk::parallel::opcodes(
       m_scope_to_walk,
       [](DexMethod*) { return true; },
       [&](DexMethod* method, IRInstruction* insn) {
@@ -9,6 +9,8 @@
 
 #include <iosfwd>
 #include <map>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
 #include "DexClass.h" // All the comparators.
@@ -102,6 +104,11 @@ class Breadcrumbs {
   MethodInsns m_illegal_field_type;
   MethodInsns m_illegal_field_cls;
   MethodInsns m_illegal_method_call;
+  // Guards the reports above while check_opcodes runs in parallel.
+  std::mutex m_reports_mutex;
+  // With verify_type_hierarchies, the load types of every class in scope, in
+  // dextypes_comparator order.
+  std::unordered_map<const DexType*, Types> m_load_types;
   XStoreRefs m_xstores;
   std::unordered_set<const DexType*> m_allow_violations;
   std::unordered_set<std::string> m_allow_violation_type_prefixes;
@@ -120,6 +127,7 @@ class Breadcrumbs {
                                   const char* desc,
                                   MethodInsns& allowed,
                                   std::ostream& ss);
+  void build_load_types();
   bool is_illegal_cross_store(const DexType* caller, const DexType* callee);
   const DexType* check_type(const DexType* type);
   const DexType* check_method(const DexMethodRef* method);
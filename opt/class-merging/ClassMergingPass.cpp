@@ -278,6 +278,7 @@ void ClassMergingPass::run_pass(DexStoresVector& stores,
   }
 
   auto scope = build_class_scope(stores);
+  class_merging::ScopeAnalyses analyses(scope, stores);
   for (ModelSpec& model_spec : m_model_specs) {
     if (!model_spec.enabled) {
       continue;
@@ -288,7 +289,8 @@ void ClassMergingPass::run_pass(DexStoresVector& stores,
             "dex");
       model_spec.include_primary_dex = true;
     }
-    class_merging::merge_model(scope, conf, mgr, stores, model_spec);
+    class_merging::merge_model(scope, conf, mgr, stores, model_spec,
+                               analyses);
   }
   post_dexen_changes(scope, stores);
 }
@@ -29,6 +29,7 @@
 #include <vector>
 
 #include "ApiLevelChecker.h"
+#include "ConcurrentContainers.h"
 #include "ControlFlow.h"
 #include "Creators.h"
 #include "DexClass.h"
@@ -92,21 +93,32 @@ class ClassSplittingInterDexPlugin : public interdex::InterDexPassPlugin {
   void configure(const Scope& scope, ConfigFiles& conf) override {
     always_assert(m_method_profiles.has_stats());
 
-    for (auto& p : m_method_profiles.all_interactions()) {
-      auto& method_stats = p.second;
-      walk::methods(scope, [&](DexMethod* method) {
+    // A single walk over the scope, looking up each method in all
+    // interactions, rather than one walk per interaction.
+    const auto& interactions = m_method_profiles.all_interactions();
+    walk::parallel::methods(scope, [&](DexMethod* method) {
+      bool sufficiently_popular{false};
+      bool insufficiently_popular{false};
+      for (auto& p : interactions) {
+        auto& method_stats = p.second;
         auto it = method_stats.find(method);
         if (it == method_stats.end()) {
-          return;
+          continue;
         }
         if (it->second.appear_percent >=
             m_config.method_profiles_appear_percent_threshold) {
-          m_sufficiently_popular_methods.insert(method);
+          sufficiently_popular = true;
         } else {
-          m_insufficiently_popular_methods.insert(method);
+          insufficiently_popular = true;
         }
-      });
-    }
+      }
+      if (sufficiently_popular) {
+        m_sufficiently_popular_methods.insert(method);
+      }
+      if (insufficiently_popular) {
+        m_insufficiently_popular_methods.insert(method);
+      }
+    });
 
     if (m_config.relocate_non_true_virtual_methods) {
       m_non_true_virtual_methods = method_override_graph::get_non_true_virtuals(
@@ -151,7 +163,7 @@ class ClassSplittingInterDexPlugin : public interdex::InterDexPassPlugin {
   DexMethod* create_trampoline_method(DexMethod* method,
                                       DexClass* target_cls,
                                       uint32_t api_level) {
-    std::string name = method->get_name()->str();
+    std::string name = method->get_name()->str_copy();
     // We are merging two "namespaces" here, so we make it clear what kind of
     // method a trampoline came from. We don't support combining target classes
     // by api-level here, as we'd have to do more uniquing.
@@ -161,7 +173,7 @@ class ClassSplittingInterDexPlugin : public interdex::InterDexPassPlugin {
     } else {
       name += "$dtramp";
     }
-    std::deque<DexType*> arg_types;
+    DexTypeList::ContainerType arg_types;
     if (!is_static(method)) {
       arg_types.push_back(method->get_class());
     }
@@ -238,9 +250,10 @@ class ClassSplittingInterDexPlugin : public interdex::InterDexPassPlugin {
         if (it != m_target_classes_by_source_classes.end()) {
           target_cls = it->second;
         } else {
-          auto& source_name = source_cls->str();
+          auto source_name = source_cls->str();
           target_cls = create_target_class(
-              source_name.substr(0, source_name.size() - 1) + RELOCATED_SUFFIX);
+              std::string(source_name.substr(0, source_name.size() - 1)) +
+              RELOCATED_SUFFIX);
           m_target_classes_by_source_classes.emplace(source_cls, target_cls);
         }
       }
@@ -564,10 +577,10 @@ class ClassSplittingInterDexPlugin : public interdex::InterDexPassPlugin {
   }
 
  private:
-  std::unordered_set<DexMethod*> m_sufficiently_popular_methods;
+  ConcurrentSet<DexMethod*> m_sufficiently_popular_methods;
   // Methods that appear in the profiles and whose frequency does not exceed
   // the threashold.
-  std::unordered_set<DexMethod*> m_insufficiently_popular_methods;
+  ConcurrentSet<DexMethod*> m_insufficiently_popular_methods;
 
   struct RelocatableMethodInfo {
     DexClass* target_cls;
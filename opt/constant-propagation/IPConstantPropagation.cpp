@@ -111,8 +111,17 @@ std::unique_ptr<FixpointIterator> PassImpl::analyze(
   m_stats.callgraph_nodes = cg_stats.num_nodes;
   m_stats.callgraph_edges = cg_stats.num_edges;
   m_stats.callgraph_callsites = cg_stats.num_callsites;
+  size_t summary_cache_hits = 0;
+  size_t summary_cache_misses = 0;
+  size_t summary_cache_context = 0;
+  if (m_summary_cache != nullptr) {
+    summary_cache_hits = m_summary_cache->hits();
+    summary_cache_misses = m_summary_cache->misses();
+    summary_cache_context = SummaryCache::context(*immut_analyzer_state);
+  }
   auto fp_iter = std::make_unique<FixpointIterator>(
-      cg, AnalyzerGenerator(immut_analyzer_state));
+      cg, AnalyzerGenerator(immut_analyzer_state), m_summary_cache,
+      summary_cache_context);
   // Run the bootstrap. All field value and method return values are
   // represented by Top.
   fp_iter->run({{CURRENT_PARTITION_LABEL, ArgumentDomain()}});
@@ -137,6 +146,11 @@ std::unique_ptr<FixpointIterator> PassImpl::analyze(
     fp_iter->run({{CURRENT_PARTITION_LABEL, ArgumentDomain()}});
   }
   compute_analysis_stats(fp_iter->get_whole_program_state());
+  if (m_summary_cache != nullptr) {
+    m_stats.summary_cache_hits = m_summary_cache->hits() - summary_cache_hits;
+    m_stats.summary_cache_misses =
+        m_summary_cache->misses() - summary_cache_misses;
+  }
 
   return fp_iter;
 }
@@ -237,6 +251,7 @@ void PassImpl::run_pass(DexStoresVector& stores,
         RuntimeAssertTransform::Config(config.get_proguard_map());
   }
 
+  set_summary_cache(&config.get_ip_constant_propagation_summary_cache());
   run(stores);
 
   ScopedMetrics sm(mgr);
@@ -247,6 +262,8 @@ void PassImpl::run_pass(DexStoresVector& stores,
   mgr.incr_metric("callgraph_edges", m_stats.callgraph_edges);
   mgr.incr_metric("callgraph_nodes", m_stats.callgraph_nodes);
   mgr.incr_metric("callgraph_callsites", m_stats.callgraph_callsites);
+  mgr.incr_metric("summary_cache_hits", m_stats.summary_cache_hits);
+  mgr.incr_metric("summary_cache_misses", m_stats.summary_cache_misses);
 }
 
 static PassImpl s_pass;
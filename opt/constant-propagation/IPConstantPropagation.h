@@ -12,6 +12,7 @@
 #include "ConstantPropagationRuntimeAssert.h"
 #include "ConstantPropagationTransform.h"
 #include "ConstantPropagationWholeProgramState.h"
+#include "IPConstantPropagationSummaryCache.h"
 #include "Pass.h"
 
 namespace constant_propagation {
@@ -73,6 +74,14 @@ class PassImpl : public Pass {
    */
   void run(const DexStoresVector& stores);
 
+  /*
+   * Analyze methods through the given cache of method summaries, which may be
+   * shared with other runs of this pass. Exposed for testing purposes.
+   */
+  void set_summary_cache(SummaryCache* summary_cache) {
+    m_summary_cache = summary_cache;
+  }
+
   /*
    * Exposed for testing purposes.
    */
@@ -93,9 +102,12 @@ class PassImpl : public Pass {
     size_t callgraph_nodes{0};
     size_t callgraph_edges{0};
     size_t callgraph_callsites{0};
+    size_t summary_cache_hits{0};
+    size_t summary_cache_misses{0};
   } m_stats;
   Transform::Stats m_transform_stats;
   Config m_config;
+  SummaryCache* m_summary_cache{nullptr};
 };
 
 } // namespace interprocedural
@@ -16,6 +16,8 @@ class CopyPropagationPass : public Pass {
 
   void run_pass(DexStoresVector&, ConfigFiles&, PassManager&) override;
 
+  bool keeps_editable_cfg() const override { return true; }
+
   void bind_config() override {
     // This option can only be safely enabled in verify-none. `run_pass` will
     // override this value to false if we aren't in verify-none. Here's why:
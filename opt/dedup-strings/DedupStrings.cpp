@@ -80,9 +80,8 @@ void DedupStrings::run(
       indices);
 
   // For each string, figure out how many times it's loaded per dex
-  ConcurrentMap<DexString*, std::unordered_map<size_t, size_t>> occurrences =
-      get_occurrences(scope, methods_to_dex, perf_sensitive_methods,
-                      non_load_strings);
+  Occurrences occurrences =
+      get_occurrences(dexen, perf_sensitive_methods, non_load_strings);
 
   // Use heuristics to determine which strings to dedup,
   // and figure out factory method details
@@ -252,63 +251,97 @@ void DedupStrings::gather_non_load_strings(
   strings->insert(m_ignore_strings.begin(), m_ignore_strings.end());
 }
 
-ConcurrentMap<DexString*, std::unordered_map<size_t, size_t>>
-DedupStrings::get_occurrences(
-    const Scope& scope,
-    const std::unordered_map<const DexMethod*, size_t>& methods_to_dex,
+DedupStrings::Occurrences DedupStrings::get_occurrences(
+    const DexClassesVector& dexen,
     const std::unordered_set<const DexMethod*>& perf_sensitive_methods,
     std::unordered_set<const DexString*> non_load_strings[]) {
-  // For each string, figure out how many times it's loaded per dex
-  ConcurrentMap<DexString*, std::unordered_map<size_t, size_t>> occurrences;
-  ConcurrentMap<DexString*, std::unordered_set<size_t>> perf_sensitive_strings;
-  walk::parallel::code(
-      scope, [&occurrences, &perf_sensitive_strings, &methods_to_dex,
-              &perf_sensitive_methods](DexMethod* method, IRCode& code) {
-        const auto dexnr = methods_to_dex.at(method);
-        const auto perf_sensitive = perf_sensitive_methods.count(method) != 0;
-        for (auto& mie : InstructionIterable(code)) {
-          const auto insn = mie.insn;
-          if (insn->opcode() == OPCODE_CONST_STRING) {
+  // For each dex, count how many times each string is loaded, and gather the
+  // strings loaded by perf-sensitive methods. Each dex is processed by a
+  // single worker, so no synchronization is needed.
+  const size_t num_dexes = dexen.size();
+  std::vector<std::unordered_map<DexString*, uint32_t>> loads_per_dex(
+      num_dexes);
+  std::vector<std::unordered_set<const DexString*>> perf_sensitive_per_dex(
+      num_dexes);
+  std::vector<size_t> indices(num_dexes);
+  std::iota(indices.begin(), indices.end(), 0);
+  workqueue_run<size_t>(
+      [&](size_t dexnr) {
+        auto& loads = loads_per_dex[dexnr];
+        auto& perf_sensitive_strings = perf_sensitive_per_dex[dexnr];
+        walk::code(dexen[dexnr], [&](DexMethod* method, IRCode& code) {
+          const auto perf_sensitive = perf_sensitive_methods.count(method) != 0;
+          for (auto& mie : InstructionIterable(code)) {
+            const auto insn = mie.insn;
+            if (insn->opcode() != OPCODE_CONST_STRING) {
+              continue;
+            }
             const auto str = insn->get_string();
             if (perf_sensitive) {
-              perf_sensitive_strings.update(
-                  str,
-                  [dexnr](const DexString*,
-                          std::unordered_set<size_t>& s,
-                          bool /* exists */) { s.emplace(dexnr); });
+              perf_sensitive_strings.emplace(str);
             } else {
-              occurrences.update(str,
-                                 [dexnr](const DexString*,
-                                         std::unordered_map<size_t, size_t>& m,
-                                         bool /* exists */) { ++m[dexnr]; });
+              ++loads[str];
             }
           }
-        }
-      });
+        });
+      },
+      indices);
 
   // Also, add all the strings that occurred in perf-sensitive methods
   // to the non_load_strings datastructure, as we won't attempt to dedup them.
-  for (const auto& it : perf_sensitive_strings) {
-    const auto str = it.first;
-    TRACE(DS, 3, "[dedup strings] perf sensitive string: {%s}", SHOW(str));
-
-    const auto& dexes = it.second;
-    for (const auto dexnr : dexes) {
-      auto& strings = non_load_strings[dexnr];
-      strings.emplace(str);
+  std::unordered_set<const DexString*> perf_sensitive_strings;
+  for (size_t dexnr = 0; dexnr < num_dexes; ++dexnr) {
+    for (const auto str : perf_sensitive_per_dex[dexnr]) {
+      if (perf_sensitive_strings.emplace(str).second) {
+        TRACE(DS, 3, "[dedup strings] perf sensitive string: {%s}", SHOW(str));
+      }
+      non_load_strings[dexnr].emplace(str);
+    }
+  }
+
+  // Only strings loaded in more than one dex are candidates for dedup.
+  std::unordered_map<DexString*, uint32_t> dexes_per_string;
+  for (const auto& loads : loads_per_dex) {
+    for (const auto& p : loads) {
+      ++dexes_per_string[p.first];
+    }
+  }
+  Occurrences occurrences;
+  occurrences.num_dexes = num_dexes;
+  for (const auto& p : dexes_per_string) {
+    if (p.second > 1) {
+      occurrences.strings.push_back(p.first);
     }
   }
+  std::sort(occurrences.strings.begin(), occurrences.strings.end(),
+            compare_dexstrings);
+  std::unordered_map<const DexString*, size_t> rows;
+  rows.reserve(occurrences.strings.size());
+  for (size_t i = 0; i < occurrences.strings.size(); ++i) {
+    rows.emplace(occurrences.strings[i], i);
+  }
+  // Each worker fills in a distinct column of the matrix.
+  occurrences.loads.resize(occurrences.strings.size() * num_dexes);
+  workqueue_run<size_t>(
+      [&](size_t dexnr) {
+        for (const auto& p : loads_per_dex[dexnr]) {
+          auto it = rows.find(p.first);
+          if (it != rows.end()) {
+            occurrences.loads[it->second * num_dexes + dexnr] = p.second;
+          }
+        }
+      },
+      indices);
 
   m_stats.perf_sensitive_strings = perf_sensitive_strings.size();
-  m_stats.non_perf_sensitive_strings = occurrences.size();
+  m_stats.non_perf_sensitive_strings = dexes_per_string.size();
   return occurrences;
 }
 
 std::unordered_map<DexString*, DedupStrings::DedupStringInfo>
 DedupStrings::get_strings_to_dedup(
     DexClassesVector& dexen,
-    const ConcurrentMap<DexString*, std::unordered_map<size_t, size_t>>&
-        occurrences,
+    const Occurrences& occurrences,
     std::unordered_map<const DexMethod*, size_t>& methods_to_dex,
     std::unordered_set<const DexMethod*>& perf_sensitive_methods,
     const std::unordered_set<const DexString*> non_load_strings[]) {
@@ -321,21 +354,14 @@ DedupStrings::get_strings_to_dedup(
 
   // Do a cost/benefit analysis to figure out which strings to access via
   // factory methods, and where to put to the factory method
+  always_assert(occurrences.num_dexes == dexen.size());
   std::vector<DexString*> strings_in_dexes[dexen.size()];
   std::unordered_set<size_t> hosting_dexnrs;
-  std::vector<DexString*> ordered_strings;
-  ordered_strings.reserve(occurrences.size());
-  for (auto& p : occurrences) {
-    const auto& m = p.second;
-    always_assert(!m.empty());
-    if (m.size() == 1) continue;
-    ordered_strings.push_back(p.first);
-  }
-  std::sort(ordered_strings.begin(), ordered_strings.end(), compare_dexstrings);
-  for (DexString* s : ordered_strings) {
+  std::vector<size_t> size_reductions(dexen.size());
+  for (size_t i = 0; i < occurrences.strings.size(); ++i) {
     // We are going to look at the situation of a particular string here
-    const auto& m = occurrences.at_unsafe(s);
-    always_assert(m.size() > 1);
+    DexString* s = occurrences.strings[i];
+    const uint32_t* loads_per_dex = occurrences.row(i);
     const auto entry_size = s->get_entry_size();
     const auto get_size_reduction = [entry_size, non_load_strings](
                                         DexString* str, size_t dexnr,
@@ -357,6 +383,13 @@ DedupStrings::get_strings_to_dedup(
 
       return 4 + entry_size - code_size_increase;
     };
+    // Figure out what the size reduction would be if a dex would *not* be
+    // hosting string s, also considering whether we'd keep around a copy of
+    // the string in that dex anyway
+    for (size_t dexnr = 0; dexnr < dexen.size(); ++dexnr) {
+      size_reductions[dexnr] =
+          get_size_reduction(s, dexnr, loads_per_dex[dexnr]);
+    }
 
     // First, we identify which dex could and should host the string in
     // its string factory method
@@ -381,12 +414,7 @@ DedupStrings::get_strings_to_dedup(
       }
 
       // So this dex could host the current string s
-      const auto mit = m.find(dexnr);
-      const auto loads = mit == m.end() ? 0 : mit->second;
-      // Figure out what the size reduction would be if this dex would *not*
-      // be hosting string s, also considering whether we'd keep around a copy
-      // of the string in this dex anyway
-      const auto size_reduction = get_size_reduction(s, dexnr, loads);
+      const auto size_reduction = size_reductions[dexnr];
       if (!host_info || size_reduction < host_info->size_reduction) {
         TRACE(DS, 4,
               "[dedup strings] non perf sensitive string: {%s} dex #%zu can "
@@ -415,14 +443,13 @@ DedupStrings::get_strings_to_dedup(
     size_t total_size_reduction = 0;
     size_t duplicate_string_loads = 0;
     std::unordered_set<size_t> dexes_to_dedup;
-    for (const auto& q : m) {
-      const auto dexnr = q.first;
-      const auto loads = q.second;
-      if (dexnr == hosting_dexnr) {
+    for (size_t dexnr = 0; dexnr < dexen.size(); ++dexnr) {
+      const size_t loads = loads_per_dex[dexnr];
+      if (loads == 0 || dexnr == hosting_dexnr) {
         continue;
       }
 
-      const auto size_reduction = get_size_reduction(s, dexnr, loads);
+      const auto size_reduction = size_reductions[dexnr];
 
       if (non_load_strings[dexnr].count(s) != 0) {
         always_assert(size_reduction == 0);
@@ -58,6 +58,17 @@ class DedupStrings {
     DexMethod* const_string_method{nullptr};
   };
 
+  // How many times each string is loaded in each dex, as a dense matrix with
+  // one row per string. Only strings loaded in more than one dex are kept.
+  struct Occurrences {
+    size_t num_dexes{0};
+    // Ordered by compare_dexstrings.
+    std::vector<DexString*> strings;
+    std::vector<uint32_t> loads;
+
+    const uint32_t* row(size_t i) const { return &loads[i * num_dexes]; }
+  };
+
   std::unordered_map<const DexMethod*, size_t> get_methods_to_dex(
       const DexClassesVector& dexen);
   std::unordered_set<const DexMethod*> get_perf_sensitive_methods(
@@ -66,15 +77,13 @@ class DedupStrings {
       DexClasses& dex, size_t dex_id, const std::vector<DexString*>& strings);
   void gather_non_load_strings(DexClasses& classes,
                                std::unordered_set<const DexString*>* strings);
-  ConcurrentMap<DexString*, std::unordered_map<size_t, size_t>> get_occurrences(
-      const Scope& scope,
-      const std::unordered_map<const DexMethod*, size_t>& methods_to_dex,
+  Occurrences get_occurrences(
+      const DexClassesVector& dexen,
       const std::unordered_set<const DexMethod*>& perf_sensitive_methods,
       std::unordered_set<const DexString*> non_load_strings[]);
   std::unordered_map<DexString*, DedupStringInfo> get_strings_to_dedup(
       DexClassesVector& dexen,
-      const ConcurrentMap<DexString*, std::unordered_map<size_t, size_t>>&
-          occurrences,
+      const Occurrences& occurrences,
       std::unordered_map<const DexMethod*, size_t>& methods_to_dex,
       std::unordered_set<const DexMethod*>& perf_sensitive_methods,
       const std::unordered_set<const DexString*> non_load_strings[]);
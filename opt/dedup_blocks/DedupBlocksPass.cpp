@@ -8,6 +8,7 @@
 #include "DedupBlocksPass.h"
 
 #include "PassManager.h"
+#include "ScopedCFG.h"
 #include "Show.h"
 #include "Trace.h"
 #include "Walkers.h"
@@ -35,16 +36,13 @@ void DedupBlocksPass::run_pass(DexStoresVector& stores,
 
         TRACE(DEDUP_BLOCKS, 3, "[dedup blocks] method %s", SHOW(method));
 
-        code->build_cfg(/* editable */ true);
-        auto& cfg = code->cfg();
+        cfg::ScopedCFG cfg(code);
 
         TRACE(DEDUP_BLOCKS, 5, "[dedup blocks] method %s before:\n%s",
-              SHOW(method), SHOW(cfg));
+              SHOW(method), SHOW(*cfg));
 
         dedup_blocks_impl::DedupBlocks impl(&m_config, method);
         impl.run();
-
-        code->clear_cfg();
         return impl.get_stats();
       },
       m_config.debug ? 1 : redex_parallel::default_num_threads());
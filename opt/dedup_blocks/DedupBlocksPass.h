@@ -16,6 +16,8 @@ class DedupBlocksPass : public Pass {
 
   void run_pass(DexStoresVector&, ConfigFiles&, PassManager&) override;
 
+  bool keeps_editable_cfg() const override { return true; }
+
   void bind_config() override {
     bind("method_blocklist", {}, m_config.method_blocklist);
     bind("block_split_min_opcode_count",
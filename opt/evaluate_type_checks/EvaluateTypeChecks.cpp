@@ -91,6 +91,89 @@ struct RemoveResult {
   }
 };
 
+// Answers type::evaluate_type_check. Subclass queries between classes in
+// scope are answered in constant time by numbering the class tree in
+// depth-first order: a class is a subclass of another exactly when its
+// interval is nested in the other's. Everything else falls back to walking
+// the hierarchy.
+class TypeCheckEvaluator {
+ public:
+  TypeCheckEvaluator() = default;
+
+  explicit TypeCheckEvaluator(const Scope& scope) {
+    std::unordered_map<const DexType*, std::vector<const DexClass*>> children;
+    std::vector<const DexClass*> roots;
+    std::unordered_set<const DexType*> in_scope;
+    for (auto* cls : scope) {
+      in_scope.insert(cls->get_type());
+    }
+    for (auto* cls : scope) {
+      auto* super = cls->get_super_class();
+      if (super != nullptr && in_scope.count(super)) {
+        children[super].push_back(cls);
+        continue;
+      }
+      // Subtrees of internal classes that are not in scope are left
+      // unnumbered and fall back to walking the hierarchy.
+      auto* super_cls = super == nullptr ? nullptr : type_class(super);
+      if (super_cls == nullptr || super_cls->is_external()) {
+        roots.push_back(cls);
+      }
+    }
+    uint32_t counter = 0;
+    std::vector<std::pair<const DexClass*, size_t>> stack;
+    for (auto* root : roots) {
+      m_intervals[root->get_type()].first = counter++;
+      stack.emplace_back(root, 0);
+      while (!stack.empty()) {
+        auto& [cls, next_child] = stack.back();
+        auto it = children.find(cls->get_type());
+        if (it != children.end() && next_child < it->second.size()) {
+          auto* child = it->second[next_child++];
+          m_intervals[child->get_type()].first = counter++;
+          stack.emplace_back(child, 0);
+          continue;
+        }
+        m_intervals[cls->get_type()].second = counter++;
+        stack.pop_back();
+      }
+    }
+  }
+
+  boost::optional<int32_t> evaluate(const DexType* src_type,
+                                    const DexType* test_type) const {
+    auto src_it = m_intervals.find(src_type);
+    auto test_it = m_intervals.find(test_type);
+    if (src_it == m_intervals.end() || test_it == m_intervals.end() ||
+        test_type == src_type || test_type == type::java_lang_Object()) {
+      return type::evaluate_type_check(src_type, test_type);
+    }
+    // Mirrors type::evaluate_type_check for internal classes.
+    auto test_cls = type_class(test_type);
+    auto src_cls = type_class(src_type);
+    if (test_cls == nullptr || src_cls == nullptr || test_cls->is_external() ||
+        src_cls->is_external() || is_interface(test_cls) ||
+        is_interface(src_cls)) {
+      return type::evaluate_type_check(src_type, test_type);
+    }
+    if (nested(src_it->second, test_it->second)) {
+      return 1;
+    } else if (!nested(test_it->second, src_it->second)) {
+      return 0;
+    }
+    return boost::none;
+  }
+
+ private:
+  using Interval = std::pair<uint32_t, uint32_t>;
+
+  static bool nested(const Interval& inner, const Interval& outer) {
+    return outer.first <= inner.first && inner.second <= outer.second;
+  }
+
+  std::unordered_map<const DexType*, Interval> m_intervals;
+};
+
 namespace instance_of {
 
 // If we know that an instance-of will always be true (if the value is not
@@ -117,9 +200,7 @@ void analyze_true_instance_ofs(
     return;
   }
 
-  live_range::MoveAwareChains chains(cfg);
-  auto du_chains = chains.get_def_use_chains();
-  auto ud_chains = chains.get_use_def_chains();
+  live_range::LazyChains chains(cfg);
 
   for (const auto* mie : true_modulo_nulls) {
     auto def_it = cfg.find_insn(mie->insn);
@@ -128,11 +209,12 @@ void analyze_true_instance_ofs(
       continue;
     }
 
-    auto du_it = du_chains.find(mie->insn);
-    if (du_it == du_chains.end()) {
-      continue;
+    std::vector<live_range::Use> uses_vec;
+    {
+      auto def_uses = chains.get_uses(mie->insn);
+      uses_vec.assign(def_uses.begin(), def_uses.end());
     }
-    const auto* uses = &du_it->second;
+    const auto* uses = &uses_vec;
     if (uses->empty()) {
       continue;
     }
@@ -146,17 +228,17 @@ void analyze_true_instance_ofs(
     };
 
     bool any_multi_def = std::any_of(
-        uses->begin(), uses->end(), [&ud_chains, &mie](const auto& use) {
-          auto it = ud_chains.find(use);
-          if (it == ud_chains.end()) {
+        uses->begin(), uses->end(), [&chains, &mie](const auto& use) {
+          auto defs = chains.get_defs(use);
+          if (defs.empty()) {
             // Weird, fail.
             return true;
           }
-          if (it->second.size() != 1) {
+          if (defs.size() != 1) {
             return true;
           }
           // Just an integrity check.
-          redex_assert(*it->second.begin() == mie->insn);
+          redex_assert(defs.front() == mie->insn);
           return false;
         });
     if (any_multi_def) {
@@ -170,13 +252,10 @@ void analyze_true_instance_ofs(
         std::any_of(uses->begin(), uses->end(), [](const auto& use) {
           return opcode::is_a_move(use.insn->opcode());
         });
-    std::remove_cv_t<std::remove_pointer_t<decltype(uses)>> filtered_uses;
     if (has_moves) {
-      filtered_uses = *uses;
-      std20::erase_if(filtered_uses, [](const auto& it) {
+      std20::erase_if(uses_vec, [](const auto& it) {
         return opcode::is_a_move(it->insn->opcode());
       });
-      uses = &filtered_uses;
     }
 
     bool non_branch_uses =
@@ -222,7 +301,8 @@ void analyze_true_instance_ofs(
   }
 }
 
-RemoveResult analyze_and_evaluate_instance_of(DexMethod* method) {
+RemoveResult analyze_and_evaluate_instance_of(
+    DexMethod* method, const TypeCheckEvaluator& evaluator) {
   ScopedCFG cfg(method->get_code());
   CFGMutation mutation(*cfg);
 
@@ -262,7 +342,7 @@ RemoveResult analyze_and_evaluate_instance_of(DexMethod* method) {
         continue;
       }
 
-      auto eval = type::evaluate_type_check(*src_type_state, test_type);
+      auto eval = evaluator.evaluate(*src_type_state, test_type);
       if (!eval) {
         continue;
       }
@@ -351,7 +431,8 @@ void handle_false_case(IRInstruction* insn,
   ++res.class_always_fail;
 }
 
-RemoveResult analyze_and_evaluate(DexMethod* method) {
+RemoveResult analyze_and_evaluate(DexMethod* method,
+                                  const TypeCheckEvaluator& evaluator) {
   ScopedCFG cfg(method->get_code());
   CFGMutation mutation(*cfg);
 
@@ -390,7 +471,7 @@ RemoveResult analyze_and_evaluate(DexMethod* method) {
         continue;
       }
 
-      auto eval = type::evaluate_type_check(*src_type_state, test_type);
+      auto eval = evaluator.evaluate(*src_type_state, test_type);
       if (!eval) {
         continue;
       }
@@ -499,11 +580,13 @@ size_t post_process(DexMethod* method,
 
 RemoveResult optimize_impl(DexMethod* method,
                            XStoreRefs& xstores,
+                           const TypeCheckEvaluator& evaluator,
                            bool has_instance_of,
                            bool has_check_cast) {
   RemoveResult instance_of_res;
   if (has_instance_of) {
-    instance_of_res = instance_of::analyze_and_evaluate_instance_of(method);
+    instance_of_res =
+        instance_of::analyze_and_evaluate_instance_of(method, evaluator);
 
     if (instance_of_res.overrides != 0) {
       instance_of_res.insn_delta =
@@ -513,7 +596,7 @@ RemoveResult optimize_impl(DexMethod* method,
 
   RemoveResult check_cast_res;
   if (has_check_cast) {
-    check_cast_res = check_cast::analyze_and_evaluate(method);
+    check_cast_res = check_cast::analyze_and_evaluate(method, evaluator);
 
     if (check_cast_res.overrides != 0) {
       check_cast_res.insn_delta =
@@ -533,7 +616,7 @@ boost::optional<int32_t> EvaluateTypeChecksPass::evaluate(
 }
 
 void EvaluateTypeChecksPass::optimize(DexMethod* method, XStoreRefs& xstores) {
-  optimize_impl(method, xstores, true, true);
+  optimize_impl(method, xstores, TypeCheckEvaluator(), true, true);
 }
 
 void EvaluateTypeChecksPass::run_pass(DexStoresVector& stores,
@@ -541,9 +624,10 @@ void EvaluateTypeChecksPass::run_pass(DexStoresVector& stores,
                                       PassManager& mgr) {
   auto scope = build_class_scope(stores);
   XStoreRefs xstores(stores);
+  TypeCheckEvaluator evaluator(scope);
 
   auto stats = walk::parallel::methods<RemoveResult>(
-      scope, [&xstores](DexMethod* method) {
+      scope, [&xstores, &evaluator](DexMethod* method) {
         auto code = method->get_code();
         if (code == nullptr || method->rstate.no_optimizations()) {
           return RemoveResult{};
@@ -570,8 +654,8 @@ void EvaluateTypeChecksPass::run_pass(DexStoresVector& stores,
           return RemoveResult();
         }
 
-        auto res =
-            optimize_impl(method, xstores, has_insns.first, has_insns.second);
+        auto res = optimize_impl(method, xstores, evaluator, has_insns.first,
+                                 has_insns.second);
         res.methods_w_instanceof = 1;
         return res;
       });
@@ -9,13 +9,11 @@
 
 #include <algorithm>
 #include <boost/algorithm/string.hpp>
-#include <boost/multi_index/hashed_index.hpp>
-#include <boost/multi_index/member.hpp>
-#include <boost/multi_index_container.hpp>
-#include <boost/utility/string_view.hpp>
 #include <cstdint>
 #include <fstream>
 #include <mutex>
+#include <string_view>
+#include <unordered_map>
 
 #include "ConfigFiles.h"
 #include "DexClass.h"
@@ -45,52 +43,31 @@ source_blocks::InsertResult source_blocks(
                                              serialize, exc_inject);
 }
 
-using namespace boost::multi_index;
-
+// The per-method data of a block profile stays in the mapped file. The index
+// only records where each method's line is, keyed by the method name as it
+// appears in the file, so that nothing has to be resolved or parsed for
+// methods that are never looked up; the lookups happen from the parallel
+// insertion walk.
 struct ProfileFile {
   RedexMappedFile mapped_file;
   std::string interaction;
 
   using StringPos = std::pair<size_t, size_t>;
 
-  using MethodMeta = std::unordered_map<const DexMethodRef*, StringPos>;
-  MethodMeta method_meta;
-
-  // Consider std::string_view in C++17.
-  struct StringViewEquals {
-    bool operator()(const std::string& s1, const std::string& s2) const {
-      return s1 == s2;
-    }
-    bool operator()(const std::string& s1, const boost::string_view& v2) const {
-      return v2 == s1;
-    }
-    bool operator()(const boost::string_view& v1, const std::string& s2) const {
-      return v1 == s2;
-    }
-    bool operator()(const boost::string_view& v1,
-                    const boost::string_view& v2) const {
-      return v1 == v2;
-    }
-  };
-  using UnresolvedMethodMeta = multi_index_container<
-      std::pair<boost::string_view, StringPos>,
-      indexed_by<hashed_unique<
-          member<std::pair<boost::string_view, StringPos>,
-                 boost::string_view,
-                 &std::pair<boost::string_view, StringPos>::first>,
-          boost::hash<boost::string_view>,
-          StringViewEquals>>>;
-
-  UnresolvedMethodMeta unresolved_method_meta;
+  using MethodIndex = std::unordered_map<std::string_view, StringPos>;
+  MethodIndex method_index;
 
   ProfileFile(RedexMappedFile mapped_file,
               std::string interaction,
-              MethodMeta method_meta,
-              UnresolvedMethodMeta unresolved_method_meta)
+              MethodIndex method_index)
       : mapped_file(std::move(mapped_file)),
         interaction(std::move(interaction)),
-        method_meta(std::move(method_meta)),
-        unresolved_method_meta(std::move(unresolved_method_meta)) {}
+        method_index(std::move(method_index)) {}
+
+  const StringPos* find(std::string_view method_name) const {
+    auto it = method_index.find(method_name);
+    return it == method_index.end() ? nullptr : &it->second;
+  }
 
   static std::unique_ptr<ProfileFile> prepare_profile_file(
       const std::string& profile_file_name) {
@@ -98,10 +75,9 @@ struct ProfileFile {
       return std::unique_ptr<ProfileFile>();
     }
     auto file = RedexMappedFile::open(profile_file_name, /*read_only=*/true);
-    MethodMeta meta;
-    UnresolvedMethodMeta unresolved_meta;
+    MethodIndex index;
 
-    boost::string_view data{file.const_data(), file.size()};
+    std::string_view data{file.const_data(), file.size()};
     size_t pos = 0;
     std::string interaction;
 
@@ -121,7 +97,7 @@ struct ProfileFile {
         boost::split(split_vec, line, [](const auto& c) { return c == ','; });
         always_assert_log(num == 0 ? split_vec == exp : split_vec.size() == num,
                           "Unexpected line: %s (%s). Expected %s/%zu.",
-                          line.to_string().c_str(),
+                          std::string(line).c_str(),
                           boost::join(split_vec, "'").c_str(),
                           boost::join(exp, ",").c_str(), num);
         return split_vec;
@@ -146,33 +122,16 @@ struct ProfileFile {
         linefeed_pos = data.length();
       }
       pos = linefeed_pos + 1;
-      // Do not use pos anymore! Ensure by scope from lambda.
-      [&data, &src_pos, &linefeed_pos, &meta, &unresolved_meta]() {
-        size_t comma_pos = data.find(',', src_pos);
-        always_assert(comma_pos < linefeed_pos);
-
-        auto string_pos =
-            std::make_pair(comma_pos + 1, linefeed_pos - comma_pos - 1);
-
-        auto method_view = data.substr(src_pos, comma_pos - src_pos);
-        // Would be nice to avoid the conversion.
-        auto mref = DexMethod::get_method</*kCheckFormat=*/true>(
-            method_view.to_string());
-        if (mref == nullptr) {
-          TRACE(METH_PROF,
-                6,
-                "failed to resolve %s",
-                method_view.to_string().c_str());
-          unresolved_meta.emplace(method_view, string_pos);
-          return;
-        }
-        meta.emplace(mref, string_pos);
-      }();
+
+      size_t comma_pos = data.find(',', src_pos);
+      always_assert(comma_pos < linefeed_pos);
+      index.emplace(
+          data.substr(src_pos, comma_pos - src_pos),
+          std::make_pair(comma_pos + 1, linefeed_pos - comma_pos - 1));
     }
 
     return std::make_unique<ProfileFile>(
-        std::move(file), std::move(interaction), std::move(meta),
-        std::move(unresolved_meta));
+        std::move(file), std::move(interaction), std::move(index));
   }
 };
 
@@ -248,12 +207,13 @@ void run_source_blocks(DexStoresVector& stores,
     }
 
     bool found_one = false;
+    auto method_name = show(mref);
     for (auto& profile_file : profile_files) {
       auto val_opt =
           maybe_val_from_mp(method_profiles, profile_file->interaction, mref);
 
-      auto it = profile_file->method_meta.find(mref);
-      if (it == profile_file->method_meta.end()) {
+      const auto* pos = profile_file->find(method_name);
+      if (pos == nullptr) {
         if (always_inject) {
           TRACE(METH_PROF, 3,
                 "No basic block profile for %s. Always-inject=true, falling "
@@ -277,10 +237,9 @@ void run_source_blocks(DexStoresVector& stores,
         continue;
       }
       found_one = true;
-      const auto& pos = it->second;
       profiles.emplace_back(std::make_pair(
-          std::string(profile_file->mapped_file.const_data() + pos.first,
-                      pos.second),
+          std::string(profile_file->mapped_file.const_data() + pos->first,
+                      pos->second),
           val_opt));
       TRACE(METH_PROF, 3,
             "Found basic block profile for %s. Error fallback is %s.",
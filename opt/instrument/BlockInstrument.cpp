@@ -47,6 +47,8 @@ enum class BlockType {
   Catch = 1 << 4,
   MoveException = 1 << 5,
   NoSourceBlock = 1 << 6,
+  // Executed exactly when an instrumented block is, so it shares its bit.
+  Implied = 1 << 7,
 };
 
 enum class InstrumentedType {
@@ -101,6 +103,7 @@ struct MethodInfo {
   size_t num_catches = 0;
   size_t num_instrumented_catches = 0;
   size_t num_instrumented_blocks = 0;
+  size_t num_implied_blocks = 0;
 
   std::vector<cfg::BlockId> bit_id_2_block_id;
   std::vector<std::vector<SourceBlock*>> bit_id_2_source_blocks;
@@ -510,6 +513,29 @@ BlockInfo create_block_info(cfg::Block* block,
   return {block, BlockType::Instrumentable | type, insert_pos};
 }
 
+// Returns the only predecessor of `b` if control always goes from it to `b`
+// once it has started: it has no other successor, and it cannot throw. Then
+// the two blocks are executed equally often, and one probe covers both.
+cfg::Block* get_implying_block(const cfg::Block* b) {
+  if (b->preds().size() != 1) {
+    return nullptr;
+  }
+  const auto* edge = b->preds().front();
+  if (edge->type() != cfg::EDGE_GOTO) {
+    return nullptr;
+  }
+  auto* pred = edge->src();
+  if (pred->succs().size() != 1) {
+    return nullptr;
+  }
+  for (const auto& mie : InstructionIterable(pred)) {
+    if (opcode::can_throw(mie.insn->opcode())) {
+      return nullptr;
+    }
+  }
+  return pred;
+}
+
 auto get_blocks_to_instrument(const cfg::ControlFlowGraph& cfg,
                               const size_t max_num_blocks,
                               const InstrumentPass::Options& options) {
@@ -527,7 +553,7 @@ auto get_blocks_to_instrument(const cfg::ControlFlowGraph& cfg,
     //
     // So, don't add entry block if it is not in any try-catch.
     if (cfg.entry_block() == b &&
-        cfg.entry_block()->get_outgoing_throws_in_order().empty()) {
+        cfg.get_succ_edge_of_type(b, cfg::EDGE_THROW) == nullptr) {
       return;
     }
     blocks.push_back(b);
@@ -536,13 +562,25 @@ auto get_blocks_to_instrument(const cfg::ControlFlowGraph& cfg,
       &cfg, block_start_fn, [](cfg::Block*, const cfg::Edge*) {},
       [](cfg::Block*) {});
 
-  // Future work: Pick minimal instrumentation candidates.
   std::vector<BlockInfo> block_info_list;
   block_info_list.reserve(blocks.size());
+  // The bit of each instrumented or implied block. Blocks are visited in DFS
+  // order, so an implying block is always visited before the blocks it
+  // implies.
+  std::unordered_map<const cfg::Block*, BitId> block_bits;
   BitId id = 0;
   for (cfg::Block* b : blocks) {
     block_info_list.emplace_back(create_block_info(b, options));
     auto& info = block_info_list.back();
+    if (options.elide_implied_blocks && info.is_instrumentable()) {
+      auto it = block_bits.find(get_implying_block(b));
+      if (it != block_bits.end()) {
+        info.type = BlockType::Implied | BlockType::Normal;
+        info.bit_id = it->second;
+        block_bits.emplace(b, it->second);
+        continue;
+      }
+    }
     if ((info.type & BlockType::Instrumentable) == BlockType::Instrumentable) {
       if (id >= max_num_blocks) {
         // This is effectively rejecting all blocks.
@@ -550,6 +588,7 @@ auto get_blocks_to_instrument(const cfg::ControlFlowGraph& cfg,
                                true /* too many block */);
       }
       info.bit_id = id++;
+      block_bits.emplace(b, info.bit_id);
     }
   }
   return std::make_tuple(block_info_list, id, false);
@@ -654,6 +693,7 @@ MethodInfo instrument_basic_blocks(IRCode& code,
   info.num_instrumented_catches =
       count(BlockType::Catch | BlockType::Instrumentable);
   info.num_instrumented_blocks = num_to_instrument;
+  info.num_implied_blocks = count(BlockType::Implied);
   always_assert(count(BlockType::Instrumentable) == num_to_instrument);
 
   info.bit_id_2_block_id.reserve(num_to_instrument);
@@ -665,12 +705,19 @@ MethodInfo instrument_basic_blocks(IRCode& code,
           source_blocks::gather_source_blocks(i.block));
     } else {
       info.rejected_blocks[i.block->id()] = i.type;
+      if ((i.type & BlockType::Implied) == BlockType::Implied) {
+        // The implying block's bit also stands for this block's source blocks.
+        auto sbs = source_blocks::gather_source_blocks(i.block);
+        auto& bit_sbs = info.bit_id_2_source_blocks.at(i.bit_id);
+        bit_sbs.insert(bit_sbs.end(), sbs.begin(), sbs.end());
+      }
     }
   }
 
   const size_t num_rejected_blocks =
       info.num_empty_blocks + info.num_useless_blocks +
       info.num_no_source_blocks + info.num_blocks_too_large +
+      info.num_implied_blocks +
       (info.num_catches - info.num_instrumented_catches);
   always_assert(info.num_non_entry_blocks ==
                 info.num_instrumented_blocks + num_rejected_blocks);
@@ -892,6 +939,12 @@ void print_stats(ScopedMetrics& sm,
       TRACE(INSTRUMENT, 4, "- Skipped useless blocks: %s",
             SHOW(print_ratio(useless_blocks)));
       metric_ratio("useless_blocks", useless_blocks);
+      auto implied_blocks = std::accumulate(
+          instrumented_methods.begin(), instrumented_methods.end(), size_t(0),
+          [](size_t a, auto&& i) { return a + i.num_implied_blocks; });
+      TRACE(INSTRUMENT, 4, "- Skipped implied blocks: %s",
+            SHOW(print_ratio(implied_blocks)));
+      metric_ratio("implied_blocks", implied_blocks);
     }
   }
 
@@ -1141,20 +1194,21 @@ void BlockInstrumentHelper::do_basic_block_tracing(
   });
 
   // Patch static fields.
-  const auto field_name = array_fields.at(1)->get_name()->str();
+  const auto field_name = array_fields.at(1)->get_name()->str_copy();
   InstrumentPass::patch_array_size(analysis_cls, field_name, method_offset);
 
   auto* field = analysis_cls->find_field_from_simple_deobfuscated_name(
       "sNumStaticallyInstrumented");
   always_assert(field != nullptr);
-  InstrumentPass::patch_static_field(analysis_cls, field->get_name()->str(),
+  InstrumentPass::patch_static_field(analysis_cls,
+                                     field->get_name()->str_copy(),
                                      instrumented_methods.size());
 
   field =
       analysis_cls->find_field_from_simple_deobfuscated_name("sProfileType");
   always_assert(field != nullptr);
   InstrumentPass::patch_static_field(
-      analysis_cls, field->get_name()->str(),
+      analysis_cls, field->get_name()->str_copy(),
       static_cast<int>(ProfileTypeFlags::BasicBlockTracing));
 
   write_metadata(cfg, options.metadata_file_name, instrumented_methods);
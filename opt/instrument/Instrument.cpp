@@ -8,12 +8,14 @@
 #include "Instrument.h"
 
 #include "BlockInstrument.h"
+#include "ConfigFiles.h"
 #include "DexClass.h"
 #include "DexUtil.h"
 #include "IRList.h"
 #include "InterDexPass.h"
 #include "InterDexPassPlugin.h"
 #include "Match.h"
+#include "MethodProfiles.h"
 #include "MethodReference.h"
 #include "PassManager.h"
 #include "Show.h"
@@ -111,9 +113,54 @@ bool match_class_name(std::string cls_name,
   return false;
 }
 
+// A method is hot if it appears in at least min_appear_percent of the samples
+// of any profiled interaction.
+bool is_hot_method(const method_profiles::MethodProfiles& profiles,
+                   const DexMethod* method,
+                   double min_appear_percent) {
+  for (const auto& [interaction_id, stats_map] : profiles.all_interactions()) {
+    auto it = stats_map.find(method);
+    if (it != stats_map.end() &&
+        it->second.appear_percent >= min_appear_percent) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Create a static int field in the analysis class that sampled probes count
+// down. The field is deliberately racy: a lost update only perturbs the
+// sampling, and a plain static is far cheaper than a ThreadLocal in Java.
+DexField* make_sampling_countdown_field(DexClass* analysis_cls,
+                                        const std::string& name) {
+  auto* field = static_cast<DexField*>(
+      DexField::make_field(analysis_cls->get_type(),
+                           DexString::make_string(name),
+                           DexType::make_type("I")));
+  field->set_deobfuscated_name(show_deobfuscated(field));
+  field->make_concrete(ACC_PUBLIC | ACC_STATIC);
+  analysis_cls->add_field(field);
+  TRACE(INSTRUMENT, 2, "Created sampling countdown: %s", SHOW(field));
+  return field;
+}
+
+// If countdown_field is given, only every sampling_interval-th entry calls the
+// analysis method:
+//
+//   sget v0, countdown_field
+//   add-int/lit8 v0, v0, -1
+//   sput v0, countdown_field
+//   if-gtz v0, :skip
+//   const v0, sampling_interval
+//   sput v0, countdown_field
+//   const v1, index
+//   invoke-static {v1}, method_onMethodBegin
+//   :skip
 void instrument_onMethodBegin(DexMethod* method,
                               int index,
-                              DexMethod* method_onMethodBegin) {
+                              DexMethod* method_onMethodBegin,
+                              DexField* countdown_field = nullptr,
+                              int64_t sampling_interval = 1) {
   IRCode* code = method->get_code();
   assert(code != nullptr);
 
@@ -155,8 +202,41 @@ void instrument_onMethodBegin(DexMethod* method,
     // Otherwise, insert_point can be used directly.
   }
 
-  code->insert_before(code->insert_before(insert_point, invoke_inst),
-                      const_inst);
+  if (countdown_field == nullptr) {
+    code->insert_before(code->insert_before(insert_point, invoke_inst),
+                        const_inst);
+  } else {
+    const auto reg_count = code->allocate_temp();
+    code->insert_before(insert_point,
+                        (new IRInstruction(OPCODE_SGET))
+                            ->set_field(countdown_field));
+    code->insert_before(
+        insert_point,
+        (new IRInstruction(IOPCODE_MOVE_RESULT_PSEUDO))->set_dest(reg_count));
+    code->insert_before(insert_point,
+                        (new IRInstruction(OPCODE_ADD_INT_LIT8))
+                            ->set_dest(reg_count)
+                            ->set_src(0, reg_count)
+                            ->set_literal(-1));
+    code->insert_before(insert_point,
+                        (new IRInstruction(OPCODE_SPUT))
+                            ->set_src(0, reg_count)
+                            ->set_field(countdown_field));
+    auto if_it = code->insert_before(
+        insert_point,
+        (new IRInstruction(OPCODE_IF_GTZ))->set_src(0, reg_count));
+    code->insert_before(insert_point,
+                        (new IRInstruction(OPCODE_CONST))
+                            ->set_dest(reg_count)
+                            ->set_literal(sampling_interval));
+    code->insert_before(insert_point,
+                        (new IRInstruction(OPCODE_SPUT))
+                            ->set_src(0, reg_count)
+                            ->set_field(countdown_field));
+    code->insert_before(insert_point, const_inst);
+    code->insert_before(insert_point, invoke_inst);
+    code->insert_before(insert_point, new BranchTarget(&*if_it));
+  }
 
   if (instr_debug) {
     for (auto it = code->begin(); it != code->end(); ++it) {
@@ -207,13 +287,13 @@ void do_simple_method_tracing(DexClass* analysis_cls,
   std::vector<DexMethod*> to_instrument;
 
   auto worker = [&](DexMethod* method, size_t& total_size) -> int {
-    const auto& name = method->get_deobfuscated_name();
+    const auto name = method->get_deobfuscated_name_copy();
     always_assert_log(
         !name.empty(),
         "Deobfuscated method name can't be empty: obfuscated "
         "name: %s, class: \'%s\'(%s)",
         SHOW(method->get_name()),
-        SHOW(type_class(method->get_class())->get_deobfuscated_name()),
+        SHOW(type_class(method->get_class())->get_deobfuscated_name_copy()),
         SHOW(method->get_class()->get_name()));
     always_assert_log(
         !method_names.count(name),
@@ -231,7 +311,7 @@ void do_simple_method_tracing(DexClass* analysis_cls,
     total_size += sum_opcode_sizes;
 
     // Excluding analysis methods myselves.
-    if (analysis_method_names.count(method->get_name()->str()) ||
+    if (analysis_method_names.count(method->get_name()->str_copy()) ||
         method == analysis_cls->get_clinit()) {
       ++excluded;
       TRACE(INSTRUMENT, 2, "Excluding analysis method: %s", SHOW(method));
@@ -298,7 +378,7 @@ void do_simple_method_tracing(DexClass* analysis_cls,
   //  1) For all methods, collect (method id, method) pairs and write meta data.
   //  2) Do actual instrumentation.
   for (const auto& cls : scope) {
-    const auto& cls_name = cls->get_deobfuscated_name();
+    const auto cls_name = cls->get_deobfuscated_name_copy();
     always_assert_log(
         !method_names.count(cls_name),
         "Deobfuscated class names must be unique, but found duplicate: %s",
@@ -346,12 +426,51 @@ void do_simple_method_tracing(DexClass* analysis_cls,
   const size_t kTotalSize = to_instrument.size();
   TRACE(INSTRUMENT, 2, "%zu methods to be instrumented; shard size: %zu (+1)",
         kTotalSize, kTotalSize / NUM_SHARDS);
+  //
+  // In sampling mode, hot and cold methods count down separate fields so that
+  // the frequent entries of hot methods don't starve the sampling of the rest.
+  always_assert(options.hot_method_sampling_interval >= 1 &&
+                options.cold_method_sampling_interval >= 1);
+  const auto& method_profiles = cfg.get_method_profiles();
+  DexField* hot_countdown = nullptr;
+  DexField* cold_countdown = nullptr;
+  if (options.hot_method_sampling_interval > 1) {
+    hot_countdown =
+        make_sampling_countdown_field(analysis_cls, "sHotSampleCountdown");
+  }
+  if (options.cold_method_sampling_interval > 1) {
+    cold_countdown =
+        make_sampling_countdown_field(analysis_cls, "sColdSampleCountdown");
+  }
+  size_t sampled_hot = 0;
+  size_t sampled_cold = 0;
   for (size_t i = 0; i < kTotalSize; ++i) {
     TRACE(INSTRUMENT, 6, "Sharded %zu => [%zu][%zu] %s", i, (i % NUM_SHARDS),
           (i / NUM_SHARDS), SHOW(to_instrument[i]));
+    DexField* countdown = nullptr;
+    int64_t sampling_interval = 1;
+    if (hot_countdown != nullptr || cold_countdown != nullptr) {
+      bool is_hot =
+          method_profiles.has_stats() &&
+          is_hot_method(method_profiles, to_instrument[i],
+                        options.sampling_hot_method_min_appear_percent);
+      countdown = is_hot ? hot_countdown : cold_countdown;
+      sampling_interval = is_hot ? options.hot_method_sampling_interval
+                                 : options.cold_method_sampling_interval;
+    }
+    if (countdown != nullptr) {
+      if (countdown == hot_countdown) {
+        ++sampled_hot;
+      } else {
+        ++sampled_cold;
+      }
+      // Let the uploader scale the sampled counts back up.
+      ofs << "S," << i << "," << sampling_interval << "\n";
+    }
     instrument_onMethodBegin(to_instrument[i],
                              (i / NUM_SHARDS) * options.num_stats_per_method,
-                             analysis_method_map.at((i % NUM_SHARDS) + 1));
+                             analysis_method_map.at((i % NUM_SHARDS) + 1),
+                             countdown, sampling_interval);
   }
 
   TRACE(INSTRUMENT,
@@ -364,7 +483,7 @@ void do_simple_method_tracing(DexClass* analysis_cls,
   for (size_t i = 0; i < NUM_SHARDS; ++i) {
     size_t n = kTotalSize / NUM_SHARDS + (i < kTotalSize % NUM_SHARDS ? 1 : 0);
     // Get obfuscated name corresponding to each sMethodStat[1-N] field.
-    const auto field_name = array_fields.at(i + 1)->get_name()->str();
+    const auto field_name = array_fields.at(i + 1)->get_name()->str_copy();
     InstrumentPass::patch_array_size(analysis_cls, field_name,
                                      options.num_stats_per_method * n);
   }
@@ -374,14 +493,14 @@ void do_simple_method_tracing(DexClass* analysis_cls,
   auto field = analysis_cls->find_field_from_simple_deobfuscated_name(
       "sNumStaticallyInstrumented");
   always_assert(field != nullptr);
-  InstrumentPass::patch_static_field(analysis_cls, field->get_name()->str(),
-                                     kTotalSize);
+  InstrumentPass::patch_static_field(analysis_cls,
+                                     field->get_name()->str_copy(), kTotalSize);
 
   field =
       analysis_cls->find_field_from_simple_deobfuscated_name("sProfileType");
   always_assert(field != nullptr);
   InstrumentPass::patch_static_field(
-      analysis_cls, field->get_name()->str(),
+      analysis_cls, field->get_name()->str_copy(),
       static_cast<int>(ProfileTypeFlags::SimpleMethodTracing));
 
   ofs.close();
@@ -389,6 +508,8 @@ void do_simple_method_tracing(DexClass* analysis_cls,
 
   pm.incr_metric("Instrumented", method_id);
   pm.incr_metric("Excluded", excluded);
+  pm.incr_metric("sampled_hot_methods", sampled_hot);
+  pm.incr_metric("sampled_cold_methods", sampled_cold);
 }
 
 std::unordered_set<std::string> load_blocklist_file(
@@ -574,6 +695,20 @@ void InstrumentPass::bind_config() {
        m_options.instrument_blocks_without_source_block);
   bind("instrument_only_root_store", false,
        m_options.instrument_only_root_store);
+  bind("elide_implied_blocks", false, m_options.elide_implied_blocks,
+       "Don't probe blocks that always execute together with their only "
+       "predecessor; its bit covers both.");
+  bind("hot_method_sampling_interval", 1,
+       m_options.hot_method_sampling_interval,
+       "With simple_method_tracing, only record one in this many entries of "
+       "hot methods. 1 records every entry.");
+  bind("cold_method_sampling_interval", 1,
+       m_options.cold_method_sampling_interval,
+       "Like hot_method_sampling_interval, for all other methods.");
+  bind("sampling_hot_method_min_appear_percent", 50.0f,
+       m_options.sampling_hot_method_min_appear_percent,
+       "Methods that appear in at least this percentage of the samples of "
+       "some profiled interaction are sampled as hot.");
 
   size_t max_analysis_methods;
   if (m_options.instrumentation_strategy == SIMPLE_METHOD_TRACING) {
@@ -618,7 +753,7 @@ bool InstrumentPass::is_included(const DexMethod* method,
   }
 
   // Try to check for method by its full name.
-  const auto& full_method_name = method->get_deobfuscated_name();
+  const auto full_method_name = method->get_deobfuscated_name_copy();
   if (set.count(full_method_name)) {
     return true;
   }
@@ -656,7 +791,8 @@ InstrumentPass::generate_sharded_analysis_methods(
     exit(1);
   }
 
-  const std::string& template_method_name = template_method->get_name()->str();
+  const std::string template_method_name =
+      template_method->get_name()->str_copy();
 
   std::unordered_map<int /*shard_num*/, DexMethod*> new_analysis_methods;
   std::unordered_set<std::string> method_names;
@@ -664,7 +800,8 @@ InstrumentPass::generate_sharded_analysis_methods(
   // Even if one shard, we create a new method from the template method.
   for (size_t i = 1; i <= num_shards; ++i) {
     const auto new_name = template_method_name + std::to_string(i);
-    std::string deobfuscated_name = template_method->get_deobfuscated_name();
+    std::string deobfuscated_name =
+        template_method->get_deobfuscated_name_copy();
     boost::replace_first(deobfuscated_name, template_method_name, new_name);
 
     DexMethod* new_method =
@@ -752,7 +889,7 @@ InstrumentPass::patch_sharded_arrays(
               suggested_names.count(i)
                   ? suggested_names.at(i)
                   : InstrumentPass::STATS_FIELD_NAME + std::to_string(i);
-          auto deobfuscated_name = template_field->get_deobfuscated_name();
+          auto deobfuscated_name = template_field->get_deobfuscated_name_copy();
           boost::replace_first(deobfuscated_name,
                                InstrumentPass::STATS_FIELD_NAME, new_name);
 
@@ -810,7 +947,8 @@ InstrumentPass::patch_sharded_arrays(
   auto field =
       cls->find_field_from_simple_deobfuscated_name("sMethodStatsArray");
   always_assert(field != nullptr);
-  InstrumentPass::patch_array_size(cls, field->get_name()->str(), num_shards);
+  InstrumentPass::patch_array_size(cls, field->get_name()->str_copy(),
+                                   num_shards);
   patched = false;
   walk::matching_opcodes_in_block(
       *clinit,
@@ -75,7 +75,11 @@ class InstrumentPass : public Pass {
     int64_t max_num_blocks;
     bool instrument_catches;
     bool instrument_blocks_without_source_block;
+    bool elide_implied_blocks;
     bool instrument_only_root_store;
+    int64_t hot_method_sampling_interval;
+    int64_t cold_method_sampling_interval;
+    float sampling_hot_method_min_appear_percent;
   };
 
  private:
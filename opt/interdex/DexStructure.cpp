@@ -81,25 +81,50 @@ unsigned estimate_linear_alloc(const DexClass* clazz) {
   return lasize;
 }
 
-/**
- * Removes the elements of b from a. Runs in O(size(a)), so it works best if
- * size(a) << size(b).
- */
-template <typename T>
-std::unordered_set<T> set_difference(const std::unordered_set<T>& a,
-                                     const std::unordered_set<T>& b) {
-  std::unordered_set<T> result;
-  for (auto& v : a) {
-    if (!b.count(v)) {
-      result.emplace(v);
+} // namespace
+
+namespace interdex {
+
+size_t RefBitset::count_missing(const RefIds& ids) const {
+  size_t missing = 0;
+  // The ids are sorted, so we gather the bits of the ids that fall into the
+  // same word, and count those that are not set yet at once.
+  for (auto it = ids.begin(); it != ids.end();) {
+    size_t word = *it / 64;
+    uint64_t bits = 0;
+    for (; it != ids.end() && *it / 64 == word; ++it) {
+      bits |= uint64_t(1) << (*it % 64);
+    }
+    if (word < m_words.size()) {
+      bits &= ~m_words[word];
     }
+    missing += __builtin_popcountll(bits);
   }
-  return result;
+  return missing;
 }
 
-} // namespace
+void RefBitset::insert(const RefIds& ids) {
+  if (ids.empty()) {
+    return;
+  }
+  size_t num_words = ids.back() / 64 + 1;
+  if (m_words.size() < num_words) {
+    m_words.resize(num_words);
+  }
+  for (auto id : ids) {
+    uint64_t& word = m_words[id / 64];
+    uint64_t bit = uint64_t(1) << (id % 64);
+    m_size += (word & bit) == 0;
+    word |= bit;
+  }
+}
 
-namespace interdex {
+void RefBitset::erase(uint32_t id) {
+  if (contains(id)) {
+    m_words[id / 64] &= ~(uint64_t(1) << (id % 64));
+    m_size--;
+  }
+}
 
 bool DexesStructure::add_class_to_current_dex(const MethodRefs& clazz_mrefs,
                                               const FieldRefs& clazz_frefs,
@@ -108,11 +133,14 @@ bool DexesStructure::add_class_to_current_dex(const MethodRefs& clazz_mrefs,
   always_assert_log(m_classes.count(clazz) == 0,
                     "Can't emit the same class twice! %s", SHOW(clazz));
 
+  auto mref_ids = m_mrefs.get_ids(clazz_mrefs);
+  auto fref_ids = m_frefs.get_ids(clazz_frefs);
   if (m_current_dex.add_class_if_fits(
-          clazz_mrefs, clazz_frefs, clazz_trefs, m_linear_alloc_limit,
-          MAX_FIELD_REFS - m_reserve_frefs, MAX_METHOD_REFS - m_reserve_mrefs,
+          mref_ids, fref_ids, m_trefs.get_ids(clazz_trefs),
+          m_linear_alloc_limit, MAX_FIELD_REFS - m_reserve_frefs,
+          MAX_METHOD_REFS - m_reserve_mrefs,
           MAX_TYPE_REFS(m_min_sdk) - m_reserve_trefs, clazz)) {
-    update_stats(clazz_mrefs, clazz_frefs, clazz);
+    update_stats(mref_ids, fref_ids, clazz);
     m_classes.emplace(clazz);
     return true;
   }
@@ -128,10 +156,13 @@ void DexesStructure::add_class_no_checks(const MethodRefs& clazz_mrefs,
                     "Can't emit the same class twice: %s!\n", SHOW(clazz));
 
   auto laclazz = estimate_linear_alloc(clazz);
-  m_current_dex.add_class_no_checks(clazz_mrefs, clazz_frefs, clazz_trefs,
-                                    laclazz, clazz);
+  auto mref_ids = m_mrefs.get_ids(clazz_mrefs);
+  auto fref_ids = m_frefs.get_ids(clazz_frefs);
+  m_current_dex.add_class_no_checks(mref_ids, fref_ids,
+                                    m_trefs.get_ids(clazz_trefs), laclazz,
+                                    clazz);
   m_classes.emplace(clazz);
-  update_stats(clazz_mrefs, clazz_frefs, clazz);
+  update_stats(mref_ids, fref_ids, clazz);
 }
 
 DexClasses DexesStructure::end_dex(DexInfo dex_info) {
@@ -153,7 +184,7 @@ DexClasses DexesStructure::end_dex(DexInfo dex_info) {
     m_info.num_scroll_dexes++;
   }
 
-  m_current_dex.check_refs_count();
+  check_refs_count();
 
   DexClasses all_classes = m_current_dex.take_all_classes();
 
@@ -161,8 +192,8 @@ DexClasses DexesStructure::end_dex(DexInfo dex_info) {
   return all_classes;
 }
 
-void DexesStructure::update_stats(const MethodRefs& clazz_mrefs,
-                                  const FieldRefs& clazz_frefs,
+void DexesStructure::update_stats(const RefIds& clazz_mrefs,
+                                  const RefIds& clazz_frefs,
                                   DexClass* clazz) {
   for (DexMethod* method : clazz->get_dmethods()) {
     if (is_static(method)) {
@@ -175,9 +206,9 @@ void DexesStructure::update_stats(const MethodRefs& clazz_mrefs,
   m_stats.num_frefs += clazz_frefs.size();
 }
 
-bool DexStructure::add_class_if_fits(const MethodRefs& clazz_mrefs,
-                                     const FieldRefs& clazz_frefs,
-                                     const TypeRefs& clazz_trefs,
+bool DexStructure::add_class_if_fits(const RefIds& clazz_mrefs,
+                                     const RefIds& clazz_frefs,
+                                     const RefIds& clazz_trefs,
                                      size_t linear_alloc_limit,
                                      size_t field_refs_limit,
                                      size_t method_refs_limit,
@@ -193,31 +224,30 @@ bool DexStructure::add_class_if_fits(const MethodRefs& clazz_mrefs,
     return false;
   }
 
-  auto extra_mrefs = set_difference(clazz_mrefs, m_mrefs);
-  auto extra_frefs = set_difference(clazz_frefs, m_frefs);
-  auto extra_trefs = set_difference(clazz_trefs, m_trefs);
-
-  if (m_mrefs.size() + extra_mrefs.size() >= method_refs_limit) {
+  size_t num_mrefs = m_mrefs.size() + m_mrefs.count_missing(clazz_mrefs);
+  if (num_mrefs >= method_refs_limit) {
     TRACE(IDEX, 6,
           "[warning]: Class won't fit current dex since it will go "
           "over the method refs limit: %zu >= %zu: %s",
-          m_mrefs.size() + extra_mrefs.size(), method_refs_limit, SHOW(clazz));
+          num_mrefs, method_refs_limit, SHOW(clazz));
     return false;
   }
 
-  if (m_frefs.size() + extra_frefs.size() >= field_refs_limit) {
+  size_t num_frefs = m_frefs.size() + m_frefs.count_missing(clazz_frefs);
+  if (num_frefs >= field_refs_limit) {
     TRACE(IDEX, 6,
           "[warning]: Class won't fit current dex since it will go "
           "over the field refs limit: %zu >= %zu: %s",
-          m_frefs.size() + extra_frefs.size(), field_refs_limit, SHOW(clazz));
+          num_frefs, field_refs_limit, SHOW(clazz));
     return false;
   }
 
-  if (m_trefs.size() + extra_trefs.size() >= type_refs_limit) {
+  size_t num_trefs = m_trefs.size() + m_trefs.count_missing(clazz_trefs);
+  if (num_trefs >= type_refs_limit) {
     TRACE(IDEX, 6,
           "[warning]: Class won't fit current dex since it will go "
           "over the type refs limit: %zu >= %zu: %s",
-          m_trefs.size() + extra_trefs.size(), type_refs_limit, SHOW(clazz));
+          num_trefs, type_refs_limit, SHOW(clazz));
     return false;
   }
 
@@ -225,38 +255,35 @@ bool DexStructure::add_class_if_fits(const MethodRefs& clazz_mrefs,
   return true;
 }
 
-void DexStructure::add_class_no_checks(const MethodRefs& clazz_mrefs,
-                                       const FieldRefs& clazz_frefs,
-                                       const TypeRefs& clazz_trefs,
+void DexStructure::add_class_no_checks(const RefIds& clazz_mrefs,
+                                       const RefIds& clazz_frefs,
+                                       const RefIds& clazz_trefs,
                                        unsigned laclazz,
                                        DexClass* clazz) {
   TRACE(IDEX, 7, "Adding class: %s", SHOW(clazz));
-  m_mrefs.insert(clazz_mrefs.begin(), clazz_mrefs.end());
-  m_frefs.insert(clazz_frefs.begin(), clazz_frefs.end());
-  m_trefs.insert(clazz_trefs.begin(), clazz_trefs.end());
+  m_mrefs.insert(clazz_mrefs);
+  m_frefs.insert(clazz_frefs);
+  m_trefs.insert(clazz_trefs);
   m_linear_alloc_size += laclazz;
   m_classes.push_back(clazz);
 }
 
-/*
- * Sanity check: did gather_refs return all the refs that ultimately ended up
- * in the dex?
- */
-void DexStructure::check_refs_count() {
+void DexesStructure::check_refs_count() const {
   if (!traceEnabled(IDEX, 4)) {
     return;
   }
 
   std::vector<DexMethodRef*> mrefs;
-  for (DexClass* cls : m_classes) {
+  for (DexClass* cls : m_current_dex.get_all_classes()) {
     cls->gather_methods(mrefs);
   }
   std::unordered_set<DexMethodRef*> mrefs_set(mrefs.begin(), mrefs.end());
-  if (mrefs_set.size() > m_mrefs.size()) {
+  if (mrefs_set.size() > m_current_dex.get_num_mrefs()) {
     std::vector<DexMethodRef*> mrefs_vec(mrefs_set.begin(), mrefs_set.end());
     std::sort(mrefs_vec.begin(), mrefs_vec.end(), compare_dexmethods);
     for (DexMethodRef* mr : mrefs_vec) {
-      if (!m_mrefs.count(mr)) {
+      auto id = m_mrefs.find_id(mr);
+      if (!id || !m_current_dex.has_mref(*id)) {
         TRACE(IDEX, 4, "WARNING: Could not find %s in predicted mrefs set",
               SHOW(mr));
       }
@@ -264,15 +291,16 @@ void DexStructure::check_refs_count() {
   }
 
   std::vector<DexFieldRef*> frefs;
-  for (DexClass* cls : m_classes) {
+  for (DexClass* cls : m_current_dex.get_all_classes()) {
     cls->gather_fields(frefs);
   }
   std::unordered_set<DexFieldRef*> frefs_set(frefs.begin(), frefs.end());
-  if (frefs_set.size() > m_frefs.size()) {
+  if (frefs_set.size() > m_current_dex.get_num_frefs()) {
     std::vector<DexFieldRef*> frefs_vec(frefs_set.begin(), frefs_set.end());
     std::sort(frefs_vec.begin(), frefs_vec.end(), compare_dexfields);
     for (auto* fr : frefs_vec) {
-      if (!m_frefs.count(fr)) {
+      auto id = m_frefs.find_id(fr);
+      if (!id || !m_current_dex.has_fref(*id)) {
         TRACE(IDEX, 4, "WARNING: Could not find %s in predicted frefs set",
               SHOW(fr));
       }
@@ -282,7 +310,7 @@ void DexStructure::check_refs_count() {
   // TODO: do we need to re-check linear_alloc_limit?
 }
 
-void DexStructure::squash_empty_last_class(DexClass* clazz) {
+void DexStructure::squash_empty_last_class(DexClass* clazz, uint32_t type_id) {
   always_assert(m_classes.back() == clazz);
   always_assert(clazz->get_dmethods().empty());
   always_assert(clazz->get_vmethods().empty());
@@ -290,7 +318,7 @@ void DexStructure::squash_empty_last_class(DexClass* clazz) {
   always_assert(clazz->get_ifields().empty());
   always_assert(!is_interface(clazz));
   m_classes.pop_back();
-  m_trefs.erase(clazz->get_type());
+  m_trefs.erase(type_id);
   m_squashed_classes.push_back(clazz);
 }
 
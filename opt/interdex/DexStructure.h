@@ -7,6 +7,10 @@
 
 #pragma once
 
+#include <algorithm>
+#include <boost/optional.hpp>
+#include <cstdint>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -16,9 +20,73 @@
 
 namespace interdex {
 
-using MethodRefs = std::unordered_set<DexMethodRef*>;
-using FieldRefs = std::unordered_set<DexFieldRef*>;
-using TypeRefs = std::unordered_set<DexType*>;
+// The refs of a class, possibly with duplicates.
+using MethodRefs = std::vector<DexMethodRef*>;
+using FieldRefs = std::vector<DexFieldRef*>;
+using TypeRefs = std::vector<DexType*>;
+
+// Sorted ids of refs, without duplicates, see RefIndexer.
+using RefIds = std::vector<uint32_t>;
+
+/*
+ * Assigns dense ids to refs, in order of first appearance, so that the refs
+ * of a dex can be represented as a RefBitset. Each ref is hashed once per
+ * class that refers to it, instead of once per set it is looked up in.
+ */
+template <typename Ref>
+class RefIndexer {
+ public:
+  RefIds get_ids(const std::vector<Ref*>& refs) {
+    RefIds ids;
+    ids.reserve(refs.size());
+    for (auto* ref : refs) {
+      ids.push_back(get_id(ref));
+    }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    return ids;
+  }
+
+  uint32_t get_id(Ref* ref) {
+    return m_ids.emplace(ref, m_ids.size()).first->second;
+  }
+
+  boost::optional<uint32_t> find_id(Ref* ref) const {
+    auto it = m_ids.find(ref);
+    if (it == m_ids.end()) {
+      return boost::none;
+    }
+    return it->second;
+  }
+
+ private:
+  std::unordered_map<Ref*, uint32_t> m_ids;
+};
+
+/*
+ * A set of ref ids. Checking whether the refs of a class fit in a dex only
+ * needs to count the bits of the class that are not set yet, word by word.
+ */
+class RefBitset {
+ public:
+  size_t size() const { return m_size; }
+
+  bool contains(uint32_t id) const {
+    size_t word = id / 64;
+    return word < m_words.size() && (m_words[word] >> (id % 64) & 1);
+  }
+
+  // The number of the given ids that are not in the set.
+  size_t count_missing(const RefIds& ids) const;
+
+  void insert(const RefIds& ids);
+
+  void erase(uint32_t id);
+
+ private:
+  std::vector<uint64_t> m_words;
+  size_t m_size{0};
+};
 
 struct DexInfo {
   bool primary{false};
@@ -39,6 +107,18 @@ class DexStructure {
 
   const DexClasses& get_squashed_classes() const { return m_squashed_classes; }
 
+  size_t get_num_refs() const {
+    return m_mrefs.size() + m_frefs.size() + m_trefs.size();
+  }
+
+  size_t get_num_mrefs() const { return m_mrefs.size(); }
+
+  size_t get_num_frefs() const { return m_frefs.size(); }
+
+  bool has_mref(uint32_t id) const { return m_mrefs.contains(id); }
+
+  bool has_fref(uint32_t id) const { return m_frefs.contains(id); }
+
   /**
    * Only call this if you know what you are doing. This will leave the
    * current instance is in an unusable state.
@@ -48,30 +128,28 @@ class DexStructure {
   /**
    * Tries to add the specified class. Returns false if it doesn't fit.
    */
-  bool add_class_if_fits(const MethodRefs& clazz_mrefs,
-                         const FieldRefs& clazz_frefs,
-                         const TypeRefs& clazz_trefs,
+  bool add_class_if_fits(const RefIds& clazz_mrefs,
+                         const RefIds& clazz_frefs,
+                         const RefIds& clazz_trefs,
                          size_t linear_alloc_limit,
                          size_t field_refs_limit,
                          size_t method_refs_limit,
                          size_t type_refs_limit,
                          DexClass* clazz);
 
-  void add_class_no_checks(const MethodRefs& clazz_mrefs,
-                           const FieldRefs& clazz_frefs,
-                           const TypeRefs& clazz_trefs,
+  void add_class_no_checks(const RefIds& clazz_mrefs,
+                           const RefIds& clazz_frefs,
+                           const RefIds& clazz_trefs,
                            unsigned laclazz,
                            DexClass* clazz);
 
-  void check_refs_count();
-
-  void squash_empty_last_class(DexClass* clazz);
+  void squash_empty_last_class(DexClass* clazz, uint32_t type_id);
 
  private:
   size_t m_linear_alloc_size;
-  TypeRefs m_trefs;
-  MethodRefs m_mrefs;
-  FieldRefs m_frefs;
+  RefBitset m_trefs;
+  RefBitset m_mrefs;
+  RefBitset m_frefs;
   std::vector<DexClass*> m_classes;
   std::vector<DexClass*> m_squashed_classes;
 };
@@ -86,6 +164,10 @@ class DexesStructure {
     return m_current_dex.get_squashed_classes();
   }
 
+  size_t get_current_dex_num_refs() const {
+    return m_current_dex.get_num_refs();
+  }
+
   size_t get_num_coldstart_dexes() const { return m_info.num_coldstart_dexes; }
 
   size_t get_num_extended_dexes() const {
@@ -150,7 +232,8 @@ class DexesStructure {
   }
 
   void squash_empty_last_class(DexClass* clazz) {
-    m_current_dex.squash_empty_last_class(clazz);
+    m_current_dex.squash_empty_last_class(clazz,
+                                          m_trefs.get_id(clazz->get_type()));
   }
 
   /**
@@ -161,13 +244,24 @@ class DexesStructure {
   bool has_class(DexClass* clazz) const { return m_classes.count(clazz); }
 
  private:
-  void update_stats(const MethodRefs& clazz_mrefs,
-                    const FieldRefs& clazz_frefs,
+  void update_stats(const RefIds& clazz_mrefs,
+                    const RefIds& clazz_frefs,
                     DexClass* clazz);
 
+  /*
+   * Sanity check: did gather_refs return all the refs that ultimately ended up
+   * in the current dex?
+   */
+  void check_refs_count() const;
+
   // NOTE: Keeps track only of the last dex.
   DexStructure m_current_dex;
 
+  // Ids of all the refs seen so far, across dexes.
+  RefIndexer<DexMethodRef> m_mrefs;
+  RefIndexer<DexFieldRef> m_frefs;
+  RefIndexer<DexType> m_trefs;
+
   // All the classes that end up added in the dexes.
   std::unordered_set<DexClass*> m_classes;
 
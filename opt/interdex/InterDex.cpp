@@ -11,7 +11,10 @@
 
 #include <algorithm>
 #include <cinttypes>
+#include <functional>
+#include <numeric>
 #include <string>
+#include <tuple>
 #include <unordered_set>
 #include <vector>
 
@@ -29,6 +32,7 @@
 #include "Show.h"
 #include "StringUtil.h"
 #include "Walkers.h"
+#include "WorkQueue.h"
 #include "file-utils.h"
 
 namespace {
@@ -152,9 +156,9 @@ void gather_refs(
                         erased_classes, should_not_relocate_methods_of_class);
   }
 
-  mrefs->insert(method_refs.begin(), method_refs.end());
-  frefs->insert(field_refs.begin(), field_refs.end());
-  trefs->insert(type_refs.begin(), type_refs.end());
+  mrefs->insert(mrefs->end(), method_refs.begin(), method_refs.end());
+  frefs->insert(frefs->end(), field_refs.begin(), field_refs.end());
+  trefs->insert(trefs->end(), type_refs.begin(), type_refs.end());
 }
 
 void print_stats(interdex::DexesStructure* dexes_structure) {
@@ -656,22 +660,166 @@ void InterDex::update_interdexorder(const DexClasses& dex,
                          primary_dex.end());
 }
 
-void InterDex::init_cross_dex_ref_minimizer_and_relocate_methods() {
-  TRACE(IDEX, 2,
-        "[dex ordering] Cross-dex-ref-minimizer active with method ref weight "
-        "%" PRIu64 ", field ref weight %" PRIu64 ", type ref weight %" PRIu64
-        ", string ref weight %" PRIu64 ", method seed weight %" PRIu64
-        ", field seed weight %" PRIu64 ", type seed weight %" PRIu64
-        ", string seed weight %" PRIu64 ".",
-        m_cross_dex_ref_minimizer.get_config().method_ref_weight,
-        m_cross_dex_ref_minimizer.get_config().field_ref_weight,
-        m_cross_dex_ref_minimizer.get_config().type_ref_weight,
-        m_cross_dex_ref_minimizer.get_config().string_ref_weight,
-        m_cross_dex_ref_minimizer.get_config().method_seed_weight,
-        m_cross_dex_ref_minimizer.get_config().field_seed_weight,
-        m_cross_dex_ref_minimizer.get_config().type_seed_weight,
-        m_cross_dex_ref_minimizer.get_config().string_seed_weight);
+namespace {
+
+/**
+ * Variations of the given cross-dex-ref-minimizer configuration, each putting
+ * more emphasis on a different kind of *ref. The given configuration always
+ * comes first.
+ */
+std::vector<cross_dex_ref_minimizer::CrossDexRefMinimizerConfig>
+get_alternative_configs(
+    const cross_dex_ref_minimizer::CrossDexRefMinimizerConfig& config,
+    size_t alternatives) {
+  using Config = cross_dex_ref_minimizer::CrossDexRefMinimizerConfig;
+  std::vector<std::function<void(Config&)>> variations = {
+      [](Config& c) {
+        c.method_ref_weight *= 2;
+        c.method_seed_weight *= 2;
+      },
+      [](Config& c) {
+        c.field_ref_weight *= 2;
+        c.field_seed_weight *= 2;
+      },
+      [](Config& c) {
+        c.type_ref_weight *= 2;
+        c.type_seed_weight *= 2;
+      },
+      [](Config& c) {
+        c.string_ref_weight *= 2;
+        c.string_seed_weight *= 2;
+      },
+      [](Config& c) {
+        c.method_ref_weight = c.field_ref_weight = c.type_ref_weight =
+            c.string_ref_weight = 100;
+      },
+      [](Config& c) {
+        c.method_seed_weight = c.field_seed_weight = c.type_seed_weight =
+            c.string_seed_weight = 100;
+      },
+  };
+  std::vector<Config> configs{config};
+  for (size_t i = 0; i < std::min(alternatives, variations.size()); ++i) {
+    configs.push_back(config);
+    variations[i](configs.back());
+  }
+  return configs;
+}
+
+struct PackingResult {
+  size_t dexes{0};
+  // Sum over all dexes of their distinct method, field and type refs.
+  size_t refs{0};
+
+  bool operator<(const PackingResult& other) const {
+    return std::tie(dexes, refs) < std::tie(other.dexes, other.refs);
+  }
+};
+
+/**
+ * Emits the remaining classes the same way emit_remaining_classes does, but
+ * into the given copy of the dexes structure, and without consulting plugins,
+ * which are neither thread-safe nor free of side effects.
+ */
+PackingResult simulate_remaining_classes(
+    const cross_dex_ref_minimizer::CrossDexRefMinimizerConfig& config,
+    DexesStructure dexes_structure,
+    const std::vector<DexClass*>& classes_to_sample,
+    const std::vector<DexClass*>& classes_to_insert) {
+  const std::vector<std::unique_ptr<InterDexPassPlugin>> no_plugins;
+  cross_dex_ref_minimizer::CrossDexRefMinimizer minimizer(config);
+  for (DexClass* cls : classes_to_sample) {
+    minimizer.sample(cls);
+  }
+  for (DexClass* cls : classes_to_insert) {
+    minimizer.sample(cls);
+  }
+  for (DexClass* cls : classes_to_insert) {
+    minimizer.insert(cls);
+  }
+  for (auto cls : dexes_structure.get_current_dex_classes()) {
+    minimizer.sample(cls);
+    minimizer.insert(cls);
+    minimizer.erase(cls, /* emitted */ true, /* overflowed */ false);
+  }
+
+  PackingResult result;
+  bool pick_worst = true;
+  while (!minimizer.empty()) {
+    DexClass* cls{nullptr};
+    if (pick_worst) {
+      auto worst = minimizer.worst();
+      if (minimizer.get_unapplied_refs(worst) > minimizer.get_applied_refs()) {
+        cls = worst;
+      }
+    }
+    if (!cls) {
+      cls = minimizer.front();
+    }
+
+    MethodRefs clazz_mrefs;
+    FieldRefs clazz_frefs;
+    TypeRefs clazz_trefs;
+    gather_refs(no_plugins, EMPTY_DEX_INFO, cls, &clazz_mrefs, &clazz_frefs,
+                &clazz_trefs, /* erased_classes */ nullptr,
+                /* should_not_relocate_methods_of_class */ false);
+    bool overflowed = !dexes_structure.add_class_to_current_dex(
+        clazz_mrefs, clazz_frefs, clazz_trefs, cls);
+    if (overflowed) {
+      result.refs += dexes_structure.get_current_dex_num_refs();
+      dexes_structure.end_dex(EMPTY_DEX_INFO);
+      dexes_structure.add_class_no_checks(clazz_mrefs, clazz_frefs,
+                                          clazz_trefs, cls);
+    }
+    minimizer.erase(cls, /* emitted */ true, overflowed);
+    pick_worst = overflowed;
+  }
+
+  result.dexes = dexes_structure.get_num_dexes();
+  if (!dexes_structure.get_current_dex_classes().empty()) {
+    result.refs += dexes_structure.get_current_dex_num_refs();
+    ++result.dexes;
+  }
+  return result;
+}
+
+} // namespace
+
+void InterDex::select_cross_dex_ref_minimizer_config(
+    const std::vector<DexClass*>& classes_to_sample,
+    const std::vector<DexClass*>& classes_to_insert) {
+  auto configs = get_alternative_configs(m_cross_dex_ref_minimizer.get_config(),
+                                         m_cross_dex_refs_alternatives);
+  std::vector<PackingResult> results(configs.size());
+  std::vector<size_t> indices(configs.size());
+  std::iota(indices.begin(), indices.end(), 0);
+  workqueue_run<size_t>(
+      [&](size_t i) {
+        results[i] = simulate_remaining_classes(
+            configs[i], m_dexes_structure, classes_to_sample,
+            classes_to_insert);
+      },
+      indices);
+
+  // Ties go to the earlier configuration, so that we only deviate from the
+  // configured one when there's an actual improvement.
+  size_t best = 0;
+  for (size_t i = 0; i < results.size(); ++i) {
+    TRACE(IDEX, 2,
+          "[dex ordering] Simulated alternative %zu: %zu dexes, %zu refs", i,
+          results[i].dexes, results[i].refs);
+    if (results[i] < results[best]) {
+      best = i;
+    }
+  }
+  m_selected_cross_dex_refs_alternative = best;
+  if (best != 0) {
+    m_cross_dex_ref_minimizer =
+        cross_dex_ref_minimizer::CrossDexRefMinimizer(configs[best]);
+  }
+}
 
+void InterDex::init_cross_dex_ref_minimizer_and_relocate_methods() {
   if (m_cross_dex_relocator_config.relocate_static_methods ||
       m_cross_dex_relocator_config.relocate_non_static_direct_methods ||
       m_cross_dex_relocator_config.relocate_virtual_methods) {
@@ -693,6 +841,7 @@ void InterDex::init_cross_dex_ref_minimizer_and_relocate_methods() {
           m_cross_dex_relocator_config.relocate_virtual_methods ? "yes" : "no");
   }
 
+  std::vector<DexClass*> classes_to_sample;
   std::vector<DexClass*> classes_to_insert;
   // Emit classes using some algorithm to group together classes which
   // tend to share the same refs.
@@ -728,14 +877,40 @@ void InterDex::init_cross_dex_ref_minimizer_and_relocate_methods() {
       // class will get emitted later via the additional-class mechanism,
       // which is accounted for via the erased_classes reported through the
       // plugin's gather_refs callback. So we'll also sample those classes here.
-      m_cross_dex_ref_minimizer.sample(cls);
+      classes_to_sample.emplace_back(cls);
       continue;
     }
 
     classes_to_insert.emplace_back(cls);
   }
 
+  // The relocator changes classes as they get emitted, which we can't
+  // simulate.
+  if (m_cross_dex_refs_alternatives > 0 && m_cross_dex_relocator == nullptr) {
+    select_cross_dex_ref_minimizer_config(classes_to_sample,
+                                          classes_to_insert);
+  }
+
+  TRACE(IDEX, 2,
+        "[dex ordering] Cross-dex-ref-minimizer active with method ref weight "
+        "%" PRIu64 ", field ref weight %" PRIu64 ", type ref weight %" PRIu64
+        ", string ref weight %" PRIu64 ", method seed weight %" PRIu64
+        ", field seed weight %" PRIu64 ", type seed weight %" PRIu64
+        ", string seed weight %" PRIu64 ".",
+        m_cross_dex_ref_minimizer.get_config().method_ref_weight,
+        m_cross_dex_ref_minimizer.get_config().field_ref_weight,
+        m_cross_dex_ref_minimizer.get_config().type_ref_weight,
+        m_cross_dex_ref_minimizer.get_config().string_ref_weight,
+        m_cross_dex_ref_minimizer.get_config().method_seed_weight,
+        m_cross_dex_ref_minimizer.get_config().field_seed_weight,
+        m_cross_dex_ref_minimizer.get_config().type_seed_weight,
+        m_cross_dex_ref_minimizer.get_config().string_seed_weight);
+
+
   // Initialize ref frequency counts
+  for (DexClass* cls : classes_to_sample) {
+    m_cross_dex_ref_minimizer.sample(cls);
+  }
   for (DexClass* cls : classes_to_insert) {
     m_cross_dex_ref_minimizer.sample(cls);
   }
@@ -39,6 +39,7 @@ class InterDex {
            bool minimize_cross_dex_refs,
            const cross_dex_ref_minimizer::CrossDexRefMinimizerConfig&
                cross_dex_refs_config,
+           size_t cross_dex_refs_alternatives,
            const CrossDexRelocatorConfig& cross_dex_relocator_config,
            size_t reserve_frefs,
            size_t reserve_trefs,
@@ -61,6 +62,7 @@ class InterDex {
         m_emitted_bg_set(false),
         m_emitting_extended(false),
         m_cross_dex_ref_minimizer(cross_dex_refs_config),
+        m_cross_dex_refs_alternatives(cross_dex_refs_alternatives),
         m_cross_dex_relocator_config(cross_dex_relocator_config),
         m_original_scope(original_scope),
         m_scope(build_class_scope(m_dexen)),
@@ -90,6 +92,12 @@ class InterDex {
     return m_cross_dex_ref_minimizer.stats();
   }
 
+  // Which of the simulated cross-dex-ref-minimizer configurations got picked;
+  // 0 is the configured one.
+  size_t get_selected_cross_dex_refs_alternative() const {
+    return m_selected_cross_dex_refs_alternative;
+  }
+
   CrossDexRelocatorStats get_cross_dex_relocator_stats() const {
     if (m_cross_dex_relocator != nullptr) {
       return m_cross_dex_relocator->stats();
@@ -136,6 +144,9 @@ class InterDex {
       const std::vector<DexType*>& interdex_types,
       const std::unordered_set<DexClass*>& unreferenced_classes);
   void init_cross_dex_ref_minimizer_and_relocate_methods();
+  void select_cross_dex_ref_minimizer_config(
+      const std::vector<DexClass*>& classes_to_sample,
+      const std::vector<DexClass*>& classes_to_insert);
   void emit_remaining_classes(DexInfo& dex_info);
   void flush_out_dex(DexInfo& dex_info);
 
@@ -179,6 +190,8 @@ class InterDex {
   std::vector<DexType*> m_scroll_markers;
 
   cross_dex_ref_minimizer::CrossDexRefMinimizer m_cross_dex_ref_minimizer;
+  size_t m_cross_dex_refs_alternatives;
+  size_t m_selected_cross_dex_refs_alternative{0};
   const CrossDexRelocatorConfig m_cross_dex_relocator_config;
   const Scope& m_original_scope;
   CrossDexRelocator* m_cross_dex_relocator{nullptr};
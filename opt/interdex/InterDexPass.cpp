@@ -85,6 +85,12 @@ void InterDexPass::bind_config() {
   bind("minimize_cross_dex_refs_string_ref_weight",
        m_minimize_cross_dex_refs_config.string_seed_weight,
        m_minimize_cross_dex_refs_config.string_seed_weight);
+  bind("minimize_cross_dex_refs_alternatives", 0,
+       m_minimize_cross_dex_refs_alternatives,
+       "How many variations of the cross-dex-ref-minimizer weights to "
+       "simulate in parallel before emitting the remaining classes; the one "
+       "yielding the fewest dexes, and then the fewest refs, is used. Not "
+       "supported together with method relocation");
   bind("minimize_cross_dex_refs_relocate_static_methods", false,
        m_cross_dex_relocator_config.relocate_static_methods);
   bind("minimize_cross_dex_refs_relocate_non_static_direct_methods", false,
@@ -127,6 +133,7 @@ void InterDexPass::run_pass(
                     m_linear_alloc_limit, m_static_prune, m_normal_primary_dex,
                     m_keep_primary_order, force_single_dex, m_emit_canaries,
                     m_minimize_cross_dex_refs, m_minimize_cross_dex_refs_config,
+                    m_minimize_cross_dex_refs_alternatives,
                     m_cross_dex_relocator_config, refs_info.frefs,
                     refs_info.trefs, refs_info.mrefs, &xstore_refs,
                     mgr.get_redex_options().min_sdk, m_sort_remaining_classes);
@@ -158,6 +165,8 @@ void InterDexPass::run_pass(
   mgr.set_metric(METRIC_REORDER_RESETS, cross_dex_ref_minimizer_stats.resets);
   mgr.set_metric(METRIC_REORDER_REPRIORITIZATIONS,
                  cross_dex_ref_minimizer_stats.reprioritizations);
+  mgr.set_metric(METRIC_REORDER_SELECTED_ALTERNATIVE,
+                 interdex.get_selected_cross_dex_refs_alternative());
   const auto& worst_classes = cross_dex_ref_minimizer_stats.worst_classes;
   for (size_t i = 0; i < worst_classes.size(); ++i) {
     auto& p = worst_classes.at(i);
@@ -210,6 +219,7 @@ void InterDexPass::run_pass_on_nonroot_store(const Scope& original_scope,
                     m_keep_primary_order, false /* force single dex */,
                     false /* emit canaries */,
                     false /* minimize_cross_dex_refs */, cross_dex_refs_config,
+                    0 /* cross_dex_refs_alternatives */,
                     cross_dex_relocator_config, refs_info.frefs,
                     refs_info.trefs, refs_info.mrefs, &xstore_refs,
                     mgr.get_redex_options().min_sdk, m_sort_remaining_classes);
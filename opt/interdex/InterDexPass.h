@@ -26,6 +26,8 @@ constexpr const char* METRIC_REORDER_RESETS = "num_reorder_resets";
 constexpr const char* METRIC_REORDER_REPRIORITIZATIONS =
     "num_reorder_reprioritization";
 constexpr const char* METRIC_REORDER_CLASSES_WORST = "reorder_classes_worst";
+constexpr const char* METRIC_REORDER_SELECTED_ALTERNATIVE =
+    "reorder_selected_alternative";
 
 constexpr const char* METRIC_CLASSES_ADDED_FOR_RELOCATED_METHODS =
     "num_classes_added_for_relocated_methods";
@@ -92,6 +94,7 @@ class InterDexPass : public Pass {
   bool m_minimize_cross_dex_refs;
   cross_dex_ref_minimizer::CrossDexRefMinimizerConfig
       m_minimize_cross_dex_refs_config;
+  size_t m_minimize_cross_dex_refs_alternatives;
   CrossDexRelocatorConfig m_cross_dex_relocator_config;
   bool m_expect_order_list;
   bool m_sort_remaining_classes;
@@ -15,4 +15,6 @@ class LocalDcePass : public Pass {
   LocalDcePass() : Pass("LocalDcePass") {}
 
   void run_pass(DexStoresVector&, ConfigFiles&, PassManager&) override;
+
+  bool keeps_editable_cfg() const override { return true; }
 };
@@ -432,7 +432,7 @@ std::unordered_map<const DexType*, DexType*> merge_interfaces(
     // Get rid of merge target in new interfaces set if it was added in.
     new_intfs.erase(merge_to_intf->get_type());
     // Set super interfaces to merged super interfaces.
-    std::deque<DexType*> deque;
+    DexTypeList::ContainerType deque;
     for (const auto& intf : new_intfs) {
       deque.emplace_back(intf);
     }
@@ -542,7 +542,7 @@ void remove_implements(
         new_intfs.emplace(cls_intf);
       }
     }
-    std::deque<DexType*> deque;
+    DexTypeList::ContainerType deque;
     TRACE_NO_LINE(MEINT, 9, "\nAfter is:");
     for (DexType* intf : new_intfs) {
       TRACE_NO_LINE(MEINT, 9, "%p ", intf);
@@ -7,12 +7,15 @@
 
 #include "IntraDexInlinePass.h"
 
+#include "HierarchyAnalysis.h"
 #include "MethodInliner.h"
 
 void IntraDexInlinePass::run_pass(DexStoresVector& stores,
                                   ConfigFiles& conf,
                                   PassManager& mgr) {
-  inliner::run_inliner(stores, mgr, conf, /* intra_dex */ true);
+  inliner::run_inliner(
+      stores, mgr, conf, /* intra_dex */ true, /* inline_for_speed */ nullptr,
+      hierarchy_analysis::get_preserved_method_override_graph(mgr));
 }
 
 static IntraDexInlinePass s_pass;
@@ -7,12 +7,15 @@
 
 #include "MethodInlinePass.h"
 
+#include "HierarchyAnalysis.h"
 #include "MethodInliner.h"
 
 void MethodInlinePass::run_pass(DexStoresVector& stores,
                                 ConfigFiles& conf,
                                 PassManager& mgr) {
-  inliner::run_inliner(stores, mgr, conf);
+  inliner::run_inliner(
+      stores, mgr, conf, /* intra_dex */ false, /* inline_for_speed */ nullptr,
+      hierarchy_analysis::get_preserved_method_override_graph(mgr));
 }
 
 static MethodInlinePass s_pass;
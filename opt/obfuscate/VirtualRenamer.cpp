@@ -185,7 +185,10 @@ struct VirtualRenamer {
   DexString* get_unescaped_name(const std::vector<const VirtualScope*>& scopes,
                                 int& seed) const;
   DexString* get_unescaped_name(const VirtualScope* scope, int& seed) const;
-  bool usable_name(DexString* name, const VirtualScope* scope) const;
+  TypeSet get_scope_types(const VirtualScope* scope) const;
+  bool usable_name(DexString* name,
+                   const VirtualScope* scope,
+                   const TypeSet& scope_types) const;
 };
 
 /**
@@ -198,7 +201,7 @@ void VirtualRenamer::rename(DexMethodRef* meth, DexString* name) {
   spec.name = name;
   spec.proto = meth->get_proto();
   if (stack_trace_elements) {
-    std::string ste = get_prefix(meth->get_class()) + meth->str();
+    std::string ste = get_prefix(meth->get_class()) + meth->str_copy();
     auto iter = stack_trace_elements->find(ste);
     // We don't find this ste if it's a miranda method
     if (iter != stack_trace_elements->end()) {
@@ -213,7 +216,7 @@ void VirtualRenamer::rename(DexMethodRef* meth, DexString* name) {
   meth->change(spec, false /* rename on collision */);
 
   if (stack_trace_elements) {
-    std::string ste = get_prefix(meth->get_class()) + name->str();
+    std::string ste = get_prefix(meth->get_class()) + name->str_copy();
     auto res = stack_trace_elements->emplace(std::move(ste), 1);
     // Ideally we've picked a new name that doesn't collide with any other
     // method, so this assert should never fire. We leave this here in case
@@ -255,24 +258,33 @@ int VirtualRenamer::rename_scope(const VirtualScope* scope, DexString* name) {
   return renamed;
 }
 
+/**
+ * The root of the scope and all its subclasses, where a new name for the
+ * scope may collide.
+ */
+TypeSet VirtualRenamer::get_scope_types(const VirtualScope* scope) const {
+  const auto root = scope->type;
+  auto hier = get_all_children(class_scopes.get_class_hierarchy(), root);
+  hier.insert(root);
+  return hier;
+}
+
 /**
  * A name is usable if it does not collide with an existing
  * one in the def and ref space.
  */
 bool VirtualRenamer::usable_name(DexString* name,
-                                 const VirtualScope* scope) const {
-  const auto root = scope->type;
+                                 const VirtualScope* scope,
+                                 const TypeSet& scope_types) const {
   const auto proto = scope->methods[0].first->get_proto();
-  auto hier = get_all_children(class_scopes.get_class_hierarchy(), root);
-  hier.insert(root);
   bool has_ste = stack_trace_elements != nullptr;
-  for (const auto& type : hier) {
+  for (const auto& type : scope_types) {
     if (DexMethod::get_method(const_cast<DexType*>(type), name, proto) !=
         nullptr) {
       return false;
     }
     if (has_ste) {
-      auto ste = get_prefix(type) + name->str();
+      auto ste = get_prefix(type) + name->str_copy();
       if (stack_trace_elements->find(ste) != stack_trace_elements->end()) {
         return false;
       }
@@ -289,8 +301,10 @@ bool VirtualRenamer::usable_name(DexString* name,
 DexString* VirtualRenamer::get_unescaped_name(const VirtualScope* scope,
                                               int& seed) const {
   seed = std::max(seed, get_next_virtualscope_seeds(scope));
+  // Collect the hierarchy once, rather than for every candidate name.
+  auto scope_types = get_scope_types(scope);
   auto name = get_name(seed++);
-  while (!usable_name(name, scope)) {
+  while (!usable_name(name, scope, scope_types)) {
     name = get_name(seed++);
   }
   return name;
@@ -304,13 +318,16 @@ DexString* VirtualRenamer::get_unescaped_name(const VirtualScope* scope,
 DexString* VirtualRenamer::get_unescaped_name(
     const std::vector<const VirtualScope*>& scopes, int& seed) const {
   // advance seed as necessary, skipping over dmethods
+  std::vector<TypeSet> scopes_types;
+  scopes_types.reserve(scopes.size());
   for (const auto& scope : scopes) {
     seed = std::max(seed, get_next_virtualscope_seeds(scope));
+    scopes_types.push_back(get_scope_types(scope));
   }
   while (true) {
     auto name = get_name(seed++);
-    for (const auto& scope : scopes) {
-      if (!usable_name(name, scope)) goto next_name;
+    for (size_t i = 0; i < scopes.size(); ++i) {
+      if (!usable_name(name, scopes[i], scopes_types[i])) goto next_name;
     }
     return name;
   next_name:;
@@ -513,12 +530,13 @@ size_t rename_virtuals(
   std::unordered_map<const DexType*, std::string> external_cache;
   if (avoid_stack_trace_collision) {
     for (const auto& cls : scope) {
-      std::string pref = java_names::internal_to_external(cls->str()) + ".";
+      std::string pref =
+          java_names::internal_to_external(cls->str_copy()) + ".";
       auto emp_res = external_cache.emplace(cls->get_type(), pref);
       always_assert(emp_res.second);
       auto meths_visitor = [&](const std::vector<DexMethod*>& methods) {
         for (const DexMethod* method : methods) {
-          std::string ste = pref + method->str();
+          std::string ste = pref + method->str_copy();
           // We're 100% ok with the default construction of an entry here, since
           // after this line that would give said entry the correct ref count
           // of 1.
@@ -91,7 +91,7 @@ class CallGraphStrategy final : public call_graph::BuildStrategy {
 
   const Scope& m_scope;
   std::unordered_set<const DexMethod*> m_non_overridden_virtuals;
-  mutable MethodRefCache m_resolved_refs;
+  mutable ConcurrentMethodRefCache m_resolved_refs;
 };
 
 static side_effects::InvokeToSummaryMap build_summary_map(
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include "DenseBitsetAbstractDomain.h"
 #include "DexUtil.h"
 #include "LocalPointersAnalysis.h"
 #include "PatriciaTreeSetAbstractDomain.h"
@@ -16,7 +17,7 @@
 
 namespace used_vars {
 
-using UsedRegisters = sparta::PatriciaTreeSetAbstractDomain<reg_t>;
+using UsedRegisters = sparta::DenseBitsetAbstractDomain<reg_t>;
 
 using UsedPointers =
     sparta::PatriciaTreeSetAbstractDomain<const IRInstruction*>;
@@ -298,7 +298,8 @@ struct EnumUtil {
     }
     auto proto = DexProto::make_proto(
         ifield->get_type(), DexTypeList::make_type_list({INTEGER_TYPE}));
-    auto method_name = DexString::make_string("redex$OE$get_" + ifield->str());
+    auto method_name =
+        DexString::make_string("redex$OE$get_" + ifield->str_copy());
     auto method = DexMethod::make_method(enum_type, method_name, proto);
     m_get_instance_field_methods.insert(std::make_pair(ifield, method));
     return method;
@@ -362,7 +362,7 @@ class EnumUpcastDetector {
     auto proto = method->get_proto();
     auto container = method->get_class();
     // Check the type of arguments.
-    const std::deque<DexType*>& args = proto->get_args()->get_type_list();
+    const DexTypeList::ContainerType& args = proto->get_args()->get_type_list();
     always_assert(args.size() == insn->srcs_size() ||
                   args.size() == insn->srcs_size() - 1);
     size_t arg_id = 0;
@@ -7,6 +7,8 @@
 
 #include "OptimizeEnums.h"
 
+#include <mutex>
+
 #include "ClassAssemblingUtils.h"
 #include "ConfigFiles.h"
 #include "EnumAnalyzeGeneratedMethods.h"
@@ -614,12 +616,23 @@ class OptimizeEnums {
 
   EnumFieldToOrdinal collect_enum_field_ordinals() {
     EnumFieldToOrdinal enum_field_to_ordinal;
+    std::mutex enum_field_to_ordinal_mutex;
 
-    for (const auto& cls : m_scope) {
-      if (is_enum(cls)) {
-        collect_enum_field_ordinals(cls, enum_field_to_ordinal);
+    // Each enum's analysis only builds the CFGs of its own constructors and
+    // <clinit>, so enums can be analyzed independently.
+    walk::parallel::classes(m_scope, [&](DexClass* cls) {
+      if (!is_enum(cls)) {
+        return;
       }
-    }
+      EnumFieldToOrdinal cls_field_to_ordinal;
+      collect_enum_field_ordinals(cls, cls_field_to_ordinal);
+      if (cls_field_to_ordinal.empty()) {
+        return;
+      }
+      std::lock_guard<std::mutex> lock(enum_field_to_ordinal_mutex);
+      enum_field_to_ordinal.insert(cls_field_to_ordinal.begin(),
+                                   cls_field_to_ordinal.end());
+    });
 
     return enum_field_to_ordinal;
   }
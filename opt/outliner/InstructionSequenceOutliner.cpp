@@ -65,9 +65,11 @@
 #include "InstructionSequenceOutliner.h"
 
 #include <algorithm>
+#include <limits>
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -106,8 +108,10 @@
 #include "Show.h"
 #include "SourceBlocks.h"
 #include "StlUtil.h"
+#include "SuffixArray.h"
 #include "Trace.h"
 #include "Walkers.h"
+#include "WorkQueue.h"
 
 using namespace instruction_sequence_outliner;
 
@@ -393,9 +397,8 @@ using LazyReachingInitializedsEnvironments =
 using OptionalReachingInitializedsEnvironments =
     boost::optional<reaching_initializeds::ReachingInitializedsEnvironments>;
 
-static std::vector<cfg::Edge*> get_ordered_goto_and_branch_succs(
-    cfg::Block* block) {
-  std::vector<cfg::Edge*> succs =
+static cfg::EdgeList get_ordered_goto_and_branch_succs(cfg::Block* block) {
+  cfg::EdgeList succs =
       block->cfg().get_succ_edges_if(block, [](cfg::Edge* e) {
         return e->type() == cfg::EDGE_GOTO || e->type() == cfg::EDGE_BRANCH;
       });
@@ -659,7 +662,8 @@ class CanOutlineBlockDecider {
   mutable std::unique_ptr<LazyUnorderedMap<cfg::Block*, bool>> m_is_in_loop;
   mutable std::unique_ptr<LazyUnorderedMap<cfg::Block*, boost::optional<float>>>
       m_max_vals;
-  mutable std::unique_ptr<dominators::SimpleFastDominators<cfg::GraphInterface>>
+  mutable std::shared_ptr<
+      const dominators::SimpleFastDominators<cfg::GraphInterface>>
       m_dominators;
 
  public:
@@ -762,8 +766,7 @@ class CanOutlineBlockDecider {
     auto entry_block = cfg.entry_block();
     if (block != entry_block && (!min_val || *min_val != 0)) {
       if (!m_dominators) {
-        m_dominators.reset(
-            new dominators::SimpleFastDominators<cfg::GraphInterface>(cfg));
+        m_dominators = cfg.dominator_tree();
       }
       do {
         block = m_dominators->get_idom(block);
@@ -1332,6 +1335,81 @@ static bool can_outline_from_method(DexMethod* method) {
   return true;
 }
 
+using CoreSegments = std::vector<std::vector<CandidateInstructionCore>>;
+
+// Finds the recurring cores among all (MIN_INSNS_SIZE)-long windows of the
+// given segments. The segments are interned into one integer stream, with a
+// unique separator after each, so that every repeated window shows up as two
+// adjacent suffixes in the suffix array whose common prefix is at least
+// MIN_INSNS_SIZE long. Returns the number of singleton cores.
+static size_t get_recurring_cores_with_suffix_array(
+    const CoreSegments& segments,
+    CandidateInstructionCoresSet* recurring_cores) {
+  std::unordered_map<CandidateInstructionCore, uint32_t,
+                     CandidateInstructionCoreHasher>
+      core_ids;
+  std::vector<CandidateInstructionCore> cores;
+  size_t stream_size = 0;
+  for (auto& segment : segments) {
+    stream_size += segment.size() + 1;
+    for (auto& core : segment) {
+      if (core_ids.emplace(core, cores.size()).second) {
+        cores.push_back(core);
+      }
+    }
+  }
+  always_assert(cores.size() + segments.size() <=
+                std::numeric_limits<uint32_t>::max());
+  std::vector<uint32_t> stream;
+  stream.reserve(stream_size);
+  // How many symbols before the next separator, for each position.
+  std::vector<uint32_t> run_lengths;
+  run_lengths.reserve(stream_size);
+  uint32_t separator = cores.size();
+  for (auto& segment : segments) {
+    for (size_t i = 0; i < segment.size(); i++) {
+      stream.push_back(core_ids.at(segment[i]));
+      run_lengths.push_back(segment.size() - i);
+    }
+    stream.push_back(separator++);
+    run_lengths.push_back(0);
+  }
+  core_ids.clear();
+
+  auto sa = suffix_array::build(stream, separator);
+  auto lcp = suffix_array::lcp(stream, sa);
+  auto get_value = [&](uint32_t pos) {
+    CandidateInstructionCores res;
+    for (size_t i = 0; i < MIN_INSNS_SIZE; i++) {
+      res[i] = cores.at(stream[pos + i]);
+    }
+    return res;
+  };
+
+  // Windows with equal cores are adjacent in the suffix array.
+  size_t singleton_cores{0};
+  size_t group_size{0};
+  for (size_t i = 0; i < sa.size(); i++) {
+    if (run_lengths[sa[i]] < MIN_INSNS_SIZE) {
+      continue;
+    }
+    if (group_size > 0 && lcp[i] >= MIN_INSNS_SIZE) {
+      if (group_size++ == 1) {
+        recurring_cores->insert(get_value(sa[i]));
+      }
+      continue;
+    }
+    if (group_size == 1) {
+      singleton_cores++;
+    }
+    group_size = 1;
+  }
+  if (group_size == 1) {
+    singleton_cores++;
+  }
+  return singleton_cores;
+}
+
 // Gather set of recurring small (MIN_INSNS_SIZE) adjacent instruction
 // sequences that are outlinable. Note that all longer recurring outlinable
 // instruction sequences must be comprised of shorter recurring ones.
@@ -1347,9 +1425,13 @@ static void get_recurring_cores(
   ConcurrentMap<CandidateInstructionCores, size_t,
                 CandidateInstructionCoresHasher>
       concurrent_cores;
+  // Only used with config.use_suffix_array.
+  CoreSegments segments;
+  std::mutex segments_mutex;
   walk::parallel::code(
       scope, [&config, &ref_checker, &sufficiently_warm_methods,
-              &sufficiently_hot_methods, &concurrent_cores,
+              &sufficiently_hot_methods, &concurrent_cores, &segments,
+              &segments_mutex,
               block_deciders](DexMethod* method, IRCode& code) {
         if (!can_outline_from_method(method)) {
           return;
@@ -1367,17 +1449,36 @@ static void get_recurring_cores(
               reaching_initializeds::get_reaching_initializeds(
                   cfg, reaching_initializeds::Mode::FirstLoadParam);
         }
+        CoreSegments method_segments;
+        auto end_segment = [&method_segments]() {
+          if (!method_segments.empty() &&
+              method_segments.back().size() < MIN_INSNS_SIZE) {
+            method_segments.back().clear();
+          } else {
+            method_segments.emplace_back();
+          }
+        };
         for (auto& big_block : big_blocks::get_big_blocks(cfg)) {
           if (block_decider.can_outline_from_big_block(big_block) !=
               CanOutlineBlockDecider::Result::CanOutline) {
             continue;
           }
           CandidateInstructionCoresBuilder cores_builder;
+          if (config.use_suffix_array) {
+            end_segment();
+          }
           for (auto& mie : big_blocks::InstructionIterable(big_block)) {
             auto insn = mie.insn;
             if (!can_outline_insn(
                     ref_checker, reaching_initialized_init_first_param, insn)) {
               cores_builder.clear();
+              if (config.use_suffix_array) {
+                end_segment();
+              }
+              continue;
+            }
+            if (config.use_suffix_array) {
+              method_segments.back().push_back(to_core(insn));
               continue;
             }
             cores_builder.push_back(insn);
@@ -1390,8 +1491,22 @@ static void get_recurring_cores(
           }
         }
         block_deciders->emplace(method, std::move(block_decider));
+        if (!method_segments.empty() &&
+            method_segments.back().size() < MIN_INSNS_SIZE) {
+          method_segments.pop_back();
+        }
+        if (!method_segments.empty()) {
+          std::lock_guard<std::mutex> lock(segments_mutex);
+          segments.insert(segments.end(),
+                          std::make_move_iterator(method_segments.begin()),
+                          std::make_move_iterator(method_segments.end()));
+        }
       });
   size_t singleton_cores{0};
+  if (config.use_suffix_array) {
+    singleton_cores =
+        get_recurring_cores_with_suffix_array(segments, recurring_cores);
+  }
   for (auto& p : concurrent_cores) {
     always_assert(p.second > 0);
     if (p.second > 1) {
@@ -1592,6 +1707,9 @@ using CandidateId = uint32_t;
 struct CandidateWithInfo {
   Candidate candidate;
   CandidateInfo info;
+  // Savings when the candidate was found, before outlining anything in the
+  // current dex.
+  size_t savings{0};
 };
 
 // Find beneficial candidates across all methods. Beneficial candidates are
@@ -1648,10 +1766,36 @@ static void get_beneficial_candidates(
   using CandidateSet = std::unordered_set<Candidate, CandidateHasher>;
   std::map<DexMethod*, CandidateSet, dexmethods_comparator>
       candidates_by_methods;
-  size_t beneficial_count{0}, maleficial_count{0};
+  // Computing the savings only reads the reusable outlined methods, so it
+  // is done in parallel, in chunks as each computation is small.
+  std::vector<const std::pair<const Candidate, CandidateInfo>*> all_candidates;
+  all_candidates.reserve(concurrent_candidates.size());
   for (auto& p : concurrent_candidates) {
-    if (get_savings(config, p.first, p.second, *outlined_methods) > 0) {
+    all_candidates.push_back(&p);
+  }
+  constexpr size_t kSavingsChunkSize = 1024;
+  std::vector<size_t> chunks;
+  for (size_t i = 0; i < all_candidates.size(); i += kSavingsChunkSize) {
+    chunks.push_back(i);
+  }
+  std::vector<size_t> all_savings(all_candidates.size());
+  workqueue_run<size_t>(
+      [&](size_t begin) {
+        auto end = std::min(begin + kSavingsChunkSize, all_candidates.size());
+        for (size_t i = begin; i < end; i++) {
+          all_savings[i] =
+              get_savings(config, all_candidates[i]->first,
+                          all_candidates[i]->second, *outlined_methods);
+        }
+      },
+      chunks);
+  std::unordered_map<const CandidateInfo*, size_t> savings_by_info;
+  size_t beneficial_count{0}, maleficial_count{0};
+  for (size_t i = 0; i < all_candidates.size(); i++) {
+    auto& p = *all_candidates[i];
+    if (all_savings[i] > 0) {
       beneficial_count += p.second.count;
+      savings_by_info.emplace(&p.second, all_savings[i]);
       for (auto& q : p.second.methods) {
         candidates_by_methods[q.first].insert(p.first);
       }
@@ -1714,8 +1858,8 @@ static void get_beneficial_candidates(
         CandidateId candidate_id = candidate_ids.size();
         method_candidate_ids.insert(candidate_id);
         candidate_ids.emplace(c, candidate_id);
-        candidates_with_infos->push_back(
-            {c, concurrent_candidates.at_unsafe(c)});
+        const auto& info = concurrent_candidates.at_unsafe(c);
+        candidates_with_infos->push_back({c, info, savings_by_info.at(&info)});
       }
     }
   }
@@ -1877,7 +2021,7 @@ class OutlinedMethodCreator {
                                     const DexType* host_class,
                                     std::set<uint32_t>* pattern_ids) {
     auto name = m_method_name_generator.get_name(c);
-    std::deque<DexType*> arg_types;
+    DexTypeList::ContainerType arg_types;
     for (auto t : c.arg_types) {
       arg_types.push_back(const_cast<DexType*>(t));
     }
@@ -2544,12 +2688,10 @@ static NewlyOutlinedMethods outline(
   // impacted candidates, until there is no more beneficial candidate left.
   using Priority = uint64_t;
   MutablePriorityQueue<CandidateId, Priority> pq;
-  auto get_priority = [&config, &candidates_with_infos,
-                       outlined_methods](CandidateId id) {
+  auto get_priority = [&candidates_with_infos](CandidateId id,
+                                               size_t savings) {
     auto& cwi = candidates_with_infos->at(id);
-    Priority primary_priority =
-        get_savings(config, cwi.candidate, cwi.info, *outlined_methods) *
-        cwi.candidate.size;
+    Priority primary_priority = savings * cwi.candidate.size;
     // clip primary_priority to 32-bit
     if (primary_priority >= (1UL << 32)) {
       primary_priority = (1UL << 32) - 1;
@@ -2567,7 +2709,7 @@ static NewlyOutlinedMethods outline(
     cwi.info.count = 0;
   };
   for (CandidateId id = 0; id < candidates_with_infos->size(); id++) {
-    pq.insert(id, get_priority(id));
+    pq.insert(id, get_priority(id, candidates_with_infos->at(id).savings));
   }
   size_t total_savings{0};
   size_t outlined_count{0};
@@ -2638,7 +2780,7 @@ static NewlyOutlinedMethods outline(
       if (other_savings == 0) {
         erase(other_id, other_cwi);
       } else {
-        pq.update_priority(other_id, get_priority(other_id));
+        pq.update_priority(other_id, get_priority(other_id, other_savings));
       }
     }
   }
@@ -3211,6 +3353,10 @@ void InstructionSequenceOutliner::bind_config() {
        m_config.max_outlined_methods_per_class,
        "Maximum number of outlined methods per generated helper class; "
        "indirectly drives number of needed helper classes");
+  bind("use_suffix_array", m_config.use_suffix_array,
+       m_config.use_suffix_array,
+       "Whether to find recurring instruction sequences with a suffix array "
+       "over all instructions of a dex instead of a hash map");
   bind("savings_threshold", m_config.savings_threshold,
        m_config.savings_threshold,
        "Minimum number of code units saved before a particular code sequence "
@@ -3287,6 +3433,9 @@ void InstructionSequenceOutliner::run_pass(DexStoresVector& stores,
       outlined_methods_to_reorder;
   size_t num_reused_methods{0};
   boost::optional<size_t> last_store_idx;
+  // Verdicts only depend on the store, so dexes of the same store share a
+  // checker, with the verdicts for each dex precomputed before it is used.
+  std::unique_ptr<RefChecker> ref_checker;
   auto iteration = m_iteration++;
   bool is_primary_dex{true};
   for (auto& store : stores) {
@@ -3319,18 +3468,22 @@ void InstructionSequenceOutliner::run_pass(DexStoresVector& stores,
         outlined_methods.map.clear();
         outlined_methods.order.clear();
       }
+      if (!last_store_idx || *last_store_idx != store_idx) {
+        ref_checker =
+            std::make_unique<RefChecker>(&xstores, store_idx, min_sdk_api);
+      }
       last_store_idx = store_idx;
-      RefChecker ref_checker{&xstores, store_idx, min_sdk_api};
+      ref_checker->precompute(dex);
       CandidateInstructionCoresSet recurring_cores;
       ConcurrentMap<DexMethod*, CanOutlineBlockDecider> block_deciders;
       get_recurring_cores(m_config, mgr, dex, sufficiently_warm_methods,
-                          sufficiently_hot_methods, ref_checker,
+                          sufficiently_hot_methods, *ref_checker,
                           &recurring_cores, &block_deciders);
       std::vector<CandidateWithInfo> candidates_with_infos;
       std::unordered_map<DexMethod*, std::unordered_set<CandidateId>>
           candidate_ids_by_methods;
       get_beneficial_candidates(
-          m_config, mgr, dex, ref_checker, recurring_cores, block_deciders,
+          m_config, mgr, dex, *ref_checker, recurring_cores, block_deciders,
           &outlined_methods, &candidates_with_infos, &candidate_ids_by_methods);
 
       // TODO: Merge candidates that are equivalent except that one returns
@@ -42,6 +42,7 @@ struct Config {
   bool outline_from_primary_dex{false};
   bool full_dbg_positions{false};
   bool debug_make_crashing{false};
+  bool use_suffix_array{false};
 };
 
 } // namespace instruction_sequence_outliner
@@ -30,17 +30,19 @@ OutlinerTypeAnalysis::OutlinerTypeAnalysis(DexMethod* method)
         }
         return res;
       }),
-      m_type_environments([method]() {
-        auto& cfg = method->get_code()->cfg();
-        type_inference::TypeInference type_inference(cfg);
-        type_inference.run(method);
-        return type_inference.get_type_environments();
-      }),
       m_constant_uses([method]() {
         auto& cfg = method->get_code()->cfg();
         return std::make_unique<constant_uses::ConstantUses>(cfg, method);
       }) {}
 
+const type_inference::TypeEnvironment&
+OutlinerTypeAnalysis::get_type_environment(const IRInstruction* insn) {
+  if (!m_type_environments) {
+    m_type_environments = type_inference::get_type_environments(m_method);
+  }
+  return m_type_environments->type_envs.at(insn);
+}
+
 const DexType* OutlinerTypeAnalysis::get_result_type(
     const PartialCandidate* pc,
     const std::unordered_set<const IRInstruction*>& insns,
@@ -69,7 +71,7 @@ const DexType* OutlinerTypeAnalysis::get_type_demand(
 const DexType* OutlinerTypeAnalysis::get_inferred_type(
     const PartialCandidate& pc, reg_t reg) {
   auto insn = pc.root.insns.front();
-  const auto& env = m_type_environments->at(insn);
+  const auto& env = get_type_environment(insn);
   switch (env.get_type(reg).element()) {
   case BOTTOM:
   case ZERO:
@@ -382,7 +384,7 @@ const DexType* OutlinerTypeAnalysis::get_result_type_helper(
   case OPCODE_AGET:
   case OPCODE_AGET_WIDE:
   case OPCODE_AGET_OBJECT: {
-    auto& env = m_type_environments->at(insn);
+    auto& env = get_type_environment(insn);
     auto dex_type = env.get_dex_type(insn->src(0));
     return (dex_type && type::is_array(*dex_type))
                ? type::get_array_component_type(*dex_type)
@@ -430,7 +432,7 @@ const DexType* OutlinerTypeAnalysis::get_type_of_reaching_defs(
 const DexType* OutlinerTypeAnalysis::get_if_insn_type_demand(
     IRInstruction* insn) {
   always_assert(opcode::is_a_conditional_branch(insn->opcode()));
-  auto& env = m_type_environments->at(insn);
+  auto& env = get_type_environment(insn);
   for (size_t src_index = 0; src_index < insn->srcs_size(); src_index++) {
     auto t = env.get_type(insn->src(src_index));
     if (t.element() == REFERENCE) {
@@ -497,7 +499,7 @@ const DexType* OutlinerTypeAnalysis::get_type_demand(IRInstruction* insn,
   case OPCODE_ARRAY_LENGTH:
   case OPCODE_FILL_ARRAY_DATA: {
     always_assert(src_index == 0);
-    auto& env = m_type_environments->at(insn);
+    auto& env = get_type_environment(insn);
     auto dex_type = env.get_dex_type(insn->src(0));
     return dex_type ? *dex_type : nullptr;
   }
@@ -647,7 +649,7 @@ const DexType* OutlinerTypeAnalysis::get_type_demand(IRInstruction* insn,
   case OPCODE_AGET_WIDE:
   case OPCODE_AGET_OBJECT:
     if (src_index == 0) {
-      auto& env = m_type_environments->at(insn);
+      auto& env = get_type_environment(insn);
       auto dex_type = env.get_dex_type(insn->src(0));
       return dex_type ? *dex_type : nullptr;
     }
@@ -665,7 +667,7 @@ const DexType* OutlinerTypeAnalysis::get_type_demand(IRInstruction* insn,
       if (insn->opcode() == OPCODE_APUT_OBJECT) {
         return DexType::make_type("[Ljava/lang/Object;");
       }
-      auto& env = m_type_environments->at(insn);
+      auto& env = get_type_environment(insn);
       auto dex_type = env.get_dex_type(insn->src(1));
       return dex_type ? *dex_type : nullptr;
     }
@@ -674,7 +676,7 @@ const DexType* OutlinerTypeAnalysis::get_type_demand(IRInstruction* insn,
     switch (insn->opcode()) {
     case OPCODE_APUT:
     case OPCODE_APUT_WIDE: {
-      auto& env = m_type_environments->at(insn);
+      auto& env = get_type_environment(insn);
       auto dex_type = env.get_dex_type(insn->src(1));
       return (dex_type && type::is_array(*dex_type))
                  ? type::get_array_component_type(*dex_type)
@@ -17,13 +17,10 @@
 #include "Lazy.h"
 #include "PartialCandidates.h"
 #include "ReachingDefinitions.h"
-#include "TypeInference.h"
+#include "TypeInferenceCache.h"
 
 namespace outliner_impl {
 
-using TypeEnvironments =
-    std::unordered_map<const IRInstruction*, type_inference::TypeEnvironment>;
-
 using ReachingDefsEnvironments =
     std::unordered_map<const IRInstruction*, reaching_defs::Environment>;
 
@@ -60,12 +57,16 @@ class OutlinerTypeAnalysis {
  private:
   DexMethod* m_method;
   Lazy<ReachingDefsEnvironments> m_reaching_defs_environments;
-  Lazy<TypeEnvironments> m_type_environments;
+  std::shared_ptr<const type_inference::CachedTypeEnvironments>
+      m_type_environments;
   Lazy<constant_uses::ConstantUses> m_constant_uses;
 
   const DexType* narrow_type_demands(
       std::unordered_set<const DexType*> type_demands);
 
+  const type_inference::TypeEnvironment& get_type_environment(
+      const IRInstruction* insn);
+
   size_t get_load_param_index(const IRInstruction* load_param_insn);
 
   const DexType* get_result_type_helper(const IRInstruction* insn);
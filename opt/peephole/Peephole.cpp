@@ -8,6 +8,7 @@
 #include "Peephole.h"
 
 #include <algorithm>
+#include <bitset>
 #include <cinttypes>
 #include <cmath>
 #include <iostream>
@@ -250,6 +251,18 @@ struct DexPattern {
       : kind(Kind::copy), copy_index(index) {}
 };
 
+// IR opcodes are numbered densely from zero, so sets of them are bitsets.
+constexpr size_t kNumOpcodes = IOPCODE_MOVE_RESULT_PSEUDO_WIDE + 1;
+using OpcodeSet = std::bitset<kNumOpcodes>;
+
+OpcodeSet to_opcode_set(const std::unordered_set<uint16_t>& opcodes) {
+  OpcodeSet result;
+  for (auto opcode : opcodes) {
+    result.set(opcode);
+  }
+  return result;
+}
+
 struct Matcher;
 
 struct Pattern {
@@ -274,13 +287,35 @@ struct Matcher {
   size_t match_index;
   std::vector<IRInstruction*> matched_instructions;
 
+  // The opcodes each element of the pattern accepts, and the opcodes which a
+  // replacement may introduce.
+  std::vector<OpcodeSet> match_opcodes;
+  OpcodeSet replacement_opcodes;
+
   std::unordered_map<Register, reg_t, EnumClassHash> matched_regs;
   std::unordered_map<String, DexString*, EnumClassHash> matched_strings;
   std::unordered_map<Literal, int64_t, EnumClassHash> matched_literals;
   std::unordered_map<Type, DexType*, EnumClassHash> matched_types;
   std::unordered_map<Field, DexFieldRef*, EnumClassHash> matched_fields;
 
-  explicit Matcher(const Pattern& pattern) : pattern(pattern), match_index(0) {}
+  explicit Matcher(const Pattern& pattern) : pattern(pattern), match_index(0) {
+    for (const auto& dex_pattern : pattern.match) {
+      match_opcodes.push_back(to_opcode_set(dex_pattern.opcodes));
+    }
+    for (const auto& dex_pattern : pattern.replace) {
+      replacement_opcodes |= to_opcode_set(dex_pattern.opcodes);
+    }
+  }
+
+  // Whether the pattern can match anything in code made up of the given
+  // opcodes.
+  bool may_match(const OpcodeSet& present) const {
+    return std::all_of(match_opcodes.begin(),
+                       match_opcodes.end(),
+                       [&](const OpcodeSet& opcodes) {
+                         return (opcodes & present).any();
+                       });
+  }
 
   void reset() {
     match_index = 0;
@@ -339,10 +374,10 @@ struct Matcher {
       return newly_inserted ? true : result.first->second == insn_field;
     };
 
-    // Does 'insn' match to the given DexPattern?
-    auto match_instruction = [&](const DexPattern& dex_pattern) {
-      if (dex_pattern.opcodes.find(insn->opcode()) ==
-              end(dex_pattern.opcodes) ||
+    // Does 'insn' match to the DexPattern at the given index?
+    auto match_instruction = [&](size_t index) {
+      const DexPattern& dex_pattern = pattern.match[index];
+      if (!match_opcodes[index].test(insn->opcode()) ||
           dex_pattern.srcs.size() != insn->srcs_size() ||
           dex_pattern.dests.size() != insn->has_dest()) {
         return false;
@@ -381,7 +416,7 @@ struct Matcher {
     };
 
     redex_assert(match_index < pattern.match.size());
-    if (!match_instruction(pattern.match[match_index])) {
+    if (!match_instruction(match_index)) {
       // Okay, this is the PG's heuristic. Retry only if the failure occurs on
       // the second opcode of the pattern.
       bool retry = (match_index == 1);
@@ -394,7 +429,7 @@ struct Matcher {
       reset();
       if (retry) {
         redex_assert(match_index == 0);
-        if (!match_instruction(pattern.match[match_index])) {
+        if (!match_instruction(match_index)) {
           return false;
         }
       } else {
@@ -1734,10 +1769,22 @@ class alignas(CACHE_LINE_SIZE) PeepholeOptimizer {
     code->build_cfg(/* editable */ true);
     auto& cfg = code->cfg();
 
+    // The opcodes in the method. Patterns which need an opcode that is not
+    // among them are skipped without looking at the code. Replacements only
+    // ever add opcodes to this set, so it may hold stale ones.
+    OpcodeSet present;
+    for (const auto& mie : cfg::InstructionIterable(cfg)) {
+      present.set(mie.insn->opcode());
+    }
+
     // do optimizations one at a time
     // so they can match on the same pattern without interfering
     for (size_t i = 0; i < m_matchers.size(); ++i) {
       auto& matcher = m_matchers[i];
+      if (!matcher.may_match(present)) {
+        continue;
+      }
+      auto matches_before = m_stats.at(i);
 
       const auto& blocks = cfg.blocks();
       cfg::CFGMutation mutator(cfg);
@@ -1794,6 +1841,9 @@ class alignas(CACHE_LINE_SIZE) PeepholeOptimizer {
 
       // Apply the mutator.
       mutator.flush();
+      if (m_stats.at(i) != matches_before) {
+        present |= matcher.replacement_opcodes;
+      }
     }
 
     code->clear_cfg();
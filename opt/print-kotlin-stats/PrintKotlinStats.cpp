@@ -146,7 +146,7 @@ PrintKotlinStats::Stats PrintKotlinStats::handle_class(DexClass* cls) {
         stats.kotlin_default_arg_method++;
       }
     }
-    if (is_anonymous(cls->get_name()->str())) {
+    if (is_anonymous(cls->get_name()->str_copy())) {
       stats.kotlin_anonymous_class++;
     }
     if (boost::algorithm::ends_with(cls->get_name()->str(), "$Companion;")) {
@@ -7,7 +7,9 @@
 
 #include "ReduceArrayLiterals.h"
 
+#include <algorithm>
 #include <cinttypes>
+#include <numeric>
 #include <vector>
 
 #include "BaseIRAnalyzer.h"
@@ -348,6 +350,195 @@ class Analyzer final : public BaseIRAnalyzer<TrackedDomainEnvironment> {
       m_escaped_arrays;
 };
 
+using ArrayLiterals =
+    std::unordered_map<const IRInstruction*, std::vector<const IRInstruction*>>;
+
+/*
+ * A streaming version of the Analyzer for code that consists of a single
+ * block, as is typical for methods that initialize large data tables. Without
+ * joins, each register holds exactly one tracked value, and the elements of an
+ * array under construction are kept once per array rather than in every copy
+ * of its tracked value. Gives up when two copies of the same array get
+ * extended differently, leaving such code to the Analyzer.
+ */
+class StraightLineAnalyzer {
+ public:
+  explicit StraightLineAnalyzer(const cfg::ControlFlowGraph& cfg)
+      : m_regs(cfg.get_registers_size()) {}
+
+  boost::optional<ArrayLiterals> run(cfg::Block* block) {
+    for (auto& mie : InstructionIterable(block)) {
+      if (!analyze_instruction(mie.insn)) {
+        return boost::none;
+      }
+    }
+    ArrayLiterals result;
+    for (auto& p : m_arrays) {
+      if (p.second.escape == Escape::Literal) {
+        result.emplace(p.first, std::move(p.second.elements));
+      }
+    }
+    return result;
+  }
+
+ private:
+  // The state of a register. For kind == NewArray, `size` elements of the
+  // array have been initialized in order.
+  struct Value {
+    TrackedValueKind kind{TrackedValueKind::Other};
+    int32_t literal{0};
+    uint32_t length{0};
+    const IRInstruction* new_array_insn{nullptr};
+    uint32_t size{0};
+  };
+
+  // Mirrors the EscapedArrayDomain of the Analyzer: all escaping copies of a
+  // literal array have the same elements.
+  enum class Escape { None, Literal, Top };
+
+  struct Array {
+    std::vector<const IRInstruction*> elements;
+    Escape escape{Escape::None};
+  };
+
+  Value& at(reg_t reg) {
+    if (reg == RESULT_REGISTER) {
+      return m_result;
+    }
+    always_assert(reg < m_regs.size());
+    return m_regs[reg];
+  }
+
+  void set(reg_t reg, bool wide, const Value& value) {
+    at(reg) = value;
+    if (wide) {
+      at(reg + 1) = Value();
+    }
+  }
+
+  void escape(reg_t reg) {
+    const auto& value = at(reg);
+    if (value.kind != TrackedValueKind::NewArray) {
+      return;
+    }
+    auto& array = m_arrays[value.new_array_insn];
+    if (value.size != value.length) {
+      array.escape = Escape::Top;
+    } else if (array.escape == Escape::None) {
+      array.escape = Escape::Literal;
+    }
+  }
+
+  void default_case(const IRInstruction* insn) {
+    for (size_t i = 0; i < insn->srcs_size(); i++) {
+      escape(insn->src(i));
+    }
+    if (insn->has_dest()) {
+      set(insn->dest(), insn->dest_is_wide(), Value());
+    } else if (insn->has_move_result_any()) {
+      m_result = Value();
+    }
+  }
+
+  // Returns false when giving up.
+  bool analyze_instruction(const IRInstruction* insn) {
+    switch (insn->opcode()) {
+    case OPCODE_CONST: {
+      Value value;
+      value.kind = TrackedValueKind::Literal;
+      value.literal = (int32_t)insn->get_literal();
+      set(insn->dest(), false /* is_wide */, value);
+      return true;
+    }
+
+    case OPCODE_NEW_ARRAY: {
+      const auto& length = at(insn->src(0));
+      if (length.kind == TrackedValueKind::Literal) {
+        always_assert(length.literal >= 0);
+        Value value;
+        value.kind = TrackedValueKind::NewArray;
+        value.length = length.literal;
+        value.new_array_insn = insn;
+        m_result = value;
+        m_arrays[insn];
+        return true;
+      }
+      m_arrays[insn].escape = Escape::Top;
+      default_case(insn);
+      return true;
+    }
+
+    case IOPCODE_MOVE_RESULT_PSEUDO_OBJECT:
+      set(insn->dest(), false /* is_wide */, m_result);
+      return true;
+
+    case OPCODE_APUT:
+    case OPCODE_APUT_BYTE:
+    case OPCODE_APUT_CHAR:
+    case OPCODE_APUT_WIDE:
+    case OPCODE_APUT_SHORT:
+    case OPCODE_APUT_OBJECT:
+    case OPCODE_APUT_BOOLEAN: {
+      escape(insn->src(0));
+      auto& array = at(insn->src(1));
+      const auto& index = at(insn->src(2));
+      if (array.kind == TrackedValueKind::NewArray &&
+          array.size != array.length &&
+          index.kind == TrackedValueKind::Literal &&
+          index.literal == (int64_t)array.size) {
+        auto& elements = m_arrays[array.new_array_insn].elements;
+        if (elements.size() != array.size) {
+          return false;
+        }
+        elements.push_back(insn);
+        array.size++;
+        return true;
+      }
+      default_case(insn);
+      return true;
+    }
+
+    case OPCODE_MOVE: {
+      const auto value = at(insn->src(0));
+      if (value.kind == TrackedValueKind::Literal) {
+        set(insn->dest(), false /* is_wide */, value);
+        return true;
+      }
+      default_case(insn);
+      return true;
+    }
+
+    default:
+      default_case(insn);
+      return true;
+    }
+  }
+
+  std::vector<Value> m_regs;
+  Value m_result;
+  std::unordered_map<const IRInstruction*, Array> m_arrays;
+};
+
+bool is_straight_line(const cfg::ControlFlowGraph& cfg) {
+  return cfg.num_blocks() == 1 && cfg.entry_block()->succs().empty();
+}
+
+// Returns the number of instructions of the given code if it may contain array
+// literals, as it both creates and stores into arrays, and 0 otherwise. This
+// doesn't need the CFG.
+size_t array_literal_candidate_size(IRCode* code) {
+  size_t size = 0;
+  bool has_new_array = false;
+  bool has_aput = false;
+  for (const auto& mie : InstructionIterable(code)) {
+    auto op = mie.insn->opcode();
+    has_new_array |= op == OPCODE_NEW_ARRAY;
+    has_aput |= opcode::is_an_aput(op);
+    size++;
+  }
+  return has_new_array && has_aput ? size : 0;
+}
+
 } // namespace
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -373,16 +564,22 @@ ReduceArrayLiterals::ReduceArrayLiterals(cfg::ControlFlowGraph& cfg,
     return;
   }
 
-  Analyzer analyzer(cfg);
-  auto array_literals = analyzer.get_array_literals();
+  boost::optional<ArrayLiterals> array_literals;
+  if (is_straight_line(cfg)) {
+    array_literals = StraightLineAnalyzer(cfg).run(cfg.entry_block());
+  }
+  if (!array_literals) {
+    Analyzer analyzer(cfg);
+    array_literals = analyzer.get_array_literals();
+  }
   // sort array literals by order of occurrence for determinism
   for (IRInstruction* new_array_insn : new_array_insns) {
-    auto it = array_literals.find(new_array_insn);
-    if (it != array_literals.end()) {
+    auto it = array_literals->find(new_array_insn);
+    if (it != array_literals->end()) {
       m_array_literals.push_back(*it);
     }
   }
-  always_assert(array_literals.size() == m_array_literals.size());
+  always_assert(array_literals->size() == m_array_literals.size());
 }
 
 void ReduceArrayLiterals::patch() {
@@ -675,23 +872,51 @@ void ReduceArrayLiteralsPass::run_pass(DexStoresVector& stores,
         architecture_to_string(arch));
 
   const auto scope = build_class_scope(stores);
+  const size_t num_threads =
+      m_debug ? 1 : redex_parallel::default_num_threads();
 
-  const auto stats = walk::parallel::methods<ReduceArrayLiterals::Stats>(
-      scope,
-      [&](DexMethod* m) {
-        const auto code = m->get_code();
-        if (code == nullptr || m->rstate.no_optimizations()) {
-          return ReduceArrayLiterals::Stats();
-        }
+  std::vector<DexMethod*> methods;
+  walk::code(scope, [&](DexMethod* m, IRCode&) {
+    if (!m->rstate.no_optimizations()) {
+      methods.push_back(m);
+    }
+  });
 
+  // Only build CFGs of, and analyze, the methods that may have array literals,
+  // found by a linear pre-scan.
+  std::vector<size_t> sizes(methods.size());
+  std::vector<size_t> indices(methods.size());
+  std::iota(indices.begin(), indices.end(), 0);
+  workqueue_run<size_t>(
+      [&](size_t i) {
+        sizes[i] = array_literal_candidate_size(methods[i]->get_code());
+      },
+      indices, num_threads);
+  indices.erase(std::remove_if(indices.begin(), indices.end(),
+                               [&](size_t i) { return sizes[i] == 0; }),
+                indices.end());
+
+  // A few huge generated methods can take longer than all others together, so
+  // start with the largest methods, leaving small ones to balance the load.
+  std::stable_sort(indices.begin(), indices.end(),
+                   [&](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+  std::vector<ReduceArrayLiterals::Stats> method_stats(methods.size());
+  workqueue_run<size_t>(
+      [&](size_t i) {
+        auto* code = methods[i]->get_code();
         code->build_cfg(/* editable */ true);
         ReduceArrayLiterals ral(code->cfg(), m_max_filled_elements, min_sdk,
                                 arch);
         ral.patch();
         code->clear_cfg();
-        return ral.get_stats();
+        method_stats[i] = ral.get_stats();
       },
-      m_debug ? 1 : redex_parallel::default_num_threads());
+      indices, num_threads);
+
+  ReduceArrayLiterals::Stats stats;
+  for (const auto& s : method_stats) {
+    stats += s;
+  }
   mgr.incr_metric(METRIC_FILLED_ARRAYS, stats.filled_arrays);
   mgr.incr_metric(METRIC_FILLED_ARRAY_ELEMENTS, stats.filled_array_elements);
   mgr.incr_metric(METRIC_FILLED_ARRAY_CHUNKS, stats.filled_array_chunks);
@@ -465,11 +465,12 @@ void ReduceGotosPass::process_code_ifs(cfg::ControlFlowGraph& cfg,
       auto throw_res = process_code_ifs_impl(
           cfg.order(), cfg,
           [&cfg](const cfg::Block* b) {
-            return !cfg.get_succ_edges_of_type(b, cfg::EDGE_THROW).empty();
+            return cfg.get_succ_edge_of_type(b, cfg::EDGE_THROW) != nullptr;
           },
           [](IROpcode op) { return op == OPCODE_THROW; },
           [&cfg](const cfg::Block* to, const cfg::Block* from) {
-            return !cfg.get_succ_edges_of_type(from, cfg::EDGE_THROW).empty();
+            return cfg.get_succ_edge_of_type(from, cfg::EDGE_THROW) !=
+                   nullptr;
           });
       rerun |= std::get<0>(throw_res);
       stats.removed_trailing_moves += std::get<1>(throw_res);
@@ -29,6 +29,8 @@ void RegAllocPass::run_pass(DexStoresVector& stores,
   graph_coloring::Allocator::Config allocator_config;
   const auto& jw = mgr.get_current_pass_info()->config;
   jw.get("live_range_splitting", false, allocator_config.use_splitting);
+  jw.get("live_range_splitting_cold_methods", true,
+         allocator_config.split_cold_methods);
   allocator_config.no_overwrite_this =
       mgr.get_redex_options().no_overwrite_this();
 
@@ -43,15 +45,22 @@ void RegAllocPass::run_pass(DexStoresVector& stores,
   TRACE(REG, 1, "  Total param spills: %lu", stats.param_spill_moves);
   TRACE(REG, 1, "  Total range spills: %lu", stats.range_spill_moves);
   TRACE(REG, 1, "  Total global spills: %lu", stats.global_spill_moves);
+  TRACE(REG, 1, "  Total spills in cold blocks: %lu", stats.cold_spill_moves);
   TRACE(REG, 1, "  Total splits: %lu", stats.split_moves);
   TRACE(REG, 1, "Total coalesce count: %lu", stats.moves_coalesced);
   TRACE(REG, 1, "Total net moves: %ld", stats.net_moves());
+  TRACE(REG, 1, "Cold methods not split: %lu", stats.cold_methods_not_split);
 
   mgr.incr_metric("param spilled too early", stats.params_spill_early);
   mgr.incr_metric("reiteration_count", stats.reiteration_count);
   mgr.incr_metric("spill_count", stats.moves_inserted());
+  mgr.incr_metric("cold_spill_count", stats.cold_spill_moves);
+  mgr.incr_metric("hot_spill_count",
+                  stats.range_spill_moves + stats.global_spill_moves -
+                      stats.cold_spill_moves);
   mgr.incr_metric("coalesce_count", stats.moves_coalesced);
   mgr.incr_metric("net_moves", stats.net_moves());
+  mgr.incr_metric("cold_methods_not_split", stats.cold_methods_not_split);
 
   ++m_run;
   // For the last invocation, record that final register allocation has been
@@ -10,6 +10,7 @@
 #include <boost/regex.hpp>
 #include <tuple>
 
+#include "ConcurrentContainers.h"
 #include "ConfigFiles.h"
 #include "Dataflow.h"
 #include "DexUtil.h"
@@ -18,6 +19,7 @@
 #include "RemoveBuildersHelper.h"
 #include "Resolver.h"
 #include "Walkers.h"
+#include "WorkQueue.h"
 
 namespace {
 
@@ -77,7 +79,7 @@ bool this_arg_escapes(DexClass* cls, bool enable_buildee_constr_change) {
       TRACE(BUILDERS,
             3,
             "this escapes in %s",
-            m->get_deobfuscated_name().c_str());
+            m->get_deobfuscated_name_copy().c_str());
       result = true;
     }
   }
@@ -89,7 +91,7 @@ bool this_arg_escapes(DexClass* cls, bool enable_buildee_constr_change) {
       TRACE(BUILDERS,
             3,
             "this escapes in %s",
-            m->get_deobfuscated_name().c_str());
+            m->get_deobfuscated_name_copy().c_str());
       result = true;
     }
   }
@@ -210,12 +212,13 @@ std::vector<DexType*> RemoveBuildersPass::created_builders(DexMethod* m) {
 // checks if any instances of :builder that get created in the method ever get
 // passed to a method (aside from when its own instance methods get invoked),
 // or if they get stored in a field, or if they escape as a return value.
+// Expects the method's CFG to be built already, so that it is built only once
+// per method rather than once per builder.
 bool RemoveBuildersPass::escapes_stack(DexType* builder, DexMethod* method) {
   always_assert(builder != nullptr);
   always_assert(method != nullptr);
 
   auto code = method->get_code();
-  code->build_cfg(/* editable */ false);
   const auto& blocks = code->cfg().blocks_reverse_post_deprecated();
   auto regs_size = method->get_code()->get_registers_size();
   auto taint_map = get_tainted_regs(regs_size, blocks, builder);
@@ -250,24 +253,36 @@ void RemoveBuildersPass::run_pass(DexStoresVector& stores,
     }
   }
 
-  std::unordered_set<DexType*> escaped_builders;
-  walk::methods(scope, [&](DexMethod* m) {
+  // Methods are analyzed in parallel. Once a builder is known to escape
+  // somewhere, there is no point in analyzing its other uses.
+  ConcurrentSet<DexType*> escaped_builders;
+  walk::parallel::methods(scope, [&](DexMethod* m) {
     auto builders = created_builders(m);
+    if (builders.empty()) {
+      return;
+    }
+    std::sort(builders.begin(), builders.end(), compare_dextypes);
+    builders.erase(std::unique(builders.begin(), builders.end()),
+                   builders.end());
+    m->get_code()->build_cfg(/* editable */ false);
     for (DexType* builder : builders) {
+      if (escaped_builders.count(builder)) {
+        continue;
+      }
       if (escapes_stack(builder, m)) {
         TRACE(BUILDERS,
               3,
               "%s escapes in %s",
               SHOW(builder),
-              m->get_deobfuscated_name().c_str());
-        escaped_builders.emplace(builder);
+              m->get_deobfuscated_name_copy().c_str());
+        escaped_builders.insert(builder);
       }
     }
   });
 
   std::unordered_set<DexType*> stack_only_builders;
   for (DexType* builder : m_builders) {
-    if (escaped_builders.find(builder) == escaped_builders.end()) {
+    if (!escaped_builders.count(builder)) {
       stack_only_builders.emplace(builder);
     }
   }
@@ -281,14 +296,16 @@ void RemoveBuildersPass::run_pass(DexStoresVector& stores,
     }
   }
 
-  std::unordered_set<DexType*> this_escapes;
-  for (DexType* cls_ty : builders_and_supers) {
-    DexClass* cls = type_class(cls_ty);
-    if (cls->is_external() ||
-        this_arg_escapes(cls, m_enable_buildee_constr_change)) {
-      this_escapes.emplace(cls_ty);
-    }
-  }
+  ConcurrentSet<DexType*> this_escapes;
+  workqueue_run<DexType*>(
+      [&](DexType* cls_ty) {
+        DexClass* cls = type_class(cls_ty);
+        if (cls->is_external() ||
+            this_arg_escapes(cls, m_enable_buildee_constr_change)) {
+          this_escapes.insert(cls_ty);
+        }
+      },
+      builders_and_supers);
 
   // set of builders that neither escape the stack nor pass their 'this' arg
   // to another function
@@ -297,7 +314,7 @@ void RemoveBuildersPass::run_pass(DexStoresVector& stores,
     DexType* cls = builder;
     bool hierarchy_has_escape = false;
     while (cls != nullptr) {
-      if (this_escapes.find(cls) != this_escapes.end()) {
+      if (this_escapes.count(cls)) {
         hierarchy_has_escape = true;
         break;
       }
@@ -358,7 +375,7 @@ void RemoveBuildersPass::run_pass(DexStoresVector& stores,
         DexMethod* method_copy = DexMethod::make_method_from(
             method,
             method->get_class(),
-            DexString::make_string(method->get_name()->str() +
+            DexString::make_string(method->get_name()->str_copy() +
                                    "$redex_builders"));
         bool was_not_removed =
             !b_transform.inline_methods(
@@ -684,7 +684,7 @@ bool params_change_regs(DexMethod* method) {
 DexProto* make_proto_for(DexClass* cls) {
   const auto& fields = cls->get_ifields();
 
-  std::deque<DexType*> dfields;
+  DexTypeList::ContainerType dfields;
   for (const DexField* field : fields) {
     dfields.push_back(field->get_type());
   }
@@ -1098,9 +1098,10 @@ bool has_builder_name(DexType* type) {
 
   static boost::regex re{"\\$Builder;$"};
 
-  const auto& deobfuscated_name = type_class(type)->get_deobfuscated_name();
+  auto deobfuscated_name = type_class(type)->get_deobfuscated_name();
   if (!deobfuscated_name.empty()) {
-    return boost::regex_search(deobfuscated_name.c_str(), re);
+    return boost::regex_search(deobfuscated_name.begin(),
+                               deobfuscated_name.end(), re);
   }
   return boost::regex_search(type->c_str(), re);
 }
@@ -1108,9 +1109,10 @@ bool has_builder_name(DexType* type) {
 DexType* get_buildee(DexType* builder) {
   always_assert(builder != nullptr);
 
-  const auto& deobfuscated_name = type_class(builder)->get_deobfuscated_name();
-  const auto& builder_name =
-      !deobfuscated_name.empty() ? deobfuscated_name : builder->str();
+  auto deobfuscated_name = type_class(builder)->get_deobfuscated_name();
+  const auto builder_name = !deobfuscated_name.empty()
+                                ? std::string(deobfuscated_name)
+                                : builder->str_copy();
 
   auto buildee_name = builder_name.substr(0, builder_name.size() - 9) + ";";
   return DexType::get_type(buildee_name.c_str());
@@ -183,7 +183,7 @@ DexTypeList* get_new_impl_list(const DexType* impl,
   auto cls_to_remove = type_class(intf_to_remove);
   auto& super_intfs = cls_to_remove->get_interfaces()->get_type_list();
   new_intfs.insert(super_intfs.begin(), super_intfs.end());
-  std::deque<DexType*> deque(new_intfs.begin(), new_intfs.end());
+  DexTypeList::ContainerType deque(new_intfs.begin(), new_intfs.end());
   return DexTypeList::make_type_list(std::move(deque));
 }
 
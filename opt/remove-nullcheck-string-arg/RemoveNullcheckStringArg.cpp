@@ -258,8 +258,8 @@ RemoveNullcheckStringArg::Stats RemoveNullcheckStringArg::change_in_cfg(
   std::unordered_map<size_t, uint32_t> param_index;
   uint32_t arg_index = is_virtual ? -1 : 0;
 
-  reaching_defs::MoveAwareFixpointIterator reaching_defs_iter(cfg);
-  reaching_defs_iter.run({});
+  live_range::LazyChains chains(cfg);
+  const auto& reaching_defs_iter = chains.get_fp_iter();
 
   for (const auto& mie : InstructionIterable(params)) {
     auto load_insn = mie.insn;
@@ -267,9 +267,6 @@ RemoveNullcheckStringArg::Stats RemoveNullcheckStringArg::change_in_cfg(
     param_index.insert(std::make_pair(load_insn->dest(), arg_index++));
   }
 
-  live_range::MoveAwareChains chains(cfg);
-  live_range::DefUseChains du_chains = chains.get_def_use_chains();
-
   for (cfg::Block* block : cfg.blocks()) {
     auto env = reaching_defs_iter.get_entry_state_at(block);
     if (env.is_bottom()) {
@@ -311,7 +308,7 @@ RemoveNullcheckStringArg::Stats RemoveNullcheckStringArg::change_in_cfg(
         auto param_iter = param_index.find(param_load_insn->dest());
         always_assert(param_iter != param_index.end());
 
-        auto use_set = du_chains[param_load_insn];
+        auto use_set = chains.get_uses(param_load_insn);
         if (use_set.size() == 1) {
           for (const auto& p : use_set) {
             always_assert(p.insn == insn);
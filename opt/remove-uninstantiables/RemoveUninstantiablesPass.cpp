@@ -79,6 +79,48 @@ bool operator==(const VirtualScopeId& a, const VirtualScopeId& b) {
 using VirtualScopeIdSet =
     std::unordered_set<VirtualScopeId, VirtualScopeIdHasher>;
 
+/// \return true if \p insn mentions an uninstantiable type in a way that
+/// RemoveUninstantiablesPass::replace_uninstantiable_refs rewrites. This must
+/// cover all the cases handled there.
+bool refs_uninstantiable(
+    const std::unordered_set<DexType*>& scoped_uninstantiable_types,
+    const IRInstruction* insn) {
+  auto op = insn->opcode();
+  switch (op) {
+  case OPCODE_INSTANCE_OF:
+  case OPCODE_CHECK_CAST:
+    return scoped_uninstantiable_types.count(insn->get_type());
+  case OPCODE_INVOKE_DIRECT:
+  case OPCODE_INVOKE_VIRTUAL:
+  case OPCODE_INVOKE_INTERFACE:
+  case OPCODE_INVOKE_SUPER:
+    return scoped_uninstantiable_types.count(insn->get_method()->get_class());
+  default:
+    break;
+  }
+  if (opcode::is_an_iget(op) || opcode::is_an_iput(op)) {
+    if (scoped_uninstantiable_types.count(insn->get_field()->get_class())) {
+      return true;
+    }
+  }
+  return (opcode::is_an_iget(op) || opcode::is_an_sget(op)) &&
+         scoped_uninstantiable_types.count(insn->get_field()->get_type());
+}
+
+/// \return true if any instruction of \p code refers to an uninstantiable
+/// type. This only scans the linear code, so that methods without such
+/// references, i.e. most methods, don't need a CFG at all.
+bool has_uninstantiable_refs(
+    const std::unordered_set<DexType*>& scoped_uninstantiable_types,
+    IRCode& code) {
+  for (const auto& mie : InstructionIterable(code)) {
+    if (refs_uninstantiable(scoped_uninstantiable_types, mie.insn)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 // Helper analysis that determines if we need to keep the code of a method (or
 // if it can never run)
 class OverriddenVirtualScopesAnalysis {
@@ -466,8 +508,14 @@ void RemoveUninstantiablesPass::run_pass(DexStoresVector& stores,
           return stats;
         }
 
+        bool keep_code = overridden_virtual_scopes_analysis.keep_code(method);
+        if (keep_code &&
+            !has_uninstantiable_refs(scoped_uninstantiable_types, *code)) {
+          return stats;
+        }
+
         code->build_cfg();
-        if (overridden_virtual_scopes_analysis.keep_code(method)) {
+        if (keep_code) {
           stats += replace_uninstantiable_refs(scoped_uninstantiable_types,
                                                code->cfg());
         } else {
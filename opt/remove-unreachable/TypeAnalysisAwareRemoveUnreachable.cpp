@@ -234,7 +234,7 @@ std::unique_ptr<ReachableObjects> compute_reachable_objects_with_type_anaysis(
     code.cfg().calculate_exit_block();
   });
 
-  auto reachable_objects = std::make_unique<ReachableObjects>();
+  auto reachable_objects = std::make_unique<ReachableObjects>(scope);
   ConditionallyMarked cond_marked;
   auto method_override_graph = mog::build_graph(scope);
 
@@ -9,12 +9,14 @@
 
 #include <deque>
 #include <mutex>
+#include <numeric>
 #include <unordered_map>
 #include <vector>
 
 #include "CallGraph.h"
 #include "DexClass.h"
 #include "DexUtil.h"
+#include "HierarchyAnalysis.h"
 #include "IRCode.h"
 #include "Liveness.h"
 #include "Match.h"
@@ -61,7 +63,10 @@ static LocalDce::Stats add_dce_stats(LocalDce::Stats a, LocalDce::Stats b) {
 RemoveArgs::PassStats RemoveArgs::run() {
   RemoveArgs::PassStats pass_stats;
   gather_results_used();
-  auto override_graph = mog::build_graph(m_scope);
+  auto override_graph = m_override_graph;
+  if (override_graph == nullptr) {
+    override_graph = mog::build_graph(m_scope);
+  }
   compute_reordered_protos(*override_graph);
   auto method_stats = update_method_protos(*override_graph);
   pass_stats.method_params_removed_count =
@@ -297,9 +302,9 @@ std::deque<uint16_t> compute_live_args(
  * Returns an updated argument type list for the given method with the given
  * live argument indices.
  */
-std::deque<DexType*> RemoveArgs::get_live_arg_type_list(
+DexTypeList::ContainerType RemoveArgs::get_live_arg_type_list(
     DexMethod* method, const std::deque<uint16_t>& live_arg_idxs) {
-  std::deque<DexType*> live_args;
+  DexTypeList::ContainerType live_args;
   auto args_list = method->get_proto()->get_args()->get_type_list();
 
   for (uint16_t arg_num : live_arg_idxs) {
@@ -326,12 +331,12 @@ bool RemoveArgs::update_method_signature(
   always_assert_log(method->is_def(),
                     "We don't treat virtuals, so methods must be defined\n");
 
-  const std::string& full_name = method->get_deobfuscated_name();
+  auto full_name = method->get_deobfuscated_name();
   for (const auto& s : m_blocklist) {
     if (full_name.find(s) != std::string::npos) {
       TRACE(ARGS, 3,
             "Skipping {%s} due to black list match of {%s} against {%s}",
-            SHOW(method), full_name.c_str(), s.c_str());
+            SHOW(method), std::string(full_name).c_str(), s.c_str());
       return false;
     }
   }
@@ -423,6 +428,7 @@ static void compute_dead_insns_and_remove_result(
     DexMethod* method,
     const mog::Graph& override_graph,
     const ConcurrentSet<DexMethod*>& results_used,
+    ConcurrentSet<DexMethod*>* all_args_live,
     std::deque<uint16_t>* live_arg_idxs,
     std::vector<IRInstruction*>* dead_insns,
     bool* remove_result) {
@@ -456,7 +462,17 @@ static void compute_dead_insns_and_remove_result(
     return;
   }
 
+  if (all_args_live != nullptr && all_args_live->count(method)) {
+    // The code didn't change since all args were found live.
+    live_arg_idxs->resize(is_static(method) ? num_args : num_args + 1);
+    std::iota(live_arg_idxs->begin(), live_arg_idxs->end(), 0);
+    return;
+  }
+
   *live_arg_idxs = compute_live_args(method, num_args, dead_insns);
+  if (all_args_live != nullptr && dead_insns->empty()) {
+    all_args_live->insert(method);
+  }
 }
 
 // When reordering a method's proto, we need to update the method's load-param
@@ -539,9 +555,9 @@ RemoveArgs::MethodStats RemoveArgs::update_method_protos(
       reordered_proto = it->second;
     } else {
       // Only if there's no reordering, we'll look at dead args and results
-      compute_dead_insns_and_remove_result(method, override_graph,
-                                           m_result_used, &live_arg_idxs,
-                                           &dead_insns, &remove_result);
+      compute_dead_insns_and_remove_result(
+          method, override_graph, m_result_used, m_all_args_live,
+          &live_arg_idxs, &dead_insns, &remove_result);
       if (dead_insns.empty() && !remove_result) {
         return;
       }
@@ -596,6 +612,9 @@ RemoveArgs::MethodStats RemoveArgs::update_method_protos(
     for (auto& p : class_entries.at(cls)) {
       DexMethod* method = p.first;
       const Entry& entry = p.second;
+      if (m_all_args_live != nullptr) {
+        m_all_args_live->erase(method);
+      }
 
       if (!entry.dead_insns.empty()) {
         // We update the method signature, so we must remove unused
@@ -691,6 +710,10 @@ size_t RemoveArgs::update_callsites() {
             }
           }
         }
+        if (callsite_args_removed > 0 && m_all_args_live != nullptr) {
+          // Registers passed to the removed args may now be dead.
+          m_all_args_live->erase(method);
+        }
         return callsite_args_removed;
       });
 }
@@ -707,9 +730,17 @@ void RemoveUnusedArgsPass::run_pass(DexStoresVector& stores,
   size_t num_method_protos_reordered_count = 0;
   size_t num_iterations = 0;
   LocalDce::Stats local_dce_stats{0, 0};
+  ConcurrentSet<DexMethod*> all_args_live;
   while (true) {
     num_iterations++;
-    RemoveArgs rm_args(scope, m_blocklist, m_total_iterations++);
+    // Each iteration changes protos, so only the first one can use a
+    // preserved override graph.
+    auto override_graph =
+        num_iterations == 1
+            ? hierarchy_analysis::get_method_override_graph(mgr, scope)
+            : nullptr;
+    RemoveArgs rm_args(scope, m_blocklist, m_total_iterations++,
+                       std::move(override_graph), &all_args_live);
     auto pass_stats = rm_args.run();
     if (pass_stats.methods_updated_count == 0) {
       break;
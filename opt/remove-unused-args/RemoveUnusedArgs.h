@@ -40,10 +40,20 @@ class RemoveArgs {
     LocalDce::Stats local_dce_stats{0, 0};
   };
 
+  // If no `override_graph` is given, one is built for the scope.
+  // `all_args_live`, if given, is a liveness cache shared across iterations:
+  // the methods whose arguments were all found live, and whose code has not
+  // changed since. Their liveness is not computed again.
   RemoveArgs(const Scope& scope,
              const std::vector<std::string>& blocklist,
-             size_t iteration = 0)
-      : m_scope(scope), m_blocklist(blocklist), m_iteration(iteration){};
+             size_t iteration = 0,
+             std::shared_ptr<const mog::Graph> override_graph = nullptr,
+             ConcurrentSet<DexMethod*>* all_args_live = nullptr)
+      : m_scope(scope),
+        m_blocklist(blocklist),
+        m_iteration(iteration),
+        m_override_graph(std::move(override_graph)),
+        m_all_args_live(all_args_live){};
   RemoveArgs::PassStats run();
 
  private:
@@ -62,8 +72,10 @@ class RemoveArgs {
   std::unordered_map<DexProto*, DexProto*> m_reordered_protos;
   const std::vector<std::string>& m_blocklist;
   size_t m_iteration;
+  std::shared_ptr<const mog::Graph> m_override_graph;
+  ConcurrentSet<DexMethod*>* m_all_args_live;
 
-  std::deque<DexType*> get_live_arg_type_list(
+  DexTypeList::ContainerType get_live_arg_type_list(
       DexMethod* method, const std::deque<uint16_t>& live_arg_idxs);
   bool update_method_signature(DexMethod* method,
                                const std::deque<uint16_t>& live_arg_idxs,
@@ -117,7 +117,7 @@ bool is_allowed_layout_class(
     const DexClass* clazz,
     const std::vector<std::string>& allow_layout_rename_packages) {
   always_assert(referenced_by_layouts(clazz));
-  auto idx = find_matching_package(clazz->get_name()->str(),
+  auto idx = find_matching_package(clazz->get_name()->str_copy(),
                                    allow_layout_rename_packages);
   return idx != -1;
 }
@@ -136,7 +136,7 @@ RenameClassesPassV2::build_dont_rename_class_name_literals(Scope& scope) {
       "([a-zA-Z][a-zA-Z\\d_$]*\\.)*"
       "[a-zA-Z][a-zA-Z\\d_$]*"};
   for (auto dex_str : all_strings) {
-    const std::string& s = dex_str->str();
+    const std::string s = dex_str->str_copy();
     if (!ends_with(s, ".java") && boost::regex_match(s, external_name_regex)) {
       const std::string& internal_name = java_names::external_to_internal(s);
       auto cls = type_class(DexType::get_type(internal_name));
@@ -180,7 +180,7 @@ RenameClassesPassV2::build_dont_rename_for_types_with_reflection(
           if (callee == nullptr || !callee->is_concrete()) return;
           auto callee_method_cls = callee->get_class();
           if (refl_map.count(callee_method_cls) == 0) return;
-          std::string classname = m->get_class()->get_name()->str();
+          std::string classname = m->get_class()->get_name()->str_copy();
           TRACE(RENAME, 4,
                 "Found %s with known reflection usage. marking reachable",
                 classname.c_str());
@@ -196,7 +196,7 @@ std::unordered_set<std::string> RenameClassesPassV2::build_dont_rename_canaries(
   // Gather canaries
   for (auto clazz : scope) {
     if (strstr(clazz->get_name()->c_str(), "/Canary")) {
-      dont_rename_canaries.insert(clazz->get_name()->str());
+      dont_rename_canaries.insert(clazz->get_name()->str_copy());
     }
   }
   return dont_rename_canaries;
@@ -390,7 +390,7 @@ static void sanity_check(const Scope& scope,
   sort_unique(all_strings);
   int sketchy_strings = 0;
   for (auto s : all_strings) {
-    if (external_names.find(s->str()) != external_names.end() ||
+    if (external_names.find(s->str_copy()) != external_names.end() ||
         name_mapping.get_new_type_name(s)) {
       TRACE(RENAME, 2, "Found %s in string pool after renaming", s->c_str());
       sketchy_strings++;
@@ -482,7 +482,7 @@ void RenameClassesPassV2::eval_classes(Scope& scope,
     for (const auto& anno : dont_rename_annotated) {
       if (has_anno(clazz, anno)) {
         m_dont_rename_reasons[clazz] = {DontRenameReasonCode::Annotated,
-                                        anno->str()};
+                                        anno->str_copy()};
         annotated = true;
         break;
       }
@@ -741,8 +741,8 @@ void RenameClassesPassV2::rename_classes_in_layouts(
   std::map<std::string, std::string> aliases_for_layouts;
   for (const auto& apair : name_mapping.get_class_map()) {
     aliases_for_layouts.emplace(
-        java_names::internal_to_external(apair.first->str()),
-        java_names::internal_to_external(apair.second->str()));
+        java_names::internal_to_external(apair.first->str_copy()),
+        java_names::internal_to_external(apair.second->str_copy()));
   }
   auto resources = create_resource_reader(m_apk_dir);
   resources->rename_classes_in_layouts(aliases_for_layouts);
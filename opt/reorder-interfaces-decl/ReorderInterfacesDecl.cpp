@@ -45,8 +45,8 @@ class ReorderInterfacesDeclImpl {
   void compute_call_frequencies(IRInstruction* insn);
   void reorder_interfaces();
   void reorder_interfaces_for_class(DexClass* cls);
-  std::deque<DexType*> sort_interfaces(
-      const std::deque<DexType*>& unsorted_list);
+  DexTypeList::ContainerType sort_interfaces(
+      const DexTypeList::ContainerType& unsorted_list);
 };
 
 /**
@@ -100,9 +100,9 @@ void ReorderInterfacesDeclImpl::compute_call_frequencies(IRInstruction* insn) {
  * Sort the list of given Interfaces with respect to the number of incoming
  * calls and return the sorted list
  */
-std::deque<DexType*> ReorderInterfacesDeclImpl::sort_interfaces(
-    const std::deque<DexType*>& unsorted_list) {
-  std::deque<DexType*> sorted_list;
+DexTypeList::ContainerType ReorderInterfacesDeclImpl::sort_interfaces(
+    const DexTypeList::ContainerType& unsorted_list) {
+  DexTypeList::ContainerType sorted_list;
   // Create list of interfaces and store frequencies
   std::vector<std::pair<DexType*, int>> list_with_frequencies;
   list_with_frequencies.reserve(unsorted_list.size());
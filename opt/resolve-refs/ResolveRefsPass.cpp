@@ -66,10 +66,12 @@ struct RefStats {
 
 void resolve_method_refs(const DexMethod* caller,
                          IRInstruction* insn,
+                         ConcurrentMethodRefCache& method_cache,
                          RefStats& stats) {
   always_assert(insn->has_method());
   auto mref = insn->get_method();
-  auto mdef = resolve_method(mref, opcode_to_search(insn), caller);
+  auto mdef =
+      resolve_method(mref, opcode_to_search(insn), method_cache, caller);
   if (!mdef || mdef == mref) {
     return;
   }
@@ -92,12 +94,13 @@ void resolve_method_refs(const DexMethod* caller,
 
 void resolve_field_refs(IRInstruction* insn,
                         FieldSearch field_search,
+                        ConcurrentFieldRefCache& field_cache,
                         RefStats& stats) {
   const auto fref = insn->get_field();
   if (fref->is_def()) {
     return;
   }
-  const auto real_ref = resolve_field(fref, field_search);
+  const auto real_ref = resolve_field(fref, field_search, field_cache);
   if (real_ref && !real_ref->is_external() && real_ref != fref) {
     TRACE(RESO, 2, "Resolving %s\n\t=>%s", SHOW(fref), SHOW(real_ref));
     insn->set_field(real_ref);
@@ -111,7 +114,13 @@ void resolve_field_refs(IRInstruction* insn,
   }
 }
 
-RefStats resolve_refs(DexMethod* method) {
+/*
+ * The same refs show up in many methods, so resolutions are shared through
+ * the caches across all the methods walked in parallel.
+ */
+RefStats resolve_refs(DexMethod* method,
+                      ConcurrentMethodRefCache& method_cache,
+                      ConcurrentFieldRefCache& field_cache) {
   RefStats stats;
   if (!method || !method->get_code()) {
     return stats;
@@ -124,7 +133,7 @@ RefStats resolve_refs(DexMethod* method) {
     case OPCODE_INVOKE_SUPER:
     case OPCODE_INVOKE_INTERFACE:
     case OPCODE_INVOKE_STATIC:
-      resolve_method_refs(method, insn, stats);
+      resolve_method_refs(method, insn, method_cache, stats);
       break;
     case OPCODE_SGET:
     case OPCODE_SGET_WIDE:
@@ -140,7 +149,7 @@ RefStats resolve_refs(DexMethod* method) {
     case OPCODE_SPUT_BYTE:
     case OPCODE_SPUT_CHAR:
     case OPCODE_SPUT_SHORT:
-      resolve_field_refs(insn, FieldSearch::Static, stats);
+      resolve_field_refs(insn, FieldSearch::Static, field_cache, stats);
       break;
     case OPCODE_IGET:
     case OPCODE_IGET_WIDE:
@@ -156,7 +165,7 @@ RefStats resolve_refs(DexMethod* method) {
     case OPCODE_IPUT_BYTE:
     case OPCODE_IPUT_CHAR:
     case OPCODE_IPUT_SHORT:
-      resolve_field_refs(insn, FieldSearch::Instance, stats);
+      resolve_field_refs(insn, FieldSearch::Instance, field_cache, stats);
       break;
     default:
       break;
@@ -330,9 +339,12 @@ void ResolveRefsPass::run_pass(DexStoresVector& stores,
                                PassManager& mgr) {
   always_assert(m_min_sdk_api);
   Scope scope = build_class_scope(stores);
+  ConcurrentMethodRefCache method_cache;
+  ConcurrentFieldRefCache field_cache;
   impl::RefStats stats =
       walk::parallel::methods<impl::RefStats>(scope, [&](DexMethod* method) {
-        auto local_stats = impl::resolve_refs(method);
+        auto local_stats =
+            impl::resolve_refs(method, method_cache, field_cache);
         local_stats += refine_virtual_callsites(method, m_desuperify);
         return local_stats;
       });
@@ -7,11 +7,16 @@
 
 #include "ResultPropagation.h"
 
+#include <unordered_set>
 #include <vector>
 
+#include "AnalysisUsage.h"
 #include "BaseIRAnalyzer.h"
+#include "ConcurrentContainers.h"
 #include "ConstantAbstractDomain.h"
 #include "ControlFlow.h"
+#include "DexUtil.h"
+#include "HierarchyAnalysis.h"
 #include "IRCode.h"
 #include "IRInstruction.h"
 #include "PassManager.h"
@@ -19,6 +24,7 @@
 #include "Resolver.h"
 #include "Trace.h"
 #include "Walkers.h"
+#include "WorkQueue.h"
 
 using namespace sparta;
 
@@ -427,6 +433,40 @@ boost::optional<ParamIndex> ReturnParamResolver::get_return_param_index(
   return return_param_index.get_constant();
 }
 
+std::vector<const DexMethod*> ReturnParamResolver::get_dependencies(
+    cfg::ControlFlowGraph& cfg) const {
+  std::vector<const DexMethod*> dependencies;
+  MethodRefCache resolved_refs;
+  for (const auto& mie : cfg::InstructionIterable(cfg)) {
+    const auto insn = mie.insn;
+    const auto opcode = insn->opcode();
+    if (!opcode::is_an_invoke(opcode)) {
+      continue;
+    }
+    // Mirrors the cases in which get_return_param_index above looks up
+    // methods_which_return_parameter.
+    const auto method = insn->get_method();
+    if (method->get_proto()->is_void() ||
+        (opcode == OPCODE_INVOKE_VIRTUAL && returns_receiver(method))) {
+      continue;
+    }
+    const auto callee =
+        resolve_method(method, opcode_to_search(insn), resolved_refs);
+    if (callee == nullptr) {
+      continue;
+    }
+    dependencies.push_back(callee);
+    if (opcode == OPCODE_INVOKE_VIRTUAL || opcode == OPCODE_INVOKE_INTERFACE) {
+      const auto overriding_methods =
+          method_override_graph::get_overriding_methods(m_graph, callee);
+      dependencies.insert(dependencies.end(), overriding_methods.begin(),
+                          overriding_methods.end());
+    }
+  }
+  sort_unique(dependencies);
+  return dependencies;
+}
+
 void ResultPropagation::patch(PassManager& mgr, IRCode* code) {
   // turn move-result-... into move instructions if the called method
   // is known to always return a particular parameter
@@ -493,11 +533,17 @@ void ResultPropagation::patch(PassManager& mgr, IRCode* code) {
   }
 }
 
+void ResultPropagationPass::set_analysis_usage(AnalysisUsage& au) const {
+  // Only move-results are rewritten.
+  au.add_preserve_specific<HierarchyAnalysisPass>();
+}
+
 void ResultPropagationPass::run_pass(DexStoresVector& stores,
                                      ConfigFiles& /* conf */,
                                      PassManager& mgr) {
   const auto scope = build_class_scope(stores);
-  const auto method_override_graph = method_override_graph::build_graph(scope);
+  const auto method_override_graph =
+      hierarchy_analysis::get_method_override_graph(mgr, scope);
   ReturnParamResolver resolver(*method_override_graph);
   const auto methods_which_return_parameter =
       find_methods_which_return_parameter(mgr, scope, resolver);
@@ -528,8 +574,6 @@ void ResultPropagationPass::run_pass(DexStoresVector& stores,
         stats.patched_move_results, stats.unverifiable_move_results);
 }
 
-using ParamIndexMap = std::unordered_map<const DexMethod*, ParamIndex>;
-
 std::unordered_map<const DexMethod*, ParamIndex>
 ResultPropagationPass::find_methods_which_return_parameter(
     PassManager& mgr, const Scope& scope, const ReturnParamResolver& resolver) {
@@ -543,61 +587,71 @@ ResultPropagationPass::find_methods_which_return_parameter(
 
   std::unordered_map<const DexMethod*, ParamIndex>
       methods_which_return_parameter;
+  // For methods that don't return a parameter (yet), the methods on whose
+  // entries their result depends. Only the dependents of newly found methods
+  // need to be inspected again.
+  ConcurrentMap<const DexMethod*, std::vector<DexMethod*>> dependents;
+  std::vector<DexMethod*> methods_to_inspect;
+  walk::code(scope, [&](DexMethod* method, IRCode&) {
+    // void methods cannot return a parameter, skip expensive analysis
+    if (!method->get_proto()->is_void()) {
+      methods_to_inspect.push_back(method);
+    }
+  });
+
   // We iterate a few times to capture chains of method calls that all
   // eventually return `this`.
   // TODO(perf): Add flag to limit number of iterations
-  // TODO(perf): For each analyzed method, keep track of the reasons (a set of
-  // methods) why the call resolution gave up, and use that "dependency"
-  // information to limit what needs to be processed in subsequent iterations
-  while (true) {
+  bool first_iteration = true;
+  while (!methods_to_inspect.empty()) {
     mgr.incr_metric(METRIC_METHODS_WHICH_RETURN_PARAMETER_ITERATIONS, 1);
-    const auto next_methods_which_return_parameter =
-        walk::parallel::methods<ParamIndexMap, MergeContainers<ParamIndexMap>>(
-            scope, [&](DexMethod* method) {
-              std::unordered_map<const DexMethod*, ParamIndex> res;
-
-              const auto code = method->get_code();
-              if (code == nullptr) {
-                return res;
-              }
-              const auto proto = method->get_proto();
-              if (proto->is_void()) {
-                // void methods cannot return a parameter, skip expensive
-                // analysis
-                return res;
-              }
-
-              const auto mwrpit = methods_which_return_parameter.find(method);
-              if (mwrpit != methods_which_return_parameter.end()) {
-                // Short-circuit re-computing for perf
-                res.insert({method, mwrpit->second});
-                return res;
-              }
-
-              // TODO(T35815704): Make the cfg const
-              cfg::ControlFlowGraph& cfg = code->cfg();
-              const auto return_param_index = resolver.get_return_param_index(
-                  cfg, methods_which_return_parameter);
-              if (return_param_index) {
-                res.insert({method, *return_param_index});
-              }
-
-              return res;
-            });
-
-    if (next_methods_which_return_parameter.size() ==
-        methods_which_return_parameter.size()) {
-
-      walk::parallel::code(scope, [](DexMethod* method, IRCode& code) {
-        const auto proto = method->get_proto();
-        if (!proto->is_void()) {
-          code.clear_cfg();
+    ConcurrentMap<const DexMethod*, ParamIndex> found;
+    workqueue_run<DexMethod*>(
+        [&](DexMethod* method) {
+          // TODO(T35815704): Make the cfg const
+          cfg::ControlFlowGraph& cfg = method->get_code()->cfg();
+          const auto return_param_index = resolver.get_return_param_index(
+              cfg, methods_which_return_parameter);
+          if (return_param_index) {
+            found.emplace(method, *return_param_index);
+          } else if (first_iteration) {
+            for (auto dependency : resolver.get_dependencies(cfg)) {
+              dependents.update(dependency,
+                                [method](const DexMethod*,
+                                         std::vector<DexMethod*>& v,
+                                         bool /* exists */) {
+                                  v.push_back(method);
+                                });
+            }
+          }
+        },
+        methods_to_inspect);
+    first_iteration = false;
+
+    methods_which_return_parameter.insert(found.begin(), found.end());
+    std::unordered_set<DexMethod*> next_methods_to_inspect;
+    for (const auto& p : found) {
+      auto it = dependents.find(p.first);
+      if (it == dependents.end()) {
+        continue;
+      }
+      for (auto dependent : it->second) {
+        if (!methods_which_return_parameter.count(dependent)) {
+          next_methods_to_inspect.insert(dependent);
         }
-      });
-      return methods_which_return_parameter;
+      }
     }
-    methods_which_return_parameter = next_methods_which_return_parameter;
+    methods_to_inspect.assign(next_methods_to_inspect.begin(),
+                              next_methods_to_inspect.end());
   }
+
+  walk::parallel::code(scope, [](DexMethod* method, IRCode& code) {
+    const auto proto = method->get_proto();
+    if (!proto->is_void()) {
+      code.clear_cfg();
+    }
+  });
+  return methods_which_return_parameter;
 }
 
 static ResultPropagationPass s_pass;
@@ -70,6 +70,14 @@ class ReturnParamResolver {
       const std::unordered_map<const DexMethod*, ParamIndex>&
           methods_which_return_parameter) const;
 
+  /*
+   * The methods whose entries in `methods_which_return_parameter` the result
+   * of the above may depend on: the resolved callees of all invocations, and
+   * their overriding methods.
+   */
+  std::vector<const DexMethod*> get_dependencies(
+      cfg::ControlFlowGraph& cfg) const;
+
  private:
   bool returns_receiver(const DexMethodRef* method) const;
   bool returns_compatible_with_receiver(const DexMethodRef* method) const;
@@ -152,14 +160,16 @@ class ResultPropagationPass : public Pass {
          "Skip propagating results from selected callees.");
   }
 
+  void set_analysis_usage(AnalysisUsage& au) const override;
+
   void run_pass(DexStoresVector&, ConfigFiles&, PassManager&) override;
 
  private:
   std::unordered_set<DexMethod*> m_callee_blocklist;
   /*
-   * Via a fixed point computation that repeatedly inspects all methods,
-   * figure out all methods which return an incoming parameter, taking into
-   * account deep call chains.
+   * Via a fixed point computation that repeatedly inspects the methods whose
+   * dependencies changed, figure out all methods which return an incoming
+   * parameter, taking into account deep call chains.
    */
   static std::unordered_map<const DexMethod*, ParamIndex>
   find_methods_which_return_parameter(PassManager& mgr,
@@ -46,7 +46,7 @@ constexpr const char* METRIC_RETAINED_CHECK_CASTS = "num_retained_check_casts";
  * we will only have one entry { A => C }
  * keep that in mind when using this map
  */
-void map_interfaces(const std::deque<DexType*>& intf_list,
+void map_interfaces(const DexTypeList::ContainerType& intf_list,
                     DexClass* cls,
                     TypeToTypes& intfs_to_classes) {
   for (auto& intf : intf_list) {
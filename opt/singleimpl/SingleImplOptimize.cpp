@@ -5,13 +5,16 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <algorithm>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <stdio.h>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "CheckCastAnalysis.h"
 #include "CheckCastTransform.h"
@@ -60,7 +63,7 @@ DexProto* get_or_make_proto(const DexType* intf,
   if (rtype == intf) rtype = impl;
   DexTypeList* new_args = nullptr;
   const auto args = proto->get_args();
-  std::deque<DexType*> new_arg_list;
+  DexTypeList::ContainerType new_arg_list;
   const auto& arg_list = args->get_type_list();
   for (const auto arg : arg_list) {
     new_arg_list.push_back(arg == intf ? impl : arg);
@@ -134,7 +137,7 @@ void remove_interface(const DexType* intf, const SingleImplData& data) {
   auto intf_cls = type_class(intf);
   collect_interfaces(intf_cls);
 
-  std::deque<DexType*> revisited_intfs;
+  DexTypeList::ContainerType revisited_intfs;
   std::copy(new_intfs.begin(), new_intfs.end(),
             std::back_inserter(revisited_intfs));
   std::sort(revisited_intfs.begin(), revisited_intfs.end(), compare_dextypes);
@@ -173,6 +176,15 @@ bool update_method_proto(const DexType* old_type_ref,
 
 using CheckCastSet = std::unordered_set<const IRInstruction*>;
 
+// A check-cast to the single implementation, of a source of an instruction
+// referencing the interface.
+struct PendingCheckCast {
+  IRList::iterator insn_it;
+  IRInstruction* insn;
+  size_t src_idx;
+  DexType* cls;
+};
+
 struct OptimizationImpl {
   OptimizationImpl(std::unique_ptr<SingleImplAnalysis> analysis,
                    const ClassHierarchy& ch)
@@ -184,7 +196,7 @@ struct OptimizationImpl {
   EscapeReason can_optimize(const DexType* intf,
                             const SingleImplData& data,
                             bool rename_on_collision);
-  CheckCastSet do_optimize(const DexType* intf, const SingleImplData& data);
+  void do_optimize(const DexType* intf, const SingleImplData& data);
   EscapeReason check_field_collision(const DexType* intf,
                                      const SingleImplData& data);
   EscapeReason check_method_collision(const DexType* intf,
@@ -194,8 +206,8 @@ struct OptimizationImpl {
                                   DexMethod* method);
   void set_field_defs(const DexType* intf, const SingleImplData& data);
   void set_field_refs(const DexType* intf, const SingleImplData& data);
-  CheckCastSet fix_instructions(const DexType* intf,
-                                const SingleImplData& data);
+  void collect_check_casts(const DexType* intf, const SingleImplData& data);
+  CheckCastSet insert_check_casts();
   void set_method_defs(const DexType* intf, const SingleImplData& data);
   void set_method_refs(const DexType* intf, const SingleImplData& data);
   void rewrite_interface_methods(const DexType* intf,
@@ -213,6 +225,10 @@ struct OptimizationImpl {
   NewMethods m_intf_meth_to_impl_meth;
   // list of optimized types
   std::unordered_set<DexType*> optimized;
+  // Check-casts to insert in each referencing method, for all optimized
+  // interfaces.
+  std::unordered_map<DexMethod*, std::vector<PendingCheckCast>>
+      m_pending_check_casts;
   const ClassHierarchy& ch;
   std::unordered_map<std::string, size_t> deobfuscated_name_counters;
 };
@@ -230,7 +246,7 @@ void OptimizationImpl::set_field_defs(const DexType* intf,
         DexField::make_field(field->get_class(), field->get_name(), data.cls));
     redex_assert(f != field);
     TRACE(INTF, 3, "(FDEF) %s", SHOW(field));
-    f->set_deobfuscated_name(field->get_deobfuscated_name());
+    f->set_deobfuscated_name(field->get_deobfuscated_name_or_null());
     f->rstate = field->rstate;
     auto field_anno = field->get_anno_set();
     if (field_anno) {
@@ -302,118 +318,125 @@ void for_all_methods(const T& methods, Fn fn, bool parallel = true) {
 //     foo(i); // Java source needs cast here.
 //   }
 //
-// This method inserts check-casts for each invoke parameter and
-// field value. Expectation is that unnecessary insertions (e.g.,
-// duplicate check-casts) will be eliminated, for example, in
+// This method collects the check-casts needed for each invoke parameter and
+// field value. They are only inserted once all interfaces have been
+// optimized, by `insert_check_casts`. Expectation is that unnecessary
+// insertions (e.g., duplicate check-casts) will be eliminated, for example, in
 // `post_process`.
-CheckCastSet OptimizationImpl::fix_instructions(const DexType* intf,
-                                                const SingleImplData& data) {
-  if (data.referencing_methods.empty()) {
-    return {};
-  }
-  std::vector<const DexMethod*> methods;
-  methods.reserve(data.referencing_methods.size());
-  std::transform(data.referencing_methods.begin(),
-                 data.referencing_methods.end(), std::back_inserter(methods),
-                 [](auto& p) { return p.first; });
-  // The typical number of methods is too small, it is actually significant
-  // overhead to spin up pool threads to just let them die.
-  constexpr bool PARALLEL = false;
-
-  std::mutex ret_lock;
-  CheckCastSet ret;
-
-  for_all_methods(
-      methods,
-      [&](const DexMethod* caller_const) {
-        auto caller = const_cast<DexMethod*>(caller_const);
-        std::vector<reg_t> temps; // Cached temps.
-        auto code = caller->get_code();
-        redex_assert(!code->editable_cfg_built());
-
-        for (const auto& insn_it_pair : data.referencing_methods.at(caller)) {
-          auto insn_it = insn_it_pair.second;
-          auto insn = insn_it_pair.first;
-
-          auto temp_it = temps.begin();
-          auto add_check_cast = [&](reg_t reg) {
-            auto check_cast = new IRInstruction(OPCODE_CHECK_CAST);
-            check_cast->set_src(0, reg);
-            check_cast->set_type(data.cls);
-            code->insert_before(insn_it, *new MethodItemEntry(check_cast));
-
-            if (PARALLEL) {
-              std::unique_lock<std::mutex> lock(ret_lock);
-              ret.insert(check_cast);
-            } else {
-              ret.insert(check_cast);
-            }
+void OptimizationImpl::collect_check_casts(const DexType* intf,
+                                           const SingleImplData& data) {
+  for (const auto& p : data.referencing_methods) {
+    auto caller = p.first;
+    for (const auto& insn_it_pair : p.second) {
+      auto insn = insn_it_pair.first;
+      auto insn_it = insn_it_pair.second;
+      auto add_check_cast = [&](size_t src_idx) {
+        m_pending_check_casts[caller].push_back(
+            {insn_it, insn, src_idx, data.cls});
+      };
+
+      if (opcode::is_an_invoke(insn->opcode())) {
+        // We need check-casts for receiver and parameters, but not
+        // return type.
+
+        auto mref = insn->get_method();
+
+        // Receiver.
+        if (mref->get_class() == intf) {
+          add_check_cast(0);
+        }
 
-            // See if we need a new temp.
-            reg_t out;
-            if (temp_it == temps.end()) {
-              reg_t new_temp = code->allocate_temp();
-              temps.push_back(new_temp);
-              temp_it = temps.end();
-              out = new_temp;
-            } else {
-              out = *temp_it;
-              temp_it++;
-            }
+        // Parameters.
+        const auto& arg_list = mref->get_proto()->get_args()->get_type_list();
+        size_t idx = insn->opcode() == OPCODE_INVOKE_STATIC ? 0 : 1;
+        for (const auto arg : arg_list) {
+          if (arg == intf) {
+            add_check_cast(idx);
+          }
+          idx++;
+        }
+        continue;
+      }
 
-            auto pseudo_move_result =
-                new IRInstruction(IOPCODE_MOVE_RESULT_PSEUDO_OBJECT);
-            pseudo_move_result->set_dest(out);
-            code->insert_before(insn_it,
-                                *new MethodItemEntry(pseudo_move_result));
+      if (opcode::is_an_iput(insn->opcode()) ||
+          opcode::is_an_sput(insn->opcode())) {
+        // If the field type is the interface, need a check-cast.
+        auto fdef = insn->get_field();
+        if (fdef->get_type() == intf) {
+          add_check_cast(0);
+        }
+        continue;
+      }
 
-            return out;
-          };
+      // Others do not need fixup.
+    }
+  }
+}
 
-          if (opcode::is_an_invoke(insn->opcode())) {
-            // We need check-casts for receiver and parameters, but not
-            // return type.
+/**
+ * Insert the check-casts collected for all optimized interfaces, visiting
+ * each referencing method once.
+ */
+CheckCastSet OptimizationImpl::insert_check_casts() {
+  std::vector<const DexMethod*> methods;
+  methods.reserve(m_pending_check_casts.size());
+  for (auto& p : m_pending_check_casts) {
+    methods.push_back(p.first);
+    // Group the check-casts of each instruction, keeping the order in which
+    // they were collected.
+    std::stable_sort(p.second.begin(), p.second.end(),
+                     [](const PendingCheckCast& a, const PendingCheckCast& b) {
+                       return a.insn < b.insn;
+                     });
+  }
 
-            auto mref = insn->get_method();
+  std::mutex ret_lock;
+  CheckCastSet ret;
 
-            // Receiver.
-            if (mref->get_class() == intf) {
-              reg_t new_receiver = add_check_cast(insn->src(0));
-              insn->set_src(0, new_receiver);
-            }
+  for_all_methods(methods, [&](const DexMethod* caller_const) {
+    auto caller = const_cast<DexMethod*>(caller_const);
+    std::vector<reg_t> temps; // Cached temps.
+    std::vector<const IRInstruction*> inserted;
+    auto code = caller->get_code();
+    redex_assert(!code->editable_cfg_built());
+
+    const auto& pending = m_pending_check_casts.at(caller);
+    auto temp_it = temps.begin();
+    for (size_t i = 0; i < pending.size(); ++i) {
+      const auto& cc = pending[i];
+      if (i == 0 || pending[i - 1].insn != cc.insn) {
+        temp_it = temps.begin();
+      }
 
-            // Parameters.
-            const auto& arg_list =
-                mref->get_proto()->get_args()->get_type_list();
-            size_t idx = insn->opcode() == OPCODE_INVOKE_STATIC ? 0 : 1;
-            for (const auto arg : arg_list) {
-              if (arg != intf) {
-                idx++;
-                continue;
-              }
-
-              reg_t new_param = add_check_cast(insn->src(idx));
-              insn->set_src(idx, new_param);
-              idx++;
-            }
-            continue;
-          }
+      auto check_cast = new IRInstruction(OPCODE_CHECK_CAST);
+      check_cast->set_src(0, cc.insn->src(cc.src_idx));
+      check_cast->set_type(cc.cls);
+      code->insert_before(cc.insn_it, *new MethodItemEntry(check_cast));
+      inserted.push_back(check_cast);
+
+      // See if we need a new temp.
+      reg_t out;
+      if (temp_it == temps.end()) {
+        reg_t new_temp = code->allocate_temp();
+        temps.push_back(new_temp);
+        temp_it = temps.end();
+        out = new_temp;
+      } else {
+        out = *temp_it;
+        temp_it++;
+      }
 
-          if (opcode::is_an_iput(insn->opcode()) ||
-              opcode::is_an_sput(insn->opcode())) {
-            // If the field type is the interface, need a check-cast.
-            auto fdef = insn->get_field();
-            if (fdef->get_type() == intf) {
-              reg_t new_param = add_check_cast(insn->src(0));
-              insn->set_src(0, new_param);
-            }
-            continue;
-          }
+      auto pseudo_move_result =
+          new IRInstruction(IOPCODE_MOVE_RESULT_PSEUDO_OBJECT);
+      pseudo_move_result->set_dest(out);
+      code->insert_before(cc.insn_it,
+                          *new MethodItemEntry(pseudo_move_result));
+      cc.insn->set_src(cc.src_idx, out);
+    }
 
-          // Others do not need fixup.
-        }
-      },
-      PARALLEL);
+    std::unique_lock<std::mutex> lock(ret_lock);
+    ret.insert(inserted.begin(), inserted.end());
+  });
 
   return ret;
 }
@@ -474,7 +497,7 @@ void OptimizationImpl::rewrite_interface_methods(const DexType* intf,
       // have these zombies lying around.
       new_meth->clear_annotations();
       new_meth->make_non_concrete();
-      auto deoob_impl_name = impl->get_deobfuscated_name();
+      auto deoob_impl_name = impl->get_deobfuscated_name_copy();
       auto unique = deobfuscated_name_counters[deoob_impl_name]++;
       auto new_deob_name = deoob_impl_name + "." +
                            meth->get_simple_deobfuscated_name() +
@@ -698,9 +721,9 @@ void OptimizationImpl::rename_possible_collisions(const DexType* intf,
 /**
  * Perform the optimization.
  */
-CheckCastSet OptimizationImpl::do_optimize(const DexType* intf,
-                                           const SingleImplData& data) {
-  CheckCastSet ret = fix_instructions(intf, data);
+void OptimizationImpl::do_optimize(const DexType* intf,
+                                   const SingleImplData& data) {
+  collect_check_casts(intf, data);
   set_type_refs(intf, data);
   set_field_defs(intf, data);
   set_field_refs(intf, data);
@@ -708,7 +731,6 @@ CheckCastSet OptimizationImpl::do_optimize(const DexType* intf,
   set_method_refs(intf, data);
   rewrite_interface_methods(intf, data);
   remove_interface(intf, data);
-  return ret;
 }
 
 /**
@@ -720,7 +742,6 @@ OptimizeStats OptimizationImpl::optimize(Scope& scope,
   single_impls->get_interfaces(to_optimize);
   std::sort(to_optimize.begin(), to_optimize.end(), compare_dextypes);
   std::unordered_set<DexMethod*> for_post_processing;
-  CheckCastSet inserted_check_casts;
   for (auto intf : to_optimize) {
     auto& intf_data = single_impls->get_single_impl_data(intf);
     if (intf_data.is_escaped()) continue;
@@ -730,8 +751,7 @@ OptimizeStats OptimizationImpl::optimize(Scope& scope,
       single_impls->escape_interface(intf, escape);
       continue;
     }
-    auto check_casts = do_optimize(intf, intf_data);
-    inserted_check_casts.insert(check_casts.begin(), check_casts.end());
+    do_optimize(intf, intf_data);
     for (auto& p : intf_data.referencing_methods) {
       for_post_processing.insert(p.first);
     }
@@ -750,6 +770,8 @@ OptimizeStats OptimizationImpl::optimize(Scope& scope,
     rewrite_annotations(scope, config);
   }
 
+  auto inserted_check_casts = insert_check_casts();
+
   post_process(for_post_processing);
   std::atomic<size_t> retained{0};
   {
@@ -177,7 +177,7 @@ BuilderStateMap Outliner::gather_builder_states(
  */
 const DexTypeList* Outliner::typelist_from_state(
     const BuilderState& state) const {
-  std::deque<DexType*> args;
+  DexTypeList::ContainerType args;
   for (auto* insn : state) {
     auto method = insn->get_method();
     args.emplace_back(method->get_proto()->get_args()->get_type_list().at(0));
@@ -187,12 +187,19 @@ const DexTypeList* Outliner::typelist_from_state(
 
 void Outliner::gather_outline_candidate_typelists(
     const BuilderStateMap& tostring_instruction_to_state) {
+  // Count locally first, so that the shared map is only updated once per
+  // distinct typelist in the method.
+  std::unordered_map<const DexTypeList*, size_t> counts;
   for (const auto& p : tostring_instruction_to_state) {
     const auto& state = p.second;
-    auto typelist = typelist_from_state(state);
+    ++counts[typelist_from_state(state)];
+  }
+  for (const auto& [typelist, count] : counts) {
     m_outline_typelists.update(
         typelist,
-        [](const DexTypeList*, size_t& n, bool /* exists */) { ++n; });
+        [count = count](const DexTypeList*, size_t& n, bool /* exists */) {
+          n += count;
+        });
   }
 }
 
@@ -233,6 +240,9 @@ void Outliner::create_outline_helpers(DexStoresVector* stores) {
   ClassCreator cc(outline_helper_cls);
   cc.set_super(type::java_lang_Object());
   bool did_create_helper{false};
+  // Select the candidates in one pass, and create their helpers in a
+  // deterministic order rather than in the hash order of the map.
+  std::vector<std::pair<const DexTypeList*, size_t>> candidates;
   for (const auto& p : m_outline_typelists) {
     const auto* typelist = p.first;
     auto count = p.second;
@@ -242,6 +252,13 @@ void Outliner::create_outline_helpers(DexStoresVector* stores) {
       // TODO: filter out length zero/one states?
       continue;
     }
+    candidates.emplace_back(typelist, count);
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [](const auto& a, const auto& b) {
+              return compare_dextypelists(a.first, b.first);
+            });
+  for (const auto& [typelist, count] : candidates) {
     TRACE(STRBUILD, 3,
           "Outlining %lu StringBuilders of length %lu with typelist %s", count,
           typelist->size(), SHOW(typelist));
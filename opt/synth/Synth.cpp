@@ -7,7 +7,10 @@
 
 #include "Synth.h"
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
+#include <numeric>
 #include <signal.h>
 #include <stdio.h>
 #include <string>
@@ -32,6 +35,7 @@
 #include "Show.h"
 #include "SynthConfig.h"
 #include "Walkers.h"
+#include "WorkQueue.h"
 
 constexpr const char* METRIC_GETTERS_REMOVED = "getter_methods_removed_count";
 constexpr const char* METRIC_WRAPPERS_REMOVED = "wrapper_methods_removed_count";
@@ -464,7 +468,7 @@ bool can_update_wrappee(const ClassHierarchy& ch,
   }
   DexProto* old_proto = wrappee->get_proto();
   auto new_args = old_proto->get_args()->get_type_list();
-  new_args.push_front(wrappee->get_class());
+  new_args.insert(new_args.begin(), wrappee->get_class());
   DexProto* new_proto = DexProto::make_proto(
       old_proto->get_rtype(), DexTypeList::make_type_list(std::move(new_args)));
   auto new_name = wrappee->get_name();
@@ -623,6 +627,10 @@ std::unique_ptr<MethodAnalysisResult> analyze_method_concurrent(
       }
     }
   }
+  if (mar->getter_calls.empty() && mar->wrapper_calls.empty() &&
+      mar->wrapped_calls.empty() && mar->ctor_calls.empty()) {
+    return nullptr;
+  }
   return mar;
 }
 
@@ -828,48 +836,72 @@ void do_transform(const ClassHierarchy& ch,
   // method once, even if we mutate the class method lists such that we'd hit
   // something a second time.
   std::vector<DexMethod*> methods;
-  std::unordered_map<DexMethod*, std::unique_ptr<MethodAnalysisResult>>
-      method_analysis_results;
-  walk::code(classes, [&](DexMethod* meth, IRCode&) {
-    methods.emplace_back(meth);
-    method_analysis_results.emplace(meth,
-                                    std::unique_ptr<MethodAnalysisResult>());
-  });
-
-  // Analyze methods in parallel (no mutation)
-  walk::parallel::code(classes, [&](DexMethod* meth, IRCode&) {
-    method_analysis_results.at(meth) = analyze_method_concurrent(meth, ssms);
-  });
+  walk::code(classes,
+             [&](DexMethod* meth, IRCode&) { methods.emplace_back(meth); });
+  std::vector<size_t> indices(methods.size());
+  std::iota(indices.begin(), indices.end(), 0);
+
+  // Analyze methods in parallel (no mutation). Only methods calling wrappers
+  // get a result.
+  std::vector<std::unique_ptr<MethodAnalysisResult>> method_analysis_results(
+      methods.size());
+  workqueue_run<size_t>(
+      [&](size_t i) {
+        method_analysis_results[i] =
+            analyze_method_concurrent(methods[i], ssms);
+      },
+      indices);
 
   // Mutate method signatures (sequentially, as they are subtle dependencies)
-  for (auto const& meth : methods) {
-    auto* mar = method_analysis_results.at(meth).get();
-    replace_wrappers_sequential(ch, meth, ssms, mar);
+  for (size_t i = 0; i < methods.size(); ++i) {
+    auto* mar = method_analysis_results[i].get();
+    if (mar != nullptr) {
+      replace_wrappers_sequential(ch, methods[i], ssms, mar);
+    }
   }
 
   // Mutate method bodies (concurrently), and check that invokes to promoted
-  // static method are correct
+  // static method are correct. Without any promoted method, only the methods
+  // calling wrappers need to be visited.
+  if (ssms.promoted_to_static.empty()) {
+    indices.erase(std::remove_if(indices.begin(), indices.end(),
+                                 [&](size_t i) {
+                                   return !method_analysis_results[i];
+                                 }),
+                  indices.end());
+  }
   std::atomic<size_t> patched_invokes{0};
-  walk::parallel::code(classes, [&](DexMethod* meth, IRCode& code) {
-    auto* mar = method_analysis_results.at(meth).get();
-    replace_wrappers_concurrent(meth, mar);
-    for (auto& mie : InstructionIterable(code)) {
-      auto* insn = mie.insn;
-      auto opcode = insn->opcode();
-      if (opcode != OPCODE_INVOKE_DIRECT) {
-        continue;
-      }
-      auto wrappee = resolve_method(insn->get_method(), MethodSearch::Direct);
-      if (wrappee == nullptr || ssms.promoted_to_static.count(wrappee) == 0) {
-        continue;
-      }
-      // change the opcode to invoke-static
-      insn->set_opcode(OPCODE_INVOKE_STATIC);
-      TRACE(SYNT, 3, "Updated invoke on promoted to static %s\n in method %s",
-            SHOW(wrappee), SHOW(meth));
-      patched_invokes++;
-    }
-  });
+  workqueue_run<size_t>(
+      [&](size_t i) {
+        auto meth = methods[i];
+        auto* mar = method_analysis_results[i].get();
+        if (mar != nullptr) {
+          replace_wrappers_concurrent(meth, mar);
+        }
+        if (ssms.promoted_to_static.empty()) {
+          return;
+        }
+        for (auto& mie : InstructionIterable(meth->get_code())) {
+          auto* insn = mie.insn;
+          auto opcode = insn->opcode();
+          if (opcode != OPCODE_INVOKE_DIRECT) {
+            continue;
+          }
+          auto wrappee =
+              resolve_method(insn->get_method(), MethodSearch::Direct);
+          if (wrappee == nullptr ||
+              ssms.promoted_to_static.count(wrappee) == 0) {
+            continue;
+          }
+          // change the opcode to invoke-static
+          insn->set_opcode(OPCODE_INVOKE_STATIC);
+          TRACE(SYNT, 3,
+                "Updated invoke on promoted to static %s\n in method %s",
+                SHOW(wrappee), SHOW(meth));
+          patched_invokes++;
+        }
+      },
+      indices);
   remove_dead_methods(ssms, synthConfig, metrics);
   metrics.methods_staticized_count += ssms.promoted_to_static.size();
   metrics.patched_invokes_count += (size_t)patched_invokes;
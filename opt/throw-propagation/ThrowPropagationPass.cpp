@@ -46,6 +46,7 @@
 #include "Show.h"
 #include "Trace.h"
 #include "Walkers.h"
+#include "WorkQueue.h"
 
 namespace {
 
@@ -55,6 +56,29 @@ constexpr const char* METRIC_UNREACHABLE_INSTRUCTIONS =
 constexpr const char* METRIC_NO_RETURN_METHODS = "num_no_return_methods";
 constexpr const char* METRIC_ITERATIONS = "num_iterations";
 
+bool is_no_return_method(const ThrowPropagationPass::Config& config,
+                         DexMethod* method) {
+  if (is_abstract(method) || method->is_external() || is_native(method) ||
+      method->rstate.no_optimizations()) {
+    return false;
+  }
+  if (config.blocklist.count(method->get_class())) {
+    TRACE(TP, 4, "black-listed method: %s", SHOW(method));
+    return false;
+  }
+  bool can_return{false};
+  editable_cfg_adapter::iterate_with_iterator(
+      method->get_code(), [&can_return](const IRList::iterator& it) {
+        if (opcode::is_a_return(it->insn->opcode())) {
+          can_return = true;
+          return editable_cfg_adapter::LOOP_BREAK;
+        } else {
+          return editable_cfg_adapter::LOOP_CONTINUE;
+        }
+      });
+  return !can_return;
+}
+
 } // namespace
 
 void ThrowPropagationPass::bind_config() {
@@ -70,25 +94,7 @@ std::unordered_set<DexMethod*> ThrowPropagationPass::get_no_return_methods(
     const Config& config, const Scope& scope) {
   ConcurrentSet<DexMethod*> concurrent_no_return_methods;
   walk::parallel::methods(scope, [&](DexMethod* method) {
-    if (is_abstract(method) || method->is_external() || is_native(method) ||
-        method->rstate.no_optimizations()) {
-      return;
-    }
-    if (config.blocklist.count(method->get_class())) {
-      TRACE(TP, 4, "black-listed method: %s", SHOW(method));
-      return;
-    }
-    bool can_return{false};
-    editable_cfg_adapter::iterate_with_iterator(
-        method->get_code(), [&can_return](const IRList::iterator& it) {
-          if (opcode::is_a_return(it->insn->opcode())) {
-            can_return = true;
-            return editable_cfg_adapter::LOOP_BREAK;
-          } else {
-            return editable_cfg_adapter::LOOP_CONTINUE;
-          }
-        });
-    if (!can_return) {
+    if (is_no_return_method(config, method)) {
       concurrent_no_return_methods.insert(method);
     }
   });
@@ -317,10 +323,10 @@ void ThrowPropagationPass::run_pass(DexStoresVector& stores,
   size_t last_no_return_methods{0};
   int iterations = 0;
   Stats stats;
+  std::unordered_set<DexMethod*> no_return_methods =
+      get_no_return_methods(m_config, scope);
   while (true) {
     iterations++;
-    std::unordered_set<DexMethod*> no_return_methods =
-        get_no_return_methods(m_config, scope);
     TRACE(TP,
           2,
           "iteration %d, no_return_methods: %zu",
@@ -330,6 +336,7 @@ void ThrowPropagationPass::run_pass(DexStoresVector& stores,
       break;
     }
     last_no_return_methods = no_return_methods.size();
+    ConcurrentSet<DexMethod*> changed_methods;
     auto last_stats =
         walk::parallel::methods<Stats>(scope, [&](DexMethod* method) -> Stats {
           auto code = method->get_code();
@@ -337,12 +344,32 @@ void ThrowPropagationPass::run_pass(DexStoresVector& stores,
             return {};
           }
 
-          return run(m_config, no_return_methods, *override_graph, code);
+          auto method_stats =
+              run(m_config, no_return_methods, *override_graph, code);
+          if (method_stats.throws_inserted > 0) {
+            changed_methods.insert(method);
+          }
+          return method_stats;
         });
     if (last_stats.throws_inserted == 0) {
       break;
     }
     stats += last_stats;
+
+    // Only the methods into which we inserted throws may have lost their last
+    // return, so there is no need to look at all others again.
+    std::vector<DexMethod*> methods_to_check(changed_methods.begin(),
+                                             changed_methods.end());
+    ConcurrentSet<DexMethod*> new_no_return_methods;
+    workqueue_run<DexMethod*>(
+        [&](DexMethod* method) {
+          if (is_no_return_method(m_config, method)) {
+            new_no_return_methods.insert(method);
+          }
+        },
+        methods_to_check);
+    no_return_methods.insert(new_no_return_methods.begin(),
+                             new_no_return_methods.end());
   }
 
   walk::parallel::code(scope, [&](const DexMethod* method, IRCode& code) {
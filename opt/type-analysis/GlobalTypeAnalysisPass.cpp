@@ -10,6 +10,7 @@
 #include "ConfigFiles.h"
 #include "DexUtil.h"
 #include "GlobalTypeAnalyzer.h"
+#include "HierarchyAnalysis.h"
 #include "KotlinNullCheckMethods.h"
 #include "Show.h"
 #include "Trace.h"
@@ -128,7 +129,9 @@ void GlobalTypeAnalysisPass::run_pass(DexStoresVector& stores,
       kotlin_nullcheck_wrapper::get_kotlin_null_assertions();
   Scope scope = build_class_scope(stores);
   global::GlobalTypeAnalysis analysis(m_config.max_global_analysis_iteration);
-  auto gta = analysis.analyze(scope);
+  auto method_override_graph =
+      hierarchy_analysis::get_method_override_graph(mgr, scope);
+  auto gta = analysis.analyze(scope, *method_override_graph);
   optimize(scope, *gta, null_assertion_set, mgr);
   m_result = std::move(gta);
 }
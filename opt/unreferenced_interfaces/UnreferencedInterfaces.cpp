@@ -236,7 +236,7 @@ void set_new_impl_list(const TypeSet& removable, DexClass* cls) {
     }
     get_impls(intf, removable, new_intfs);
   }
-  std::deque<DexType*> deque;
+  DexTypeList::ContainerType deque;
   for (const auto& intf : new_intfs) {
     deque.emplace_back(intf);
   }
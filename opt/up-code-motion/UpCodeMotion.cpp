@@ -30,6 +30,7 @@
 
 #include <vector>
 
+#include "CFGLocalOptimizations.h"
 #include "ControlFlow.h"
 #include "DexClass.h"
 #include "DexUtil.h"
@@ -38,6 +39,7 @@
 #include "IROpcode.h"
 #include "PassManager.h"
 #include "RedexContext.h"
+#include "ScopedCFG.h"
 #include "Show.h"
 #include "SourceBlocks.h"
 #include "Trace.h"
@@ -234,10 +236,19 @@ UpCodeMotionPass::Stats UpCodeMotionPass::process_code(
     DexTypeList* args,
     IRCode* code,
     bool is_branch_hot_check) {
+  cfg::ScopedCFG cfg(code);
+  return process_cfg(is_static, declaring_type, args, *cfg,
+                     is_branch_hot_check);
+}
+
+UpCodeMotionPass::Stats UpCodeMotionPass::process_cfg(
+    bool is_static,
+    DexType* declaring_type,
+    DexTypeList* args,
+    cfg::ControlFlowGraph& cfg,
+    bool is_branch_hot_check) {
   Stats stats;
 
-  code->build_cfg(/* editable = true*/);
-  auto& cfg = code->cfg();
   std::unique_ptr<type_inference::TypeInference> type_inference;
   std::unordered_set<cfg::Block*> blocks_to_remove_set;
   std::vector<cfg::Block*> blocks_to_remove;
@@ -365,8 +376,6 @@ UpCodeMotionPass::Stats UpCodeMotionPass::process_code(
   }
 
   cfg.remove_blocks(blocks_to_remove);
-
-  code->clear_cfg();
   return stats;
 }
 
@@ -413,3 +422,27 @@ void UpCodeMotionPass::run_pass(DexStoresVector& stores,
 }
 
 static UpCodeMotionPass s_pass;
+
+static cfg_local_opts::StageRegistration s_stage(
+    "UpCodeMotionPass",
+    {[](const Json::Value& options) -> cfg_local_opts::MethodTransform {
+       bool check_branch_hotness =
+           options.get("check_branch_hotness", false).asBool();
+       return [check_branch_hotness](DexMethod* method,
+                                     cfg::ControlFlowGraph& cfg,
+                                     cfg_local_opts::Metrics& metrics) {
+         auto stats = UpCodeMotionPass::process_cfg(
+             is_static(method), method->get_class(),
+             method->get_proto()->get_args(), cfg, check_branch_hotness);
+         metrics.values[METRIC_INSTRUCTIONS_MOVED] += stats.instructions_moved;
+         metrics.values[METRIC_BRANCHES_MOVED_OVER] +=
+             stats.branches_moved_over;
+         metrics.values[METRIC_INVERTED_CONDITIONAL_BRANCHES] +=
+             stats.inverted_conditional_branches;
+         metrics.values[METRIC_SKIPPED_BRANCHES] += stats.skipped_branches;
+         metrics.values[METRIC_CLOBBERED_REGISTERS] +=
+             stats.clobbered_registers;
+       };
+     },
+     /* requires_type_environments */ false,
+     /* cacheable */ true});
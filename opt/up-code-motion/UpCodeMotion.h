@@ -33,6 +33,8 @@ class UpCodeMotionPass : public Pass {
   UpCodeMotionPass() : Pass("UpCodeMotionPass") {}
 
   void run_pass(DexStoresVector&, ConfigFiles&, PassManager&) override;
+
+  bool keeps_editable_cfg() const override { return true; }
   void bind_config() override {
     bind("check_branch_hotness",
          false,
@@ -45,6 +47,11 @@ class UpCodeMotionPass : public Pass {
                             DexTypeList* args,
                             IRCode*,
                             bool is_branch_hot_check);
+  static Stats process_cfg(bool is_static,
+                           DexType* declaring_type,
+                           DexTypeList* args,
+                           cfg::ControlFlowGraph&,
+                           bool is_branch_hot_check);
 
  private:
   bool m_check_if_branch_is_hot;
@@ -556,7 +556,7 @@ void update_implements(DexClass* from_cls, DexClass* to_cls) {
   for (const auto& cls_intf : from_cls->get_interfaces()->get_type_list()) {
     new_intfs.emplace(cls_intf);
   }
-  std::deque<DexType*> deque;
+  DexTypeList::ContainerType deque;
 
   TRACE(VMERGE, 5, "interface after : ");
   for (const auto& intf : new_intfs) {
@@ -83,9 +83,9 @@ void publicize_methods(const method_override_graph::Graph* graph,
 /**
  * Deduplicate identical overriding code.
  */
-uint32_t remove_duplicated_vmethods(const Scope& scope) {
+uint32_t remove_duplicated_vmethods(
+    const Scope& scope, const method_override_graph::Graph& graph) {
   uint32_t ret = 0;
-  auto graph = method_override_graph::build_graph(scope);
 
   walk::classes(scope, [&](DexClass* cls) {
     for (auto method : cls->get_vmethods()) {
@@ -103,10 +103,10 @@ uint32_t remove_duplicated_vmethods(const Scope& scope) {
         continue;
       }
       std::vector<DexMethod*> duplicates;
-      find_duplications(graph.get(), method, &duplicates);
+      find_duplications(&graph, method, &duplicates);
       if (!duplicates.empty()) {
         if (is_protected(method)) {
-          publicize_methods(graph.get(), method);
+          publicize_methods(&graph, method);
         }
         TRACE(VM, 8, "Same as %s", SHOW(method));
         for (auto m : duplicates) {
@@ -124,9 +124,10 @@ uint32_t remove_duplicated_vmethods(const Scope& scope) {
 
 namespace dedup_vmethods {
 
-uint32_t dedup(const DexStoresVector& stores) {
+uint32_t dedup(const DexStoresVector& stores,
+               const method_override_graph::Graph& graph) {
   auto scope = build_class_scope(stores);
-  auto deduplicated_vmethods = remove_duplicated_vmethods(scope);
+  auto deduplicated_vmethods = remove_duplicated_vmethods(scope, graph);
   TRACE(VM, 2, "deduplicated_vmethods %d\n", deduplicated_vmethods);
   return deduplicated_vmethods;
 }
@@ -13,6 +13,10 @@
 class DexStore;
 using DexStoresVector = std::vector<DexStore>;
 
+namespace method_override_graph {
+class Graph;
+} // namespace method_override_graph
+
 /**
  * Remove small identical virtual methods.
  * 1. Consider non-root and renamable methods without invoke-super. Remove the
@@ -27,5 +31,6 @@ using DexStoresVector = std::vector<DexStore>;
  * }
  */
 namespace dedup_vmethods {
-uint32_t dedup(const DexStoresVector& stores);
+uint32_t dedup(const DexStoresVector& stores,
+               const method_override_graph::Graph& graph);
 } // namespace dedup_vmethods
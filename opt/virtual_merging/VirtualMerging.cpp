@@ -42,11 +42,15 @@
 
 #include "VirtualMerging.h"
 
+#include <atomic>
+#include <mutex>
+
 #include "ABExperimentContext.h"
 #include "ConfigFiles.h"
 #include "ControlFlow.h"
 #include "CppUtil.h"
 #include "DedupVirtualMethods.h"
+#include "HierarchyAnalysis.h"
 #include "IRCode.h"
 #include "IRInstruction.h"
 #include "Inliner.h"
@@ -56,6 +60,7 @@
 #include "StlUtil.h"
 #include "TypeSystem.h"
 #include "Walkers.h"
+#include "WorkQueue.h"
 
 namespace {
 
@@ -759,6 +764,37 @@ void check_remap(
   }
 }
 
+// Merging into an overridden method reads the code of its overriding methods,
+// which may themselves be overridden methods that other methods get merged
+// into first. Returns, for each element of the ordering, the number of
+// elements it has to wait for, and the elements that wait for it.
+std::pair<std::vector<size_t>, std::vector<std::vector<size_t>>>
+get_ordering_dependencies(const std::vector<MethodData>& ordering) {
+  std::unordered_map<const DexMethod*, size_t> idx_of_overridden_method;
+  for (size_t i = 0; i < ordering.size(); i++) {
+    idx_of_overridden_method.emplace(ordering[i].first, i);
+  }
+  std::vector<size_t> num_dependencies(ordering.size());
+  std::vector<std::vector<size_t>> dependents(ordering.size());
+  for (size_t i = 0; i < ordering.size(); i++) {
+    for (const auto& q : ordering[i].second) {
+      for (auto* overriding_method : q.second) {
+        auto it = idx_of_overridden_method.find(overriding_method);
+        if (it != idx_of_overridden_method.end()) {
+          // The ordering puts deeper overridden methods first.
+          always_assert(it->second < i);
+          num_dependencies[i]++;
+          dependents[it->second].push_back(i);
+        }
+      }
+    }
+  }
+  return std::make_pair(std::move(num_dependencies), std::move(dependents));
+}
+
+// Merges the overriding methods of each element of the ordering into its
+// overridden method. Unless `parallel` is false, this is done for independent
+// elements in parallel.
 template <typename MethodFn>
 VirtualMergingStats apply_ordering(
     MultiMethodInliner& inliner,
@@ -766,9 +802,16 @@ VirtualMergingStats apply_ordering(
     const MethodFn& method_fn,
     std::unordered_map<DexClass*, std::vector<const DexMethod*>>&
         virtual_methods_to_remove,
-    std::unordered_map<DexMethod*, DexMethod*>& virtual_methods_to_remap) {
-  VirtualMergingStats stats;
-  for (auto& p : ordering) {
+    std::unordered_map<DexMethod*, DexMethod*>& virtual_methods_to_remap,
+    bool parallel) {
+  // Results per element, combined in order at the end for determinism.
+  std::vector<VirtualMergingStats> ordering_stats(ordering.size());
+  std::vector<std::vector<std::pair<DexMethod*, DexMethod*>>> merged_methods(
+      ordering.size());
+  std::mutex change_visibility_mutex;
+  auto merge = [&](size_t idx) {
+    auto& p = ordering[idx];
+    auto& stats = ordering_stats[idx];
     auto overridden_method = const_cast<DexMethod*>(p.first);
     for (auto& q : p.second) {
       if (q.second.empty()) {
@@ -978,7 +1021,11 @@ VirtualMergingStats apply_ordering(
             overridden_method, overriding_method, invoke_virtual_insn,
             /* needs_receiver_cast */ nullptr,
             overridden_method->get_code()->cfg().get_registers_size());
-        change_visibility(overriding_method, overridden_method->get_class());
+        {
+          // This may change the visibility of other members.
+          std::lock_guard<std::mutex> lock(change_visibility_mutex);
+          change_visibility(overriding_method, overridden_method->get_class());
+        }
         overriding_method->get_code()->clear_cfg();
 
         // Check if everything was inlined.
@@ -989,16 +1036,53 @@ VirtualMergingStats apply_ordering(
 
         overridden_code->clear_cfg();
 
-        virtual_methods_to_remove[type_class(overriding_method->get_class())]
-            .push_back(overriding_method);
         auto virtual_scope_root = virtual_scope->methods.front();
         always_assert(overriding_method != virtual_scope_root.first);
-        virtual_methods_to_remap.emplace(overriding_method,
+        merged_methods[idx].emplace_back(overriding_method,
                                          virtual_scope_root.first);
 
         stats.removed_virtual_methods++;
       }
     }
+  };
+
+  if (parallel) {
+    auto dependencies = get_ordering_dependencies(ordering);
+    const auto& dependents = dependencies.second;
+    std::vector<std::atomic<size_t>> remaining(ordering.size());
+    std::vector<size_t> ready;
+    for (size_t i = 0; i < ordering.size(); i++) {
+      remaining[i] = dependencies.first[i];
+      if (remaining[i] == 0) {
+        ready.push_back(i);
+      }
+    }
+    workqueue_run<size_t>(
+        [&](sparta::SpartaWorkerState<size_t>* worker_state, size_t idx) {
+          merge(idx);
+          for (size_t dependent : dependents[idx]) {
+            if (--remaining[dependent] == 0) {
+              worker_state->push_task(dependent);
+            }
+          }
+        },
+        ready,
+        redex_parallel::default_num_threads(),
+        /*push_tasks_while_running=*/true);
+  } else {
+    for (size_t i = 0; i < ordering.size(); i++) {
+      merge(i);
+    }
+  }
+
+  VirtualMergingStats stats;
+  for (size_t i = 0; i < ordering.size(); i++) {
+    stats += ordering_stats[i];
+    for (const auto& q : merged_methods[i]) {
+      virtual_methods_to_remove[type_class(q.first->get_class())].push_back(
+          q.first);
+      virtual_methods_to_remap.emplace(q.first, q.second);
+    }
   }
   return stats;
 }
@@ -1030,14 +1114,17 @@ void VirtualMerging::merge_methods(
       clones.emplace(m, DexMethod::make_full_method_from(
                             m, m->get_class(),
                             DexString::make_string(
-                                m->str() + "$VirtualMergingTemporaryClone")));
+                                m->str_copy() +
+                                "$VirtualMergingTemporaryClone")));
     }
     return m;
   };
 
-  auto stats =
-      apply_ordering(*m_inliner, ordering_pair.first, make_clone,
-                     m_virtual_methods_to_remove, m_virtual_methods_to_remap);
+  // Cloning for experiments is not thread-safe.
+  auto stats = apply_ordering(*m_inliner, ordering_pair.first, make_clone,
+                              m_virtual_methods_to_remove,
+                              m_virtual_methods_to_remap,
+                              /* parallel */ !is_experiment);
   m_stats += stats;
 
   always_assert(m_stats.mergeable_pairs ==
@@ -1090,7 +1177,8 @@ void VirtualMerging::merge_methods(
                             SHOW(m));
           return m;
         },
-        exp_virtual_methods_to_remove, exp_virtual_methods_to_remap);
+        exp_virtual_methods_to_remove, exp_virtual_methods_to_remap,
+        /* parallel */ false);
     redex_assert(stats == exp_stats);
 
     check_remove(m_virtual_methods_to_remove, exp_virtual_methods_to_remove,
@@ -1218,7 +1306,9 @@ void VirtualMergingPass::run_pass(DexStoresVector& stores,
     return;
   }
 
-  auto dedupped = dedup_vmethods::dedup(stores);
+  auto override_graph = hierarchy_analysis::get_method_override_graph(
+      mgr, build_class_scope(stores));
+  auto dedupped = dedup_vmethods::dedup(stores, *override_graph);
 
   auto inliner_config = conf.get_inliner_config();
   // We don't need to worry about inlining synchronized code, as we always
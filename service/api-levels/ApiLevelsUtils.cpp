@@ -396,7 +396,7 @@ void ApiLevelsUtils::load_framework_api(const Scope& scope) {
     const auto& framework_cls_str = framework_cls->str();
     if (!boost::starts_with(framework_cls_str, "Landroid")) {
       TRACE(API_UTILS, 5, "Excluding %s from possible replacement.",
-            framework_cls_str.c_str());
+            framework_cls->c_str());
       it = framework_cls_to_api.erase(it);
     } else {
       ++it;
@@ -59,23 +59,48 @@ std::unique_ptr<RefChecker> ref_checker_for_root_store(XStoreRefs* xstores,
 
 namespace class_merging {
 
+const TypeSystem& ScopeAnalyses::type_system() {
+  if (!m_type_system) {
+    m_type_system = std::make_unique<TypeSystem>(m_scope);
+  }
+  return *m_type_system;
+}
+
+XStoreRefs* ScopeAnalyses::xstores() {
+  if (!m_xstores) {
+    m_xstores = std::make_unique<XStoreRefs>(m_stores);
+  }
+  return m_xstores.get();
+}
+
+void ScopeAnalyses::invalidate() {
+  m_type_system.reset();
+  m_xstores.reset();
+}
+
 void merge_model(Scope& scope,
                  ConfigFiles& conf,
                  PassManager& mgr,
                  DexStoresVector& stores,
-                 ModelSpec& spec) {
+                 ModelSpec& spec,
+                 ScopeAnalyses& analyses) {
   set_up(conf);
   always_assert(s_is_initialized);
+  auto scope_size = scope.size();
   handle_interface_as_root(spec, scope, stores);
+  if (scope.size() != scope_size) {
+    // New base classes were added for interface roots.
+    analyses.invalidate();
+  }
   TRACE(CLMG, 2, "[ClassMerging] merging %s model", spec.name.c_str());
   Timer t("erase_model");
   for (const auto root : spec.roots) {
     always_assert(!is_interface(type_class(root)));
   }
-  TypeSystem type_system(scope);
+  const auto& type_system = analyses.type_system();
   int32_t min_sdk = mgr.get_redex_options().min_sdk;
-  XStoreRefs xstores(stores);
-  auto refchecker = ref_checker_for_root_store(&xstores, conf, min_sdk);
+  auto refchecker =
+      ref_checker_for_root_store(analyses.xstores(), conf, min_sdk);
   if (spec.merging_targets.empty()) {
     // TODO: change to unordered set.
     TypeSet merging_targets_set;
@@ -89,10 +114,23 @@ void merge_model(Scope& scope,
   model.update_redex_stats(mgr);
 
   ModelMerger mm;
+  scope_size = scope.size();
   auto merger_classes = mm.merge_model(scope, stores, conf, model);
+  if (!merger_classes.empty() || scope.size() != scope_size) {
+    analyses.invalidate();
+  }
   auto num_dedupped = method_dedup::dedup_constructors(merger_classes, scope);
   mm.increase_ctor_dedupped_stats(num_dedupped);
   mm.update_redex_stats(spec.class_name_prefix, mgr);
 }
 
+void merge_model(Scope& scope,
+                 ConfigFiles& conf,
+                 PassManager& mgr,
+                 DexStoresVector& stores,
+                 ModelSpec& spec) {
+  ScopeAnalyses analyses(scope, stores);
+  merge_model(scope, conf, mgr, stores, spec, analyses);
+}
+
 } // namespace class_merging
@@ -7,10 +7,44 @@
 
 #pragma once
 
+#include <memory>
+
+#include "DexStore.h"
 #include "Model.h"
+#include "TypeSystem.h"
 
 namespace class_merging {
 
+/*
+ * The type system and cross-store references of the scope, which every model
+ * needs and which dominate the cost of merging a small model. A pass merging
+ * several models shares them across its models, and merge_model() only has
+ * them rebuilt after a model actually changed the scope.
+ */
+class ScopeAnalyses {
+ public:
+  ScopeAnalyses(const Scope& scope, const DexStoresVector& stores)
+      : m_scope(scope), m_stores(stores) {}
+
+  const TypeSystem& type_system();
+  XStoreRefs* xstores();
+
+  void invalidate();
+
+ private:
+  const Scope& m_scope;
+  const DexStoresVector& m_stores;
+  std::unique_ptr<TypeSystem> m_type_system;
+  std::unique_ptr<XStoreRefs> m_xstores;
+};
+
+void merge_model(Scope& scope,
+                 ConfigFiles& conf,
+                 PassManager& mgr,
+                 DexStoresVector& stores,
+                 ModelSpec& spec,
+                 ScopeAnalyses& analyses);
+
 void merge_model(Scope& scope,
                  ConfigFiles& conf,
                  PassManager& mgr,
@@ -855,7 +855,9 @@ void Model::collect_methods() {
           TRACE(CLMG,
                 8,
                 "non virtual scope %s (%s)",
-                virt_scope->methods[0].first->get_deobfuscated_name().c_str(),
+                virt_scope->methods[0]
+                    .first->get_deobfuscated_name_copy()
+                    .c_str(),
                 SHOW(virt_scope->methods[0].first->get_name()));
           merger.non_virt_methods.emplace_back(virt_scope->methods[0].first);
           continue;
@@ -922,7 +924,7 @@ void Model::add_interface_scope(MergerType& merger,
       TRACE(CLMG,
             8,
             "add interface method %s (%s)",
-            vmeth.first->get_deobfuscated_name().c_str(),
+            vmeth.first->get_deobfuscated_name_copy().c_str(),
             SHOW(vmeth.first->get_name()));
       intf_meths.methods.emplace_back(vmeth.first);
     }
@@ -971,7 +973,7 @@ void Model::distribute_virtual_methods(
             "walking virtual scope [%s, %ld] %s (%s)",
             SHOW(virt_scope->type),
             virt_scope->methods.size(),
-            virt_scope->methods[0].first->get_deobfuscated_name().c_str(),
+            virt_scope->methods[0].first->get_deobfuscated_name_copy().c_str(),
             SHOW(virt_scope->methods[0].first->get_name()));
       bool is_interface = !virt_scope->interfaces.empty();
       std::vector<DexMethod*>* insert_list = nullptr;
@@ -990,7 +992,7 @@ void Model::distribute_virtual_methods(
         TRACE(CLMG,
               9,
               "method %s (%s)",
-              vmeth.first->get_deobfuscated_name().c_str(),
+              vmeth.first->get_deobfuscated_name_copy().c_str(),
               SHOW(vmeth.first->get_name()));
         if (is_interface) {
           if (insert_list == nullptr) {
@@ -998,7 +1000,7 @@ void Model::distribute_virtual_methods(
             TRACE(CLMG,
                   8,
                   "add interface method %s (%s) w/ overridden_meth %s",
-                  vmeth.first->get_deobfuscated_name().c_str(),
+                  vmeth.first->get_deobfuscated_name_copy().c_str(),
                   SHOW(vmeth.first->get_name()),
                   SHOW(overridden_meth));
             merger->second.intfs_methods.push_back(
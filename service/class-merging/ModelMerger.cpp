@@ -405,7 +405,7 @@ std::string merger_info(const MergerType& merger) {
 
 void set_interfaces(DexClass* cls, const TypeSet& intfs) {
   if (!intfs.empty()) {
-    auto intf_list = std::deque<DexType*>();
+    auto intf_list = DexTypeList::ContainerType();
     for (const auto& intf : intfs) {
       intf_list.emplace_back(const_cast<DexType*>(intf));
     }
@@ -582,7 +582,8 @@ std::vector<DexClass*> ModelMerger::merge_model(Scope& scope,
     auto type = const_cast<DexType*>(merger->type);
     for (auto mergeable : merger->mergeables) {
       loosen_access_modifier_except_vmethods(type_class(mergeable));
-      merged_type_names[mergeable->get_name()->str()] = type->get_name()->str();
+      merged_type_names[mergeable->get_name()->str_copy()] =
+          type->get_name()->str_copy();
       mergeable_to_merger[mergeable] = type;
     }
   }
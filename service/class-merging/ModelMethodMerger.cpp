@@ -23,6 +23,7 @@
 #include "SwitchDispatch.h"
 #include "TypeReference.h"
 #include "Walkers.h"
+#include "WorkQueue.h"
 
 using namespace class_merging;
 
@@ -359,6 +360,38 @@ std::vector<IRInstruction*> ModelMethodMerger::make_check_cast(DexType* type,
   return {check_cast, move_result_pseudo};
 }
 
+/**
+ * Dispatches are generated in phases. The targets of all the dispatches of a
+ * model are first made static, serially. Finding the identical targets of each
+ * dispatch only reads their code, so it then runs in parallel over all the
+ * dispatches. Creating the dispatch methods and updating the classes is
+ * done last, serially and in the original order, which keeps the output
+ * deterministic.
+ */
+struct ModelMethodMerger::DispatchGroup {
+  // Only set for ctor dispatches.
+  const MergerType* merger;
+  dispatch::Spec spec;
+  std::vector<DexMethod*> targets;
+  // Signatures of the targets, by owner type, for the method dedup map.
+  std::unordered_map<const DexType*, std::string> signatures;
+  std::map<SwitchIndices, DexMethod*> indices_to_callee;
+};
+
+void ModelMethodMerger::compute_dedupped_indices(
+    std::vector<DispatchGroup>& groups) {
+  std::vector<DispatchGroup*> group_ptrs;
+  group_ptrs.reserve(groups.size());
+  for (auto& group : groups) {
+    group_ptrs.push_back(&group);
+  }
+  workqueue_run<DispatchGroup*>(
+      [this](DispatchGroup* group) {
+        group->indices_to_callee = get_dedupped_indices_map(group->targets);
+      },
+      group_ptrs);
+}
+
 dispatch::DispatchMethod ModelMethodMerger::create_dispatch_method(
     const dispatch::Spec& spec, const std::vector<DexMethod*>& targets) {
   always_assert(targets.size());
@@ -575,9 +608,7 @@ void ModelMethodMerger::merge_virtual_methods(
     DexType* target_type,
     DexField* type_tag_field,
     const std::vector<MergerType::VirtualMethod>& virt_methods,
-    std::vector<std::pair<DexClass*, DexMethod*>>& dispatch_methods,
-    std::unordered_map<DexMethod*, DexMethod*>& old_to_new_callee) {
-  DexClass* target_cls = type_class(target_type);
+    std::vector<DispatchGroup>& groups) {
   for (auto& virt_meth : virt_methods) {
     auto& meth_lst = virt_meth.second;
     always_assert(meth_lst.size());
@@ -589,17 +620,15 @@ void ModelMethodMerger::merge_virtual_methods(
                              front_meth->get_proto()->get_args());
 
     // Make static
-    MethodTypeTags type_tags;
     std::unordered_map<const DexType*, std::string> meth_signatures;
     for (auto m : meth_lst) {
       meth_signatures[m->get_class()] = get_method_signature_string(m);
       mutators::make_static(m, mutators::KeepThis::Yes);
       replace_method_args_head(m, target_type);
-      type_tags[m] = m_type_tags->get_type_tag(m->get_class());
     }
-    auto name = front_meth->get_name()->str();
+    auto name = front_meth->get_name()->str_copy();
 
-    // Create dispatch.
+    // The dispatch is created once the targets of all groups are dedupped.
     dispatch::Spec spec{target_type,
                         dispatch::Type::VIRTUAL,
                         name,
@@ -610,29 +639,8 @@ void ModelMethodMerger::merge_virtual_methods(
                         m_max_num_dispatch_target,
                         boost::none,
                         m_model_spec.keep_debug_info};
-    dispatch::DispatchMethod dispatch = create_dispatch_method(spec, meth_lst);
-    dispatch_methods.emplace_back(target_cls, dispatch.main_dispatch);
-    for (const auto sub_dispatch : dispatch.sub_dispatches) {
-      dispatch_methods.emplace_back(target_cls, sub_dispatch);
-    }
-    for (const auto& m : meth_lst) {
-      old_to_new_callee[m] = dispatch.main_dispatch;
-    }
-    for (const auto& m : meth_lst) {
-      relocate_method(m, target_type);
-    }
-    // Populating method dedup map
-    for (auto& type_to_sig : meth_signatures) {
-      auto type = type_to_sig.first;
-      auto map = std::make_pair(type_to_sig.second, dispatch.main_dispatch);
-      m_method_dedup_map[type].push_back(map);
-      TRACE(CLMG,
-            9,
-            " adding dedup map type %s %s -> %s",
-            SHOW(type),
-            type_to_sig.second.c_str(),
-            SHOW(dispatch.main_dispatch));
-    }
+    groups.push_back(
+        DispatchGroup{nullptr, spec, meth_lst, std::move(meth_signatures), {}});
   }
 }
 
@@ -659,11 +667,10 @@ void ModelMethodMerger::merge_ctors() {
   //////////////////////////////////////////
   // Create dispatch and fixes
   //////////////////////////////////////////
-  std::unordered_map<DexMethod*, DexMethod*> old_to_new_callee;
+  std::vector<DispatchGroup> groups;
   for (const auto& pair : m_merger_ctors) {
     auto merger = pair.first;
     auto target_type = const_cast<DexType*>(merger->type);
-    auto target_cls = type_class(target_type);
     auto type_tag_field = m_type_tag_fields.count(merger) > 0
                               ? m_type_tag_fields.at(merger)
                               : nullptr;
@@ -678,7 +685,6 @@ void ModelMethodMerger::merge_ctors() {
           " Merging ctors for %s with %zu different protos",
           SHOW(target_type),
           proto_to_ctors.size());
-    std::unordered_set<DexMethod*> dispatches;
     for (const auto& ctors_pair : proto_to_ctors) {
       auto& ctors = ctors_pair.second;
       auto ctor_proto = ctors_pair.first;
@@ -691,7 +697,6 @@ void ModelMethodMerger::merge_ctors() {
         TRACE(CLMG, 9, "  converting ctor %s", SHOW(ctor));
       }
 
-      // Create dispatch.
       auto dispatch_arg_list =
           type_reference::append_and_make(ctor_proto->get_args(), type::_int());
       auto dispatch_proto =
@@ -710,54 +715,73 @@ void ModelMethodMerger::merge_ctors() {
           nullptr, // overridden_meth
           get_ctor_type_tag_param_idx(pass_type_tag_param, ctor_proto),
           m_model_spec.keep_debug_info};
-      auto indices_to_callee = get_dedupped_indices_map(ctors);
-      if (indices_to_callee.size() > 1) {
-        always_assert_log(
-            m_model_spec.has_type_tag(),
-            "No type tag config cannot handle multiple dispatch targets!");
-      }
-      m_stats.m_num_ctor_dedupped += ctors.size() - indices_to_callee.size();
-      auto dispatch =
-          dispatch::create_ctor_or_static_dispatch(spec, indices_to_callee);
-      for (const auto& m : ctors) {
-        old_to_new_callee[m] = dispatch;
-      }
-      type_class(target_type)->add_method(dispatch);
-      // Inline entries
-      inline_dispatch_entries(dispatch);
-      sink_common_ctor_to_return_block(dispatch);
-      auto mergeable_cls = type_class(ctors.front()->get_class());
-      always_assert(mergeable_cls->get_super_class() ==
-                    target_cls->get_super_class());
-
-      // Remove mergeable ctors
-      // The original mergeable ctors have been converted to static and won't
-      // pass VFY.
-      for (const auto ctor : ctors) {
-        auto cls = type_class(ctor->get_class());
-        cls->remove_method(ctor);
-      }
+      groups.push_back(
+          DispatchGroup{merger, spec, ctors, std::move(ctor_signatures), {}});
+    }
+  }
+  compute_dedupped_indices(groups);
 
-      // Populating method dedup map
-      for (auto& type_to_sig : ctor_signatures) {
-        auto type = type_to_sig.first;
-        auto map = std::make_pair(type_to_sig.second, dispatch);
-        m_method_dedup_map[type].push_back(map);
-        TRACE(CLMG,
-              9,
-              " adding dedup map type %s %s -> %s",
-              SHOW(type),
-              type_to_sig.second.c_str(),
-              SHOW(dispatch));
-      }
+  // Create the dispatches, in order.
+  std::unordered_map<DexMethod*, DexMethod*> old_to_new_callee;
+  std::vector<DexMethod*> dispatches;
+  dispatches.reserve(groups.size());
+  for (auto& group : groups) {
+    auto& ctors = group.targets;
+    auto& indices_to_callee = group.indices_to_callee;
+    if (indices_to_callee.size() > 1) {
+      always_assert_log(
+          m_model_spec.has_type_tag(),
+          "No type tag config cannot handle multiple dispatch targets!");
+    }
+    m_stats.m_num_ctor_dedupped += ctors.size() - indices_to_callee.size();
+    auto dispatch =
+        dispatch::create_ctor_or_static_dispatch(group.spec, indices_to_callee);
+    for (const auto& m : ctors) {
+      old_to_new_callee[m] = dispatch;
+    }
+    type_class(group.spec.owner_type)->add_method(dispatch);
+    // Inline entries. Inlining changes the visibility of the members the
+    // entries reference, so it is not done in parallel.
+    inline_dispatch_entries(dispatch);
+    dispatches.push_back(dispatch);
+  }
+  workqueue_run<DexMethod*>(
+      [](DexMethod* dispatch) { sink_common_ctor_to_return_block(dispatch); },
+      dispatches);
+
+  for (size_t i = 0; i < groups.size(); ++i) {
+    auto& group = groups[i];
+    auto dispatch = dispatches[i];
+    auto& ctors = group.targets;
+    auto target_cls = type_class(group.spec.owner_type);
+    auto mergeable_cls = type_class(ctors.front()->get_class());
+    always_assert(mergeable_cls->get_super_class() ==
+                  target_cls->get_super_class());
+
+    // Remove mergeable ctors
+    // The original mergeable ctors have been converted to static and won't
+    // pass VFY.
+    for (const auto ctor : ctors) {
+      auto cls = type_class(ctor->get_class());
+      cls->remove_method(ctor);
+    }
 
-      dispatches.emplace(dispatch);
+    // Populating method dedup map
+    for (auto& type_to_sig : group.signatures) {
+      auto type = type_to_sig.first;
+      auto map = std::make_pair(type_to_sig.second, dispatch);
+      m_method_dedup_map[type].push_back(map);
+      TRACE(CLMG,
+            9,
+            " adding dedup map type %s %s -> %s",
+            SHOW(type),
+            type_to_sig.second.c_str(),
+            SHOW(dispatch));
     }
+
     // Update mergeable ctor map
-    for (auto type : pair.first->mergeables) {
-      for (auto dispatch : dispatches) {
-        m_mergeable_to_merger_ctor[type] = dispatch;
-      }
+    for (auto type : group.merger->mergeables) {
+      m_mergeable_to_merger_ctor[type] = dispatch;
     }
   }
   //////////////////////////////////////////
@@ -882,9 +906,7 @@ void ModelMethodMerger::dedup_non_ctor_non_virt_methods() {
 }
 
 void ModelMethodMerger::merge_virt_itf_methods() {
-  std::vector<std::pair<DexClass*, DexMethod*>> dispatch_methods;
-  std::unordered_map<DexMethod*, DexMethod*> old_to_new_callee;
-
+  std::vector<DispatchGroup> groups;
   for (auto merger : m_mergers) {
     auto merger_type = const_cast<DexType*>(merger->type);
     auto merger_cls = type_class(merger_type);
@@ -907,8 +929,49 @@ void ModelMethodMerger::merge_virt_itf_methods() {
                           merger_type,
                           type_tag_field,
                           virt_methods,
-                          dispatch_methods,
-                          old_to_new_callee);
+                          groups);
+  }
+  compute_dedupped_indices(groups);
+
+  // Create the dispatches, in order.
+  std::vector<std::pair<DexClass*, DexMethod*>> dispatch_methods;
+  std::unordered_map<DexMethod*, DexMethod*> old_to_new_callee;
+  for (auto& group : groups) {
+    auto target_type = group.spec.owner_type;
+    auto target_cls = type_class(target_type);
+    auto& meth_lst = group.targets;
+    TRACE(CLMG,
+          5,
+          "creating dispatch %s.%s for targets of size %zu",
+          SHOW(target_type),
+          group.spec.name.c_str(),
+          meth_lst.size());
+    m_stats.m_num_vmethods_dedupped +=
+        meth_lst.size() - group.indices_to_callee.size();
+    auto dispatch =
+        dispatch::create_virtual_dispatch(group.spec, group.indices_to_callee);
+    dispatch_methods.emplace_back(target_cls, dispatch.main_dispatch);
+    for (const auto sub_dispatch : dispatch.sub_dispatches) {
+      dispatch_methods.emplace_back(target_cls, sub_dispatch);
+    }
+    for (const auto& m : meth_lst) {
+      old_to_new_callee[m] = dispatch.main_dispatch;
+    }
+    for (const auto& m : meth_lst) {
+      relocate_method(m, target_type);
+    }
+    // Populating method dedup map
+    for (auto& type_to_sig : group.signatures) {
+      auto type = type_to_sig.first;
+      auto map = std::make_pair(type_to_sig.second, dispatch.main_dispatch);
+      m_method_dedup_map[type].push_back(map);
+      TRACE(CLMG,
+            9,
+            " adding dedup map type %s %s -> %s",
+            SHOW(type),
+            type_to_sig.second.c_str(),
+            SHOW(dispatch.main_dispatch));
+    }
   }
 
   method_reference::update_call_refs_simple(m_scope, old_to_new_callee);
@@ -122,18 +122,23 @@ class ModelMethodMerger {
   void merge_methods_within_shape();
   void fix_visibility();
 
+  // The targets of a dispatch to create, see ModelMethodMerger.cpp.
+  struct DispatchGroup;
+
   void merge_virtual_methods(
       const Scope& scope,
       DexType* super_type,
       DexType* target_type,
       DexField* type_tag_field,
       const std::vector<MergerType::VirtualMethod>& virt_methods,
-      std::vector<std::pair<DexClass*, DexMethod*>>& dispatch_methods,
-      std::unordered_map<DexMethod*, DexMethod*>& old_to_new_callee);
+      std::vector<DispatchGroup>& groups);
 
   std::map<SwitchIndices, DexMethod*> get_dedupped_indices_map(
       const std::vector<DexMethod*>& targets);
 
+  // Fills in the dedupped indices of all groups, in parallel.
+  void compute_dedupped_indices(std::vector<DispatchGroup>& groups);
+
   DexType* get_merger_type(DexType* mergeable);
 
   std::string get_method_signature_string(DexMethod* meth);
@@ -1108,7 +1108,7 @@ bool EnumUtilsFieldAnalyzer::analyze_sget(
   always_assert(initializer.insn_src_id_of_attr == 0);
 
   const auto& name = field->str();
-  auto value = std::stoi(name.substr(1));
+  auto value = std::stoi(std::string(name.substr(1)));
   ObjectWithImmutAttr object(integer_type, 1);
   object.write_value(initializer.attr, SignedConstantDomain(value));
   object.jvm_cached_singleton = state->is_jvm_cached_object(valueOf, value);
@@ -405,16 +405,46 @@ bool Transform::replace_with_throw(
 }
 
 void Transform::apply_changes(IRCode* code) {
+  // Replacing instructions one at a time means searching the IRList for each
+  // of them, which is quadratic in the size of the method. Instead, all
+  // replacements are applied in a single walk over the IRList.
+  std::unordered_map<IRInstruction*, const std::vector<IRInstruction*>*>
+      replacements;
+  replacements.reserve(m_replacements.size());
   for (auto const& p : m_replacements) {
-    IRInstruction* old_op = p.first;
-    std::vector<IRInstruction*> new_ops = p.second;
+    bool inserted = replacements.emplace(p.first, &p.second).second;
+    always_assert_log(inserted, "Multiple replacements for %s",
+                      SHOW(p.first));
+  }
+  for (auto it = code->begin(); it != code->end() && !replacements.empty();
+       ++it) {
+    if (it->type != MFLOW_OPCODE) {
+      continue;
+    }
+    auto replacement = replacements.find(it->insn);
+    if (replacement == replacements.end()) {
+      continue;
+    }
+    IRInstruction* old_op = it->insn;
+    const auto& new_ops = *replacement->second;
+    replacements.erase(replacement);
     if (opcode::is_branch(old_op->opcode())) {
+      // Keep the entry, and with it all branch targets pointing to it.
       always_assert(new_ops.size() == 1);
-      code->replace_branch(old_op, new_ops.at(0));
+      always_assert(opcode::is_branch(new_ops.at(0)->opcode()));
+      it->insn = new_ops.at(0);
+      delete old_op;
     } else {
-      code->replace_opcode(old_op, new_ops);
+      for (auto* insn : new_ops) {
+        code->insert_before(it, insn);
+      }
+      // This only turns the entry (and its move-result-pseudo) into a
+      // fallthrough, so the iterator stays valid.
+      code->remove_opcode(it);
     }
   }
+  always_assert_log(replacements.empty(), "No match found for %zu replacements",
+                    replacements.size());
   for (const auto& it : m_deletes) {
     TRACE(CONSTP, 4, "Removing instruction %s", SHOW(it->insn));
     code->remove_opcode(it);
@@ -167,8 +167,10 @@ WholeProgramState::WholeProgramState(
 void WholeProgramState::collect(
     const Scope& scope, const interprocedural::FixpointIterator& fp_iter) {
   initialize_ifields(scope, &m_field_partition);
-  ConcurrentMap<const DexField*, std::vector<ConstantValue>> fields_value_tmp;
-  ConcurrentMap<const DexMethod*, std::vector<ConstantValue>> methods_value_tmp;
+  // Values are joined as they are collected, so that there is a single value
+  // per member to join into the partitions.
+  ConcurrentMap<const DexField*, ConstantValue> fields_value_tmp;
+  ConcurrentMap<const DexMethod*, ConstantValue> methods_value_tmp;
   walk::parallel::methods(scope, [&](DexMethod* method) {
     IRCode* code = method->get_code();
     if (code == nullptr) {
@@ -191,18 +193,16 @@ void WholeProgramState::collect(
     }
   });
   for (const auto& pair : fields_value_tmp) {
-    for (auto& value : pair.second) {
-      m_field_partition.update(pair.first, [&value](auto* current_value) {
-        current_value->join_with(value);
-      });
-    }
+    const auto& value = pair.second;
+    m_field_partition.update(pair.first, [&value](auto* current_value) {
+      current_value->join_with(value);
+    });
   }
   for (const auto& pair : methods_value_tmp) {
-    for (auto& value : pair.second) {
-      m_method_partition.update(pair.first, [&value](auto* current_value) {
-        current_value->join_with(value);
-      });
-    }
+    const auto& value = pair.second;
+    m_method_partition.update(pair.first, [&value](auto* current_value) {
+      current_value->join_with(value);
+    });
   }
 }
 
@@ -219,8 +219,7 @@ void WholeProgramState::collect_field_values(
     const IRInstruction* insn,
     const ConstantEnvironment& env,
     const DexType* clinit_cls,
-    ConcurrentMap<const DexField*, std::vector<ConstantValue>>*
-        fields_value_tmp) {
+    ConcurrentMap<const DexField*, ConstantValue>* fields_value_tmp) {
   if (!opcode::is_an_sput(insn->opcode()) &&
       !opcode::is_an_iput(insn->opcode())) {
     return;
@@ -233,10 +232,13 @@ void WholeProgramState::collect_field_values(
     }
     auto value = env.get(insn->src(0));
     fields_value_tmp->update(
-        field,
-        [value](const DexField*,
-                std::vector<ConstantValue>& s,
-                bool /* exists */) { s.emplace_back(value); });
+        field, [&value](const DexField*, ConstantValue& s, bool exists) {
+          if (exists) {
+            s.join_with(value);
+          } else {
+            s = value;
+          }
+        });
   }
 }
 
@@ -250,8 +252,7 @@ void WholeProgramState::collect_return_values(
     const IRInstruction* insn,
     const ConstantEnvironment& env,
     const DexMethod* method,
-    ConcurrentMap<const DexMethod*, std::vector<ConstantValue>>*
-        methods_value_tmp) {
+    ConcurrentMap<const DexMethod*, ConstantValue>* methods_value_tmp) {
   auto op = insn->opcode();
   if (!opcode::is_a_return(op)) {
     return;
@@ -262,18 +263,20 @@ void WholeProgramState::collect_return_values(
     // this tells us that the code following any invoke of this method is
     // reachable.
     methods_value_tmp->update(
-        method,
-        [](const DexMethod*, std::vector<ConstantValue>& s, bool /* exists */) {
-          s.emplace_back(ConstantValue::top());
+        method, [](const DexMethod*, ConstantValue& s, bool /* exists */) {
+          s = ConstantValue::top();
         });
     return;
   }
   auto value = env.get(insn->src(0));
   methods_value_tmp->update(
-      method,
-      [value](const DexMethod*,
-              std::vector<ConstantValue>& s,
-              bool /* exists */) { s.emplace_back(value); });
+      method, [&value](const DexMethod*, ConstantValue& s, bool exists) {
+        if (exists) {
+          s.join_with(value);
+        } else {
+          s = value;
+        }
+      });
 }
 
 void WholeProgramState::collect_static_finals(const DexClass* cls,
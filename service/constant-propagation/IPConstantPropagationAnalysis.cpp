@@ -7,6 +7,8 @@
 
 #include "IPConstantPropagationAnalysis.h"
 
+#include "IPConstantPropagationSummaryCache.h"
+
 namespace constant_propagation {
 
 namespace interprocedural {
@@ -52,7 +54,6 @@ void FixpointIterator::analyze_node(call_graph::NodeId const& node,
     return;
   }
   auto& cfg = code->cfg();
-  auto intra_cp = get_intraprocedural_analysis(method);
   const auto outgoing_edges =
       call_graph::GraphInterface::successors(m_call_graph, node);
   std::unordered_set<IRInstruction*> outgoing_insns;
@@ -62,23 +63,63 @@ void FixpointIterator::analyze_node(call_graph::NodeId const& node,
     }
     outgoing_insns.emplace(edge->invoke_iterator()->insn);
   }
+
+  // A zero fingerprint means that the summary cache is not used.
+  size_t fingerprint = 0;
+  ArgumentDomain args;
+  if (m_summary_cache != nullptr && m_wps_is_initial) {
+    fingerprint = SummaryCache::fingerprint(method);
+    args = this->get_entry_state_at(node).get(CURRENT_PARTITION_LABEL);
+    auto summary = m_summary_cache->get(method, fingerprint,
+                                        m_summary_cache_context, args);
+    if (summary) {
+      size_t idx = 0;
+      for (auto* block : cfg.blocks()) {
+        for (auto& mie : InstructionIterable(block)) {
+          auto* insn = mie.insn;
+          if (insn->has_method()) {
+            always_assert(idx < summary->out_args.size());
+            if (outgoing_insns.count(insn)) {
+              current_state->set(insn, summary->out_args[idx]);
+            }
+            ++idx;
+          }
+        }
+      }
+      return;
+    }
+  }
+
+  auto intra_cp = get_intraprocedural_analysis(method);
+  std::vector<ArgumentDomain> summary_out_args;
   for (auto* block : cfg.blocks()) {
     auto state = intra_cp->get_entry_state_at(block);
     auto last_insn = block->get_last_insn();
     for (auto& mie : InstructionIterable(block)) {
       auto* insn = mie.insn;
       if (insn->has_method()) {
-        if (outgoing_insns.count(insn)) {
+        bool outgoing = outgoing_insns.count(insn);
+        if (outgoing || fingerprint != 0) {
           ArgumentDomain out_args;
           for (size_t i = 0; i < insn->srcs_size(); ++i) {
             out_args.set(i, state.get(insn->src(i)));
           }
-          current_state->set(insn, out_args);
+          if (fingerprint != 0) {
+            summary_out_args.push_back(out_args);
+          }
+          if (outgoing) {
+            current_state->set(insn, out_args);
+          }
         }
       }
       intra_cp->analyze_instruction(insn, &state, insn == last_insn->insn);
     }
   }
+  if (fingerprint != 0) {
+    m_summary_cache->set(
+        method, fingerprint, m_summary_cache_context,
+        SummaryCache::Summary{std::move(args), std::move(summary_out_args)});
+  }
 }
 
 Domain FixpointIterator::analyze_edge(
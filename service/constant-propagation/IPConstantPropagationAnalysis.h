@@ -58,6 +58,8 @@ using ProcedureAnalysisFactory =
     std::function<std::unique_ptr<intraprocedural::FixpointIterator>(
         const DexMethod*, const WholeProgramState&, ArgumentDomain)>;
 
+class SummaryCache;
+
 /*
  * Performs interprocedural constant propagation of stack / register values.
  *
@@ -68,11 +70,19 @@ class FixpointIterator : public sparta::ParallelMonotonicFixpointIterator<
                              call_graph::GraphInterface,
                              Domain> {
  public:
+  /*
+   * If a SummaryCache is given, methods are analyzed through it as long as
+   * the initial (Top) WholeProgramState is in use.
+   */
   FixpointIterator(const call_graph::Graph& call_graph,
-                   const ProcedureAnalysisFactory& proc_analysis_factory)
+                   const ProcedureAnalysisFactory& proc_analysis_factory,
+                   SummaryCache* summary_cache = nullptr,
+                   size_t summary_cache_context = 0)
       : ParallelMonotonicFixpointIterator(call_graph),
         m_proc_analysis_factory(proc_analysis_factory),
-        m_call_graph(call_graph) {
+        m_call_graph(call_graph),
+        m_summary_cache(summary_cache),
+        m_summary_cache_context(summary_cache_context) {
     auto wps = new WholeProgramState();
     wps->set_to_top();
     m_wps.reset(wps);
@@ -91,6 +101,7 @@ class FixpointIterator : public sparta::ParallelMonotonicFixpointIterator<
 
   void set_whole_program_state(std::unique_ptr<WholeProgramState> wps) {
     m_wps = std::move(wps);
+    m_wps_is_initial = false;
   }
 
   const call_graph::Graph& get_call_graph() { return m_call_graph; }
@@ -99,6 +110,9 @@ class FixpointIterator : public sparta::ParallelMonotonicFixpointIterator<
   std::unique_ptr<const WholeProgramState> m_wps;
   ProcedureAnalysisFactory m_proc_analysis_factory;
   call_graph::Graph m_call_graph;
+  SummaryCache* m_summary_cache;
+  size_t m_summary_cache_context;
+  bool m_wps_is_initial{true};
 };
 
 } // namespace interprocedural
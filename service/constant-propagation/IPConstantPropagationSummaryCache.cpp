@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "IPConstantPropagationSummaryCache.h"
+
+#include <boost/functional/hash.hpp>
+
+#include "DexAnnotation.h"
+#include "DexHasher.h"
+#include "MethodUtil.h"
+
+namespace constant_propagation {
+
+namespace interprocedural {
+
+size_t SummaryCache::context(const ImmutableAttributeAnalyzerState& state) {
+  // The containers are unordered, so combine the hashes of their elements
+  // with an order-independent sum.
+  size_t initializers_hash = 0;
+  for (auto& p : state.method_initializers) {
+    size_t seed = 0;
+    boost::hash_combine(seed, p.first);
+    for (auto& initializer : p.second) {
+      boost::hash_combine(seed, (uint8_t)initializer.attr.kind);
+      boost::hash_combine(seed, initializer.attr.member);
+      boost::hash_combine(seed, initializer.insn_src_id_of_attr);
+      boost::hash_combine(seed, initializer.obj_is_dest());
+      if (!initializer.obj_is_dest()) {
+        boost::hash_combine(seed, *initializer.insn_src_id_of_obj);
+      }
+    }
+    initializers_hash += seed;
+  }
+  size_t attributes_hash = 0;
+  for (auto* method : state.attribute_methods) {
+    attributes_hash += std::hash<const void*>()(method);
+  }
+  for (auto* field : state.attribute_fields) {
+    attributes_hash += std::hash<const void*>()(field);
+  }
+  size_t boxed_objects_hash = 0;
+  for (auto& p : state.cached_boxed_objects) {
+    size_t seed = 0;
+    boost::hash_combine(seed, p.first);
+    boost::hash_combine(seed, p.second.begin);
+    boost::hash_combine(seed, p.second.end);
+    boxed_objects_hash += seed;
+  }
+  size_t seed = 0;
+  boost::hash_combine(seed, initializers_hash);
+  boost::hash_combine(seed, attributes_hash);
+  boost::hash_combine(seed, boxed_objects_hash);
+  return seed;
+}
+
+size_t SummaryCache::fingerprint(const DexMethod* method) {
+  size_t seed = hashing::code_fingerprint(method);
+  if (method::is_clinit(method)) {
+    // The analysis of a class initializer starts out with the encoded values
+    // of the static fields of its class; see set_encoded_values.
+    auto* cls = type_class(method->get_class());
+    for (auto* sfield : cls->get_sfields()) {
+      boost::hash_combine(seed, sfield);
+      auto* value = sfield->get_static_value();
+      boost::hash_combine(seed, value == nullptr ? 0 : value->hash_value());
+    }
+  }
+  return seed | 1;
+}
+
+boost::optional<SummaryCache::Summary> SummaryCache::get(
+    const DexMethod* method,
+    size_t fingerprint,
+    size_t context,
+    const ArgumentDomain& args) {
+  auto entry = m_entries.get(method, Entry());
+  if (entry.fingerprint != fingerprint || entry.context != context ||
+      !entry.summary.args.equals(args)) {
+    m_misses++;
+    return boost::none;
+  }
+  m_hits++;
+  return std::move(entry.summary);
+}
+
+void SummaryCache::set(const DexMethod* method,
+                       size_t fingerprint,
+                       size_t context,
+                       Summary summary) {
+  m_entries.insert_or_assign(std::make_pair(
+      method, Entry{fingerprint, context, std::move(summary)}));
+}
+
+} // namespace interprocedural
+
+} // namespace constant_propagation
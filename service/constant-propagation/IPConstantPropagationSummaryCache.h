@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <utility>
+#include <vector>
+
+#include "ConcurrentContainers.h"
+#include "IPConstantPropagationAnalysis.h"
+
+namespace constant_propagation {
+
+namespace interprocedural {
+
+/*
+ * Remembers, for every method analyzed by the interprocedural FixpointIterator,
+ * the arguments it was analyzed with and the arguments it passed on at each of
+ * its invoke instructions. Kept across runs of IPConstantPropagation, this
+ * lets a later run skip the intraprocedural analysis of a method whose code
+ * and incoming arguments did not change; every other method is reprocessed,
+ * and so are its callees whenever the arguments it passes them change.
+ *
+ * Summaries are only valid for a given analysis context, i.e. a fingerprint
+ * of the analyzer state, and are only recorded while the whole program state
+ * is still Top: a refined WholeProgramState is a product of the current run
+ * and the analysis of a method under it depends on more than its own code.
+ */
+class SummaryCache {
+ public:
+  struct Summary {
+    ArgumentDomain args;
+    // The arguments passed by the n'th invoke instruction of the method, in
+    // the order of the blocks of its (non-editable) CFG.
+    std::vector<ArgumentDomain> out_args;
+  };
+
+  /*
+   * A fingerprint of everything besides its own code and arguments that the
+   * analysis of a method depends on.
+   */
+  static size_t context(const ImmutableAttributeAnalyzerState&);
+
+  /*
+   * A fingerprint of the code of the method, including the encoded values of
+   * the static fields it sees when it is a class initializer.
+   */
+  static size_t fingerprint(const DexMethod*);
+
+  /*
+   * Returns the summary of the method if it was recorded for the same
+   * fingerprint, context and arguments. Safe to call concurrently.
+   */
+  boost::optional<Summary> get(const DexMethod*,
+                               size_t fingerprint,
+                               size_t context,
+                               const ArgumentDomain& args);
+
+  void set(const DexMethod*,
+           size_t fingerprint,
+           size_t context,
+           Summary summary);
+
+  size_t size() const { return m_entries.size(); }
+
+  void clear() { m_entries.clear(); }
+
+  size_t hits() const { return m_hits.load(); }
+  size_t misses() const { return m_misses.load(); }
+
+ private:
+  struct Entry {
+    size_t fingerprint{0};
+    size_t context{0};
+    Summary summary;
+  };
+  ConcurrentMap<const DexMethod*, Entry> m_entries;
+  std::atomic<size_t> m_hits{0};
+  std::atomic<size_t> m_misses{0};
+};
+
+} // namespace interprocedural
+
+} // namespace constant_propagation
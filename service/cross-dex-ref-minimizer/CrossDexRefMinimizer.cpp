@@ -5,6 +5,7 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <algorithm>
 #include <cinttypes>
 #include <cmath>
 #include <numeric>
@@ -70,40 +71,79 @@ uint64_t CrossDexRefMinimizer::ClassInfo::get_priority() const {
   return (primary_priority << 24) | secondary_priority;
 }
 
-void CrossDexRefMinimizer::reprioritize(
-    const std::unordered_map<DexClass*, CrossDexRefMinimizer::ClassInfoDelta>&
-        affected_classes) {
-  TRACE(IDEX, 4, "[dex ordering] Reprioritizing %zu classes",
-        affected_classes.size());
-  for (auto p : affected_classes) {
-    ++m_stats.reprioritizations;
-    DexClass* affected_class = p.first;
-    CrossDexRefMinimizer::ClassInfoDelta& delta = p.second;
-    CrossDexRefMinimizer::ClassInfo& affected_class_info =
-        m_class_infos.at(affected_class);
-    affected_class_info.applied_refs_weight += delta.applied_refs_weight;
-    for (size_t i = 0; i < INFREQUENT_REFS_COUNT; ++i) {
-      affected_class_info.infrequent_refs_weight[i] +=
-          delta.infrequent_refs_weight[i];
+uint32_t CrossDexRefMinimizer::get_ref_id(void* ref) {
+  auto p = m_ref_ids.emplace(ref, m_ref_classes.size());
+  if (p.second) {
+    m_ref_classes.emplace_back();
+    m_ref_remaining_classes.push_back(0);
+    m_ref_applied.push_back(false);
+  }
+  return p.first->second;
+}
+
+template <class Fn>
+void CrossDexRefMinimizer::for_each_remaining_class(uint32_t ref_id,
+                                                    const Fn& fn) {
+  auto& classes = m_ref_classes[ref_id];
+  auto is_erased = [&](uint32_t index) {
+    return m_class_infos[index].cls == nullptr;
+  };
+  // Drop erased classes once they make up most of the list.
+  if (classes.size() > 2 * m_ref_remaining_classes[ref_id] + 8) {
+    classes.erase(std::remove_if(classes.begin(), classes.end(), is_erased),
+                  classes.end());
+  }
+  for (auto index : classes) {
+    if (!is_erased(index)) {
+      fn(m_class_infos[index]);
     }
+  }
+}
 
-    const auto priority = affected_class_info.get_priority();
-    m_prioritized_classes.update_priority(affected_class, priority);
-    TRACE(
-        IDEX, 5,
-        "[dex ordering] Reprioritized class {%s} with priority %016" PRIu64
-        "; index %u; %" PRIu64 " (delta %" PRId64
-        ") applied refs weight, %s (delta %s) infrequent refs weights, %zu "
-        "total refs",
-        SHOW(affected_class), priority, affected_class_info.index,
-        affected_class_info.applied_refs_weight, delta.applied_refs_weight,
-        format_infrequent_refs_array(affected_class_info.infrequent_refs_weight)
-            .c_str(),
-        format_infrequent_refs_array(delta.infrequent_refs_weight).c_str(),
-        affected_class_info.refs.size());
+void CrossDexRefMinimizer::mark_dirty(ClassInfo& class_info) {
+  if (!class_info.dirty) {
+    class_info.dirty = true;
+    m_dirty_classes.push_back(class_info.index);
   }
 }
 
+void CrossDexRefMinimizer::reprioritize() {
+  m_dirty_classes.erase(std::remove_if(m_dirty_classes.begin(),
+                                       m_dirty_classes.end(),
+                                       [&](uint32_t index) {
+                                         auto& class_info =
+                                             m_class_infos[index];
+                                         class_info.dirty = false;
+                                         return class_info.cls == nullptr;
+                                       }),
+                        m_dirty_classes.end());
+  if (m_dirty_classes.empty()) {
+    return;
+  }
+  TRACE(IDEX, 4, "[dex ordering] Reprioritizing %zu classes",
+        m_dirty_classes.size());
+  m_stats.reprioritizations += m_dirty_classes.size();
+  m_prioritized_classes.update_priorities(
+      m_dirty_classes, [&](uint32_t index) {
+        const auto& affected_class_info = m_class_infos[index];
+        const auto priority = affected_class_info.get_priority();
+        TRACE(IDEX, 5,
+              "[dex ordering] Reprioritized class {%s} with priority "
+              "%016" PRIu64 "; index %u; %" PRIu64
+              " applied refs weight, %s infrequent refs weights, %zu total "
+              "refs",
+              SHOW(affected_class_info.cls), priority,
+              affected_class_info.index,
+              affected_class_info.applied_refs_weight,
+              format_infrequent_refs_array(
+                  affected_class_info.infrequent_refs_weight)
+                  .c_str(),
+              affected_class_info.refs.size());
+        return priority;
+      });
+  m_dirty_classes.clear();
+}
+
 void CrossDexRefMinimizer::gather_refs(DexClass* cls,
                                        std::vector<DexMethodRef*>& method_refs,
                                        std::vector<DexFieldRef*>& field_refs,
@@ -162,12 +202,12 @@ void CrossDexRefMinimizer::sample(DexClass* cls) {
 }
 
 void CrossDexRefMinimizer::insert(DexClass* cls) {
-  always_assert(m_class_infos.count(cls) == 0);
+  always_assert(m_class_indices.count(cls) == 0);
   ++m_stats.classes;
-  CrossDexRefMinimizer::ClassInfo& class_info =
-      m_class_infos
-          .insert({cls, CrossDexRefMinimizer::ClassInfo(m_next_index++)})
-          .first->second;
+  uint32_t index = m_class_infos.size();
+  m_class_indices.emplace(cls, index);
+  m_class_infos.emplace_back(cls, index);
+  CrossDexRefMinimizer::ClassInfo& class_info = m_class_infos.back();
 
   // Collect all relevant references that contribute to cross-dex metadata
   // entries.
@@ -185,7 +225,7 @@ void CrossDexRefMinimizer::insert(DexClass* cls) {
   uint64_t& refs_weight = class_info.refs_weight;
   uint64_t& seed_weight = class_info.seed_weight;
 
-  auto add_weight = [&ref_counts = m_ref_counts,
+  auto add_weight = [this, &ref_counts = m_ref_counts,
                      max_ref_count = m_max_ref_count, &refs, &refs_weight,
                      &seed_weight](void* ref, size_t item_weight,
                                    size_t item_seed_weight) {
@@ -200,7 +240,7 @@ void CrossDexRefMinimizer::insert(DexClass* cls) {
     TRACE(IDEX, 6, "[dex ordering] %zu/%zu = %lf %s", ref_count, max_ref_count,
           frequency, skipping ? "(skipping)" : "");
     if (!skipping) {
-      refs.emplace_back(ref, item_weight);
+      refs.emplace_back(get_ref_id(ref), item_weight);
       refs_weight += item_weight;
       seed_weight += item_seed_weight;
     }
@@ -224,105 +264,92 @@ void CrossDexRefMinimizer::insert(DexClass* cls) {
     add_weight(fref, m_config.field_ref_weight, m_config.field_seed_weight);
   }
 
-  std::unordered_map<DexClass*, CrossDexRefMinimizer::ClassInfoDelta>
-      affected_classes;
-  for (const std::pair<void*, uint32_t>& p : refs) {
-    void* ref = p.first;
+  for (const std::pair<uint32_t, uint32_t>& p : refs) {
+    uint32_t ref_id = p.first;
     uint32_t weight = p.second;
-    auto& classes = m_ref_classes[ref];
-    size_t frequency = classes.size();
-    // We record the need to undo (subtract weight of) a previously claimed
-    // infrequent ref. The actual undoing happens later in
-    // reprioritize.
+    size_t frequency = m_ref_remaining_classes[ref_id];
+    // We undo (subtract weight of) a previously claimed infrequent ref. The
+    // priorities of the affected classes get updated later in reprioritize.
     if (frequency > 0 && frequency <= INFREQUENT_REFS_COUNT) {
-      for (DexClass* affected_class : classes) {
-        always_assert(affected_class != cls);
-        affected_classes[affected_class]
-            .infrequent_refs_weight[frequency - 1] -= weight;
-      }
+      for_each_remaining_class(ref_id, [&](ClassInfo& affected_class_info) {
+        affected_class_info.infrequent_refs_weight[frequency - 1] -= weight;
+        mark_dirty(affected_class_info);
+      });
     }
     ++frequency;
     // We are recording a new infrequent unapplied ref, if any.
-    // This happens immediately for the to be inserted class cls,
-    // so that it can be used right away by the upcoming
-    // class_info.get_priority() call, while all other change requests happen
-    // later in reprioritize.
     if (frequency <= INFREQUENT_REFS_COUNT) {
-      for (DexClass* affected_class : classes) {
-        affected_classes[affected_class]
-            .infrequent_refs_weight[frequency - 1] += weight;
-      }
+      for_each_remaining_class(ref_id, [&](ClassInfo& affected_class_info) {
+        affected_class_info.infrequent_refs_weight[frequency - 1] += weight;
+        mark_dirty(affected_class_info);
+      });
       class_info.infrequent_refs_weight[frequency - 1] += weight;
     }
 
-    // There's an implicit invariant that class_info and the keys of
-    // affected_classes are disjoint, so we are not going to reprioritize
-    // the class that we are adding here.
-    classes.emplace(cls);
+    // The class that we are adding here is only recorded now, so that it
+    // doesn't count as affected.
+    m_ref_classes[ref_id].push_back(index);
+    m_ref_remaining_classes[ref_id] = frequency;
   }
   const auto priority = class_info.get_priority();
-  m_prioritized_classes.insert(cls, priority);
+  m_prioritized_classes.insert(index, priority);
   TRACE(IDEX, 4,
         "[dex ordering] Inserting class {%s} with priority %016" PRIu64
         "; index %u; %s infrequent refs weights, %zu total refs",
         SHOW(cls), priority, class_info.index,
         format_infrequent_refs_array(class_info.infrequent_refs_weight).c_str(),
         refs.size());
-  reprioritize(affected_classes);
 }
 
 bool CrossDexRefMinimizer::empty() const {
   return m_prioritized_classes.empty();
 }
 
-DexClass* CrossDexRefMinimizer::front() const {
-  return m_prioritized_classes.front();
+DexClass* CrossDexRefMinimizer::front() {
+  reprioritize();
+  return m_class_infos[m_prioritized_classes.front()].cls;
 }
 
 DexClass* CrossDexRefMinimizer::worst(bool generated) {
-  auto max_it = m_class_infos.end();
+  const CrossDexRefMinimizer::ClassInfo* max_class_info = nullptr;
   uint64_t max_value = 0;
 
-  for (auto it = m_class_infos.begin(); it != m_class_infos.end(); ++it) {
+  // Classes are visited in insertion order, so that if there's a tie, we
+  // prefer the class that was inserted earlier (smaller index) to make things
+  // deterministic.
+  for (const auto& class_info : m_class_infos) {
     // If requested, let's skip generated classes, as they tend to be not stable
     // and may cause drastic build-over-build changes.
-    if (it->first->rstate.is_generated() != generated) {
+    if (class_info.cls == nullptr ||
+        class_info.cls->rstate.is_generated() != generated) {
       continue;
     }
 
-    const CrossDexRefMinimizer::ClassInfo& class_info = it->second;
     uint64_t value = class_info.seed_weight;
 
     // Prefer the largest denominator
-    if (value < max_value) {
+    if (max_class_info != nullptr && value <= max_value) {
       continue;
     }
 
-    // If equal, prefer the class that was inserted earlier (smaller index) to
-    // make things deterministic.
-    if (value == max_value && max_it != m_class_infos.end() &&
-        class_info.index > max_it->second.index) {
-      continue;
-    }
-
-    max_it = it;
+    max_class_info = &class_info;
     max_value = value;
   }
 
-  if (max_it == m_class_infos.end()) {
+  if (max_class_info == nullptr) {
     return nullptr;
   }
 
   TRACE(IDEX, 3,
         "[dex ordering] Picked worst class {%s} with seed %" PRIu64
         "; index %u",
-        SHOW(max_it->first), max_value, max_it->second.index);
-  m_stats.worst_classes.emplace_back(max_it->first, max_value);
-  return max_it->first;
+        SHOW(max_class_info->cls), max_value, max_class_info->index);
+  m_stats.worst_classes.emplace_back(max_class_info->cls, max_value);
+  return max_class_info->cls;
 }
 
 DexClass* CrossDexRefMinimizer::worst() {
-  always_assert(!m_class_infos.empty());
+  always_assert(!m_class_indices.empty());
   // We prefer to find a class that is not generated. Only when such a class
   // doesn't exist (because all classes are generated), then we pick the worst
   // generated class.
@@ -335,10 +362,12 @@ DexClass* CrossDexRefMinimizer::worst() {
 }
 
 void CrossDexRefMinimizer::erase(DexClass* cls, bool emitted, bool reset) {
-  m_prioritized_classes.erase(cls);
-  auto class_info_it = m_class_infos.find(cls);
-  always_assert(class_info_it != m_class_infos.end());
-  const CrossDexRefMinimizer::ClassInfo& class_info = class_info_it->second;
+  auto index_it = m_class_indices.find(cls);
+  always_assert(index_it != m_class_indices.end());
+  uint32_t index = index_it->second;
+  m_class_indices.erase(index_it);
+  m_prioritized_classes.erase(index);
+  CrossDexRefMinimizer::ClassInfo& class_info = m_class_infos[index];
   TRACE(IDEX, 3,
         "[dex ordering] Processing class {%s} with priority %016" PRIu64
         "; index %u; %" PRIu64
@@ -349,85 +378,79 @@ void CrossDexRefMinimizer::erase(DexClass* cls, bool emitted, bool reset) {
         format_infrequent_refs_array(class_info.infrequent_refs_weight).c_str(),
         class_info.refs.size(), emitted);
 
-  // Updating m_applied_refs and m_ref_classes,
-  // and gathering information on how this affects other classes
+  // From here on, the class doesn't count as remaining anymore.
+  class_info.cls = nullptr;
 
   if (reset) {
     TRACE(IDEX, 3, "[dex ordering] Reset");
     ++m_stats.resets;
+    for (auto ref_id : m_applied_refs) {
+      m_ref_applied[ref_id] = false;
+    }
     m_applied_refs.clear();
+    for (auto& reset_class_info : m_class_infos) {
+      if (reset_class_info.cls != nullptr) {
+        reset_class_info.applied_refs_weight = 0;
+        mark_dirty(reset_class_info);
+      }
+    }
   }
 
-  std::unordered_map<DexClass*, CrossDexRefMinimizer::ClassInfoDelta>
-      affected_classes;
-  const auto& refs = class_info.refs;
+  // Updating m_applied_refs and m_ref_classes, and the weights of the
+  // affected classes.
+
   size_t old_applied_refs = m_applied_refs.size();
-  for (const std::pair<void*, uint32_t>& p : refs) {
-    void* ref = p.first;
+  for (const std::pair<uint32_t, uint32_t>& p : class_info.refs) {
+    uint32_t ref_id = p.first;
     uint32_t weight = p.second;
-    auto& classes = m_ref_classes.at(ref);
-    size_t frequency = classes.size();
+    size_t frequency = m_ref_remaining_classes[ref_id];
     always_assert(frequency > 0);
-    const auto erased = classes.erase(cls);
-    always_assert(erased);
     if (frequency <= INFREQUENT_REFS_COUNT) {
-      for (DexClass* affected_class : classes) {
-        affected_classes[affected_class]
-            .infrequent_refs_weight[frequency - 1] -= weight;
-      }
+      for_each_remaining_class(ref_id, [&](ClassInfo& affected_class_info) {
+        affected_class_info.infrequent_refs_weight[frequency - 1] -= weight;
+        mark_dirty(affected_class_info);
+      });
     }
     --frequency;
+    m_ref_remaining_classes[ref_id] = frequency;
     if (frequency > 0 && frequency <= INFREQUENT_REFS_COUNT) {
-      for (DexClass* affected_class : classes) {
-        affected_classes[affected_class]
-            .infrequent_refs_weight[frequency - 1] += weight;
-      }
+      for_each_remaining_class(ref_id, [&](ClassInfo& affected_class_info) {
+        affected_class_info.infrequent_refs_weight[frequency - 1] += weight;
+        mark_dirty(affected_class_info);
+      });
     }
 
     if (!emitted) {
       continue;
     }
-    if (m_applied_refs.count(ref) != 0) {
+    if (m_ref_applied[ref_id]) {
       continue;
     }
-    m_applied_refs.emplace(ref);
-    for (DexClass* affected_class : classes) {
-      affected_classes[affected_class].applied_refs_weight += weight;
-    }
+    m_ref_applied[ref_id] = true;
+    m_applied_refs.push_back(ref_id);
+    for_each_remaining_class(ref_id, [&](ClassInfo& affected_class_info) {
+      affected_class_info.applied_refs_weight += weight;
+      mark_dirty(affected_class_info);
+    });
   }
+  // The refs of an erased class are not needed anymore.
+  std::vector<std::pair<uint32_t, uint32_t>>().swap(class_info.refs);
 
-  // Updating m_class_infos and m_prioritized_classes
-
-  m_class_infos.erase(class_info_it);
-  always_assert(m_class_infos.count(cls) == 0);
-
-  if (reset) {
-    m_prioritized_classes.clear();
-    for (auto it = m_class_infos.begin(); it != m_class_infos.end(); ++it) {
-      DexClass* reset_class = it->first;
-      CrossDexRefMinimizer::ClassInfo& reset_class_info = it->second;
-      reset_class_info.applied_refs_weight = 0;
-      const auto priority = reset_class_info.get_priority();
-      m_prioritized_classes.insert(reset_class, priority);
-      always_assert(reset_class_info.applied_refs_weight == 0);
-    }
-  }
   if (emitted) {
     TRACE(IDEX, 4, "[dex ordering] %zu + %zu = %zu applied refs",
           old_applied_refs, m_applied_refs.size() - old_applied_refs,
           m_applied_refs.size());
   }
-  reprioritize(affected_classes);
 }
 
 size_t CrossDexRefMinimizer::get_unapplied_refs(DexClass* cls) {
-  auto it = m_class_infos.find(cls);
-  if (it == m_class_infos.end()) {
+  auto it = m_class_indices.find(cls);
+  if (it == m_class_indices.end()) {
     return 0;
   }
   size_t unapplied_refs{0};
-  for (auto& p : it->second.refs) {
-    if (!m_applied_refs.count(p.first)) {
+  for (auto& p : m_class_infos[it->second].refs) {
+    if (!m_ref_applied[p.first]) {
       unapplied_refs++;
     }
   }
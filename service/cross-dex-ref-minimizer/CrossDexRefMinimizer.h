@@ -12,7 +12,7 @@
 #include <vector>
 
 #include "DexClass.h"
-#include "MutablePriorityQueue.h"
+#include "IndexedPriorityQueue.h"
 
 namespace cross_dex_ref_minimizer {
 
@@ -26,7 +26,8 @@ namespace cross_dex_ref_minimizer {
 // minimization, but also causes it to use more memory and run slower.
 constexpr uint64_t INFREQUENT_REFS_COUNT = 6;
 
-using PrioritizedDexClasses = MutablePriorityQueue<DexClass*, uint64_t>;
+// Classes are identified by the index at which they were inserted.
+using PrioritizedDexClasses = IndexedPriorityQueue<uint64_t>;
 struct CrossDexRefMinimizerStats {
   uint64_t classes{0};
   uint64_t resets{0};
@@ -76,39 +77,59 @@ struct CrossDexRefMinimizerConfig {
 // reasonably large to prevent overflows. However, we don't always check for
 // overflows. In any case, all of this flows into a heuristic, so it wouldn't
 // be the end of the world if an overflow ever happens.
+//
+// Inserting or erasing a class changes the weights of all remaining classes
+// that share a *ref with it, but their priorities are only recomputed, once
+// per class, when the next class is picked.
 class CrossDexRefMinimizer {
   PrioritizedDexClasses m_prioritized_classes;
-  std::unordered_set<void*> m_applied_refs;
   struct ClassInfo {
+    // The class, or nullptr once it has been erased.
+    DexClass* cls;
     uint32_t index;
+    // Whether the class is in m_dirty_classes.
+    bool dirty{false};
     // This array stores (the weights of) how many of the *refs of this class
     // have only one, two, ... classes left that reference them.
     std::array<uint32_t, INFREQUENT_REFS_COUNT> infrequent_refs_weight;
-    std::vector<std::pair<void*, uint32_t>> refs;
+    // Pairs of ref ids and weights.
+    std::vector<std::pair<uint32_t, uint32_t>> refs;
     uint64_t refs_weight;
     uint64_t applied_refs_weight;
     uint64_t seed_weight{0};
-    explicit ClassInfo(uint32_t i)
-        : index(i),
+    ClassInfo(DexClass* c, uint32_t i)
+        : cls(c),
+          index(i),
           infrequent_refs_weight(),
           refs_weight(0),
           applied_refs_weight(0) {}
     uint64_t get_primary_priority_denominator() const;
     uint64_t get_priority() const;
   };
-  std::unordered_map<DexClass*, ClassInfo> m_class_infos;
-  uint32_t m_next_index{0};
-  std::unordered_map<void*, std::unordered_set<DexClass*>> m_ref_classes;
-  CrossDexRefMinimizerStats m_stats;
-  const CrossDexRefMinimizerConfig m_config;
+  // All classes ever inserted, by index, and the indices of the remaining
+  // ones.
+  std::vector<ClassInfo> m_class_infos;
+  std::unordered_map<DexClass*, uint32_t> m_class_indices;
+  // Classes whose priority needs to be recomputed.
+  std::vector<uint32_t> m_dirty_classes;
 
-  struct ClassInfoDelta {
-    std::array<int32_t, INFREQUENT_REFS_COUNT> infrequent_refs_weight{};
-    int64_t applied_refs_weight{0};
-  };
+  // All relevant *refs get consecutive ids. For each, we track the indices of
+  // the classes that reference it, which may include classes that have been
+  // erased since, and how many of those classes remain.
+  std::unordered_map<void*, uint32_t> m_ref_ids;
+  std::vector<std::vector<uint32_t>> m_ref_classes;
+  std::vector<uint32_t> m_ref_remaining_classes;
+  std::vector<bool> m_ref_applied;
+  std::vector<uint32_t> m_applied_refs;
+
+  CrossDexRefMinimizerStats m_stats;
+  CrossDexRefMinimizerConfig m_config;
 
-  void reprioritize(
-      const std::unordered_map<DexClass*, ClassInfoDelta>& affected_classes);
+  uint32_t get_ref_id(void* ref);
+  template <class Fn>
+  void for_each_remaining_class(uint32_t ref_id, const Fn& fn);
+  void mark_dirty(ClassInfo& class_info);
+  void reprioritize();
   DexClass* worst(bool generated);
 
   std::unordered_map<void*, size_t> m_ref_counts;
@@ -130,7 +151,7 @@ class CrossDexRefMinimizer {
   void ignore(DexClass* cls);
   void insert(DexClass* cls);
   bool empty() const;
-  DexClass* front() const;
+  DexClass* front();
   // "Worst" in the sense of having highest seed weight.
   DexClass* worst();
   // "Erasing" a class applies its refs, updating
@@ -1105,8 +1105,33 @@ CseUnorderedLocationSet SharedState::get_relevant_written_locations(
 
   auto method_ref = insn->get_method();
   DexMethod* method = resolve_method(method_ref, opcode_to_search(insn));
+  auto callee_written_locations = get_callee_written_locations(method);
+  if (callee_written_locations->general_memory_barrier) {
+    return general_memory_barrier_locations;
+  }
+
+  // Only keep written locations that are read
   CseUnorderedLocationSet written_locations;
-  if (!process_base_and_overriding_methods(
+  for (const auto& location : callee_written_locations->locations) {
+    if (read_locations.count(location)) {
+      written_locations.insert(location);
+    }
+  }
+
+  return written_locations;
+}
+
+std::shared_ptr<const SharedState::CalleeWrittenLocations>
+SharedState::get_callee_written_locations(const DexMethod* method) {
+  auto cached = m_callee_written_locations.get(method, nullptr);
+  if (cached) {
+    return cached;
+  }
+
+  auto callee_written_locations = std::make_shared<CalleeWrittenLocations>();
+  auto& locations = callee_written_locations->locations;
+  callee_written_locations->general_memory_barrier =
+      !process_base_and_overriding_methods(
           m_method_override_graph.get(), method, &m_safe_method_defs,
           /* ignore_methods_with_assumenosideeffects */ true,
           [&](DexMethod* other_method) {
@@ -1114,18 +1139,13 @@ CseUnorderedLocationSet SharedState::get_relevant_written_locations(
             if (it == m_method_written_locations.end()) {
               return false;
             }
-            written_locations.insert(it->second.begin(), it->second.end());
+            locations.insert(it->second.begin(), it->second.end());
             return true;
-          })) {
-    return general_memory_barrier_locations;
-  }
-
-  // Remove written locations that are not read
-  std20::erase_if(written_locations, [&read_locations](auto it) {
-    return !read_locations.count(*it);
-  });
+          });
 
-  return written_locations;
+  // Racing threads compute the same summary, so it doesn't matter whose wins.
+  m_callee_written_locations.emplace(method, callee_written_locations);
+  return callee_written_locations;
 }
 
 void SharedState::log_barrier(const Barrier& barrier) {
@@ -1485,7 +1505,7 @@ void CommonSubexpressionElimination::insert_runtime_assertions(
   // the original block, we need to make sure that we track what throw-edges as\
   // needed. (All this is to appease the Android verifier in the presence of
   // monitor instructions.)
-  std::unordered_map<cfg::Block*, std::vector<cfg::Edge*>> outgoing_throws;
+  std::unordered_map<cfg::Block*, cfg::EdgeList> outgoing_throws;
   for (auto b : m_cfg.blocks()) {
     outgoing_throws.emplace(b, b->get_outgoing_throws_in_order());
   }
@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <memory>
+
 #include "ConcurrentContainers.h"
 #include "IROpcode.h"
 #include "MethodOverrideGraph.h"
@@ -100,6 +102,13 @@ class SharedState {
   bool is_invoke_safe(const IRInstruction* insn, DexType* exact_virtual_scope);
   CseUnorderedLocationSet get_relevant_written_locations(
       const IRInstruction* insn, const CseUnorderedLocationSet& read_locations);
+  // The locations written by a resolved callee and all methods overriding it.
+  struct CalleeWrittenLocations {
+    bool general_memory_barrier{false};
+    CseUnorderedLocationSet locations;
+  };
+  std::shared_ptr<const CalleeWrittenLocations> get_callee_written_locations(
+      const DexMethod* method);
   // after init_scope, m_pure_methods will include m_conditionally_pure_methods
   std::unordered_set<DexMethodRef*> m_pure_methods;
   // methods which never represent barriers
@@ -111,6 +120,11 @@ class SharedState {
   std::unique_ptr<ConcurrentMap<Barrier, size_t, BarrierHasher>> m_barriers;
   std::unordered_map<const DexMethod*, CseUnorderedLocationSet>
       m_method_written_locations;
+  // Filled in on demand, as all invocations of a callee in all methods share
+  // the same summary.
+  ConcurrentMap<const DexMethod*,
+                std::shared_ptr<const CalleeWrittenLocations>>
+      m_callee_written_locations;
   std::unordered_map<const DexMethod*, CseUnorderedLocationSet>
       m_conditionally_pure_methods;
   std::unique_ptr<const method_override_graph::Graph> m_method_override_graph;
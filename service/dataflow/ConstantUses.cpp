@@ -119,8 +119,7 @@ ConstantUses::ConstantUses(const cfg::ControlFlowGraph& cfg, DexMethod* method)
   TRACE(CU, 2, "[CU] ConstantUses(%s) need_type_inference:%u", SHOW(method),
         need_type_inference);
   if (need_type_inference && method) {
-    m_type_inference.reset(new type_inference::TypeInference(cfg));
-    m_type_inference->run(method);
+    m_type_environments = type_inference::get_type_environments(cfg, method);
   }
 }
 
@@ -349,8 +348,8 @@ TypeDemand ConstantUses::get_type_demand(IRInstruction* insn,
 
   case OPCODE_IF_EQ:
   case OPCODE_IF_NE:
-    if (m_type_inference) {
-      auto& type_environments = m_type_inference->get_type_environments();
+    if (m_type_environments) {
+      auto& type_environments = m_type_environments->type_envs;
       auto& type_environment = type_environments.at(insn);
       auto t1 = type_environment.get_type(insn->src(0));
       auto t2 = type_environment.get_type(insn->src(1));
@@ -414,8 +413,8 @@ TypeDemand ConstantUses::get_type_demand(IRInstruction* insn,
     switch (insn->opcode()) {
     case OPCODE_APUT:
     case OPCODE_APUT_WIDE: {
-      if (m_type_inference) {
-        auto& type_environments = m_type_inference->get_type_environments();
+      if (m_type_environments) {
+        auto& type_environments = m_type_environments->type_envs;
         auto& type_environment = type_environments.at(insn);
         auto dex_type = type_environment.get_dex_type(insn->src(1));
         TRACE(CU, 3, "[CU] aput(-wide) instruction array type: %s",
@@ -499,6 +498,8 @@ TypeDemand ConstantUses::get_type_demand(IRInstruction* insn,
   }
 }
 
-bool ConstantUses::has_type_inference() const { return !!m_type_inference; }
+bool ConstantUses::has_type_inference() const {
+  return !!m_type_environments;
+}
 
 } // namespace constant_uses
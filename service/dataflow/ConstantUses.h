@@ -8,7 +8,7 @@
 #pragma once
 
 #include "ReachingDefinitions.h"
-#include "TypeInference.h"
+#include "TypeInferenceCache.h"
 
 namespace constant_uses {
 
@@ -46,7 +46,8 @@ class ConstantUses {
   static TypeDemand get_type_demand(DexType* type);
   TypeDemand get_type_demand(IRInstruction* insn, size_t src_index) const;
 
-  mutable std::unique_ptr<type_inference::TypeInference> m_type_inference;
+  std::shared_ptr<const type_inference::CachedTypeEnvironments>
+      m_type_environments;
   reaching_defs::MoveAwareFixpointIterator m_reaching_definitions;
   std::unordered_map<IRInstruction*,
                      std::vector<std::pair<IRInstruction*, size_t>>>
@@ -151,6 +151,104 @@ DefUseChains MoveAwareChains::get_def_use_chains() const {
   return get_def_use_chains_impl(m_cfg, m_fp_iter);
 }
 
+struct LazyChains::Index {
+  // The uses of an instruction with n srcs are the n consecutive rows starting
+  // at the row recorded for it here.
+  std::unordered_map<const IRInstruction*, uint32_t> use_rows;
+  // The defs of the use at row r are defs[def_offsets[r], def_offsets[r + 1]).
+  std::vector<uint32_t> def_offsets;
+  std::vector<Def> defs;
+
+  // Likewise, the uses of the def at row r are
+  // uses[use_offsets[r], use_offsets[r + 1]).
+  std::unordered_map<const IRInstruction*, uint32_t> def_rows;
+  std::vector<uint32_t> use_offsets;
+  std::vector<Use> uses;
+};
+
+LazyChains::LazyChains(const cfg::ControlFlowGraph& cfg) : m_cfg(cfg) {}
+
+LazyChains::~LazyChains() = default;
+
+const reaching_defs::MoveAwareFixpointIterator& LazyChains::get_fp_iter()
+    const {
+  if (!m_fp_iter) {
+    m_fp_iter =
+        std::make_unique<reaching_defs::MoveAwareFixpointIterator>(m_cfg);
+    m_fp_iter->run(reaching_defs::Environment());
+  }
+  return *m_fp_iter;
+}
+
+const LazyChains::Index& LazyChains::get_index() const {
+  if (m_index) {
+    return *m_index;
+  }
+
+  auto index = std::make_unique<Index>();
+  // (def row, use) pairs, to be bucketed by def row once all are known.
+  std::vector<std::pair<uint32_t, Use>> def_uses;
+  index->def_offsets.push_back(0);
+  replay_analysis_with_callback(
+      m_cfg, get_fp_iter(),
+      [&](const Use& use, const reaching_defs::Domain& defs) {
+        if (use.src_index == 0) {
+          index->use_rows.emplace(use.insn, index->def_offsets.size() - 1);
+        }
+        for (auto def : defs.elements()) {
+          index->defs.push_back(def);
+          auto row = index->def_rows.emplace(def, index->def_rows.size())
+                         .first->second;
+          def_uses.emplace_back(row, use);
+        }
+        index->def_offsets.push_back(index->defs.size());
+      });
+
+  index->use_offsets.assign(index->def_rows.size() + 1, 0);
+  for (const auto& def_use : def_uses) {
+    ++index->use_offsets[def_use.first + 1];
+  }
+  for (size_t row = 1; row < index->use_offsets.size(); ++row) {
+    index->use_offsets[row] += index->use_offsets[row - 1];
+  }
+  std::vector<uint32_t> next(index->use_offsets.begin(),
+                             index->use_offsets.end() - 1);
+  index->uses.resize(def_uses.size());
+  for (const auto& def_use : def_uses) {
+    index->uses[next[def_use.first]++] = def_use.second;
+  }
+
+  m_index = std::move(index);
+  return *m_index;
+}
+
+LazyChains::Defs LazyChains::get_defs(const Use& use) const {
+  const auto& index = get_index();
+  auto it = index.use_rows.find(use.insn);
+  if (it == index.use_rows.end() || use.src_index >= use.insn->srcs_size()) {
+    return Defs();
+  }
+  auto row = it->second + use.src_index;
+  const auto* defs = index.defs.data();
+  return Defs(defs + index.def_offsets[row], defs + index.def_offsets[row + 1]);
+}
+
+LazyChains::Uses LazyChains::get_uses(Def def) const {
+  const auto& index = get_index();
+  auto it = index.def_rows.find(def);
+  if (it == index.def_rows.end()) {
+    return Uses();
+  }
+  auto row = it->second;
+  const auto* uses = index.uses.data();
+  return Uses(uses + index.use_offsets[row], uses + index.use_offsets[row + 1]);
+}
+
+void LazyChains::invalidate() {
+  m_index.reset();
+  m_fp_iter.reset();
+}
+
 void renumber_registers(IRCode* code, bool width_aware) {
   cfg::ScopedCFG cfg(code);
 
@@ -6,9 +6,12 @@
  */
 
 #include <boost/functional/hash.hpp>
+#include <boost/range/iterator_range.hpp>
 #include <cstdint>
+#include <memory>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "ControlFlow.h"
 #include "IRInstruction.h"
@@ -78,6 +81,45 @@ class MoveAwareChains {
   reaching_defs::MoveAwareFixpointIterator m_fp_iter;
 };
 
+/*
+ * Move-aware use-def and def-use chains of a method, for passes which query
+ * chains in both directions, or also need the reaching definitions. Nothing is
+ * computed until the first query. The reaching-definitions fixpoint then runs
+ * once, and a single replay of it builds both chains, in compressed sparse row
+ * form: the defs of all uses, and the uses of all defs, are each stored in one
+ * flat array, indexed by an array of offsets. Queries return ranges into those
+ * arrays, so no container is allocated per chain.
+ *
+ * The chains are a snapshot of the code at the time of the first query. After
+ * changing the code, call invalidate() before querying again.
+ */
+class LazyChains {
+ public:
+  using Defs = boost::iterator_range<const Def*>;
+  using Uses = boost::iterator_range<const Use*>;
+
+  explicit LazyChains(const cfg::ControlFlowGraph& cfg);
+  ~LazyChains();
+
+  const reaching_defs::MoveAwareFixpointIterator& get_fp_iter() const;
+
+  // The defs reaching `use`, empty if there is no such use.
+  Defs get_defs(const Use& use) const;
+
+  // The uses reached by `def`, empty if it has none.
+  Uses get_uses(Def def) const;
+
+  void invalidate();
+
+ private:
+  struct Index;
+  const Index& get_index() const;
+
+  const cfg::ControlFlowGraph& m_cfg;
+  mutable std::unique_ptr<reaching_defs::MoveAwareFixpointIterator> m_fp_iter;
+  mutable std::unique_ptr<Index> m_index;
+};
+
 /*
  * width_aware means that the renumbering process will allocate 2 slots per
  * wide register. In general, callers should use the default (true) value.
@@ -9,9 +9,10 @@
 
 #include "BaseIRAnalyzer.h"
 #include "ControlFlow.h"
-#include "PatriciaTreeSetAbstractDomain.h"
+#include "DenseBitsetAbstractDomain.h"
 
-using LivenessDomain = sparta::PatriciaTreeSetAbstractDomain<reg_t>;
+// Registers form a small dense universe, so bit vectors beat Patricia trees.
+using LivenessDomain = sparta::DenseBitsetAbstractDomain<reg_t>;
 
 class LivenessFixpointIterator final
     : public ir_analyzer::BaseBackwardsIRAnalyzer<LivenessDomain> {
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "BlockFingerprintIndex.h"
+
+#include <boost/functional/hash.hpp>
+
+#include "DedupBlockValueNumbering.h"
+#include "IRCode.h"
+#include "Liveness.h"
+#include "Walkers.h"
+
+using namespace DedupBlkValueNumbering;
+
+namespace {
+
+using Tokens = std::vector<uint64_t>;
+
+enum Token : uint64_t {
+  DEF,
+  REF,
+};
+
+// Serializes the ordered operations of a block into a method-independent
+// token sequence. Each value is spelled out where it is first used, and
+// referenced by its block-local index afterwards.
+class Canonicalizer {
+ public:
+  explicit Canonicalizer(const BlockValues& block_values)
+      : m_block_values(block_values) {}
+
+  Tokens run(const BlockValue& block_value) {
+    Tokens tokens;
+    for (auto& operation : block_value.ordered_operations) {
+      append_operation(operation, &tokens);
+    }
+    // Tail blocks have nothing live-out, but be conservative.
+    for (auto& p : block_value.out_regs) {
+      append_value(p.second, &tokens);
+    }
+    return tokens;
+  }
+
+ private:
+  void append_operation(const IROperation& operation, Tokens* tokens) {
+    tokens->push_back(operation.opcode);
+    if (operation.opcode == IOPCODE_LOAD_REG) {
+      // The local index assigned in append_value renames the register.
+      return;
+    }
+    tokens->push_back(operation.literal);
+    tokens->push_back(operation.srcs.size());
+    for (auto src : operation.srcs) {
+      append_value(src, tokens);
+    }
+  }
+
+  void append_value(value_id_t value, Tokens* tokens) {
+    auto p = m_local_ids.emplace(value, m_local_ids.size());
+    if (!p.second) {
+      tokens->push_back(REF);
+      tokens->push_back(p.first->second);
+      return;
+    }
+    tokens->push_back(DEF);
+    append_operation(m_block_values.get_value_operation(value), tokens);
+  }
+
+  const BlockValues& m_block_values;
+  std::unordered_map<value_id_t, size_t> m_local_ids;
+};
+
+bool is_tail_block(const cfg::ControlFlowGraph& cfg, cfg::Block* block) {
+  auto branchingness = block->branchingness();
+  if (branchingness != opcode::BRANCH_RETURN &&
+      branchingness != opcode::BRANCH_THROW) {
+    return false;
+  }
+  return cfg.get_succ_edge_of_type(block, cfg::EDGE_THROW) == nullptr;
+}
+
+bool tail_block_less(const dedup_blocks_impl::TailBlock& a,
+                     const dedup_blocks_impl::TailBlock& b) {
+  if (a.method != b.method) {
+    return compare_dexmethods(a.method, b.method);
+  }
+  return a.block_id < b.block_id;
+}
+
+} // namespace
+
+namespace dedup_blocks_impl {
+
+BlockFingerprintIndex::BlockFingerprintIndex(const Scope& scope,
+                                             size_t min_insns) {
+  ConcurrentMap<Tokens, std::vector<TailBlock>, boost::hash<Tokens>> groups;
+  walk::parallel::code(scope, [&](DexMethod* method, IRCode& code) {
+    bool built_cfg = false;
+    if (!code.cfg_built()) {
+      code.build_cfg(/* editable */ false);
+      built_cfg = true;
+    }
+    auto& cfg = code.cfg();
+    cfg.calculate_exit_block();
+    LivenessFixpointIterator liveness_fixpoint_iter(cfg);
+    liveness_fixpoint_iter.run({});
+    BlockValues block_values(liveness_fixpoint_iter);
+    for (auto* block : cfg.blocks()) {
+      auto insns = block->num_opcodes();
+      if (insns < min_insns || insns == 0 || !is_tail_block(cfg, block)) {
+        continue;
+      }
+      auto* first_insn = block->get_first_insn()->insn;
+      auto tokens =
+          Canonicalizer(block_values).run(*block_values.get_block_value(block));
+      m_fingerprints.emplace(first_insn, boost::hash_range(tokens.begin(),
+                                                           tokens.end()));
+      groups.update(tokens, [&](const Tokens&, std::vector<TailBlock>& v,
+                                bool) {
+        v.push_back(TailBlock{method, first_insn, block->id(), insns});
+      });
+    }
+    if (built_cfg) {
+      code.clear_cfg();
+    }
+  });
+
+  for (auto& p : groups) {
+    auto group = p.second;
+    std::sort(group.begin(), group.end(), tail_block_less);
+    if (group.front().method == group.back().method) {
+      continue;
+    }
+    m_cross_method_duplicates.push_back(std::move(group));
+  }
+  std::sort(m_cross_method_duplicates.begin(),
+            m_cross_method_duplicates.end(),
+            [](const std::vector<TailBlock>& a,
+               const std::vector<TailBlock>& b) {
+              return tail_block_less(a.front(), b.front());
+            });
+}
+
+boost::optional<size_t> BlockFingerprintIndex::get_fingerprint(
+    const IRInstruction* first_insn) const {
+  auto it = m_fingerprints.find(first_insn);
+  if (it == m_fingerprints.end()) {
+    return boost::none;
+  }
+  return it->second;
+}
+
+} // namespace dedup_blocks_impl
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <vector>
+
+#include "ConcurrentContainers.h"
+#include "ControlFlow.h"
+#include "DexClass.h"
+
+namespace dedup_blocks_impl {
+
+// A block that leaves its method, i.e. that ends in a return or throw and
+// has no exception handlers. Such blocks can be shared across methods
+// without regard to what follows them.
+struct TailBlock {
+  DexMethod* method;
+  // The first instruction of the block; instructions survive building and
+  // clearing the CFG, block ids do not.
+  const IRInstruction* first_insn;
+  // The id of the block in the CFG the index was built from.
+  cfg::BlockId block_id;
+  size_t insns;
+};
+
+// Scope-wide index of the values computed by all tail blocks, based on the
+// same value numbering as DedupBlocks. Fingerprints are canonical across
+// methods: values are described by the operations that compute them, and
+// incoming registers are renamed by order of first use. Two tail blocks
+// with the same fingerprint compute the same values and exit the same way.
+//
+// Operands of commutative operations are ordered by (method-specific) value
+// number, so some equivalent blocks may not be recognized.
+class BlockFingerprintIndex {
+ public:
+  explicit BlockFingerprintIndex(const Scope& scope, size_t min_insns = 1);
+
+  // Groups of equivalent tail blocks that span more than one method, in a
+  // deterministic order.
+  const std::vector<std::vector<TailBlock>>& get_cross_method_duplicates()
+      const {
+    return m_cross_method_duplicates;
+  }
+
+  // The fingerprint of the tail block starting with the given instruction,
+  // if it was indexed.
+  boost::optional<size_t> get_fingerprint(const IRInstruction* first_insn) const;
+
+  size_t size() const { return m_fingerprints.size(); }
+
+ private:
+  ConcurrentMap<const IRInstruction*, size_t> m_fingerprints;
+  std::vector<std::vector<TailBlock>> m_cross_method_duplicates;
+};
+
+} // namespace dedup_blocks_impl
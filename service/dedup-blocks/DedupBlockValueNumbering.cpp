@@ -59,6 +59,11 @@ const BlockValue* BlockValues::get_block_value(cfg::Block* block) const {
   return ptr;
 };
 
+const IROperation& BlockValues::get_value_operation(
+    value_id_t value_id) const {
+  return *m_value_operations.at(value_id);
+}
+
 value_id_t BlockValues::prepare_and_get_reg(std::map<reg_t, value_id_t>& regs,
                                             reg_t reg) const {
   auto it = regs.find(reg);
@@ -117,6 +122,7 @@ value_id_t BlockValues::get_value_id(const IROperation& operation) const {
     return it->second;
   }
   value_id_t id = m_value_ids.size();
-  m_value_ids.emplace(operation, id);
+  auto emplaced = m_value_ids.emplace(operation, id);
+  m_value_operations.push_back(&emplaced.first->first);
   return id;
 }
@@ -98,6 +98,10 @@ class BlockValues {
 
   const BlockValue* get_block_value(cfg::Block* block) const;
 
+  // The operation that computes the given value. Value ids are only
+  // meaningful within the BlockValues instance that created them.
+  const IROperation& get_value_operation(value_id_t value_id) const;
+
  private:
   value_id_t prepare_and_get_reg(std::map<reg_t, value_id_t>& regs,
                                  reg_t reg) const;
@@ -113,5 +117,6 @@ class BlockValues {
       m_block_values;
   mutable std::unordered_map<IROperation, value_id_t, IROperationHasher>
       m_value_ids;
+  mutable std::vector<const IROperation*> m_value_operations;
 };
 } // namespace DedupBlkValueNumbering
@@ -7,8 +7,9 @@
 
 #include "LocalPointersAnalysis.h"
 
+#include <atomic>
+
 #include "DexUtil.h"
-#include "PatriciaTreeSet.h"
 #include "Resolver.h"
 #include "Walkers.h"
 #include "WorkQueue.h"
@@ -381,25 +382,147 @@ void FixpointIteratorMapDeleter::operator()(FixpointIteratorMap* map) {
   wq.run_all();
 }
 
-static void analyze_method_recursive(
+namespace {
+
+/*
+ * The strongly connected components of the call graph, restricted to the
+ * methods that still need to be analyzed.
+ */
+struct CallGraphSccs {
+  // Components are numbered in reverse topological order, i.e. callees come
+  // before their callers. Within a component, methods are listed in the order
+  // in which they should be analyzed.
+  std::vector<std::vector<const DexMethod*>> components;
+  // For each component, the distinct components that call into it.
+  std::vector<std::vector<size_t>> callers;
+  // For each component, the number of distinct components it calls into.
+  std::vector<size_t> num_callees;
+};
+
+std::vector<const DexMethod*> get_callees_to_analyze(
     const DexMethod* method,
     const call_graph::Graph& call_graph,
-    sparta::PatriciaTreeSet<const DexMethodRef*> visiting,
-    FixpointIteratorMap* fp_iter_map,
-    SummaryCMap* summary_map) {
-  if (!method || summary_map->count(method) != 0 || visiting.contains(method) ||
-      method->get_code() == nullptr) {
-    return;
+    const SummaryCMap& summary_map) {
+  std::vector<const DexMethod*> callees;
+  if (!call_graph.has_node(method)) {
+    return callees;
+  }
+  for (const auto& edge : call_graph.node(method)->callees()) {
+    const DexMethod* callee = edge->callee()->method();
+    if (callee != nullptr && callee->get_code() != nullptr &&
+        summary_map.count(callee) == 0) {
+      callees.push_back(callee);
+    }
   }
-  visiting.insert(method);
+  return callees;
+}
 
+/*
+ * Tarjan's algorithm, made iterative so that deep call chains don't overflow
+ * the stack.
+ */
+CallGraphSccs compute_sccs(const std::vector<const DexMethod*>& roots,
+                           const call_graph::Graph& call_graph,
+                           const SummaryCMap& summary_map) {
+  struct NodeInfo {
+    size_t index;
+    size_t lowlink;
+    bool on_stack;
+  };
+  struct Frame {
+    const DexMethod* method;
+    std::vector<const DexMethod*> callees;
+    size_t next_callee;
+  };
+
+  CallGraphSccs sccs;
+  std::unordered_map<const DexMethod*, NodeInfo> infos;
+  std::unordered_map<const DexMethod*, size_t> component_of;
+  std::vector<const DexMethod*> scc_stack;
+  std::vector<Frame> dfs_stack;
+
+  auto push = [&](const DexMethod* method) {
+    size_t index = infos.size();
+    infos.emplace(method, NodeInfo{index, index, true});
+    scc_stack.push_back(method);
+    dfs_stack.push_back(
+        Frame{method, get_callees_to_analyze(method, call_graph, summary_map),
+              0});
+  };
+
+  for (const DexMethod* root : roots) {
+    if (infos.count(root) != 0 || summary_map.count(root) != 0) {
+      continue;
+    }
+    push(root);
+    while (!dfs_stack.empty()) {
+      auto& frame = dfs_stack.back();
+      if (frame.next_callee < frame.callees.size()) {
+        const DexMethod* callee = frame.callees[frame.next_callee++];
+        auto it = infos.find(callee);
+        if (it == infos.end()) {
+          push(callee);
+        } else if (it->second.on_stack) {
+          auto& info = infos.at(frame.method);
+          info.lowlink = std::min(info.lowlink, it->second.index);
+        }
+        continue;
+      }
+      const DexMethod* method = frame.method;
+      dfs_stack.pop_back();
+      auto& info = infos.at(method);
+      if (!dfs_stack.empty()) {
+        auto& caller_info = infos.at(dfs_stack.back().method);
+        caller_info.lowlink = std::min(caller_info.lowlink, info.lowlink);
+      }
+      if (info.lowlink != info.index) {
+        continue;
+      }
+      size_t component = sccs.components.size();
+      sccs.components.emplace_back();
+      const DexMethod* member;
+      do {
+        member = scc_stack.back();
+        scc_stack.pop_back();
+        infos.at(member).on_stack = false;
+        component_of.emplace(member, component);
+        sccs.components.back().push_back(member);
+      } while (member != method);
+    }
+  }
+
+  size_t num_components = sccs.components.size();
+  sccs.callers.resize(num_components);
+  sccs.num_callees.resize(num_components, 0);
+  std::vector<size_t> last_caller(num_components, num_components);
+  for (size_t caller = 0; caller < num_components; ++caller) {
+    for (const DexMethod* method : sccs.components[caller]) {
+      for (const DexMethod* callee :
+           get_callees_to_analyze(method, call_graph, summary_map)) {
+        size_t component = component_of.at(callee);
+        if (component == caller || last_caller[component] == caller) {
+          continue;
+        }
+        last_caller[component] = caller;
+        sccs.callers[component].push_back(caller);
+        ++sccs.num_callees[caller];
+      }
+    }
+  }
+  return sccs;
+}
+
+void analyze_method(const DexMethod* method,
+                    const call_graph::Graph& call_graph,
+                    FixpointIteratorMap* fp_iter_map,
+                    SummaryCMap* summary_map) {
   std::unordered_map<const IRInstruction*, EscapeSummary> invoke_to_summary_map;
   if (call_graph.has_node(method)) {
     const auto& callee_edges = call_graph.node(method)->callees();
     for (const auto& edge : callee_edges) {
       auto* callee = edge->callee()->method();
-      analyze_method_recursive(callee, call_graph, visiting, fp_iter_map,
-                               summary_map);
+      // Callees in the same strongly connected component that haven't been
+      // analyzed yet have no summary, and are treated as unknown methods.
       if (summary_map->count(callee) != 0) {
         invoke_to_summary_map.emplace(edge->invoke_iterator()->insn,
                                       summary_map->at(callee));
@@ -427,6 +550,8 @@ static void analyze_method_recursive(
   }
 }
 
+} // namespace
+
 FixpointIteratorMapPtr analyze_scope(const Scope& scope,
                                      const call_graph::Graph& call_graph,
                                      SummaryCMap* summary_map_ptr) {
@@ -438,11 +563,38 @@ FixpointIteratorMapPtr analyze_scope(const Scope& scope,
   summary_map_ptr->emplace(
       DexMethod::get_method("Ljava/lang/Object;.<init>:()V"), EscapeSummary{});
 
-  walk::parallel::code(scope, [&](const DexMethod* method, IRCode& code) {
-    sparta::PatriciaTreeSet<const DexMethodRef*> visiting;
-    analyze_method_recursive(method, call_graph, visiting, fp_iter_map.get(),
-                             summary_map_ptr);
+  std::vector<const DexMethod*> roots;
+  walk::code(scope, [&](const DexMethod* method, IRCode&) {
+    roots.push_back(method);
   });
+  auto sccs = compute_sccs(roots, call_graph, *summary_map_ptr);
+
+  // Analyze the strongly connected components bottom-up: a component becomes
+  // ready once all the components it calls into have been analyzed, and
+  // independent components are analyzed in parallel.
+  std::vector<std::atomic<size_t>> remaining_callees(sccs.components.size());
+  std::vector<size_t> ready;
+  for (size_t i = 0; i < sccs.components.size(); ++i) {
+    remaining_callees[i] = sccs.num_callees[i];
+    if (sccs.num_callees[i] == 0) {
+      ready.push_back(i);
+    }
+  }
+  workqueue_run<size_t>(
+      [&](sparta::SpartaWorkerState<size_t>* worker_state, size_t component) {
+        for (const DexMethod* method : sccs.components[component]) {
+          analyze_method(method, call_graph, fp_iter_map.get(),
+                         summary_map_ptr);
+        }
+        for (size_t caller : sccs.callers[component]) {
+          if (--remaining_callees[caller] == 0) {
+            worker_state->push_task(caller);
+          }
+        }
+      },
+      ready,
+      redex_parallel::default_num_threads(),
+      /*push_tasks_while_running=*/true);
   return fp_iter_map;
 }
 
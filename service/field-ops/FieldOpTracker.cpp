@@ -7,6 +7,9 @@
 
 #include "FieldOpTracker.h"
 
+#include <atomic>
+#include <memory>
+
 #include "BaseIRAnalyzer.h"
 #include "ConcurrentContainers.h"
 #include "ConstantAbstractDomain.h"
@@ -374,11 +377,14 @@ bool TypeLifetimes::has_lifetime(const DexType* t) const {
   if (m_ignored_types.count(t)) {
     return false;
   }
-  if (type::is_subclass(m_java_lang_Enum, t)) {
-    return false;
+  // Checking for enums walks up the class hierarchy, so remember the result.
+  auto cached = m_cache.get(t, boost::none);
+  if (cached) {
+    return *cached;
   }
-
-  return true;
+  bool res = !type::is_subclass(m_java_lang_Enum, t);
+  m_cache.emplace(t, res);
+  return res;
 }
 
 FieldWrites analyze_writes(const Scope& scope,
@@ -400,6 +406,22 @@ FieldWrites analyze_writes(const Scope& scope,
 };
 
 FieldStatsMap analyze(const Scope& scope) {
+  // The fields defined in the scope are counted in a dense table, without
+  // locking; only references resolving to external fields go through the
+  // concurrent map.
+  std::vector<DexField*> fields;
+  std::unordered_map<const DexField*, size_t> field_ids;
+  walk::fields(scope, [&](DexField* field) {
+    field_ids.emplace(field, fields.size());
+    fields.push_back(field);
+  });
+  struct AtomicFieldStats {
+    std::atomic<size_t> reads{0};
+    std::atomic<size_t> writes{0};
+    std::atomic<size_t> init_writes{0};
+  };
+  std::unique_ptr<AtomicFieldStats[]> dense_field_stats(
+      new AtomicFieldStats[fields.size()]);
   ConcurrentMap<DexField*, FieldStats> concurrent_field_stats;
   // Gather the read/write counts from instructions.
   walk::parallel::methods(scope, [&](DexMethod* method) {
@@ -463,13 +485,33 @@ FieldStatsMap analyze(const Scope& scope) {
           return editable_cfg_adapter::LOOP_CONTINUE;
         });
     for (auto& p : field_stats) {
-      concurrent_field_stats.update(
-          p.first, [&](DexField*, FieldStats& fs, bool) { fs += p.second; });
+      auto it = field_ids.find(p.first);
+      if (it == field_ids.end()) {
+        concurrent_field_stats.update(
+            p.first, [&](DexField*, FieldStats& fs, bool) { fs += p.second; });
+        continue;
+      }
+      auto& fs = dense_field_stats[it->second];
+      fs.reads.fetch_add(p.second.reads, std::memory_order_relaxed);
+      fs.writes.fetch_add(p.second.writes, std::memory_order_relaxed);
+      fs.init_writes.fetch_add(p.second.init_writes,
+                               std::memory_order_relaxed);
     }
   });
 
   FieldStatsMap field_stats(concurrent_field_stats.begin(),
                             concurrent_field_stats.end());
+  field_stats.reserve(field_stats.size() + fields.size());
+  for (size_t id = 0; id < fields.size(); ++id) {
+    const auto& fs = dense_field_stats[id];
+    FieldStats stats;
+    stats.reads = fs.reads.load(std::memory_order_relaxed);
+    stats.writes = fs.writes.load(std::memory_order_relaxed);
+    stats.init_writes = fs.init_writes.load(std::memory_order_relaxed);
+    if (stats.reads != 0 || stats.writes != 0 || stats.init_writes != 0) {
+      field_stats.emplace(fields[id], stats);
+    }
+  }
 
   // Gather field reads from annotations.
   walk::annotations(scope, [&](DexAnnotation* anno) {
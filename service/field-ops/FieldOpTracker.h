@@ -37,7 +37,7 @@ class TypeLifetimes {
  private:
   std::unordered_set<const DexType*> m_ignored_types;
   const DexType* m_java_lang_Enum;
-  mutable ConcurrentMap<const DexMethodRef*, boost::optional<bool>> m_cache;
+  mutable ConcurrentMap<const DexType*, boost::optional<bool>> m_cache;
 
  public:
   TypeLifetimes();
@@ -63,7 +63,9 @@ KotlinInstanceRewriter::Stats KotlinInstanceRewriter::remove_escaping_instance(
                   std::set<std::pair<IRInstruction*, DexMethod*>>>&
         concurrent_instance_map) {
   ConcurrentSet<DexFieldRef*> remove_list;
-  // Get all the single uses of the INSTANCE variables
+  // Get all the single uses of the INSTANCE variables. This looks at every
+  // method in the scope, so scan the linear code rather than building a CFG
+  // for each of them, and only consult the shared map for INSTANCE fields.
   KotlinInstanceRewriter::Stats total_stats =
       walk::parallel::methods<KotlinInstanceRewriter::Stats>(
           scope, [&](DexMethod* method) {
@@ -73,10 +75,9 @@ KotlinInstanceRewriter::Stats KotlinInstanceRewriter::remove_escaping_instance(
               return stats;
             }
 
-            cfg::ScopedCFG cfg(method->get_code());
-            auto iterable = cfg::InstructionIterable(*cfg);
-            for (auto it = iterable.begin(); it != iterable.end(); it++) {
-              auto insn = it->insn;
+            std::vector<std::pair<DexFieldRef*, IRInstruction*>> uses;
+            for (auto& mie : InstructionIterable(code)) {
+              auto insn = mie.insn;
 
               if (!opcode::is_an_sget(insn->opcode()) &&
                   !opcode::is_an_sput(insn->opcode())) {
@@ -84,10 +85,8 @@ KotlinInstanceRewriter::Stats KotlinInstanceRewriter::remove_escaping_instance(
               }
 
               auto field = insn->get_field();
-              if (!concurrent_instance_map.count(field)) {
-                continue;
-              }
-              if (remove_list.count(field)) {
+              if (field->get_name() != m_instance ||
+                  !concurrent_instance_map.count(field)) {
                 continue;
               }
               // If there is more SPUT otherthan the initial one.
@@ -100,13 +99,19 @@ KotlinInstanceRewriter::Stats KotlinInstanceRewriter::remove_escaping_instance(
                 remove_list.insert(field);
                 continue;
               }
+              uses.emplace_back(field, insn);
+            }
 
+            for (const auto& use : uses) {
+              if (remove_list.count(use.first)) {
+                continue;
+              }
               concurrent_instance_map.update(
-                  field,
+                  use.first,
                   [&](DexFieldRef*,
                       std::set<std::pair<IRInstruction*, DexMethod*>>& s,
                       bool /* exists */) {
-                    s.insert(std::make_pair(insn, method));
+                    s.insert(std::make_pair(use.second, method));
                   });
             }
             return stats;
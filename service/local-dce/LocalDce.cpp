@@ -257,7 +257,9 @@ bool LocalDce::assumenosideeffects(DexMethodRef* ref, DexMethod* meth) {
   if (::assumenosideeffects(meth)) {
     return true;
   }
-  return m_pure_methods.find(ref) != m_pure_methods.end();
+  // Summaries computed for method definitions apply to all references which
+  // resolve to them.
+  return m_pure_methods.count(ref) || m_pure_methods.count(meth);
 }
 
 void LocalDce::normalize_new_instances(cfg::ControlFlowGraph& cfg) {
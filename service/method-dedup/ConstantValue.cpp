@@ -228,7 +228,7 @@ DexMethod* ConstantValues::create_stub_method(DexMethod* callee) {
       type_reference::drop_and_make(appended_proto->get_args(), size());
   auto stub_proto =
       DexProto::make_proto(appended_proto->get_rtype(), stub_arg_list);
-  auto name = DexString::make_string(callee->get_name()->str() + "$stub");
+  auto name = DexString::make_string(callee->get_name()->str_copy() + "$stub");
   name = DexMethod::get_unique_name(type, name, stub_proto);
   TRACE(METH_DEDUP, 9, "const value: stub name %s", name->c_str());
   auto mc = new MethodCreator(type,
@@ -273,7 +273,7 @@ DexMethod* ConstantValues::create_stub_method(DexMethod* callee) {
 
   auto stub = mc->create();
   // Propogate deobfuscated name
-  auto orig_name = callee->get_deobfuscated_name();
+  auto orig_name = callee->get_deobfuscated_name_copy();
   auto pos = orig_name.find(':');
   always_assert(pos != std::string::npos);
   auto new_name =
@@ -7,20 +7,60 @@
 
 #include "MethodDedup.h"
 
+#include <boost/functional/hash.hpp>
+
 #include "DexOpcode.h"
 #include "IRCode.h"
 #include "MethodReference.h"
 #include "Show.h"
 #include "Trace.h"
+#include "WorkQueue.h"
 
 namespace {
 
+// Below this many methods, hashing their code isn't worth spinning up threads.
+constexpr size_t MIN_METHODS_FOR_PARALLEL_HASHING = 1000;
+
+using CodeHashes = std::unordered_map<const DexMethod*, size_t>;
+
+// A hash of the instructions of `code`, in order. Codes which are structurally
+// equal have the same hash.
+size_t hash_code(const IRCode* code) {
+  size_t result = 0;
+  for (auto& mie : InstructionIterable(code)) {
+    boost::hash_combine(result, mie.insn->hash());
+  }
+  return result;
+}
+
+CodeHashes hash_codes(const std::vector<DexMethod*>& methods) {
+  CodeHashes code_hashes;
+  code_hashes.reserve(methods.size());
+  for (auto* method : methods) {
+    always_assert(method->get_code());
+    code_hashes.emplace(method, 0);
+  }
+  // All entries exist already, so threads only write to distinct values.
+  auto hash_method = [&code_hashes](DexMethod* method) {
+    code_hashes.at(method) = hash_code(method->get_code());
+  };
+  if (methods.size() < MIN_METHODS_FOR_PARALLEL_HASHING) {
+    for (auto* method : methods) {
+      hash_method(method);
+    }
+  } else {
+    workqueue_run<DexMethod*>(hash_method, methods);
+  }
+  return code_hashes;
+}
+
 struct CodeAsKey {
   const IRCode* code;
   const bool dedup_throw_blocks;
+  const size_t hash;
 
-  CodeAsKey(const IRCode* c, bool dedup_throw_blocks)
-      : code(c), dedup_throw_blocks(dedup_throw_blocks) {}
+  CodeAsKey(const IRCode* c, bool dedup_throw_blocks, size_t hash)
+      : code(c), dedup_throw_blocks(dedup_throw_blocks), hash(hash) {}
 
   static bool non_throw_instruction_equal(const IRInstruction& left,
                                           const IRInstruction& right) {
@@ -36,25 +76,21 @@ struct CodeAsKey {
 };
 
 struct CodeHasher {
-  size_t operator()(const CodeAsKey& key) const {
-    size_t result = 0;
-    for (auto& mie : InstructionIterable(key.code)) {
-      result ^= mie.insn->hash();
-    }
-    return result;
-  }
+  size_t operator()(const CodeAsKey& key) const { return key.hash; }
 };
 
 using DuplicateMethods =
     std::unordered_map<CodeAsKey, MethodOrderedSet, CodeHasher>;
 
 std::vector<MethodOrderedSet> get_duplicate_methods_simple(
-    const MethodOrderedSet& methods, bool dedup_throw_blocks) {
+    const MethodOrderedSet& methods,
+    bool dedup_throw_blocks,
+    const CodeHashes& code_hashes) {
   DuplicateMethods duplicates;
   for (DexMethod* method : methods) {
-    always_assert(method->get_code());
-    duplicates[CodeAsKey(method->get_code(), dedup_throw_blocks)].emplace(
-        method);
+    duplicates[CodeAsKey(method->get_code(), dedup_throw_blocks,
+                         code_hashes.at(method))]
+        .emplace(method);
   }
 
   std::vector<MethodOrderedSet> result;
@@ -102,11 +138,12 @@ std::vector<MethodOrderedSet> group_identical_methods(
     const std::vector<DexMethod*>& methods, bool dedup_throw_blocks) {
   std::vector<MethodOrderedSet> result;
   std::vector<MethodOrderedSet> same_protos = group_similar_methods(methods);
+  auto code_hashes = hash_codes(methods);
 
   // Find actual duplicates.
   for (const auto& same_proto : same_protos) {
-    std::vector<MethodOrderedSet> duplicates =
-        get_duplicate_methods_simple(same_proto, dedup_throw_blocks);
+    std::vector<MethodOrderedSet> duplicates = get_duplicate_methods_simple(
+        same_proto, dedup_throw_blocks, code_hashes);
 
     result.insert(result.end(), duplicates.begin(), duplicates.end());
   }
@@ -572,7 +572,7 @@ void CFGInliner::split_on_callee_throws(ControlFlowGraph* callee) {
 void CFGInliner::add_callee_throws_to_caller(
     ControlFlowGraph* cfg,
     const std::vector<Block*>& callee_blocks,
-    const std::vector<Edge*>& caller_catches) {
+    const EdgeList& caller_catches) {
 
   // There are two requirements about the catch indices here:
   //   1) New throw edges must be added to the end of a callee's existing throw
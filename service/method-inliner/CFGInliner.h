@@ -129,7 +129,7 @@ class CFGInliner {
   static void add_callee_throws_to_caller(
       ControlFlowGraph* cfg,
       const std::vector<Block*>& callee_blocks,
-      const std::vector<Edge*>& caller_catches);
+      const EdgeList& caller_catches);
 
   /*
    * Set the parent pointers of the positions in `callee` to `callsite_dbg_pos`
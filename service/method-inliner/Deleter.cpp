@@ -6,12 +6,18 @@
  */
 
 #include "Deleter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <unordered_map>
+
 #include "DexClass.h"
 #include "DexUtil.h"
 #include "ReachableClasses.h"
 #include "Show.h"
 #include "Trace.h"
 #include "Walkers.h"
+#include "WorkQueue.h"
 
 size_t delete_methods(
     std::vector<DexClass*>& scope,
@@ -19,6 +25,9 @@ size_t delete_methods(
     ConcurrentSet<DexMethod*>& delayed_make_static,
     std::function<DexMethod*(DexMethodRef*, MethodSearch search)>
         concurrent_resolver) {
+  if (removable.empty()) {
+    return 0;
+  }
 
   // if a removable candidate is invoked do not delete
   ConcurrentSet<DexMethod*> removable_to_erase;
@@ -38,19 +47,29 @@ size_t delete_methods(
   }
 
   // if a removable candidate is referenced by an annotation do not delete
-  walk::annotations(scope, [&](DexAnnotation* anno) {
+  removable_to_erase.clear();
+  walk::parallel::annotations(scope, [&](DexAnnotation* anno) {
     for (auto anno_element : anno->anno_elems()) {
       auto ev = anno_element.encoded_value;
       if (ev->evtype() == DEVT_METHOD) {
         DexEncodedValueMethod* evm = static_cast<DexEncodedValueMethod*>(ev);
         if (evm->method()->is_def()) {
-          removable.erase(evm->method()->as_def());
+          auto method = evm->method()->as_def();
+          if (removable.count(method)) {
+            removable_to_erase.insert(method);
+          }
         }
       }
     }
   });
+  for (auto method : removable_to_erase) {
+    removable.erase(method);
+  }
 
-  size_t deleted = 0;
+  // Group the deletable methods by class, so that each class only gets
+  // compacted once, and the classes can be processed in parallel.
+  std::unordered_map<DexClass*, std::unordered_set<DexMethod*>>
+      deletable_by_class;
   for (auto callee : removable) {
     if (!callee->is_concrete()) continue;
     if (!can_delete(callee)) continue;
@@ -58,11 +77,31 @@ size_t delete_methods(
     always_assert_log(cls != nullptr,
                       "%s is concrete but does not have a DexClass\n",
                       SHOW(callee));
-    cls->remove_method(callee);
-    delayed_make_static.erase(callee);
-    DexMethod::erase_method(callee);
-    deleted++;
-    TRACE(DELMET, 4, "removing %s", SHOW(callee));
+    deletable_by_class[cls].insert(callee);
+  }
+
+  std::vector<DexClass*> classes;
+  classes.reserve(deletable_by_class.size());
+  for (auto& p : deletable_by_class) {
+    classes.push_back(p.first);
   }
+  std::atomic<size_t> deleted{0};
+  workqueue_run<DexClass*>(
+      [&](DexClass* cls) {
+        const auto& deletable = deletable_by_class.at(cls);
+        auto is_deletable = [&](DexMethod* m) { return deletable.count(m); };
+        for (auto* methods : {&cls->get_dmethods(), &cls->get_vmethods()}) {
+          methods->erase(
+              std::remove_if(methods->begin(), methods->end(), is_deletable),
+              methods->end());
+        }
+        for (auto callee : deletable) {
+          delayed_make_static.erase(callee);
+          DexMethod::erase_method(callee);
+          TRACE(DELMET, 4, "removing %s", SHOW(callee));
+        }
+        deleted += deletable.size();
+      },
+      classes);
   return deleted;
 }
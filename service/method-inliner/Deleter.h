@@ -16,7 +16,9 @@
 /**
  * Attempt to delete all removable candidates if there are no reference to
  * the method and the method is not marked as "do not delete".
- * Walks all opcodes in scope to check if the method is called.
+ * Walks all opcodes in scope to check if the method is called. The remaining
+ * candidates are then removed from their classes in parallel, one class at a
+ * time.
  * A resolver must be provided to map a method reference to a method definition.
  * The resolver must be thread-safe.
  */
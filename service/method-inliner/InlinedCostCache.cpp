@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "InlinedCostCache.h"
+
+#include <boost/functional/hash.hpp>
+
+#include "DexInstruction.h"
+#include "IRCode.h"
+#include "IRInstruction.h"
+
+namespace {
+
+void combine_insn(size_t& seed, const IRInstruction* insn) {
+  boost::hash_combine(seed, (uint16_t)insn->opcode());
+  for (auto src : insn->srcs()) {
+    boost::hash_combine(seed, src);
+  }
+  if (insn->has_dest()) {
+    boost::hash_combine(seed, insn->dest());
+  }
+  if (insn->has_literal()) {
+    boost::hash_combine(seed, insn->get_literal());
+  } else if (insn->has_string()) {
+    boost::hash_combine(seed, insn->get_string());
+  } else if (insn->has_type()) {
+    boost::hash_combine(seed, insn->get_type());
+  } else if (insn->has_field()) {
+    boost::hash_combine(seed, insn->get_field());
+  } else if (insn->has_method()) {
+    boost::hash_combine(seed, insn->get_method());
+  } else if (insn->has_callsite()) {
+    boost::hash_combine(seed, insn->get_callsite());
+  } else if (insn->has_methodhandle()) {
+    boost::hash_combine(seed, insn->get_methodhandle());
+  } else if (insn->has_data()) {
+    auto* data = insn->get_data();
+    boost::hash_range(seed, data->data(), data->data() + data->data_size());
+  }
+}
+
+} // namespace
+
+namespace inliner {
+
+size_t InlinedCostCache::fingerprint(const IRCode* code) {
+  always_assert(code->editable_cfg_built());
+  auto& cfg = code->cfg();
+  size_t seed = cfg.get_registers_size();
+  boost::hash_combine(seed, cfg.entry_block()->id());
+  for (auto* block : cfg.blocks()) {
+    boost::hash_combine(seed, block->id());
+    for (auto& mie : InstructionIterable(block)) {
+      combine_insn(seed, mie.insn);
+    }
+    for (auto* edge : block->succs()) {
+      boost::hash_combine(seed, (uint8_t)edge->type());
+      boost::hash_combine(seed, edge->target()->id());
+      if (edge->type() == cfg::EDGE_THROW) {
+        boost::hash_combine(seed, edge->throw_info()->catch_type);
+        boost::hash_combine(seed, edge->throw_info()->index);
+      } else if (edge->case_key()) {
+        boost::hash_combine(seed, *edge->case_key());
+      }
+    }
+  }
+  return seed | 1;
+}
+
+template <class Fn>
+void InlinedCostCache::update(const DexMethod* callee,
+                              size_t fingerprint,
+                              const Fn& fn) {
+  m_entries.update(callee, [&](const DexMethod*, Entry& entry, bool) {
+    if (entry.fingerprint != fingerprint) {
+      entry = Entry();
+      entry.fingerprint = fingerprint;
+    }
+    fn(entry);
+  });
+}
+
+std::shared_ptr<InlinedCost> InlinedCostCache::get_fully_inlined_cost(
+    const DexMethod* callee, size_t fingerprint) {
+  std::shared_ptr<InlinedCost> res;
+  update(callee, fingerprint,
+         [&](const Entry& entry) { res = entry.fully_inlined_cost; });
+  (res ? m_hits : m_misses)++;
+  return res;
+}
+
+void InlinedCostCache::set_fully_inlined_cost(const DexMethod* callee,
+                                              size_t fingerprint,
+                                              const InlinedCost& cost) {
+  always_assert(cost.dead_blocks.empty());
+  auto stored = std::make_shared<InlinedCost>(cost);
+  update(callee, fingerprint,
+         [&](Entry& entry) { entry.fully_inlined_cost = stored; });
+}
+
+std::shared_ptr<InlinedCost> InlinedCostCache::get_call_site_inlined_cost(
+    const DexMethod* callee,
+    size_t fingerprint,
+    size_t context,
+    const std::string& key) {
+  boost::optional<StoredCost> stored;
+  update(callee, fingerprint, [&](const Entry& entry) {
+    if (entry.call_site_context != context) {
+      return;
+    }
+    auto it = entry.call_site_costs.find(key);
+    if (it != entry.call_site_costs.end()) {
+      stored = it->second;
+    }
+  });
+  if (!stored) {
+    m_misses++;
+    return nullptr;
+  }
+  m_hits++;
+  auto res = std::make_shared<InlinedCost>(std::move(stored->cost));
+  auto& cfg = callee->get_code()->cfg();
+  for (auto id : stored->dead_blocks) {
+    res->dead_blocks.insert(cfg.get_block(id));
+  }
+  return res;
+}
+
+void InlinedCostCache::set_call_site_inlined_cost(const DexMethod* callee,
+                                                  size_t fingerprint,
+                                                  size_t context,
+                                                  const std::string& key,
+                                                  const InlinedCost& cost) {
+  StoredCost stored{cost, {}};
+  stored.cost.dead_blocks.clear();
+  for (auto* block : cost.dead_blocks) {
+    stored.dead_blocks.push_back(block->id());
+  }
+  update(callee, fingerprint, [&](Entry& entry) {
+    if (entry.call_site_context != context) {
+      entry.call_site_context = context;
+      entry.call_site_costs.clear();
+    }
+    entry.call_site_costs.emplace(key, std::move(stored));
+  });
+}
+
+boost::optional<size_t> InlinedCostCache::get_insn_size(
+    const DexMethod* callee, size_t fingerprint) {
+  boost::optional<size_t> res;
+  update(callee, fingerprint,
+         [&](const Entry& entry) { res = entry.insn_size; });
+  return res;
+}
+
+void InlinedCostCache::set_insn_size(const DexMethod* callee,
+                                     size_t fingerprint,
+                                     size_t size) {
+  update(callee, fingerprint, [&](Entry& entry) { entry.insn_size = size; });
+}
+
+} // namespace inliner
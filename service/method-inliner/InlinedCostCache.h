@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <boost/optional.hpp>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "ConcurrentContainers.h"
+#include "ControlFlow.h"
+#include "DexClass.h"
+
+// The average or call-site specific inlined costs, depending on how it is
+// retrieved
+struct InlinedCost {
+  // Full code costs of the original callee
+  size_t full_code;
+  // Average or call-site specific code costs of the callee after pruning
+  float code;
+  // Average or call-site specific method-refs count of the callee after pruning
+  float method_refs;
+  // Average or call-site specific others-refs count of the callee after pruning
+  float other_refs;
+  // Whether all or a specific call-site is guaranteed to not return normally
+  bool no_return;
+  // Average or call-site specific value indicating whether result is used
+  float result_used;
+  // For a specific call-site, a set of known dead blocks in the callee
+  std::unordered_set<cfg::Block*> dead_blocks;
+  // Maximum or call-site specific estimated callee size after pruning
+  size_t insn_size;
+
+  bool operator==(const InlinedCost& other) {
+    return full_code == other.full_code && code == other.code &&
+           method_refs == other.method_refs && other_refs == other.other_refs &&
+           no_return == other.no_return && result_used == other.result_used &&
+           dead_blocks == other.dead_blocks && insn_size == other.insn_size;
+  }
+};
+
+namespace inliner {
+
+/*
+ * Inlined costs of callees, retained across MultiMethodInliner instances so
+ * that repeated inlining passes only re-evaluate callees whose code changed.
+ *
+ * Every entry is tagged with a fingerprint of the callee's editable CFG,
+ * including its block ids; a lookup with a different fingerprint drops the
+ * entry. Dead blocks of call-site specific costs are stored by block id and
+ * mapped back into the callee's current CFG when retrieved.
+ *
+ * Call-site specific costs additionally depend on what the inliner knows
+ * about pure methods, summarized as a context value; they are dropped when
+ * the context changes.
+ */
+class InlinedCostCache {
+ public:
+  // Fingerprint of code with an editable CFG. Never zero.
+  static size_t fingerprint(const IRCode* code);
+
+  std::shared_ptr<InlinedCost> get_fully_inlined_cost(const DexMethod* callee,
+                                                      size_t fingerprint);
+
+  void set_fully_inlined_cost(const DexMethod* callee,
+                              size_t fingerprint,
+                              const InlinedCost& cost);
+
+  std::shared_ptr<InlinedCost> get_call_site_inlined_cost(
+      const DexMethod* callee,
+      size_t fingerprint,
+      size_t context,
+      const std::string& key);
+
+  void set_call_site_inlined_cost(const DexMethod* callee,
+                                  size_t fingerprint,
+                                  size_t context,
+                                  const std::string& key,
+                                  const InlinedCost& cost);
+
+  boost::optional<size_t> get_insn_size(const DexMethod* callee,
+                                        size_t fingerprint);
+
+  void set_insn_size(const DexMethod* callee, size_t fingerprint, size_t size);
+
+  size_t hits() const { return m_hits; }
+  size_t misses() const { return m_misses; }
+
+ private:
+  struct StoredCost {
+    InlinedCost cost;
+    std::vector<cfg::BlockId> dead_blocks;
+  };
+
+  struct Entry {
+    size_t fingerprint{0};
+    std::shared_ptr<InlinedCost> fully_inlined_cost;
+    boost::optional<size_t> insn_size;
+    size_t call_site_context{0};
+    std::unordered_map<std::string, StoredCost> call_site_costs;
+  };
+
+  // Runs fn on the entry of the callee, after resetting it if its
+  // fingerprint doesn't match.
+  template <class Fn>
+  void update(const DexMethod* callee, size_t fingerprint, const Fn& fn);
+
+  ConcurrentMap<const DexMethod*, Entry> m_entries;
+  std::atomic<size_t> m_hits{0};
+  std::atomic<size_t> m_misses{0};
+};
+
+} // namespace inliner
@@ -80,7 +80,8 @@ MultiMethodInliner::MultiMethodInliner(
     InlineForSpeed* inline_for_speed,
     bool analyze_and_prune_inits,
     const std::unordered_set<DexMethodRef*>& configured_pure_methods,
-    const std::unordered_set<DexString*>& configured_finalish_field_names)
+    const std::unordered_set<DexString*>& configured_finalish_field_names,
+    inliner::InlinedCostCache* inlined_cost_cache)
     : m_concurrent_resolver(std::move(concurrent_resolve_fn)),
       m_scheduler(
           [this](DexMethod* method) {
@@ -111,8 +112,35 @@ MultiMethodInliner::MultiMethodInliner(
                  scope,
                  config.shrinker,
                  configured_pure_methods,
-                 configured_finalish_field_names) {
+                 configured_finalish_field_names),
+      m_inlined_cost_cache(inlined_cost_cache) {
   Timer t("MultiMethodInliner construction");
+  const auto& blocklist = config.get_blocklist();
+  for (auto* cls : scope) {
+    std::vector<const DexType*> chain;
+    bool blocklisted = false;
+    for (auto* c = cls; c != nullptr; c = type_class(c->get_super_class())) {
+      auto it = m_blocklisted_types.find(c->get_type());
+      if (it != m_blocklisted_types.end()) {
+        blocklisted = it->second;
+        break;
+      }
+      chain.push_back(c->get_type());
+      if (blocklist.count(c->get_type())) {
+        blocklisted = true;
+        break;
+      }
+    }
+    for (auto* type : chain) {
+      m_blocklisted_types.emplace(type, blocklisted);
+    }
+  }
+  if (m_inlined_cost_cache) {
+    for (auto* method : m_shrinker.get_pure_methods()) {
+      // Order-independent, as the set is unordered.
+      m_call_site_cost_context += std::hash<DexMethodRef*>()(method);
+    }
+  }
   for (const auto& callee_callers : true_virtual_callers) {
     auto callee = callee_callers.first;
     if (callee_callers.second.other_call_sites) {
@@ -288,7 +316,7 @@ void MultiMethodInliner::compute_call_site_summaries() {
 
   Timer t("compute_call_site_summaries");
   struct CalleeInfo {
-    std::unordered_map<std::string, CallSiteSummary> call_site_summaries;
+    CallSiteSummaries call_site_summaries;
     std::unordered_map<std::string, size_t> occurrences;
   };
 
@@ -377,8 +405,10 @@ void MultiMethodInliner::compute_call_site_summaries() {
                   SHOW(call_site_summary.arguments));
             }
             ++ci->occurrences[key];
+            // Elements of an unordered_map don't move, also not when the map
+            // itself is moved into m_callee_call_site_summaries below.
+            m_invoke_call_site_summaries.emplace(insn, &*q.first);
           });
-      m_invoke_call_site_summaries.emplace(insn, std::move(call_site_summary));
     }
     info.constant_invoke_callers_analyzed++;
     info.constant_invoke_callers_unreachable_blocks += res.dead_blocks;
@@ -388,6 +418,7 @@ void MultiMethodInliner::compute_call_site_summaries() {
   for (auto& p : caller_callee) {
     auto method = const_cast<DexMethod*>(p.first);
     callers.push_back(method);
+    summaries_scheduler.set_weight(method, get_method_size(method));
     auto dependencies = get_dependencies(method);
     if (dependencies) {
       for (auto& q : *dependencies) {
@@ -397,6 +428,11 @@ void MultiMethodInliner::compute_call_site_summaries() {
   }
   info.constant_invoke_callers_critical_path_length =
       summaries_scheduler.run(callers.begin(), callers.end());
+  auto& summaries_thread_pool = summaries_scheduler.get_thread_pool();
+  info.constant_invoke_callers_utilization_percent =
+      (size_t)(summaries_thread_pool.get_utilization() * 100);
+  info.constant_invoke_callers_saturation_percent =
+      (size_t)(summaries_thread_pool.get_saturation() * 100);
 
   for (auto& p : concurrent_callee_infos) {
     auto& v = m_callee_call_site_summary_occurrences[p.first];
@@ -404,8 +440,10 @@ void MultiMethodInliner::compute_call_site_summaries() {
     for (const auto& q : ci->occurrences) {
       const auto& key = q.first;
       const auto& count = q.second;
-      v.emplace_back(ci->call_site_summaries.at(key), count);
+      v.emplace_back(&*ci->call_site_summaries.find(key), count);
     }
+    m_callee_call_site_summaries.emplace(p.first,
+                                         std::move(ci->call_site_summaries));
   }
 }
 
@@ -445,7 +483,7 @@ void MultiMethodInliner::inline_methods(bool methods_need_deconstruct) {
   // - whether all callers are in the same class, and are called from how many
   //   classes
   m_callee_insn_sizes =
-      std::make_unique<ConcurrentMap<const DexMethod*, size_t>>();
+      std::make_unique<ReadMostlyConcurrentMap<const DexMethod*, size_t>>();
   m_callee_type_refs = std::make_unique<
       ConcurrentMap<const DexMethod*, std::vector<DexType*>>>();
   m_callee_caller_refs =
@@ -505,10 +543,38 @@ void MultiMethodInliner::inline_methods(bool methods_need_deconstruct) {
     }
   }
 
+  // Weigh each method by its own size plus the sizes of the callees that
+  // will be inlined into it, so that long chains of large methods get started
+  // first instead of serializing at the end.
+  std::unordered_map<const DexMethod*, size_t> method_sizes;
+  auto get_size = [&](const DexMethod* method) {
+    auto it = method_sizes.find(method);
+    if (it == method_sizes.end()) {
+      it = method_sizes.emplace(method, get_method_size(method)).first;
+    }
+    return it->second;
+  };
+  for (auto method : methods_to_schedule) {
+    uint64_t weight = get_size(method);
+    auto it = caller_callee.find(method);
+    if (it != caller_callee.end()) {
+      for (auto& q : it->second) {
+        weight += get_size(q.first) * q.second;
+      }
+    }
+    m_scheduler.set_weight(
+        method, (uint32_t)std::min<uint64_t>(
+                    weight, std::numeric_limits<uint32_t>::max()));
+  }
+
   info.critical_path_length =
       m_scheduler.run(methods_to_schedule.begin(), methods_to_schedule.end());
+  info.weighted_critical_path_length = m_scheduler.get_max_weighted_length();
   delayed_change_visibilities();
-  info.waited_seconds = m_scheduler.get_thread_pool().get_waited_seconds();
+  auto& thread_pool = m_scheduler.get_thread_pool();
+  info.waited_seconds = thread_pool.get_waited_seconds();
+  info.utilization_percent = (size_t)(thread_pool.get_utilization() * 100);
+  info.saturation_percent = (size_t)(thread_pool.get_saturation() * 100);
 
   if (!need_deconstruct.empty()) {
     workqueue_run<IRCode*>([](IRCode* code) { code->clear_cfg(); },
@@ -1229,6 +1295,13 @@ bool MultiMethodInliner::is_blocklisted(const DexMethod* callee) {
   if (is_enum(cls) && root(callee)) {
     return true;
   }
+  auto it = m_blocklisted_types.find(callee->get_class());
+  if (it != m_blocklisted_types.end()) {
+    if (it->second) {
+      info.blocklisted++;
+    }
+    return it->second;
+  }
   while (cls != nullptr) {
     if (m_config.get_blocklist().count(cls->get_type())) {
       info.blocklisted++;
@@ -1322,6 +1395,12 @@ bool MultiMethodInliner::should_inline_always(const DexMethod* callee) {
   return *res;
 }
 
+size_t MultiMethodInliner::get_method_size(const DexMethod* method) {
+  const IRCode* code = method->get_code();
+  return code->editable_cfg_built() ? code->cfg().sum_opcode_sizes()
+                                    : code->sum_opcode_sizes();
+}
+
 size_t MultiMethodInliner::get_callee_insn_size(const DexMethod* callee) {
   if (m_callee_insn_sizes) {
     const auto absent = std::numeric_limits<size_t>::max();
@@ -1331,9 +1410,15 @@ size_t MultiMethodInliner::get_callee_insn_size(const DexMethod* callee) {
     }
   }
 
-  const IRCode* code = callee->get_code();
-  auto size = code->editable_cfg_built() ? code->cfg().sum_opcode_sizes()
-                                         : code->sum_opcode_sizes();
+  auto fingerprint = m_callee_insn_sizes ? get_callee_fingerprint(callee) : 0;
+  boost::optional<size_t> cached_size;
+  if (fingerprint) {
+    cached_size = m_inlined_cost_cache->get_insn_size(callee, fingerprint);
+  }
+  auto size = cached_size ? *cached_size : get_method_size(callee);
+  if (fingerprint && !cached_size) {
+    m_inlined_cost_cache->set_insn_size(callee, fingerprint, size);
+  }
   if (m_callee_insn_sizes) {
     m_callee_insn_sizes->emplace(callee, size);
   }
@@ -1664,16 +1749,28 @@ const InlinedCost* MultiMethodInliner::get_fully_inlined_cost(
   if (inlined_cost) {
     return inlined_cost.get();
   }
-  bool callee_is_static = is_static(callee);
-  bool callee_has_result = !callee->get_proto()->is_void();
-  inlined_cost = std::make_shared<InlinedCost>(get_inlined_cost(
-      callee_is_static, callee_has_result, callee->get_code()));
-  TRACE(INLINE, 4, "get_fully_inlined_cost(%s) = {%zu,%f,%f,%f,%s,%f,%zu,%zu}",
-        SHOW(callee), inlined_cost->full_code, inlined_cost->code,
-        inlined_cost->method_refs, inlined_cost->other_refs,
-        inlined_cost->no_return ? "no_return" : "return",
-        inlined_cost->result_used, inlined_cost->dead_blocks.size(),
-        inlined_cost->insn_size);
+  auto fingerprint = get_callee_fingerprint(callee);
+  if (fingerprint) {
+    inlined_cost =
+        m_inlined_cost_cache->get_fully_inlined_cost(callee, fingerprint);
+  }
+  if (!inlined_cost) {
+    bool callee_is_static = is_static(callee);
+    bool callee_has_result = !callee->get_proto()->is_void();
+    inlined_cost = std::make_shared<InlinedCost>(get_inlined_cost(
+        callee_is_static, callee_has_result, callee->get_code()));
+    TRACE(INLINE, 4,
+          "get_fully_inlined_cost(%s) = {%zu,%f,%f,%f,%s,%f,%zu,%zu}",
+          SHOW(callee), inlined_cost->full_code, inlined_cost->code,
+          inlined_cost->method_refs, inlined_cost->other_refs,
+          inlined_cost->no_return ? "no_return" : "return",
+          inlined_cost->result_used, inlined_cost->dead_blocks.size(),
+          inlined_cost->insn_size);
+    if (fingerprint) {
+      m_inlined_cost_cache->set_fully_inlined_cost(callee, fingerprint,
+                                                   *inlined_cost);
+    }
+  }
   m_fully_inlined_costs.update(
       callee,
       [&](const DexMethod*, std::shared_ptr<InlinedCost>& value, bool exists) {
@@ -1689,18 +1786,29 @@ const InlinedCost* MultiMethodInliner::get_fully_inlined_cost(
   return inlined_cost.get();
 }
 
+size_t MultiMethodInliner::get_callee_fingerprint(const DexMethod* callee) {
+  if (!m_inlined_cost_cache || !callee->get_code()->editable_cfg_built()) {
+    return 0;
+  }
+  auto fingerprint = m_callee_fingerprints.get(callee, 0);
+  if (fingerprint == 0) {
+    fingerprint = inliner::InlinedCostCache::fingerprint(callee->get_code());
+    m_callee_fingerprints.emplace(callee, fingerprint);
+  }
+  return fingerprint;
+}
+
 const InlinedCost* MultiMethodInliner::get_call_site_inlined_cost(
     const IRInstruction* invoke_insn, const DexMethod* callee) {
   auto it = m_invoke_call_site_summaries.find(invoke_insn);
   if (it == m_invoke_call_site_summaries.end()) {
     return nullptr;
   }
-  auto& call_site_summary = it->second;
-  return get_call_site_inlined_cost(call_site_summary, callee);
+  return get_call_site_inlined_cost(it->second, callee);
 }
 
 const InlinedCost* MultiMethodInliner::get_call_site_inlined_cost(
-    const CallSiteSummary& call_site_summary, const DexMethod* callee) {
+    CallSiteSummaryRef call_site_summary, const DexMethod* callee) {
   auto callee_call_site_summary_occurrences_it =
       m_callee_call_site_summary_occurrences.find(callee);
   if (callee_call_site_summary_occurrences_it ==
@@ -1713,38 +1821,52 @@ const InlinedCost* MultiMethodInliner::get_call_site_inlined_cost(
     return nullptr;
   }
 
-  auto key = show(callee) + " ** " + get_key(call_site_summary);
-  auto inlined_cost = m_call_site_inlined_costs.get(key, nullptr);
+  const auto& summary_key = call_site_summary->first;
+  auto inlined_cost =
+      m_call_site_inlined_costs.get(call_site_summary, nullptr);
   if (inlined_cost) {
     return inlined_cost.get();
   }
 
-  bool callee_is_static = is_static(callee);
-  bool callee_has_result = !callee->get_proto()->is_void();
-  inlined_cost = std::make_shared<InlinedCost>(
-      get_inlined_cost(callee_is_static, callee_has_result, callee->get_code(),
-                       &call_site_summary, &m_shrinker.get_pure_methods(),
-                       m_shrinker.get_immut_analyzer_state()));
-  TRACE(INLINE, 4,
-        "get_call_site_inlined_cost(%s) = {%zu,%f,%f,%f,%s,%f,%zu,%zu}",
-        key.c_str(), inlined_cost->full_code, inlined_cost->code,
-        inlined_cost->method_refs, inlined_cost->other_refs,
-        inlined_cost->no_return ? "no_return" : "return",
-        inlined_cost->result_used, inlined_cost->dead_blocks.size(),
-        inlined_cost->insn_size);
-  m_call_site_inlined_costs.update(key,
-                                   [&](const std::string&,
-                                       std::shared_ptr<InlinedCost>& value,
-                                       bool exists) {
-                                     if (exists) {
-                                       // We wasted some work, and some other
-                                       // thread beat us. Oh well...
-                                       always_assert(*value == *inlined_cost);
-                                       inlined_cost = value;
-                                       return;
-                                     }
-                                     value = inlined_cost;
-                                   });
+  auto fingerprint = get_callee_fingerprint(callee);
+  if (fingerprint) {
+    inlined_cost = m_inlined_cost_cache->get_call_site_inlined_cost(
+        callee, fingerprint, m_call_site_cost_context, summary_key);
+  }
+  if (!inlined_cost) {
+    bool callee_is_static = is_static(callee);
+    bool callee_has_result = !callee->get_proto()->is_void();
+    inlined_cost = std::make_shared<InlinedCost>(get_inlined_cost(
+        callee_is_static, callee_has_result, callee->get_code(),
+        &call_site_summary->second, &m_shrinker.get_pure_methods(),
+        m_shrinker.get_immut_analyzer_state()));
+    TRACE(INLINE, 4,
+          "get_call_site_inlined_cost(%s ** %s) = "
+          "{%zu,%f,%f,%f,%s,%f,%zu,%zu}",
+          SHOW(callee), summary_key.c_str(), inlined_cost->full_code,
+          inlined_cost->code, inlined_cost->method_refs,
+          inlined_cost->other_refs,
+          inlined_cost->no_return ? "no_return" : "return",
+          inlined_cost->result_used, inlined_cost->dead_blocks.size(),
+          inlined_cost->insn_size);
+    if (fingerprint) {
+      m_inlined_cost_cache->set_call_site_inlined_cost(
+          callee, fingerprint, m_call_site_cost_context, summary_key,
+          *inlined_cost);
+    }
+  }
+  m_call_site_inlined_costs.update(
+      call_site_summary,
+      [&](CallSiteSummaryRef, std::shared_ptr<InlinedCost>& value,
+          bool exists) {
+        if (exists) {
+          // We wasted some work, and some other thread beat us. Oh well...
+          always_assert(*value == *inlined_cost);
+          inlined_cost = value;
+          return;
+        }
+        value = inlined_cost;
+      });
 
   return inlined_cost.get();
 }
@@ -1784,7 +1906,7 @@ const InlinedCost* MultiMethodInliner::get_average_inlined_cost(
       always_assert(call_site_inlined_cost);
       callees_unreachable_blocks +=
           call_site_inlined_cost->dead_blocks.size() * count;
-      if (callee_has_result && !call_site_summary.result_used) {
+      if (callee_has_result && !call_site_summary->second.result_used) {
         callees_unused_results += count;
       }
       inlined_cost->code += call_site_inlined_cost->code * count;
@@ -10,6 +10,7 @@
 #include <functional>
 #include <vector>
 
+#include "InlinedCostCache.h"
 #include "PriorityThreadPoolDAGScheduler.h"
 #include "Resolver.h"
 #include "Shrinker.h"
@@ -72,7 +73,13 @@ struct InvokeCallSiteSummariesAndDeadBlocks {
   size_t dead_blocks{0};
 };
 
-using CallSiteSummaryOccurrences = std::pair<CallSiteSummary, size_t>;
+// The distinct call-site summaries of a callee, by their canonical key. All
+// call-sites with the same constant arguments share one entry, which is
+// referenced by its address, and thus also share one inlined cost.
+using CallSiteSummaries = std::unordered_map<std::string, CallSiteSummary>;
+using CallSiteSummaryRef = const CallSiteSummaries::value_type*;
+
+using CallSiteSummaryOccurrences = std::pair<CallSiteSummaryRef, size_t>;
 
 struct Inlinable {
   DexMethod* callee;
@@ -95,34 +102,6 @@ struct CalleeCallerRefs {
   size_t classes;
 };
 
-// The average or call-site specific inlined costs, depending on how it is
-// retrieved
-struct InlinedCost {
-  // Full code costs of the original callee
-  size_t full_code;
-  // Average or call-site specific code costs of the callee after pruning
-  float code;
-  // Average or call-site specific method-refs count of the callee after pruning
-  float method_refs;
-  // Average or call-site specific others-refs count of the callee after pruning
-  float other_refs;
-  // Whether all or a specific call-site is guaranteed to not return normally
-  bool no_return;
-  // Average or call-site specific value indicating whether result is used
-  float result_used;
-  // For a specific call-site, a set of known dead blocks in the callee
-  std::unordered_set<cfg::Block*> dead_blocks;
-  // Maximum or call-site specific estimated callee size after pruning
-  size_t insn_size;
-
-  bool operator==(const InlinedCost& other) {
-    return full_code == other.full_code && code == other.code &&
-           method_refs == other.method_refs && other_refs == other.other_refs &&
-           no_return == other.no_return && result_used == other.result_used &&
-           dead_blocks == other.dead_blocks && insn_size == other.insn_size;
-  }
-};
-
 /**
  * Helper class to inline a set of candidates.
  * Take a set of candidates and a scope and walk all instructions in scope
@@ -151,7 +130,8 @@ class MultiMethodInliner {
       bool analyze_and_prune_inits = false,
       const std::unordered_set<DexMethodRef*>& configured_pure_methods = {},
       const std::unordered_set<DexString*>& configured_finalish_field_names =
-          {});
+          {},
+      inliner::InlinedCostCache* inlined_cost_cache = nullptr);
 
   ~MultiMethodInliner() { delayed_invoke_direct_to_static(); }
 
@@ -347,6 +327,11 @@ class MultiMethodInliner {
    */
   bool should_inline_fast(const DexMethod* callee);
 
+  /**
+   * Gets the current number of instructions in a method, without caching.
+   */
+  static size_t get_method_size(const DexMethod* method);
+
   /**
    * Gets the number of instructions in a callee.
    */
@@ -374,6 +359,12 @@ class MultiMethodInliner {
    */
   const InlinedCost* get_fully_inlined_cost(const DexMethod* callee);
 
+  /**
+   * Fingerprint of a callee for the (optional) inlined cost cache, or 0 if
+   * the cost cache cannot be used.
+   */
+  size_t get_callee_fingerprint(const DexMethod* callee);
+
   /**
    * Estimate average inlined cost when inlining a callee, considering all
    * call-site summaries for pruning.
@@ -390,7 +381,7 @@ class MultiMethodInliner {
    * Estimate inlined cost for a particular call-site summary, if available.
    */
   const InlinedCost* get_call_site_inlined_cost(
-      const CallSiteSummary& call_site_summary, const DexMethod* callee);
+      CallSiteSummaryRef call_site_summary, const DexMethod* callee);
 
   /**
    * Change visibilities of methods, assuming that`m_change_visibility` is
@@ -485,6 +476,10 @@ class MultiMethodInliner {
 
   std::unordered_set<const DexMethod*> m_recursive_callees;
 
+  // Whether a class, or any of its ancestors, is in the configured blocklist.
+  // Computed once for the scope so that callee checks are a single lookup.
+  std::unordered_map<const DexType*, bool> m_blocklisted_types;
+
   // If mode == IntraDex, then this is the set of callees that is reachable via
   // an (otherwise ignored) invocation from a caller in a different dex. If mode
   // != IntraDex, then the set is empty.
@@ -499,11 +494,17 @@ class MultiMethodInliner {
   mutable ConcurrentMap<const DexMethod*, std::shared_ptr<InlinedCost>>
       m_average_inlined_costs;
 
-  // Cache of the inlined costs of each method and each constant-arguments key
-  // after pruning.
-  mutable ConcurrentMap<std::string, std::shared_ptr<InlinedCost>>
+  // Cache of the inlined costs of each distinct call-site summary after
+  // pruning.
+  mutable ConcurrentMap<CallSiteSummaryRef, std::shared_ptr<InlinedCost>>
       m_call_site_inlined_costs;
 
+  /**
+   * For all (reachable) invoked methods, the distinct call-site summaries
+   */
+  std::unordered_map<const DexMethod*, CallSiteSummaries>
+      m_callee_call_site_summaries;
+
   /**
    * For all (reachable) invoked methods, list of constant arguments
    */
@@ -514,7 +515,7 @@ class MultiMethodInliner {
   /**
    * For all (reachable) invoke instructions, constant arguments
    */
-  mutable ConcurrentMap<const IRInstruction*, CallSiteSummary>
+  mutable ConcurrentMap<const IRInstruction*, CallSiteSummaryRef>
       m_invoke_call_site_summaries;
 
   // Priority thread pool to handle parallel processing of methods, either
@@ -535,10 +536,12 @@ class MultiMethodInliner {
   std::mutex m_change_visibility_mutex;
 
   // Cache for should_inline function
-  ConcurrentMap<const DexMethod*, boost::optional<bool>> m_should_inline;
+  ReadMostlyConcurrentMap<const DexMethod*, boost::optional<bool>>
+      m_should_inline;
 
   // Optional cache for get_callee_insn_size function
-  std::unique_ptr<ConcurrentMap<const DexMethod*, size_t>> m_callee_insn_sizes;
+  std::unique_ptr<ReadMostlyConcurrentMap<const DexMethod*, size_t>>
+      m_callee_insn_sizes;
 
   // Optional cache for get_callee_type_refs function
   std::unique_ptr<ConcurrentMap<const DexMethod*, std::vector<DexType*>>>
@@ -562,6 +565,13 @@ class MultiMethodInliner {
     size_t max_call_stack_depth{0};
     size_t waited_seconds{0};
     int critical_path_length{0};
+    uint64_t weighted_critical_path_length{0};
+    // How well the threads were used while inlining, and while computing
+    // call-site summaries.
+    size_t utilization_percent{0};
+    size_t saturation_percent{0};
+    size_t constant_invoke_callers_utilization_percent{0};
+    size_t constant_invoke_callers_saturation_percent{0};
 
     // statistics that may be incremented concurrently
     std::atomic<size_t> calls_inlined{0};
@@ -613,6 +623,16 @@ class MultiMethodInliner {
 
   shrinker::Shrinker m_shrinker;
 
+  // Optional cost cache that outlives this inliner.
+  inliner::InlinedCostCache* m_inlined_cost_cache;
+
+  // Summary of the pure methods known to the shrinker, which call-site
+  // specific costs depend on.
+  size_t m_call_site_cost_context{0};
+
+  // Cache of callee fingerprints for m_inlined_cost_cache.
+  ConcurrentMap<const DexMethod*, size_t> m_callee_fingerprints;
+
   AccumulatingTimer m_inline_callees_timer;
   AccumulatingTimer m_inline_callees_should_inline_timer;
   AccumulatingTimer m_inline_callees_init_timer;
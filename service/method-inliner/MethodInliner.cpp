@@ -20,6 +20,7 @@
 #include "DexUtil.h"
 #include "IRCode.h"
 #include "IRInstruction.h"
+#include "InlinedCostCache.h"
 #include "Inliner.h"
 #include "LiveRange.h"
 #include "MethodOverrideGraph.h"
@@ -535,7 +536,8 @@ void run_inliner(DexStoresVector& stores,
                  PassManager& mgr,
                  ConfigFiles& conf,
                  bool intra_dex /* false */,
-                 InlineForSpeed* inline_for_speed) {
+                 InlineForSpeed* inline_for_speed /* nullptr */,
+                 std::shared_ptr<const mog::Graph> method_override_graph) {
   if (mgr.no_proguard_rules()) {
     TRACE(INLINE, 1,
           "MethodInlinePass not run because no ProGuard configuration was "
@@ -556,8 +558,9 @@ void run_inliner(DexStoresVector& stores,
 
   inliner_config.unique_inlined_registers = false;
 
-  std::unique_ptr<const mog::Graph> method_override_graph;
-  if (inliner_config.virtual_inline) {
+  if (!inliner_config.virtual_inline) {
+    method_override_graph = nullptr;
+  } else if (method_override_graph == nullptr) {
     method_override_graph = mog::build_graph(scope);
   }
 
@@ -592,11 +595,19 @@ void run_inliner(DexStoresVector& stores,
       inliner_config.shrinker.run_const_prop;
 
   // inline candidates
-  MultiMethodInliner inliner(scope, stores, candidates, concurrent_resolver,
-                             inliner_config, intra_dex ? IntraDex : InterDex,
-                             true_virtual_callers, inline_for_speed,
-                             analyze_and_prune_inits, conf.get_pure_methods());
+  auto& inlined_cost_cache = conf.get_inlined_cost_cache();
+  auto cost_cache_hits = inlined_cost_cache.hits();
+  auto cost_cache_misses = inlined_cost_cache.misses();
+  MultiMethodInliner inliner(
+      scope, stores, candidates, concurrent_resolver, inliner_config,
+      intra_dex ? IntraDex : InterDex, true_virtual_callers, inline_for_speed,
+      analyze_and_prune_inits, conf.get_pure_methods(),
+      conf.get_finalish_field_names(), &inlined_cost_cache);
   inliner.inline_methods(/* need_deconstruct */ false);
+  mgr.incr_metric("inlined_cost_cache_hits",
+                  inlined_cost_cache.hits() - cost_cache_hits);
+  mgr.incr_metric("inlined_cost_cache_misses",
+                  inlined_cost_cache.misses() - cost_cache_misses);
 
   walk::parallel::code(scope,
                        [](DexMethod*, IRCode& code) { code.clear_cfg(); });
@@ -721,9 +732,21 @@ void run_inliner(DexStoresVector& stores,
       inliner.get_info().constant_invoke_callees_unreachable_blocks);
   mgr.incr_metric("constant_invoke_callees_unused_results",
                   inliner.get_info().constant_invoke_callees_unused_results);
+  mgr.incr_metric(
+      "constant_invoke_callers_utilization_percent",
+      inliner.get_info().constant_invoke_callers_utilization_percent);
+  mgr.incr_metric(
+      "constant_invoke_callers_saturation_percent",
+      inliner.get_info().constant_invoke_callers_saturation_percent);
   mgr.incr_metric("critical_path_length",
                   inliner.get_info().critical_path_length);
+  mgr.incr_metric("weighted_critical_path_length",
+                  inliner.get_info().weighted_critical_path_length);
+  mgr.incr_metric("utilization_percent",
+                  inliner.get_info().utilization_percent);
+  mgr.incr_metric("saturation_percent", inliner.get_info().saturation_percent);
   mgr.incr_metric("methods_shrunk", shrinker.get_methods_shrunk());
+  mgr.incr_metric("shrinker_extra_rounds", shrinker.get_extra_rounds());
   mgr.incr_metric("callers", inliner.get_callers());
   if (intra_dex) {
     mgr.incr_metric("x-dex-callees", inliner.get_x_dex_callees());
@@ -5,7 +5,10 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <memory>
+
 #include "InlinerConfig.h"
+#include "MethodOverrideGraph.h"
 #include "PassManager.h"
 
 class InlineForSpeed;
@@ -15,10 +18,15 @@ namespace inliner {
  * Before InterDexPass, we can run inliner with "intra_dex=false" to do global
  * inlining. But after InterDexPass, we can only run inliner within each dex by
  * setting "intra_dex" to true.
+ *
+ * A `method_override_graph` of the whole program can be given to avoid
+ * rebuilding it when virtual inlining is enabled.
  */
 void run_inliner(DexStoresVector& stores,
                  PassManager& mgr,
                  ConfigFiles& conf,
                  bool intra_dex = false,
-                 InlineForSpeed* inline_for_speed = nullptr);
+                 InlineForSpeed* inline_for_speed = nullptr,
+                 std::shared_ptr<const method_override_graph::Graph>
+                     method_override_graph = nullptr);
 } // namespace inliner
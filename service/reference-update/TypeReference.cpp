@@ -200,7 +200,7 @@ void add_vmethod_to_groups(
     DexMethod* method,
     VMethodsGroups* groups) {
   size_t org_signature_hash = hash_signature(method);
-  auto possible_new_name = gen_new_name(method->str(), org_signature_hash);
+  auto possible_new_name = gen_new_name(method->str_copy(), org_signature_hash);
 
   auto proto = method->get_proto();
   auto rtype =
@@ -355,7 +355,7 @@ bool TypeRefUpdater::mangling(DexFieldRef* field) {
     boost::hash_combine(seed, field->get_type()->str());
     boost::hash_combine(seed, field->str());
     DexFieldSpec spec;
-    spec.name = gen_new_name(field->str(), seed);
+    spec.name = gen_new_name(field->str_copy(), seed);
     spec.type = new_type;
     field->change(spec);
     TRACE(REFU, 9, "Update field %s ", SHOW(field));
@@ -374,7 +374,7 @@ bool TypeRefUpdater::mangling(DexMethodRef* method) {
   } else { // Keep unchanged.
     rtype = proto->get_rtype();
   }
-  std::deque<DexType*> new_args;
+  DexTypeList::ContainerType new_args;
   size_t id = 0;
   for (DexType* arg : proto->get_args()->get_type_list()) {
     DexType* new_arg = try_convert_to_new_type(arg);
@@ -415,7 +415,7 @@ bool TypeRefUpdater::mangling(DexMethodRef* method) {
     DexMethodSpec spec;
     spec.proto = new_proto;
     boost::hash_combine(seed, method->str());
-    spec.name = gen_new_name(method->str(), seed);
+    spec.name = gen_new_name(method->str_copy(), seed);
     method->change(spec, false /* rename on collision */);
     TRACE(REFU, 9, "Update method %s ", SHOW(method));
   }
@@ -429,14 +429,14 @@ TypeRefUpdater::TypeRefUpdater(
 }
 
 DexString* new_name(const DexMethodRef* method) {
-  return gen_new_name(method->str(), hash_signature(method));
+  return gen_new_name(method->str_copy(), hash_signature(method));
 }
 
 DexString* new_name(const DexFieldRef* field) {
   size_t seed = 0;
   boost::hash_combine(seed, field->str());
   boost::hash_combine(seed, field->get_type()->str());
-  return gen_new_name(field->str(), seed);
+  return gen_new_name(field->str_copy(), seed);
 }
 
 std::string get_method_signature(const DexMethod* method) {
@@ -484,7 +484,7 @@ DexProto* get_new_proto(
   } else {
     rtype = proto->get_rtype();
   }
-  std::deque<DexType*> lst;
+  DexTypeList::ContainerType lst;
   for (const auto arg_type : proto->get_args()->get_type_list()) {
     auto extracted_arg_type = type::get_element_type_if_array(arg_type);
     if (old_to_new.count(extracted_arg_type) > 0) {
@@ -503,14 +503,14 @@ DexProto* get_new_proto(
 
 DexTypeList* prepend_and_make(const DexTypeList* list, DexType* new_type) {
   auto old_list = list->get_type_list();
-  auto prepended = std::deque<DexType*>(old_list.begin(), old_list.end());
-  prepended.push_front(new_type);
+  auto prepended = DexTypeList::ContainerType(old_list.begin(), old_list.end());
+  prepended.insert(prepended.begin(), new_type);
   return DexTypeList::make_type_list(std::move(prepended));
 }
 
 DexTypeList* append_and_make(const DexTypeList* list, DexType* new_type) {
   auto old_list = list->get_type_list();
-  auto appended = std::deque<DexType*>(old_list.begin(), old_list.end());
+  auto appended = DexTypeList::ContainerType(old_list.begin(), old_list.end());
   appended.push_back(new_type);
   return DexTypeList::make_type_list(std::move(appended));
 }
@@ -518,23 +518,22 @@ DexTypeList* append_and_make(const DexTypeList* list, DexType* new_type) {
 DexTypeList* append_and_make(const DexTypeList* list,
                              const std::vector<DexType*>& new_types) {
   auto old_list = list->get_type_list();
-  auto appended = std::deque<DexType*>(old_list.begin(), old_list.end());
+  auto appended = DexTypeList::ContainerType(old_list.begin(), old_list.end());
   appended.insert(appended.end(), new_types.begin(), new_types.end());
   return DexTypeList::make_type_list(std::move(appended));
 }
 
 DexTypeList* replace_head_and_make(const DexTypeList* list, DexType* new_head) {
   auto old_list = list->get_type_list();
-  auto new_list = std::deque<DexType*>(old_list.begin(), old_list.end());
+  auto new_list = DexTypeList::ContainerType(old_list.begin(), old_list.end());
   always_assert(!new_list.empty());
-  new_list.pop_front();
-  new_list.push_front(new_head);
+  new_list.front() = new_head;
   return DexTypeList::make_type_list(std::move(new_list));
 }
 
 DexTypeList* drop_and_make(const DexTypeList* list, size_t num_types_to_drop) {
   auto old_list = list->get_type_list();
-  auto dropped = std::deque<DexType*>(old_list.begin(), old_list.end());
+  auto dropped = DexTypeList::ContainerType(old_list.begin(), old_list.end());
   for (size_t i = 0; i < num_types_to_drop; ++i) {
     dropped.pop_back();
   }
@@ -18,6 +18,7 @@
 #include "Dominators.h"
 #include "IRCode.h"
 #include "Show.h"
+#include "SourceBlocks.h"
 #include "Trace.h"
 #include "Transform.h"
 #include "VirtualRegistersFile.h"
@@ -316,6 +317,8 @@ Allocator::Stats& Allocator::Stats::operator+=(const Allocator::Stats& that) {
   split_moves += that.split_moves;
   moves_coalesced += that.moves_coalesced;
   params_spill_early += that.params_spill_early;
+  cold_methods_not_split += that.cold_methods_not_split;
+  cold_spill_moves += that.cold_spill_moves;
   return *this;
 }
 
@@ -341,7 +344,8 @@ static bool has_2addr_form(IROpcode op) {
  * the larger non-2addr encoding if their assigned vregs are larger than 4
  * bits. They will be handled in the post-regalloc instruction selection phase.
  *
- * Return a bool indicating whether any coalescing was done.
+ * Return a bool indicating whether any coalescing was done, i.e. whether any
+ * symregs were merged or any moves removed.
  *
  * This is fairly similar to the implementation in [Briggs92] section 8.6.
  */
@@ -366,6 +370,7 @@ bool Allocator::coalesce(interference::Graph* ig, IRCode* code) {
   auto ii = InstructionIterable(code);
   auto end = ii.end();
   auto old_coalesce_count = m_stats.moves_coalesced;
+  bool merged_any = false;
   for (auto it = ii.begin(); it != end; ++it) {
     auto insn = it->insn;
     auto op = insn->opcode();
@@ -398,6 +403,7 @@ bool Allocator::coalesce(interference::Graph* ig, IRCode* code) {
       }
       // Merge the child's node into the parent's
       ig->combine(parent, child);
+      merged_any = true;
       TRACE(REG, 7, "Coalescing v%u and v%u because of %s", parent, child,
             SHOW(insn));
       if (opcode::is_a_move(op)) {
@@ -407,13 +413,15 @@ bool Allocator::coalesce(interference::Graph* ig, IRCode* code) {
     }
   }
 
-  transform::RegMap reg_map;
-  for (reg_t i = 0; i < code->get_registers_size(); ++i) {
-    reg_map.emplace(i, aliases.find_set(i));
+  if (merged_any) {
+    transform::RegMap reg_map;
+    for (reg_t i = 0; i < code->get_registers_size(); ++i) {
+      reg_map.emplace(i, aliases.find_set(i));
+    }
+    transform::remap_registers(code, reg_map);
   }
-  transform::remap_registers(code, reg_map);
 
-  return m_stats.moves_coalesced != old_coalesce_count;
+  return merged_any || m_stats.moves_coalesced != old_coalesce_count;
 }
 
 /*
@@ -482,8 +490,8 @@ void Allocator::simplify(interference::Graph* ig,
     // already-spilled ones. Spilling the same node twice won't make the graph
     // any easier to color.
     // In case of a tie, pick the node with the lowest ratio of
-    // spill_cost / weight. For example, if we had to pick spill candidates in
-    // the following code:
+    // weighted_spill_cost / weight, where uses in cold blocks are cheap. For
+    // example, if we had to pick spill candidates in the following code:
     //
     //   sget v0 LFoo;.a:LFoo;
     //   iget v2 v0 LFoo;.a:LBar;
@@ -504,8 +512,8 @@ void Allocator::simplify(interference::Graph* ig,
           auto& node_b = ig->get_node(b);
           if (node_a.is_spilt() == node_b.is_spilt()) {
             // Note that a / b < c / d <=> a * d < c * b.
-            return node_a.spill_cost() * node_b.weight() <
-                   node_b.spill_cost() * node_a.weight();
+            return node_a.weighted_spill_cost() * node_b.weight() <
+                   node_b.weighted_spill_cost() * node_a.weight();
           }
           return !node_a.is_spilt() && node_b.is_spilt();
         });
@@ -949,6 +957,16 @@ void Allocator::spill(const interference::Graph& ig,
                       IRCode* code) {
   // TODO: account for "close" defs and uses. See [Briggs92], section 8.7
 
+  // Moves next to these instructions are counted as cold spills.
+  std::unordered_set<const IRInstruction*> cold_insns;
+  for (auto* block : code->cfg().blocks()) {
+    if (source_blocks::is_cold(block)) {
+      for (auto& mie : InstructionIterable(block)) {
+        cold_insns.insert(mie.insn);
+      }
+    }
+  }
+
   auto ii = InstructionIterable(code);
   auto end = ii.end();
   for (auto it = ii.begin(); it != end; ++it) {
@@ -965,6 +983,7 @@ void Allocator::spill(const interference::Graph& ig,
           insn->set_src(idx, temp);
           auto mov = gen_move(node.type(), temp, src);
           ++m_stats.range_spill_moves;
+          m_stats.cold_spill_moves += cold_insns.count(insn);
           code->insert_before(it.unwrap(), mov);
         }
       }
@@ -987,6 +1006,7 @@ void Allocator::spill(const interference::Graph& ig,
           insn->set_src(i, temp);
           auto mov = gen_move(node.type(), temp, src);
           ++m_stats.global_spill_moves;
+          m_stats.cold_spill_moves += cold_insns.count(insn);
           code->insert_before(it.unwrap(), mov);
         }
       }
@@ -1000,6 +1020,7 @@ void Allocator::spill(const interference::Graph& ig,
           it.reset(code->insert_after(
               it.unwrap(), gen_move(ig.get_node(dest).type(), dest, temp)));
           ++m_stats.global_spill_moves;
+          m_stats.cold_spill_moves += cold_insns.count(insn);
         }
       }
     }
@@ -1112,11 +1133,13 @@ void Allocator::allocate(DexMethod* method) {
 
     TRACE(REG, 7, "IG:\n%s", SHOW(ig));
     if (first) {
-      coalesce(&ig, code);
       first = false;
       // After coalesce the live_out and live_in of blocks may change, so run
-      // LivenessFixpointIterator again.
-      fixpoint_iter.run(LivenessDomain());
+      // LivenessFixpointIterator again. Often nothing coalesces, e.g. in
+      // methods without moves, and the liveness computed above still holds.
+      if (coalesce(&ig, code)) {
+        fixpoint_iter.run(LivenessDomain());
+      }
       TRACE(REG, 5, "Post-coalesce:\n%s", ::SHOW(code->cfg()));
     } else {
       // TODO we should coalesce here too, but we'll need to avoid removing
@@ -1178,6 +1201,7 @@ void Allocator::allocate(DexMethod* method) {
   TRACE(REG, 3, "  Param spills: %lu", m_stats.param_spill_moves);
   TRACE(REG, 3, "  Range spills: %lu", m_stats.range_spill_moves);
   TRACE(REG, 3, "  Global spills: %lu", m_stats.global_spill_moves);
+  TRACE(REG, 3, "  In cold blocks: %lu", m_stats.cold_spill_moves);
   TRACE(REG, 3, "  splits: %lu", m_stats.split_moves);
   TRACE(REG, 3, "Coalesce count: %lu", m_stats.moves_coalesced);
   TRACE(REG, 3, "Params spilled too early: %lu", m_stats.params_spill_early);
@@ -83,6 +83,10 @@ class Allocator {
   struct Config {
     bool no_overwrite_this{false};
     bool use_splitting{false};
+    // Whether to split live ranges in methods whose entry block is cold
+    // according to source blocks. Splitting is the costliest part of the
+    // allocation loop, and its move savings matter little in cold code.
+    bool split_cold_methods{true};
   };
 
   struct Stats {
@@ -93,6 +97,9 @@ class Allocator {
     size_t split_moves{0};
     size_t moves_coalesced{0};
     size_t params_spill_early{0};
+    size_t cold_methods_not_split{0};
+    // Range and global spill moves placed in cold blocks.
+    size_t cold_spill_moves{0};
     size_t moves_inserted() const {
       return param_spill_moves + range_spill_moves + global_spill_moves +
              split_moves;
@@ -13,6 +13,7 @@
 #include "IRCode.h"
 #include "MonotonicFixpointIterator.h"
 #include "Show.h"
+#include "SourceBlocks.h"
 
 namespace regalloc {
 
@@ -89,8 +90,7 @@ void Graph::add_edge(reg_t u, reg_t v, bool can_coalesce) {
   //
   // then the final state of the edge between s0 and s1 must be
   // non-coalesceable.
-  m_adj_matrix[build_edge(u, v)] =
-      m_adj_matrix[build_edge(u, v)] || !can_coalesce;
+  m_adj_matrix.insert(u, v, !can_coalesce);
 }
 
 uint32_t Node::colorable_limit() const {
@@ -187,6 +187,7 @@ vreg_t max_value_for_src(const IRInstruction* insn,
 
 void GraphBuilder::update_node_constraints(const IRList::iterator& it,
                                            const RangeSet& range_set,
+                                           bool in_cold_block,
                                            Graph* graph) {
   auto insn = it->insn;
   auto op = insn->opcode();
@@ -202,6 +203,7 @@ void GraphBuilder::update_node_constraints(const IRList::iterator& it,
     node.m_width = insn->dest_is_wide() ? 2 : 1;
     if (max_vreg < max_unsigned_value(16)) {
       ++node.m_spill_cost;
+      node.m_cold_spill_cost += in_cold_block;
     }
   }
 
@@ -220,6 +222,7 @@ void GraphBuilder::update_node_constraints(const IRList::iterator& it,
     node.m_max_vreg = std::min(node.m_max_vreg, max_vreg);
     if (max_vreg < max_unsigned_value(16)) {
       ++node.m_spill_cost;
+      node.m_cold_spill_cost += in_cold_block;
     }
   }
 }
@@ -272,12 +275,18 @@ Graph GraphBuilder::build(const LivenessFixpointIterator& fixpoint_iter,
                           reg_t initial_regs,
                           const RangeSet& range_set) {
   Graph graph;
-  auto ii = InstructionIterable(code);
-  for (auto it = ii.begin(); it != ii.end(); ++it) {
-    GraphBuilder::update_node_constraints(it.unwrap(), range_set, &graph);
+  auto& cfg = code->cfg();
+  graph.m_adj_matrix.set_dense_bound(cfg.get_registers_size());
+  graph.m_containment_graph.set_dense_bound(cfg.get_registers_size());
+  for (cfg::Block* block : cfg.blocks()) {
+    bool in_cold_block = source_blocks::is_cold(block);
+    auto ii = InstructionIterable(block);
+    for (auto it = ii.begin(); it != ii.end(); ++it) {
+      GraphBuilder::update_node_constraints(it.unwrap(), range_set,
+                                            in_cold_block, &graph);
+    }
   }
 
-  auto& cfg = code->cfg();
   for (cfg::Block* block : cfg.blocks()) {
     LivenessDomain live_out = fixpoint_iter.get_live_out_vars_at(block);
     for (auto it = block->rbegin(); it != block->rend(); ++it) {
@@ -365,11 +374,9 @@ std::ostream& Graph::write_dot_format(std::ostream& o) const {
   o << "}\n";
 
   o << "containment graph {\n";
-  for (const auto& pair : m_containment_graph) {
-    reg_t reg1 = static_cast<reg_t>((pair & 0xFFFFFFFF00000000) >> 32);
-    reg_t reg2 = static_cast<reg_t>(pair & 0x00000000FFFFFFFF);
+  m_containment_graph.for_each([&o](reg_t reg1, reg_t reg2) {
     o << reg1 << " -- " << reg2 << "\n";
-  }
+  });
   o << "}\n";
   return o;
 }
@@ -88,6 +88,111 @@ inline reg_pair_t build_edge(reg_t u, reg_t v) {
   return (hi << (sizeof(reg_t) * 8)) | lo;
 }
 
+/*
+ * A set of register pairs, each with a boolean flag. Pairs are unordered if
+ * `kSymmetric`, ordered otherwise.
+ *
+ * Huge methods produce dense graphs with millions of edges, for which hashing
+ * every pair dominates graph construction. Once set_dense_bound(n) has been
+ * called, pairs of registers below n are kept in a packed bit-matrix instead
+ * (a triangular one if `kSymmetric`), with two bits per pair. Pairs involving
+ * other registers, and methods with too many registers for the matrix to be
+ * reasonably small, use a hash map.
+ */
+template <bool kSymmetric>
+class RegPairFlags {
+ public:
+  // Upper bound on the size of the bit-matrix.
+  static constexpr size_t kMaxDenseBits = size_t(1) << 26;
+
+  void set_dense_bound(reg_t n) {
+    always_assert(m_bits.empty() && m_sparse.empty());
+    size_t bits = 2 * num_dense_pairs(n);
+    if (bits > kMaxDenseBits) {
+      return;
+    }
+    m_dense_bound = n;
+    m_bits.resize((bits + 63) / 64);
+  }
+
+  bool contains(reg_t u, reg_t v) const {
+    if (is_dense(u, v)) {
+      return test_bit(2 * dense_index(u, v));
+    }
+    return m_sparse.count(sparse_key(u, v)) != 0;
+  }
+
+  // The flag of a pair in the set.
+  bool flag(reg_t u, reg_t v) const {
+    if (is_dense(u, v)) {
+      return test_bit(2 * dense_index(u, v) + 1);
+    }
+    return m_sparse.at(sparse_key(u, v));
+  }
+
+  // Adds the pair if absent, and sets its flag if `flag` is true.
+  void insert(reg_t u, reg_t v, bool flag) {
+    if (is_dense(u, v)) {
+      size_t idx = 2 * dense_index(u, v);
+      set_bit(idx);
+      if (flag) {
+        set_bit(idx + 1);
+      }
+      return;
+    }
+    auto& entry = m_sparse[sparse_key(u, v)];
+    entry = entry || flag;
+  }
+
+  // Calls fn(u, v) for every pair in the set.
+  template <typename Fn>
+  void for_each(const Fn& fn) const {
+    for (reg_t u = 0; u < m_dense_bound; ++u) {
+      reg_t end = kSymmetric ? u + 1 : m_dense_bound;
+      for (reg_t v = 0; v < end; ++v) {
+        if (test_bit(2 * dense_index(u, v))) {
+          fn(u, v);
+        }
+      }
+    }
+    for (const auto& pair : m_sparse) {
+      fn(static_cast<reg_t>(pair.first >> (sizeof(reg_t) * 8)),
+         static_cast<reg_t>(pair.first));
+    }
+  }
+
+ private:
+  static size_t num_dense_pairs(size_t n) {
+    return kSymmetric ? n * (n + 1) / 2 : n * n;
+  }
+
+  bool is_dense(reg_t u, reg_t v) const {
+    return u < m_dense_bound && v < m_dense_bound;
+  }
+
+  size_t dense_index(reg_t u, reg_t v) const {
+    if (kSymmetric) {
+      size_t hi = std::max(u, v);
+      size_t lo = std::min(u, v);
+      return hi * (hi + 1) / 2 + lo;
+    }
+    return size_t(u) * m_dense_bound + v;
+  }
+
+  static reg_pair_t sparse_key(reg_t u, reg_t v) {
+    return kSymmetric ? build_edge(u, v) : build_containment_edge(u, v);
+  }
+
+  bool test_bit(size_t idx) const {
+    return (m_bits[idx / 64] >> (idx % 64)) & 1;
+  }
+  void set_bit(size_t idx) { m_bits[idx / 64] |= uint64_t(1) << (idx % 64); }
+
+  reg_t m_dense_bound{0};
+  std::vector<uint64_t> m_bits;
+  std::unordered_map<reg_pair_t, bool> m_sparse;
+};
+
 } // namespace impl
 
 class Node {
@@ -127,6 +232,18 @@ class Node {
    */
   uint32_t spill_cost() const { return m_spill_cost; }
 
+  /*
+   * The spill cost with the moves that would land in blocks not known to be
+   * cold counted kNonColdSpillWeight times, so that among otherwise similar
+   * candidates we spill the live ranges that are mostly used in cold code.
+   * Without profile data, this is just a multiple of spill_cost().
+   */
+  static constexpr uint64_t kNonColdSpillWeight = 16;
+  uint64_t weighted_spill_cost() const {
+    return uint64_t(m_spill_cost - m_cold_spill_cost) * kNonColdSpillWeight +
+           m_cold_spill_cost;
+  }
+
   /*
    * The maximum vreg this node can be mapped to without spilling. Since
    * different opcodes have different maximums, this ends up being a per-node
@@ -158,6 +275,7 @@ class Node {
  private:
   uint32_t m_weight{0};
   uint32_t m_spill_cost{0};
+  uint32_t m_cold_spill_cost{0};
   vreg_t m_max_vreg{max_unsigned_value(16)};
   // While the width is implicit in the register type, looking up the type to
   // determine the width is a little more expensive than storing the width
@@ -191,16 +309,15 @@ class Graph {
   }
 
   bool is_adjacent(reg_t u, reg_t v) const {
-    return m_adj_matrix.find(impl::build_edge(u, v)) != m_adj_matrix.end();
+    return m_adj_matrix.contains(u, v);
   }
 
   bool is_coalesceable(reg_t u, reg_t v) const {
-    return !is_adjacent(u, v) || !m_adj_matrix.at(impl::build_edge(u, v));
+    return !is_adjacent(u, v) || !m_adj_matrix.flag(u, v);
   }
 
   bool has_containment_edge(reg_t u, reg_t v) const {
-    return m_containment_graph.find(impl::build_containment_edge(u, v)) !=
-           m_containment_graph.end();
+    return m_containment_graph.contains(u, v);
   }
 
   /*
@@ -233,13 +350,14 @@ class Graph {
     if (u == v) {
       return;
     }
-    m_containment_graph.emplace(impl::build_containment_edge(u, v));
+    m_containment_graph.insert(u, v, false);
   }
 
  private:
   std::unordered_map<reg_t, Node> m_nodes;
-  std::unordered_map<reg_pair_t, bool> m_adj_matrix;
-  std::unordered_set<reg_pair_t> m_containment_graph;
+  // The flag of an edge is set if it is not coalesceable.
+  impl::RegPairFlags</* kSymmetric */ true> m_adj_matrix;
+  impl::RegPairFlags</* kSymmetric */ false> m_containment_graph;
   // This map contains the LivenessDomains for all instructions which could
   // potentialy take on the /range format.
   std::unordered_map<IRInstruction*, LivenessDomain> m_range_liveness;
@@ -274,6 +392,7 @@ inline uint32_t div_ceil(uint32_t a, uint32_t b) { return (a + b - 1) / b; }
 class GraphBuilder {
   static void update_node_constraints(const IRList::iterator&,
                                       const RangeSet&,
+                                      bool in_cold_block,
                                       Graph*);
 
  public:
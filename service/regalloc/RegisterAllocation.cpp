@@ -19,6 +19,7 @@
 #include "LiveRange.h"
 #include "PassManager.h"
 #include "Show.h"
+#include "SourceBlocks.h"
 #include "Trace.h"
 #include "Walkers.h"
 
@@ -41,11 +42,19 @@ Stats allocate(const Config& allocator_config, DexMethod* m) {
     // The transformations below all require a CFG. Build it once
     // here instead of requiring each transform to build it.
     code.build_cfg(/* editable */ false);
-    Allocator allocator(allocator_config);
+    Config config = allocator_config;
+    bool cold_not_split = config.use_splitting && !config.split_cold_methods &&
+                          source_blocks::is_cold(code.cfg().entry_block());
+    if (cold_not_split) {
+      config.use_splitting = false;
+    }
+    Allocator allocator(config);
     allocator.allocate(m);
     TRACE(REG, 5, "After alloc: regs:%d code:\n%s", code.get_registers_size(),
           SHOW(&code));
-    return allocator.get_stats();
+    auto stats = allocator.get_stats();
+    stats.cold_methods_not_split = cold_not_split ? 1 : 0;
+    return stats;
   } catch (const std::exception& e) {
     std::cerr << "Failed to allocate " << SHOW(m) << ": " << e.what()
               << std::endl;
@@ -7,11 +7,14 @@
 
 #include "Shrinker.h"
 
+#include <boost/functional/hash.hpp>
+
 #include "ConstructorParams.h"
 #include "LinearScan.h"
 #include "RandomForest.h"
 #include "RegisterAllocation.h"
 #include "ScopedMetrics.h"
+#include "SourceBlocks.h"
 #include "Trace.h"
 
 namespace shrinker {
@@ -68,6 +71,55 @@ bool should_shrink(IRCode* code, const Shrinker::ShrinkerForest& forest) {
       (uint32_t)regs, (uint32_t)insn, (uint32_t)blocks, (uint32_t)edges});
 }
 
+bool has_conditional_branches(cfg::ControlFlowGraph& cfg) {
+  for (auto* block : cfg.blocks()) {
+    auto branchingness = block->branchingness();
+    if (branchingness == opcode::BRANCH_IF ||
+        branchingness == opcode::BRANCH_SWITCH) {
+      return true;
+    }
+  }
+  return false;
+}
+
+using CodeFingerprint = std::pair<size_t, size_t>;
+
+// The number of instructions, and a hash of the registers and instructions.
+CodeFingerprint fingerprint(IRCode* code) {
+  size_t count = 0;
+  size_t hash = 0;
+  auto add = [&](const auto& insns, size_t registers_size) {
+    boost::hash_combine(hash, registers_size);
+    for (const auto& mie : insns) {
+      boost::hash_combine(hash, mie.insn->hash());
+      ++count;
+    }
+  };
+  if (code->editable_cfg_built()) {
+    auto& cfg = code->cfg();
+    add(InstructionIterable(cfg), cfg.get_registers_size());
+  } else {
+    add(InstructionIterable(code), code->get_registers_size());
+  }
+  return {count, hash};
+}
+
+// Whether the profiles say that the method was never executed.
+bool is_cold(IRCode* code) {
+  if (code->editable_cfg_built()) {
+    return source_blocks::is_cold(code->cfg().entry_block());
+  }
+  for (const auto& mie : *code) {
+    if (mie.type == MFLOW_SOURCE_BLOCK) {
+      return source_blocks::is_cold(mie.src_block.get());
+    }
+    if (mie.type == MFLOW_OPCODE) {
+      break;
+    }
+  }
+  return false;
+}
+
 } // namespace
 
 Shrinker::Shrinker(
@@ -120,7 +172,7 @@ Shrinker::Shrinker(
   }
 }
 
-void Shrinker::shrink_method(DexMethod* method) {
+bool Shrinker::shrink_method_round(DexMethod* method) {
   auto code = method->get_code();
   bool editable_cfg_built = code->editable_cfg_built();
 
@@ -155,7 +207,10 @@ void Shrinker::shrink_method(DexMethod* method) {
     always_assert(!code->editable_cfg_built());
     code->build_cfg(/* editable */ true);
     code->cfg().calculate_exit_block();
-    {
+    // The second round only forwards branch targets. Without conditional
+    // branches left, all it could do is skip over blocks of dead
+    // assignments, which local DCE cleans up just as well.
+    if (!m_config.run_local_dce || has_conditional_branches(code->cfg())) {
       constant_propagation::intraprocedural::FixpointIterator fp_iter(
           code->cfg(),
           constant_propagation::ConstantPrimitiveAndBoxedAnalyzer(
@@ -169,12 +224,15 @@ void Shrinker::shrink_method(DexMethod* method) {
     }
   }
 
+  // CSE, copy propagation and local DCE all work on the same editable CFG,
+  // which stays around until register allocation.
+  if ((m_config.run_cse || m_config.run_copy_prop || m_config.run_local_dce) &&
+      !code->editable_cfg_built()) {
+    code->build_cfg(/* editable */ true);
+  }
+
   if (m_config.run_cse) {
     auto timer = m_cse_timer.scope();
-    if (!code->editable_cfg_built()) {
-      code->build_cfg(/* editable */ true);
-    }
-
     cse_impl::CommonSubexpressionElimination cse(
         m_cse_shared_state.get(), code->cfg(), is_static(method),
         method::is_init(method) || method::is_clinit(method),
@@ -192,9 +250,8 @@ void Shrinker::shrink_method(DexMethod* method) {
 
   if (m_config.run_local_dce) {
     auto timer = m_local_dce_timer.scope();
-    // LocalDce doesn't care if editable_cfg_built
     auto local_dce = LocalDce(m_pure_methods);
-    local_dce.dce(code);
+    local_dce.dce(code->cfg());
     local_dce_stats = local_dce.get_stats();
   }
 
@@ -258,10 +315,13 @@ void Shrinker::shrink_method(DexMethod* method) {
       code->build_cfg(/* editable */ true);
     }
 
-    dedup_blocks_impl::Config config;
-    dedup_blocks_impl::DedupBlocks dedup_blocks(&config, method);
-    dedup_blocks.run();
-    dedup_blocks_stats = dedup_blocks.get_stats();
+    // There is nothing to deduplicate within a single block.
+    if (code->cfg().num_blocks() > 1) {
+      dedup_blocks_impl::Config config;
+      dedup_blocks_impl::DedupBlocks dedup_blocks(&config, method);
+      dedup_blocks.run();
+      dedup_blocks_stats = dedup_blocks.get_stats();
+    }
   }
 
   auto data_after_dedup = get_features(kMMINLDataCollectionLevel);
@@ -287,8 +347,35 @@ void Shrinker::shrink_method(DexMethod* method) {
   m_copy_prop_stats += copy_prop_stats;
   m_local_dce_stats += local_dce_stats;
   m_dedup_blocks_stats += dedup_blocks_stats;
+  return reg_alloc_inc != 0;
+}
+
+void Shrinker::shrink_method(DexMethod* method) {
+  auto code = method->get_code();
+  size_t max_rounds = m_config.max_rounds;
+  if (max_rounds > 1 && is_cold(code)) {
+    max_rounds = 1;
+  }
+  bool reg_alloced = false;
+  size_t rounds = 0;
+  auto before = max_rounds > 1 ? fingerprint(code) : CodeFingerprint{};
+  while (rounds < max_rounds) {
+    reg_alloced |= shrink_method_round(method);
+    ++rounds;
+    if (rounds == max_rounds) {
+      break;
+    }
+    auto after = fingerprint(code);
+    if (after == before) {
+      break;
+    }
+    before = after;
+  }
+
+  std::lock_guard<std::mutex> guard(m_stats_mutex);
   m_methods_shrunk++;
-  m_methods_reg_alloced += reg_alloc_inc;
+  m_methods_reg_alloced += reg_alloced ? 1 : 0;
+  m_extra_rounds += rounds - 1;
 }
 
 void Shrinker::log_metrics(ScopedMetrics& sm) const {
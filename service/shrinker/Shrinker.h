@@ -50,6 +50,8 @@ class Shrinker {
   }
   size_t get_methods_shrunk() const { return m_methods_shrunk; }
   size_t get_methods_reg_alloced() const { return m_methods_reg_alloced; }
+  // The number of rounds beyond the first one, see ShrinkerConfig::max_rounds.
+  size_t get_extra_rounds() const { return m_extra_rounds; }
 
   bool enabled() const { return m_enabled; }
 
@@ -101,6 +103,10 @@ class Shrinker {
   void log_metrics(ScopedMetrics& sm) const;
 
  private:
+  // Runs all enabled stages once, and returns whether registers were
+  // reallocated.
+  bool shrink_method_round(DexMethod* method);
+
   ShrinkerForest m_forest;
   const XStoreRefs m_xstores;
   const ShrinkerConfig m_config;
@@ -128,6 +134,7 @@ class Shrinker {
   AccumulatingTimer m_fast_reg_alloc_timer;
   size_t m_methods_shrunk{0};
   size_t m_methods_reg_alloced{0};
+  size_t m_extra_rounds{0};
 };
 
 } // namespace shrinker
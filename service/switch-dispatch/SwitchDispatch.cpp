@@ -478,8 +478,8 @@ DexMethodRef* create_dispatch_method_ref(
   }
   auto cls = first_method->get_class();
   auto dispatch_proto = append_int_arg(first_method->get_proto());
-  auto dispatch_name =
-      dispatch::gen_dispatch_name(cls, dispatch_proto, first_method->str());
+  auto dispatch_name = dispatch::gen_dispatch_name(cls, dispatch_proto,
+                                                  first_method->str_copy());
   return DexMethod::make_method(cls, dispatch_name, dispatch_proto);
 }
 #undef LOG_AND_RETURN
@@ -648,7 +648,8 @@ DexString* gen_dispatch_name(DexType* owner,
   size_t count = 0;
   while (true) {
     auto suffix = "$" + std::to_string(count);
-    auto dispatch_name = DexString::make_string(simple_name->str() + suffix);
+    auto dispatch_name =
+        DexString::make_string(simple_name->str_copy() + suffix);
     auto existing_meth = DexMethod::get_method(owner, dispatch_name, proto);
     if (existing_meth == nullptr) {
       return dispatch_name;
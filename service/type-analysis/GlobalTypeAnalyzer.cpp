@@ -398,8 +398,13 @@ void GlobalTypeAnalysis::find_any_init_reachables(
 std::unique_ptr<GlobalTypeAnalyzer> GlobalTypeAnalysis::analyze(
     const Scope& scope) {
   auto method_override_graph = mog::build_graph(scope);
+  return analyze(scope, *method_override_graph);
+}
+
+std::unique_ptr<GlobalTypeAnalyzer> GlobalTypeAnalysis::analyze(
+    const Scope& scope, const mog::Graph& method_override_graph) {
   call_graph::Graph cg =
-      call_graph::single_callee_graph(*method_override_graph, scope);
+      call_graph::single_callee_graph(method_override_graph, scope);
   // Rebuild all CFGs here -- this should be more efficient than doing them
   // within FixpointIterator::analyze_node(), since that can get called
   // multiple times for a given method
@@ -409,7 +414,7 @@ std::unique_ptr<GlobalTypeAnalyzer> GlobalTypeAnalysis::analyze(
     }
     code.cfg().calculate_exit_block();
   });
-  find_any_init_reachables(*method_override_graph, scope, cg);
+  find_any_init_reachables(method_override_graph, scope, cg);
 
   // Run the bootstrap. All field value and method return values are
   // represented by Top.
@@ -417,7 +422,7 @@ std::unique_ptr<GlobalTypeAnalyzer> GlobalTypeAnalysis::analyze(
   auto gta = std::make_unique<GlobalTypeAnalyzer>(cg);
   gta->run({{CURRENT_PARTITION_LABEL, ArgumentTypeEnvironment()}});
   auto non_true_virtuals =
-      mog::get_non_true_virtuals(*method_override_graph, scope);
+      mog::get_non_true_virtuals(method_override_graph, scope);
   size_t iteration_cnt = 0;
 
   for (size_t i = 0; i < m_max_global_analysis_iteration; ++i) {
@@ -117,6 +117,10 @@ class GlobalTypeAnalysis {
 
   std::unique_ptr<GlobalTypeAnalyzer> analyze(const Scope&);
 
+  // Uses an existing method override graph of the scope.
+  std::unique_ptr<GlobalTypeAnalyzer> analyze(
+      const Scope&, const method_override_graph::Graph& method_override_graph);
+
  private:
   size_t m_max_global_analysis_iteration;
   // Methods reachable from clinit that read static fields and reachable from
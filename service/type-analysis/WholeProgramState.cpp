@@ -228,8 +228,10 @@ void WholeProgramState::analyze_clinits_and_ctors(
 
 void WholeProgramState::collect(const Scope& scope,
                                 const global::GlobalTypeAnalyzer& gta) {
-  ConcurrentMap<const DexField*, std::vector<DexTypeDomain>> fields_tmp;
-  ConcurrentMap<const DexMethod*, std::vector<DexTypeDomain>> methods_tmp;
+  // Types are joined as they are collected, so that there is a single type
+  // per member to join into the partitions.
+  ConcurrentMap<const DexField*, DexTypeDomain> fields_tmp;
+  ConcurrentMap<const DexMethod*, DexTypeDomain> methods_tmp;
 
   walk::parallel::methods(scope, [&](DexMethod* method) {
     IRCode* code = method->get_code();
@@ -252,25 +254,23 @@ void WholeProgramState::collect(const Scope& scope,
     }
   });
   for (const auto& pair : fields_tmp) {
-    for (auto& type : pair.second) {
-      m_field_partition.update(pair.first, [&type](auto* current_type) {
-        current_type->join_with(type);
-      });
-    }
+    const auto& type = pair.second;
+    m_field_partition.update(pair.first, [&type](auto* current_type) {
+      current_type->join_with(type);
+    });
   }
   for (const auto& pair : methods_tmp) {
-    for (auto& type : pair.second) {
-      m_method_partition.update(pair.first, [&type](auto* current_type) {
-        current_type->join_with(type);
-      });
-    }
+    const auto& type = pair.second;
+    m_method_partition.update(pair.first, [&type](auto* current_type) {
+      current_type->join_with(type);
+    });
   }
 }
 
 void WholeProgramState::collect_field_types(
     const IRInstruction* insn,
     const DexTypeEnvironment& env,
-    ConcurrentMap<const DexField*, std::vector<DexTypeDomain>>* field_tmp) {
+    ConcurrentMap<const DexField*, DexTypeDomain>* field_tmp) {
   if (!opcode::is_an_sput(insn->opcode()) &&
       !opcode::is_an_iput(insn->opcode())) {
     return;
@@ -285,17 +285,21 @@ void WholeProgramState::collect_field_types(
     ss << type;
     TRACE(TYPE, 5, "collecting field %s -> %s", SHOW(field), ss.str().c_str());
   }
-  field_tmp->update(field,
-                    [type](const DexField*,
-                           std::vector<DexTypeDomain>& s,
-                           bool /* exists */) { s.emplace_back(type); });
+  field_tmp->update(
+      field, [&type](const DexField*, DexTypeDomain& s, bool exists) {
+        if (exists) {
+          s.join_with(type);
+        } else {
+          s = type;
+        }
+      });
 }
 
 void WholeProgramState::collect_return_types(
     const IRInstruction* insn,
     const DexTypeEnvironment& env,
     const DexMethod* method,
-    ConcurrentMap<const DexMethod*, std::vector<DexTypeDomain>>* method_tmp) {
+    ConcurrentMap<const DexMethod*, DexTypeDomain>* method_tmp) {
   auto op = insn->opcode();
   if (!opcode::is_a_return(op)) {
     return;
@@ -306,17 +310,20 @@ void WholeProgramState::collect_return_types(
     // this tells us that the code following any invoke of this method is
     // reachable.
     method_tmp->update(
-        method,
-        [](const DexMethod*, std::vector<DexTypeDomain>& s, bool /* exists */) {
-          s.emplace_back(DexTypeDomain::top());
+        method, [](const DexMethod*, DexTypeDomain& s, bool /* exists */) {
+          s = DexTypeDomain::top();
         });
     return;
   }
   auto type = env.get(insn->src(0));
-  method_tmp->update(method,
-                     [type](const DexMethod*,
-                            std::vector<DexTypeDomain>& s,
-                            bool /* exists */) { s.emplace_back(type); });
+  method_tmp->update(
+      method, [&type](const DexMethod*, DexTypeDomain& s, bool exists) {
+        if (exists) {
+          s.join_with(type);
+        } else {
+          s = type;
+        }
+      });
 }
 
 bool WholeProgramState::is_reachable(const global::GlobalTypeAnalyzer& gta,
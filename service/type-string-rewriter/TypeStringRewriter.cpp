@@ -7,8 +7,10 @@
 
 #include "TypeStringRewriter.h"
 
+#include "ConcurrentContainers.h"
 #include "Trace.h"
 #include "Walkers.h"
+#include "WorkQueue.h"
 
 namespace {
 
@@ -29,7 +31,7 @@ DexString* lookup_signature_annotation(const rewriter::TypeStringMap& mapping,
                                        DexString* anno) {
   bool has_bracket = false;
   bool added_semicolon = false;
-  std::string anno_str = anno->str();
+  std::string anno_str = anno->str_copy();
 
   // anno_str is some arbitrary segment of a full signature. We rely on standard
   // dexer behavior that keeps types mostly-intact.
@@ -87,7 +89,7 @@ DexString* lookup_signature_annotation(const rewriter::TypeStringMap& mapping,
     return obfu;
   }
   // We need to transform back to the old_name format of the input
-  std::string obfu_str = obfu->str();
+  std::string obfu_str = obfu->str_copy();
   if (added_semicolon) {
     always_assert(obfu_str.back() == ';');
     obfu_str.pop_back();
@@ -114,6 +116,80 @@ DexString* make_array(const DexString* name, uint32_t level) {
   array.append(name->str());
   return DexString::make_string(array);
 }
+
+/*
+ * The new string for a const-string literal naming a type, e.g.
+ * "com.facebook.TypeXYZ" => "X.A", or null if the literal is left as is.
+ */
+DexString* lookup_string_literal(const rewriter::TypeStringMap& mapping,
+                                 DexString* old_str) {
+  DexString* internal_str = DexString::get_string(
+      java_names::external_to_internal(old_str->str_copy()));
+  if (!internal_str || !DexType::get_type(internal_str)) {
+    return nullptr;
+  }
+  auto new_type_name = mapping.get_new_type_name(internal_str);
+  if (!new_type_name) {
+    return nullptr;
+  }
+  return DexString::make_string(
+      java_names::internal_to_external(new_type_name->str_copy()));
+}
+
+/*
+ * The same strings are referenced from many places, so we resolve each
+ * distinct string only once, in parallel. Only strings with a replacement are
+ * kept.
+ */
+template <typename Lookup>
+ConcurrentMap<DexString*, DexString*> resolve_strings(
+    const ConcurrentSet<DexString*>& strings, const Lookup& lookup) {
+  ConcurrentMap<DexString*, DexString*> replacements;
+  workqueue_run<DexString*>(
+      [&](DexString* old_str) {
+        DexString* new_str = lookup(old_str);
+        if (new_str != nullptr) {
+          replacements.emplace(old_str, new_str);
+        }
+      },
+      std::vector<DexString*>(strings.begin(), strings.end()));
+  return replacements;
+}
+
+/*
+ * Calls the given function on the string values of the arrays of
+ * dalvik.annotation.Signature annotations.
+ */
+template <typename Fn>
+void walk_signature_strings(const Scope& scope, const Fn& fn) {
+  static DexType* dalviksig =
+      DexType::get_type("Ldalvik/annotation/Signature;");
+  walk::parallel::annotations(scope, [&](DexAnnotation* anno) {
+    if (anno->type() != dalviksig) return;
+    auto elems = anno->anno_elems();
+    for (auto elem : elems) {
+      auto ev = elem.encoded_value;
+      if (ev->evtype() != DEVT_ARRAY) continue;
+      auto arrayev = static_cast<DexEncodedValueArray*>(ev);
+      auto const& evs = arrayev->evalues();
+      for (auto strev : *evs) {
+        if (strev->evtype() != DEVT_STRING) continue;
+        fn(static_cast<DexEncodedValueString*>(strev));
+      }
+    }
+  });
+}
+
+template <typename Fn>
+void walk_const_strings(const Scope& scope, const Fn& fn) {
+  walk::parallel::code(scope, [&](DexMethod*, IRCode& code) {
+    for (const auto& mie : InstructionIterable(code)) {
+      if (mie.insn->opcode() == OPCODE_CONST_STRING) {
+        fn(mie.insn);
+      }
+    }
+  });
+}
 } // namespace
 
 namespace rewriter {
@@ -128,6 +204,7 @@ TypeStringMap::TypeStringMap(
 void TypeStringMap::add_type_name(DexString* old_name, DexString* new_name) {
   always_assert(old_name && new_name);
   m_type_name_map[old_name] = new_name;
+  m_new_type_names[old_name] = new_name;
   if (old_name->str()[0] != '[') {
     return;
   }
@@ -139,11 +216,12 @@ void TypeStringMap::add_type_name(DexString* old_name, DexString* new_name) {
   old_name = DexString::make_string(old_name->c_str() + old_level);
   new_name = DexString::make_string(new_name->c_str() + new_level);
   m_type_name_map[old_name] = new_name;
+  m_new_type_names[old_name] = new_name;
 }
 
 DexString* TypeStringMap::get_new_type_name(DexString* old_name) const {
-  auto it = m_type_name_map.find(old_name);
-  if (it != m_type_name_map.end()) {
+  auto it = m_new_type_names.find(old_name);
+  if (it != m_new_type_names.end()) {
     return it->second;
   }
   auto level = get_array_level(old_name);
@@ -154,8 +232,8 @@ DexString* TypeStringMap::get_new_type_name(DexString* old_name) const {
   if (old_name == nullptr) {
     return nullptr;
   }
-  it = m_type_name_map.find(old_name);
-  if (it != m_type_name_map.end()) {
+  it = m_new_type_names.find(old_name);
+  if (it != m_new_type_names.end()) {
     return make_array(it->second, level);
   }
   return nullptr;
@@ -163,60 +241,53 @@ DexString* TypeStringMap::get_new_type_name(DexString* old_name) const {
 
 void rewrite_dalvik_annotation_signature(const Scope& scope,
                                          const TypeStringMap& mapping) {
-  static DexType* dalviksig =
-      DexType::get_type("Ldalvik/annotation/Signature;");
-  walk::parallel::annotations(scope, [&](DexAnnotation* anno) {
-    if (anno->type() != dalviksig) return;
-    auto elems = anno->anno_elems();
-    for (auto elem : elems) {
-      auto ev = elem.encoded_value;
-      if (ev->evtype() != DEVT_ARRAY) continue;
-      auto arrayev = static_cast<DexEncodedValueArray*>(ev);
-      auto const& evs = arrayev->evalues();
-      for (auto strev : *evs) {
-        if (strev->evtype() != DEVT_STRING) continue;
-        auto stringev = static_cast<DexEncodedValueString*>(strev);
-        DexString* old_str = stringev->string();
-        DexString* new_str = lookup_signature_annotation(mapping, old_str);
-        if (new_str != nullptr) {
-          TRACE(RENAME, 5, "Rewriting Signature from '%s' to '%s'",
-                old_str->c_str(), new_str->c_str());
-          stringev->string(new_str);
-        }
-      }
+  ConcurrentSet<DexString*> strings;
+  walk_signature_strings(scope, [&](DexEncodedValueString* stringev) {
+    strings.insert(stringev->string());
+  });
+  auto replacements = resolve_strings(strings, [&](DexString* old_str) {
+    return lookup_signature_annotation(mapping, old_str);
+  });
+  if (replacements.size() == 0) {
+    return;
+  }
+  walk_signature_strings(scope, [&](DexEncodedValueString* stringev) {
+    DexString* old_str = stringev->string();
+    DexString* new_str = replacements.get(old_str, nullptr);
+    if (new_str != nullptr) {
+      TRACE(RENAME, 5, "Rewriting Signature from '%s' to '%s'",
+            old_str->c_str(), new_str->c_str());
+      stringev->string(new_str);
     }
   });
 }
 
 uint32_t rewrite_string_literal_instructions(const Scope& scope,
                                              const TypeStringMap& mapping) {
+  ConcurrentSet<DexString*> strings;
+  walk_const_strings(scope, [&](IRInstruction* insn) {
+    strings.insert(insn->get_string());
+  });
+  auto replacements = resolve_strings(strings, [&](DexString* old_str) {
+    return lookup_string_literal(mapping, old_str);
+  });
+  if (replacements.size() == 0) {
+    return 0;
+  }
   std::atomic<uint32_t> total_updates(0);
-  walk::parallel::code(scope, [&](DexMethod* meth, IRCode& code) {
-    for (const auto& mie : InstructionIterable(code)) {
-      auto insn = mie.insn;
-      if (insn->opcode() != OPCODE_CONST_STRING) {
-        continue;
-      }
-      DexString* old_str = insn->get_string();
-      DexString* internal_str = DexString::get_string(
-          java_names::external_to_internal(old_str->str()));
-      if (!internal_str || !DexType::get_type(internal_str)) {
-        continue;
-      }
-      auto new_type_name = mapping.get_new_type_name(internal_str);
-      if (!new_type_name) {
-        continue;
-      }
-      auto new_str = DexString::make_string(
-          java_names::internal_to_external(new_type_name->str()));
-      insn->set_string(new_str);
-      total_updates++;
-      TRACE(RENAME,
-            5,
-            "Replace const-string from %s to %s",
-            old_str->c_str(),
-            new_str->c_str());
+  walk_const_strings(scope, [&](IRInstruction* insn) {
+    DexString* old_str = insn->get_string();
+    DexString* new_str = replacements.get(old_str, nullptr);
+    if (new_str == nullptr) {
+      return;
     }
+    insn->set_string(new_str);
+    total_updates++;
+    TRACE(RENAME,
+          5,
+          "Replace const-string from %s to %s",
+          old_str->c_str(),
+          new_str->c_str());
   });
   return total_updates.load();
 }
@@ -19,6 +19,9 @@ namespace rewriter {
 
 class TypeStringMap {
   std::map<DexString*, DexString*, dexstrings_comparator> m_type_name_map;
+  // Same mapping, for lookups. Strings are interned, so pointers can be
+  // hashed instead of comparing contents.
+  std::unordered_map<const DexString*, DexString*> m_new_type_names;
 
  public:
   TypeStringMap() {}
@@ -42,6 +45,9 @@ class TypeStringMap {
 /**
  * dalvik.annotation.Signature annotations store class names as strings, when we
  * rename these classes, we should update the strings properly at the same time.
+ *
+ * Like rewrite_string_literal_instructions, this first resolves each distinct
+ * string in parallel, and then applies the replacements in a parallel walk.
  */
 void rewrite_dalvik_annotation_signature(const Scope& scope,
                                          const TypeStringMap& mapping);
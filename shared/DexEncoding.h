@@ -8,6 +8,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <string.h>
 #include <string>
 
 namespace dex_encoding {
@@ -187,18 +188,53 @@ inline uint32_t mutf8_next_code_point(const char*& s) {
   dex_encoding::details::throw_invalid("Invalid size encoding mutf8 string");
 }
 
-inline uint32_t length_of_utf8_string(const char* s) {
-  if (s == nullptr) {
-    return 0;
+/*
+ * Returns the length of the run of ASCII bytes at the start of the given
+ * `size` bytes. Runs of ASCII are checked a word at a time, which is where
+ * most of the time goes for the mostly-ASCII strings found in dex files.
+ */
+inline size_t mutf8_ascii_prefix_length(const char* s, size_t size) {
+  constexpr uint64_t kHighBits = 0x8080808080808080ull;
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, s + i, sizeof(word));
+    if (word & kHighBits) {
+      break;
+    }
+  }
+  while (i < size && !(s[i] & 0x80)) {
+    ++i;
   }
+  return i;
+}
+
+/*
+ * Returns the number of code points in the MUTF-8 string `s` of `size` bytes,
+ * not counting the terminating null byte.
+ */
+inline uint32_t length_of_utf8_string(const char* s, size_t size) {
+  const char* end = s + size;
   uint32_t len = 0;
-  while (*s != '\0') {
-    ++len;
-    mutf8_next_code_point(s);
+  while (s < end) {
+    size_t ascii = mutf8_ascii_prefix_length(s, end - s);
+    len += ascii;
+    s += ascii;
+    if (s < end) {
+      ++len;
+      mutf8_next_code_point(s);
+    }
   }
   return len;
 }
 
+inline uint32_t length_of_utf8_string(const char* s) {
+  if (s == nullptr) {
+    return 0;
+  }
+  return length_of_utf8_string(s, strlen(s));
+}
+
 // https://docs.oracle.com/javase/8/docs/api/java/lang/String.html#hashCode--
 inline int32_t java_hashcode_of_utf8_string(const char* s) {
   if (s == nullptr) {
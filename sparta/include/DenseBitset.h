@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <ostream>
+#include <type_traits>
+
+#include <boost/container/small_vector.hpp>
+
+namespace sparta {
+
+/*
+ * A set of small unsigned integers, represented as a bit vector. This is much
+ * faster than a PatriciaTreeSet when the universe of elements is small and
+ * densely used, like the registers of a method: set operations work on a whole
+ * word of elements at a time, in loops that compilers readily vectorize.
+ *
+ * The bit vector grows on demand to hold the largest element ever inserted.
+ * Bit vectors for up to 256 elements are stored inline, so that the sets of a
+ * typical method don't allocate at all.
+ *
+ * Iteration enumerates the elements in increasing order.
+ */
+template <typename Element>
+class DenseBitset final {
+  static_assert(std::is_unsigned<Element>::value,
+                "DenseBitset only supports unsigned integer elements");
+
+  using Word = uint64_t;
+  static constexpr size_t BITS_PER_WORD = 64;
+  static constexpr size_t INLINE_WORDS = 4;
+  using Words = boost::container::small_vector<Word, INLINE_WORDS>;
+
+ public:
+  class iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Element;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Element*;
+    using reference = const Element&;
+
+    iterator() = default;
+
+    iterator(const Words* words, size_t index)
+        : m_words(words), m_index(index) {
+      if (m_index < m_words->size()) {
+        m_current = (*m_words)[m_index];
+        skip_empty_words();
+      }
+    }
+
+    iterator& operator++() {
+      m_current &= m_current - 1;
+      skip_empty_words();
+      return *this;
+    }
+
+    iterator operator++(int) {
+      iterator result = *this;
+      ++(*this);
+      return result;
+    }
+
+    reference operator*() const {
+      m_element = static_cast<Element>(m_index * BITS_PER_WORD +
+                                       __builtin_ctzll(m_current));
+      return m_element;
+    }
+
+    bool operator==(const iterator& other) const {
+      return m_index == other.m_index && m_current == other.m_current;
+    }
+
+    bool operator!=(const iterator& other) const { return !(*this == other); }
+
+   private:
+    void skip_empty_words() {
+      while (m_current == 0 && ++m_index < m_words->size()) {
+        m_current = (*m_words)[m_index];
+      }
+      if (m_current == 0) {
+        m_index = m_words->size();
+      }
+    }
+
+    const Words* m_words{nullptr};
+    size_t m_index{0};
+    Word m_current{0};
+    mutable Element m_element{0};
+  };
+
+  using value_type = Element;
+  using const_iterator = iterator;
+
+  DenseBitset() = default;
+
+  DenseBitset(std::initializer_list<Element> l) {
+    for (Element e : l) {
+      insert(e);
+    }
+  }
+
+  template <typename InputIterator>
+  DenseBitset(InputIterator first, InputIterator last) {
+    for (auto it = first; it != last; ++it) {
+      insert(*it);
+    }
+  }
+
+  iterator begin() const { return iterator(&m_words, 0); }
+
+  iterator end() const { return iterator(&m_words, m_words.size()); }
+
+  bool empty() const {
+    return std::all_of(
+        m_words.begin(), m_words.end(), [](Word w) { return w == 0; });
+  }
+
+  size_t size() const {
+    size_t count = 0;
+    for (Word w : m_words) {
+      count += __builtin_popcountll(w);
+    }
+    return count;
+  }
+
+  bool contains(Element e) const {
+    size_t index = e / BITS_PER_WORD;
+    return index < m_words.size() && (m_words[index] & mask(e)) != 0;
+  }
+
+  DenseBitset& insert(Element e) {
+    size_t index = e / BITS_PER_WORD;
+    if (index >= m_words.size()) {
+      m_words.resize(index + 1, 0);
+    }
+    m_words[index] |= mask(e);
+    return *this;
+  }
+
+  DenseBitset& remove(Element e) {
+    size_t index = e / BITS_PER_WORD;
+    if (index < m_words.size()) {
+      m_words[index] &= ~mask(e);
+    }
+    return *this;
+  }
+
+  void clear() { m_words.clear(); }
+
+  bool is_subset_of(const DenseBitset& other) const {
+    size_t common = std::min(m_words.size(), other.m_words.size());
+    for (size_t i = 0; i < common; ++i) {
+      if ((m_words[i] & ~other.m_words[i]) != 0) {
+        return false;
+      }
+    }
+    return zero_from(common);
+  }
+
+  bool equals(const DenseBitset& other) const {
+    size_t common = std::min(m_words.size(), other.m_words.size());
+    for (size_t i = 0; i < common; ++i) {
+      if (m_words[i] != other.m_words[i]) {
+        return false;
+      }
+    }
+    return zero_from(common) && other.zero_from(common);
+  }
+
+  DenseBitset& union_with(const DenseBitset& other) {
+    if (other.m_words.size() > m_words.size()) {
+      m_words.resize(other.m_words.size(), 0);
+    }
+    Word* words = m_words.data();
+    const Word* other_words = other.m_words.data();
+    for (size_t i = 0, n = other.m_words.size(); i < n; ++i) {
+      words[i] |= other_words[i];
+    }
+    return *this;
+  }
+
+  DenseBitset& intersection_with(const DenseBitset& other) {
+    if (m_words.size() > other.m_words.size()) {
+      m_words.resize(other.m_words.size());
+    }
+    Word* words = m_words.data();
+    const Word* other_words = other.m_words.data();
+    for (size_t i = 0, n = m_words.size(); i < n; ++i) {
+      words[i] &= other_words[i];
+    }
+    return *this;
+  }
+
+  DenseBitset& difference_with(const DenseBitset& other) {
+    Word* words = m_words.data();
+    const Word* other_words = other.m_words.data();
+    for (size_t i = 0, n = std::min(m_words.size(), other.m_words.size());
+         i < n;
+         ++i) {
+      words[i] &= ~other_words[i];
+    }
+    return *this;
+  }
+
+  friend std::ostream& operator<<(std::ostream& o, const DenseBitset& s) {
+    o << "{";
+    for (auto it = s.begin(); it != s.end();) {
+      o << *it++;
+      if (it != s.end()) {
+        o << ", ";
+      }
+    }
+    o << "}";
+    return o;
+  }
+
+ private:
+  static Word mask(Element e) { return Word(1) << (e % BITS_PER_WORD); }
+
+  bool zero_from(size_t index) const {
+    return std::all_of(m_words.begin() + index, m_words.end(),
+                       [](Word w) { return w == 0; });
+  }
+
+  Words m_words;
+};
+
+} // namespace sparta
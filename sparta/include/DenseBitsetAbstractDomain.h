@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <initializer_list>
+
+#include "DenseBitset.h"
+#include "PowersetAbstractDomain.h"
+
+namespace sparta {
+
+template <typename Element>
+class DenseBitsetAbstractDomain;
+
+namespace dbsad_impl {
+
+/*
+ * An abstract value from a powerset is implemented as a bit vector.
+ */
+template <typename Element>
+class SetValue final
+    : public PowersetImplementation<Element,
+                                    const DenseBitset<Element>&,
+                                    SetValue<Element>> {
+ public:
+  SetValue() = default;
+
+  SetValue(const Element& e) { m_set.insert(e); }
+
+  SetValue(std::initializer_list<Element> l) : m_set(l) {}
+
+  SetValue(const DenseBitset<Element>& set) : m_set(set) {}
+
+  const DenseBitset<Element>& elements() const override { return m_set; }
+
+  size_t size() const override { return m_set.size(); }
+
+  bool contains(const Element& e) const override { return m_set.contains(e); }
+
+  void add(const Element& e) override { m_set.insert(e); }
+
+  void remove(const Element& e) override { m_set.remove(e); }
+
+  void clear() override { m_set.clear(); }
+
+  AbstractValueKind kind() const override { return AbstractValueKind::Value; }
+
+  bool leq(const SetValue& other) const override {
+    return m_set.is_subset_of(other.m_set);
+  }
+
+  bool equals(const SetValue& other) const override {
+    return m_set.equals(other.m_set);
+  }
+
+  AbstractValueKind join_with(const SetValue& other) override {
+    m_set.union_with(other.m_set);
+    return AbstractValueKind::Value;
+  }
+
+  AbstractValueKind meet_with(const SetValue& other) override {
+    m_set.intersection_with(other.m_set);
+    return AbstractValueKind::Value;
+  }
+
+  AbstractValueKind difference_with(const SetValue& other) override {
+    m_set.difference_with(other.m_set);
+    return AbstractValueKind::Value;
+  }
+
+  friend std::ostream& operator<<(std::ostream& o, const SetValue& value) {
+    o << "[#" << value.size() << "]";
+    o << value.m_set;
+    return o;
+  }
+
+ private:
+  DenseBitset<Element> m_set;
+
+  template <typename T>
+  friend class sparta::DenseBitsetAbstractDomain;
+};
+
+} // namespace dbsad_impl
+
+/*
+ * An implementation of powerset abstract domains using bit vectors. This
+ * implementation should be used when the elements are small unsigned integers
+ * drawn from a dense universe, like the registers of a method in a liveness
+ * analysis. Unlike PatriciaTreeSetAbstractDomain, copies don't share any
+ * structure, so this is a poor fit for analyses that keep many nearly identical
+ * sets over a large universe.
+ */
+template <typename Element>
+class DenseBitsetAbstractDomain final
+    : public PowersetAbstractDomain<Element,
+                                    dbsad_impl::SetValue<Element>,
+                                    const DenseBitset<Element>&,
+                                    DenseBitsetAbstractDomain<Element>> {
+ public:
+  using Value = dbsad_impl::SetValue<Element>;
+
+  DenseBitsetAbstractDomain()
+      : PowersetAbstractDomain<Element,
+                               Value,
+                               const DenseBitset<Element>&,
+                               DenseBitsetAbstractDomain>() {}
+
+  DenseBitsetAbstractDomain(AbstractValueKind kind)
+      : PowersetAbstractDomain<Element,
+                               Value,
+                               const DenseBitset<Element>&,
+                               DenseBitsetAbstractDomain>(kind) {}
+
+  explicit DenseBitsetAbstractDomain(const Element& e) {
+    this->set_to_value(Value(e));
+  }
+
+  explicit DenseBitsetAbstractDomain(std::initializer_list<Element> l) {
+    this->set_to_value(Value(l));
+  }
+
+  explicit DenseBitsetAbstractDomain(const DenseBitset<Element>& set) {
+    this->set_to_value(Value(set));
+  }
+
+  static DenseBitsetAbstractDomain bottom() {
+    return DenseBitsetAbstractDomain(AbstractValueKind::Bottom);
+  }
+
+  static DenseBitsetAbstractDomain top() {
+    return DenseBitsetAbstractDomain(AbstractValueKind::Top);
+  }
+};
+
+} // namespace sparta
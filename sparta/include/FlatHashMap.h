@@ -0,0 +1,489 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace sparta {
+
+namespace fhm_impl {
+
+// Control bytes. A full slot holds the low 7 bits of the hash of its key.
+constexpr int8_t kEmpty = -128;
+constexpr int8_t kDeleted = -2;
+
+constexpr size_t kGroupWidth = 16;
+
+inline bool is_full(int8_t ctrl) { return ctrl >= 0; }
+
+/*
+ * Scans the control bytes of a group of kGroupWidth slots. Bit i of a mask is
+ * set iff slot i of the group matches.
+ */
+class Group {
+ public:
+  explicit Group(const int8_t* ctrl) {
+#if defined(__SSE2__)
+    m_ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+#else
+    std::memcpy(m_ctrl, ctrl, kGroupWidth);
+#endif
+  }
+
+  uint32_t match(int8_t h2) const {
+#if defined(__SSE2__)
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), m_ctrl));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < kGroupWidth; ++i) {
+      mask |= static_cast<uint32_t>(m_ctrl[i] == h2) << i;
+    }
+    return mask;
+#endif
+  }
+
+  uint32_t match_empty() const { return match(kEmpty); }
+
+  uint32_t match_empty_or_deleted() const {
+#if defined(__SSE2__)
+    // Both special values are negative, full slots are not.
+    return _mm_movemask_epi8(m_ctrl);
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < kGroupWidth; ++i) {
+      mask |= static_cast<uint32_t>(!is_full(m_ctrl[i])) << i;
+    }
+    return mask;
+#endif
+  }
+
+ private:
+#if defined(__SSE2__)
+  __m128i m_ctrl;
+#else
+  int8_t m_ctrl[kGroupWidth];
+#endif
+};
+
+inline size_t lowest_bit(uint32_t mask) { return __builtin_ctz(mask); }
+
+} // namespace fhm_impl
+
+/*
+ * A hashtable with open addressing, in the style of Swiss tables: the entries
+ * are stored inline in a single array of slots, and a parallel array of one
+ * control byte per slot tells whether the slot is empty, deleted, or full (in
+ * which case it holds 7 bits of the hash of the key). Lookups compare a whole
+ * group of 16 control bytes at once (with SSE2 when available), and only probe
+ * the slots whose control byte matches.
+ *
+ * This has the same interface as the subset of std::unordered_map used by the
+ * hashed abstract domains, with the same guarantee that erasing an entry does
+ * not invalidate iterators to the other entries. Unlike std::unordered_map,
+ * inserting an entry may move all the others, which invalidates references to
+ * them.
+ */
+template <typename Key,
+          typename Value,
+          typename Hash = std::hash<Key>,
+          typename Equal = std::equal_to<Key>>
+class FlatHashMap final {
+ public:
+  using key_type = Key;
+  using mapped_type = Value;
+  using value_type = std::pair<const Key, Value>;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using hasher = Hash;
+  using key_equal = Equal;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+
+ private:
+  using Slot = std::aligned_storage_t<sizeof(value_type), alignof(value_type)>;
+
+  template <bool IsConst>
+  class Iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = typename FlatHashMap::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer =
+        std::conditional_t<IsConst, const value_type*, value_type*>;
+    using reference =
+        std::conditional_t<IsConst, const value_type&, value_type&>;
+
+    Iterator() = default;
+
+    // Conversion from iterator to const_iterator.
+    template <bool C = IsConst, typename = std::enable_if_t<C>>
+    Iterator(const Iterator<false>& other) // NOLINT
+        : m_ctrl(other.m_ctrl), m_slot(other.m_slot), m_end(other.m_end) {}
+
+    reference operator*() const { return *get(); }
+
+    pointer operator->() const { return get(); }
+
+    Iterator& operator++() {
+      ++m_ctrl;
+      ++m_slot;
+      skip_free_slots();
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator res = *this;
+      ++(*this);
+      return res;
+    }
+
+    bool operator==(const Iterator& other) const {
+      return m_ctrl == other.m_ctrl;
+    }
+
+    bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+   private:
+    Iterator(const int8_t* ctrl, const Slot* slot, const int8_t* end)
+        : m_ctrl(ctrl), m_slot(const_cast<Slot*>(slot)), m_end(end) {
+      skip_free_slots();
+    }
+
+    void skip_free_slots() {
+      while (m_ctrl != m_end && !fhm_impl::is_full(*m_ctrl)) {
+        ++m_ctrl;
+        ++m_slot;
+      }
+    }
+
+    pointer get() const { return reinterpret_cast<pointer>(m_slot); }
+
+    const int8_t* m_ctrl{nullptr};
+    Slot* m_slot{nullptr};
+    const int8_t* m_end{nullptr};
+
+    template <bool>
+    friend class Iterator;
+    friend class FlatHashMap;
+  };
+
+ public:
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  FlatHashMap() = default;
+
+  FlatHashMap(const FlatHashMap& other) { copy_from(other); }
+
+  FlatHashMap(FlatHashMap&& other) noexcept { swap(other); }
+
+  FlatHashMap& operator=(const FlatHashMap& other) {
+    if (this != &other) {
+      FlatHashMap copy(other);
+      swap(copy);
+    }
+    return *this;
+  }
+
+  FlatHashMap& operator=(FlatHashMap&& other) noexcept {
+    FlatHashMap moved(std::move(other));
+    swap(moved);
+    return *this;
+  }
+
+  ~FlatHashMap() { destroy_slots(); }
+
+  void swap(FlatHashMap& other) noexcept {
+    std::swap(m_ctrl, other.m_ctrl);
+    std::swap(m_slots, other.m_slots);
+    std::swap(m_capacity, other.m_capacity);
+    std::swap(m_size, other.m_size);
+    std::swap(m_growth_left, other.m_growth_left);
+  }
+
+  bool empty() const { return m_size == 0; }
+
+  size_t size() const { return m_size; }
+
+  iterator begin() { return iterator_at(0); }
+
+  iterator end() { return iterator_at(m_capacity); }
+
+  const_iterator begin() const { return const_iterator_at(0); }
+
+  const_iterator end() const { return const_iterator_at(m_capacity); }
+
+  const_iterator cbegin() const { return begin(); }
+
+  const_iterator cend() const { return end(); }
+
+  iterator find(const Key& key) { return iterator_at(find_index(key)); }
+
+  const_iterator find(const Key& key) const {
+    return const_iterator_at(find_index(key));
+  }
+
+  size_t count(const Key& key) const { return find_index(key) != m_capacity; }
+
+  Value& operator[](const Key& key) {
+    return try_emplace(key).first->second;
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args) {
+    size_t hash = hash_of(key);
+    size_t index = find_index(key, hash);
+    if (index != m_capacity) {
+      return {iterator_at(index), false};
+    }
+    index = prepare_insert(hash);
+    new (&m_slots[index])
+        value_type(std::piecewise_construct, std::forward_as_tuple(key),
+                   std::forward_as_tuple(std::forward<Args>(args)...));
+    return {iterator_at(index), true};
+  }
+
+  std::pair<iterator, bool> insert(const value_type& value) {
+    return try_emplace(value.first, value.second);
+  }
+
+  size_t erase(const Key& key) {
+    size_t index = find_index(key);
+    if (index == m_capacity) {
+      return 0;
+    }
+    erase_at(index);
+    return 1;
+  }
+
+  iterator erase(const_iterator it) {
+    size_t index = it.m_ctrl - m_ctrl.get();
+    erase_at(index);
+    return iterator_at(index + 1);
+  }
+
+  void clear() {
+    destroy_slots();
+    if (m_capacity != 0) {
+      std::memset(m_ctrl.get(), fhm_impl::kEmpty, m_capacity);
+    }
+    m_size = 0;
+    m_growth_left = max_load(m_capacity);
+  }
+
+  void reserve(size_t n) {
+    if (n > max_load(m_capacity)) {
+      size_t capacity = fhm_impl::kGroupWidth;
+      while (max_load(capacity) < n) {
+        capacity *= 2;
+      }
+      rehash(capacity);
+    }
+  }
+
+ private:
+  // The table is grown when 7/8 of the slots are either full or deleted.
+  static size_t max_load(size_t capacity) { return capacity - capacity / 8; }
+
+  size_t hash_of(const Key& key) const {
+    // Mix the bits, as the standard hash of integers and pointers is the
+    // identity, and we take both the group index and the control byte from
+    // the hash.
+    uint64_t h = Hash()(key);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return static_cast<size_t>(h);
+  }
+
+  static int8_t h2(size_t hash) { return static_cast<int8_t>(hash & 0x7f); }
+
+  size_t num_groups() const { return m_capacity / fhm_impl::kGroupWidth; }
+
+  /*
+   * Visits groups in a triangular probe sequence, which covers all groups
+   * since their number is a power of 2. The callback returns true to stop.
+   */
+  template <typename Fn>
+  void probe(size_t hash, const Fn& fn) const {
+    size_t mask = num_groups() - 1;
+    size_t group = (hash >> 7) & mask;
+    for (size_t i = 1;; ++i) {
+      if (fn(group * fhm_impl::kGroupWidth)) {
+        return;
+      }
+      group = (group + i) & mask;
+    }
+  }
+
+  size_t find_index(const Key& key) const {
+    return find_index(key, hash_of(key));
+  }
+
+  // Returns m_capacity if the key is absent.
+  size_t find_index(const Key& key, size_t hash) const {
+    size_t res = m_capacity;
+    if (m_size == 0) {
+      return res;
+    }
+    probe(hash, [&](size_t base) {
+      fhm_impl::Group group(m_ctrl.get() + base);
+      for (uint32_t mask = group.match(h2(hash)); mask != 0;
+           mask &= mask - 1) {
+        size_t index = base + fhm_impl::lowest_bit(mask);
+        if (Equal()(key, reinterpret_cast<const value_type*>(&m_slots[index])
+                             ->first)) {
+          res = index;
+          return true;
+        }
+      }
+      // An empty slot ends the probe sequence of every key that hashes to
+      // this group or to one probed before it.
+      return group.match_empty() != 0;
+    });
+    return res;
+  }
+
+  size_t find_first_free(size_t hash) const {
+    size_t res = 0;
+    probe(hash, [&](size_t base) {
+      auto mask =
+          fhm_impl::Group(m_ctrl.get() + base).match_empty_or_deleted();
+      if (mask == 0) {
+        return false;
+      }
+      res = base + fhm_impl::lowest_bit(mask);
+      return true;
+    });
+    return res;
+  }
+
+  // Returns the index of a free slot for a new entry with the given hash, and
+  // marks it as full.
+  size_t prepare_insert(size_t hash) {
+    if (m_capacity == 0) {
+      rehash(fhm_impl::kGroupWidth);
+    }
+    size_t index = find_first_free(hash);
+    if (m_growth_left == 0 && m_ctrl[index] == fhm_impl::kEmpty) {
+      // Grow, unless most of the used slots are tombstones, in which case
+      // rehashing in place reclaims them.
+      rehash(m_size * 2 >= max_load(m_capacity) ? m_capacity * 2
+                                                : m_capacity);
+      index = find_first_free(hash);
+    }
+    if (m_ctrl[index] == fhm_impl::kEmpty) {
+      --m_growth_left;
+    }
+    m_ctrl[index] = h2(hash);
+    ++m_size;
+    return index;
+  }
+
+  void erase_at(size_t index) {
+    reinterpret_cast<value_type*>(&m_slots[index])->~value_type();
+    --m_size;
+    // Groups are probed as a whole, so if the group of the slot already has
+    // an empty slot, no probe sequence goes past it and the slot can be made
+    // empty. Otherwise, we need a tombstone.
+    size_t base = index - index % fhm_impl::kGroupWidth;
+    if (fhm_impl::Group(m_ctrl.get() + base).match_empty() != 0) {
+      m_ctrl[index] = fhm_impl::kEmpty;
+      ++m_growth_left;
+    } else {
+      m_ctrl[index] = fhm_impl::kDeleted;
+    }
+  }
+
+  void rehash(size_t capacity) {
+    std::unique_ptr<int8_t[]> old_ctrl = std::move(m_ctrl);
+    std::unique_ptr<Slot[]> old_slots = std::move(m_slots);
+    size_t old_capacity = m_capacity;
+
+    m_ctrl.reset(new int8_t[capacity]);
+    std::memset(m_ctrl.get(), fhm_impl::kEmpty, capacity);
+    m_slots.reset(new Slot[capacity]);
+    m_capacity = capacity;
+    m_growth_left = max_load(capacity) - m_size;
+
+    for (size_t i = 0; i < old_capacity; ++i) {
+      if (!fhm_impl::is_full(old_ctrl[i])) {
+        continue;
+      }
+      auto* entry = reinterpret_cast<value_type*>(&old_slots[i]);
+      size_t hash = hash_of(entry->first);
+      size_t index = find_first_free(hash);
+      m_ctrl[index] = h2(hash);
+      new (&m_slots[index]) value_type(std::move(*entry));
+      entry->~value_type();
+    }
+  }
+
+  void copy_from(const FlatHashMap& other) {
+    if (other.m_capacity == 0) {
+      return;
+    }
+    // Keep the same layout, so that no rehashing is needed.
+    m_ctrl.reset(new int8_t[other.m_capacity]);
+    std::memcpy(m_ctrl.get(), other.m_ctrl.get(), other.m_capacity);
+    m_slots.reset(new Slot[other.m_capacity]);
+    m_capacity = other.m_capacity;
+    for (size_t i = 0; i < m_capacity; ++i) {
+      if (fhm_impl::is_full(m_ctrl[i])) {
+        new (&m_slots[i]) value_type(
+            *reinterpret_cast<const value_type*>(&other.m_slots[i]));
+      }
+    }
+    m_size = other.m_size;
+    m_growth_left = other.m_growth_left;
+  }
+
+  void destroy_slots() {
+    if (std::is_trivially_destructible<value_type>::value || m_size == 0) {
+      return;
+    }
+    for (size_t i = 0; i < m_capacity; ++i) {
+      if (fhm_impl::is_full(m_ctrl[i])) {
+        reinterpret_cast<value_type*>(&m_slots[i])->~value_type();
+      }
+    }
+  }
+
+  iterator iterator_at(size_t index) {
+    return iterator(m_ctrl.get() + index, m_slots.get() + index,
+                    m_ctrl.get() + m_capacity);
+  }
+
+  const_iterator const_iterator_at(size_t index) const {
+    return const_iterator(m_ctrl.get() + index, m_slots.get() + index,
+                          m_ctrl.get() + m_capacity);
+  }
+
+  // The capacity is either 0 or a power of 2 that is a multiple of the group
+  // width, so that groups never wrap around the end of the table.
+  std::unique_ptr<int8_t[]> m_ctrl;
+  std::unique_ptr<Slot[]> m_slots;
+  size_t m_capacity{0};
+  size_t m_size{0};
+  size_t m_growth_left{0};
+};
+
+} // namespace sparta
@@ -16,6 +16,7 @@
 #include <utility>
 
 #include "AbstractDomain.h"
+#include "FlatHashMap.h"
 
 namespace sparta {
 
@@ -24,7 +25,8 @@ namespace hae_impl {
 template <typename Variable,
           typename Domain,
           typename VariableHash,
-          typename VariableEqual>
+          typename VariableEqual,
+          template <typename...> class Map>
 class MapValue;
 
 } // namespace hae_impl
@@ -60,21 +62,28 @@ class MapValue;
  * environment has a default value of Top. This representation is quite
  * convenient in practice. It also allows us to manipulate large (or possibly
  * infinite) variable sets with sparse assignments of non-Top values.
+ *
+ * As in HashedAbstractPartition, the Map parameter selects the hashtable, e.g.
+ * sparta::FlatHashMap instead of the default std::unordered_map.
  */
 template <typename Variable,
           typename Domain,
           typename VariableHash = std::hash<Variable>,
-          typename VariableEqual = std::equal_to<Variable>>
+          typename VariableEqual = std::equal_to<Variable>,
+          template <typename...> class Map = std::unordered_map>
 class HashedAbstractEnvironment final
     : public AbstractDomainScaffolding<
-          hae_impl::MapValue<Variable, Domain, VariableHash, VariableEqual>,
+          hae_impl::
+              MapValue<Variable, Domain, VariableHash, VariableEqual, Map>,
           HashedAbstractEnvironment<Variable,
                                     Domain,
                                     VariableHash,
-                                    VariableEqual>> {
+                                    VariableEqual,
+                                    Map>> {
  public:
   using Value =
-      hae_impl::MapValue<Variable, Domain, VariableHash, VariableEqual>;
+      hae_impl::MapValue<Variable, Domain, VariableHash, VariableEqual, Map>;
+  using MapType = typename Value::MapType;
 
   /*
    * The default constructor produces the Top value.
@@ -107,8 +116,7 @@ class HashedAbstractEnvironment final
     return this->get_value()->m_map.size();
   }
 
-  const std::unordered_map<Variable, Domain, VariableHash, VariableEqual>&
-  bindings() const {
+  const MapType& bindings() const {
     RUNTIME_CHECK(this->kind() == AbstractValueKind::Value,
                   invalid_abstract_value()
                       << expected_kind(AbstractValueKind::Value)
@@ -187,13 +195,15 @@ class HashedAbstractEnvironment final
 template <typename Variable,
           typename Domain,
           typename VariableHash,
-          typename VariableEqual>
+          typename VariableEqual,
+          template <typename...> class Map>
 inline std::ostream& operator<<(
     std::ostream& o,
     const typename sparta::HashedAbstractEnvironment<Variable,
                                                      Domain,
                                                      VariableHash,
-                                                     VariableEqual>& e) {
+                                                     VariableEqual,
+                                                     Map>& e) {
   using namespace sparta;
   switch (e.kind()) {
   case AbstractValueKind::Bottom: {
@@ -239,11 +249,14 @@ namespace hae_impl {
 template <typename Variable,
           typename Domain,
           typename VariableHash,
-          typename VariableEqual>
+          typename VariableEqual,
+          template <typename...> class Map>
 class MapValue final
     : public AbstractValue<
-          MapValue<Variable, Domain, VariableHash, VariableEqual>> {
+          MapValue<Variable, Domain, VariableHash, VariableEqual, Map>> {
  public:
+  using MapType = Map<Variable, Domain, VariableHash, VariableEqual>;
+
   MapValue() = default;
 
   MapValue(const Variable& variable, const Domain& value) {
@@ -386,9 +399,14 @@ class MapValue final
     return kind();
   }
 
-  std::unordered_map<Variable, Domain, VariableHash, VariableEqual> m_map;
+  MapType m_map;
 
-  template <typename T1, typename T2, typename T3, typename T4>
+  template <typename T1,
+            typename T2,
+            typename T3,
+            typename T4,
+            template <typename...>
+            class T5>
   friend class sparta::HashedAbstractEnvironment;
 };
 
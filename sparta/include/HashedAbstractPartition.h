@@ -16,6 +16,7 @@
 #include <utility>
 
 #include "AbstractDomain.h"
+#include "FlatHashMap.h"
 
 namespace sparta {
 
@@ -37,15 +38,23 @@ namespace sparta {
  *   HashedAbstractPartition::top().set(L, D) == HashedAbstractPartition::top()
  *
  * This makes for a much simpler implementation.
+ *
+ * The hashtable is a std::unordered_map by default. Passing sparta::FlatHashMap
+ * as the Map parameter stores the bindings inline in an open-addressing table,
+ * which makes lookups and componentwise operations faster, but references to
+ * bindings are not stable across insertions.
  */
 template <typename Label,
           typename Domain,
           typename LabelHash = std::hash<Label>,
-          typename LabelEqual = std::equal_to<Label>>
+          typename LabelEqual = std::equal_to<Label>,
+          template <typename...> class Map = std::unordered_map>
 class HashedAbstractPartition final
     : public AbstractDomain<
-          HashedAbstractPartition<Label, Domain, LabelHash, LabelEqual>> {
+          HashedAbstractPartition<Label, Domain, LabelHash, LabelEqual, Map>> {
  public:
+  using MapType = Map<Label, Domain, LabelHash, LabelEqual>;
+
   /*
    * The default constructor produces the Bottom value.
    */
@@ -70,8 +79,7 @@ class HashedAbstractPartition final
    * Get the bindings that are not set to Bottom. This operation is not defined
    * if the HashedAbstractPartition is set to Top.
    */
-  const std::unordered_map<Label, Domain, LabelHash, LabelEqual>& bindings()
-      const {
+  const MapType& bindings() const {
     RUNTIME_CHECK(!is_top(), undefined_operation());
     return m_map;
   }
@@ -272,7 +280,7 @@ class HashedAbstractPartition final
   }
 
  private:
-  std::unordered_map<Label, Domain, LabelHash, LabelEqual> m_map;
+  MapType m_map;
   bool m_is_top{false};
 };
 
@@ -281,11 +289,12 @@ class HashedAbstractPartition final
 template <typename Label,
           typename Domain,
           typename LabelHash,
-          typename LabelEqual>
+          typename LabelEqual,
+          template <typename...> class Map>
 inline std::ostream& operator<<(
     std::ostream& o,
     const typename sparta::
-        HashedAbstractPartition<Label, Domain, LabelHash, LabelEqual>&
+        HashedAbstractPartition<Label, Domain, LabelHash, LabelEqual, Map>&
             partition) {
   if (partition.is_bottom()) {
     o << "_|_";
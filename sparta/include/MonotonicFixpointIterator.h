@@ -8,8 +8,12 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <type_traits>
 #include <unordered_map>
 #include <vector>
@@ -320,6 +324,76 @@ class WTOMonotonicFixpointIterator
   WeakTopologicalOrdering<NodeId, NodeHash> m_wto;
 };
 
+/*
+ * Builds the weak partial ordering of the nodes of a graph that a
+ * MonotonicFixpointIterator follows.
+ */
+template <typename GraphInterface,
+          typename NodeHash = std::hash<typename GraphInterface::NodeId>>
+std::shared_ptr<
+    const WeakPartialOrdering<typename GraphInterface::NodeId, NodeHash>>
+make_weak_partial_ordering(const typename GraphInterface::Graph& graph) {
+  using NodeId = typename GraphInterface::NodeId;
+  return std::make_shared<const WeakPartialOrdering<NodeId, NodeHash>>(
+      GraphInterface::entry(graph),
+      [&graph](const NodeId& x) {
+        const auto& succ_edges = GraphInterface::successors(graph, x);
+        std::vector<NodeId> succ_nodes_tmp;
+        std::transform(succ_edges.begin(),
+                       succ_edges.end(),
+                       std::back_inserter(succ_nodes_tmp),
+                       std::bind(&GraphInterface::target,
+                                 std::ref(graph),
+                                 std::placeholders::_1));
+        // Filter out duplicate succ nodes.
+        std::vector<NodeId> succ_nodes;
+        std::unordered_set<NodeId, NodeHash> succ_nodes_set;
+        for (auto node : succ_nodes_tmp) {
+          if (!succ_nodes_set.count(node)) {
+            succ_nodes_set.emplace(node);
+            succ_nodes.emplace_back(node);
+          }
+        }
+        return succ_nodes;
+      },
+      false);
+}
+
+namespace fp_impl {
+
+template <typename GraphInterface, typename NodeHash, typename = void>
+struct has_cached_wpo : std::false_type {};
+
+template <typename GraphInterface, typename NodeHash>
+struct has_cached_wpo<
+    GraphInterface,
+    NodeHash,
+    std::enable_if_t<std::is_same<
+        decltype(GraphInterface::cached_wpo(
+            std::declval<const typename GraphInterface::Graph&>())),
+        std::shared_ptr<const WeakPartialOrdering<
+            typename GraphInterface::NodeId,
+            NodeHash>>>::value>> : std::true_type {};
+
+/*
+ * Graphs that are analyzed over and over without changing can keep their
+ * ordering around: if the GraphInterface has a static `cached_wpo(graph)`
+ * returning the result of make_weak_partial_ordering(), it is used instead of
+ * building a new ordering.
+ */
+template <typename GraphInterface, typename NodeHash>
+std::shared_ptr<
+    const WeakPartialOrdering<typename GraphInterface::NodeId, NodeHash>>
+get_weak_partial_ordering(const typename GraphInterface::Graph& graph) {
+  if constexpr (has_cached_wpo<GraphInterface, NodeHash>::value) {
+    return GraphInterface::cached_wpo(graph);
+  } else {
+    return make_weak_partial_ordering<GraphInterface, NodeHash>(graph);
+  }
+}
+
+} // namespace fp_impl
+
 /*
  * Implementation of a deterministic concurrent fixpoint algorithm for weak
  * partial ordering (WPO) of a rooted directed graph, as described in the paper:
@@ -349,29 +423,8 @@ class ParallelMonotonicFixpointIterator
       : fp_impl::
             MonotonicFixpointIteratorBase<GraphInterface, Domain, NodeHash>(
                 graph, /*cfg_size_hint*/ 4),
-        m_wpo(
-            GraphInterface::entry(graph),
-            [=, &graph](const NodeId& x) {
-              const auto& succ_edges = GraphInterface::successors(graph, x);
-              std::vector<NodeId> succ_nodes_tmp;
-              std::transform(succ_edges.begin(),
-                             succ_edges.end(),
-                             std::back_inserter(succ_nodes_tmp),
-                             std::bind(&GraphInterface::target,
-                                       std::ref(graph),
-                                       std::placeholders::_1));
-              // Filter out duplicate succ nodes.
-              std::vector<NodeId> succ_nodes;
-              std::unordered_set<NodeId> succ_nodes_set;
-              for (auto node : succ_nodes_tmp) {
-                if (!succ_nodes_set.count(node)) {
-                  succ_nodes_set.emplace(node);
-                  succ_nodes.emplace_back(node);
-                }
-              }
-              return succ_nodes;
-            },
-            false),
+        m_wpo(fp_impl::get_weak_partial_ordering<GraphInterface, NodeHash>(
+            graph)),
         m_num_thread(num_thread) {
     // Gathering all reachable nodes in graph.
     std::stack<NodeId> node_queue;
@@ -400,25 +453,25 @@ class ParallelMonotonicFixpointIterator
     this->set_all_to_bottom(m_all_nodes);
     Context context(init, m_all_nodes);
     std::unique_ptr<std::atomic<uint32_t>[]> wpo_counter(
-        new std::atomic<uint32_t>[m_wpo.size()]);
-    std::fill_n(wpo_counter.get(), m_wpo.size(), 0);
-    auto entry_idx = m_wpo.get_entry();
-    assert(m_wpo.get_num_preds(entry_idx) == 0);
+        new std::atomic<uint32_t>[m_wpo->size()]);
+    std::fill_n(wpo_counter.get(), m_wpo->size(), 0);
+    auto entry_idx = m_wpo->get_entry();
+    assert(m_wpo->get_num_preds(entry_idx) == 0);
     // Prepare work queue.
     auto wq = sparta::work_queue<uint32_t>(
         [&context, &entry_idx, &wpo_counter, this](WPOWorkerState* worker_state,
                                                    uint32_t wpo_idx) {
           std::atomic<uint32_t>& current_counter = wpo_counter[wpo_idx];
-          assert(current_counter == m_wpo.get_num_preds(wpo_idx));
+          assert(current_counter == m_wpo->get_num_preds(wpo_idx));
           current_counter = 0;
           // NonExit node
-          if (!m_wpo.is_exit(wpo_idx)) {
-            this->analyze_vertex(&context, m_wpo.get_node(wpo_idx));
-            for (auto succ_idx : m_wpo.get_successors(wpo_idx)) {
+          if (!m_wpo->is_exit(wpo_idx)) {
+            this->analyze_vertex(&context, m_wpo->get_node(wpo_idx));
+            for (auto succ_idx : m_wpo->get_successors(wpo_idx)) {
               std::atomic<uint32_t>& succ_counter = wpo_counter[succ_idx];
               // Increase succ node's counter, push succ nodes in work queue if
               // their counter number matches their NumSchedPreds.
-              if (++succ_counter == m_wpo.get_num_preds(succ_idx)) {
+              if (++succ_counter == m_wpo->get_num_preds(succ_idx)) {
                 worker_state->push_task(succ_idx);
               }
             }
@@ -426,8 +479,8 @@ class ParallelMonotonicFixpointIterator
           }
           // Exit node
           // Check if component of the exit node has stabilized.
-          auto head_idx = m_wpo.get_head_of_exit(wpo_idx);
-          NodeId head = m_wpo.get_node(head_idx);
+          auto head_idx = m_wpo->get_head_of_exit(wpo_idx);
+          NodeId head = m_wpo->get_node(head_idx);
           Domain* current_state = &this->m_entry_states[head];
           Domain new_state = Domain::bottom();
           this->compute_entry_state(&context, head, &new_state);
@@ -435,11 +488,11 @@ class ParallelMonotonicFixpointIterator
             // Component stabilized.
             context.reset_local_iteration_count_for(head);
             *current_state = std::move(new_state);
-            for (auto succ_idx : m_wpo.get_successors(wpo_idx)) {
+            for (auto succ_idx : m_wpo->get_successors(wpo_idx)) {
               std::atomic<uint32_t>& succ_counter = wpo_counter[succ_idx];
               // Increase succ node's counter, push succ nodes in work queue if
               // their counter number matches their NumSchedPreds.
-              if (++succ_counter == m_wpo.get_num_preds(succ_idx)) {
+              if (++succ_counter == m_wpo->get_num_preds(succ_idx)) {
                 worker_state->push_task(succ_idx);
               }
             }
@@ -449,7 +502,7 @@ class ParallelMonotonicFixpointIterator
             context.increase_iteration_count_for(head);
             // Set component nodes v's counter to their
             // NumOuterSchedPreds(v, wpo_idx)
-            for (auto pred_pair : m_wpo.get_num_outer_preds(wpo_idx)) {
+            for (auto pred_pair : m_wpo->get_num_outer_preds(wpo_idx)) {
               auto component_idx = pred_pair.first;
               assert(component_idx != entry_idx);
               std::atomic<uint32_t>& component_counter =
@@ -466,7 +519,7 @@ class ParallelMonotonicFixpointIterator
               // predecessors, and update our own counter to 0 before updating
               // any other dependent counters.
               if ((component_counter += pred_pair.second) ==
-                  m_wpo.get_num_preds(component_idx)) {
+                  m_wpo->get_num_preds(component_idx)) {
                 worker_state->push_task(component_idx);
               }
             }
@@ -483,17 +536,313 @@ class ParallelMonotonicFixpointIterator
         },
         m_num_thread,
         /*push_tasks_while_running=*/true);
-    wq.add_item(m_wpo.get_entry());
+    wq.add_item(m_wpo->get_entry());
     wq.run_all();
-    for (uint32_t idx = 0; idx < m_wpo.size(); ++idx) {
+    for (uint32_t idx = 0; idx < m_wpo->size(); ++idx) {
       assert(wpo_counter[idx] == 0);
     }
   }
 
  private:
-  WeakPartialOrdering<NodeId, NodeHash> m_wpo;
+  std::shared_ptr<const WeakPartialOrdering<NodeId, NodeHash>> m_wpo;
+  size_t m_num_thread;
+  std::unordered_set<NodeId> m_all_nodes;
+};
+
+/*
+ * A parallel fixpoint algorithm that schedules the strongly connected
+ * components (SCCs) of the graph rather than the components of a weak partial
+ * ordering. SCCs whose predecessor SCCs have all stabilized are analyzed
+ * concurrently, and the nodes within an SCC are analyzed by a parallel
+ * chaotic iteration: a node is (re)scheduled whenever the exit state of one
+ * of its predecessors in the same SCC changes. This keeps all threads busy on
+ * graphs with large recursive SCCs, where the nesting of WPO components
+ * serializes the iteration.
+ *
+ * Every node within a cyclic SCC is a widening point, and the order in which
+ * nodes are analyzed depends on the scheduling. For domains of finite height
+ * whose extrapolation is a join, the result is the least fixpoint, as with the
+ * other iterators; otherwise it may differ between runs.
+ */
+template <typename GraphInterface,
+          typename Domain,
+          typename NodeHash = std::hash<typename GraphInterface::NodeId>>
+class SccParallelMonotonicFixpointIterator
+    : public fp_impl::
+          MonotonicFixpointIteratorBase<GraphInterface, Domain, NodeHash> {
+ public:
+  using Graph = typename GraphInterface::Graph;
+  using NodeId = typename GraphInterface::NodeId;
+  using EdgeId = typename GraphInterface::EdgeId;
+  using Context =
+      fp_impl::MonotonicFixpointIteratorContext<NodeId, Domain, NodeHash>;
+  using WorkerState = SpartaWorkerState<uint32_t>;
+
+  SccParallelMonotonicFixpointIterator(
+      const Graph& graph, size_t num_thread = parallel::default_num_threads())
+      : fp_impl::
+            MonotonicFixpointIteratorBase<GraphInterface, Domain, NodeHash>(
+                graph, /*cfg_size_hint*/ 4),
+        m_num_thread(num_thread) {
+    // Gathering all reachable nodes in graph.
+    auto entry = GraphInterface::entry(graph);
+    m_indices.emplace(entry, 0);
+    m_nodes.push_back(entry);
+    for (uint32_t idx = 0; idx < m_nodes.size(); ++idx) {
+      std::vector<uint32_t> succs;
+      for (auto& edge : GraphInterface::successors(graph, m_nodes[idx])) {
+        auto target = GraphInterface::target(graph, edge);
+        auto insertion = m_indices.emplace(target, m_nodes.size());
+        if (insertion.second) {
+          m_nodes.push_back(target);
+        }
+        succs.push_back(insertion.first->second);
+      }
+      std::sort(succs.begin(), succs.end());
+      succs.erase(std::unique(succs.begin(), succs.end()), succs.end());
+      m_successors.push_back(std::move(succs));
+    }
+    m_all_nodes.insert(m_nodes.begin(), m_nodes.end());
+    compute_sccs();
+  }
+
+  /*
+   * Executes the fixpoint iterator given an abstract value describing the
+   * initial program configuration. This method can be invoked multiple times
+   * with different values in order to analyze the program under different
+   * initial conditions.
+   */
+  void run(const Domain& init) {
+    this->set_all_to_bottom(m_all_nodes);
+    Context context(init, m_all_nodes);
+    auto num_nodes = m_nodes.size();
+    auto num_sccs = m_scc_nodes.size();
+    std::unique_ptr<std::mutex[]> analysis_locks(new std::mutex[num_nodes]);
+    std::unique_ptr<std::mutex[]> state_locks(new std::mutex[num_nodes]);
+    std::unique_ptr<std::atomic<bool>[]> queued(
+        new std::atomic<bool>[num_nodes]);
+    std::fill_n(queued.get(), num_nodes, false);
+    std::vector<char> visited(num_nodes, false);
+    std::unique_ptr<std::atomic<uint32_t>[]> remaining_preds(
+        new std::atomic<uint32_t>[num_sccs]);
+    std::unique_ptr<std::atomic<uint32_t>[]> pending(
+        new std::atomic<uint32_t>[num_sccs]);
+    for (uint32_t scc = 0; scc < num_sccs; ++scc) {
+      remaining_preds[scc] = m_scc_num_preds[scc];
+      pending[scc] = 0;
+    }
+
+    // Both functions return whether the node was not queued yet; the pending
+    // count of its SCC must be incremented before it gets pushed.
+    auto enqueue = [&](uint32_t idx) {
+      if (queued[idx].exchange(true)) {
+        return false;
+      }
+      ++pending[m_scc_of[idx]];
+      return true;
+    };
+    auto start_scc = [&](uint32_t scc, std::vector<uint32_t>* ready) {
+      for (auto idx : m_scc_nodes[scc]) {
+        if (enqueue(idx)) {
+          ready->push_back(idx);
+        }
+      }
+    };
+
+    auto wq = sparta::work_queue<uint32_t>(
+        [&](WorkerState* worker_state, uint32_t idx) {
+          const NodeId& node = m_nodes[idx];
+          auto scc = m_scc_of[idx];
+          std::vector<uint32_t> ready;
+          {
+            std::lock_guard<std::mutex> analysis_guard(analysis_locks[idx]);
+            queued[idx] = false;
+            if (analyze_node_in_scc(&context, idx, state_locks.get(),
+                                    &visited)) {
+              for (auto succ_idx : m_successors[idx]) {
+                if (m_scc_of[succ_idx] == scc && enqueue(succ_idx)) {
+                  ready.push_back(succ_idx);
+                }
+              }
+            }
+          }
+          if (--pending[scc] == 0) {
+            // The SCC has stabilized, as none of its nodes is queued or
+            // running.
+            for (auto succ_scc : m_scc_successors[scc]) {
+              if (--remaining_preds[succ_scc] == 0) {
+                start_scc(succ_scc, &ready);
+              }
+            }
+          }
+          for (auto ready_idx : ready) {
+            worker_state->push_task(ready_idx);
+          }
+          return nullptr;
+        },
+        m_num_thread,
+        /*push_tasks_while_running=*/true);
+    std::vector<uint32_t> roots;
+    for (uint32_t scc = 0; scc < num_sccs; ++scc) {
+      if (m_scc_num_preds[scc] == 0) {
+        start_scc(scc, &roots);
+      }
+    }
+    for (auto idx : roots) {
+      wq.add_item(idx);
+    }
+    wq.run_all();
+    for (uint32_t scc = 0; scc < num_sccs; ++scc) {
+      assert(pending[scc] == 0);
+      assert(remaining_preds[scc] == 0);
+    }
+  }
+
+  size_t get_num_sccs() const { return m_scc_nodes.size(); }
+
+  size_t get_largest_scc_size() const {
+    size_t res = 0;
+    for (auto& nodes : m_scc_nodes) {
+      res = std::max(res, nodes.size());
+    }
+    return res;
+  }
+
+ private:
+  /*
+   * Recomputes the entry state of a node from the exit states of its
+   * predecessors, and reanalyzes the node unless the entry state is subsumed
+   * by the previous one. Returns whether the exit state may have changed. The
+   * caller must hold the analysis lock of the node.
+   */
+  bool analyze_node_in_scc(Context* context,
+                           uint32_t idx,
+                           std::mutex* state_locks,
+                           std::vector<char>* visited) {
+    const NodeId& node = m_nodes[idx];
+    Domain new_entry_state = Domain::bottom();
+    if (idx == 0) {
+      new_entry_state.join_with(context->get_initial_value());
+    }
+    for (EdgeId edge : GraphInterface::predecessors(this->m_graph, node)) {
+      auto it = m_indices.find(GraphInterface::source(this->m_graph, edge));
+      if (it == m_indices.end()) {
+        // Unreachable predecessors have a bottom exit state.
+        continue;
+      }
+      Domain exit_state = Domain::bottom();
+      {
+        std::lock_guard<std::mutex> state_guard(state_locks[it->second]);
+        exit_state = this->m_exit_states.at(it->first);
+      }
+      new_entry_state.join_with(this->analyze_edge(edge, exit_state));
+    }
+
+    Domain exit_state = Domain::bottom();
+    {
+      std::lock_guard<std::mutex> state_guard(state_locks[idx]);
+      Domain* entry_state = &this->m_entry_states.at(node);
+      if ((*visited)[idx] && new_entry_state.leq(*entry_state)) {
+        return false;
+      }
+      (*visited)[idx] = true;
+      this->extrapolate(*context, node, entry_state, new_entry_state);
+      context->increase_iteration_count_for(node);
+      exit_state = *entry_state;
+    }
+    this->analyze_node(node, &exit_state);
+    std::lock_guard<std::mutex> state_guard(state_locks[idx]);
+    this->m_exit_states.at(node) = std::move(exit_state);
+    return true;
+  }
+
+  // Tarjan's algorithm, without recursion. SCCs are numbered in reverse
+  // topological order.
+  void compute_sccs() {
+    const uint32_t unvisited = std::numeric_limits<uint32_t>::max();
+    auto num_nodes = m_nodes.size();
+    std::vector<uint32_t> index(num_nodes, unvisited);
+    std::vector<uint32_t> lowlink(num_nodes);
+    std::vector<char> on_stack(num_nodes, false);
+    std::vector<uint32_t> stack;
+    // Pairs of node and index of the next successor to visit.
+    std::vector<std::pair<uint32_t, size_t>> frames;
+    uint32_t next_index = 0;
+    m_scc_of.assign(num_nodes, unvisited);
+    auto visit = [&](uint32_t idx) {
+      index[idx] = lowlink[idx] = next_index++;
+      stack.push_back(idx);
+      on_stack[idx] = true;
+      frames.emplace_back(idx, 0);
+    };
+    for (uint32_t root = 0; root < num_nodes; ++root) {
+      if (index[root] != unvisited) {
+        continue;
+      }
+      visit(root);
+      while (!frames.empty()) {
+        auto& frame = frames.back();
+        auto idx = frame.first;
+        if (frame.second < m_successors[idx].size()) {
+          auto succ_idx = m_successors[idx][frame.second++];
+          if (index[succ_idx] == unvisited) {
+            visit(succ_idx);
+          } else if (on_stack[succ_idx]) {
+            lowlink[idx] = std::min(lowlink[idx], index[succ_idx]);
+          }
+          continue;
+        }
+        frames.pop_back();
+        if (!frames.empty()) {
+          auto parent = frames.back().first;
+          lowlink[parent] = std::min(lowlink[parent], lowlink[idx]);
+        }
+        if (lowlink[idx] != index[idx]) {
+          continue;
+        }
+        auto scc = (uint32_t)m_scc_nodes.size();
+        m_scc_nodes.emplace_back();
+        uint32_t member;
+        do {
+          member = stack.back();
+          stack.pop_back();
+          on_stack[member] = false;
+          m_scc_of[member] = scc;
+          m_scc_nodes.back().push_back(member);
+        } while (member != idx);
+      }
+    }
+
+    m_scc_successors.resize(m_scc_nodes.size());
+    m_scc_num_preds.assign(m_scc_nodes.size(), 0);
+    for (uint32_t scc = 0; scc < m_scc_nodes.size(); ++scc) {
+      auto& succ_sccs = m_scc_successors[scc];
+      for (auto idx : m_scc_nodes[scc]) {
+        for (auto succ_idx : m_successors[idx]) {
+          if (m_scc_of[succ_idx] != scc) {
+            succ_sccs.push_back(m_scc_of[succ_idx]);
+          }
+        }
+      }
+      std::sort(succ_sccs.begin(), succ_sccs.end());
+      succ_sccs.erase(std::unique(succ_sccs.begin(), succ_sccs.end()),
+                      succ_sccs.end());
+      for (auto succ_scc : succ_sccs) {
+        ++m_scc_num_preds[succ_scc];
+      }
+    }
+  }
+
   size_t m_num_thread;
+  // Reachable nodes, indexed in discovery order; the entry has index 0.
+  std::vector<NodeId> m_nodes;
+  std::unordered_map<NodeId, uint32_t, NodeHash> m_indices;
   std::unordered_set<NodeId> m_all_nodes;
+  std::vector<std::vector<uint32_t>> m_successors;
+  std::vector<uint32_t> m_scc_of;
+  std::vector<std::vector<uint32_t>> m_scc_nodes;
+  std::vector<std::vector<uint32_t>> m_scc_successors;
+  std::vector<uint32_t> m_scc_num_preds;
 };
 
 /*
@@ -518,29 +867,8 @@ class MonotonicFixpointIterator
       : fp_impl::MonotonicFixpointIteratorBase<GraphInterface,
                                                Domain,
                                                NodeHash>(graph, cfg_size_hint),
-        m_wpo(
-            GraphInterface::entry(graph),
-            [=, &graph](const NodeId& x) {
-              const auto& succ_edges = GraphInterface::successors(graph, x);
-              std::vector<NodeId> succ_nodes_tmp;
-              std::transform(succ_edges.begin(),
-                             succ_edges.end(),
-                             std::back_inserter(succ_nodes_tmp),
-                             std::bind(&GraphInterface::target,
-                                       std::ref(graph),
-                                       std::placeholders::_1));
-              // Filter out duplicate succ nodes.
-              std::vector<NodeId> succ_nodes;
-              std::unordered_set<NodeId, NodeHash> succ_nodes_set;
-              for (auto node : succ_nodes_tmp) {
-                if (!succ_nodes_set.count(node)) {
-                  succ_nodes_set.emplace(node);
-                  succ_nodes.emplace_back(node);
-                }
-              }
-              return succ_nodes;
-            },
-            false) {}
+        m_wpo(fp_impl::get_weak_partial_ordering<GraphInterface, NodeHash>(
+            graph)) {}
 
   /*
    * Executes the fixpoint iterator given an abstract value describing the
@@ -552,22 +880,22 @@ class MonotonicFixpointIterator
     this->clear();
     Context context(init);
     std::unique_ptr<std::atomic<uint32_t>[]> wpo_counter(
-        new std::atomic<uint32_t>[m_wpo.size()]);
-    std::fill_n(wpo_counter.get(), m_wpo.size(), 0);
+        new std::atomic<uint32_t>[m_wpo->size()]);
+    std::fill_n(wpo_counter.get(), m_wpo->size(), 0);
     std::queue<uint32_t> work_queue;
-    auto entry_idx = m_wpo.get_entry();
-    assert(m_wpo.get_num_preds(entry_idx) == 0);
+    auto entry_idx = m_wpo->get_entry();
+    assert(m_wpo->get_num_preds(entry_idx) == 0);
     // Prepare work queue.
     auto process_node = [&](uint32_t wpo_idx) {
-      assert(wpo_counter[wpo_idx] == m_wpo.get_num_preds(wpo_idx));
+      assert(wpo_counter[wpo_idx] == m_wpo->get_num_preds(wpo_idx));
       wpo_counter[wpo_idx] = 0;
       // NonExit node
-      if (!m_wpo.is_exit(wpo_idx)) {
-        this->analyze_vertex(&context, m_wpo.get_node(wpo_idx));
-        for (auto succ_idx : m_wpo.get_successors(wpo_idx)) {
+      if (!m_wpo->is_exit(wpo_idx)) {
+        this->analyze_vertex(&context, m_wpo->get_node(wpo_idx));
+        for (auto succ_idx : m_wpo->get_successors(wpo_idx)) {
           // Increase succ node's counter, push succ nodes in work queue if
           // their counter number matches their NumSchedPreds.
-          if (++wpo_counter[succ_idx] == m_wpo.get_num_preds(succ_idx)) {
+          if (++wpo_counter[succ_idx] == m_wpo->get_num_preds(succ_idx)) {
             work_queue.emplace(succ_idx);
           }
         }
@@ -575,8 +903,8 @@ class MonotonicFixpointIterator
       }
       // Exit node
       // Check if component of the exit node has stabilized.
-      uint32_t head_idx = m_wpo.get_head_of_exit(wpo_idx);
-      NodeId head = m_wpo.get_node(head_idx);
+      uint32_t head_idx = m_wpo->get_head_of_exit(wpo_idx);
+      NodeId head = m_wpo->get_node(head_idx);
       Domain* current_state = &this->m_entry_states[head];
       Domain new_state = Domain::bottom();
       this->compute_entry_state(&context, head, &new_state);
@@ -584,10 +912,10 @@ class MonotonicFixpointIterator
         // Component stabilized.
         context.reset_local_iteration_count_for(head);
         *current_state = std::move(new_state);
-        for (auto succ_idx : m_wpo.get_successors(wpo_idx)) {
+        for (auto succ_idx : m_wpo->get_successors(wpo_idx)) {
           // Increase succ node's counter, push succ nodes in work queue if
           // their counter number matches their NumSchedPreds.
-          if (++wpo_counter[succ_idx] == m_wpo.get_num_preds(succ_idx)) {
+          if (++wpo_counter[succ_idx] == m_wpo->get_num_preds(succ_idx)) {
             work_queue.emplace(succ_idx);
           }
         }
@@ -597,13 +925,13 @@ class MonotonicFixpointIterator
         context.increase_iteration_count_for(head);
         // Set component nodes v's counter to their
         // NumOuterSchedPreds(v, wpo_idx)
-        for (auto pred_pair : m_wpo.get_num_outer_preds(wpo_idx)) {
+        for (auto pred_pair : m_wpo->get_num_outer_preds(wpo_idx)) {
           auto component_idx = pred_pair.first;
           assert(component_idx != entry_idx);
           // Push component nodes in work queue if their counter number
           // matches their NumSchedPreds.
           if ((wpo_counter[component_idx] += pred_pair.second) ==
-              m_wpo.get_num_preds(component_idx)) {
+              m_wpo->get_num_preds(component_idx)) {
             work_queue.emplace(component_idx);
           }
         }
@@ -625,13 +953,13 @@ class MonotonicFixpointIterator
       work_queue.pop();
       process_node(item);
     }
-    for (uint32_t idx = 0; idx < m_wpo.size(); ++idx) {
+    for (uint32_t idx = 0; idx < m_wpo->size(); ++idx) {
       assert(wpo_counter[idx] == 0);
     }
   }
 
  private:
-  WeakPartialOrdering<NodeId, NodeHash> m_wpo;
+  std::shared_ptr<const WeakPartialOrdering<NodeId, NodeHash>> m_wpo;
 };
 
 /*
@@ -660,12 +988,12 @@ class BackwardsFixpointIterationAdaptor {
   static NodeId exit(const Graph& graph) {
     return GraphInterface::entry(graph);
   }
-  static std::vector<EdgeId> predecessors(const Graph& graph,
-                                          const NodeId& node) {
+  // Forward whatever the underlying interface returns, so that a container
+  // returned by reference is not copied.
+  static decltype(auto) predecessors(const Graph& graph, const NodeId& node) {
     return GraphInterface::successors(graph, node);
   }
-  static std::vector<EdgeId> successors(const Graph& graph,
-                                        const NodeId& node) {
+  static decltype(auto) successors(const Graph& graph, const NodeId& node) {
     return GraphInterface::predecessors(graph, node);
   }
   static NodeId source(const Graph& graph, const EdgeId& edge) {
@@ -674,6 +1002,13 @@ class BackwardsFixpointIterationAdaptor {
   static NodeId target(const Graph& graph, const EdgeId& edge) {
     return GraphInterface::source(graph, edge);
   }
+  // Forward a cached ordering of the reversed graph, if the underlying
+  // interface keeps one. See fp_impl::get_weak_partial_ordering().
+  template <typename G = GraphInterface>
+  static auto cached_wpo(const Graph& graph)
+      -> decltype(G::cached_backward_wpo(graph)) {
+    return G::cached_backward_wpo(graph);
+  }
 };
 
 } // namespace sparta
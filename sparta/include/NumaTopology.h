@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace sparta {
+
+namespace numa {
+
+/*
+ * The CPUs of each NUMA node of the host, as read from sysfs. Hosts where the
+ * topology is unknown are reported as a single node without any CPU.
+ */
+inline std::vector<std::vector<int>> read_node_cpus() {
+  std::vector<std::vector<int>> nodes;
+#if defined(__linux__)
+  // Node ids may be sparse, e.g. with offline nodes.
+  for (int node = 0; node < 1024; ++node) {
+    std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) +
+                     "/cpulist");
+    if (!in) {
+      continue;
+    }
+    // The format is a comma-separated list of ranges, e.g. "0-15,32-47".
+    std::vector<int> cpus;
+    std::string range;
+    while (std::getline(in, range, ',')) {
+      int first, last;
+      char dash;
+      std::istringstream range_in(range);
+      if (!(range_in >> first)) {
+        continue;
+      }
+      last = (range_in >> dash >> last) ? last : first;
+      for (int cpu = first; cpu <= last; ++cpu) {
+        cpus.push_back(cpu);
+      }
+    }
+    if (!cpus.empty()) {
+      nodes.push_back(std::move(cpus));
+    }
+  }
+#endif
+  if (nodes.empty()) {
+    nodes.emplace_back();
+  }
+  return nodes;
+}
+
+inline const std::vector<std::vector<int>>& node_cpus() {
+  static const auto nodes = read_node_cpus();
+  return nodes;
+}
+
+inline std::atomic<bool>& worker_pinning_flag() {
+  static std::atomic<bool> flag{false};
+  return flag;
+}
+
+/*
+ * When enabled, the workers of a work queue are spread over the NUMA nodes in
+ * contiguous blocks, each worker is pinned to the CPUs of its node, and idle
+ * workers steal from workers of their own node first. Data allocated by a
+ * worker then stays local to the node (first touch), and so does most of the
+ * stolen work. This is a no-op on hosts with a single node.
+ */
+inline void set_worker_pinning(bool enabled) {
+  worker_pinning_flag().store(enabled);
+}
+
+inline bool worker_pinning() {
+  return worker_pinning_flag().load() && node_cpus().size() > 1;
+}
+
+inline size_t node_of_worker(size_t worker, size_t num_workers) {
+  return worker * node_cpus().size() / num_workers;
+}
+
+// Pins the calling thread to the CPUs of the given node.
+inline void pin_current_thread_to_node(size_t node) {
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu : node_cpus()[node]) {
+    CPU_SET(cpu, &set);
+  }
+  // Pinning is best effort, e.g. the CPUs may be outside of our cpuset.
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+  (void)node;
+#endif
+}
+
+} // namespace numa
+
+} // namespace sparta
@@ -8,15 +8,18 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <cstdint>
 #include <functional>
 #include <initializer_list>
 #include <iterator>
 #include <limits>
+#include <mutex>
 #include <ostream>
 #include <stack>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
 
 #include <boost/functional/hash.hpp>
@@ -39,6 +42,20 @@ class PatriciaTreeLeaf;
 template <typename IntegerType>
 class PatriciaTreeIterator;
 
+template <typename IntegerType>
+class PatriciaTreeNodeTable;
+
+inline std::atomic<bool> s_hash_consing{false};
+
+enum class SetOperation { UNION, INTERSECTION, DIFFERENCE };
+
+template <typename IntegerType, typename Operation>
+inline boost::intrusive_ptr<PatriciaTree<IntegerType>> memoized(
+    SetOperation op,
+    const boost::intrusive_ptr<PatriciaTree<IntegerType>>& s,
+    const boost::intrusive_ptr<PatriciaTree<IntegerType>>& t,
+    const Operation& operation);
+
 template <typename IntegerType>
 inline bool contains(
     IntegerType key,
@@ -91,6 +108,24 @@ inline boost::intrusive_ptr<PatriciaTree<IntegerType>> diff(
 
 } // namespace pt_impl
 
+/*
+ * Patricia-tree sets can optionally be hash-consed, which is off by default.
+ * While on, all nodes are created through a global node table, so that
+ * structurally equal trees share their nodes, however independently they
+ * were built. Set operations then shortcut on the shared subtrees, and
+ * unions, intersections and differences of large trees are memoized in a small
+ * per-thread cache. This pays off for analyses that keep building the same
+ * sets over and over during fixpoint iteration. Sets built while it was off
+ * stay valid, they just share less.
+ */
+inline void set_patricia_tree_hash_consing(bool enabled) {
+  pt_impl::s_hash_consing.store(enabled, std::memory_order_relaxed);
+}
+
+inline bool patricia_tree_hash_consing() {
+  return pt_impl::s_hash_consing.load(std::memory_order_relaxed);
+}
+
 /*
  * This implementation of sets of integers using Patricia trees is based on the
  * following paper:
@@ -226,17 +261,23 @@ class PatriciaTreeSet final {
   }
 
   PatriciaTreeSet& union_with(const PatriciaTreeSet& other) {
-    m_tree = pt_impl::merge<IntegerType>(m_tree, other.m_tree);
+    m_tree = pt_impl::memoized<IntegerType>(
+        pt_impl::SetOperation::UNION, m_tree, other.m_tree,
+        pt_impl::merge<IntegerType>);
     return *this;
   }
 
   PatriciaTreeSet& intersection_with(const PatriciaTreeSet& other) {
-    m_tree = pt_impl::intersect<IntegerType>(m_tree, other.m_tree);
+    m_tree = pt_impl::memoized<IntegerType>(
+        pt_impl::SetOperation::INTERSECTION, m_tree, other.m_tree,
+        pt_impl::intersect<IntegerType>);
     return *this;
   }
 
   PatriciaTreeSet& difference_with(const PatriciaTreeSet& other) {
-    m_tree = pt_impl::diff<IntegerType>(m_tree, other.m_tree);
+    m_tree = pt_impl::memoized<IntegerType>(
+        pt_impl::SetOperation::DIFFERENCE, m_tree, other.m_tree,
+        pt_impl::diff<IntegerType>);
     return *this;
   }
 
@@ -339,6 +380,23 @@ class PatriciaTree {
 
   void set_hash(size_t h) { m_hash = h; }
 
+  bool is_interned() const { return m_interned; }
+
+  void set_interned() { m_interned = true; }
+
+  // Takes a reference, unless the last one is already gone and the node is
+  // about to be destroyed.
+  bool try_add_ref() const {
+    size_t count = m_reference_count.load(std::memory_order_relaxed);
+    while (count != 0) {
+      if (m_reference_count.compare_exchange_weak(
+              count, count + 1, std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
   friend void intrusive_ptr_add_ref(const PatriciaTree<IntegerType>* p) {
     p->m_reference_count.fetch_add(1, std::memory_order_relaxed);
   }
@@ -346,6 +404,9 @@ class PatriciaTree {
   friend void intrusive_ptr_release(const PatriciaTree<IntegerType>* p) {
     if (p->m_reference_count.fetch_sub(1, std::memory_order_release) == 1) {
       std::atomic_thread_fence(std::memory_order_acquire);
+      if (p->m_interned) {
+        PatriciaTreeNodeTable<IntegerType>::get().forget(p);
+      }
       delete p;
     }
   }
@@ -353,6 +414,7 @@ class PatriciaTree {
  private:
   mutable std::atomic<size_t> m_reference_count{0};
   size_t m_hash;
+  bool m_interned{false};
 };
 
 // This defines an internal node of a Patricia tree. Patricia trees are
@@ -401,6 +463,10 @@ class PatriciaTreeBranch final : public PatriciaTree<IntegerType> {
       IntegerType branching_bit,
       boost::intrusive_ptr<PatriciaTree<IntegerType>> left_tree,
       boost::intrusive_ptr<PatriciaTree<IntegerType>> right_tree) {
+    if (s_hash_consing.load(std::memory_order_relaxed)) {
+      return PatriciaTreeNodeTable<IntegerType>::get().branch(
+          prefix, branching_bit, std::move(left_tree), std::move(right_tree));
+    }
     return new PatriciaTreeBranch<IntegerType>(
         prefix, branching_bit, std::move(left_tree), std::move(right_tree));
   }
@@ -426,6 +492,9 @@ class PatriciaTreeLeaf final : public PatriciaTree<IntegerType> {
 
   static boost::intrusive_ptr<PatriciaTreeLeaf<IntegerType>> make(
       IntegerType key) {
+    if (s_hash_consing.load(std::memory_order_relaxed)) {
+      return PatriciaTreeNodeTable<IntegerType>::get().leaf(key);
+    }
     return new PatriciaTreeLeaf<IntegerType>(key);
   }
 
@@ -433,6 +502,150 @@ class PatriciaTreeLeaf final : public PatriciaTree<IntegerType> {
   IntegerType m_key;
 };
 
+// The global table of hash-consed nodes. It only holds raw pointers; a node
+// removes itself when its last reference goes away. Children of hash-consed
+// nodes are hash-consed themselves, so nodes are equal iff their fields and the
+// addresses of their children are.
+template <typename IntegerType>
+class PatriciaTreeNodeTable final {
+ public:
+  static PatriciaTreeNodeTable& get() {
+    // Leaked, so that trees which outlive static destruction can still remove
+    // their nodes.
+    static auto* table = new PatriciaTreeNodeTable();
+    return *table;
+  }
+
+  boost::intrusive_ptr<PatriciaTreeLeaf<IntegerType>> leaf(IntegerType key) {
+    return intern<PatriciaTreeLeaf<IntegerType>>(
+        Key{key, 0, nullptr, nullptr},
+        [&]() { return new PatriciaTreeLeaf<IntegerType>(key); });
+  }
+
+  boost::intrusive_ptr<PatriciaTreeBranch<IntegerType>> branch(
+      IntegerType prefix,
+      IntegerType branching_bit,
+      boost::intrusive_ptr<PatriciaTree<IntegerType>> left_tree,
+      boost::intrusive_ptr<PatriciaTree<IntegerType>> right_tree) {
+    Key key{prefix, branching_bit, left_tree.get(), right_tree.get()};
+    return intern<PatriciaTreeBranch<IntegerType>>(key, [&]() {
+      return new PatriciaTreeBranch<IntegerType>(
+          prefix, branching_bit, std::move(left_tree), std::move(right_tree));
+    });
+  }
+
+  void forget(const PatriciaTree<IntegerType>* node) {
+    auto key = key_of(node);
+    auto& shard = shard_of(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.nodes.find(key);
+    // The entry may have been replaced by an equal node while this one was on
+    // its way out.
+    if (it != shard.nodes.end() && it->second == node) {
+      shard.nodes.erase(it);
+    }
+  }
+
+ private:
+  // Leaves have a branching bit of 0, which no branch has.
+  struct Key {
+    IntegerType prefix_or_key;
+    IntegerType branching_bit;
+    const PatriciaTree<IntegerType>* left;
+    const PatriciaTree<IntegerType>* right;
+
+    bool operator==(const Key& other) const {
+      return prefix_or_key == other.prefix_or_key &&
+             branching_bit == other.branching_bit && left == other.left &&
+             right == other.right;
+    }
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key& key) const {
+      size_t seed = 0;
+      boost::hash_combine(seed, key.prefix_or_key);
+      boost::hash_combine(seed, key.branching_bit);
+      boost::hash_combine(seed, key.left);
+      boost::hash_combine(seed, key.right);
+      return seed;
+    }
+  };
+
+  struct Shard {
+    std::mutex mutex;
+    std::unordered_map<Key, const PatriciaTree<IntegerType>*, KeyHash> nodes;
+  };
+
+  static constexpr size_t NUM_SHARDS = 64;
+
+  static Key key_of(const PatriciaTree<IntegerType>* node) {
+    if (node->is_leaf()) {
+      auto leaf = static_cast<const PatriciaTreeLeaf<IntegerType>*>(node);
+      return Key{leaf->key(), 0, nullptr, nullptr};
+    }
+    auto branch = static_cast<const PatriciaTreeBranch<IntegerType>*>(node);
+    return Key{branch->prefix(), branch->branching_bit(),
+               branch->left_tree().get(), branch->right_tree().get()};
+  }
+
+  Shard& shard_of(const Key& key) {
+    return m_shards[KeyHash()(key) % NUM_SHARDS];
+  }
+
+  template <typename Node, typename MakeNode>
+  boost::intrusive_ptr<Node> intern(const Key& key, const MakeNode& make) {
+    auto& shard = shard_of(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.nodes.find(key);
+    if (it != shard.nodes.end() && it->second->try_add_ref()) {
+      auto existing = const_cast<PatriciaTree<IntegerType>*>(it->second);
+      return boost::intrusive_ptr<Node>(static_cast<Node*>(existing),
+                                        /* add_ref */ false);
+    }
+    boost::intrusive_ptr<Node> node = make();
+    node->set_interned();
+    shard.nodes[key] = node.get();
+    return node;
+  }
+
+  std::array<Shard, NUM_SHARDS> m_shards;
+};
+
+template <typename IntegerType, typename Operation>
+inline boost::intrusive_ptr<PatriciaTree<IntegerType>> memoized(
+    SetOperation op,
+    const boost::intrusive_ptr<PatriciaTree<IntegerType>>& s,
+    const boost::intrusive_ptr<PatriciaTree<IntegerType>>& t,
+    const Operation& operation) {
+  // Operations involving a leaf are cheap, and results can only be reused
+  // across independently built trees if they are hash-consed.
+  if (!s_hash_consing.load(std::memory_order_relaxed) || s == nullptr ||
+      t == nullptr || s == t || s->is_leaf() || t->is_leaf()) {
+    return operation(s, t);
+  }
+  // A direct-mapped cache. Its entries keep their trees alive, so that the
+  // addresses cannot be reused by other trees.
+  struct Entry {
+    SetOperation op;
+    boost::intrusive_ptr<PatriciaTree<IntegerType>> s;
+    boost::intrusive_ptr<PatriciaTree<IntegerType>> t;
+    boost::intrusive_ptr<PatriciaTree<IntegerType>> result;
+  };
+  static constexpr size_t CACHE_SIZE = 256;
+  thread_local std::array<Entry, CACHE_SIZE> cache;
+  size_t seed = static_cast<size_t>(op);
+  boost::hash_combine(seed, s.get());
+  boost::hash_combine(seed, t.get());
+  auto& entry = cache[seed % CACHE_SIZE];
+  if (entry.op == op && entry.s == s && entry.t == t) {
+    return entry.result;
+  }
+  auto result = operation(s, t);
+  entry = Entry{op, s, t, result};
+  return result;
+}
+
 template <typename IntegerType>
 boost::intrusive_ptr<PatriciaTreeBranch<IntegerType>> join(
     IntegerType prefix0,
@@ -14,13 +14,19 @@
 #include <cassert>
 #include <chrono>
 #include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
 #include <mutex>
 #include <numeric>
 #include <queue>
 #include <random>
 #include <utility>
+#include <vector>
 
 #include "Arity.h"
+#include "NumaTopology.h"
+#include "ThreadPool.h"
 
 namespace sparta {
 
@@ -43,7 +49,8 @@ namespace workqueue_impl {
  * from being prematurely emptied (if everyone targets thread 0, for example)
  *
  * Each thread should empty its own queue first, so we explicitly set the
- * thread's index as the first element of the list.
+ * thread's index as the first element of the list. With NUMA worker pinning,
+ * the threads of the same node come next.
  */
 inline std::vector<unsigned int> create_permutation(unsigned int num,
                                                     unsigned int thread_idx) {
@@ -54,6 +61,13 @@ inline std::vector<unsigned int> create_permutation(unsigned int num,
       attempts.begin(), attempts.end(), std::default_random_engine(seed));
   std::iter_swap(attempts.begin(),
                  std::find(attempts.begin(), attempts.end(), thread_idx));
+  if (numa::worker_pinning()) {
+    auto node = numa::node_of_worker(thread_idx, num);
+    std::stable_partition(
+        attempts.begin() + 1, attempts.end(), [&](unsigned int idx) {
+          return numa::node_of_worker(idx, num) == node;
+        });
+  }
   return attempts;
 }
 
@@ -134,7 +148,7 @@ class SpartaWorkerState final {
     if (m_state_counters->num_running < m_state_counters->num_all) {
       m_state_counters->waiter->give(1u); // May consider waking all.
     }
-    m_queue.push(task);
+    m_queue.push_back(task);
   }
 
   size_t worker_id() const { return m_id; }
@@ -150,24 +164,61 @@ class SpartaWorkerState final {
   };
 
  private:
+  /*
+   * The owner takes tasks from the front of its queue. Any other worker steals
+   * half of the remaining tasks from the back, runs one and keeps the rest in
+   * its own queue, so that a worker with a long backlog is relieved with a
+   * single steal rather than one task at a time.
+   */
   boost::optional<Input> pop_task(SpartaWorkerState<Input>* other) {
-    std::lock_guard<std::mutex> guard(m_queue_mtx);
-    if (!m_queue.empty()) {
+    std::vector<Input> stolen;
+    {
+      std::lock_guard<std::mutex> guard(m_queue_mtx);
+      if (m_queue.empty()) {
+        return boost::none;
+      }
       other->set_running(true);
-      if (m_queue.size() == 1) {
+      if (other == this) {
+        if (m_queue.size() == 1) {
+          assert(m_state_counters->num_non_empty > 0);
+          --m_state_counters->num_non_empty;
+        }
+        auto task = std::move(m_queue.front());
+        m_queue.pop_front();
+        return task;
+      }
+      size_t num_stolen = (m_queue.size() + 1) / 2;
+      if (num_stolen == m_queue.size()) {
         assert(m_state_counters->num_non_empty > 0);
         --m_state_counters->num_non_empty;
       }
-      auto task = std::move(m_queue.front());
-      m_queue.pop();
-      return task;
+      stolen.reserve(num_stolen);
+      for (size_t i = 0; i < num_stolen; ++i) {
+        stolen.push_back(std::move(m_queue.back()));
+        m_queue.pop_back();
+      }
     }
-    return boost::none;
+    // The thief runs the stolen task that was deepest in the victim's queue
+    // and queues the others in their original order. Only the owner adds to
+    // its queue while running, so this cannot race with another thief's
+    // insertion.
+    auto task = std::move(stolen.back());
+    stolen.pop_back();
+    if (!stolen.empty()) {
+      std::lock_guard<std::mutex> guard(other->m_queue_mtx);
+      if (other->m_queue.empty()) {
+        ++m_state_counters->num_non_empty;
+      }
+      for (auto it = stolen.rbegin(); it != stolen.rend(); ++it) {
+        other->m_queue.push_back(std::move(*it));
+      }
+    }
+    return task;
   }
 
   size_t m_id;
   bool m_running{false};
-  std::queue<Input> m_queue;
+  std::deque<Input> m_queue;
   std::mutex m_queue_mtx;
   workqueue_impl::StateCounters* m_state_counters;
   const bool m_can_push_task{false};
@@ -187,6 +238,10 @@ class SpartaWorkQueue {
   size_t m_insert_idx{0};
   workqueue_impl::StateCounters m_state_counters;
   const bool m_can_push_task{false};
+  // Items added with a cost hint; they are assigned to workers in run_all().
+  std::vector<std::pair<Input, uint64_t>> m_weighted_items;
+
+  void distribute_weighted_items();
 
   void consume(SpartaWorkerState<Input>* state, Input task) {
     m_executor(state, task);
@@ -214,6 +269,14 @@ class SpartaWorkQueue {
   /* Add an item on the queue of the given worker. */
   void add_item(Input task, size_t worker_id);
 
+  /*
+   * Add an item with a hint of its relative cost, e.g. an instruction count.
+   * Before running, weighted items are handed out heaviest first to the
+   * least-loaded worker, so the most expensive items start early instead of
+   * trailing at the end of some queue.
+   */
+  void add_weighted_item(Input task, uint64_t cost);
+
   /**
    * Spawn threads and evaluate function.  This method blocks.
    */
@@ -242,13 +305,51 @@ template <class Input, typename Executor>
 void SpartaWorkQueue<Input, Executor>::add_item(Input task) {
   m_insert_idx = (m_insert_idx + 1) % m_num_threads;
   assert(m_insert_idx < m_states.size());
-  m_states[m_insert_idx]->m_queue.push(task);
+  m_states[m_insert_idx]->m_queue.push_back(task);
 }
 
 template <class Input, typename Executor>
 void SpartaWorkQueue<Input, Executor>::add_item(Input task, size_t worker_id) {
   assert(worker_id < m_states.size());
-  m_states[worker_id]->m_queue.push(task);
+  m_states[worker_id]->m_queue.push_back(task);
+}
+
+template <class Input, typename Executor>
+void SpartaWorkQueue<Input, Executor>::add_weighted_item(Input task,
+                                                         uint64_t cost) {
+  m_weighted_items.emplace_back(std::move(task), cost);
+}
+
+/*
+ * Greedy longest-processing-time-first assignment. The sort is stable and ties
+ * between workers go to the lowest index, so the assignment is deterministic.
+ */
+template <class Input, typename Executor>
+void SpartaWorkQueue<Input, Executor>::distribute_weighted_items() {
+  if (m_weighted_items.empty()) {
+    return;
+  }
+  std::stable_sort(m_weighted_items.begin(),
+                   m_weighted_items.end(),
+                   [](const std::pair<Input, uint64_t>& a,
+                      const std::pair<Input, uint64_t>& b) {
+                     return a.second > b.second;
+                   });
+  using Load = std::pair<uint64_t, size_t>;
+  std::priority_queue<Load, std::vector<Load>, std::greater<Load>> loads;
+  for (size_t i = 0; i < m_num_threads; ++i) {
+    loads.emplace(0, i);
+  }
+  for (auto& item : m_weighted_items) {
+    auto load = loads.top();
+    loads.pop();
+    m_states[load.second]->m_queue.push_back(std::move(item.first));
+    // Count every item as at least one unit so that zero-cost items are
+    // still spread out.
+    loads.emplace(load.first + std::max<uint64_t>(item.second, 1),
+                  load.second);
+  }
+  m_weighted_items.clear();
 }
 
 /*
@@ -257,10 +358,15 @@ void SpartaWorkQueue<Input, Executor>::add_item(Input task, size_t worker_id) {
  */
 template <class Input, typename Executor>
 void SpartaWorkQueue<Input, Executor>::run_all() {
+  distribute_weighted_items();
   m_state_counters.num_non_empty = 0;
   m_state_counters.num_running = 0;
   m_state_counters.waiter->take_all();
   auto worker = [&](SpartaWorkerState<Input>* state, size_t state_idx) {
+    if (numa::worker_pinning()) {
+      numa::pin_current_thread_to_node(
+          numa::node_of_worker(state_idx, m_num_threads));
+    }
     auto attempts =
         workqueue_impl::create_permutation(m_num_threads, state_idx);
     while (true) {
@@ -304,18 +410,8 @@ void SpartaWorkQueue<Input, Executor>::run_all() {
     }
   }
 
-  std::vector<boost::thread> all_threads;
-  all_threads.reserve(m_num_threads);
-  for (size_t i = 0; i < m_num_threads; ++i) {
-    boost::thread::attributes attrs;
-    attrs.set_stack_size(8 * 1024 * 1024);
-    all_threads.emplace_back(attrs,
-                             std::bind<void>(worker, m_states[i].get(), i));
-  }
-
-  for (auto& thread : all_threads) {
-    thread.join();
-  }
+  ThreadPool::get().run(m_num_threads,
+                        [&](size_t i) { worker(m_states[i].get(), i); });
 
   for (size_t i = 0; i < m_num_threads; ++i) {
     assert(m_states[i]->m_queue.empty());
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <boost/thread/thread.hpp>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace sparta {
+
+/*
+ * A process-wide cache of worker threads, so that the many short parallel
+ * sections of a program don't each pay for spawning and joining threads.
+ *
+ * `run(n, fn)` runs fn(0), ..., fn(n - 1) on n distinct threads, and waits for
+ * all of them. Threads park once done, and are reused by later runs. When not
+ * enough threads are parked, e.g. for nested runs, new ones are spawned, so a
+ * run never waits for another one to finish.
+ */
+class ThreadPool final {
+ public:
+  static ThreadPool& get() {
+    static ThreadPool pool;
+    return pool;
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  ~ThreadPool() { release_idle_threads(); }
+
+  void run(size_t n, const std::function<void(size_t)>& fn) {
+    size_t remaining = n;
+    std::mutex done_mutex;
+    std::condition_variable done_cv;
+    auto on_done = [&]() {
+      std::lock_guard<std::mutex> lock(done_mutex);
+      if (--remaining == 0) {
+        done_cv.notify_one();
+      }
+    };
+    for (size_t i = 0; i < n; ++i) {
+      acquire()->assign([&fn, i]() { fn(i); }, on_done);
+    }
+    std::unique_lock<std::mutex> lock(done_mutex);
+    done_cv.wait(lock, [&]() { return remaining == 0; });
+  }
+
+  // Joins all parked threads. Threads of runs in progress are not affected.
+  void release_idle_threads() {
+    std::vector<std::unique_ptr<Worker>> released;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      released = std::move(m_idle);
+      m_idle.clear();
+    }
+    for (auto& worker : released) {
+      worker->shutdown();
+    }
+  }
+
+ private:
+  class Worker {
+   public:
+    explicit Worker(ThreadPool* pool) : m_pool(pool) {
+      boost::thread::attributes attrs;
+      attrs.set_stack_size(8 * 1024 * 1024);
+      m_thread = boost::thread(attrs, [this]() { loop(); });
+    }
+
+    void assign(std::function<void()> task, std::function<void()> on_done) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_task = std::move(task);
+      m_on_done = std::move(on_done);
+      m_cv.notify_one();
+    }
+
+    void shutdown() {
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_shutdown = true;
+        m_cv.notify_one();
+      }
+      m_thread.join();
+    }
+
+   private:
+    void loop() {
+      while (true) {
+        std::function<void()> task;
+        std::function<void()> on_done;
+        {
+          std::unique_lock<std::mutex> lock(m_mutex);
+          m_cv.wait(lock, [this]() { return m_task || m_shutdown; });
+          if (!m_task) {
+            return;
+          }
+          task = std::move(m_task);
+          on_done = std::move(m_on_done);
+          m_task = nullptr;
+        }
+        task();
+        // Park before signaling completion, so that a run following right
+        // after this one can pick this thread up again.
+        m_pool->park(this);
+        on_done();
+      }
+    }
+
+    ThreadPool* m_pool;
+    boost::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::function<void()> m_task;
+    std::function<void()> m_on_done;
+    bool m_shutdown{false};
+  };
+
+  ThreadPool() = default;
+
+  Worker* acquire() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::unique_ptr<Worker> worker;
+    if (m_idle.empty()) {
+      worker = std::make_unique<Worker>(this);
+    } else {
+      worker = std::move(m_idle.back());
+      m_idle.pop_back();
+    }
+    auto* res = worker.get();
+    m_busy.push_back(std::move(worker));
+    return res;
+  }
+
+  void park(Worker* worker) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = m_busy.begin(); it != m_busy.end(); ++it) {
+      if (it->get() == worker) {
+        m_idle.push_back(std::move(*it));
+        *it = std::move(m_busy.back());
+        m_busy.pop_back();
+        return;
+      }
+    }
+  }
+
+  std::mutex m_mutex;
+  std::vector<std::unique_ptr<Worker>> m_idle;
+  std::vector<std::unique_ptr<Worker>> m_busy;
+};
+
+} // namespace sparta
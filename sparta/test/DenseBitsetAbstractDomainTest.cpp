@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "DenseBitsetAbstractDomain.h"
+
+#include <cstdint>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <vector>
+
+#include "AbstractDomainPropertyTest.h"
+
+using namespace sparta;
+
+using Domain = DenseBitsetAbstractDomain<uint32_t>;
+
+INSTANTIATE_TYPED_TEST_CASE_P(DenseBitsetAbstractDomain,
+                              AbstractDomainPropertyTest,
+                              Domain);
+
+template <>
+std::vector<Domain> AbstractDomainPropertyTest<Domain>::non_extremal_values() {
+  Domain e1(1);
+  Domain e2({1, 2, 300});
+  Domain e3({2, 300, 64});
+  return {e1, e2, e3};
+}
+
+TEST(DenseBitsetAbstractDomainTest, latticeOperations) {
+  Domain e1(1);
+  Domain e2({1, 2, 300});
+  Domain e3({2, 300, 64});
+
+  EXPECT_THAT(e1.elements(), ::testing::ElementsAre(1));
+  EXPECT_THAT(e2.elements(), ::testing::ElementsAre(1, 2, 300));
+  EXPECT_THAT(e3.elements(), ::testing::ElementsAre(2, 64, 300));
+
+  std::ostringstream out;
+  out << e2;
+  EXPECT_EQ("[#3]{1, 2, 300}", out.str());
+
+  EXPECT_TRUE(e1.leq(e2));
+  EXPECT_FALSE(e1.leq(e3));
+  EXPECT_FALSE(e2.leq(e1));
+  EXPECT_TRUE(e2.equals(Domain({300, 2, 1})));
+  EXPECT_FALSE(e2.equals(e3));
+
+  EXPECT_THAT(e2.join(e3).elements(), ::testing::ElementsAre(1, 2, 64, 300));
+  EXPECT_TRUE(e1.join(e2).equals(e2));
+  EXPECT_TRUE(e2.join(Domain::bottom()).equals(e2));
+  EXPECT_TRUE(e2.join(Domain::top()).is_top());
+
+  EXPECT_THAT(e2.meet(e3).elements(), ::testing::ElementsAre(2, 300));
+  EXPECT_TRUE(e1.meet(e2).equals(e1));
+  EXPECT_TRUE(e1.meet(e3).elements().empty());
+  EXPECT_FALSE(e1.meet(e3).is_bottom());
+
+  EXPECT_TRUE(e2.contains(300));
+  EXPECT_FALSE(e3.contains(1));
+  EXPECT_FALSE(e3.contains(100000));
+}
+
+TEST(DenseBitsetAbstractDomainTest, destructiveOperations) {
+  Domain e1(1);
+  Domain e2({1, 2, 300});
+
+  e1.add(1000);
+  EXPECT_THAT(e1.elements(), ::testing::ElementsAre(1, 1000));
+  e1.remove(1000);
+  // Trailing empty words don't matter for comparisons.
+  EXPECT_TRUE(e1.equals(Domain(1)));
+  EXPECT_TRUE(e1.leq(Domain(1)));
+  EXPECT_EQ(1, e1.size());
+
+  e1.add({2, 300});
+  EXPECT_TRUE(e1.equals(e2));
+  e1.remove({1, 300});
+  EXPECT_THAT(e1.elements(), ::testing::ElementsAre(2));
+
+  e2.difference_with(Domain({2, 5000}));
+  EXPECT_THAT(e2.elements(), ::testing::ElementsAre(1, 300));
+
+  e2.join_with(Domain::top());
+  EXPECT_TRUE(e2.is_top());
+  e2.add(7);
+  EXPECT_TRUE(e2.is_top());
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "FlatHashMap.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+#include "ConstantAbstractDomain.h"
+#include "HashedAbstractEnvironment.h"
+#include "HashedAbstractPartition.h"
+
+using namespace sparta;
+
+namespace {
+
+using Map = FlatHashMap<uint32_t, std::string>;
+
+void expect_same(const Map& map,
+                 const std::unordered_map<uint32_t, std::string>& expected) {
+  EXPECT_EQ(expected.size(), map.size());
+  size_t visited = 0;
+  for (const auto& p : map) {
+    auto it = expected.find(p.first);
+    ASSERT_NE(it, expected.end());
+    EXPECT_EQ(it->second, p.second);
+    ++visited;
+  }
+  EXPECT_EQ(expected.size(), visited);
+  for (const auto& p : expected) {
+    auto it = map.find(p.first);
+    ASSERT_NE(it, map.end());
+    EXPECT_EQ(p.second, it->second);
+  }
+}
+
+} // namespace
+
+TEST(FlatHashMapTest, basicOperations) {
+  Map map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.begin(), map.end());
+  EXPECT_EQ(map.find(1), map.end());
+  EXPECT_EQ(0, map.erase(1));
+
+  map[1] = "a";
+  map[2] = "b";
+  EXPECT_EQ(2, map.size());
+  EXPECT_EQ("a", map.find(1)->second);
+  EXPECT_FALSE(map.insert({2, "c"}).second);
+  EXPECT_EQ("b", map[2]);
+  EXPECT_EQ(1, map.erase(1));
+  EXPECT_EQ(map.find(1), map.end());
+  EXPECT_EQ(1, map.size());
+
+  Map copy = map;
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(1, copy.count(2));
+}
+
+TEST(FlatHashMapTest, randomOperations) {
+  std::mt19937 rng(0);
+  // A small key range, so that keys get erased and inserted again, and the
+  // table fills up with tombstones.
+  std::uniform_int_distribution<uint32_t> key_dist(0, 499);
+  Map map;
+  std::unordered_map<uint32_t, std::string> expected;
+  for (size_t i = 0; i < 20000; ++i) {
+    uint32_t key = key_dist(rng);
+    if (rng() % 3 == 0) {
+      EXPECT_EQ(expected.erase(key), map.erase(key));
+    } else {
+      expected[key] = std::to_string(i);
+      map[key] = std::to_string(i);
+    }
+    if (i % 1000 == 0) {
+      expect_same(map, expected);
+    }
+  }
+  expect_same(map, expected);
+
+  // Erasing the current entry does not invalidate the iteration.
+  for (auto it = map.begin(); it != map.end();) {
+    if (it->first % 2 == 0) {
+      expected.erase(it->first);
+      auto to_erase = it++;
+      map.erase(to_erase);
+    } else {
+      ++it;
+    }
+  }
+  expect_same(map, expected);
+
+  Map copy(map);
+  expect_same(copy, expected);
+  Map moved(std::move(copy));
+  expect_same(moved, expected);
+}
+
+TEST(FlatHashMapTest, abstractDomains) {
+  using Domain = ConstantAbstractDomain<int>;
+  using Partition =
+      HashedAbstractPartition<uint32_t, Domain, std::hash<uint32_t>,
+                              std::equal_to<uint32_t>, FlatHashMap>;
+  using Environment =
+      HashedAbstractEnvironment<uint32_t, Domain, std::hash<uint32_t>,
+                                std::equal_to<uint32_t>, FlatHashMap>;
+
+  Partition p1({{1, Domain(1)}, {2, Domain(2)}, {3, Domain(3)}});
+  Partition p2({{2, Domain(2)}, {3, Domain(4)}, {4, Domain(4)}});
+  Partition join = p1.join(p2);
+  EXPECT_EQ(4, join.size());
+  EXPECT_TRUE(join.get(3).is_top());
+  EXPECT_EQ(2, *join.get(2).get_constant());
+  Partition meet = p1.meet(p2);
+  EXPECT_EQ(1, meet.size());
+  EXPECT_TRUE(meet.leq(p1));
+  EXPECT_TRUE(p1.leq(join));
+
+  Environment e1({{1, Domain(1)}, {2, Domain(2)}, {3, Domain(3)}});
+  Environment e2({{2, Domain(2)}, {3, Domain(4)}, {4, Domain(4)}});
+  Environment env_join = e1.join(e2);
+  EXPECT_EQ(1, env_join.size());
+  EXPECT_EQ(2, *env_join.get(2).get_constant());
+  EXPECT_TRUE(env_join.get(1).is_top());
+  EXPECT_TRUE(e1.leq(env_join));
+  EXPECT_TRUE(e1.meet(e2).is_bottom());
+  e1.update(5, [](Domain* d) { *d = Domain(5); });
+  EXPECT_EQ(4, e1.size());
+}
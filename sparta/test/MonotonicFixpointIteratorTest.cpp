@@ -299,7 +299,8 @@ class MonotonicFixpointIteratorLivenessTest : public ::testing::Test {
 using LivenessFixpoints = ::testing::Types<
     liveness::FixpointEngine<sparta::WTOMonotonicFixpointIterator>,
     liveness::FixpointEngine<sparta::MonotonicFixpointIterator>,
-    liveness::FixpointEngine<sparta::ParallelMonotonicFixpointIterator>>;
+    liveness::FixpointEngine<sparta::ParallelMonotonicFixpointIterator>,
+    liveness::FixpointEngine<sparta::SccParallelMonotonicFixpointIterator>>;
 TYPED_TEST_CASE(MonotonicFixpointIteratorLivenessTest, LivenessFixpoints);
 
 TYPED_TEST(MonotonicFixpointIteratorLivenessTest, program1) {
@@ -759,7 +760,8 @@ class MonotonicFixpointIteratorNumericalTest : public ::testing::Test {};
 using NumericalFixpoints = ::testing::Types<
     numerical::FixpointEngine<sparta::WTOMonotonicFixpointIterator>,
     numerical::FixpointEngine<sparta::MonotonicFixpointIterator>,
-    numerical::FixpointEngine<sparta::ParallelMonotonicFixpointIterator>>;
+    numerical::FixpointEngine<sparta::ParallelMonotonicFixpointIterator>,
+    numerical::FixpointEngine<sparta::SccParallelMonotonicFixpointIterator>>;
 TYPED_TEST_CASE(MonotonicFixpointIteratorNumericalTest, NumericalFixpoints);
 
 TYPED_TEST(MonotonicFixpointIteratorNumericalTest, program1) {
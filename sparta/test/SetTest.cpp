@@ -273,3 +273,37 @@ TYPED_TEST(UInt64SetTest, setOfUnsignedInt64) {
     EXPECT_EQ(1, values.count(x));
   }
 }
+
+TEST(PatriciaTreeSetHashConsingTest, sharing) {
+  set_patricia_tree_hash_consing(true);
+  {
+    PatriciaTreeSet<uint32_t> s1, s2, s3;
+    for (uint32_t x : {1, 5, 17, 300, 4000}) {
+      s1.insert(x);
+    }
+    for (uint32_t x : {4000, 300, 17, 5, 1}) {
+      s2.insert(x);
+    }
+    EXPECT_TRUE(s1.reference_equals(s2));
+
+    // Building the same set through different operations yields the same
+    // tree.
+    for (uint32_t x : {1, 5, 17}) {
+      s3.insert(x);
+    }
+    PatriciaTreeSet<uint32_t> s4{300, 4000};
+    auto u1 = s3.get_union_with(s4);
+    auto u2 = s3.get_union_with(s4);
+    EXPECT_TRUE(u1.reference_equals(s1));
+    EXPECT_TRUE(u1.reference_equals(u2));
+
+    EXPECT_TRUE(s1.get_difference_with(s4).reference_equals(s3));
+    EXPECT_TRUE(s1.get_intersection_with(s4).reference_equals(s4));
+
+    s2.remove(17);
+    EXPECT_FALSE(s1.reference_equals(s2));
+    s2.insert(17);
+    EXPECT_TRUE(s1.reference_equals(s2));
+  }
+  set_patricia_tree_hash_consing(false);
+}
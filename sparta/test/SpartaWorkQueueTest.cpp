@@ -99,3 +99,41 @@ TEST(SpartaWorkQueueTest, preciseScheduling) {
     ASSERT_EQ(1, array[idx]);
   }
 }
+
+TEST(SpartaWorkQueueTest, weightedScheduling) {
+  constexpr size_t num_threads{4};
+  std::array<int, NUM_INTS> array = {0};
+
+  auto wq = sparta::work_queue<int*>([](int* a) { (*a)++; }, num_threads);
+
+  for (int idx = 0; idx < NUM_INTS; ++idx) {
+    wq.add_weighted_item(&array[idx], /* cost */ idx % 7);
+  }
+  wq.run_all();
+  for (int idx = 0; idx < NUM_INTS; ++idx) {
+    ASSERT_EQ(1, array[idx]);
+  }
+}
+
+// All work starts on one worker; the others have to steal it, including the
+// tasks that it pushes while running.
+TEST(SpartaWorkQueueTest, stealFromSingleQueue) {
+  constexpr size_t num_threads{4};
+  std::array<std::atomic<int>, NUM_INTS> array{};
+  auto wq = sparta::work_queue<int>(
+      [&](sparta::SpartaWorkerState<int>* worker_state, int a) {
+        array[a]++;
+        if (a + 1 < NUM_INTS && a % 2 == 0) {
+          worker_state->push_task(a + 1);
+        }
+      },
+      num_threads,
+      /*push_tasks_while_running=*/true);
+  for (int idx = 0; idx < NUM_INTS; idx += 2) {
+    wq.add_item(idx, /* worker_id */ 0);
+  }
+  wq.run_all();
+  for (int idx = 0; idx < NUM_INTS; ++idx) {
+    ASSERT_EQ(1, array[idx]);
+  }
+}
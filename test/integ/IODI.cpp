@@ -389,10 +389,10 @@ TEST_F(IODITest, sameNameDontUseIODI) {
   for (DexClass* cls : classes) {
     std::unordered_map<std::string, DexMethods> name_to_methods;
     for (DexMethod* method : cls->get_dmethods()) {
-      name_to_methods[method->str()].push_back(method);
+      name_to_methods[method->str_copy()].push_back(method);
     }
     for (DexMethod* method : cls->get_vmethods()) {
-      name_to_methods[method->str()].push_back(method);
+      name_to_methods[method->str_copy()].push_back(method);
     }
 
     for (auto& iter : name_to_methods) {
@@ -423,10 +423,10 @@ TEST_F(IODITest, sameNameIODILayered) {
   for (DexClass* cls : classes) {
     std::unordered_map<std::string, DexMethods> name_to_methods;
     for (DexMethod* method : cls->get_dmethods()) {
-      name_to_methods[method->str()].push_back(method);
+      name_to_methods[method->str_copy()].push_back(method);
     }
     for (DexMethod* method : cls->get_vmethods()) {
-      name_to_methods[method->str()].push_back(method);
+      name_to_methods[method->str_copy()].push_back(method);
     }
 
     for (auto& iter : name_to_methods) {
@@ -477,10 +477,10 @@ TEST_F(IODITest, iodiLayers) {
   for (DexClass* cls : classes) {
     std::unordered_map<std::string, DexMethods> name_to_methods;
     for (DexMethod* method : cls->get_dmethods()) {
-      name_to_methods[method->str()].push_back(method);
+      name_to_methods[method->str_copy()].push_back(method);
     }
     for (DexMethod* method : cls->get_vmethods()) {
-      name_to_methods[method->str()].push_back(method);
+      name_to_methods[method->str_copy()].push_back(method);
     }
 
     for (auto& iter : name_to_methods) {
@@ -567,7 +567,7 @@ class IODIEncodingTest : public IODITest {
       bool is_plain = is_plain_or_iodi_plain(*debug_item);
       for (DexMethod* method : data.second) {
         std::string pretty_name =
-            java_names::internal_to_external(method->get_class()->str());
+            java_names::internal_to_external(method->get_class()->str_copy());
         pretty_name.push_back('.');
         pretty_name += method->str();
         if (layered) {
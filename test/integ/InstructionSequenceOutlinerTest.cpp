@@ -1041,7 +1041,7 @@ TEST_F(InstructionSequenceOutlinerTest, check_positions) {
     for (const auto& classes : dex) {
       for (const auto& cls : classes) {
         for (const auto& m : cls->get_vmethods()) {
-          if (method_names.count(m->get_name()->str())) {
+          if (method_names.count(m->get_name()->str_copy())) {
             methods.push_back(m);
           }
         }
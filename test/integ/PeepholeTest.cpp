@@ -182,7 +182,7 @@ class PeepholeTest : public ::testing::Test {
                              type::_int());
 
     auto ctor =
-        DexMethod::make_method(dex_class->get_type()->str() + ".<init>:()V")
+        DexMethod::make_method(dex_class->get_type()->str_copy() + ".<init>:()V")
             ->make_concrete(ACC_PUBLIC, false);
     return IRInstructionList{
         dasm(OPCODE_NEW_INSTANCE, dex_class->get_type(), {}),
@@ -203,7 +203,7 @@ class PeepholeTest : public ::testing::Test {
                              DexString::make_string("field_name"),
                              type::_int());
     auto ctor =
-        DexMethod::make_method(dex_class->get_type()->str() + ".<init>:()V")
+        DexMethod::make_method(dex_class->get_type()->str_copy() + ".<init>:()V")
             ->make_concrete(ACC_PUBLIC, false);
     return IRInstructionList{
         dasm(OPCODE_NEW_INSTANCE, dex_class->get_type(), {}),
@@ -231,7 +231,7 @@ class PeepholeTest : public ::testing::Test {
                                                 : DexAccessFlags::ACC_PUBLIC);
     dex_class->add_field(field);
     auto ctor =
-        DexMethod::make_method(dex_class->get_type()->str() + ".<init>:()V")
+        DexMethod::make_method(dex_class->get_type()->str_copy() + ".<init>:()V")
             ->make_concrete(ACC_PUBLIC, false);
     return IRInstructionList{
         dasm(OPCODE_NEW_INSTANCE, dex_class->get_type(), {}),
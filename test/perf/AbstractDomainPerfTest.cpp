@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ConstantAbstractDomain.h"
+#include "DenseBitsetAbstractDomain.h"
+#include "FlatHashMap.h"
+#include "HashedAbstractEnvironment.h"
+#include "HashedSetAbstractDomain.h"
+#include "JemallocUtil.h"
+#include "PatriciaTreeMapAbstractEnvironment.h"
+#include "PatriciaTreeSetAbstractDomain.h"
+#include "SmallSortedSetAbstractDomain.h"
+
+/*
+ * Throughput of the basic operations of the sparta set domains and
+ * environments, over a range of sizes and two sharing patterns: unrelated
+ * operands, and operands derived from one another by a few updates (as
+ * happens between the states of consecutive blocks in a fixpoint iteration).
+ * Memory is measured as the growth of the jemalloc heap, and reported as 0
+ * when not running with jemalloc.
+ */
+
+using namespace sparta;
+
+namespace {
+
+constexpr size_t kSizes[] = {8, 64, 1024, 16384};
+// Number of copies made to measure memory.
+constexpr size_t kCopies = 1000;
+
+template <typename Fn>
+double ns_per_op(size_t ops, const Fn& fn) {
+  auto start = std::chrono::steady_clock::now();
+  fn();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() / ops;
+}
+
+// Enough repetitions for each measurement to take a comparable time.
+size_t repetitions(size_t size) { return std::max<size_t>(10, 200000 / size); }
+
+std::vector<uint32_t> random_elements(std::mt19937& rng,
+                                      size_t size,
+                                      uint32_t universe) {
+  std::uniform_int_distribution<uint32_t> dist(0, universe - 1);
+  std::vector<uint32_t> res(size);
+  for (auto& e : res) {
+    e = dist(rng);
+  }
+  return res;
+}
+
+template <typename Domain>
+Domain make_set(const std::vector<uint32_t>& elements) {
+  Domain d;
+  for (auto e : elements) {
+    d.add(e);
+  }
+  return d;
+}
+
+template <typename Domain>
+void bench_set(const std::string& name, size_t max_size) {
+  std::mt19937 rng(0);
+  for (size_t size : kSizes) {
+    if (size > max_size) {
+      break;
+    }
+    // A dense-ish universe, so that joins and meets are not trivial.
+    uint32_t universe = size * 4;
+    auto elements = random_elements(rng, size, universe);
+    size_t reps = repetitions(size);
+
+    Domain a;
+    double insert = ns_per_op(size * reps, [&] {
+      for (size_t r = 0; r < reps; ++r) {
+        a = make_set<Domain>(elements);
+      }
+    });
+    volatile size_t hits = 0;
+    double contains = ns_per_op(size * reps, [&] {
+      for (size_t r = 0; r < reps; ++r) {
+        for (auto e : elements) {
+          hits = hits + a.contains(e);
+        }
+      }
+    });
+
+    auto unrelated = make_set<Domain>(random_elements(rng, size, universe));
+    auto derived = a;
+    for (auto e : random_elements(rng, std::max<size_t>(1, size / 32),
+                                  universe)) {
+      derived.add(e);
+    }
+    for (const auto& pattern :
+         {std::make_pair("unrelated", unrelated),
+          std::make_pair("derived", derived)}) {
+      const auto& b = pattern.second;
+      volatile bool leq = false;
+      double t_leq = ns_per_op(reps, [&] {
+        for (size_t r = 0; r < reps; ++r) {
+          leq = a.leq(b);
+        }
+      });
+      double t_join = ns_per_op(reps, [&] {
+        for (size_t r = 0; r < reps; ++r) {
+          a.join(b);
+        }
+      });
+      double t_meet = ns_per_op(reps, [&] {
+        for (size_t r = 0; r < reps; ++r) {
+          a.meet(b);
+        }
+      });
+      double t_widen = ns_per_op(reps, [&] {
+        for (size_t r = 0; r < reps; ++r) {
+          a.widening(b);
+        }
+      });
+      printf("%s size=%zu %s: leq %.0f join %.0f meet %.0f widen %.0f ns\n",
+             name.c_str(), size, pattern.first, t_leq, t_join, t_meet,
+             t_widen);
+    }
+
+    std::vector<Domain> copies;
+    copies.reserve(kCopies);
+    auto before = jemalloc_util::get_allocated_bytes();
+    for (size_t i = 0; i < kCopies; ++i) {
+      copies.push_back(a);
+      copies.back().add(universe + i);
+    }
+    auto after = jemalloc_util::get_allocated_bytes();
+    printf("%s size=%zu: insert %.1f contains %.1f ns/elem, "
+           "%.0f bytes/derived copy\n",
+           name.c_str(), size, insert, contains,
+           (double)(after - before) / kCopies);
+  }
+}
+
+template <typename Env>
+void bench_environment(const std::string& name) {
+  using Domain = ConstantAbstractDomain<int>;
+  std::mt19937 rng(0);
+  for (size_t size : kSizes) {
+    auto vars = random_elements(rng, size, size * 4);
+    size_t reps = repetitions(size);
+
+    Env a;
+    double set = ns_per_op(size * reps, [&] {
+      for (size_t r = 0; r < reps; ++r) {
+        a = Env();
+        for (auto v : vars) {
+          a.set(v, Domain(v % 7));
+        }
+      }
+    });
+    volatile size_t tops = 0;
+    double get = ns_per_op(size * reps, [&] {
+      for (size_t r = 0; r < reps; ++r) {
+        for (auto v : vars) {
+          tops = tops + a.get(v).is_top();
+        }
+      }
+    });
+
+    Env unrelated;
+    for (auto v : random_elements(rng, size, size * 4)) {
+      unrelated.set(v, Domain(v % 7));
+    }
+    auto derived = a;
+    for (auto v :
+         random_elements(rng, std::max<size_t>(1, size / 32), size * 4)) {
+      derived.set(v, Domain(v % 5));
+    }
+    for (const auto& pattern :
+         {std::make_pair("unrelated", unrelated),
+          std::make_pair("derived", derived)}) {
+      const auto& b = pattern.second;
+      volatile bool leq = false;
+      double t_leq = ns_per_op(reps, [&] {
+        for (size_t r = 0; r < reps; ++r) {
+          leq = a.leq(b);
+        }
+      });
+      double t_join = ns_per_op(reps, [&] {
+        for (size_t r = 0; r < reps; ++r) {
+          a.join(b);
+        }
+      });
+      double t_meet = ns_per_op(reps, [&] {
+        for (size_t r = 0; r < reps; ++r) {
+          a.meet(b);
+        }
+      });
+      double t_widen = ns_per_op(reps, [&] {
+        for (size_t r = 0; r < reps; ++r) {
+          a.widening(b);
+        }
+      });
+      printf("%s size=%zu %s: leq %.0f join %.0f meet %.0f widen %.0f ns\n",
+             name.c_str(), size, pattern.first, t_leq, t_join, t_meet,
+             t_widen);
+    }
+
+    std::vector<Env> copies;
+    copies.reserve(kCopies);
+    auto before = jemalloc_util::get_allocated_bytes();
+    for (size_t i = 0; i < kCopies; ++i) {
+      copies.push_back(a);
+      copies.back().set(vars[i % size], Domain(-1));
+    }
+    auto after = jemalloc_util::get_allocated_bytes();
+    printf("%s size=%zu: set %.1f get %.1f ns/var, %.0f bytes/derived copy\n",
+           name.c_str(), size, set, get, (double)(after - before) / kCopies);
+  }
+}
+
+} // namespace
+
+TEST(AbstractDomainPerfTest, SetDomains) {
+  bench_set<PatriciaTreeSetAbstractDomain<uint32_t>>("PatriciaTreeSet",
+                                                     SIZE_MAX);
+  bench_set<HashedSetAbstractDomain<uint32_t>>("HashedSet", SIZE_MAX);
+  bench_set<DenseBitsetAbstractDomain<uint32_t>>("DenseBitset", SIZE_MAX);
+  // Goes to top beyond its maximum count.
+  bench_set<SmallSortedSetAbstractDomain<uint32_t, 64>>("SmallSortedSet", 64);
+}
+
+TEST(AbstractDomainPerfTest, Environments) {
+  bench_environment<PatriciaTreeMapAbstractEnvironment<
+      uint32_t, ConstantAbstractDomain<int>>>("PatriciaTreeMapEnvironment");
+  bench_environment<
+      HashedAbstractEnvironment<uint32_t, ConstantAbstractDomain<int>>>(
+      "HashedEnvironment");
+  bench_environment<HashedAbstractEnvironment<uint32_t,
+                                              ConstantAbstractDomain<int>,
+                                              std::hash<uint32_t>,
+                                              std::equal_to<uint32_t>,
+                                              FlatHashMap>>(
+      "FlatHashedEnvironment");
+}
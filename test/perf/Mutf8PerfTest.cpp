@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+#include <sys/time.h>
+#include <vector>
+
+#include "DexEncoding.h"
+
+namespace {
+
+unsigned long long get_time_in_ms() {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  unsigned long long microsec = tv.tv_usec;
+  unsigned long long sec = tv.tv_sec;
+  return microsec / 1000 + sec * 1000;
+}
+
+uint32_t length_by_code_point(const char* s) {
+  uint32_t len = 0;
+  while (*s != '\0') {
+    ++len;
+    mutf8_next_code_point(s);
+  }
+  return len;
+}
+
+} // namespace
+
+TEST(Mutf8PerfTest, Length) {
+  const int iter = 10000000;
+  const std::vector<std::string> strs = {
+      "Lcom/some/class/name;",
+      "Lcom/some/class/name;.methodname:(ILjava/lang/String;)V",
+      "A/x",
+      "this string is very long very long very long very long",
+      "caf\303\251 na\303\257ve r\303\251sum\303\251",
+      "mostly ascii with a single \340\240\200 in the middle of it",
+  };
+  unsigned long long result1 = 0;
+  unsigned long long result2 = 0;
+  unsigned long long ts1 = get_time_in_ms();
+  for (int i = 0; i < iter; i++) {
+    for (const auto& s : strs) {
+      result1 += length_by_code_point(s.c_str());
+    }
+  }
+  unsigned long long ts2 = get_time_in_ms();
+  for (int i = 0; i < iter; i++) {
+    for (const auto& s : strs) {
+      result2 += length_of_utf8_string(s.c_str(), s.size());
+    }
+  }
+  unsigned long long ts3 = get_time_in_ms();
+  printf("Execution time (ms) by code point: %llu word at a time: %llu\n",
+         ts2 - ts1, ts3 - ts2);
+  EXPECT_EQ(result1, result2);
+}
@@ -11,6 +11,7 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -151,14 +152,23 @@ class FixpointEngine final
   const Program& m_program;
 };
 
+template <template <typename GraphInterface, typename Domain, typename NodeHash>
+          class FixpointIteratorBase>
 class ParallelFixpointEngine final
-    : public ParallelMonotonicFixpointIterator<
+    : public FixpointIteratorBase<
           BackwardsFixpointIterationAdaptor<ProgramInterface>,
-          LivenessDomain> {
+          LivenessDomain,
+          std::hash<uint32_t>> {
+ private:
+  using Base =
+      FixpointIteratorBase<BackwardsFixpointIterationAdaptor<ProgramInterface>,
+                           LivenessDomain,
+                           std::hash<uint32_t>>;
+  using EdgeId = typename Base::EdgeId;
+
  public:
   explicit ParallelFixpointEngine(const Program& program, uint32_t num_core)
-      : ParallelMonotonicFixpointIterator(program, num_core),
-        m_program(program) {}
+      : Base(program, num_core), m_program(program) {}
 
   void analyze_node(const uint32_t& node,
                     LivenessDomain* current_state) const override {
@@ -182,11 +192,15 @@ class ParallelFixpointEngine final
 
 class MonotonicFixpointIteratorTest {
  public:
-  MonotonicFixpointIteratorTest() : m_program1(1) {}
+  MonotonicFixpointIteratorTest() : m_program1(1), m_program2(1) {}
 
-  void SetUp() { build_program1(); }
+  void SetUp() {
+    build_program1();
+    build_program2();
+  }
 
   Program m_program1;
+  Program m_program2;
 
  private:
   /*
@@ -210,15 +224,45 @@ class MonotonicFixpointIteratorTest {
     }
     m_program1.set_exit(2001);
   }
+
+  /*
+   *  A single large SCC, as in a recursive call graph. The WPO-based
+   *  iterators handle it poorly, so it is kept smaller:
+   *  1: a = 0; Switch to 2-200
+   *     i: b_i = b_{i+1} + a; if (...) goto 2 + i % 10; else goto i + 1;
+   *  201:   return b_2;
+   */
+  void build_program2() {
+    m_program2.add(1, Statement(/* use: */ {}, /* def: */ {0}));
+    for (uint32_t i = 2; i <= 200; ++i) {
+      m_program2.add(i, Statement(/* use: */ {0, i + 1}, /* def: */ {i}));
+    }
+    m_program2.add(201, Statement(/* use: */ {2}, /* def: */ {}));
+    for (uint32_t i = 2; i <= 200; ++i) {
+      m_program2.add_edge(1, i);
+      m_program2.add_edge(i, i == 200 ? 2 : i + 1);
+      m_program2.add_edge(i, 2 + i % 10);
+    }
+    m_program2.add_edge(200, 201);
+    m_program2.set_exit(201);
+  }
 };
 
-double calculate_speedup(const MonotonicFixpointIteratorTest& test,
-                         uint32_t num_core) {
-  using namespace std::placeholders;
-  ParallelFixpointEngine para_fp(test.m_program1, num_core);
+template <typename Engine>
+double measure(const Program& program,
+               uint32_t num_nodes,
+               uint32_t num_core,
+               const FixpointEngine& expected) {
+  Engine para_fp(program, num_core);
   auto para_start = std::chrono::high_resolution_clock::now();
   para_fp.run(LivenessDomain());
   auto para_end = std::chrono::high_resolution_clock::now();
+  for (uint32_t node = 1; node <= num_nodes; ++node) {
+    if (!para_fp.get_exit_state_at(node).equals(
+            expected.get_exit_state_at(node))) {
+      printf("Mismatch at node %u\n", node);
+    }
+  }
 
   double duration2 = std::chrono::duration_cast<std::chrono::microseconds>(
                          para_end - para_start)
@@ -226,18 +270,32 @@ double calculate_speedup(const MonotonicFixpointIteratorTest& test,
   return duration2;
 }
 
-int main() {
-  printf("Begin!\n");
-  MonotonicFixpointIteratorTest test;
-  test.SetUp();
-  FixpointEngine fp(test.m_program1);
+void measure_speedups(const char* name,
+                      const Program& program,
+                      uint32_t num_nodes) {
+  FixpointEngine fp(program);
   auto single_start = std::chrono::high_resolution_clock::now();
   fp.run(LivenessDomain());
   auto single_end = std::chrono::high_resolution_clock::now();
   double duration1 = std::chrono::duration_cast<std::chrono::microseconds>(
                          single_end - single_start)
                          .count();
+  printf("%s: cores wpo-speedup scc-speedup\n", name);
   for (uint32_t i = 1; i <= redex_parallel::default_num_threads(); ++i) {
-    printf("%u %lf\n", i, duration1 / calculate_speedup(test, i));
+    auto wpo =
+        measure<ParallelFixpointEngine<ParallelMonotonicFixpointIterator>>(
+            program, num_nodes, i, fp);
+    auto scc =
+        measure<ParallelFixpointEngine<SccParallelMonotonicFixpointIterator>>(
+            program, num_nodes, i, fp);
+    printf("%u %lf %lf\n", i, duration1 / wpo, duration1 / scc);
   }
 }
+
+int main() {
+  printf("Begin!\n");
+  MonotonicFixpointIteratorTest test;
+  test.SetUp();
+  measure_speedups("program1", test.m_program1, 2001);
+  measure_speedups("program2", test.m_program2, 201);
+}
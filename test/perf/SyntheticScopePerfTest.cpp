@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <json/json.h>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "CommonSubexpressionEliminationPass.h"
+#include "Creators.h"
+#include "DexClass.h"
+#include "IRAssembler.h"
+#include "InterDexPass.h"
+#include "MethodInlinePass.h"
+#include "PassManager.h"
+#include "RedexTest.h"
+#include "RedexTestUtils.h"
+#include "RegAlloc.h"
+
+/*
+ * End-to-end pass benchmarks over synthesized scopes. The shape of the scope
+ * is parameterized, and the number of classes is multiplied by the
+ * REDEX_SYNTHETIC_SCALE environment variable (default 1), so that pass
+ * scaling can be measured at 1x/10x/100x app size without real APKs.
+ */
+
+namespace {
+
+struct SyntheticScopeConfig {
+  size_t num_classes{1000};
+  // Class i extends a class of depth in [0, max_hierarchy_depth).
+  size_t max_hierarchy_depth{6};
+  size_t methods_per_class{8};
+  // Method bodies have between min and max straight-line blocks.
+  size_t min_method_blocks{1};
+  size_t max_method_blocks{24};
+  // Probabilities, per block, of a call, a switch and a try region.
+  double call_density{0.3};
+  double switch_density{0.05};
+  double try_density{0.05};
+  uint32_t seed{0};
+};
+
+unsigned long long get_time_in_ms() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+size_t get_scale() {
+  auto scale = std::getenv("REDEX_SYNTHETIC_SCALE");
+  return scale == nullptr ? 1 : std::max(1, std::atoi(scale));
+}
+
+std::string class_name(size_t i) { return "LSyn" + std::to_string(i) + ";"; }
+
+std::string method_name(size_t cls, size_t m) {
+  return class_name(cls) + ".m" + std::to_string(m) + ":(I)I";
+}
+
+class SyntheticScopeGenerator {
+ public:
+  explicit SyntheticScopeGenerator(const SyntheticScopeConfig& config)
+      : m_config(config), m_rng(config.seed) {}
+
+  DexClasses generate() {
+    DexClasses classes;
+    std::vector<std::vector<size_t>> classes_by_depth(
+        m_config.max_hierarchy_depth);
+    for (size_t i = 0; i < m_config.num_classes; ++i) {
+      size_t depth = pick(m_config.max_hierarchy_depth);
+      while (depth > 0 && classes_by_depth[depth - 1].empty()) {
+        --depth;
+      }
+      ClassCreator cc(DexType::make_type(class_name(i).c_str()));
+      cc.set_access(ACC_PUBLIC);
+      if (depth == 0) {
+        cc.set_super(type::java_lang_Object());
+      } else {
+        const auto& supers = classes_by_depth[depth - 1];
+        cc.set_super(DexType::make_type(
+            class_name(supers[pick(supers.size())]).c_str()));
+      }
+      classes_by_depth[depth].push_back(i);
+      for (size_t m = 0; m < m_config.methods_per_class; ++m) {
+        cc.add_method(assembler::method_from_string(make_method(i, m)));
+      }
+      classes.push_back(cc.create());
+    }
+    return classes;
+  }
+
+ private:
+  size_t pick(size_t n) {
+    return std::uniform_int_distribution<size_t>(0, n - 1)(m_rng);
+  }
+
+  bool flip(double p) { return std::bernoulli_distribution(p)(m_rng); }
+
+  std::string make_call() {
+    std::ostringstream out;
+    out << "(invoke-static (v0) \""
+        << method_name(pick(m_config.num_classes),
+                       pick(m_config.methods_per_class))
+        << "\")\n(move-result v0)\n";
+    return out.str();
+  }
+
+  std::string make_method(size_t cls, size_t m) {
+    std::ostringstream out;
+    out << "(method (public static) \"" << method_name(cls, m) << "\"\n(\n";
+    out << "(load-param v0)\n(const v1 " << m << ")\n";
+    size_t blocks = m_config.min_method_blocks +
+                    pick(m_config.max_method_blocks -
+                         m_config.min_method_blocks + 1);
+    for (size_t b = 0; b < blocks; ++b) {
+      out << "(add-int/lit8 v0 v0 " << (b % 100) << ")\n";
+      out << "(mul-int v1 v0 v1)\n(xor-int v0 v0 v1)\n";
+      if (flip(m_config.call_density)) {
+        out << make_call();
+      }
+      if (flip(m_config.switch_density)) {
+        out << "(switch v0 (:s" << b << "_0 :s" << b << "_1 :s" << b
+            << "_2))\n(goto :j" << b << ")\n";
+        for (size_t c = 0; c < 3; ++c) {
+          out << "(:s" << b << "_" << c << " " << c << ")\n";
+          out << "(add-int/lit8 v0 v0 " << (c + 1) << ")\n";
+          out << "(goto :j" << b << ")\n";
+        }
+        out << "(:j" << b << ")\n";
+      }
+      if (flip(m_config.try_density)) {
+        out << "(.try_start t" << b << ")\n" << make_call();
+        out << "(.try_end t" << b << ")\n(goto :c" << b << ")\n";
+        out << "(.catch (t" << b << "))\n(const v0 0)\n";
+        out << "(:c" << b << ")\n";
+      }
+    }
+    out << "(return v0)\n)\n)";
+    return out.str();
+  }
+
+  const SyntheticScopeConfig& m_config;
+  std::mt19937 m_rng;
+};
+
+struct SyntheticScopePerfTest : public RedexTest {
+  void run_timed(const std::string& name, Pass* pass, const Json::Value& cfg) {
+    PassManager manager({pass}, cfg);
+    manager.set_testing_mode();
+    ConfigFiles conf(cfg);
+    conf.set_outdir(m_tmp_dir.path);
+    auto start = get_time_in_ms();
+    manager.run_passes(m_stores, conf);
+    printf("%s: %llu ms\n", name.c_str(), get_time_in_ms() - start);
+  }
+
+  void run(const SyntheticScopeConfig& config) {
+    m_tmp_dir = redex::make_tmp_dir("redex_synthetic_perf_%%%%%%%%");
+    auto start = get_time_in_ms();
+    auto classes = SyntheticScopeGenerator(config).generate();
+    printf("Generated %zu classes in %llu ms\n", classes.size(),
+           get_time_in_ms() - start);
+
+    DexMetadata dm;
+    dm.set_id("classes");
+    DexStore store(dm);
+    store.add_classes(std::move(classes));
+    m_stores.emplace_back(std::move(store));
+
+    run_timed("MethodInlinePass", new MethodInlinePass(), Json::nullValue);
+    run_timed("CommonSubexpressionEliminationPass",
+              new CommonSubexpressionEliminationPass(), Json::nullValue);
+    run_timed("RegAllocPass", new regalloc::RegAllocPass(), Json::nullValue);
+
+    auto jars_dir = boost::filesystem::path(m_tmp_dir.path) / "assets" /
+                    "secondary-program-dex-jars";
+    boost::filesystem::create_directories(jars_dir);
+    Json::Value interdex_cfg;
+    interdex_cfg["apk_dir"] = m_tmp_dir.path;
+    run_timed("InterDexPass",
+              new interdex::InterDexPass(/* register_plugins */ false),
+              interdex_cfg);
+
+    size_t num_dexes = 0;
+    for (auto& s : m_stores) {
+      num_dexes += s.get_dexen().size();
+    }
+    printf("Resulting dexes: %zu\n", num_dexes);
+  }
+
+  redex::TempDir m_tmp_dir;
+  std::vector<DexStore> m_stores;
+};
+
+} // namespace
+
+TEST_F(SyntheticScopePerfTest, Default) {
+  SyntheticScopeConfig config;
+  config.num_classes *= get_scale();
+  run(config);
+}
+
+TEST_F(SyntheticScopePerfTest, DeepHierarchyLargeMethods) {
+  SyntheticScopeConfig config;
+  config.num_classes = 200 * get_scale();
+  config.max_hierarchy_depth = 20;
+  config.min_method_blocks = 32;
+  config.max_method_blocks = 128;
+  config.switch_density = 0.1;
+  config.try_density = 0.1;
+  run(config);
+}
+
+TEST_F(SyntheticScopePerfTest, DenseCallGraph) {
+  SyntheticScopeConfig config;
+  config.num_classes *= get_scale();
+  config.max_method_blocks = 8;
+  config.call_density = 0.9;
+  run(config);
+}
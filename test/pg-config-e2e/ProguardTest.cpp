@@ -56,7 +56,7 @@ DexMethod* find_method_named(const Container& methods,
                              const std::string& name) {
   TRACE(PGR, 8, "==> Searching for method %s", name.c_str());
   auto it = std::find_if(methods.begin(), methods.end(), [&name](DexMethod* m) {
-    const auto& deobfuscated_method = m->get_deobfuscated_name();
+    const auto deobfuscated_method = m->get_deobfuscated_name_copy();
     TRACE(PGR,
           8,
           "====> Comparing against method %s [%s]",
@@ -89,7 +89,7 @@ template <class Container>
 DexField* find_field_named(const Container& fields, const char* name) {
   TRACE(PGR, 8, "==> Searching for field %s", name);
   auto it = std::find_if(fields.begin(), fields.end(), [&name](DexField* f) {
-    auto deobfuscated_field = f->get_deobfuscated_name();
+    auto deobfuscated_field = f->get_deobfuscated_name_copy();
     TRACE(PGR,
           8,
           "====> Comparing against %s [%s] <%s>",
@@ -10,7 +10,9 @@
 #include "RedexTest.h"
 
 #include "AnalysisUsage.h"
+#include "HierarchyAnalysis.h"
 #include "Pass.h"
+#include "ResultPropagation.h"
 
 struct AnalysisUsageTest : public RedexTest {
   template <typename P>
@@ -220,3 +222,25 @@ TEST_F(AnalysisUsageTest, testDependencyChecking) {
     EXPECT_TRUE(exception_caught);
   }
 }
+
+TEST_F(AnalysisUsageTest, testHierarchyAnalysisPreservation) {
+  auto get_preserved_passes = []() {
+    std::unordered_map<AnalysisID, Pass*> ret;
+    ret.emplace(get_analysis_id_by_pass<HierarchyAnalysisPass>(),
+                new HierarchyAnalysisPass());
+    return ret;
+  };
+
+  {
+    auto preserved = get_preserved_passes();
+    run_invalidation_policy_by_pass<ResultPropagationPass>(preserved);
+    EXPECT_EQ(preserved.size(), 1);
+  }
+
+  {
+    auto preserved = get_preserved_passes();
+    run_invalidation_policy_by_pass<ConsumeAnalysisAndInvalidatePass>(
+        preserved);
+    EXPECT_EQ(preserved.size(), 0);
+  }
+}
@@ -42,7 +42,8 @@ void test(const std::string& code_str,
   type_inference.run(method);
   constant_uses::ConstantUses constant_uses(cfg, method);
   int actual_insns_hoisted =
-      BranchPrefixHoistingPass::process_cfg(cfg, type_inference, constant_uses);
+      BranchPrefixHoistingPass::process_cfg(
+          cfg, type_inference.get_type_environments(), constant_uses);
 
   std::cerr << "after:" << std::endl << SHOW(code->cfg());
   EXPECT_EQ(expected_instructions_hoisted, actual_insns_hoisted);
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <boost/filesystem.hpp>
+#include <gtest/gtest.h>
+
+#include "CFGLocalOptimizations.h"
+#include "CFGLocalOptimizationsCache.h"
+#include "ControlFlow.h"
+#include "DexClass.h"
+#include "IRAssembler.h"
+#include "IRCode.h"
+#include "RedexTest.h"
+
+class CFGLocalOptimizationsTest : public RedexTest {};
+
+namespace {
+
+cfg_local_opts::Metrics run_stages(DexMethod* method,
+                                   const std::vector<std::string>& names) {
+  cfg_local_opts::Metrics metrics;
+  auto code = method->get_code();
+  code->build_cfg(/* editable */ true);
+  for (const auto& name : names) {
+    auto* stage = cfg_local_opts::get_stage(name);
+    EXPECT_NE(stage, nullptr) << name;
+    stage->make_transform(Json::Value(Json::objectValue))(method, code->cfg(),
+                                                          metrics);
+  }
+  code->clear_cfg();
+  return metrics;
+}
+
+} // namespace
+
+TEST_F(CFGLocalOptimizationsTest, unknown_stage) {
+  EXPECT_EQ(cfg_local_opts::get_stage("NoSuchPass"), nullptr);
+}
+
+TEST_F(CFGLocalOptimizationsTest, stages_share_cfg) {
+  auto method = assembler::method_from_string(R"(
+    (method (public static) "LFoo;.bar:(I)I"
+      (
+        (load-param v0)
+        (if-eqz v0 :true)
+
+        (const v1 0)
+
+        (:end)
+        (return v1)
+
+        (:true)
+        (const v1 1)
+        (goto :end)
+      )
+    )
+  )");
+  auto metrics =
+      run_stages(method, {"UpCodeMotionPass", "BranchPrefixHoistingPass"});
+  EXPECT_EQ(metrics.values["num_instructions_moved"], 1);
+  EXPECT_EQ(metrics.values["num_branches_moved_over"], 1);
+  EXPECT_EQ(metrics.values["num_instructions_hoisted"], 0);
+
+  auto expected = assembler::ircode_from_string(R"(
+    (
+      (load-param v0)
+      (const v1 1)
+      (if-eqz v0 :end)
+
+      (const v1 0)
+
+      (:end)
+      (return v1)
+    )
+  )");
+  EXPECT_CODE_EQ(method->get_code(), expected.get());
+}
+
+TEST_F(CFGLocalOptimizationsTest, cache_keeps_used_entries) {
+  auto path = (boost::filesystem::temp_directory_path() /
+               boost::filesystem::unique_path("cfg-local-opts-%%%%-%%%%.bin"))
+                  .string();
+  using cfg_local_opts::Cache;
+  auto key_a = Cache::make_key({"a", "b"});
+  auto key_b = Cache::make_key({"ab"});
+  auto key_c = Cache::make_key({"c"});
+  EXPECT_NE(key_a, key_b);
+
+  {
+    Cache cache(path);
+    EXPECT_EQ(cache.loaded_size(), 0);
+    EXPECT_FALSE(cache.get(key_a));
+    cache.put(key_a, "value a");
+    cache.put(key_b, "value b");
+    EXPECT_EQ(*cache.get(key_a), "value a");
+    cache.save();
+  }
+  {
+    Cache cache(path);
+    EXPECT_EQ(cache.loaded_size(), 2);
+    EXPECT_EQ(*cache.get(key_b), "value b");
+    EXPECT_FALSE(cache.get(key_c));
+    cache.put(key_c, "value c");
+    cache.save();
+  }
+  {
+    // Entries which were not used in the last build are dropped.
+    Cache cache(path);
+    EXPECT_EQ(cache.loaded_size(), 2);
+    EXPECT_FALSE(cache.get(key_a));
+    EXPECT_EQ(*cache.get(key_b), "value b");
+    EXPECT_EQ(*cache.get(key_c), "value c");
+  }
+  boost::filesystem::remove(path);
+}
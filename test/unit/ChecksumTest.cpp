@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+#include "Adler32.h"
+#include "Sha1.h"
+
+namespace {
+
+std::string sha1_hex(const unsigned char* data, size_t size, size_t chunk) {
+  Sha1Context context;
+  sha1_init(&context);
+  for (size_t offset = 0; offset < size; offset += chunk) {
+    sha1_update(&context, data + offset,
+                (unsigned int)std::min(chunk, size - offset));
+  }
+  unsigned char digest[20];
+  sha1_final(digest, &context);
+  std::string hex;
+  for (auto byte : digest) {
+    char buf[3];
+    snprintf(buf, sizeof(buf), "%02x", byte);
+    hex += buf;
+  }
+  return hex;
+}
+
+std::vector<uint8_t> random_bytes(size_t size) {
+  std::mt19937 rng(size);
+  std::vector<uint8_t> bytes(size);
+  for (auto& b : bytes) {
+    b = (uint8_t)rng();
+  }
+  return bytes;
+}
+
+} // namespace
+
+TEST(ChecksumTest, sha1) {
+  std::string abc = "abc";
+  EXPECT_EQ(sha1_hex((const unsigned char*)abc.data(), abc.size(), 64),
+            "a9993e364706816aba3e25717850c26c9cd0d89d");
+
+  // Long enough to go through the multi-block path, fed in various chunks.
+  std::string a(1000000, 'a');
+  for (size_t chunk : {1, 63, 64, 1000, 1000000}) {
+    EXPECT_EQ(sha1_hex((const unsigned char*)a.data(), a.size(), chunk),
+              "34aa973cd4c4daa4f61eeb2bdbad27316534016f");
+  }
+}
+
+TEST(ChecksumTest, adler32) {
+  for (size_t size : {0, 1, 31, 32, 33, 5535, 5552, 5553, 100000}) {
+    auto bytes = random_bytes(size);
+    auto expected = (uint32_t)adler32(1, bytes.data(), (uInt)size);
+    EXPECT_EQ(adler32_update(kAdler32Init, bytes.data(), size), expected)
+        << size;
+
+    auto split = size / 3;
+    auto partial = adler32_update(kAdler32Init, bytes.data(), split);
+    EXPECT_EQ(adler32_update(partial, bytes.data() + split, size - split),
+              expected)
+        << size;
+
+    // All-0xff input maximizes the sums between reductions.
+    std::vector<uint8_t> ones(size, 0xff);
+    EXPECT_EQ(adler32_update(kAdler32Init, ones.data(), size),
+              (uint32_t)adler32(1, ones.data(), (uInt)size))
+        << size;
+  }
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "CodeSpill.h"
+
+#include <boost/filesystem.hpp>
+#include <gtest/gtest.h>
+
+#include "Creators.h"
+#include "IRAssembler.h"
+#include "IRCode.h"
+#include "RedexTest.h"
+
+class CodeSpillTest : public RedexTest {
+ public:
+  std::string spill_path() {
+    auto path = boost::filesystem::temp_directory_path() /
+                boost::filesystem::unique_path("code-spill-%%%%-%%%%.bin");
+    return path.string();
+  }
+};
+
+TEST_F(CodeSpillTest, roundtrip) {
+  auto method = assembler::method_from_string(R"(
+    (method (public static) "LFoo;.bar:(I)I"
+      (
+        (load-param v0)
+        (.pos:dbg_0 "LFoo;.bar:(I)I" "Foo.java" 10)
+        (.src_block "LFoo;.bar:(I)I" 0 (0.5 0.25))
+        (.try_start a)
+        (invoke-static (v0) "LFoo;.baz:(I)I")
+        (move-result v1)
+        (.try_end a)
+        (.pos:dbg_1 "LFoo;.baz:(I)I" "Foo.java" 20 dbg_0)
+        (switch v1 (:b :c))
+        (const-string "hello")
+        (move-result-pseudo-object v2)
+        (return v1)
+
+        (:b 1)
+        (const-wide v2 12345678912345)
+        (return v0)
+
+        (:c 2)
+        (.src_block "LFoo;.bar:(I)I" 1 (0.0 0.0) (0.1 0.2))
+        (return v0)
+
+        (.catch (a) "Ljava/lang/Exception;")
+        (const v1 -1)
+        (return v1)
+      )
+    )
+  )");
+  ClassCreator cc(DexType::make_type("LFoo;"));
+  cc.set_super(type::java_lang_Object());
+  cc.add_method(method);
+  auto scope = Scope{cc.create()};
+
+  auto before = assembler::to_string(method->get_code());
+  auto registers = method->get_code()->get_registers_size();
+
+  auto path = spill_path();
+  {
+    code_spill::CodeSpill spill(path);
+    EXPECT_EQ(spill.spill(scope), 1);
+    EXPECT_TRUE(method->is_code_spilled());
+    EXPECT_TRUE(boost::filesystem::exists(path));
+
+    // Spilling again leaves spilled code alone.
+    EXPECT_EQ(spill.spill(scope), 0);
+
+    EXPECT_EQ(assembler::to_string(method->get_code()), before);
+    EXPECT_FALSE(method->is_code_spilled());
+    EXPECT_EQ(method->get_code()->get_registers_size(), registers);
+
+    // Restored code can be spilled again.
+    EXPECT_EQ(spill.spill(scope), 1);
+    EXPECT_TRUE(method->is_code_spilled());
+  }
+  // Destroying the spill brings everything back and removes the file.
+  EXPECT_FALSE(method->is_code_spilled());
+  EXPECT_EQ(assembler::to_string(method->get_code()), before);
+  EXPECT_FALSE(boost::filesystem::exists(path));
+}
+
+TEST_F(CodeSpillTest, skip_cfg) {
+  auto method = assembler::method_from_string(R"(
+    (method (public static) "LBar;.bar:()V"
+      (
+        (return-void)
+      )
+    )
+  )");
+  ClassCreator cc(DexType::make_type("LBar;"));
+  cc.set_super(type::java_lang_Object());
+  cc.add_method(method);
+  auto scope = Scope{cc.create()};
+
+  method->get_code()->build_cfg(/* editable */ true);
+  code_spill::CodeSpill spill(spill_path());
+  EXPECT_EQ(spill.spill(scope), 0);
+  EXPECT_FALSE(method->is_code_spilled());
+  method->get_code()->clear_cfg();
+}
@@ -11,6 +11,7 @@
 
 #include "ControlFlow.h"
 #include "DexAsm.h"
+#include "Dominators.h"
 #include "IRAssembler.h"
 #include "IRCode.h"
 #include "RedexTest.h"
@@ -230,6 +231,60 @@ TEST_F(ControlFlowTest, findExitBlocks) {
   }
 }
 
+TEST_F(ControlFlowTest, blockIdsAfterRemoval) {
+  ControlFlowGraph cfg;
+  auto b0 = cfg.create_block();
+  auto b1 = cfg.create_block();
+  auto b2 = cfg.create_block();
+  auto b3 = cfg.create_block();
+  cfg.set_entry_block(b0);
+  cfg.add_edge(b0, b1, EDGE_GOTO);
+  cfg.add_edge(b1, b3, EDGE_GOTO);
+  cfg.add_edge(b0, b2, EDGE_BRANCH);
+
+  cfg.remove_block(b2);
+  EXPECT_EQ(cfg.blocks(), (std::vector<Block*>{b0, b1, b3}));
+  EXPECT_EQ(cfg.num_blocks(), 3);
+  EXPECT_EQ(cfg.get_block(3), b3);
+
+  // Ids of removed blocks at the end are handed out again.
+  cfg.remove_block(b3);
+  auto b4 = cfg.create_block();
+  EXPECT_EQ(b4->id(), 2);
+  EXPECT_EQ(cfg.blocks(), (std::vector<Block*>{b0, b1, b4}));
+}
+
+TEST(BlockMapTest, holesAndIterators) {
+  std::vector<std::unique_ptr<Block>> storage;
+  for (BlockId id = 0; id < 4; ++id) {
+    storage.push_back(std::make_unique<Block>(nullptr, id));
+  }
+  BlockMap blocks;
+  blocks.emplace(0, storage[0].get());
+  blocks.emplace(2, storage[2].get());
+  EXPECT_EQ(blocks.size(), 2);
+  EXPECT_EQ(blocks.count(1), 0);
+  EXPECT_EQ(blocks.find(1), blocks.end());
+  EXPECT_EQ(blocks.at(2), storage[2].get());
+  EXPECT_THROW(blocks.at(1), std::out_of_range);
+  EXPECT_EQ(blocks.rbegin()->first, 2);
+
+  // end() stays the end when blocks are added.
+  auto end = blocks.end();
+  blocks.emplace(3, storage[3].get());
+  std::vector<BlockId> ids;
+  for (auto it = blocks.begin(); it != end; ++it) {
+    ids.push_back(it->first);
+  }
+  EXPECT_EQ(ids, (std::vector<BlockId>{0, 2, 3}));
+
+  auto it = blocks.erase(blocks.find(2));
+  EXPECT_EQ(it->first, 3);
+  EXPECT_EQ((--it)->first, 0);
+  EXPECT_EQ(blocks.erase(3), 1);
+  EXPECT_EQ(blocks.id_bound(), 1);
+}
+
 TEST_F(ControlFlowTest, iterate1) {
   auto code = assembler::ircode_from_string(R"(
     (
@@ -881,7 +936,7 @@ TEST_F(ControlFlowTest, branchingness) {
   auto& cfg = code->cfg();
   uint16_t blocks_checked = 0;
   for (Block* b : cfg.blocks()) {
-    std::string str = b->get_first_insn()->insn->get_string()->str();
+    std::string str = b->get_first_insn()->insn->get_string()->str_copy();
     if (str == "one") {
       EXPECT_EQ(opcode::BRANCH_IF, b->branchingness());
       ++blocks_checked;
@@ -2515,3 +2570,45 @@ OPCODE: ADD_INT_LIT8 v0, v0, 1
 OPCODE: GOTO
 )");
 }
+
+TEST_F(ControlFlowTest, cachedOrderings) {
+  auto code = assembler::ircode_from_string(R"(
+    (
+      (const v0 0)
+      (if-eqz v0 :true)
+      (const v0 1)
+      (:true)
+      (return v0)
+    )
+  )");
+  code->build_cfg(/* editable */ true);
+  auto& cfg = code->cfg();
+  cfg.calculate_exit_block();
+
+  auto rpo = cfg.reverse_postorder();
+  auto wpo = cfg.forward_wpo();
+  auto backward_wpo = cfg.backward_wpo();
+  auto doms = cfg.dominator_tree();
+  EXPECT_EQ(rpo->size(), 3);
+  EXPECT_EQ(rpo->front(), cfg.entry_block());
+  EXPECT_EQ(wpo->size(), 3);
+  EXPECT_EQ(backward_wpo->size(), 3);
+  EXPECT_EQ(doms->get_idom(rpo->back()), cfg.entry_block());
+
+  // Unchanged, the CFG hands out the same objects again.
+  EXPECT_EQ(cfg.reverse_postorder(), rpo);
+  EXPECT_EQ(cfg.forward_wpo(), wpo);
+  EXPECT_EQ(cfg.backward_wpo(), backward_wpo);
+  EXPECT_EQ(cfg.dominator_tree(), doms);
+
+  // Removing the branch drops them, while the old ones stay usable.
+  auto entry = cfg.entry_block();
+  auto branch = entry->get_last_insn();
+  entry->remove_insn(branch);
+  EXPECT_NE(cfg.reverse_postorder(), rpo);
+  EXPECT_NE(cfg.forward_wpo(), wpo);
+  EXPECT_NE(cfg.dominator_tree(), doms);
+  EXPECT_EQ(rpo->size(), 3);
+
+  code->clear_cfg();
+}
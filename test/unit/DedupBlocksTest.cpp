@@ -11,6 +11,7 @@
 
 #include "ControlFlow.h"
 #include "Creators.h"
+#include "BlockFingerprintIndex.h"
 #include "DedupBlocks.h"
 #include "DexAsm.h"
 #include "DexUtil.h"
@@ -1234,3 +1235,55 @@ TEST_F(DedupBlocksTest, retainPositionWhenMayThrow) {
   auto expected_code = assembler::ircode_from_string(expected_str);
   EXPECT_CODE_EQ(expected_code.get(), method->get_code());
 }
+
+TEST_F(DedupBlocksTest, fingerprintIndexFindsCrossMethodTails) {
+  auto* a = assembler::method_from_string(R"(
+    (method (public static) "LFoo;.a:(I)I"
+     (
+      (load-param v0)
+      (const v1 7)
+      (add-int v1 v0 v1)
+      (return v1)
+     )
+    )
+  )");
+  auto* b = assembler::method_from_string(R"(
+    (method (public static) "LFoo;.b:(I)I"
+     (
+      (load-param v3)
+      (const v2 7)
+      (add-int v2 v3 v2)
+      (return v2)
+     )
+    )
+  )");
+  auto* c = assembler::method_from_string(R"(
+    (method (public static) "LFoo;.c:(I)I"
+     (
+      (load-param v0)
+      (const v1 8)
+      (add-int v1 v0 v1)
+      (return v1)
+     )
+    )
+  )");
+  auto* cls = assembler::class_with_methods("LFoo;", {a, b, c});
+
+  dedup_blocks_impl::BlockFingerprintIndex index({cls});
+  EXPECT_EQ(index.size(), 3);
+  const auto& dups = index.get_cross_method_duplicates();
+  ASSERT_EQ(dups.size(), 1);
+  ASSERT_EQ(dups[0].size(), 2);
+  EXPECT_EQ(dups[0][0].method, a);
+  EXPECT_EQ(dups[0][1].method, b);
+  EXPECT_EQ(dups[0][0].insns, 4);
+
+  auto first_insn = [](DexMethod* method) {
+    return InstructionIterable(method->get_code()).begin()->insn;
+  };
+  auto fingerprint_a = index.get_fingerprint(first_insn(a));
+  ASSERT_TRUE(fingerprint_a);
+  EXPECT_EQ(*fingerprint_a, *index.get_fingerprint(first_insn(b)));
+  EXPECT_NE(*fingerprint_a, *index.get_fingerprint(first_insn(c)));
+  EXPECT_FALSE(a->get_code()->cfg_built());
+}
@@ -172,3 +172,74 @@ TEST_F(DexClassTest, testObfuscatedNames) {
   EXPECT_EQ(field->get_deobfuscated_name(), "Lbaz;.bar:I");
   EXPECT_EQ(field->get_simple_deobfuscated_name(), "bar");
 }
+
+TEST_F(DexClassTest, testStringStorage) {
+  auto* empty = DexString::make_string("");
+  EXPECT_EQ(empty->size(), 0);
+  EXPECT_STREQ(empty->c_str(), "");
+
+  auto* foo = DexString::make_string("foo");
+  EXPECT_EQ(foo, DexString::make_string(std::string("foo")));
+  EXPECT_EQ(foo, DexString::get_string(std::string_view("foobar", 3)));
+  EXPECT_EQ(foo->size(), 3);
+  EXPECT_EQ(foo->str(), "foo");
+  EXPECT_EQ(foo->str_copy(), "foo");
+  EXPECT_EQ(foo->c_str()[3], '\0');
+
+  // Strings larger than an arena chunk, and enough strings to need several
+  // chunks, must stay intact.
+  std::string huge(3 * 1024 * 1024, 'x');
+  auto* huge_str = DexString::make_string(huge);
+  EXPECT_EQ(huge_str->size(), huge.size());
+  EXPECT_EQ(huge_str->str(), huge);
+
+  std::vector<DexString*> strings;
+  for (size_t i = 0; i < 100000; ++i) {
+    strings.push_back(DexString::make_string("string" + std::to_string(i)));
+  }
+  for (size_t i = 0; i < strings.size(); ++i) {
+    EXPECT_EQ(strings[i]->str(), "string" + std::to_string(i));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(strings[i]) % alignof(DexString), 0);
+  }
+  EXPECT_EQ(foo->str(), "foo");
+  EXPECT_EQ(huge_str->str(), huge);
+}
+
+TEST_F(DexClassTest, testBatchInterning) {
+  auto* foo = DexString::make_string("foo");
+  std::vector<std::string> names;
+  for (size_t i = 0; i < 1000; ++i) {
+    names.push_back("batch" + std::to_string(i));
+  }
+  names.emplace_back("foo");
+  names.emplace_back("batch7");
+
+  std::vector<std::pair<const char*, uint32_t>> strs;
+  for (const auto& name : names) {
+    strs.emplace_back(name.c_str(), name.size());
+  }
+  auto dexstrings = g_redex->make_strings(strs);
+  ASSERT_EQ(dexstrings.size(), names.size());
+  for (size_t i = 0; i < names.size(); ++i) {
+    EXPECT_EQ(dexstrings[i]->str(), names[i]);
+    EXPECT_EQ(dexstrings[i], DexString::get_string(names[i]));
+  }
+  EXPECT_EQ(dexstrings[1000], foo);
+  EXPECT_EQ(dexstrings[1001], dexstrings[7]);
+
+  auto* type = DexType::make_type("LFoo;");
+  auto* proto =
+      DexProto::make_proto(type::_void(), DexTypeList::make_type_list({}));
+  auto* existing = DexMethod::make_method(type, dexstrings[0], proto);
+  std::vector<DexMethodSpec> specs;
+  for (auto* name : dexstrings) {
+    specs.emplace_back(type, name, proto);
+  }
+  auto methods = g_redex->make_methods(specs);
+  ASSERT_EQ(methods.size(), specs.size());
+  EXPECT_EQ(methods[0], existing);
+  for (size_t i = 0; i < specs.size(); ++i) {
+    EXPECT_EQ(methods[i], DexMethod::get_method(type, dexstrings[i], proto));
+  }
+  EXPECT_EQ(methods[1001], methods[7]);
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "DexHasher.h"
+
+#include <gtest/gtest.h>
+
+#include "IRAssembler.h"
+#include "IRCode.h"
+#include "RedexTest.h"
+
+struct DexHasherTest : public RedexTest {};
+
+namespace {
+
+bool operator==(const hashing::DexHash& a, const hashing::DexHash& b) {
+  return a.positions_hash == b.positions_hash &&
+         a.registers_hash == b.registers_hash && a.code_hash == b.code_hash &&
+         a.signature_hash == b.signature_hash;
+}
+
+} // namespace
+
+TEST_F(DexHasherTest, cachedHashesMatchUncached) {
+  auto* callee = assembler::method_from_string(R"(
+    (method (public static) "LFoo;.callee:()V"
+     (
+      (return-void)
+     )
+    )
+  )");
+  auto* caller = assembler::method_from_string(R"(
+    (method (public static) "LFoo;.caller:(I)V"
+     (
+      (.pos:dbg_0 "LFoo;.caller:(I)V" "Foo.java" 1)
+      (load-param v0)
+      (invoke-static () "LFoo;.callee:()V")
+      (return-void)
+     )
+    )
+  )");
+  auto* cls = assembler::class_with_methods("LFoo;", {callee, caller});
+  Scope scope{cls};
+
+  hashing::MethodHashCache cache;
+  auto uncached = hashing::DexScopeHasher(scope).run();
+  EXPECT_TRUE(cache.has_changed(caller));
+  EXPECT_TRUE(hashing::DexScopeHasher(scope, &cache).run() == uncached);
+  EXPECT_EQ(cache.misses(), 2);
+  EXPECT_FALSE(cache.has_changed(callee));
+  EXPECT_FALSE(cache.has_changed(caller));
+
+  EXPECT_TRUE(hashing::DexScopeHasher(scope, &cache).run() == uncached);
+  EXPECT_EQ(cache.hits(), 2);
+  EXPECT_EQ(cache.misses(), 2);
+
+  // Changing the code of one method only invalidates that method.
+  callee->get_code()->push_back(new IRInstruction(OPCODE_NOP));
+  EXPECT_TRUE(cache.has_changed(callee));
+  EXPECT_FALSE(cache.has_changed(caller));
+  auto changed = hashing::DexScopeHasher(scope, &cache).run();
+  EXPECT_FALSE(changed.code_hash == uncached.code_hash);
+  EXPECT_TRUE(changed == hashing::DexScopeHasher(scope).run());
+  EXPECT_EQ(cache.misses(), 3);
+
+  // Renaming a referenced method invalidates its callers.
+  DexMethodSpec spec;
+  spec.name = DexString::make_string("renamed");
+  callee->change(spec, /* rename_on_collision */ false);
+  EXPECT_TRUE(cache.has_changed(caller));
+  EXPECT_TRUE(hashing::DexScopeHasher(scope, &cache).run() ==
+              hashing::DexScopeHasher(scope).run());
+}
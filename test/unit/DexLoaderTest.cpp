@@ -6,6 +6,8 @@
  */
 
 #include "DexLoader.h"
+#include "IRAssembler.h"
+#include "IRCode.h"
 #include "RedexTest.h"
 #include <gtest/gtest.h>
 #include <stdint.h>
@@ -48,3 +50,56 @@ TEST_F(DexLoaderTest, align_ptr) {
   EXPECT_EQ(UINTPTR_MAX_ALIGNED, align_ptr(UINTPTR_MAX_ALIGNED - 1, 4));
   EXPECT_EQ(UINTPTR_MAX_ALIGNED, align_ptr(UINTPTR_MAX_ALIGNED - 0, 4));
 }
+
+TEST_F(DexLoaderTest, balloon_lazily) {
+  auto method = assembler::method_from_string(R"(
+    (method (public static) "LFoo;.bar:(I)I"
+      (
+        (load-param v0)
+        (if-eqz v0 :zero)
+        (return v0)
+        (:zero)
+        (const v0 1)
+        (return v0)
+      )
+    )
+  )");
+  auto before = assembler::to_string(method->get_code());
+  method->sync();
+  ASSERT_NE(method->get_dex_code(), nullptr);
+
+  method->balloon_lazily();
+  EXPECT_TRUE(method->is_balloon_pending());
+  EXPECT_NE(method->get_dex_code(), nullptr);
+
+  // The first access to the IRCode balloons it.
+  EXPECT_EQ(assembler::to_string(method->get_code()), before);
+  EXPECT_FALSE(method->is_balloon_pending());
+  EXPECT_EQ(method->get_dex_code(), nullptr);
+}
+
+TEST_F(DexLoaderTest, sync_without_ballooning) {
+  auto method = assembler::method_from_string(R"(
+    (method (public static) "LFoo;.baz:()Ljava/lang/String;"
+      (
+        (const-string "hello")
+        (move-result-pseudo-object v0)
+        (return-object v0)
+      )
+    )
+  )");
+  method->sync();
+  method->balloon_lazily();
+  auto* dex_code = method->get_dex_code();
+
+  // Gathering looks at the loaded code.
+  std::vector<DexString*> strings;
+  method->gather_strings(strings);
+  EXPECT_EQ(strings, std::vector<DexString*>{DexString::make_string("hello")});
+  EXPECT_TRUE(method->is_balloon_pending());
+
+  // Syncing keeps the loaded code.
+  method->sync();
+  EXPECT_FALSE(method->is_balloon_pending());
+  EXPECT_EQ(method->get_dex_code(), dex_code);
+}
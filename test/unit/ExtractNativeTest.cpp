@@ -7,6 +7,7 @@
 
 #include <gtest/gtest.h>
 #include <string>
+#include <unordered_set>
 
 #include "RedexResources.h"
 
@@ -15,3 +16,20 @@ TEST(ExtractNativeTest, empty) {
   auto overset = extract_classes_from_native_lib(over);
   EXPECT_EQ(overset.size(), 2);
 }
+
+TEST(ExtractNativeTest, names) {
+  const char names[] =
+      "\x01\x02Lcom/facebook/Foo;\xff"
+      "com/facebook/Bar\x00"
+      "Xcom/facebook/Baz_$1 short/nm Lcom/facebook/Foo;";
+  // Enough binary noise around the names to span several 64-byte blocks.
+  auto lib = std::string(100, '\x90') +
+             std::string(names, sizeof(names) - 1) + std::string(61, '\xcc');
+  auto classes = extract_classes_from_native_lib(lib);
+  std::unordered_set<std::string> expected{
+      "Lcom/facebook/Foo;",
+      "Lcom/facebook/Bar;",
+      "Lcom/facebook/Baz_$1;",
+  };
+  EXPECT_EQ(classes, expected);
+}
@@ -244,6 +244,21 @@ TEST_F(IRInstructionTest, SelectMove) {
             select_move_opcode(dasm(OPCODE_MOVE_OBJECT, {65535_v, 65535_v})));
 }
 
+TEST_F(IRInstructionTest, SufficientlySparse) {
+  using namespace instruction_lowering;
+
+  // 10 entries over a range of 31 keys.
+  std::vector<int32_t> keys{0, 3, 6, 9, 12, 15, 18, 21, 24, 30};
+  EXPECT_TRUE(sufficiently_sparse(keys));
+  EXPECT_FALSE(sufficiently_sparse(keys, /* is_hot */ true));
+
+  keys.push_back(100);
+  EXPECT_TRUE(sufficiently_sparse(keys, /* is_hot */ true));
+
+  EXPECT_FALSE(sufficiently_sparse({1, 2, 3, 5}));
+  EXPECT_TRUE(sufficiently_sparse({0, 70000}, /* is_hot */ true));
+}
+
 TEST_F(IRInstructionTest, SelectConst) {
   using namespace dex_asm;
   using namespace instruction_lowering::impl;
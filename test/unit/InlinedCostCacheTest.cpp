@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "InlinedCostCache.h"
+
+#include <gtest/gtest.h>
+
+#include "IRAssembler.h"
+#include "IRCode.h"
+#include "RedexTest.h"
+
+struct InlinedCostCacheTest : public RedexTest {};
+
+namespace {
+
+InlinedCost make_cost(size_t full_code) {
+  return InlinedCost{full_code, (float)full_code, 0, 0, false, 0, {}, 1};
+}
+
+} // namespace
+
+TEST_F(InlinedCostCacheTest, entriesAreDroppedWhenCodeChanges) {
+  auto* method = assembler::method_from_string(R"(
+    (method (public static) "LFoo;.bar:(I)V"
+     (
+      (load-param v0)
+      (if-eqz v0 :dead)
+      (return-void)
+      (:dead)
+      (const v0 1)
+      (return-void)
+     )
+    )
+  )");
+  auto* code = method->get_code();
+  code->build_cfg(/* editable */ true);
+
+  inliner::InlinedCostCache cache;
+  auto fingerprint = inliner::InlinedCostCache::fingerprint(code);
+  EXPECT_NE(fingerprint, 0);
+  EXPECT_EQ(fingerprint, inliner::InlinedCostCache::fingerprint(code));
+  EXPECT_EQ(cache.get_fully_inlined_cost(method, fingerprint), nullptr);
+  cache.set_fully_inlined_cost(method, fingerprint, make_cost(5));
+  auto fully_inlined_cost = cache.get_fully_inlined_cost(method, fingerprint);
+  ASSERT_NE(fully_inlined_cost, nullptr);
+  EXPECT_EQ(fully_inlined_cost->full_code, 5);
+
+  // Dead blocks are mapped back into the current CFG.
+  cfg::Block* dead_block = nullptr;
+  IRInstruction* const_insn = nullptr;
+  for (auto* block : code->cfg().blocks()) {
+    for (auto& mie : InstructionIterable(block)) {
+      if (mie.insn->opcode() == OPCODE_CONST) {
+        dead_block = block;
+        const_insn = mie.insn;
+      }
+    }
+  }
+  ASSERT_NE(dead_block, nullptr);
+  auto call_site_cost = make_cost(3);
+  call_site_cost.dead_blocks.insert(dead_block);
+  cache.set_call_site_inlined_cost(method, fingerprint, /* context */ 1, "key",
+                                   call_site_cost);
+  EXPECT_EQ(cache.get_call_site_inlined_cost(method, fingerprint,
+                                             /* context */ 2, "key"),
+            nullptr);
+  cache.set_call_site_inlined_cost(method, fingerprint, /* context */ 1, "key",
+                                   call_site_cost);
+  auto cached = cache.get_call_site_inlined_cost(method, fingerprint,
+                                                 /* context */ 1, "key");
+  ASSERT_NE(cached, nullptr);
+  EXPECT_EQ(cached->full_code, 3);
+  EXPECT_EQ(cached->dead_blocks, call_site_cost.dead_blocks);
+
+  // Changing the code drops everything cached for the method.
+  const_insn->set_literal(2);
+  auto new_fingerprint = inliner::InlinedCostCache::fingerprint(code);
+  EXPECT_NE(new_fingerprint, fingerprint);
+  EXPECT_EQ(cache.get_fully_inlined_cost(method, new_fingerprint), nullptr);
+  EXPECT_EQ(cache.get_call_site_inlined_cost(method, new_fingerprint,
+                                             /* context */ 1, "key"),
+            nullptr);
+  EXPECT_EQ(cache.hits(), 2);
+  EXPECT_EQ(cache.misses(), 4);
+  code->clear_cfg();
+}
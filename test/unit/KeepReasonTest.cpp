@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+
+#include "Creators.h"
+#include "DexClass.h"
+#include "KeepReason.h"
+#include "RedexTest.h"
+#include "WorkQueue.h"
+
+class KeepReasonTest : public RedexTest {
+ public:
+  KeepReasonTest() { RedexContext::set_record_keep_reasons(true); }
+};
+
+TEST_F(KeepReasonTest, reasons_are_grouped_and_interned) {
+  ClassCreator foo_creator(DexType::make_type("LFoo;"));
+  foo_creator.set_super(type::java_lang_Object());
+  auto foo = foo_creator.create();
+  ClassCreator bar_creator(DexType::make_type("LBar;"));
+  bar_creator.set_super(type::java_lang_Object());
+  auto bar = bar_creator.create();
+
+  foo->rstate.set_root(keep_reason::MANIFEST);
+  foo->rstate.set_root(keep_reason::MANIFEST);
+  foo->rstate.set_keepnames(keep_reason::NATIVE);
+  bar->rstate.set_root(keep_reason::MANIFEST);
+
+  const auto& foo_reasons = foo->rstate.keep_reasons();
+  ASSERT_EQ(foo_reasons.size(), 2);
+  EXPECT_EQ(foo_reasons[0]->type, keep_reason::MANIFEST);
+  EXPECT_EQ(foo_reasons[1]->type, keep_reason::NATIVE);
+  const auto& bar_reasons = bar->rstate.keep_reasons();
+  ASSERT_EQ(bar_reasons.size(), 1);
+  // Equal reasons are the same object.
+  EXPECT_EQ(bar_reasons[0], foo_reasons[0]);
+}
+
+TEST_F(KeepReasonTest, concurrent_recording) {
+  std::vector<DexClass*> classes;
+  for (size_t i = 0; i < 100; ++i) {
+    auto name = "LFoo" + std::to_string(i) + ";";
+    ClassCreator cc(DexType::make_type(name.c_str()));
+    cc.set_super(type::java_lang_Object());
+    classes.push_back(cc.create());
+  }
+  workqueue_run<DexClass*>(
+      [](DexClass* cls) {
+        cls->rstate.set_root(keep_reason::MANIFEST);
+        cls->rstate.set_root(keep_reason::XML);
+      },
+      classes);
+  for (auto* cls : classes) {
+    EXPECT_EQ(cls->rstate.keep_reasons().size(), 2);
+  }
+}
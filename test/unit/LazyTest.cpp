@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "Lazy.h"
+
+#include <atomic>
+#include <gtest/gtest.h>
+#include <vector>
+
+#include <boost/thread/thread.hpp>
+
+constexpr size_t kThreads = 16;
+constexpr size_t kKeys = 1000;
+
+TEST(LazyTest, lazy) {
+  size_t created = 0;
+  Lazy<int> lazy([&] {
+    created++;
+    return 42;
+  });
+  EXPECT_FALSE(static_cast<bool>(lazy));
+  EXPECT_EQ(42, *lazy);
+  EXPECT_EQ(42, *lazy);
+  EXPECT_TRUE(static_cast<bool>(lazy));
+  EXPECT_EQ(1, created);
+}
+
+TEST(LazyTest, concurrentLazy) {
+  std::atomic<size_t> created{0};
+  ConcurrentLazy<std::vector<int>> lazy([&] {
+    created++;
+    return std::vector<int>(100, 1);
+  });
+  EXPECT_FALSE(static_cast<bool>(lazy));
+  std::vector<boost::thread> threads;
+  std::atomic<size_t> sum{0};
+  for (size_t t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&] { sum += lazy->size(); });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_TRUE(static_cast<bool>(lazy));
+  EXPECT_EQ(1, created);
+  EXPECT_EQ(100 * kThreads, sum);
+}
+
+TEST(LazyTest, concurrentLazyUnorderedMap) {
+  std::atomic<size_t> created{0};
+  ConcurrentLazyUnorderedMap<size_t, size_t> map([&](size_t key) {
+    created++;
+    return key * 2;
+  });
+  std::vector<boost::thread> threads;
+  std::atomic<size_t> mismatches{0};
+  for (size_t t = 0; t < kThreads; ++t) {
+    // All threads query all keys, in different orders.
+    threads.emplace_back([&, t] {
+      for (size_t i = 0; i < kKeys; ++i) {
+        size_t key = (i * (2 * t + 1)) % kKeys;
+        if (map[key] != key * 2) {
+          mismatches++;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, mismatches);
+  EXPECT_EQ(kKeys, created);
+  // References stay valid.
+  size_t& value = map[0];
+  map[kKeys];
+  EXPECT_EQ(&value, &map[0]);
+}
@@ -208,3 +208,49 @@ TEST_F(LiveRangeTest, testDefUseChainMultiDefinition) {
   EXPECT_THAT(du_chains[const_v1_2],
               ::testing::UnorderedElementsAre(Use{move, 0}));
 }
+
+TEST_F(LiveRangeTest, testLazyChains) {
+  auto code = assembler::ircode_from_string(R"(
+    (
+      (const v0 0)
+      (if-eq v0 v0 :if-true)
+      (const v1 1)
+      (goto :end)
+      (:if-true)
+      (const v1 2)
+      (:end)
+      (add-int v2 v1 v0)
+      (return-void)
+    )
+  )");
+
+  using namespace live_range;
+
+  cfg::ScopedCFG cfg(code.get());
+  LazyChains chains(*cfg);
+  auto du_chains = MoveAwareChains(*cfg).get_def_use_chains();
+  auto ud_chains = MoveAwareChains(*cfg).get_use_def_chains();
+
+  for (const auto& mie : InstructionIterable(*cfg)) {
+    auto* insn = mie.insn;
+    auto uses = chains.get_uses(insn);
+    EXPECT_THAT(std::vector<Use>(uses.begin(), uses.end()),
+                ::testing::UnorderedElementsAreArray(du_chains[insn]));
+    for (src_index_t i = 0; i < insn->srcs_size(); ++i) {
+      auto defs = chains.get_defs(Use{insn, i});
+      const auto& expected = ud_chains[Use{insn, i}];
+      EXPECT_THAT(std::vector<Def>(defs.begin(), defs.end()),
+                  ::testing::UnorderedElementsAreArray(
+                      std::vector<Def>(expected.begin(), expected.end())));
+    }
+  }
+
+  auto it = InstructionIterable(*cfg).begin();
+  IRInstruction* const_v0 = it->insn;
+  EXPECT_EQ(chains.get_uses(const_v0).size(), 3);
+  EXPECT_TRUE(chains.get_defs(Use{const_v0, 0}).empty());
+  EXPECT_EQ(&chains.get_fp_iter(), &chains.get_fp_iter());
+
+  chains.invalidate();
+  EXPECT_EQ(chains.get_uses(const_v0).size(), 3);
+}
@@ -317,6 +317,48 @@ TEST_F(LocalDceEnhanceTest, HaveImplementorWithoutSideEffectsTest) {
   EXPECT_CODE_EQ(ircode, expected_code.get());
 }
 
+TEST_F(LocalDceEnhanceTest, ResolvedImplementorWithoutSideEffectsTest) {
+  Scope scope = create_empty_scope();
+  auto void_t = type::_void();
+  auto void_void =
+      DexProto::make_proto(void_t, DexTypeList::make_type_list({}));
+
+  DexType* a_type = DexType::make_type("LA;");
+  DexClass* a_cls = create_internal_class(a_type, type::java_lang_Object(), {},
+                                          ACC_PUBLIC | ACC_ABSTRACT);
+  create_abstract_method(a_cls, "m", void_void);
+
+  DexType* b_type = DexType::make_type("LB;");
+  DexClass* b_cls = create_internal_class(b_type, a_type, {});
+
+  DexType* c_type = DexType::make_type("LC;");
+  DexClass* c_cls = create_internal_class(c_type, b_type, {});
+  create_empty_method(c_cls, "m", void_void);
+
+  scope.push_back(a_cls);
+  scope.push_back(b_cls);
+  scope.push_back(c_cls);
+
+  // LB;.m is not a definition, but resolves to LA;.m.
+  auto code = assembler::ircode_from_string(R"(
+    (
+      (invoke-virtual (v0) "LB;.m:()V")
+      (return-void)
+    )
+  )");
+
+  auto expected_code = assembler::ircode_from_string(R"(
+    (
+      (return-void)
+    )
+  )");
+  const auto& pure_methods = get_no_side_effect_methods(scope);
+  LocalDce ldce(pure_methods);
+  IRCode* ircode = code.get();
+  ldce.dce(ircode);
+  EXPECT_CODE_EQ(ircode, expected_code.get());
+}
+
 TEST_F(LocalDceEnhanceTest, HaveImplementorWithSideEffectsTest) {
   Scope scope = create_empty_scope();
   auto void_t = type::_void();
@@ -936,5 +936,39 @@ TEST_F(MatchFlowTest, InstructionGraphTransitiveFailure) {
   EXPECT_EQ(locs.at(2), nullptr);
 }
 
+TEST_F(MatchFlowTest, MayMatch) {
+  auto code = assembler::ircode_from_string(R"((
+    (const v0 0)
+    (const v1 1)
+    (:L)
+    (add-int v0 v0 v1)
+    (goto :L)
+  ))");
+
+  cfg::ScopedCFG cfg{code.get()};
+
+  using namespace detail;
+  std::vector<Constraint> constraints;
+
+  // 0: add-int with its first operand from a sub-int, which doesn't exist.
+  constraints.emplace_back(insn_matcher(m::add_int_()));
+  constraints[0].add_src(0, 1, AliasFlag::dest, QuantFlag::exists);
+  constraints.emplace_back(insn_matcher(m::sub_int_()));
+
+  // 2: The same, but for all operands, which holds vacuously.
+  constraints.emplace_back(insn_matcher(m::add_int_()));
+  constraints[2].add_src(0, 1, AliasFlag::dest, QuantFlag::forall);
+
+  // 3: add-int in a cycle with itself.
+  constraints.emplace_back(insn_matcher(m::add_int_()));
+  constraints[3].add_src(0, 3, AliasFlag::dest, QuantFlag::exists);
+
+  EXPECT_FALSE(may_match(*cfg, constraints, {0}));
+  EXPECT_FALSE(may_match(*cfg, constraints, {1}));
+  EXPECT_TRUE(may_match(*cfg, constraints, {2}));
+  EXPECT_TRUE(may_match(*cfg, constraints, {3}));
+  EXPECT_TRUE(may_match(*cfg, constraints, {0, 3}));
+}
+
 } // namespace
 } // namespace mf
@@ -114,7 +114,7 @@ DexMethod* make_loopy_method(DexClass* cls, const char* name) {
  * }
  */
 DexMethod* make_precondition_method(DexClass* cls, const char* name) {
-  auto method_name = cls->get_name()->str() + "." + name;
+  auto method_name = cls->get_name()->str_copy() + "." + name;
   auto method = assembler::method_from_string(std::string("") + R"(
     (method (public static) ")" + method_name +
                                               R"(:(I)V"
@@ -146,7 +146,7 @@ DexMethod* make_precondition_method(DexClass* cls, const char* name) {
  * }
  */
 DexMethod* make_silly_precondition_method(DexClass* cls, const char* name) {
-  auto method_name = cls->get_name()->str() + "." + name;
+  auto method_name = cls->get_name()->str_copy() + "." + name;
   auto method = assembler::method_from_string(std::string("") + R"(
     (method (public static) ")" + method_name +
                                               R"(:(I)V"
@@ -182,7 +182,7 @@ DexMethod* make_silly_precondition_method(DexClass* cls, const char* name) {
  * }
  */
 DexMethod* make_unboxing_precondition_method(DexClass* cls, const char* name) {
-  auto method_name = cls->get_name()->str() + "." + name;
+  auto method_name = cls->get_name()->str_copy() + "." + name;
   auto method = assembler::method_from_string(std::string("") + R"(
     (method (public static) ")" + method_name +
                                               R"(:(Ljava/lang/Boolean;)V"
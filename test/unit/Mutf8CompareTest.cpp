@@ -6,7 +6,9 @@
  */
 
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <memory>
+#include <vector>
 
 #include "DexClass.h"
 #include "RedexTest.h"
@@ -19,3 +21,50 @@ TEST_F(Mutf8CompareTest, empty) {
   EXPECT_TRUE(compare_dexstrings(s1, s2));
   EXPECT_FALSE(compare_dexstrings(s2, s1));
 }
+
+TEST_F(Mutf8CompareTest, ordinals) {
+  std::vector<DexString*> strings{
+      DexString::make_string("b"),
+      DexString::make_string(";\300\200", 2),
+      DexString::make_string(""),
+      DexString::make_string("a"),
+      DexString::make_string(";"),
+  };
+  std::vector<DexString*> expected(strings);
+  std::sort(expected.begin(), expected.end(), compare_dexstrings);
+
+  g_redex->assign_string_ordinals();
+  auto* late = DexString::make_string("ab");
+  EXPECT_EQ(late->ordinal(), 0);
+  for (auto* s : strings) {
+    EXPECT_NE(s->ordinal(), 0);
+  }
+
+  std::vector<DexString*> actual(strings);
+  std::sort(actual.begin(), actual.end(), compare_dexstrings);
+  EXPECT_EQ(actual, expected);
+
+  // Strings without an ordinal still sort consistently with those that have
+  // one.
+  EXPECT_TRUE(compare_dexstrings(DexString::get_string("a"), late));
+  EXPECT_TRUE(compare_dexstrings(late, DexString::get_string("b")));
+}
+
+TEST_F(Mutf8CompareTest, longCommonPrefix) {
+  // U+00E9 (\303\251) and U+0800 (\340\240\200) share no bytes, but U+00E9
+  // and U+00EA (\303\252) differ only in their second byte.
+  std::string prefix = "Lcom/example/some/long/package/Name";
+  auto* s1 = DexString::make_string(prefix + "\303\251x");
+  auto* s2 = DexString::make_string(prefix + "\303\252");
+  auto* s3 = DexString::make_string(prefix + "\340\240\200");
+  auto* s4 = DexString::make_string(prefix + "\300\200");
+  EXPECT_TRUE(compare_dexstrings(s1, s2));
+  EXPECT_FALSE(compare_dexstrings(s2, s1));
+  EXPECT_TRUE(compare_dexstrings(s2, s3));
+  EXPECT_TRUE(compare_dexstrings(s4, s1));
+  EXPECT_TRUE(compare_dexstrings(DexString::make_string(prefix), s4));
+
+  EXPECT_EQ(s1->length(), prefix.size() + 2);
+  EXPECT_EQ(s3->length(), prefix.size() + 1);
+  EXPECT_EQ(length_of_utf8_string(s3->c_str()), prefix.size() + 1);
+}
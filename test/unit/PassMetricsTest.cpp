@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "PassMetrics.h"
+
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+using namespace pass_metrics;
+
+TEST(PassMetricsTest, counter_from_threads) {
+  Counter counter;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&counter]() {
+      for (int i = 0; i < 1000; ++i) {
+        counter.add(2);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(counter.get(), 16000);
+}
+
+TEST(PassMetricsTest, histogram) {
+  Histogram histogram;
+  EXPECT_EQ(histogram.count(), 0);
+  EXPECT_EQ(histogram.percentile(50), 0);
+
+  for (uint64_t v = 1; v <= 100; ++v) {
+    histogram.record(v);
+  }
+  histogram.record(0);
+  EXPECT_EQ(histogram.count(), 101);
+  EXPECT_EQ(histogram.sum(), 5050);
+  EXPECT_EQ(histogram.max(), 100);
+
+  // 0 is alone in its bucket.
+  EXPECT_EQ(histogram.percentile(0), 0);
+  // The 51st value is 50, in the bucket [32, 64).
+  EXPECT_EQ(histogram.percentile(50), 63);
+  // The last bucket [64, 128) is capped by the largest value.
+  EXPECT_EQ(histogram.percentile(99), 100);
+  EXPECT_EQ(histogram.percentile(100), 100);
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "PriorityThreadPoolDAGScheduler.h"
+
+#include <gtest/gtest.h>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+std::vector<int> run_in_order(bool weighted) {
+  std::mutex mutex;
+  std::vector<int> order;
+  PriorityThreadPoolDAGScheduler<int> scheduler(
+      [&](int task) {
+        std::lock_guard<std::mutex> lock(mutex);
+        order.push_back(task);
+      },
+      /* num_threads */ 1);
+  // Task 2 waits for task 1; task 3 is independent but expensive.
+  scheduler.add_dependency(2, 1);
+  if (weighted) {
+    scheduler.set_weight(1, 1);
+    scheduler.set_weight(2, 1);
+    scheduler.set_weight(3, 100);
+  }
+  std::vector<int> tasks{1, 2, 3};
+  EXPECT_EQ(scheduler.run(tasks.begin(), tasks.end()), 1);
+  if (weighted) {
+    EXPECT_EQ(scheduler.get_max_weighted_length(), 100);
+  }
+  auto utilization = scheduler.get_thread_pool().get_utilization();
+  EXPECT_GE(utilization, 0);
+  EXPECT_LE(utilization, 1.0 + 1e-9);
+  return order;
+}
+
+} // namespace
+
+TEST(PriorityThreadPoolDAGSchedulerTest, longestChainFirst) {
+  EXPECT_EQ(run_in_order(/* weighted */ false), std::vector<int>({1, 2, 3}));
+}
+
+TEST(PriorityThreadPoolDAGSchedulerTest, heaviestChainFirst) {
+  EXPECT_EQ(run_in_order(/* weighted */ true), std::vector<int>({3, 1, 2}));
+}
@@ -7,6 +7,8 @@
 
 #include "ProguardMap.h"
 
+#include <boost/filesystem.hpp>
+#include <fstream>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <sstream>
@@ -341,3 +343,32 @@ TEST_F(ProguardMapTest, DeobfuscateFramesWithoutLineRange) {
 
   EXPECT_CODE_EQ(code.get(), expected_code.get());
 }
+
+TEST_F(ProguardMapTest, MappedFullRenameMap) {
+  auto path = boost::filesystem::temp_directory_path() /
+              boost::filesystem::unique_path("pg-map-%%%%-%%%%.txt");
+  {
+    std::ofstream out(path.string());
+    // The last line has no line terminator.
+    out << "type Lcom/foo/Bar; -> LA;\n"
+           "ifield Lcom/foo/Bar;.baz:I -> LA;.a:I\n"
+           "vmethod Lcom/foo/Bar;.qux:(I)V -> LA;.b:(I)V";
+  }
+  ProguardMap pm(path.string(), /* use_new_rename_map */ true);
+  boost::filesystem::remove(path);
+
+  EXPECT_EQ("LA;", pm.translate_class_view("Lcom/foo/Bar;"));
+  EXPECT_EQ("LA;.a:I", pm.translate_field_view("Lcom/foo/Bar;.baz:I"));
+  EXPECT_EQ("LA;.b:(I)V", pm.translate_method_view("Lcom/foo/Bar;.qux:(I)V"));
+  EXPECT_EQ("Lcom/foo/Bar;", pm.deobfuscate_class_view("LA;"));
+  EXPECT_EQ("Lcom/foo/Bar;.baz:I", pm.deobfuscate_field_view("LA;.a:I"));
+  EXPECT_EQ("Lcom/foo/Bar;.qux:(I)V", pm.deobfuscate_method("LA;.b:(I)V"));
+
+  // Unmapped names are returned as is, without a copy.
+  std::string not_found = "Lcom/not/Found;";
+  EXPECT_EQ(not_found.data(), pm.translate_class_view(not_found).data());
+
+  // Moving the map keeps its names valid.
+  ProguardMap moved(std::move(pm));
+  EXPECT_EQ("LA;", moved.translate_class_view("Lcom/foo/Bar;"));
+}
@@ -7,11 +7,13 @@
 
 #include <gtest/gtest.h>
 
+#include <fstream>
 #include <istream>
 #include <vector>
 
 #include "ProguardConfiguration.h"
 #include "ProguardParser.h"
+#include "RedexTestUtils.h"
 
 using namespace keep_rules;
 
@@ -886,3 +888,39 @@ TEST(ProguardParserTest, assumenosideeffects_with_field_value) {
               keep_rules::AssumeReturnValue::ValueNone);
   }
 }
+
+// parse_files gives the same result as parsing the files one by one.
+TEST(ProguardParserTest, parse_files) {
+  auto tmp_dir = redex::make_tmp_dir("redex_proguard_parser_test_%%%%%%%%");
+  auto write = [&](const std::string& name, const std::string& contents) {
+    auto path = tmp_dir.path + "/" + name;
+    std::ofstream(path) << contents;
+    return path;
+  };
+  auto included = write("included.pro", "-keep class Included\n-dontwarn d\n");
+  std::vector<std::string> files{
+      write("a.pro", "-include " + included + "\n-keep class A\n"),
+      write("b.pro", "-dontshrink\n-keep class B\n-keep class A\n"),
+      write("c.pro", "-keep class C\n-target 1.8\n-dontwarn c\n"),
+  };
+
+  ProguardConfiguration sequential;
+  for (const auto& file : files) {
+    proguard_parser::parse_file(file, &sequential);
+  }
+  ProguardConfiguration concurrent;
+  proguard_parser::parse_files(files, &concurrent);
+
+  ASSERT_TRUE(concurrent.ok);
+  EXPECT_FALSE(concurrent.shrink);
+  EXPECT_EQ(concurrent.target_version, "1.8");
+  EXPECT_EQ(concurrent.includes, sequential.includes);
+  EXPECT_EQ(concurrent.dontwarn, sequential.dontwarn);
+  ASSERT_EQ(concurrent.keep_rules.size(), sequential.keep_rules.size());
+  for (size_t i = 0; i < concurrent.keep_rules.size(); ++i) {
+    const auto* expected = sequential.keep_rules.elements()[i];
+    const auto* actual = concurrent.keep_rules.elements()[i];
+    EXPECT_EQ(*actual, *expected);
+    EXPECT_EQ(actual->source_filename, expected->source_filename);
+  }
+}
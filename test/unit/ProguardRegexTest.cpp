@@ -270,3 +270,41 @@ TEST(ProguardRegexTest, types) {
     EXPECT_EQ("Lalpha/**/beta;", descriptor);
   }
 }
+
+TEST(ProguardRegexTest, wildcardMatcherAgreesWithRegex) {
+  const std::vector<std::string> patterns = {
+      "L*;",          "L**;",          "Lalpha/*;",   "Lalpha/**;",
+      "Lalpha/*/beta;", "Lalpha/**/beta;", "Lalpha?beta;", "La/b$*;",
+      "La/**Test;",   "La/*?;",        "[La/*;",      "La/b/C;",
+  };
+  const std::vector<std::string> types = {
+      "La;",         "Lalpha;",     "Lalpha/beta;", "Lalpha/x/beta;",
+      "Lalpha/x/y/beta;", "Lalpha$beta;", "Lalpha/beta/gamma;",
+      "La/b$C;",     "La/b$C$D;",   "La/b/CTest;",  "La/Test;",
+      "[La/b;",      "La/b/C;",     "La/[b;",       "Lalphabeta;",
+      "La/x;",       "",
+  };
+  for (const auto& pattern : patterns) {
+    auto matcher = proguard_parser::TypeWildcardMatcher::compile(pattern);
+    ASSERT_TRUE(matcher) << pattern;
+    boost::regex rx(proguard_parser::form_type_regex(pattern));
+    for (const auto& type : types) {
+      EXPECT_EQ(boost::regex_match(type, rx), matcher->match(type))
+          << pattern << " vs " << type;
+    }
+  }
+
+  // Patterns outside of simple wildcards are left to boost::regex.
+  EXPECT_FALSE(proguard_parser::TypeWildcardMatcher::compile("%"));
+  EXPECT_FALSE(proguard_parser::TypeWildcardMatcher::compile("***"));
+  EXPECT_FALSE(proguard_parser::TypeWildcardMatcher::compile("L.a;"));
+  EXPECT_FALSE(proguard_parser::TypeWildcardMatcher::compile(""));
+}
+
+TEST(ProguardRegexTest, literalTypePrefix) {
+  EXPECT_EQ("L", proguard_parser::literal_type_prefix("L*;"));
+  EXPECT_EQ("Lalpha/", proguard_parser::literal_type_prefix("Lalpha/**;"));
+  EXPECT_EQ("Lalpha", proguard_parser::literal_type_prefix("Lalpha?beta;"));
+  EXPECT_EQ("", proguard_parser::literal_type_prefix("%"));
+  EXPECT_EQ("La/b;", proguard_parser::literal_type_prefix("La/b;"));
+}
@@ -131,4 +131,33 @@ TEST_F(RandomForestTest, accept_feat_caller) {
   }
 }
 
+TEST_F(RandomForestTest, shared_features_evaluated_once) {
+  using IntForest = Forest<int>;
+  size_t calls = 0;
+  IntForest::FeatureFunctionMap feature_fns{
+      {"x", [&calls](int x) -> float {
+         ++calls;
+         return x;
+       }}};
+  auto forest = IntForest::deserialize(
+      "(forest (feat \"x\" 5 (acc 1 0) (acc 0 1))"
+      " (feat \"x\" 2 (acc 1 0) (feat \"x\" 4 (acc 0 1) (acc 1 0)))"
+      " (acc 0 1))",
+      feature_fns);
+  EXPECT_EQ(forest.size(), 3);
+
+  size_t acc_count;
+  EXPECT_FALSE(forest.accept(3, &acc_count));
+  EXPECT_EQ(acc_count, 1);
+  EXPECT_EQ(calls, 1);
+
+  EXPECT_FALSE(forest.clone().accept(7, &acc_count));
+  EXPECT_EQ(acc_count, 1);
+  EXPECT_FALSE(forest.accept(4, &acc_count));
+  EXPECT_EQ(acc_count, 1);
+  EXPECT_TRUE(forest.accept(1, &acc_count));
+  EXPECT_EQ(acc_count, 2);
+  EXPECT_EQ(calls, 4);
+}
+
 } // namespace random_forest
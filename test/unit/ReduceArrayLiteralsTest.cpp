@@ -344,3 +344,43 @@ TEST_F(ReduceArrayLiteralsTest, conditional_escape) {
   const auto& expected_str = code_str;
   test(code_str, expected_str, 0, 0);
 }
+
+TEST_F(ReduceArrayLiteralsTest, array_literal_before_branch) {
+  // Code with more than one block is left to the fixpoint analysis.
+  auto code_str = R"(
+    (
+      (load-param v3)
+      (const v0 1)
+      (new-array v0 "[Ljava/lang/String;")
+      (move-result-pseudo-object v1)
+      (const v0 0)
+      (const-string "hello")
+      (move-result-pseudo-object v2)
+      (aput-object v2 v1 v0)
+      (if-eqz v3 :skip)
+      (return-object v1)
+      (:skip)
+      (const v1 0)
+      (return-object v1)
+    )
+  )";
+  const auto& expected_str = R"(
+    (
+      (load-param v3)
+      (const v0 1)
+      (const v0 0)
+      (const-string "hello")
+      (move-result-pseudo-object v2)
+      (check-cast v2 "Ljava/lang/String;")
+      (move-result-pseudo-object v4)
+      (filled-new-array (v4) "[Ljava/lang/String;")
+      (move-result-object v1)
+      (if-eqz v3 :skip)
+      (return-object v1)
+      (:skip)
+      (const v1 0)
+      (return-object v1)
+    )
+  )";
+  test(code_str, expected_str, 1, 1);
+}
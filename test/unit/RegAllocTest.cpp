@@ -738,6 +738,40 @@ TEST_F(RegAllocTest, ContainmentGraph) {
   EXPECT_TRUE(ig.has_containment_edge(0, 1));
 }
 
+TEST_F(RegAllocTest, RegPairFlagsDenseAndSparse) {
+  interference::impl::RegPairFlags</* kSymmetric */ true> sym;
+  interference::impl::RegPairFlags</* kSymmetric */ false> directed;
+  // Registers 0..9 go into the bit-matrix, larger ones into the hash map.
+  sym.set_dense_bound(10);
+  directed.set_dense_bound(10);
+  sym.insert(3, 7, false);
+  sym.insert(12, 2, true);
+  directed.insert(3, 7, false);
+  directed.insert(12, 2, false);
+
+  EXPECT_TRUE(sym.contains(7, 3));
+  EXPECT_FALSE(sym.flag(3, 7));
+  sym.insert(7, 3, true);
+  EXPECT_TRUE(sym.flag(3, 7));
+  // A set flag stays set.
+  sym.insert(3, 7, false);
+  EXPECT_TRUE(sym.flag(7, 3));
+  EXPECT_TRUE(sym.contains(2, 12));
+  EXPECT_TRUE(sym.flag(2, 12));
+  EXPECT_FALSE(sym.contains(3, 3));
+
+  EXPECT_TRUE(directed.contains(3, 7));
+  EXPECT_FALSE(directed.contains(7, 3));
+  EXPECT_TRUE(directed.contains(12, 2));
+  EXPECT_FALSE(directed.contains(2, 12));
+
+  std::vector<std::pair<reg_t, reg_t>> pairs;
+  directed.for_each([&](reg_t u, reg_t v) { pairs.emplace_back(u, v); });
+  EXPECT_THAT(pairs,
+              ::testing::UnorderedElementsAre(std::make_pair(3u, 7u),
+                                              std::make_pair(12u, 2u)));
+}
+
 TEST_F(RegAllocTest, FindSplit) {
   auto code = assembler::ircode_from_string(R"(
     (
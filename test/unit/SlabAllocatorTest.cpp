@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "SlabAllocator.h"
+
+TEST(SlabAllocatorTest, distinctAndReused) {
+  constexpr size_t kNum = 10000;
+  std::vector<void*> ptrs;
+  for (size_t i = 0; i < kNum; ++i) {
+    auto* ptr = slab_allocator::allocate(40);
+    std::memset(ptr, 0xab, 40);
+    ptrs.push_back(ptr);
+  }
+  std::unordered_set<void*> distinct(ptrs.begin(), ptrs.end());
+  EXPECT_EQ(distinct.size(), kNum);
+  for (auto* ptr : ptrs) {
+    slab_allocator::deallocate(ptr, 40);
+  }
+
+  if (slab_allocator::is_enabled()) {
+    // Freed objects of the same size class get handed out again.
+    auto* ptr = slab_allocator::allocate(48);
+    EXPECT_EQ(distinct.count(ptr), 1);
+    slab_allocator::deallocate(ptr, 48);
+  }
+}
+
+TEST(SlabAllocatorTest, largeObjects) {
+  auto* ptr = slab_allocator::allocate(4096);
+  std::memset(ptr, 0, 4096);
+  slab_allocator::deallocate(ptr, 4096);
+}
+
+TEST(SlabAllocatorTest, freeOnOtherThreads) {
+  constexpr size_t kNumThreads = 4;
+  constexpr size_t kNum = 5000;
+  std::vector<std::vector<void*>> ptrs(kNumThreads);
+  for (auto& v : ptrs) {
+    for (size_t i = 0; i < kNum; ++i) {
+      v.push_back(slab_allocator::allocate(24));
+    }
+  }
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      for (auto* ptr : ptrs[t]) {
+        slab_allocator::deallocate(ptr, 24);
+      }
+      // Allocate on this thread too, from what it just freed.
+      std::vector<void*> mine;
+      for (size_t i = 0; i < kNum; ++i) {
+        mine.push_back(slab_allocator::allocate(24));
+      }
+      for (auto* ptr : mine) {
+        slab_allocator::deallocate(ptr, 24);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  // Exited threads handed their objects back.
+  std::vector<void*> again;
+  for (size_t i = 0; i < kNum; ++i) {
+    again.push_back(slab_allocator::allocate(24));
+  }
+  for (auto* ptr : again) {
+    slab_allocator::deallocate(ptr, 24);
+  }
+}
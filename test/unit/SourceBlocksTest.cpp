@@ -698,3 +698,74 @@ B3: LFoo;.bar:()V@4(5:0))");
   EXPECT_EQ(coalesced.first, 1);
   EXPECT_EQ(coalesced.second, 4);
 }
+
+TEST_F(SourceBlocksTest, copies_share_vals) {
+  auto* method = create_method();
+  SourceBlock sb(method, 0,
+                 std::vector<SourceBlock::Val>{SourceBlock::Val(1, 2),
+                                               SourceBlock::Val::none()});
+  SourceBlock copy(sb);
+  ASSERT_EQ(copy.vals.begin(), sb.vals.begin());
+  EXPECT_EQ(copy, sb);
+
+  copy.vals[0] = SourceBlock::Val(3, 4);
+  EXPECT_NE(copy.vals.begin(), sb.vals.begin());
+  EXPECT_EQ(*sb.get_val(0), 1);
+  EXPECT_EQ(*copy.get_val(0), 3);
+  EXPECT_FALSE(copy.get_val(1));
+  EXPECT_FALSE(copy == sb);
+}
+
+TEST_F(SourceBlocksTest, cold_last_linearization) {
+  auto* method = create_method();
+  method->set_code(assembler::ircode_from_string(R"(
+    (
+      (const v0 0)
+      (if-eqz v0 :cold)
+      (if-nez v0 :hot)
+      (invoke-static () "LFoo;.hot1:()V")
+      (return-void)
+
+      (:cold)
+      (invoke-static () "LFoo;.cold:()V")
+      (return-void)
+
+      (:hot)
+      (invoke-static () "LFoo;.hot2:()V")
+      (return-void)
+    )
+  )"));
+  auto* code = method->get_code();
+  code->build_cfg();
+  auto& cfg = code->cfg();
+
+  auto calls = [](const Block* b, const char* name) {
+    for (const auto& mie : ::InstructionIterable(b)) {
+      if (mie.insn->has_method() &&
+          mie.insn->get_method()->get_name()->str() == name) {
+        return true;
+      }
+    }
+    return false;
+  };
+  size_t id = 0;
+  for (auto* b : cfg.blocks()) {
+    float val = calls(b, "cold") ? 0 : 1;
+    impl::BlockAccessor::push_source_block(
+        b, std::make_unique<SourceBlock>(
+               method, id++,
+               std::vector<SourceBlock::Val>{SourceBlock::Val(val, 1)}));
+    EXPECT_EQ(is_cold(b), calls(b, "cold"));
+  }
+
+  code->clear_cfg(std::make_unique<ColdLastLinearizationStrategy>());
+
+  std::vector<std::string> order;
+  for (const auto& mie : ::InstructionIterable(code)) {
+    if (mie.insn->opcode() == OPCODE_INVOKE_STATIC) {
+      order.emplace_back(mie.insn->get_method()->get_name()->str());
+    }
+  }
+  ASSERT_EQ(order.size(), 3u);
+  EXPECT_EQ(order.back(), "cold");
+}
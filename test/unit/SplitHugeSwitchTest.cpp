@@ -50,7 +50,7 @@ class SplitHugeSwitchTest : public RedexTest {
 
   static std::string replace_count(const std::string& str, DexMethod* m) {
     const std::string replacement = "LFoo;";
-    const std::string needle = m->get_class()->str();
+    const std::string needle = m->get_class()->str_copy();
     std::string res = str;
     for (;;) {
       size_t i = res.find(needle);
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "SuffixArray.h"
+
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <numeric>
+#include <random>
+
+namespace {
+
+std::vector<uint32_t> naive_suffix_array(const std::vector<uint32_t>& str) {
+  std::vector<uint32_t> sa(str.size());
+  std::iota(sa.begin(), sa.end(), 0);
+  std::sort(sa.begin(), sa.end(), [&](uint32_t a, uint32_t b) {
+    return std::lexicographical_compare(str.begin() + a, str.end(),
+                                        str.begin() + b, str.end());
+  });
+  return sa;
+}
+
+uint32_t naive_lcp(const std::vector<uint32_t>& str, uint32_t a, uint32_t b) {
+  uint32_t h = 0;
+  while (a + h < str.size() && b + h < str.size() &&
+         str[a + h] == str[b + h]) {
+    h++;
+  }
+  return h;
+}
+
+} // namespace
+
+TEST(SuffixArrayTest, empty) {
+  EXPECT_TRUE(suffix_array::build({}, 1).empty());
+  EXPECT_TRUE(suffix_array::lcp({}, {}).empty());
+}
+
+TEST(SuffixArrayTest, banana) {
+  // b=1, a=0, n=2
+  std::vector<uint32_t> str{1, 0, 2, 0, 2, 0};
+  auto sa = suffix_array::build(str, 3);
+  EXPECT_EQ(sa, std::vector<uint32_t>({5, 3, 1, 0, 4, 2}));
+  EXPECT_EQ(suffix_array::lcp(str, sa),
+            std::vector<uint32_t>({0, 1, 3, 0, 0, 2}));
+}
+
+TEST(SuffixArrayTest, matchesNaive) {
+  std::mt19937 gen(42);
+  for (uint32_t alphabet_size : {1, 2, 3, 50}) {
+    for (size_t n : {1, 2, 7, 64, 300}) {
+      std::uniform_int_distribution<uint32_t> dist(0, alphabet_size - 1);
+      std::vector<uint32_t> str(n);
+      for (auto& c : str) {
+        c = dist(gen);
+      }
+      auto sa = suffix_array::build(str, alphabet_size);
+      EXPECT_EQ(sa, naive_suffix_array(str));
+      auto lcp = suffix_array::lcp(str, sa);
+      ASSERT_EQ(lcp.size(), n);
+      EXPECT_EQ(lcp[0], 0);
+      for (size_t i = 1; i < n; ++i) {
+        EXPECT_EQ(lcp[i], naive_lcp(str, sa[i - 1], sa[i]));
+      }
+    }
+  }
+}
@@ -121,3 +121,28 @@ TEST(AccumulatingTimer, multipleThreadsMultipleScopes) {
   // Assume that thread startup is not too expensive.
   EXPECT_TRUE(is_close(NUM_ITERS * kOneSecInMus, global_mus, NUM_ITERS));
 }
+
+TEST(Timer, traceEvents) {
+  Timer::enable_trace_events(true);
+  {
+    Timer outer("outer");
+    {
+      Timer inner("inner");
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+  Timer::enable_trace_events(false);
+  { Timer untraced("untraced"); }
+
+  const auto& events = Timer::get_trace_events();
+  ASSERT_EQ(2, events.size());
+  // Scopes are recorded as they complete.
+  EXPECT_EQ("inner", events.names[0]);
+  EXPECT_EQ("outer", events.names[1]);
+  EXPECT_EQ(1, events.depths[0]);
+  EXPECT_EQ(0, events.depths[1]);
+  EXPECT_LE(events.start_us[1], events.start_us[0]);
+  EXPECT_GE(events.wall_us[1], events.wall_us[0]);
+  EXPECT_GE(events.wall_us[0], 10 * 1000);
+  EXPECT_EQ(events.thread_ids[0], events.thread_ids[1]);
+}
@@ -10,6 +10,7 @@
 #include "IRAssembler.h"
 #include "RedexTest.h"
 #include "TypeInference.h"
+#include "TypeInferenceCache.h"
 
 using namespace testing;
 
@@ -45,3 +46,53 @@ TEST_F(TypeInferenceTest, const0) {
     }
   }
 }
+
+TEST_F(TypeInferenceTest, cached_environments) {
+  auto method = assembler::method_from_string(R"(
+    (method (public static) "LFoo;.baz:(I)I"
+     (
+      (load-param v0)
+      (const v1 1)
+      (add-int v0 v0 v1)
+      (return v0)
+     )
+    )
+  )");
+  auto code = method->get_code();
+  code->build_cfg(/* editable */ true);
+  auto envs = type_inference::get_type_environments(method);
+  EXPECT_EQ(envs, code->get_cached_type_environments());
+
+  // Unchanged code reuses the environments, also across CFG rebuilds.
+  EXPECT_EQ(envs, type_inference::get_type_environments(method));
+  code->clear_cfg();
+  code->build_cfg(/* editable */ true);
+  EXPECT_EQ(envs, type_inference::get_type_environments(method));
+
+  // Changed code gets new environments.
+  auto& cfg = code->cfg();
+  auto ii = cfg::InstructionIterable(cfg);
+  auto it = std::find_if(ii.begin(), ii.end(), [](auto& mie) {
+    return mie.insn->opcode() == OPCODE_CONST;
+  });
+  ASSERT_FALSE(it.is_end());
+  it->insn->set_literal(0);
+  auto changed_envs = type_inference::get_type_environments(method);
+  EXPECT_NE(envs, changed_envs);
+  EXPECT_EQ(changed_envs, code->get_cached_type_environments());
+  for (auto& mie : cfg::InstructionIterable(cfg)) {
+    if (mie.insn->opcode() == OPCODE_RETURN) {
+      EXPECT_EQ(changed_envs->type_envs.at(mie.insn).get_type(0),
+                type_inference::TypeDomain(INT));
+    }
+  }
+
+  // A copy of the CFG isn't cached.
+  cfg::ControlFlowGraph copy;
+  cfg.deep_copy(&copy);
+  auto copy_envs = type_inference::get_type_environments(copy, method);
+  EXPECT_NE(changed_envs, copy_envs);
+  EXPECT_EQ(changed_envs, code->get_cached_type_environments());
+
+  code->clear_cfg();
+}
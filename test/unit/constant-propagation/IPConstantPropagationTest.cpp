@@ -1674,3 +1674,68 @@ TEST_F(InterproceduralConstantPropagationTest, whiteBoxReturnValues) {
             SignedConstantDomain::bottom());
   EXPECT_EQ(wps.get_return_value(returns_constant), SignedConstantDomain(1));
 }
+
+TEST_F(InterproceduralConstantPropagationTest, summaryCacheAcrossRuns) {
+  auto cls_ty = DexType::make_type("LFoo;");
+  ClassCreator creator(cls_ty);
+  creator.set_super(type::java_lang_Object());
+
+  auto bar = assembler::method_from_string(R"(
+    (method (public static) "LFoo;.bar:()V"
+     (
+      (const v0 0)
+      (invoke-static (v0) "LFoo;.baz:(I)V")
+      (return-void)
+     )
+    )
+  )");
+  bar->rstate.set_root();
+  creator.add_method(bar);
+
+  auto baz = assembler::method_from_string(R"(
+    (method (public static) "LFoo;.baz:(I)V"
+     (
+      (load-param v0)
+      (return-void)
+     )
+    )
+  )");
+  creator.add_method(baz);
+
+  Scope scope{creator.create()};
+  walk::code(scope, [](DexMethod*, IRCode& code) {
+    code.build_cfg(/* editable */ false);
+  });
+
+  SummaryCache cache;
+  auto get_baz_arg = [&](FixpointIterator& fp_iter) {
+    auto& cg = fp_iter.get_call_graph();
+    return fp_iter.get_entry_state_at(cg.node(baz))
+        .get(CURRENT_PARTITION_LABEL)
+        .get(0);
+  };
+
+  InterproceduralConstantPropagationPass pass;
+  pass.set_summary_cache(&cache);
+  auto fp_iter = pass.analyze(scope, &m_immut_analyzer_state);
+  EXPECT_EQ(get_baz_arg(*fp_iter), SignedConstantDomain(0));
+  EXPECT_EQ(cache.hits(), 0);
+  EXPECT_EQ(cache.misses(), 2);
+  EXPECT_EQ(cache.size(), 2);
+
+  // Nothing changed, so neither method is reanalyzed.
+  fp_iter = pass.analyze(scope, &m_immut_analyzer_state);
+  EXPECT_EQ(get_baz_arg(*fp_iter), SignedConstantDomain(0));
+  EXPECT_EQ(cache.hits(), 2);
+  EXPECT_EQ(cache.misses(), 2);
+
+  // Changing the code of the caller changes the arguments of the callee, so
+  // both are reanalyzed.
+  auto* const_insn = InstructionIterable(bar->get_code()).begin()->insn;
+  ASSERT_EQ(const_insn->opcode(), OPCODE_CONST);
+  const_insn->set_literal(1);
+  fp_iter = pass.analyze(scope, &m_immut_analyzer_state);
+  EXPECT_EQ(get_baz_arg(*fp_iter), SignedConstantDomain(1));
+  EXPECT_EQ(cache.hits(), 2);
+  EXPECT_EQ(cache.misses(), 4);
+}
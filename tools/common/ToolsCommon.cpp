@@ -24,10 +24,12 @@
 #include "DexOutput.h"
 #include "DexPosition.h"
 #include "DexUtil.h"
+#include "IRAssembler.h"
 #include "IRMetaIO.h"
 #include "InstructionLowering.h"
 #include "JarLoader.h"
 #include "Macros.h"
+#include "Resolver.h"
 #include "Show.h"
 #include "Timer.h"
 #include "Walkers.h"
@@ -60,7 +62,7 @@ void init_ir_meta(DexStoresVector& stores) {
   Timer t("Init default meta");
   Scope classes = build_class_scope(stores);
   walk::parallel::classes(classes, [](DexClass* cls) {
-    cls->set_deobfuscated_name(show(cls));
+    cls->set_deobfuscated_name(cls->get_name());
     for (DexField* field : cls->get_sfields()) {
       field->set_deobfuscated_name(show(field));
     }
@@ -267,16 +269,21 @@ void load_classes_from_dexes_and_metadata(
     std::vector<dex_stats_t>& input_dexes_stats) {
   always_assert_log(!stores.empty(),
                     "Cannot load classes into empty DexStoresVector");
+  // All dexes of all stores are loaded at once, so first gather them along
+  // with the index of the store they go into.
+  std::vector<std::string> dex_paths;
+  std::vector<size_t> dex_store_indices;
+  std::vector<DexStore> metadata_stores;
+  auto add_dex = [&](const std::string& path, size_t store_index) {
+    assert_dex_magic_consistency(stores[0].get_dex_magic(),
+                                 load_dex_magic_from_dex(path.c_str()));
+    dex_paths.push_back(path);
+    dex_store_indices.push_back(store_index);
+  };
   for (const auto& filename : dex_files) {
     if (filename.size() >= 5 &&
         filename.compare(filename.size() - 4, 4, ".dex") == 0) {
-      assert_dex_magic_consistency(stores[0].get_dex_magic(),
-                                   load_dex_magic_from_dex(filename.c_str()));
-      dex_stats_t dex_stats;
-      DexClasses classes = load_classes_from_dex(filename.c_str(), &dex_stats);
-      input_totals += dex_stats;
-      input_dexes_stats.push_back(dex_stats);
-      stores[0].add_classes(std::move(classes));
+      add_dex(filename, 0);
     } else if (is_zip(filename)) {
       std::cerr << "error: Input files are expected to be DEX (with filename "
                    "ending in "
@@ -288,22 +295,23 @@ void load_classes_from_dexes_and_metadata(
     } else {
       DexMetadata store_metadata;
       store_metadata.parse(filename);
-      DexStore store(store_metadata);
       for (const auto& file_path : store_metadata.get_files()) {
-        assert_dex_magic_consistency(
-            stores[0].get_dex_magic(),
-            load_dex_magic_from_dex(file_path.c_str()));
-        dex_stats_t dex_stats;
-        DexClasses classes =
-            load_classes_from_dex(file_path.c_str(), &dex_stats);
-
-        input_totals += dex_stats;
-        input_dexes_stats.push_back(dex_stats);
-        store.add_classes(std::move(classes));
+        add_dex(file_path, stores.size() + metadata_stores.size());
       }
-      stores.emplace_back(std::move(store));
+      metadata_stores.emplace_back(store_metadata);
     }
   }
+
+  std::vector<dex_stats_t> dexes_stats;
+  auto dexen = load_classes_from_dexes(dex_paths, &dexes_stats);
+  stores.insert(stores.end(),
+                std::make_move_iterator(metadata_stores.begin()),
+                std::make_move_iterator(metadata_stores.end()));
+  for (size_t i = 0; i < dexen.size(); ++i) {
+    input_totals += dexes_stats[i];
+    input_dexes_stats.push_back(dexes_stats[i]);
+    stores[dex_store_indices[i]].add_classes(std::move(dexen[i]));
+  }
 }
 
 /**
@@ -317,4 +325,129 @@ std::string get_dex_output_name(const std::string& output_dir,
                                 int index) {
   return output_dir + "/" + dex_name(store, index);
 }
+
+namespace {
+
+Json::Value method_to_capsule(const DexMethod* method) {
+  auto code = method->get_code();
+  always_assert_log(!code->editable_cfg_built(), "%s has a cfg!",
+                    SHOW(method));
+  Json::Value res;
+  res["name"] = show(method);
+  res["access"] = (Json::UInt)method->get_access();
+  res["virtual"] = method->is_virtual();
+  res["code"] = assembler::to_string(code);
+  return res;
+}
+
+} // namespace
+
+Json::Value make_method_capsule(const DexMethod* method,
+                                const Json::Value& config) {
+  always_assert_log(method->get_code() != nullptr, "%s has no code",
+                    SHOW(method));
+  std::vector<const DexMethod*> methods{method};
+  std::unordered_set<const DexMethod*> seen{method};
+  for (const auto& mie : InstructionIterable(method->get_code())) {
+    if (!mie.insn->has_method()) {
+      continue;
+    }
+    auto callee = resolve_method(mie.insn->get_method(),
+                                 opcode_to_search(mie.insn), method);
+    if (callee != nullptr && callee->get_code() != nullptr &&
+        seen.insert(callee).second) {
+      methods.push_back(callee);
+    }
+  }
+
+  // Classes are listed with their superclasses first, so that they can be
+  // re-created in order.
+  std::vector<const DexClass*> classes;
+  std::unordered_set<const DexClass*> seen_classes;
+  for (auto m : methods) {
+    std::vector<const DexClass*> chain;
+    for (auto cls = type_class(m->get_class());
+         cls != nullptr && !cls->is_external() && !seen_classes.count(cls);
+         cls = type_class(cls->get_super_class())) {
+      seen_classes.insert(cls);
+      chain.push_back(cls);
+    }
+    classes.insert(classes.end(), chain.rbegin(), chain.rend());
+  }
+
+  Json::Value capsule;
+  capsule["method"] = show(method);
+  capsule["classes"] = Json::arrayValue;
+  for (auto cls : classes) {
+    Json::Value jcls;
+    jcls["name"] = show(cls->get_type());
+    jcls["access"] = (Json::UInt)cls->get_access();
+    if (cls->get_super_class() != nullptr) {
+      jcls["super"] = show(cls->get_super_class());
+    }
+    jcls["interfaces"] = Json::arrayValue;
+    for (auto intf : *cls->get_interfaces()) {
+      jcls["interfaces"].append(show(intf));
+    }
+    capsule["classes"].append(jcls);
+  }
+  capsule["methods"] = Json::arrayValue;
+  for (auto m : methods) {
+    capsule["methods"].append(method_to_capsule(m));
+  }
+  capsule["config"] = config;
+  return capsule;
+}
+
+void load_method_capsule(const Json::Value& capsule, DexStoresVector& stores) {
+  std::unordered_map<std::string, std::unique_ptr<ClassCreator>> creators;
+  std::vector<ClassCreator*> ordered;
+  for (const auto& jcls : capsule["classes"]) {
+    auto cc = std::make_unique<ClassCreator>(
+        DexType::make_type(jcls["name"].asString().c_str()));
+    cc->set_access((DexAccessFlags)jcls["access"].asUInt());
+    if (jcls.isMember("super")) {
+      cc->set_super(DexType::make_type(jcls["super"].asString().c_str()));
+    }
+    for (const auto& intf : jcls["interfaces"]) {
+      cc->add_interface(DexType::make_type(intf.asString().c_str()));
+    }
+    ordered.push_back(cc.get());
+    creators.emplace(jcls["name"].asString(), std::move(cc));
+  }
+  const auto& target = capsule["method"].asString();
+  for (const auto& jmethod : capsule["methods"]) {
+    const auto& name = jmethod["name"].asString();
+    auto method = DexMethod::make_method(name)->make_concrete(
+        (DexAccessFlags)jmethod["access"].asUInt(),
+        jmethod["virtual"].asBool());
+    method->set_code(assembler::ircode_from_string(jmethod["code"].asString()));
+    if (name != target) {
+      // Keep the callees around, so that replays are repeatable.
+      method->rstate.set_root();
+    }
+    creators.at(show(method->get_class()))->add_method(method);
+  }
+
+  DexClasses classes;
+  for (auto cc : ordered) {
+    classes.push_back(cc->create());
+  }
+  DexMetadata dm;
+  dm.set_id("classes");
+  DexStore store(dm);
+  store.add_classes(std::move(classes));
+  stores.emplace_back(std::move(store));
+}
+
+void reset_method_capsule_code(const Json::Value& capsule) {
+  for (const auto& jmethod : capsule["methods"]) {
+    auto ref = DexMethod::get_method(jmethod["name"].asString());
+    auto method = ref == nullptr ? nullptr : ref->as_def();
+    if (method != nullptr) {
+      method->set_code(
+          assembler::ircode_from_string(jmethod["code"].asString()));
+    }
+  }
+}
 } // namespace redex
@@ -35,4 +35,24 @@ void load_classes_from_dexes_and_metadata(
 std::string get_dex_output_name(const std::string& output_dir,
                                 const DexStore& store,
                                 int index);
+
+/**
+ * A method capsule is a standalone JSON record of one method, to replay a
+ * pass on just that method. It holds the method's code, the code of the
+ * methods it directly invokes, the internal classes of their type hierarchies,
+ * and the given config.
+ */
+Json::Value make_method_capsule(const DexMethod* method,
+                                const Json::Value& config);
+
+/**
+ * Re-creates the classes and methods of a capsule, as a single store.
+ */
+void load_method_capsule(const Json::Value& capsule, DexStoresVector& stores);
+
+/**
+ * Restores the code of the methods of a loaded capsule, e.g. before replaying
+ * a pass again.
+ */
+void reset_method_capsule_code(const Json::Value& capsule);
 } // namespace redex
@@ -8,25 +8,40 @@
 #include <cstdio>
 #include <cstdlib>
 #include <getopt.h>
+#include <cstring>
 #include <regex>
 
 #include "DexCommon.h"
 
 void print_usage() {
-  fprintf(stderr, "Usage: dexgrep <classname> <dexfile 1> <dexfile 2> ...\n");
+  fprintf(stderr,
+          "Usage: dexgrep [-F] <classname> <dexfile 1> <dexfile 2> ...\n"
+          "  -F, --fixed-strings: match <classname> as a plain substring\n");
+}
+
+// Whether the pattern matches exactly the strings containing it literally, so
+// that it can be searched for without the (slow) regex engine.
+bool is_literal(const char* pattern) {
+  return strpbrk(pattern, "\\^$.|?*+()[]{}") == nullptr;
 }
 
 int main(int argc, char* argv[]) {
   bool files_only = false;
+  bool fixed_strings = false;
   char c;
   static const struct option options[] = {
       {"files-without-match", no_argument, nullptr, 'l'},
+      {"fixed-strings", no_argument, nullptr, 'F'},
+      {nullptr, 0, nullptr, 0},
   };
-  while ((c = getopt_long(argc, argv, "hl", &options[0], nullptr)) != -1) {
+  while ((c = getopt_long(argc, argv, "hlF", &options[0], nullptr)) != -1) {
     switch (c) {
     case 'l':
       files_only = true;
       break;
+    case 'F':
+      fixed_strings = true;
+      break;
     case 'h':
       print_usage();
       return 0;
@@ -43,7 +58,11 @@ int main(int argc, char* argv[]) {
   }
 
   const char* search_str = argv[optind];
-  std::regex re(search_str);
+  fixed_strings = fixed_strings || is_literal(search_str);
+  std::regex re;
+  if (!fixed_strings) {
+    re = std::regex(search_str);
+  }
 
   for (int i = optind + 1; i < argc; ++i) {
     const char* dexfile = argv[i];
@@ -54,7 +73,9 @@ int main(int argc, char* argv[]) {
     for (uint32_t j = 0; j < size; j++) {
       dex_class_def* cls_def = rd.dex_class_defs + j;
       char* name = dex_string_by_type_idx(&rd, cls_def->typeidx);
-      if (std::regex_search(name, re)) {
+      bool matches = fixed_strings ? strstr(name, search_str) != nullptr
+                                   : std::regex_search(name, re);
+      if (matches) {
         if (files_only) {
           printf("%s\n", dexfile);
         } else {
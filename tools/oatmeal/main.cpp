@@ -11,6 +11,7 @@
 #include "vdex.h"
 
 #include <getopt.h>
+#include <sys/mman.h>
 
 #ifndef ANDROID
 #include <wordexp.h>
@@ -20,6 +21,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <functional>
 #include <memory>
 
 #include <string>
@@ -249,18 +251,24 @@ int dump(const Arguments& args) {
 
   auto oat_file_size = get_filesize(oat_file);
 
-  // We don't run dumping during install on device, so it is allowed to consume
-  // lots of memory.
-  auto oat_file_contents = std::make_unique<char[]>(oat_file_size);
-  auto oatFileBytesRead =
-      fread(oat_file_contents.get(), 1, oat_file_size, oat_file.get());
-  if (oatFileBytesRead != oat_file_size) {
+  // Map the file rather than reading it up front, so that only the parts we
+  // actually parse get paged in.
+  void* mapped = mmap(nullptr,
+                      oat_file_size,
+                      PROT_READ,
+                      MAP_PRIVATE,
+                      fileno(oat_file.get()),
+                      0);
+  if (mapped == MAP_FAILED) {
     fprintf(stderr,
-            "Failed to read file %s (%zd)\n",
-            std::strerror(errno),
-            oatFileBytesRead);
+            "Failed to map file %s %s\n",
+            oat_file_name.c_str(),
+            std::strerror(errno));
     return 1;
   }
+  std::unique_ptr<char, std::function<void(char*)>> oat_file_contents(
+      static_cast<char*>(mapped),
+      [oat_file_size](char* p) { munmap(p, oat_file_size); });
 
   ConstBuffer oatfile_buffer{oat_file_contents.get(), oat_file_size};
   auto ma_scope = MemoryAccounter::NewScope(oatfile_buffer);
@@ -129,6 +129,16 @@ class MemoryAccounterImpl : public MemoryAccounter {
   void markRangeImpl(uint32_t begin, uint32_t end) {
     CHECK(begin <= end);
     CHECK(end <= buf_.len);
+    // Parsing mostly consumes the buffer sequentially, so extend the last
+    // range when possible rather than recording one range per read. This
+    // doesn't hide double consumption, as the ranges remain disjoint.
+    if (consumed_ranges_.size() > 1) {
+      auto& last = consumed_ranges_.back();
+      if (last.end == begin) {
+        last.end = end;
+        return;
+      }
+    }
     consumed_ranges_.emplace_back(begin, end);
   }
 };
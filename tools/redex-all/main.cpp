@@ -10,6 +10,7 @@
 #include <cstring>
 #include <ctime>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <memory>
 #include <regex>
@@ -52,6 +53,7 @@
 #include "Macros.h"
 #include "MonitorCount.h"
 #include "NoOptimizationsMatcher.h"
+#include "NumaTopology.h"
 #include "OptData.h"
 #include "PassRegistry.h"
 #include "PostLowering.h"
@@ -97,6 +99,8 @@ struct Arguments {
   // command line arguments. For development usage
   Json::Value entry_data;
   boost::optional<int> stop_pass_idx;
+  boost::optional<int> snapshot_pass_idx;
+  std::string snapshot_dir;
   RedexOptions redex_options;
 };
 
@@ -332,6 +336,11 @@ Arguments parse_args(int argc, char* argv[]) {
                    "Stop before pass n and output IR to file");
   od.add_options()("output-ir", po::value<std::string>(),
                    "IR output directory, used with --stop-pass");
+  od.add_options()("snapshot-after-pass", po::value<int>(),
+                   "Write an IR snapshot after pass n, which redex-opt "
+                   "--resume can continue from, and keep going");
+  od.add_options()("snapshot-dir", po::value<std::string>(),
+                   "IR snapshot directory, used with --snapshot-after-pass");
 
   po::positional_options_description pod;
   pod.add("dex-files", -1);
@@ -514,6 +523,23 @@ Arguments parse_args(int argc, char* argv[]) {
     }
   }
 
+  if (vm.count("snapshot-after-pass")) {
+    args.snapshot_pass_idx = vm["snapshot-after-pass"].as<int>();
+    int idx = *args.snapshot_pass_idx;
+    if (idx < 0 || (size_t)idx >= args.config["redex"]["passes"].size()) {
+      std::cerr << "Invalid snapshot-after-pass value\n";
+      exit(EXIT_FAILURE);
+    }
+    if (vm.count("snapshot-dir")) {
+      args.snapshot_dir = vm["snapshot-dir"].as<std::string>();
+    }
+    if (args.snapshot_dir.empty() ||
+        !redex::dir_is_writable(args.snapshot_dir)) {
+      std::cerr << "snapshot-dir is empty or not writable" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+
   std::string metafiles = args.out_dir + "/meta/";
   int status = [&metafiles]() -> int {
 #if !IS_WINDOWS
@@ -615,6 +641,13 @@ Json::Value get_stats(const dex_stats_t& stats) {
   val["annotations_directory_count"] = stats.annotations_directory_count;
   val["annotations_directory_bytes"] = stats.annotations_directory_bytes;
 
+  val["num_startup_methods"] = stats.num_startup_methods;
+  val["startup_code_pages"] = stats.startup_code_pages;
+  val["startup_string_data_pages"] = stats.startup_string_data_pages;
+  val["startup_class_def_pages"] = stats.startup_class_def_pages;
+  val["startup_debug_info_pages"] = stats.startup_debug_info_pages;
+  val["startup_pages"] = stats.startup_pages;
+
   return val;
 }
 
@@ -664,6 +697,7 @@ Json::Value get_lowering_stats(const instruction_lowering::Stats& stats) {
   Json::Value obj(Json::ValueType::objectValue);
   obj["num_2addr_instructions"] = Json::UInt(stats.to_2addr);
   obj["num_move_added_for_check_cast"] = Json::UInt(stats.move_for_check_cast);
+  obj["num_hot_packed_switches"] = Json::UInt(stats.hot_packed_switches);
   return obj;
 }
 
@@ -697,6 +731,41 @@ Json::Value get_times(double cpu_time_s) {
   return list;
 }
 
+// Timer scopes in the Chrome trace event format, which can be loaded into
+// Perfetto or chrome://tracing.
+Json::Value get_trace_events() {
+  const auto& events = Timer::get_trace_events();
+  const auto num_threads = redex_parallel::default_num_threads();
+  Json::Value list(Json::arrayValue);
+  for (size_t i = 0; i < events.size(); i++) {
+    Json::Value event;
+    event["name"] = events.names[i];
+    event["cat"] = "redex";
+    event["ph"] = "X";
+    event["pid"] = 0;
+    event["tid"] = events.thread_ids[i];
+    event["ts"] = (Json::UInt64)events.start_us[i];
+    event["dur"] = (Json::UInt64)events.wall_us[i];
+    Json::Value args;
+    args["depth"] = events.depths[i];
+    args["cpu_us"] = (Json::UInt64)events.cpu_us[i];
+    if (events.wall_us[i] > 0) {
+      // Fraction of the available cores that was busy during the scope.
+      double utilization = (double)events.cpu_us[i] /
+                           ((double)events.wall_us[i] * num_threads);
+      args["thread_utilization"] = std::round(utilization * 100) / 100.0;
+    }
+    args["vm_hwm_delta"] = (Json::Int64)events.vm_hwm_delta[i];
+    args["allocated_delta"] = (Json::Int64)events.allocated_delta[i];
+    event["args"] = args;
+    list.append(event);
+  }
+  Json::Value trace;
+  trace["traceEvents"] = list;
+  trace["displayTimeUnit"] = "ms";
+  return trace;
+}
+
 Json::Value get_input_stats(const dex_stats_t& stats,
                             const std::vector<dex_stats_t>& dexes_stats) {
   Json::Value d;
@@ -875,9 +944,10 @@ void redex_frontend(ConfigFiles& conf, /* input */
 
   g_redex->load_pointers_cache();
 
-  for (const auto& pg_config_path : args.proguard_config_paths) {
-    Timer time_pg_parsing("Parsed ProGuard config file");
-    keep_rules::proguard_parser::parse_file(pg_config_path, &pg_config);
+  {
+    Timer time_pg_parsing("Parsed ProGuard config files");
+    keep_rules::proguard_parser::parse_files(args.proguard_config_paths,
+                                             &pg_config);
   }
   keep_rules::proguard_parser::remove_blocklisted_rules(&pg_config);
 
@@ -925,20 +995,40 @@ void redex_frontend(ConfigFiles& conf, /* input */
   args.entry_data["jars"] = Json::arrayValue;
   if (!library_jars.empty()) {
     Timer t("Load library jars");
+    // Parsed library jars may be cached across builds.
+    std::string jar_cache_dir =
+        json_config.get("library_jar_cache_dir", std::string());
 
+    // Jars that can't be found as given are looked up in the basedir.
+    std::vector<std::string> jar_paths;
+    std::vector<bool> in_basedir;
     for (const auto& library_jar : library_jars) {
       TRACE(MAIN, 1, "LIBRARY JAR: %s", library_jar.c_str());
-      if (!load_jar_file(library_jar.c_str(), &external_classes)) {
-        // Try again with the basedir
-        std::string basedir_path = pg_config.basedirectory + "/" + library_jar;
-        if (!load_jar_file(basedir_path.c_str())) {
-          std::cerr << "error: library jar could not be loaded: " << library_jar
-                    << std::endl;
-          exit(EXIT_FAILURE);
-        }
-        args.entry_data["jars"].append(basedir_path);
+      boost::system::error_code ec;
+      if (boost::filesystem::exists(library_jar, ec)) {
+        jar_paths.push_back(library_jar);
+        in_basedir.push_back(false);
       } else {
-        auto abs_path = boost::filesystem::absolute(library_jar);
+        jar_paths.push_back(pg_config.basedirectory + "/" + library_jar);
+        in_basedir.push_back(true);
+      }
+    }
+
+    std::vector<Scope> jar_classes;
+    auto loaded = load_jar_files(jar_paths, &jar_classes, jar_cache_dir);
+    auto library_jar_it = library_jars.begin();
+    for (size_t i = 0; i < jar_paths.size(); ++i, ++library_jar_it) {
+      if (!loaded[i]) {
+        std::cerr << "error: library jar could not be loaded: "
+                  << *library_jar_it << std::endl;
+        exit(EXIT_FAILURE);
+      }
+      if (in_basedir[i]) {
+        args.entry_data["jars"].append(jar_paths[i]);
+      } else {
+        external_classes.insert(external_classes.end(), jar_classes[i].begin(),
+                                jar_classes[i].end());
+        auto abs_path = boost::filesystem::absolute(jar_paths[i]);
         args.entry_data["jars"].append(abs_path.string());
       }
     }
@@ -1003,6 +1093,70 @@ void redex_frontend(ConfigFiles& conf, /* input */
   }
 }
 
+void dump_class_method_info_map(const std::string& file_path,
+                                DexStoresVector& stores) {
+  std::ofstream ofs(file_path, std::ofstream::out | std::ofstream::trunc);
+
+  static const char* header =
+      "# This map enumerates all class and method sizes and some properties.\n"
+      "# To minimize the size, dex location strings are interned.\n"
+      "# Class information is also interned.\n"
+      "#\n"
+      "# First column can be M, C, and I.\n"
+      "# - C => Class index and information\n"
+      "# - M => Method information\n"
+      "# - I,DEXLOC => Dex location string index\n"
+      "#\n"
+      "# C,<index>,<obfuscated class name>,<deobfuscated class name>,\n"
+      "#   <# of all methods>,<# of all virtual methods>,\n"
+      "#   <dex location string index>\n"
+      "# M,<class index>,<obfuscated method name>,<deobfuscated method name>,\n"
+      "#   <size>,<virtual>,<external>,<concrete>\n"
+      "# I,DEXLOC,<index>,<string>";
+  ofs << header << '\n';
+
+  auto exclude_class_name = [&](const std::string& full_name) {
+    const auto dot_pos = full_name.find('.');
+    always_assert(dot_pos != std::string::npos);
+    // Return excluding class name and "."
+    return full_name.substr(dot_pos + 1);
+  };
+
+  auto print = [&](const int cls_idx, const DexMethod* method) {
+    ofs << "M," << cls_idx << "," << exclude_class_name(show(method)) << ","
+        << exclude_class_name(method->get_fully_deobfuscated_name()) << ","
+        << (method->get_dex_code() ? method->get_dex_code()->size() : 0) << ","
+        << method->is_virtual() << "," << method->is_external() << ","
+        << method->is_concrete() << '\n';
+  };
+
+  // Interning
+  std::unordered_map<const DexClass*, int /*index*/> class_map;
+  std::unordered_map<std::string /*location*/, int /*index*/> dexloc_map;
+
+  walk::classes(build_class_scope(stores), [&](const DexClass* cls) {
+    const auto& dexloc = cls->get_location();
+    if (!dexloc_map.count(dexloc)) {
+      dexloc_map[dexloc] = dexloc_map.size();
+      ofs << "I,DEXLOC," << dexloc_map[dexloc] << "," << dexloc << '\n';
+    }
+
+    redex_assert(!class_map.count(cls));
+    const int cls_idx = (class_map[cls] = class_map.size());
+    ofs << "C," << cls_idx << "," << show(cls) << "," << show_deobfuscated(cls)
+        << "," << (cls->get_dmethods().size() + cls->get_vmethods().size())
+        << "," << cls->get_vmethods().size() << "," << dexloc_map[dexloc]
+        << '\n';
+
+    for (auto dmethod : cls->get_dmethods()) {
+      print(cls_idx, dmethod);
+    }
+    for (auto vmethod : cls->get_vmethods()) {
+      print(cls_idx, vmethod);
+    }
+  });
+}
+
 /**
  * Post processing steps: write dex and collect stats
  */
@@ -1046,9 +1200,11 @@ void redex_backend(ConfigFiles& conf,
   auto dik = redex_options.debug_info_kind;
   bool needs_addresses = dik == DebugInfoKind::NoPositions || is_iodi(dik);
 
-  std::unique_ptr<PositionMapper> pos_mapper(PositionMapper::make(
+  const std::string& pos_map_filename =
       dik == DebugInfoKind::NoCustomSymbolication ? ""
-                                                  : line_number_map_filename));
+                                                  : line_number_map_filename;
+  std::unique_ptr<PositionMapper> pos_mapper(
+      PositionMapper::make(pos_map_filename));
   std::unordered_map<DexMethod*, uint64_t> method_to_id;
   std::unordered_map<DexCode*, std::vector<DebugLineItem>> code_debug_lines;
 
@@ -1075,30 +1231,107 @@ void redex_backend(ConfigFiles& conf,
     Timer t("Compute initial IODI metadata");
     iodi_metadata.mark_methods(stores);
   }
-  for (size_t store_number = 0; store_number < stores.size(); ++store_number) {
-    auto& store = stores[store_number];
-    Timer t("Writing optimized dexes");
-    for (size_t i = 0; i < store.get_dexen().size(); i++) {
-      auto this_dex_stats = write_classes_to_dex(
-          redex_options,
-          redex::get_dex_output_name(output_dir, store, i),
-          &store.get_dexen()[i],
-          locator_index,
-          store_number,
-          i,
-          conf,
-          pos_mapper.get(),
-          needs_addresses ? &method_to_id : nullptr,
-          needs_addresses ? &code_debug_lines : nullptr,
-          is_iodi(dik) ? &iodi_metadata : nullptr,
-          stores[0].get_dex_magic(),
-          symbolicate_detached_methods ? post_lowering.get() : nullptr,
-          manager.get_redex_options().min_sdk,
-          disable_method_similarity_order);
-
-      output_totals += this_dex_stats;
-      output_dexes_stats.push_back(this_dex_stats);
-      signatures.insert(*reinterpret_cast<uint32_t*>(this_dex_stats.signature));
+  {
+    // Every dex sorts its strings, types and member refs by name; sort all
+    // strings once up front so that those sorts compare integers.
+    Timer t("Assigning string ordinals");
+    g_redex->assign_string_ordinals();
+  }
+  // Dexes can only be laid out concurrently when nothing carries over from one
+  // dex to the next: the RealPositionMapper numbers lines in emission order,
+  // and IODI and post-lowering keep cross-dex state.
+  bool parallel_dex_output =
+      json_config.get("parallel_dex_output", false) &&
+      pos_map_filename.empty() && !is_iodi(dik) && !post_lowering;
+  auto record_dex_stats = [&](const dex_stats_t& this_dex_stats) {
+    output_totals += this_dex_stats;
+    output_dexes_stats.push_back(this_dex_stats);
+    signatures.insert(*reinterpret_cast<const uint32_t*>(
+        this_dex_stats.signature));
+  };
+  if (parallel_dex_output) {
+    Timer t("Writing optimized dexes (parallel)");
+    struct DexEmission {
+      size_t store_number;
+      size_t dex_number;
+      std::unordered_map<DexMethod*, uint64_t> method_to_id;
+      std::unordered_map<DexCode*, std::vector<DebugLineItem>>
+          code_debug_lines;
+      std::unique_ptr<DexOutput> output;
+    };
+    std::vector<DexEmission> emissions;
+    for (size_t store_number = 0; store_number < stores.size();
+         ++store_number) {
+      for (size_t i = 0; i < stores[store_number].get_dexen().size(); i++) {
+        emissions.push_back(DexEmission{store_number, i, {}, {}, nullptr});
+      }
+    }
+    // Loaded lazily, so make sure that happens before going parallel.
+    conf.get_method_profiles();
+    // Every prepared dex holds on to its output buffer until it is written,
+    // so only prepare as many dexes at a time as there are workers.
+    size_t batch_size = redex_parallel::default_num_threads();
+    for (size_t begin = 0; begin < emissions.size(); begin += batch_size) {
+      size_t end = std::min(begin + batch_size, emissions.size());
+      std::vector<DexEmission*> batch;
+      for (size_t j = begin; j < end; j++) {
+        batch.push_back(&emissions[j]);
+      }
+      workqueue_run<DexEmission*>(
+          [&](DexEmission* e) {
+            auto& store = stores[e->store_number];
+            e->output = prepare_classes_for_dex(
+                redex_options,
+                redex::get_dex_output_name(output_dir, store, e->dex_number),
+                &store.get_dexen()[e->dex_number],
+                locator_index,
+                e->store_number,
+                e->dex_number,
+                conf,
+                pos_mapper.get(),
+                needs_addresses ? &e->method_to_id : nullptr,
+                needs_addresses ? &e->code_debug_lines : nullptr,
+                nullptr,
+                stores[0].get_dex_magic(),
+                nullptr,
+                manager.get_redex_options().min_sdk,
+                disable_method_similarity_order);
+          },
+          batch);
+      // Symbol files are appended to and unique-reference stats accumulate,
+      // so finish the dexes in order.
+      for (auto* e : batch) {
+        record_dex_stats(finish_classes_for_dex(*e->output));
+        e->output.reset();
+        method_to_id.insert(e->method_to_id.begin(), e->method_to_id.end());
+        code_debug_lines.insert(
+            std::make_move_iterator(e->code_debug_lines.begin()),
+            std::make_move_iterator(e->code_debug_lines.end()));
+      }
+    }
+  } else {
+    for (size_t store_number = 0; store_number < stores.size();
+         ++store_number) {
+      auto& store = stores[store_number];
+      Timer t("Writing optimized dexes");
+      for (size_t i = 0; i < store.get_dexen().size(); i++) {
+        record_dex_stats(write_classes_to_dex(
+            redex_options,
+            redex::get_dex_output_name(output_dir, store, i),
+            &store.get_dexen()[i],
+            locator_index,
+            store_number,
+            i,
+            conf,
+            pos_mapper.get(),
+            needs_addresses ? &method_to_id : nullptr,
+            needs_addresses ? &code_debug_lines : nullptr,
+            is_iodi(dik) ? &iodi_metadata : nullptr,
+            stores[0].get_dex_magic(),
+            symbolicate_detached_methods ? post_lowering.get() : nullptr,
+            manager.get_redex_options().min_sdk,
+            disable_method_similarity_order));
+      }
     }
   }
 
@@ -1118,32 +1351,49 @@ void redex_backend(ConfigFiles& conf,
   }
 
   {
-    Timer t("Writing opt decisions data");
+    // The metadata files only read the final state of the stores, so write
+    // them concurrently.
+    Timer t("Writing metadata files");
+    std::vector<std::function<void()>> writers;
     const Json::Value& opt_decisions_args = json_config["opt_decisions"];
     if (opt_decisions_args.get("enable_logs", false).asBool()) {
-      auto opt_decisions_output_path = conf.metafile(OPT_DECISIONS);
-      auto opt_data =
-          opt_metadata::OptDataMapper::get_instance().serialize_sql();
-      {
+      writers.push_back([&]() {
+        auto opt_decisions_output_path = conf.metafile(OPT_DECISIONS);
+        auto opt_data =
+            opt_metadata::OptDataMapper::get_instance().serialize_sql();
         std::ofstream opt_data_out(opt_decisions_output_path);
         opt_data_out << opt_data;
-      }
+      });
     }
-  }
-
-  {
-    Timer t("Writing stats");
-    auto method_move_map =
-        conf.metafile(json_config.get("method_move_map", std::string()));
     if (needs_addresses) {
-      write_debug_line_mapping(debug_line_map_filename, method_to_id,
-                               code_debug_lines, stores,
-                               needs_debug_line_mapping);
+      writers.push_back([&]() {
+        write_debug_line_mapping(debug_line_map_filename, method_to_id,
+                                 code_debug_lines, stores,
+                                 needs_debug_line_mapping);
+      });
     }
     if (is_iodi(dik)) {
-      iodi_metadata.write(iodi_metadata_filename, method_to_id);
+      writers.push_back([&]() {
+        iodi_metadata.write(iodi_metadata_filename, method_to_id);
+      });
     }
-    pos_mapper->write_map();
+    writers.push_back([&]() { pos_mapper->write_map(); });
+    if (json_config.get("emit_class_method_info_map", false)) {
+      writers.push_back([&]() {
+        dump_class_method_info_map(conf.metafile(CLASS_METHOD_INFO_MAP),
+                                   stores);
+      });
+    }
+    bool parallel_metadata_output =
+        json_config.get("parallel_metadata_output", true);
+    workqueue_run<std::function<void()>>(
+        [](const std::function<void()>& writer) { writer(); },
+        writers,
+        parallel_metadata_output ? writers.size() : 1);
+  }
+
+  {
+    Timer t("Writing stats");
     stats["output_stats"] =
         get_output_stats(output_totals, output_dexes_stats, manager,
                          instruction_lowering_stats, pos_mapper.get());
@@ -1151,70 +1401,6 @@ void redex_backend(ConfigFiles& conf,
   }
 }
 
-void dump_class_method_info_map(const std::string& file_path,
-                                DexStoresVector& stores) {
-  std::ofstream ofs(file_path, std::ofstream::out | std::ofstream::trunc);
-
-  static const char* header =
-      "# This map enumerates all class and method sizes and some properties.\n"
-      "# To minimize the size, dex location strings are interned.\n"
-      "# Class information is also interned.\n"
-      "#\n"
-      "# First column can be M, C, and I.\n"
-      "# - C => Class index and information\n"
-      "# - M => Method information\n"
-      "# - I,DEXLOC => Dex location string index\n"
-      "#\n"
-      "# C,<index>,<obfuscated class name>,<deobfuscated class name>,\n"
-      "#   <# of all methods>,<# of all virtual methods>,\n"
-      "#   <dex location string index>\n"
-      "# M,<class index>,<obfuscated method name>,<deobfuscated method name>,\n"
-      "#   <size>,<virtual>,<external>,<concrete>\n"
-      "# I,DEXLOC,<index>,<string>";
-  ofs << header << std::endl;
-
-  auto exclude_class_name = [&](const std::string& full_name) {
-    const auto dot_pos = full_name.find('.');
-    always_assert(dot_pos != std::string::npos);
-    // Return excluding class name and "."
-    return full_name.substr(dot_pos + 1);
-  };
-
-  auto print = [&](const int cls_idx, const DexMethod* method) {
-    ofs << "M," << cls_idx << "," << exclude_class_name(show(method)) << ","
-        << exclude_class_name(method->get_fully_deobfuscated_name()) << ","
-        << (method->get_dex_code() ? method->get_dex_code()->size() : 0) << ","
-        << method->is_virtual() << "," << method->is_external() << ","
-        << method->is_concrete() << std::endl;
-  };
-
-  // Interning
-  std::unordered_map<const DexClass*, int /*index*/> class_map;
-  std::unordered_map<std::string /*location*/, int /*index*/> dexloc_map;
-
-  walk::classes(build_class_scope(stores), [&](const DexClass* cls) {
-    const auto& dexloc = cls->get_location();
-    if (!dexloc_map.count(dexloc)) {
-      dexloc_map[dexloc] = dexloc_map.size();
-      ofs << "I,DEXLOC," << dexloc_map[dexloc] << "," << dexloc << std::endl;
-    }
-
-    redex_assert(!class_map.count(cls));
-    const int cls_idx = (class_map[cls] = class_map.size());
-    ofs << "C," << cls_idx << "," << show(cls) << "," << show_deobfuscated(cls)
-        << "," << (cls->get_dmethods().size() + cls->get_vmethods().size())
-        << "," << cls->get_vmethods().size() << "," << dexloc_map[dexloc]
-        << std::endl;
-
-    for (auto dmethod : cls->get_dmethods()) {
-      print(cls_idx, dmethod);
-    }
-    for (auto vmethod : cls->get_vmethods()) {
-      print(cls_idx, vmethod);
-    }
-  });
-}
-
 } // namespace
 
 int main(int argc, char* argv[]) {
@@ -1234,6 +1420,7 @@ int main(int argc, char* argv[]) {
       ScopedCommandProfiling::maybe_from_env("GLOBAL_", "global");
 
   std::string stats_output_path;
+  std::string trace_events_output_path;
   Json::Value stats;
   double cpu_time_s;
   {
@@ -1253,9 +1440,19 @@ int main(int argc, char* argv[]) {
     //       list of library JARS.
     Arguments args = parse_args(argc, argv);
 
+    bool emit_trace_events =
+        args.config.get("emit_trace_events", false).asBool();
+    Timer::enable_trace_events(emit_trace_events);
+
     RedexContext::set_record_keep_reasons(
         args.config.get("record_keep_reasons", false).asBool());
 
+    RedexContext::set_lazy_balloon(
+        args.config.get("lazy_balloon", false).asBool());
+
+    sparta::numa::set_worker_pinning(
+        args.config.get("numa_worker_pinning", false).asBool());
+
     slow_invariants_debug =
         args.config.get("slow_invariants_debug", false).asBool();
     cfg::ControlFlowGraph::DEBUG =
@@ -1291,6 +1488,23 @@ int main(int argc, char* argv[]) {
     PassManager manager(passes, std::move(pg_config), args.config,
                         args.redex_options);
 
+    if (args.snapshot_pass_idx != boost::none) {
+      manager.set_snapshot_after_pass(
+          *args.snapshot_pass_idx,
+          [&args](const PassManager::PassInfo& pass_info,
+                  DexStoresVector& stores, ConfigFiles& conf) {
+            // Keep metafiles of the passes run for the snapshot out of the
+            // real output directory.
+            conf.set_outdir(args.snapshot_dir);
+            Json::Value entry_data = args.entry_data;
+            entry_data["resume_pass_index"] =
+                (Json::UInt)(pass_info.config_index + 1);
+            redex::write_all_intermediate(conf, args.snapshot_dir,
+                                          args.redex_options, stores,
+                                          entry_data);
+          });
+    }
+
     std::unordered_map<std::string, std::string> exp_states;
     conf.get_json_config().get("ab_experiments_states", {}, exp_states);
     ab_test::ABExperimentContext::parse_experiments_states(
@@ -1306,10 +1520,6 @@ int main(int argc, char* argv[]) {
       auto profile_backend =
           ScopedCommandProfiling::maybe_from_env("BACKEND_", "backend");
       redex_backend(conf, manager, stores, stats);
-      if (args.config.get("emit_class_method_info_map", false).asBool()) {
-        dump_class_method_info_map(conf.metafile(CLASS_METHOD_INFO_MAP),
-                                   stores);
-      }
     } else {
       redex::write_all_intermediate(conf, args.out_dir, args.redex_options,
                                     stores, args.entry_data);
@@ -1317,6 +1527,13 @@ int main(int argc, char* argv[]) {
 
     stats_output_path = conf.metafile(
         args.config.get("stats_output", "redex-stats.txt").asString());
+    if (emit_trace_events) {
+      trace_events_output_path =
+          conf.metafile(args.config
+                            .get("trace_events_output",
+                                 "redex-trace-events.json")
+                            .asString());
+    }
 
     {
       Timer t("Freeing global memory");
@@ -1338,6 +1555,10 @@ int main(int argc, char* argv[]) {
     std::ofstream out(stats_output_path);
     out << stats;
   }
+  if (!trace_events_output_path.empty()) {
+    std::ofstream out(trace_events_output_path);
+    out << get_trace_events();
+  }
 
   TRACE(MAIN, 1, "Done.");
   if (traceEnabled(MAIN, 1) || traceEnabled(STATS, 1)) {
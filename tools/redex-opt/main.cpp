@@ -7,6 +7,7 @@
 
 #include <boost/filesystem.hpp>
 #include <boost/program_options.hpp>
+#include <fstream>
 #include <iostream>
 #include <json/json.h>
 
@@ -22,10 +23,15 @@ struct Arguments {
   std::string input_ir_dir;
   std::string output_ir_dir;
   std::vector<std::string> pass_names;
+  bool resume{false};
   RedexOptions redex_options;
   std::string config_file;
   std::vector<std::string> s_args;
   std::vector<std::string> j_args;
+  // Method capsules: export one method, or replay passes on one.
+  std::string export_capsule_method;
+  std::string capsule_file;
+  size_t replay_iterations{1};
 };
 
 Arguments parse_args(int argc, char* argv[]) {
@@ -40,10 +46,25 @@ Arguments parse_args(int argc, char* argv[]) {
                      "output dex and IR meta directory");
   desc.add_options()("pass-name,p", po::value<std::vector<std::string>>(),
                      "pass name");
+  desc.add_options()("resume",
+                     "run the remaining configured passes of a snapshot "
+                     "written by redex-all --snapshot-after-pass");
   desc.add_options()("config,c",
                      po::value<std::string>(),
                      "A JSON-formatted config file to replace the one from "
                      "{input-ir}/entry.json");
+  desc.add_options()("export-capsule",
+                     po::value<std::string>(),
+                     "write a capsule of the given method of input-ir, e.g. "
+                     "\"LFoo;.bar:(I)V\", to --capsule instead of running "
+                     "passes");
+  desc.add_options()("capsule",
+                     po::value<std::string>(),
+                     "method capsule file; without --export-capsule, the "
+                     "passes given by --pass-name are replayed on it");
+  desc.add_options()("replay-iterations",
+                     po::value<size_t>(),
+                     "number of times to replay the passes on the capsule");
   desc.add_options()(",S",
                      po::value<std::vector<std::string>>(), // Accumulation
                      "-Skey=string\n"
@@ -83,24 +104,48 @@ Arguments parse_args(int argc, char* argv[]) {
     args.input_ir_dir = vm["input-ir"].as<std::string>();
   }
 
+  if (vm.count("export-capsule")) {
+    args.export_capsule_method = vm["export-capsule"].as<std::string>();
+  }
+  if (vm.count("capsule")) {
+    args.capsule_file = vm["capsule"].as<std::string>();
+  }
+  if (vm.count("replay-iterations")) {
+    args.replay_iterations = vm["replay-iterations"].as<size_t>();
+  }
+  if (!args.export_capsule_method.empty() && args.capsule_file.empty()) {
+    std::cerr << "export-capsule requires capsule\n";
+    exit(EXIT_FAILURE);
+  }
+
   if (vm.count("output-ir")) {
     args.output_ir_dir = vm["output-ir"].as<std::string>();
   }
-  if (args.output_ir_dir.empty()) {
+  if (args.output_ir_dir.empty() && args.capsule_file.empty()) {
     std::cerr << "output-dir is empty\n";
     exit(EXIT_FAILURE);
   }
-  std::string meta_dir = args.output_ir_dir + "/meta";
-  boost::filesystem::create_directories(meta_dir);
-  if (!boost::filesystem::is_directory(meta_dir)) {
-    std::cerr << "Could not create " << meta_dir << std::endl;
-    exit(EXIT_FAILURE);
+  if (args.capsule_file.empty()) {
+    std::string meta_dir = args.output_ir_dir + "/meta";
+    boost::filesystem::create_directories(meta_dir);
+    if (!boost::filesystem::is_directory(meta_dir)) {
+      std::cerr << "Could not create " << meta_dir << std::endl;
+      exit(EXIT_FAILURE);
+    }
   }
 
   if (vm.count("pass-name")) {
     args.pass_names = vm["pass-name"].as<std::vector<std::string>>();
   }
 
+  if (vm.count("resume")) {
+    if (!args.pass_names.empty()) {
+      std::cerr << "pass-name and resume are exclusive\n";
+      exit(EXIT_FAILURE);
+    }
+    args.resume = true;
+  }
+
   if (vm.count("config")) {
     args.config_file = vm["config"].as<std::string>();
   }
@@ -162,13 +207,28 @@ bool add_value_to_config(Json::Value& config,
  * - redex_options
  * - config
  * - jars
+ * - resume_pass_index (snapshots only)
  */
 Json::Value process_entry_data(const Json::Value& entry_data,
                                const Arguments& args) {
   Json::Value config_data =
       redex::parse_config(entry_data["config"].asString());
   // Change passes list in config data.
-  config_data["redex"]["passes"] = Json::arrayValue;
+  if (args.resume) {
+    if (!entry_data.isMember("resume_pass_index")) {
+      std::cerr << "input-ir is not a snapshot\n";
+      exit(EXIT_FAILURE);
+    }
+    const auto& configured = config_data["redex"]["passes"];
+    Json::Value remaining = Json::arrayValue;
+    for (Json::ArrayIndex i = entry_data["resume_pass_index"].asUInt();
+         i < configured.size(); ++i) {
+      remaining.append(configured[i]);
+    }
+    config_data["redex"]["passes"] = remaining;
+  } else {
+    config_data["redex"]["passes"] = Json::arrayValue;
+  }
   Json::Value& passes_list = config_data["redex"]["passes"];
   for (const std::string& pass_name : args.pass_names) {
     passes_list.append(pass_name);
@@ -197,6 +257,60 @@ Json::Value process_entry_data(const Json::Value& entry_data,
 
   return config_data;
 }
+
+/**
+ * Runs the passes given on the command line on a method capsule, as many
+ * times as asked, restoring the capsule's code before each run. Meant to be
+ * run under a profiler.
+ */
+void replay_capsule(const Arguments& args) {
+  Json::Value capsule;
+  std::ifstream capsule_in(args.capsule_file);
+  capsule_in >> capsule;
+
+  Json::Value config_data = capsule["config"];
+  config_data["redex"]["passes"] = Json::arrayValue;
+  for (const std::string& pass_name : args.pass_names) {
+    config_data["redex"]["passes"].append(pass_name);
+  }
+  for (auto& key_value : args.s_args) {
+    if (!add_value_to_config(config_data, key_value, false)) {
+      std::cerr << "warning: cannot parse -S" << key_value << std::endl;
+    }
+  }
+  for (auto& key_value : args.j_args) {
+    if (!add_value_to_config(config_data, key_value, true)) {
+      std::cerr << "warning: cannot parse -J" << key_value << std::endl;
+    }
+  }
+
+  DexStoresVector stores;
+  redex::load_method_capsule(capsule, stores);
+  const auto& passes = PassRegistry::get().get_passes();
+  for (size_t i = 0; i < args.replay_iterations; ++i) {
+    if (i > 0) {
+      redex::reset_method_capsule_code(capsule);
+    }
+    Timer t("Replay " + std::to_string(i));
+    ConfigFiles conf(config_data);
+    PassManager manager(passes, config_data, args.redex_options);
+    manager.set_testing_mode();
+    manager.run_passes(stores, conf);
+  }
+}
+
+void export_capsule(const Arguments& args,
+                    const Json::Value& config_data) {
+  auto ref = DexMethod::get_method(args.export_capsule_method);
+  auto method = ref == nullptr ? nullptr : ref->as_def();
+  if (method == nullptr) {
+    std::cerr << "No method definition " << args.export_capsule_method
+              << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  std::ofstream capsule_out(args.capsule_file);
+  capsule_out << redex::make_method_capsule(method, config_data);
+}
 } // namespace
 
 int main(int argc, char* argv[]) {
@@ -205,6 +319,12 @@ int main(int argc, char* argv[]) {
 
   g_redex = new RedexContext();
 
+  if (!args.capsule_file.empty() && args.export_capsule_method.empty()) {
+    replay_capsule(args);
+    delete g_redex;
+    return 0;
+  }
+
   Json::Value entry_data;
 
   DexStoresVector stores;
@@ -225,6 +345,11 @@ int main(int argc, char* argv[]) {
   args.redex_options.deserialize(entry_data);
 
   Json::Value config_data = process_entry_data(entry_data, args);
+  if (!args.export_capsule_method.empty()) {
+    export_capsule(args, config_data);
+    delete g_redex;
+    return 0;
+  }
   ConfigFiles conf(config_data, args.output_ir_dir);
 
   const auto& passes = PassRegistry::get().get_passes();
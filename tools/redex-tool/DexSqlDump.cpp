@@ -22,7 +22,11 @@ $ ./native/redex/tools/redex-tool/DexSqlQuery.py dex.db
 */
 
 #include <boost/algorithm/string/replace.hpp>
+#include <boost/optional.hpp>
+#include <cstdarg>
+#include <numeric>
 #include <queue>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
@@ -34,6 +38,7 @@ $ ./native/redex/tools/redex-tool/DexSqlQuery.py dex.db
 #include "Show.h"
 #include "Tool.h"
 #include "Walkers.h"
+#include "WorkQueue.h"
 
 namespace {
 
@@ -42,8 +47,61 @@ static std::unordered_map<DexMethod*, int> method_ids;
 static std::unordered_map<DexField*, int> field_ids;
 static std::unordered_map<DexString*, int> string_ids;
 
-void dump_field_refs(FILE* fdout,
-                     const char* prefix,
+// Accumulates the rows of one table and writes them out as multi-row INSERT
+// statements, which are both smaller and much faster for sqlite to load than
+// one statement per row.
+class Inserter {
+ public:
+  Inserter(FILE* fdout, const char* prefix, const char* table)
+      : m_fdout(fdout), m_prefix(prefix), m_table(table) {}
+
+  ~Inserter() { flush(); }
+
+  void row(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+    va_list va;
+    va_start(va, format);
+    va_list va_size;
+    va_copy(va_size, va);
+    int size = vsnprintf(nullptr, 0, format, va_size);
+    va_end(va_size);
+    always_assert(size >= 0);
+    m_rows += m_count == 0 ? "\n(" : ",\n(";
+    auto offset = m_rows.size();
+    m_rows.resize(offset + size + 1);
+    vsnprintf(&m_rows[offset], size + 1, format, va);
+    va_end(va);
+    m_rows.resize(offset + size);
+    m_rows += ')';
+    if (++m_count == ROWS_PER_INSERT) {
+      flush();
+    }
+  }
+
+  void flush() {
+    if (m_count == 0) {
+      return;
+    }
+    fprintf(m_fdout,
+            "INSERT INTO %s%s VALUES%s;\n",
+            m_prefix,
+            m_table,
+            m_rows.c_str());
+    m_rows.clear();
+    m_count = 0;
+  }
+
+ private:
+  // Older versions of sqlite limit the number of rows per VALUES clause.
+  static constexpr size_t ROWS_PER_INSERT = 500;
+
+  FILE* m_fdout;
+  const char* m_prefix;
+  const char* m_table;
+  std::string m_rows;
+  size_t m_count{0};
+};
+
+void dump_field_refs(Inserter& field_string_refs,
                      DexField* field,
                      int field_id) {
   static int next_string_ref = 0;
@@ -51,85 +109,94 @@ void dump_field_refs(FILE* fdout,
   if (!static_value || (static_value->evtype() != DEVT_STRING)) return;
   auto* static_string_value = static_cast<DexEncodedValueString*>(static_value);
   auto string_id = string_ids[static_string_value->string()];
-  fprintf(fdout,
-          "INSERT INTO %sfield_string_refs VALUES (%d, %d, %d);\n",
-          prefix,
-          next_string_ref++,
-          field_id,
-          string_id);
+  field_string_refs.row("%d, %d, %d", next_string_ref++, field_id, string_id);
 }
 
-void dump_method_refs(FILE* fdout,
-                      const char* prefix,
-                      DexMethod* method,
-                      int method_id) {
-  auto code = method->get_code();
-  if (!code) return;
+// The items referenced by the code of a method, as (id, opcode) pairs.
+struct MethodRefs {
+  std::vector<std::pair<int, IROpcode>> strings;
+  std::vector<std::pair<int, IROpcode>> classes;
+  std::vector<std::pair<int, IROpcode>> fields;
+  std::vector<std::pair<int, IROpcode>> methods;
+};
 
-  static int next_string_ref = 0;
-  static int next_class_ref = 0;
-  static int next_field_ref = 0;
-  static int next_method_ref = 0;
+// Only reads the id maps, so this can run in parallel once all items have
+// been assigned ids.
+MethodRefs collect_method_refs(DexMethod* method) {
+  MethodRefs refs;
+  auto code = method->get_code();
+  if (!code) return refs;
 
+  auto find_id = [](const auto& ids, auto* item) {
+    auto it = ids.find(item);
+    return it == ids.end() ? boost::none : boost::optional<int>(it->second);
+  };
   for (auto& mie : InstructionIterable(code)) {
     auto insn = mie.insn;
+    auto op = insn->opcode();
     if (insn->has_string()) {
-      if (string_ids.count(insn->get_string())) {
-        auto string_id = string_ids[insn->get_string()];
-        fprintf(fdout,
-                "INSERT INTO %smethod_string_refs VALUES (%d, %d, %d, %d);\n",
-                prefix,
-                next_string_ref++,
-                method_id,
-                string_id,
-                insn->opcode());
+      if (auto id = find_id(string_ids, insn->get_string())) {
+        refs.strings.emplace_back(*id, op);
       }
     }
     if (insn->has_type()) {
       auto cls = type_class(insn->get_type());
-      if (cls && class_ids.count(cls)) {
-        auto class_id = class_ids[cls];
-        fprintf(fdout,
-                "INSERT INTO %smethod_class_refs VALUES (%d, %d, %d, %d);\n",
-                prefix,
-                next_class_ref++,
-                method_id,
-                class_id,
-                insn->opcode());
+      if (cls) {
+        if (auto id = find_id(class_ids, cls)) {
+          refs.classes.emplace_back(*id, op);
+        }
       }
     }
     if (insn->has_field()) {
       auto field = resolve_field(insn->get_field());
-      if (field != nullptr && field_ids.count(field)) {
-        auto field_id = field_ids[field];
-        fprintf(fdout,
-                "INSERT INTO %smethod_field_refs VALUES (%d, %d, %d, %d);\n",
-                prefix,
-                next_field_ref++,
-                method_id,
-                field_id,
-                insn->opcode());
+      if (field != nullptr) {
+        if (auto id = find_id(field_ids, field)) {
+          refs.fields.emplace_back(*id, op);
+        }
       }
     }
     if (insn->has_method()) {
       auto meth =
           resolve_method(insn->get_method(), opcode_to_search(insn), method);
-      if (meth != nullptr && method_ids.count(meth)) {
-        auto method_ref_id = method_ids[meth];
-        fprintf(fdout,
-                "INSERT INTO %smethod_method_refs VALUES (%d, %d, %d, %d);\n",
-                prefix,
-                next_method_ref++,
-                method_id,
-                method_ref_id,
-                insn->opcode());
+      if (meth != nullptr) {
+        if (auto id = find_id(method_ids, meth)) {
+          refs.methods.emplace_back(*id, op);
+        }
       }
     }
   }
+  return refs;
 }
 
-void dump_class(FILE* fdout,
-                const char* prefix,
+struct MethodRefInserters {
+  Inserter strings;
+  Inserter classes;
+  Inserter fields;
+  Inserter methods;
+};
+
+void dump_method_refs(MethodRefInserters& inserters,
+                      const MethodRefs& refs,
+                      int method_id) {
+  static int next_string_ref = 0;
+  static int next_class_ref = 0;
+  static int next_field_ref = 0;
+  static int next_method_ref = 0;
+
+  auto dump = [method_id](Inserter& inserter,
+                          const std::vector<std::pair<int, IROpcode>>& ids,
+                          int& next_ref) {
+    for (const auto& p : ids) {
+      inserter.row("%d, %d, %d, %d", next_ref++, method_id, p.first, p.second);
+    }
+  };
+  dump(inserters.strings, refs.strings, next_string_ref);
+  dump(inserters.classes, refs.classes, next_class_ref);
+  dump(inserters.fields, refs.fields, next_field_ref);
+  dump(inserters.methods, refs.methods, next_method_ref);
+}
+
+void dump_class(Inserter& classes,
                 const char* dex_id,
                 DexClass* cls,
                 int class_id) {
@@ -137,19 +204,16 @@ void dump_class(FILE* fdout,
   // TODO: inheritance?
   // TODO: string usage
   // TODO: size estimate
-  const auto& deobfuscated_name = cls->get_deobfuscated_name();
-  fprintf(fdout,
-          "INSERT INTO %sclasses VALUES (%d,'%s','%s','%s',%u);\n",
-          prefix,
-          class_id,
-          dex_id,
-          deobfuscated_name.c_str(),
-          cls->get_name()->c_str(),
-          cls->get_access());
+  const auto deobfuscated_name = cls->get_deobfuscated_name_copy();
+  classes.row("%d,'%s','%s','%s',%u",
+              class_id,
+              dex_id,
+              deobfuscated_name.c_str(),
+              cls->get_name()->c_str(),
+              cls->get_access());
 }
 
-void dump_field(FILE* fdout,
-                const char* prefix,
+void dump_field(Inserter& fields,
                 int class_id,
                 DexField* field,
                 int field_id) {
@@ -157,20 +221,17 @@ void dump_field(FILE* fdout,
   // TODO: break down signature
   // TODO: annotations?
   // TODO: string usage (encoded_value for static fields)
-  const auto& deobfuscated_name = field->get_deobfuscated_name();
+  const auto deobfuscated_name = field->get_deobfuscated_name_copy();
   auto field_name = strchr(deobfuscated_name.c_str(), ';');
-  fprintf(fdout,
-          "INSERT INTO %sfields VALUES(%d, %d, '%s', '%s', %u);\n",
-          prefix,
-          field_id,
-          class_id,
-          field_name,
-          field->get_name()->c_str(),
-          field->get_access());
+  fields.row("%d, %d, '%s', '%s', %u",
+             field_id,
+             class_id,
+             field_name,
+             field->get_name()->c_str(),
+             field->get_access());
 }
 
-void dump_method(FILE* fdout,
-                 const char* prefix,
+void dump_method(Inserter& methods,
                  int class_id,
                  DexMethod* method,
                  int method_id) {
@@ -180,17 +241,15 @@ void dump_method(FILE* fdout,
   // TODO: annotations?
   // TODO: string usage
   // TODO: size estimate
-  auto deobfuscated_name = method->get_deobfuscated_name();
+  auto deobfuscated_name = method->get_deobfuscated_name_copy();
   auto method_name = strchr(deobfuscated_name.c_str(), ';');
-  fprintf(fdout,
-          "INSERT INTO %smethods VALUES (%d,%d,'%s','%s',%d,%lu);\n",
-          prefix,
-          method_id,
-          class_id,
-          method_name,
-          method->get_name()->c_str(),
-          method->get_access(),
-          method->get_code() ? method->get_code()->sum_opcode_sizes() : 0);
+  methods.row("%d,%d,'%s','%s',%d,%lu",
+              method_id,
+              class_id,
+              method_name,
+              method->get_name()->c_str(),
+              method->get_access(),
+              method->get_code() ? method->get_code()->sum_opcode_sizes() : 0);
 }
 
 void dump_sql(FILE* fdout,
@@ -278,79 +337,112 @@ CREATE TABLE %1$smethod_string_refs (
 
   // Dump all dex items
   fprintf(fdout, "BEGIN TRANSACTION;\n");
-  for (auto& store : stores) {
-    auto store_name = store.get_name();
-    auto& dexen = store.get_dexen();
-    apply_deobfuscated_names(dexen, pg_map);
-    for (size_t dex_idx = 0; dex_idx < dexen.size(); ++dex_idx) {
-      auto& dex = dexen[dex_idx];
-      GatheredTypes gtypes(&dex);
-      auto strings = gtypes.get_cls_order_dexstring_emitlist();
-      for (auto dexstr : strings) {
-        int id = next_string_id++;
-        string_ids[dexstr] = id;
-        // Escape string before inserting. ' -> ''
-        std::string esc(dexstr->c_str());
-        boost::replace_all(esc, "'", "''");
-        fprintf(fdout,
-                "INSERT INTO %sstrings VALUES(%d, '%s');\n",
-                prefix,
-                id,
-                esc.c_str());
-      }
-      std::string dex_id_str(store_name + "/" + std::to_string(dex_idx));
-      const char* dex_id = dex_id_str.c_str();
-      for (const auto& cls : dex) {
-        int class_id = next_class_id++;
-        dump_class(fdout, prefix, dex_id, cls, class_id);
-        class_ids[cls] = class_id;
-        for (auto field : cls->get_ifields()) {
-          int field_id = next_field_id++;
-          field_ids[field] = field_id;
-          dump_field(fdout, prefix, class_id, field, field_id);
-        }
-        for (auto field : cls->get_sfields()) {
-          int field_id = next_field_id++;
-          field_ids[field] = field_id;
-          dump_field(fdout, prefix, class_id, field, field_id);
+  {
+    Inserter strings_inserter(fdout, prefix, "strings");
+    Inserter classes_inserter(fdout, prefix, "classes");
+    Inserter fields_inserter(fdout, prefix, "fields");
+    Inserter methods_inserter(fdout, prefix, "methods");
+    for (auto& store : stores) {
+      auto store_name = store.get_name();
+      auto& dexen = store.get_dexen();
+      apply_deobfuscated_names(dexen, pg_map);
+      for (size_t dex_idx = 0; dex_idx < dexen.size(); ++dex_idx) {
+        auto& dex = dexen[dex_idx];
+        GatheredTypes gtypes(&dex);
+        auto strings = gtypes.get_cls_order_dexstring_emitlist();
+        for (auto dexstr : strings) {
+          int id = next_string_id++;
+          string_ids[dexstr] = id;
+          // Escape string before inserting. ' -> ''
+          std::string esc(dexstr->c_str());
+          boost::replace_all(esc, "'", "''");
+          strings_inserter.row("%d, '%s'", id, esc.c_str());
         }
-        for (const auto& meth : cls->get_dmethods()) {
-          int meth_id = next_method_id++;
-          method_ids[meth] = meth_id;
-          dump_method(fdout, prefix, class_id, meth, meth_id);
-        }
-        for (auto& meth : cls->get_vmethods()) {
-          int meth_id = next_method_id++;
-          method_ids[meth] = meth_id;
-          dump_method(fdout, prefix, class_id, meth, meth_id);
+        std::string dex_id_str(store_name + "/" + std::to_string(dex_idx));
+        const char* dex_id = dex_id_str.c_str();
+        for (const auto& cls : dex) {
+          int class_id = next_class_id++;
+          dump_class(classes_inserter, dex_id, cls, class_id);
+          class_ids[cls] = class_id;
+          for (auto field : cls->get_ifields()) {
+            int field_id = next_field_id++;
+            field_ids[field] = field_id;
+            dump_field(fields_inserter, class_id, field, field_id);
+          }
+          for (auto field : cls->get_sfields()) {
+            int field_id = next_field_id++;
+            field_ids[field] = field_id;
+            dump_field(fields_inserter, class_id, field, field_id);
+          }
+          for (const auto& meth : cls->get_dmethods()) {
+            int meth_id = next_method_id++;
+            method_ids[meth] = meth_id;
+            dump_method(methods_inserter, class_id, meth, meth_id);
+          }
+          for (auto& meth : cls->get_vmethods()) {
+            int meth_id = next_method_id++;
+            method_ids[meth] = meth_id;
+            dump_method(methods_inserter, class_id, meth, meth_id);
+          }
         }
       }
     }
   }
   fprintf(fdout, "END TRANSACTION;\n");
 
-  // Dump references
-  fprintf(fdout, "BEGIN TRANSACTION;\n");
+  // Dump references. Collecting a method's references means resolving every
+  // member reference in its code, so do that in parallel, then write them out
+  // in order.
+  std::vector<DexMethod*> methods;
   for (auto& store : stores) {
-    auto& dexen = store.get_dexen();
-    for (size_t dex_idx = 0; dex_idx < dexen.size(); ++dex_idx) {
-      auto& dex = dexen[dex_idx];
+    for (auto& dex : store.get_dexen()) {
       for (const auto& cls : dex) {
-        for (const auto& meth : cls->get_dmethods()) {
-          int meth_id = method_ids[meth];
-          dump_method_refs(fdout, prefix, meth, meth_id);
-        }
-        for (auto& meth : cls->get_vmethods()) {
-          int meth_id = method_ids[meth];
-          dump_method_refs(fdout, prefix, meth, meth_id);
-        }
-        for (const auto& field : cls->get_sfields()) {
-          int field_id = field_ids[field];
-          dump_field_refs(fdout, prefix, field, field_id);
-        }
-        for (const auto& field : cls->get_ifields()) {
-          int field_id = field_ids[field];
-          dump_field_refs(fdout, prefix, field, field_id);
+        methods.insert(methods.end(),
+                       cls->get_dmethods().begin(),
+                       cls->get_dmethods().end());
+        methods.insert(methods.end(),
+                       cls->get_vmethods().begin(),
+                       cls->get_vmethods().end());
+      }
+    }
+  }
+  std::vector<MethodRefs> method_refs(methods.size());
+  std::vector<size_t> indices(methods.size());
+  std::iota(indices.begin(), indices.end(), 0);
+  workqueue_run<size_t>(
+      [&](size_t i) { method_refs[i] = collect_method_refs(methods[i]); },
+      indices);
+
+  fprintf(fdout, "BEGIN TRANSACTION;\n");
+  {
+    MethodRefInserters method_ref_inserters{
+        Inserter(fdout, prefix, "method_string_refs"),
+        Inserter(fdout, prefix, "method_class_refs"),
+        Inserter(fdout, prefix, "method_field_refs"),
+        Inserter(fdout, prefix, "method_method_refs")};
+    Inserter field_string_refs_inserter(fdout, prefix, "field_string_refs");
+    size_t method_idx = 0;
+    for (auto& store : stores) {
+      auto& dexen = store.get_dexen();
+      for (size_t dex_idx = 0; dex_idx < dexen.size(); ++dex_idx) {
+        auto& dex = dexen[dex_idx];
+        for (const auto& cls : dex) {
+          for (size_t i = 0;
+               i < cls->get_dmethods().size() + cls->get_vmethods().size();
+               ++i, ++method_idx) {
+            auto meth = methods[method_idx];
+            dump_method_refs(method_ref_inserters,
+                             method_refs[method_idx],
+                             method_ids[meth]);
+          }
+          for (const auto& field : cls->get_sfields()) {
+            int field_id = field_ids[field];
+            dump_field_refs(field_string_refs_inserter, field, field_id);
+          }
+          for (const auto& field : cls->get_ifields()) {
+            int field_id = field_ids[field];
+            dump_field_refs(field_string_refs_inserter, field, field_id);
+          }
         }
       }
     }
@@ -362,18 +454,19 @@ CREATE TABLE %1$smethod_string_refs (
   ClassHierarchy ch = build_type_hierarchy(scope);
   int next_is_a_id = 0;
   fprintf(fdout, "BEGIN TRANSACTION;\n");
-  for (auto& cls : scope) {
-    TypeSet results;
-    get_all_children_or_implementors(ch, scope, cls, results);
-    for (auto type : results) {
-      auto type_cls = type_class(type);
-      if (type_cls) {
-        fprintf(fdout,
-                "INSERT INTO %sis_a VALUES(%d, %d, %d);\n",
-                prefix,
-                next_is_a_id++,
-                class_ids[type_cls],
-                class_ids[cls]);
+  {
+    Inserter is_a_inserter(fdout, prefix, "is_a");
+    for (auto& cls : scope) {
+      TypeSet results;
+      get_all_children_or_implementors(ch, scope, cls, results);
+      for (auto type : results) {
+        auto type_cls = type_class(type);
+        if (type_cls) {
+          is_a_inserter.row("%d, %d, %d",
+                            next_is_a_id++,
+                            class_ids[type_cls],
+                            class_ids[cls]);
+        }
       }
     }
   }
@@ -13,25 +13,31 @@ bool clean = false;
 bool raw = false;
 bool escape = false;
 
+static thread_local FILE* redump_out = nullptr;
+
+void set_redump_output(FILE* out) { redump_out = out; }
+
+static FILE* output() { return redump_out ? redump_out : stdout; }
+
 void redump(const char* format, ...) {
   va_list va;
   va_start(va, format);
-  vprintf(format, va);
+  vfprintf(output(), format, va);
   va_end(va);
 }
 
 void redump(uint32_t off, const char* format, ...) {
   va_list va;
   va_start(va, format);
-  if (!clean) printf("[0x%x] ", off);
-  vprintf(format, va);
+  if (!clean) fprintf(output(), "[0x%x] ", off);
+  vfprintf(output(), format, va);
   va_end(va);
 }
 
 void redump(uint32_t pos, uint32_t off, const char* format, ...) {
   va_list va;
   va_start(va, format);
-  if (!clean) printf("(0x%x) [0x%x] ", pos, off);
-  vprintf(format, va);
+  if (!clean) fprintf(output(), "(0x%x) [0x%x] ", pos, off);
+  vfprintf(output(), format, va);
   va_end(va);
 }
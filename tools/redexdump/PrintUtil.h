@@ -8,11 +8,16 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdio.h>
 
 extern bool clean;
 extern bool raw;
 extern bool escape;
 
+// Redirects the output of redump() on the calling thread; nullptr restores
+// the default of stdout.
+void set_redump_output(FILE* out);
+
 void redump(const char* format, ...);
 void redump(uint32_t off, const char* format, ...);
 void redump(uint32_t pos, uint32_t off, const char* format, ...);
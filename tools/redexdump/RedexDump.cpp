@@ -6,13 +6,18 @@
  */
 
 #include "RedexDump.h"
+#include <algorithm>
 #include <getopt.h>
+#include <numeric>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <string>
+#include <vector>
 
 #include "Formatters.h"
 #include "PrintUtil.h"
+#include "WorkQueue.h"
 
 static const char ddump_usage_string[] =
     "ReDex, DEX Dump tool\n"
@@ -47,7 +52,9 @@ static const char ddump_usage_string[] =
     "printing options:\n"
     "--clean: suppress indices and offsets\n"
     "--no-headers: suppress headers\n"
-    "--raw: print all bytes, even control characters\n";
+    "--raw: print all bytes, even control characters\n"
+    "-j, --jobs=<n>: dump up to <n> dex files in parallel; the output is the\n"
+    "    same as when dumping them one at a time\n";
 
 int main(int argc, char* argv[]) {
 
@@ -68,6 +75,7 @@ int main(int argc, char* argv[]) {
   bool redexdump_debug = false;
   uint32_t ddebug_offset = 0;
   int no_headers = 0;
+  unsigned int jobs = 1;
 
   char c;
   static const struct option options[] = {
@@ -91,11 +99,12 @@ int main(int argc, char* argv[]) {
       {"raw", no_argument, (int*)&raw, 1},
       {"escape", no_argument, (int*)&escape, 1},
       {"no-headers", no_argument, &no_headers, 1},
+      {"jobs", required_argument, nullptr, 'j'},
       {"help", no_argument, nullptr, 'h'},
       {nullptr, 0, nullptr, 0},
   };
 
-  while ((c = getopt_long(argc, argv, "asStpfmcCxeAdDh", &options[0],
+  while ((c = getopt_long(argc, argv, "asStpfmcCxeAdDj:h", &options[0],
                           nullptr)) != -1) {
     switch (c) {
     case 'a':
@@ -146,6 +155,9 @@ int main(int argc, char* argv[]) {
     case 'D':
       sscanf(optarg, "%x", &ddebug_offset);
       break;
+    case 'j':
+      jobs = std::max(1, atoi(optarg));
+      break;
     case 'h':
       puts(ddump_usage_string);
       return 0;
@@ -164,8 +176,7 @@ int main(int argc, char* argv[]) {
     return 1;
   }
 
-  while (optind < argc) {
-    const char* dexfile = argv[optind++];
+  auto dump_dex = [&](const char* dexfile) {
     ddump_data rd;
     open_dex_file(dexfile, &rd);
     if (!no_headers) {
@@ -217,7 +228,42 @@ int main(int argc, char* argv[]) {
     if (ddebug_offset != 0) {
       disassemble_debug(&rd, ddebug_offset);
     }
-    fprintf(stdout, "\n");
+    redump("\n");
+  };
+
+  std::vector<const char*> dexfiles(argv + optind, argv + argc);
+  if (jobs == 1 || dexfiles.size() == 1) {
+    for (const char* dexfile : dexfiles) {
+      dump_dex(dexfile);
+      fflush(stdout);
+    }
+    return 0;
+  }
+
+  // Dump a batch of dex files at a time, each into its own buffer, and emit
+  // the buffers in order. Batching bounds how much output is held in memory.
+  for (size_t start = 0; start < dexfiles.size(); start += jobs) {
+    size_t end = std::min(dexfiles.size(), start + jobs);
+    std::vector<std::string> outputs(end - start);
+    std::vector<size_t> indices(end - start);
+    std::iota(indices.begin(), indices.end(), 0);
+    workqueue_run<size_t>(
+        [&](size_t i) {
+          char* buf = nullptr;
+          size_t size = 0;
+          FILE* out = open_memstream(&buf, &size);
+          set_redump_output(out);
+          dump_dex(dexfiles[start + i]);
+          set_redump_output(nullptr);
+          fclose(out);
+          outputs[i].assign(buf, size);
+          free(buf);
+        },
+        indices,
+        indices.size());
+    for (const auto& output : outputs) {
+      fwrite(output.data(), 1, output.size(), stdout);
+    }
     fflush(stdout);
   }
 
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "Adler32.h"
+
+#include <algorithm>
+#include <zlib.h>
+
+#include "CpuFeatures.h"
+
+#ifdef REDEX_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Largest prime smaller than 2^16.
+constexpr uint32_t kBase = 65521;
+// Largest n such that 255n(n+1)/2 + (n+1)(kBase-1) fits into 32 bits, i.e.
+// how many bytes can be summed up before having to reduce modulo kBase.
+constexpr size_t kNMax = 5552;
+
+#ifdef REDEX_X86_DISPATCH
+
+/*
+ * Processes 32 bytes per iteration: the byte sums go into s1 with a sum of
+ * absolute differences against zero, and the position-weighted sums go into
+ * s2 with multiply-adds against descending tap weights. This is the approach
+ * of the SSSE3 Adler-32 in Chromium's zlib.
+ */
+__attribute__((target("ssse3"))) uint32_t adler32_ssse3(uint32_t adler,
+                                                          const uint8_t* data,
+                                                          size_t size) {
+  constexpr size_t kBlockSize = 32;
+  uint32_t s1 = adler & 0xffff;
+  uint32_t s2 = adler >> 16;
+
+  size_t num_blocks = size / kBlockSize;
+  size -= num_blocks * kBlockSize;
+
+  const __m128i tap1 = _mm_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23,
+                                     22, 21, 20, 19, 18, 17);
+  const __m128i tap2 =
+      _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i ones = _mm_set1_epi16(1);
+
+  while (num_blocks > 0) {
+    size_t n = std::min(kNMax / kBlockSize, num_blocks);
+    num_blocks -= n;
+
+    // v_ps accumulates the s1 of all previous blocks, each of which
+    // contributes kBlockSize times to s2.
+    __m128i v_ps = _mm_set_epi32(0, 0, 0, (int)(s1 * n));
+    __m128i v_s2 = _mm_set_epi32(0, 0, 0, (int)s2);
+    __m128i v_s1 = _mm_setzero_si128();
+
+    do {
+      const __m128i bytes1 = _mm_loadu_si128((const __m128i*)data);
+      const __m128i bytes2 = _mm_loadu_si128((const __m128i*)(data + 16));
+
+      v_ps = _mm_add_epi32(v_ps, v_s1);
+
+      v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(bytes1, zero));
+      const __m128i mad1 = _mm_maddubs_epi16(bytes1, tap1);
+      v_s2 = _mm_add_epi32(v_s2, _mm_madd_epi16(mad1, ones));
+
+      v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(bytes2, zero));
+      const __m128i mad2 = _mm_maddubs_epi16(bytes2, tap2);
+      v_s2 = _mm_add_epi32(v_s2, _mm_madd_epi16(mad2, ones));
+
+      data += kBlockSize;
+    } while (--n);
+
+    v_s2 = _mm_add_epi32(v_s2, _mm_slli_epi32(v_ps, 5));
+
+    // Sum the lanes.
+    v_s1 = _mm_add_epi32(v_s1,
+                         _mm_shuffle_epi32(v_s1, _MM_SHUFFLE(2, 3, 0, 1)));
+    v_s1 = _mm_add_epi32(v_s1,
+                         _mm_shuffle_epi32(v_s1, _MM_SHUFFLE(1, 0, 3, 2)));
+    s1 += (uint32_t)_mm_cvtsi128_si32(v_s1);
+
+    v_s2 = _mm_add_epi32(v_s2,
+                         _mm_shuffle_epi32(v_s2, _MM_SHUFFLE(2, 3, 0, 1)));
+    v_s2 = _mm_add_epi32(v_s2,
+                         _mm_shuffle_epi32(v_s2, _MM_SHUFFLE(1, 0, 3, 2)));
+    s2 = (uint32_t)_mm_cvtsi128_si32(v_s2);
+
+    s1 %= kBase;
+    s2 %= kBase;
+  }
+
+  // Fewer than kBlockSize bytes remain, which cannot overflow.
+  for (; size > 0; --size) {
+    s1 += *data++;
+    s2 += s1;
+  }
+  s1 %= kBase;
+  s2 %= kBase;
+
+  return s1 | (s2 << 16);
+}
+
+#endif
+
+} // namespace
+
+uint32_t adler32_update(uint32_t adler, const uint8_t* data, size_t size) {
+#ifdef REDEX_X86_DISPATCH
+  static const bool use_ssse3 = cpu_features::has_ssse3();
+  if (use_ssse3) {
+    return adler32_ssse3(adler, data, size);
+  }
+#endif
+  // zlib takes lengths as uInt, so feed it in chunks.
+  while (size > 0) {
+    auto chunk = (uInt)std::min<size_t>(size, 1u << 30);
+    adler = (uint32_t)adler32(adler, (const Bytef*)data, chunk);
+    data += chunk;
+    size -= chunk;
+  }
+  return adler;
+}
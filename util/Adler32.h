@@ -0,0 +1,22 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Initial value of an Adler-32 checksum.
+ */
+constexpr uint32_t kAdler32Init = 1;
+
+/*
+ * Continues the Adler-32 checksum `adler` over `size` bytes at `data`, as
+ * zlib's adler32() does. Uses SSSE3 when the CPU has it.
+ */
+uint32_t adler32_update(uint32_t adler, const uint8_t* data, size_t size);
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+/*
+ * Runtime detection of the x86 instruction set extensions that the checksum
+ * code in util/ can make use of. Code using them must be compiled for the
+ * extension with a target attribute, guarded by REDEX_X86_DISPATCH, and only
+ * be called after checking for the extension here.
+ */
+
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define REDEX_X86_DISPATCH 1
+#include <cpuid.h>
+#endif
+
+namespace cpu_features {
+
+#ifdef REDEX_X86_DISPATCH
+
+struct X86Features {
+  bool ssse3{false};
+  bool sse41{false};
+  bool sha{false};
+
+  X86Features() {
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+      ssse3 = (ecx & bit_SSSE3) != 0;
+      sse41 = (ecx & bit_SSE4_1) != 0;
+    }
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+      // bit_SHA is missing from older cpuid.h versions.
+      sha = (ebx & (1u << 29)) != 0;
+    }
+  }
+};
+
+inline const X86Features& x86() {
+  static const X86Features features;
+  return features;
+}
+
+inline bool has_ssse3() { return x86().ssse3; }
+inline bool has_sha() { return x86().sha && x86().sse41 && x86().ssse3; }
+
+#else
+
+inline bool has_ssse3() { return false; }
+inline bool has_sha() { return false; }
+
+#endif
+
+} // namespace cpu_features
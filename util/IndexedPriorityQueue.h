@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "Debug.h"
+
+/*
+ * Max-priority queue over dense indices, i.e. small unsigned integers that
+ * the client hands out, stored as a binary heap in flat arrays. Compared to
+ * MutablePriorityQueue, there are no node allocations, and priorities of many
+ * elements can be changed at once in linear time.
+ *
+ * Limitations:
+ * - No two values can exist in the queue with the same priority at the same
+ *   time, so that the order in which elements are retrieved is deterministic
+ */
+template <class Priority, class PriorityCompare = std::less<Priority>>
+class IndexedPriorityQueue {
+ public:
+  using Index = uint32_t;
+
+  // Inserts an index with a priority; the index cannot already be present.
+  void insert(Index index, const Priority& priority) {
+    if (index >= m_positions.size()) {
+      m_positions.resize(index + 1, NONE);
+      m_priorities.resize(index + 1);
+    }
+    always_assert(m_positions[index] == NONE);
+    m_priorities[index] = priority;
+    m_positions[index] = static_cast<Index>(m_heap.size());
+    m_heap.push_back(index);
+    sift_up(m_positions[index]);
+  }
+
+  // Erases an index that's currently in the queue.
+  void erase(Index index) {
+    always_assert(contains(index));
+    auto pos = m_positions[index];
+    m_positions[index] = NONE;
+    auto last = m_heap.back();
+    m_heap.pop_back();
+    if (last == index) {
+      return;
+    }
+    place(pos, last);
+    sift_up(pos);
+    sift_down(m_positions[last]);
+  }
+
+  // Changes the priority of an index that's currently in the queue.
+  void update_priority(Index index, const Priority& priority) {
+    always_assert(contains(index));
+    m_priorities[index] = priority;
+    sift_up(m_positions[index]);
+    sift_down(m_positions[index]);
+  }
+
+  // Changes the priorities of the given indices, which must be in the queue,
+  // and must not be repeated, to get_priority(index). When a large fraction
+  // of the queue changes, the heap is rebuilt in linear time instead of
+  // updating elements one by one.
+  template <class GetPriority>
+  void update_priorities(const std::vector<Index>& indices,
+                         const GetPriority& get_priority) {
+    if (indices.size() * REBUILD_RATIO < m_heap.size()) {
+      for (auto index : indices) {
+        update_priority(index, get_priority(index));
+      }
+      return;
+    }
+    for (auto index : indices) {
+      always_assert(contains(index));
+      m_priorities[index] = get_priority(index);
+    }
+    for (size_t pos = m_heap.size() / 2; pos-- > 0;) {
+      sift_down(pos);
+    }
+  }
+
+  bool contains(Index index) const {
+    return index < m_positions.size() && m_positions[index] != NONE;
+  }
+
+  const Priority& get_priority(Index index) const {
+    always_assert(contains(index));
+    return m_priorities[index];
+  }
+
+  // Removes all elements.
+  void clear() {
+    m_heap.clear();
+    m_positions.clear();
+    m_priorities.clear();
+  }
+
+  // Checks if queue is empty.
+  bool empty() const { return m_heap.empty(); }
+
+  size_t size() const { return m_heap.size(); }
+
+  // Returns index with highest priority.
+  Index front() const { return m_heap.front(); }
+
+ private:
+  static constexpr Index NONE = std::numeric_limits<Index>::max();
+  // Rebuild the heap when at least a quarter of the elements changed.
+  static constexpr size_t REBUILD_RATIO = 4;
+
+  bool less(Index a, Index b) const {
+    return m_compare(m_priorities[a], m_priorities[b]);
+  }
+
+  void place(size_t pos, Index index) {
+    m_heap[pos] = index;
+    m_positions[index] = static_cast<Index>(pos);
+  }
+
+  void sift_up(size_t pos) {
+    auto index = m_heap[pos];
+    while (pos > 0) {
+      auto parent = (pos - 1) / 2;
+      if (!less(m_heap[parent], index)) {
+        break;
+      }
+      place(pos, m_heap[parent]);
+      pos = parent;
+    }
+    place(pos, index);
+  }
+
+  void sift_down(size_t pos) {
+    auto index = m_heap[pos];
+    auto size = m_heap.size();
+    while (true) {
+      auto child = 2 * pos + 1;
+      if (child >= size) {
+        break;
+      }
+      if (child + 1 < size && less(m_heap[child], m_heap[child + 1])) {
+        ++child;
+      }
+      if (!less(index, m_heap[child])) {
+        break;
+      }
+      place(pos, m_heap[child]);
+      pos = child;
+    }
+    place(pos, index);
+  }
+
+  std::vector<Index> m_heap;
+  // Position in m_heap by index, or NONE.
+  std::vector<Index> m_positions;
+  std::vector<Priority> m_priorities;
+  PriorityCompare m_compare;
+};
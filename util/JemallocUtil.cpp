@@ -10,6 +10,7 @@
 #endif
 
 #include "Debug.h"
+#include "JemallocUtil.h"
 
 extern "C" {
 
@@ -43,4 +44,61 @@ void enable_profiling() { set_profile_active(true); }
 
 void disable_profiling() { set_profile_active(false); }
 
+uint64_t get_allocated_bytes() {
+  if (mallctl == nullptr) {
+    return 0;
+  }
+  // Statistics are cached by jemalloc and only refreshed on an epoch bump.
+  uint64_t epoch = 1;
+  size_t len = sizeof(epoch);
+  if (mallctl("epoch", &epoch, &len, &epoch, len) != 0) {
+    return 0;
+  }
+  size_t allocated = 0;
+  len = sizeof(allocated);
+  if (mallctl("stats.allocated", &allocated, &len, nullptr, 0) != 0) {
+    return 0;
+  }
+  return allocated;
+}
+
+namespace {
+
+bool read_stat(const char* name, uint64_t* value) {
+  size_t v = 0;
+  size_t len = sizeof(v);
+  if (mallctl(name, &v, &len, nullptr, 0) != 0) {
+    return false;
+  }
+  *value = v;
+  return true;
+}
+
+} // namespace
+
+bool get_heap_stats(HeapStats* stats) {
+  *stats = HeapStats();
+  if (mallctl == nullptr) {
+    return false;
+  }
+  uint64_t epoch = 1;
+  size_t len = sizeof(epoch);
+  if (mallctl("epoch", &epoch, &len, &epoch, len) != 0) {
+    return false;
+  }
+  // 4096 is MALLCTL_ARENAS_ALL, which aggregates the stats of all arenas.
+  uint64_t small_nmalloc = 0;
+  uint64_t large_nmalloc = 0;
+  if (!read_stat("stats.allocated", &stats->allocated) ||
+      !read_stat("stats.resident", &stats->resident) ||
+      !read_stat("stats.retained", &stats->retained) ||
+      !read_stat("stats.arenas.4096.small.nmalloc", &small_nmalloc) ||
+      !read_stat("stats.arenas.4096.large.nmalloc", &large_nmalloc)) {
+    *stats = HeapStats();
+    return false;
+  }
+  stats->num_allocations = small_nmalloc + large_nmalloc;
+  return true;
+}
+
 } // namespace jemalloc_util
@@ -5,6 +5,9 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#pragma once
+
+#include <cstdint>
 #include <cstdio>
 
 namespace jemalloc_util {
@@ -13,6 +16,25 @@ void enable_profiling();
 
 void disable_profiling();
 
+// Total bytes currently allocated by the application, or 0 when not running
+// with jemalloc.
+uint64_t get_allocated_bytes();
+
+struct HeapStats {
+  // Bytes in live allocations.
+  uint64_t allocated{0};
+  // Bytes in physically resident pages mapped by the allocator.
+  uint64_t resident{0};
+  // Bytes in virtual memory retained by the allocator for later reuse.
+  uint64_t retained{0};
+  // Number of allocation requests served so far, across all threads.
+  uint64_t num_allocations{0};
+};
+
+// Snapshot of the allocator statistics. Returns false, leaving `stats`
+// zeroed, when not running with jemalloc or when it was built without stats.
+bool get_heap_stats(HeapStats* stats);
+
 class ScopedProfiling final {
  public:
   explicit ScopedProfiling(bool enable) {
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "PerfCounters.h"
+
+#if defined(__linux__)
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace perf_counters {
+
+#if defined(__linux__)
+
+namespace {
+
+struct CounterSpec {
+  const char* metric;
+  uint32_t type;
+  uint64_t config;
+};
+
+constexpr CounterSpec COUNTERS[] = {
+    {"perf_cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"perf_instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"perf_llc_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {"perf_branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {"perf_context_switches", PERF_TYPE_SOFTWARE,
+     PERF_COUNT_SW_CONTEXT_SWITCHES},
+};
+
+int open_counter(const CounterSpec& spec) {
+  perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = spec.type;
+  attr.config = spec.config;
+  attr.disabled = 1;
+  attr.inherit = 1;
+  attr.exclude_hv = 1;
+  // Context switches are counted by the kernel on our behalf.
+  attr.exclude_kernel = spec.type == PERF_TYPE_HARDWARE ? 1 : 0;
+  attr.read_format =
+      PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return (int)syscall(__NR_perf_event_open, &attr, /* pid */ 0, /* cpu */ -1,
+                      /* group_fd */ -1, /* flags */ 0);
+}
+
+} // namespace
+
+ScopedCounters::ScopedCounters(bool enable) {
+  if (!enable) {
+    return;
+  }
+  for (const auto& spec : COUNTERS) {
+    int fd = open_counter(spec);
+    if (fd >= 0) {
+      m_counters.emplace_back(spec.metric, fd);
+    }
+  }
+  for (const auto& p : m_counters) {
+    ioctl(p.second, PERF_EVENT_IOC_RESET, 0);
+    ioctl(p.second, PERF_EVENT_IOC_ENABLE, 0);
+  }
+}
+
+ScopedCounters::~ScopedCounters() {
+  for (const auto& p : m_counters) {
+    close(p.second);
+  }
+}
+
+std::vector<std::pair<std::string, int64_t>> ScopedCounters::stop() {
+  std::vector<std::pair<std::string, int64_t>> res;
+  for (const auto& p : m_counters) {
+    ioctl(p.second, PERF_EVENT_IOC_DISABLE, 0);
+  }
+  for (const auto& p : m_counters) {
+    // value, time enabled, time running
+    uint64_t buf[3];
+    if (read(p.second, buf, sizeof(buf)) != sizeof(buf) || buf[2] == 0) {
+      continue;
+    }
+    double value = buf[0];
+    if (buf[2] < buf[1]) {
+      value = value * buf[1] / buf[2];
+    }
+    res.emplace_back(p.first, (int64_t)value);
+  }
+  return res;
+}
+
+#else
+
+ScopedCounters::ScopedCounters(bool) {}
+
+ScopedCounters::~ScopedCounters() {}
+
+std::vector<std::pair<std::string, int64_t>> ScopedCounters::stop() {
+  return {};
+}
+
+#endif
+
+} // namespace perf_counters
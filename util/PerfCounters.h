@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace perf_counters {
+
+/*
+ * Counts hardware and scheduler events (cycles, instructions, LLC misses,
+ * branch misses and context switches) from construction until `stop`, via
+ * perf_event_open. Counters are inherited by threads spawned in the scope,
+ * so work done by worker threads is included as long as they have exited by
+ * the time `stop` is called. Parked threads of sparta::ThreadPool must be
+ * released for that.
+ *
+ * Counters that cannot be opened (not Linux, restrictive
+ * perf_event_paranoid, no PMU in a VM, ...) are silently left out.
+ */
+class ScopedCounters final {
+ public:
+  explicit ScopedCounters(bool enable);
+
+  ScopedCounters(const ScopedCounters&) = delete;
+  ScopedCounters& operator=(const ScopedCounters&) = delete;
+
+  ~ScopedCounters();
+
+  // Stops counting, and returns metric name and value of each open counter.
+  // Values are scaled up when the kernel had to multiplex counters.
+  std::vector<std::pair<std::string, int64_t>> stop();
+
+ private:
+  std::vector<std::pair<const char*, int>> m_counters;
+};
+
+} // namespace perf_counters
@@ -14,6 +14,12 @@
 
 #include <cstring>
 
+#include "CpuFeatures.h"
+
+#ifdef REDEX_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
 static const unsigned char PADDING[128] = {
     0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
     0,    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
@@ -206,6 +212,139 @@ static void sha1_transform(unsigned int state[5],
   memset((unsigned char*)x, 0, sizeof(x));
 }
 
+#ifdef REDEX_X86_DISPATCH
+
+/*
+ * SHA1 transformation of consecutive blocks using the SHA extensions, after
+ * the Intel white paper "Intel SHA Extensions" (2013).
+ */
+__attribute__((target("sha,sse4.1,ssse3"))) static void sha1_transform_shani(
+    unsigned int state[5], const unsigned char* data, size_t num_blocks) {
+  const __m128i mask =
+      _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+
+  __m128i abcd = _mm_loadu_si128((const __m128i*)state);
+  __m128i e0 = _mm_set_epi32((int)state[4], 0, 0, 0);
+  abcd = _mm_shuffle_epi32(abcd, 0x1B);
+
+  // Each group of four rounds consumes one message vector and prepares the
+  // message schedule for later groups.
+#define SHANI_LOAD(msg, i)                                             \
+  msg = _mm_shuffle_epi8(                                              \
+      _mm_loadu_si128((const __m128i*)(data + 16 * (i))), mask)
+#define SHANI_ROUNDS(e_in, e_out, msg, f)   \
+  e_in = _mm_sha1nexte_epu32(e_in, msg);    \
+  e_out = abcd;                             \
+  abcd = _mm_sha1rnds4_epu32(abcd, e_in, f)
+#define SHANI_SCHEDULE(m0, m1, m2, m3) \
+  m0 = _mm_sha1msg2_epu32(m0, m3);     \
+  m2 = _mm_sha1msg1_epu32(m2, m3);     \
+  m1 = _mm_xor_si128(m1, m3)
+
+  for (; num_blocks > 0; --num_blocks, data += 64) {
+    __m128i abcd_save = abcd;
+    __m128i e0_save = e0;
+    __m128i e1;
+    __m128i msg0, msg1, msg2, msg3;
+
+    // Rounds 0-3
+    SHANI_LOAD(msg0, 0);
+    e0 = _mm_add_epi32(e0, msg0);
+    e1 = abcd;
+    abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+
+    // Rounds 4-7
+    SHANI_LOAD(msg1, 1);
+    SHANI_ROUNDS(e1, e0, msg1, 0);
+    msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+
+    // Rounds 8-11
+    SHANI_LOAD(msg2, 2);
+    SHANI_ROUNDS(e0, e1, msg2, 0);
+    msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+    msg0 = _mm_xor_si128(msg0, msg2);
+
+    // Rounds 12-15
+    SHANI_LOAD(msg3, 3);
+    e1 = _mm_sha1nexte_epu32(e1, msg3);
+    e0 = abcd;
+    msg0 = _mm_sha1msg2_epu32(msg0, msg3);
+    abcd = _mm_sha1rnds4_epu32(abcd, e1, 0);
+    msg2 = _mm_sha1msg1_epu32(msg2, msg3);
+    msg1 = _mm_xor_si128(msg1, msg3);
+
+    // Rounds 16-67, in groups of four, rotating through the message vectors.
+    SHANI_ROUNDS(e0, e1, msg0, 0);
+    SHANI_SCHEDULE(msg1, msg2, msg3, msg0);
+    SHANI_ROUNDS(e1, e0, msg1, 1);
+    SHANI_SCHEDULE(msg2, msg3, msg0, msg1);
+    SHANI_ROUNDS(e0, e1, msg2, 1);
+    SHANI_SCHEDULE(msg3, msg0, msg1, msg2);
+    SHANI_ROUNDS(e1, e0, msg3, 1);
+    SHANI_SCHEDULE(msg0, msg1, msg2, msg3);
+    SHANI_ROUNDS(e0, e1, msg0, 1);
+    SHANI_SCHEDULE(msg1, msg2, msg3, msg0);
+    SHANI_ROUNDS(e1, e0, msg1, 1);
+    SHANI_SCHEDULE(msg2, msg3, msg0, msg1);
+    SHANI_ROUNDS(e0, e1, msg2, 2);
+    SHANI_SCHEDULE(msg3, msg0, msg1, msg2);
+    SHANI_ROUNDS(e1, e0, msg3, 2);
+    SHANI_SCHEDULE(msg0, msg1, msg2, msg3);
+    SHANI_ROUNDS(e0, e1, msg0, 2);
+    SHANI_SCHEDULE(msg1, msg2, msg3, msg0);
+    SHANI_ROUNDS(e1, e0, msg1, 2);
+    SHANI_SCHEDULE(msg2, msg3, msg0, msg1);
+    SHANI_ROUNDS(e0, e1, msg2, 2);
+    SHANI_SCHEDULE(msg3, msg0, msg1, msg2);
+    SHANI_ROUNDS(e1, e0, msg3, 3);
+    SHANI_SCHEDULE(msg0, msg1, msg2, msg3);
+
+    SHANI_ROUNDS(e0, e1, msg0, 3);
+    SHANI_SCHEDULE(msg1, msg2, msg3, msg0);
+
+    // Rounds 68-79 only finish the message schedule.
+    SHANI_ROUNDS(e1, e0, msg1, 3);
+    msg2 = _mm_sha1msg2_epu32(msg2, msg1);
+    msg3 = _mm_xor_si128(msg3, msg1);
+    SHANI_ROUNDS(e0, e1, msg2, 3);
+    msg3 = _mm_sha1msg2_epu32(msg3, msg2);
+    SHANI_ROUNDS(e1, e0, msg3, 3);
+
+    // Combine state
+    e0 = _mm_sha1nexte_epu32(e0, e0_save);
+    abcd = _mm_add_epi32(abcd, abcd_save);
+  }
+
+#undef SHANI_LOAD
+#undef SHANI_ROUNDS
+#undef SHANI_SCHEDULE
+
+  abcd = _mm_shuffle_epi32(abcd, 0x1B);
+  _mm_storeu_si128((__m128i*)state, abcd);
+  state[4] = (unsigned int)_mm_extract_epi32(e0, 3);
+}
+
+#endif
+
+/*
+ * Transforms state based on consecutive blocks, using the SHA extensions when
+ * the CPU has them.
+ */
+static void sha1_transform_blocks(unsigned int state[5],
+                                  const unsigned char* data,
+                                  size_t num_blocks) {
+#ifdef REDEX_X86_DISPATCH
+  static const bool use_shani = cpu_features::has_sha();
+  if (use_shani) {
+    sha1_transform_shani(state, data, num_blocks);
+    return;
+  }
+#endif
+  for (; num_blocks > 0; --num_blocks, data += 64) {
+    sha1_transform(state, data);
+  }
+}
+
 /*
  * SHA1 initialization. Begins an SHA1 operation, writing a new context.
  */
@@ -245,10 +384,11 @@ void sha1_update(Sha1Context* context,
   if (inputLen >= partLen) {
     memcpy((unsigned char*)&context->buffer[index], (unsigned char*)input,
            partLen);
-    sha1_transform(context->state, context->buffer);
+    sha1_transform_blocks(context->state, context->buffer, 1);
 
-    for (i = partLen; i + 63 < inputLen; i += 64)
-      sha1_transform(context->state, &input[i]);
+    unsigned int num_blocks = (inputLen - partLen) / 64;
+    sha1_transform_blocks(context->state, &input[partLen], num_blocks);
+    i = partLen + num_blocks * 64;
 
     index = 0;
   } else